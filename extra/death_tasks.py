@@ -36,6 +36,9 @@ if env.get("PIOENV", "") == "esp32dev_ota":
     # Telnet helper targets
     TELNET_CMDS = {
         "status": ("status", "Show system status", "--read-timeout 2 --post-send-wait 1.2 --retries 3 --retry-delay 2"),
+        "mem": ("mem", "Show heap and allocation stats", "--read-timeout 2 --post-send-wait 1.2 --retries 2"),
+        "perf": ("perf", "Show loop stage timings", "--read-timeout 2 --post-send-wait 1.2 --retries 2"),
+        "audiostats": ("audiostats", "Show audio underrun and latency stats", "--read-timeout 2 --post-send-wait 1.2 --retries 2"),
         "log": ("log", "Dump rolling log", "--read-timeout 2 --post-send-wait 2 --retries 2"),
         "startup": ("startup", "Dump startup log", "--read-timeout 2 --post-send-wait 2 --retries 2"),
         "head": ("head 20", "Show last 20 log entries", "--read-timeout 2 --post-send-wait 2 --retries 2"),
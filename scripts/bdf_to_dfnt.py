@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Convert a BDF bitmap font to the `.dfnt` format used by the thermal printer.
+
+The printer firmware renders fortunes in raster bands with this font when
+`printer_font` in config.txt points at the output file. Only codepoints
+0-255 (Latin-1) are kept. See src/bitmap_font.h for the binary layout.
+
+Kerning pairs are optional and come from a plain-text file with one pair per
+line: `<left> <right> <adjust>`, where left/right are single characters or
+integer codepoints and adjust is a signed pixel offset.
+"""
+
+from __future__ import annotations
+
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+VERSION = 1
+MAX_CODEPOINT = 0xFF
+
+
+class Glyph:
+    def __init__(self, codepoint: int, advance: int, width: int, height: int,
+                 x_offset: int, y_offset: int, rows: list[bytes]):
+        self.codepoint = codepoint
+        self.advance = advance
+        self.width = width
+        self.height = height
+        self.x_offset = x_offset
+        self.y_offset = y_offset
+        self.rows = rows
+
+
+def parse_bdf(path: Path) -> tuple[int, int, list[Glyph]]:
+    ascent = descent = None
+    glyphs: list[Glyph] = []
+    lines = path.read_text(encoding="latin-1").splitlines()
+    i = 0
+    while i < len(lines):
+        parts = lines[i].split()
+        i += 1
+        if not parts:
+            continue
+        key = parts[0]
+        if key == "FONT_ASCENT":
+            ascent = int(parts[1])
+        elif key == "FONT_DESCENT":
+            descent = int(parts[1])
+        elif key == "STARTCHAR":
+            codepoint = advance = None
+            bbx = (0, 0, 0, 0)
+            rows: list[bytes] = []
+            while i < len(lines):
+                parts = lines[i].split()
+                i += 1
+                if not parts:
+                    continue
+                if parts[0] == "ENCODING":
+                    codepoint = int(parts[1])
+                elif parts[0] == "DWIDTH":
+                    advance = int(parts[1])
+                elif parts[0] == "BBX":
+                    bbx = tuple(int(v) for v in parts[1:5])
+                elif parts[0] == "BITMAP":
+                    row_bytes = (bbx[0] + 7) // 8
+                    for _ in range(bbx[1]):
+                        hex_row = lines[i].strip()
+                        i += 1
+                        rows.append(bytes.fromhex(hex_row)[:row_bytes].ljust(row_bytes, b"\0"))
+                elif parts[0] == "ENDCHAR":
+                    break
+            if codepoint is None or codepoint < 0 or codepoint > MAX_CODEPOINT:
+                continue
+            glyphs.append(Glyph(codepoint, advance if advance is not None else bbx[0],
+                                bbx[0], bbx[1], bbx[2], bbx[3], rows))
+
+    if ascent is None or descent is None:
+        raise ValueError("BDF file is missing FONT_ASCENT/FONT_DESCENT")
+
+    # BDF offsets are relative to the baseline; the firmware wants rows from the line top.
+    for glyph in glyphs:
+        glyph.y_offset = ascent - (glyph.y_offset + glyph.height)
+        if glyph.y_offset < 0:
+            glyph.rows = glyph.rows[-glyph.y_offset:]
+            glyph.height = len(glyph.rows)
+            glyph.y_offset = 0
+    return ascent, ascent + descent, sorted(glyphs, key=lambda g: g.codepoint)
+
+
+def parse_kerning(path: Path) -> list[tuple[int, int, int]]:
+    def codepoint(token: str) -> int:
+        return ord(token) if len(token) == 1 else int(token, 0)
+
+    pairs: dict[tuple[int, int], int] = {}
+    for number, line in enumerate(path.read_text(encoding="latin-1").splitlines(), start=1):
+        line = line.strip()
+        if not line or line.startswith("#"):
+            continue
+        parts = line.split()
+        if len(parts) != 3:
+            raise ValueError(f"{path}:{number}: expected '<left> <right> <adjust>'")
+        pairs[(codepoint(parts[0]), codepoint(parts[1]))] = int(parts[2])
+    return sorted((left, right, adjust) for (left, right), adjust in pairs.items())
+
+
+def write_dfnt(path: Path, ascent: int, line_height: int, glyphs: list[Glyph],
+               kerning: list[tuple[int, int, int]]) -> int:
+    for name, value, limit in (("line height", line_height, 255), ("ascent", ascent, 255)):
+        if not 0 < value <= limit:
+            raise ValueError(f"{name} {value} out of range")
+
+    records = bytearray()
+    bitmaps = bytearray()
+    for glyph in glyphs:
+        if glyph.width > 255 or glyph.height > 255 or not -128 <= glyph.x_offset <= 127:
+            raise ValueError(f"glyph {glyph.codepoint} too large")
+        records += struct.pack("<HBBBbBBI", glyph.codepoint, max(0, min(glyph.advance, 255)),
+                               glyph.width, glyph.height, glyph.x_offset,
+                               min(glyph.y_offset, 255), 0, len(bitmaps))
+        bitmaps += b"".join(glyph.rows)
+
+    kerns = bytearray()
+    for left, right, adjust in kerning:
+        kerns += struct.pack("<HHbB", left, right, max(-128, min(adjust, 127)), 0)
+
+    header = b"DFNT" + struct.pack("<BBBBHHI", VERSION, line_height, ascent, 0,
+                                   len(glyphs), len(kerning), 0)
+    data = header + records + kerns + bitmaps
+    path.write_bytes(data)
+    return len(data)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("bdf", type=Path, help="input BDF font")
+    parser.add_argument("output", type=Path, help="output .dfnt file")
+    parser.add_argument("--kerning", type=Path, help="optional kerning pair file")
+    args = parser.parse_args()
+
+    try:
+        ascent, line_height, glyphs = parse_bdf(args.bdf)
+        if not glyphs:
+            raise ValueError("no Latin-1 glyphs found")
+        kerning = parse_kerning(args.kerning) if args.kerning else []
+        size = write_dfnt(args.output, ascent, line_height, glyphs, kerning)
+    except (OSError, ValueError) as exc:
+        print(f"error: {exc}", file=sys.stderr)
+        return 1
+
+    print(f"Wrote {args.output} ({len(glyphs)} glyphs, {len(kerning)} kerning pairs, "
+          f"{line_height} px lines, {size} bytes)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
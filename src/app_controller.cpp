@@ -19,9 +19,14 @@
 #include "death_controller_adapters.h"
 #include "finger_sensor.h"
 #include "fortune_generator.h"
+#include "infra/alloc_tracker.h"
+#include "infra/arduino_heap_probe.h"
+#include "infra/sd_mmc_filesystem.h"
 #include "infra/log_sink.h"
 #include "light_controller.h"
 #include "logging_manager.h"
+#include "loop_profiler.h"
+#include "memory_monitor.h"
 #include "ota_manager.h"
 #include "remote_debug_manager.h"
 #include "servo_controller.h"
@@ -55,6 +60,7 @@ constexpr const char* AUDIO_FORTUNE_TOLD_DIR = "/audio/fortune_told";
 constexpr unsigned long BREATHING_INTERVAL = 7000;   // ms
 constexpr int BREATHING_JAW_ANGLE = 30;              // degrees
 constexpr int BREATHING_MOVEMENT_DURATION = 2000;    // ms
+constexpr int BREATHING_HOLD_DURATION = 100;         // ms at the open position
 constexpr int SERVO_POSITION_MARGIN_DEGREES = 3;
 
 constexpr const char* DEFAULT_FORTUNE_JSON = "/printer/fortunes_littlekid.json";
@@ -64,6 +70,7 @@ constexpr const char* DEFAULT_INITIALIZATION_AUDIO = "/audio/initialized.wav";
 constexpr unsigned INIT_SERIAL_DELAY_MS = 500;
 constexpr int MAX_SD_RETRIES = 5;
 constexpr int MAX_CONFIG_RETRIES = 5;
+constexpr unsigned long RETRY_BACKOFF_MS = 500;      // Pause after the error blinks before retrying
 
 int32_t IRAM_ATTR provideAudioFramesThunk(void* context, Frame* frame, int32_t frameCount) {
     auto* player = static_cast<AudioPlayer*>(context);
@@ -189,6 +196,11 @@ bool AppController::setup() {
     setupLogging();
     LOG_INFO(TAG, "💀 Death starting…");
 
+    if (!m_memoryMonitor) {
+        m_heapProbe = std::make_unique<infra::ArduinoHeapProbe>();
+        m_memoryMonitor = std::make_unique<MemoryMonitor>(*m_heapProbe);
+    }
+
     if (!m_lightController) {
         m_lightController = std::make_unique<LightController>(m_pins.eyeLed, m_pins.mouthLed);
     }
@@ -218,6 +230,7 @@ bool AppController::setup() {
     queueInitializationAudio();
 
     LOG_INFO(TAG, "🎉 Death initialized successfully");
+    m_memoryMonitor->update(millis());
     m_initialized = true;
     return true;
 }
@@ -227,28 +240,48 @@ void AppController::loop() {
         return;
     }
 
+    LoopProfiler::Scope loopScope(m_loopProfiler, LoopProfiler::Stage::Loop);
     const unsigned long now = millis();
 
     if (m_audioPlayer) {
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Audio);
         m_audioPlayer->update();
     }
+    {
+        // Right after the refill is when the audio buffer has the most in hand
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::SdLog);
+        LoggingManager::instance().serviceSdLog(now, !m_audioPlayer || m_audioPlayer->hasSdHeadroom());
+    }
     if (m_bluetoothController) {
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Bluetooth);
         m_bluetoothController->update();
     }
     if (m_fingerSensor) {
-        m_fingerSensor->update();
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Finger);
+        m_fingerSensor->update(!m_audioPlayer || m_audioPlayer->hasSdHeadroom());
     }
     if (m_thermalPrinter) {
-        m_thermalPrinter->update();
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Printer);
+        m_thermalPrinter->update(!m_audioPlayer || m_audioPlayer->hasSdHeadroom());
         updatePrinterFaultIndicator();
     }
     if (m_lightController) {
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Lights);
         m_lightController->update();
     }
+    if (m_servoController) {
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Servo);
+        m_servoController->update(now);
+    }
 
-    updateConnectivity();
+    {
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Connectivity);
+        infra::ScopedAllocTag allocTag(infra::AllocTag::Network);
+        updateConnectivity();
+    }
 
     if (m_uartController) {
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Uart);
         m_uartController->update();
         UARTCommand lastCommand = m_uartController->getLastCommand();
         if (lastCommand != UARTCommand::NONE) {
@@ -267,6 +300,8 @@ void AppController::loop() {
     }
 
     if (m_deathController) {
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Controller);
+        infra::ScopedAllocTag allocTag(infra::AllocTag::Controller);
         DeathController::FingerReadout readout{};
         if (m_fingerSensor) {
             readout.detected = m_fingerSensor->isFingerDetected();
@@ -277,6 +312,7 @@ void AppController::loop() {
         m_deathController->update(now, readout);
         processControllerActions(m_deathController->pendingActions());
         m_deathController->clearActions();
+        prepareNextFortuneJob();
 
         const bool fingerStreaming = m_fingerSensor && m_fingerSensor->isStreamEnabled();
         const bool controllerIdle = m_deathController->state() == DeathController::State::Idle;
@@ -289,8 +325,12 @@ void AppController::loop() {
     }
 
     if (m_cliService) {
+        LoopProfiler::Scope scope(m_loopProfiler, LoopProfiler::Stage::Cli);
+        infra::ScopedAllocTag allocTag(infra::AllocTag::Cli);
         m_cliService->poll();
     }
+
+    m_memoryMonitor->update(now);
 }
 
 void AppController::enqueueCliCommand(const String& command) {
@@ -301,18 +341,8 @@ void AppController::enqueueCliCommand(const String& command) {
 
 void AppController::setupLogging() {
     LoggingManager::instance().begin(&Serial);
-    class LoggingManagerSink : public infra::ILogSink {
-    public:
-        void log(infra::LogLevel level, const char* tag, const char* message) override {
-            LoggingManager::instance().log(static_cast<LogLevel>(level),
-                                           tag ? tag : TAG,
-                                           "%s",
-                                           message ? message : "");
-        }
-    };
-    static LoggingManagerSink loggingSink;
-    infra::setLogSink(&loggingSink);
 
+    // Without a sink, LOG_* calls go straight to the binary log ring
     if (m_logSink) {
         infra::setLogSink(m_logSink);
     }
@@ -324,26 +354,40 @@ void AppController::mountSdCard() {
     while (!m_sdCardManager.begin() && retries < MAX_SD_RETRIES) {
         LOG_WARN(TAG, "⚠️ SD card mount failed! Retrying… (%d/%d)", retries + 1, MAX_SD_RETRIES);
         m_lightController->blinkEyes(3);
-        delay(500);
+        waitWithLights(3 * LightController::SIMPLE_BLINK_PERIOD_MS + RETRY_BACKOFF_MS);
         ++retries;
     }
 
     if (retries < MAX_SD_RETRIES) {
         m_sdCardMounted = true;
         LOG_INFO(TAG, "SD card mounted successfully");
+        static infra::SDMMCFileSystem s_logFileSystem;
+        if (!LoggingManager::instance().beginSdLog(&s_logFileSystem)) {
+            LOG_WARN(TAG, "⚠️ SD log could not be opened; logging to serial and telnet only");
+        }
         m_sdCardContent = m_sdCardManager.loadContent();
     } else {
         LOG_WARN(TAG, "⚠️ SD card mount failed after %d retries - using safe defaults", MAX_SD_RETRIES);
     }
 }
 
+// Setup has no loop running yet; keep the LED effects moving while a retry backs off
+void AppController::waitWithLights(unsigned long durationMs) {
+    const unsigned long start = millis();
+    while (millis() - start < durationMs) {
+        m_lightController->update();
+        delay(10);
+    }
+    m_lightController->update();
+}
+
 void AppController::loadConfiguration() {
     ConfigManager& config = ConfigManager::getInstance();
     int retries = 0;
     while (!config.loadConfig() && retries < MAX_CONFIG_RETRIES) {
         LOG_WARN(TAG, "⚠️ Failed to load config. Retrying… (%d/%d)", retries + 1, MAX_CONFIG_RETRIES);
         m_lightController->blinkEyes(5);
-        delay(500);
+        waitWithLights(5 * LightController::SIMPLE_BLINK_PERIOD_MS + RETRY_BACKOFF_MS);
         ++retries;
     }
 
@@ -364,6 +408,7 @@ void AppController::loadConfiguration() {
     if (m_printerLogoPath.isEmpty()) {
         m_printerLogoPath = DEFAULT_PRINTER_LOGO;
     }
+    m_printerFontPath = m_configLoaded ? config.getPrinterFont() : String();
 
     m_initializationAudioPath = DEFAULT_INITIALIZATION_AUDIO;
 
@@ -376,6 +421,8 @@ void AppController::loadConfiguration() {
         if (m_snapDelayMinMs > m_snapDelayMaxMs) {
             std::swap(m_snapDelayMinMs, m_snapDelayMaxMs);
         }
+        m_lightController->setPwmResolution(config.getLedPwmBits());
+        m_lightController->setGammaCorrection(config.getLedGamma());
         m_lightController->configureMouthLED(config.getMouthLedBright(),
                                              config.getMouthLedPulseMin(),
                                              config.getMouthLedPulseMax(),
@@ -461,6 +508,8 @@ void AppController::initializePrinter() {
 
     if (m_thermalPrinter) {
         m_thermalPrinter->setLogoPath(m_printerLogoPath);
+        m_thermalPrinter->setFontPath(m_printerFontPath);
+        m_thermalPrinter->setFlowControlPin(m_pins.printerDtr);
         m_thermalPrinter->begin();
     } else {
         LOG_WARN(FLOW_TAG, "Thermal printer unavailable");
@@ -476,6 +525,11 @@ void AppController::initializeFingerSensor() {
     m_fingerSensor->setFilterAlpha(config.getFingerFilterAlpha());
     m_fingerSensor->setBaselineDrift(config.getFingerBaselineDrift());
     m_fingerSensor->setMultisampleCount(config.getFingerMultisample());
+    TouchDetector::Algorithm detector = TouchDetector::Algorithm::Threshold;
+    if (TouchDetector::parseAlgorithm(config.getFingerDetector().c_str(), detector)) {
+        m_fingerSensor->setDetectionAlgorithm(detector);
+    }
+    m_fingerSensor->setPrefilterWindows(config.getFingerMedianWindow(), config.getFingerHampelWindow());
     m_fingerSensor->setSensitivity(config.getCapThreshold());
     m_fingerSensor->begin();
     m_fingerSensor->setStableDurationMs(m_fingerStableMs);
@@ -610,13 +664,12 @@ void AppController::initializeSkitSystems() {
                                                                     m_sdCardManager,
                                                                     servoMinDegrees,
                                                                     servoMaxDegrees);
-        m_skullAudioAnimator->setSpeakingStateCallback([this](bool speaking) {
-            if (!m_lightController) {
-                return;
-            }
-            m_lightController->setEyeBrightness(speaking ? LightController::BRIGHTNESS_MAX
-                                                         : LightController::BRIGHTNESS_DIM);
-        });
+        // The animator drives the eyes from the audio envelope itself
+        ConfigManager& config = ConfigManager::getInstance();
+        AudioEnvelope::Settings envelope;
+        envelope.attackMs = config.getLedAudioAttackMs();
+        envelope.releaseMs = config.getLedAudioReleaseMs();
+        m_skullAudioAnimator->setLightEnvelope(envelope);
     }
 
     if (!m_skitSelector) {
@@ -639,6 +692,9 @@ void AppController::initializeConnectivity() {
 
     if (m_remoteDebugManager) {
         m_remoteDebugManager->setBluetoothController(m_bluetoothController);
+        m_remoteDebugManager->setMemoryMonitor(m_memoryMonitor.get());
+        m_remoteDebugManager->setLoopProfiler(&m_loopProfiler);
+        m_remoteDebugManager->setAudioPlayer(m_audioPlayer);
     }
 
     auto pauseRemoteDebugForOta = [this]() {
@@ -810,7 +866,12 @@ void AppController::processControllerActions(const DeathController::ControllerAc
         }
     }
     if (!actions.fortuneText.empty()) {
-        printFortuneToSerial(String(actions.fortuneText.c_str()));
+        const String fortuneText(actions.fortuneText.c_str());
+        printFortuneToSerial(fortuneText);
+        // Render while the preamble plays so the print starts on request
+        if (m_thermalPrinter && !actions.queueFortunePrint && !m_thermalPrinter->isPrinting()) {
+            m_thermalPrinter->prepareFortuneJob(fortuneText);
+        }
     }
 
     if (actions.requestMouthOpen || actions.requestMouthClose) {
@@ -866,7 +927,16 @@ void AppController::processControllerActions(const DeathController::ControllerAc
 }
 
 void AppController::updatePrinterFaultIndicator() {
-    if (!m_thermalPrinter || m_printerFaultLatched || !m_lightController) {
+    if (!m_thermalPrinter || !m_lightController) {
+        return;
+    }
+    if (m_printerFaultLatched) {
+        // Faults reported by the status poll clear themselves once fixed
+        if (!m_thermalPrinter->hasError()) {
+            m_printerFaultLatched = false;
+            m_lightController->stopEyeBlinkPattern();
+            LOG_INFO(LED_TAG, "Printer fault cleared");
+        }
         return;
     }
     if (m_thermalPrinter->hasError()) {
@@ -884,15 +954,20 @@ void AppController::updatePrinterFaultIndicator() {
 }
 
 void AppController::breathingJawMovement() {
-    if (!m_audioPlayer || m_audioPlayer->isAudioPlaying() || !m_servoController) {
+    if (!m_audioPlayer || m_audioPlayer->isAudioPlaying() || !m_servoController ||
+        m_servoController->isMoving()) {
         return;
     }
     const int closedPosition = getServoClosedPosition();
     int openTarget = closedPosition + BREATHING_JAW_ANGLE;
     openTarget = std::min(openTarget, getServoOpenPosition());
-    m_servoController->smoothMove(openTarget, BREATHING_MOVEMENT_DURATION);
-    delay(100);
-    m_servoController->smoothMove(closedPosition, BREATHING_MOVEMENT_DURATION);
+    m_servoController->moveTo(openTarget,
+                              BREATHING_MOVEMENT_DURATION,
+                              ServoController::Easing::EaseInOut,
+                              BREATHING_HOLD_DURATION);
+    m_servoController->queueMove(closedPosition,
+                                 BREATHING_MOVEMENT_DURATION,
+                                 ServoController::Easing::EaseInOut);
 }
 
 void AppController::handleUartCommand(UARTCommand cmd) {
@@ -919,6 +994,24 @@ void AppController::handleUartCommand(UARTCommand cmd) {
     m_deathController->clearActions();
 }
 
+void AppController::prepareNextFortuneJob() {
+    if (!m_thermalPrinter || !m_fortuneServiceAdapter || !m_deathController) {
+        return;
+    }
+    const DeathController::State state = m_deathController->state();
+    if (state != DeathController::State::Idle && state != DeathController::State::Cooldown) {
+        return;
+    }
+    if (m_thermalPrinter->isPrinting() || m_thermalPrinter->hasPreparedJob()) {
+        return;
+    }
+    // Generate the next fortune now; the controller picks it up on its next cycle
+    if (!m_fortuneServiceAdapter->prefetch()) {
+        return;
+    }
+    m_thermalPrinter->prepareFortuneJob(String(m_fortuneServiceAdapter->prefetched().c_str()));
+}
+
 void AppController::printFortuneToSerial(const String& fortune) {
     Serial.println();
     Serial.println(F("=== FORTUNE ==="));
@@ -1307,6 +1400,47 @@ void AppController::configureCliRouter() {
         printer.println();
     };
 
+    deps.memoryReporter = [this](CliCommandRouter::IPrinter& printer) {
+        printer.println();
+        m_memoryMonitor->writeReport([&printer](const char* line) {
+            printer.println(line);
+        });
+        printer.println();
+    };
+
+    deps.loopProfileReporter = [this](CliCommandRouter::IPrinter& printer) {
+        printer.println();
+        m_loopProfiler.writeReport([&printer](const char* line) {
+            printer.println(line);
+        });
+        if (m_servoController) {
+            const auto servo = m_servoController->controlStats();
+            printer.printf("Servo control: %u ticks, %u writes, %u targets (%u coalesced), %u dropped cmds\n",
+                           static_cast<unsigned>(servo.ticks),
+                           static_cast<unsigned>(servo.writes),
+                           static_cast<unsigned>(servo.directTargets),
+                           static_cast<unsigned>(servo.coalescedTargets),
+                           static_cast<unsigned>(servo.droppedCommands));
+        }
+        printer.println();
+    };
+    deps.loopProfileReset = [this]() {
+        m_loopProfiler.reset();
+    };
+
+    if (m_audioPlayer) {
+        deps.audioStatsReporter = [this](CliCommandRouter::IPrinter& printer) {
+            printer.println();
+            m_audioPlayer->telemetry().writeReport([&printer](const char* line) {
+                printer.println(line);
+            });
+            printer.println();
+        };
+        deps.audioStatsReset = [this]() {
+            m_audioPlayer->resetTelemetry();
+        };
+    }
+
     m_cliRouterOwned = std::make_unique<CliCommandRouter>(deps);
     m_cliRouter = m_cliRouterOwned.get();
 }
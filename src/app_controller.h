@@ -10,6 +10,7 @@
 #include "audio_player.h"
 #include "cli_command_router.h"
 #include "fortune_generator.h"
+#include "loop_profiler.h"
 #include "runtime/module_options.h"
 #include "sd_card_manager.h"
 #include "death_controller.h"
@@ -21,6 +22,7 @@ class CliService;
 class FingerSensor;
 class FortuneServiceAdapter;
 class LightController;
+class MemoryMonitor;
 class ManualCalibrationAdapter;
 class OTAManager;
 class PrinterStatusAdapter;
@@ -33,6 +35,7 @@ class WiFiManager;
 class ServoController;
 
 namespace infra {
+class IHeapProbe;
 class ILogSink;
 class IRandomSource;
 class ITimeProvider;
@@ -47,6 +50,7 @@ public:
         int fingerSensor = 4;
         int printerTx = 18;
         int printerRx = 19;
+        int printerDtr = -1;  // Optional printer busy/DTR line (LOW = ready)
         int uartMatterTx = 21;
         int uartMatterRx = 22;
     };
@@ -97,6 +101,7 @@ private:
 
     void setupLogging();
     void mountSdCard();
+    void waitWithLights(unsigned long durationMs);
     void loadConfiguration();
     void initializeServo();
     void initializeAudio();
@@ -112,6 +117,7 @@ private:
 
     void processControllerActions(const DeathController::ControllerActions& actions);
     void updatePrinterFaultIndicator();
+    void prepareNextFortuneJob();
     void breathingJawMovement();
     void handleUartCommand(UARTCommand cmd);
     void printFortuneToSerial(const String& fortune);
@@ -205,10 +211,15 @@ private:
     std::unique_ptr<DeathController> m_deathController;
     std::unique_ptr<SkullAudioAnimator> m_skullAudioAnimator;
 
+    std::unique_ptr<infra::IHeapProbe> m_heapProbe;
+    std::unique_ptr<MemoryMonitor> m_memoryMonitor;
+    LoopProfiler m_loopProfiler;
+
     FortuneGenerator m_fortuneGenerator;
 
     String m_initializationAudioPath;
     String m_printerLogoPath;
+    String m_printerFontPath;
     String m_fortunesJsonPath;
     std::vector<std::string> m_fortuneCandidates;
 
@@ -1,4 +1,5 @@
 #include "audio_directory_selector.h"
+#include "infra/alloc_tracker.h"
 #ifdef UNIT_TEST
 #include "logging_stub.h"
 #else
@@ -53,6 +54,7 @@ AudioDirectorySelector::AudioDirectorySelector(const Dependencies &deps)
 }
 
 String AudioDirectorySelector::selectClip(const char *directory, const char *description) {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Audio);
     if (!directory || directory[0] == '\0') {
         LOG_WARN(TAG, "Invalid directory provided for selection");
         return "";
@@ -0,0 +1,60 @@
+#include "audio_envelope.h"
+
+#include <algorithm>
+#include <cmath>
+
+AudioBlockFeatures AudioBlockFeatures::fromSumOfSquares(double sumOfSquares,
+                                                        uint32_t samples,
+                                                        uint32_t frames,
+                                                        uint32_t sampleRate) {
+    AudioBlockFeatures block;
+    block.frames = frames;
+    block.rms = samples ? static_cast<float>(std::sqrt(sumOfSquares / samples)) : 0.0f;
+    block.durationUs = sampleRate ? static_cast<uint32_t>((static_cast<uint64_t>(frames) * 1000000ull) / sampleRate) : 0;
+    return block;
+}
+
+AudioEnvelope::AudioEnvelope()
+    : AudioEnvelope(Settings()) {
+}
+
+AudioEnvelope::AudioEnvelope(const Settings &settings)
+    : m_settings(),
+      m_rms(0.0f) {
+    configure(settings);
+}
+
+void AudioEnvelope::configure(const Settings &settings) {
+    m_settings = settings;
+    m_settings.floorRms = std::max(0.0f, m_settings.floorRms);
+    m_settings.ceilingRms = std::max(m_settings.floorRms + 1.0f, m_settings.ceilingRms);
+}
+
+float AudioEnvelope::update(const AudioBlockFeatures &block) {
+    const uint32_t timeConstant = block.rms > m_rms ? m_settings.attackMs : m_settings.releaseMs;
+    m_rms += (block.rms - m_rms) * coefficient(timeConstant, block.durationUs);
+    return value();
+}
+
+void AudioEnvelope::reset() {
+    m_rms = 0.0f;
+}
+
+float AudioEnvelope::value() const {
+    const float span = m_settings.ceilingRms - m_settings.floorRms;
+    return std::min(1.0f, std::max(0.0f, (m_rms - m_settings.floorRms) / span));
+}
+
+uint8_t AudioEnvelope::level(uint8_t minLevel, uint8_t maxLevel) const {
+    const float range = static_cast<float>(maxLevel) - static_cast<float>(minLevel);
+    return static_cast<uint8_t>(std::lround(static_cast<float>(minLevel) + range * value()));
+}
+
+// One-pole smoothing step for a block: 1 - exp(-dt / tau). A zero time
+// constant follows the input immediately.
+float AudioEnvelope::coefficient(uint32_t timeConstantMs, uint32_t blockUs) {
+    if (timeConstantMs == 0) {
+        return 1.0f;
+    }
+    return 1.0f - std::exp(-static_cast<float>(blockUs) / (static_cast<float>(timeConstantMs) * 1000.0f));
+}
@@ -0,0 +1,56 @@
+#ifndef AUDIO_ENVELOPE_H
+#define AUDIO_ENVELOPE_H
+
+#include <stdint.h>
+
+/**
+ * Per-block audio features, measured once per A2DP callback and shared by
+ * every consumer (jaw, LEDs) so the samples are only walked once.
+ */
+struct AudioBlockFeatures {
+    float rms = 0.0f;          // RMS over both channels
+    uint32_t frames = 0;
+    uint32_t durationUs = 0;   // Play time of the block at the stream's sample rate
+
+    static AudioBlockFeatures fromSumOfSquares(double sumOfSquares, uint32_t samples, uint32_t frames, uint32_t sampleRate);
+};
+
+/**
+ * Attack/release envelope follower on the block RMS. Rising input follows
+ * the attack time constant, falling input the release one; both are scaled
+ * by the block duration, so the response does not depend on the callback
+ * size. value() is the envelope normalized between the floor (silence) and
+ * the ceiling (full level) RMS.
+ */
+class AudioEnvelope {
+public:
+    struct Settings {
+        uint32_t attackMs = 20;
+        uint32_t releaseMs = 250;
+        float floorRms = 200.0f;    // Below this counts as silence
+        float ceilingRms = 3000.0f; // At or above this the envelope is 1
+    };
+
+    AudioEnvelope();
+    explicit AudioEnvelope(const Settings &settings);
+
+    void configure(const Settings &settings);
+    const Settings &settings() const { return m_settings; }
+
+    // Advances the follower by one block and returns value()
+    float update(const AudioBlockFeatures &block);
+    void reset();
+
+    float rms() const { return m_rms; }
+    float value() const;
+    // value() mapped onto [minLevel, maxLevel], rounded
+    uint8_t level(uint8_t minLevel, uint8_t maxLevel) const;
+
+private:
+    static float coefficient(uint32_t timeConstantMs, uint32_t blockUs);
+
+    Settings m_settings;
+    float m_rms;
+};
+
+#endif  // AUDIO_ENVELOPE_H
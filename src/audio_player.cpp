@@ -20,6 +20,7 @@
 
 #include "audio_player.h"
 #include "logging_manager.h"
+#include "infra/alloc_tracker.h"
 
 #ifdef ARDUINO
 
@@ -44,6 +45,7 @@ AudioPlayer::AudioPlayer(SDCardManager &sdCardManager)
       m_fileEndBufferPos(BUFFER_POS_UNDEFINED),
       m_fileEndPath(""),
       m_isAudioPlaying(false),
+      m_streamActive(false),
       m_muted(false),
       m_sdCardManager(sdCardManager),
       m_pendingStartEvent(false),
@@ -96,12 +98,16 @@ int32_t IRAM_ATTR AudioPlayer::provideAudioFrames(Frame *frame, int32_t frame_co
     portENTER_CRITICAL_ISR(&m_bufferMux);
 
     size_t available = m_bufferFilled;
+    const bool streaming = m_streamActive;
     if (available == 0)
     {
         m_isAudioPlaying = false;
         muted = m_muted;
         portEXIT_CRITICAL_ISR(&m_bufferMux);
 
+        m_telemetry.recordCallback(0, AUDIO_BUFFER_SIZE, static_cast<uint32_t>(frame_count),
+                                   static_cast<uint32_t>(frame_count), streaming);
+
         if (bytesRequested > 0)
         {
             memset(frame, 0, bytesRequested);
@@ -109,6 +115,7 @@ int32_t IRAM_ATTR AudioPlayer::provideAudioFrames(Frame *frame, int32_t frame_co
         return frame_count;
     }
 
+    const size_t fillBeforeRead = available;
     size_t bytesToRead = bytesRequested;
     if (bytesToRead > available)
     {
@@ -160,6 +167,10 @@ int32_t IRAM_ATTR AudioPlayer::provideAudioFrames(Frame *frame, int32_t frame_co
 
     portEXIT_CRITICAL_ISR(&m_bufferMux);
 
+    m_telemetry.recordCallback(fillBeforeRead, AUDIO_BUFFER_SIZE, static_cast<uint32_t>(frame_count),
+                               static_cast<uint32_t>((bytesRequested - bytesCopied) / sizeof(Frame)),
+                               streaming);
+
     if (bytesCopied < bytesRequested)
     {
         memset(reinterpret_cast<uint8_t *>(frame) + bytesCopied, 0, bytesRequested - bytesCopied);
@@ -194,6 +205,7 @@ int32_t AudioPlayer::provideAudioData(uint8_t *data, uint32_t len)
 
 void AudioPlayer::update()
 {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Audio);
     handlePendingEvents();
     fillBuffer();
     handlePendingEvents();
@@ -201,6 +213,9 @@ void AudioPlayer::update()
 
 void AudioPlayer::fillBuffer()
 {
+    const unsigned long refillStartUs = micros();
+    size_t bytesRefilled = 0;
+
     while (true)
     {
         size_t bufferFilledSnapshot = 0;
@@ -232,10 +247,13 @@ void AudioPlayer::fillBuffer()
         }
 
         uint8_t audioData[512];
+        const unsigned long readStartUs = micros();
         size_t bytesRead = audioFile.read(audioData, sizeof(audioData));
+        m_telemetry.recordSdRead(static_cast<uint32_t>(micros() - readStartUs));
         if (bytesRead > 0)
         {
             writeToBuffer(audioData, bytesRead);
+            bytesRefilled += bytesRead;
         }
         else
         {
@@ -246,6 +264,11 @@ void AudioPlayer::fillBuffer()
             portEXIT_CRITICAL(&m_bufferMux);
         }
     }
+
+    if (bytesRefilled > 0)
+    {
+        m_telemetry.recordRefill(static_cast<uint32_t>(micros() - refillStartUs), bytesRefilled);
+    }
 }
 
 void AudioPlayer::writeToBuffer(const uint8_t *audioData, size_t dataSize)
@@ -311,6 +334,7 @@ bool AudioPlayer::startNextFile()
             {
                 portEXIT_CRITICAL(&m_queueMux);
                 m_currentBufferingFilePath = "";
+                m_streamActive = false;
                 return false;
             }
             nextFile = audioQueue.front();
@@ -318,15 +342,19 @@ bool AudioPlayer::startNextFile()
             portEXIT_CRITICAL(&m_queueMux);
         }
 
+        const unsigned long openStartUs = micros();
         audioFile = m_sdCardManager.openFile(nextFile.c_str());
         if (!audioFile)
         {
+            m_telemetry.recordFileOpen(static_cast<uint32_t>(micros() - openStartUs), false);
             LOG_ERROR(TAG, "Failed to open audio file: %s", nextFile.c_str());
             continue;
         }
 
         // Skip WAV header (simplified approach)
         audioFile.seek(128);
+        m_telemetry.recordFileOpen(static_cast<uint32_t>(micros() - openStartUs), true);
+        m_streamActive = true;
 
         portENTER_CRITICAL(&m_bufferMux);
         m_currentBufferingFilePath = String(nextFile.c_str());
@@ -350,6 +378,19 @@ bool AudioPlayer::isAudioPlaying() const
     return m_isAudioPlaying;
 }
 
+bool AudioPlayer::hasSdHeadroom() const
+{
+    if (!m_streamActive && !m_isAudioPlaying)
+    {
+        return true;
+    }
+    size_t bufferFilledSnapshot = 0;
+    portENTER_CRITICAL(&const_cast<AudioPlayer *>(this)->m_bufferMux);
+    bufferFilledSnapshot = m_bufferFilled;
+    portEXIT_CRITICAL(&const_cast<AudioPlayer *>(this)->m_bufferMux);
+    return bufferFilledSnapshot >= SD_HEADROOM_BYTES;
+}
+
 unsigned long AudioPlayer::getPlaybackTime() const
 {
     size_t bytesPlayedSnapshot = 0;
@@ -3,6 +3,7 @@
 
 #include "FS.h"
 #include "sd_card_manager.h"
+#include "audio_telemetry.h"
 #ifdef ARDUINO
 #include "BluetoothA2DPSource.h" // For Frame definition
 #else
@@ -52,6 +53,11 @@ public:
     // Check if audio is currently playing
     bool isAudioPlaying() const;
 
+    // True when other SD work may block the main loop without risking an
+    // underrun: nothing is streaming, or the buffer is above
+    // SD_HEADROOM_BYTES (about 35 ms of audio).
+    bool hasSdHeadroom() const;
+
     // Set the muted state of the audio player
     void setMuted(bool muted);
 
@@ -72,12 +78,17 @@ public:
 
     bool hasQueuedAudio();
 
+    // Underrun, buffer-fill and SD latency counters
+    const AudioTelemetry &telemetry() const { return m_telemetry; }
+    void resetTelemetry() { m_telemetry.reset(); }
+
 private:
     void handlePendingEvents();
 
     static constexpr const char *IDENTIFIER = "AudioPlayer";
     static constexpr size_t BUFFER_POS_UNDEFINED = static_cast<size_t>(-1);
     static constexpr size_t AUDIO_BUFFER_SIZE = 8192; // Size of the circular audio buffer
+    static constexpr size_t SD_HEADROOM_BYTES = AUDIO_BUFFER_SIZE * 3 / 4; // High watermark for foreign SD writes
 
     // Hardcoded audio format specifications
     static constexpr uint32_t AUDIO_SAMPLE_RATE = 44100;
@@ -109,6 +120,7 @@ private:
     File audioFile;
     String m_currentPlayingFilePath;
     volatile bool m_isAudioPlaying;
+    volatile bool m_streamActive;  // A file is open (or queued) and feeding the buffer
     bool m_muted;
 
     // Timing
@@ -138,6 +150,8 @@ private:
 
     volatile size_t m_bytesPlayed;  // Total bytes played for the current file
 
+    AudioTelemetry m_telemetry;
+
     // New method to reset byte counters
     void resetByteCounters();
 
@@ -0,0 +1,153 @@
+#include "audio_telemetry.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+void IRAM_ATTR AudioTelemetry::recordCallback(size_t fillBytes,
+                                              size_t capacityBytes,
+                                              uint32_t requestedFrames,
+                                              uint32_t silentFrames,
+                                              bool streaming) {
+    m_callbacks = m_callbacks + 1;
+    m_framesRequested = m_framesRequested + requestedFrames;
+
+    if (capacityBytes > 0) {
+        size_t bucket = (fillBytes * FILL_BUCKETS) / capacityBytes;
+        if (bucket >= FILL_BUCKETS) {
+            bucket = FILL_BUCKETS - 1;
+        }
+        m_fillBuckets[bucket] = m_fillBuckets[bucket] + 1;
+    }
+
+    if (!streaming) {
+        m_inUnderrun = false;
+        return;
+    }
+
+    if (fillBytes < m_minStreamingFill) {
+        m_minStreamingFill = static_cast<uint32_t>(fillBytes);
+    }
+
+    if (silentFrames > 0) {
+        m_silentFrames = m_silentFrames + silentFrames;
+        m_underrunCallbacks = m_underrunCallbacks + 1;
+        if (!m_inUnderrun) {
+            m_underrunEvents = m_underrunEvents + 1;
+            m_inUnderrun = true;
+        }
+    } else {
+        m_inUnderrun = false;
+    }
+}
+
+void AudioTelemetry::recordRefill(uint32_t durationUs, size_t bytes) {
+    m_refill.record(durationUs);
+    m_bytesRefilled += bytes;
+}
+
+void AudioTelemetry::recordSdRead(uint32_t latencyUs) {
+    m_sdRead.record(latencyUs);
+}
+
+void AudioTelemetry::recordFileOpen(uint32_t latencyUs, bool success) {
+    m_fileOpen.record(latencyUs);
+    if (!success) {
+        ++m_openFailures;
+    }
+}
+
+// Callback-side counters are cleared from the loop task; an increment racing
+// the reset is simply lost, which is acceptable for diagnostics.
+void AudioTelemetry::reset() {
+    m_callbacks = 0;
+    m_underrunEvents = 0;
+    m_underrunCallbacks = 0;
+    m_silentFrames = 0;
+    m_framesRequested = 0;
+    for (auto &bucket : m_fillBuckets) {
+        bucket = 0;
+    }
+    m_minStreamingFill = UINT32_MAX;
+    m_inUnderrun = false;
+    m_openFailures = 0;
+    m_bytesRefilled = 0;
+    m_refill.reset();
+    m_sdRead.reset();
+    m_fileOpen.reset();
+}
+
+void AudioTelemetry::writeSummary(char *buffer, size_t size) const {
+    if (!buffer || size == 0) {
+        return;
+    }
+    snprintf(buffer, size,
+             "underruns=%u silent=%u refill p99=%uus sd read p99=%uus open p99=%uus",
+             static_cast<unsigned>(m_underrunEvents),
+             static_cast<unsigned>(m_silentFrames),
+             static_cast<unsigned>(m_refill.percentileUs(990)),
+             static_cast<unsigned>(m_sdRead.percentileUs(990)),
+             static_cast<unsigned>(m_fileOpen.percentileUs(990)));
+}
+
+void AudioTelemetry::writeReport(const LineWriter &write) const {
+    if (!write) {
+        return;
+    }
+    char line[112];
+    write("=== AUDIO STATS ===");
+    snprintf(line, sizeof(line), "Callbacks:       %u (%u frames requested)",
+             static_cast<unsigned>(m_callbacks),
+             static_cast<unsigned>(m_framesRequested));
+    write(line);
+    snprintf(line, sizeof(line), "Underruns:       %u events, %u short callbacks, %u silent frames",
+             static_cast<unsigned>(m_underrunEvents),
+             static_cast<unsigned>(m_underrunCallbacks),
+             static_cast<unsigned>(m_silentFrames));
+    write(line);
+    if (m_minStreamingFill == UINT32_MAX) {
+        write("Min fill:        n/a (no streaming callbacks yet)");
+    } else {
+        snprintf(line, sizeof(line), "Min fill:        %u bytes while streaming",
+                 static_cast<unsigned>(m_minStreamingFill));
+        write(line);
+    }
+
+    uint32_t totalFill = 0;
+    for (size_t i = 0; i < FILL_BUCKETS; ++i) {
+        totalFill += m_fillBuckets[i];
+    }
+    write("Buffer fill at callback:");
+    for (size_t i = 0; i < FILL_BUCKETS; ++i) {
+        const unsigned lowPct = static_cast<unsigned>((i * 100) / FILL_BUCKETS);
+        const unsigned highPct = static_cast<unsigned>(((i + 1) * 100) / FILL_BUCKETS);
+        const unsigned share = totalFill
+                                   ? static_cast<unsigned>((static_cast<uint64_t>(m_fillBuckets[i]) * 100) / totalFill)
+                                   : 0;
+        snprintf(line, sizeof(line), "  %3u-%3u%%  %10u  (%u%%)",
+                 lowPct, highPct,
+                 static_cast<unsigned>(m_fillBuckets[i]),
+                 share);
+        write(line);
+    }
+
+    write("Latency (us)       count     min     avg     p50     p99     max");
+    const auto writeHistogram = [&](const char *name, const infra::LatencyHistogram &histogram) {
+        snprintf(line, sizeof(line), "%-14s %9u %7u %7u %7u %7u %7u",
+                 name,
+                 static_cast<unsigned>(histogram.count()),
+                 static_cast<unsigned>(histogram.minUs()),
+                 static_cast<unsigned>(histogram.avgUs()),
+                 static_cast<unsigned>(histogram.percentileUs(500)),
+                 static_cast<unsigned>(histogram.percentileUs(990)),
+                 static_cast<unsigned>(histogram.maxUs()));
+        write(line);
+    };
+    writeHistogram("refill", m_refill);
+    writeHistogram("sd read", m_sdRead);
+    writeHistogram("file open", m_fileOpen);
+
+    snprintf(line, sizeof(line), "Refilled:        %" PRIu64 " bytes, %u open failures",
+             m_bytesRefilled,
+             static_cast<unsigned>(m_openFailures));
+    write(line);
+}
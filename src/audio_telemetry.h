@@ -0,0 +1,80 @@
+#ifndef AUDIO_TELEMETRY_H
+#define AUDIO_TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+#include "infra/latency_histogram.h"
+
+#ifdef ARDUINO
+#include "esp_attr.h"
+#else
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#endif
+
+/**
+ * Counters for AudioPlayer buffer health. The A2DP callback is the only
+ * writer of the callback-side fields and the main loop the only writer of the
+ * refill/SD fields, so plain integers suffice; readers may see a slightly torn
+ * snapshot, which is fine for diagnostics.
+ */
+class AudioTelemetry {
+public:
+    using LineWriter = std::function<void(const char *line)>;
+
+    static constexpr size_t FILL_BUCKETS = 8;
+
+    // Called from the audio callback with the buffer level before the copy.
+    // `streaming` is true while a file is still being fed into the buffer, so
+    // silence padded at the natural end of playback is not counted.
+    void IRAM_ATTR recordCallback(size_t fillBytes,
+                                  size_t capacityBytes,
+                                  uint32_t requestedFrames,
+                                  uint32_t silentFrames,
+                                  bool streaming);
+
+    void recordRefill(uint32_t durationUs, size_t bytes);
+    void recordSdRead(uint32_t latencyUs);
+    void recordFileOpen(uint32_t latencyUs, bool success);
+
+    void reset();
+
+    uint32_t callbacks() const { return m_callbacks; }
+    uint32_t underrunEvents() const { return m_underrunEvents; }
+    uint32_t underrunCallbacks() const { return m_underrunCallbacks; }
+    uint32_t silentFrames() const { return m_silentFrames; }
+    uint32_t framesRequested() const { return m_framesRequested; }
+    uint32_t fillBucket(size_t index) const { return index < FILL_BUCKETS ? m_fillBuckets[index] : 0; }
+    // Lowest buffer level seen while streaming; UINT32_MAX until the first sample.
+    uint32_t minStreamingFillBytes() const { return m_minStreamingFill; }
+    uint32_t openFailures() const { return m_openFailures; }
+    uint64_t bytesRefilled() const { return m_bytesRefilled; }
+
+    const infra::LatencyHistogram &refillLatency() const { return m_refill; }
+    const infra::LatencyHistogram &sdReadLatency() const { return m_sdRead; }
+    const infra::LatencyHistogram &fileOpenLatency() const { return m_fileOpen; }
+
+    void writeSummary(char *buffer, size_t size) const;
+    void writeReport(const LineWriter &write) const;
+
+private:
+    volatile uint32_t m_callbacks = 0;
+    volatile uint32_t m_underrunEvents = 0;
+    volatile uint32_t m_underrunCallbacks = 0;
+    volatile uint32_t m_silentFrames = 0;
+    volatile uint32_t m_framesRequested = 0;
+    volatile uint32_t m_fillBuckets[FILL_BUCKETS] = {};
+    volatile uint32_t m_minStreamingFill = UINT32_MAX;
+    volatile bool m_inUnderrun = false;
+
+    uint32_t m_openFailures = 0;
+    uint64_t m_bytesRefilled = 0;
+    infra::LatencyHistogram m_refill;
+    infra::LatencyHistogram m_sdRead;
+    infra::LatencyHistogram m_fileOpen;
+};
+
+#endif  // AUDIO_TELEMETRY_H
@@ -0,0 +1,261 @@
+#include "bitmap_font.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "infra/log_sink.h"
+
+namespace {
+constexpr const char *kTag = "BitmapFont";
+
+uint16_t readLE16(const uint8_t *data) {
+    return static_cast<uint16_t>(data[0]) |
+           static_cast<uint16_t>(data[1]) << 8;
+}
+
+uint32_t readLE32(const uint8_t *data) {
+    return static_cast<uint32_t>(data[0]) |
+           (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) |
+           (static_cast<uint32_t>(data[3]) << 24);
+}
+}  // namespace
+
+BitmapFont::BitmapFont()
+    : m_readAt(),
+      m_loaded(false),
+      m_lineHeight(0),
+      m_ascent(0),
+      m_bitmapBase(0),
+      m_glyphs(),
+      m_kernKeys(),
+      m_kernAdjust(),
+      m_preloaded(),
+      m_cacheLimit(DEFAULT_CACHE_BYTES),
+      m_cache(),
+      m_cacheStats() {
+}
+
+void BitmapFont::reset() {
+    m_readAt = nullptr;
+    m_loaded = false;
+    m_lineHeight = 0;
+    m_ascent = 0;
+    m_bitmapBase = 0;
+    m_glyphs.clear();
+    m_kernKeys.clear();
+    m_kernAdjust.clear();
+    m_preloaded.clear();
+    m_preloaded.shrink_to_fit();
+    m_cache.clear();
+    m_cacheStats = CacheStats();
+}
+
+bool BitmapFont::load(ReadAt readAt, size_t cacheBytes) {
+    reset();
+    if (!readAt) {
+        return false;
+    }
+
+    uint8_t header[HEADER_BYTES];
+    if (readAt(0, header, sizeof(header)) != sizeof(header) ||
+        header[0] != 'D' || header[1] != 'F' || header[2] != 'N' || header[3] != 'T') {
+        infra::emitLog(infra::LogLevel::Error, kTag, "Font header missing or not a DFNT file");
+        return false;
+    }
+    if (header[4] != VERSION) {
+        infra::emitLog(infra::LogLevel::Error, kTag,
+                       "Unsupported font version %u", static_cast<unsigned>(header[4]));
+        return false;
+    }
+
+    const uint8_t lineHeight = header[5];
+    const uint8_t ascent = header[6];
+    const uint16_t glyphCount = readLE16(header + 8);
+    const uint16_t kernCount = readLE16(header + 10);
+    if (lineHeight == 0 || glyphCount == 0) {
+        infra::emitLog(infra::LogLevel::Error, kTag, "Font has no glyphs or zero line height");
+        return false;
+    }
+
+    std::vector<uint8_t> table(static_cast<size_t>(glyphCount) * GLYPH_RECORD_BYTES);
+    if (readAt(HEADER_BYTES, table.data(), table.size()) != table.size()) {
+        infra::emitLog(infra::LogLevel::Error, kTag, "Font glyph table truncated");
+        return false;
+    }
+    m_glyphs.reserve(glyphCount);
+    for (uint16_t i = 0; i < glyphCount; ++i) {
+        const uint8_t *rec = table.data() + i * GLYPH_RECORD_BYTES;
+        Glyph g;
+        g.codepoint = readLE16(rec);
+        g.advance = rec[2];
+        g.width = rec[3];
+        g.height = rec[4];
+        g.xOffset = static_cast<int8_t>(rec[5]);
+        g.yOffset = rec[6];
+        g.bitmapOffset = readLE32(rec + 8);
+        if (!m_glyphs.empty() && g.codepoint <= m_glyphs.back().codepoint) {
+            infra::emitLog(infra::LogLevel::Error, kTag, "Font glyph table not sorted");
+            m_glyphs.clear();
+            return false;
+        }
+        m_glyphs.push_back(g);
+    }
+
+    const uint32_t kernOffset = HEADER_BYTES + static_cast<uint32_t>(table.size());
+    if (kernCount > 0) {
+        std::vector<uint8_t> kerns(static_cast<size_t>(kernCount) * KERN_RECORD_BYTES);
+        if (readAt(kernOffset, kerns.data(), kerns.size()) != kerns.size()) {
+            infra::emitLog(infra::LogLevel::Error, kTag, "Font kerning table truncated");
+            m_glyphs.clear();
+            return false;
+        }
+        m_kernKeys.reserve(kernCount);
+        m_kernAdjust.reserve(kernCount);
+        for (uint16_t i = 0; i < kernCount; ++i) {
+            const uint8_t *rec = kerns.data() + i * KERN_RECORD_BYTES;
+            m_kernKeys.push_back((static_cast<uint32_t>(readLE16(rec)) << 16) | readLE16(rec + 2));
+            m_kernAdjust.push_back(static_cast<int8_t>(rec[4]));
+        }
+        if (!std::is_sorted(m_kernKeys.begin(), m_kernKeys.end())) {
+            infra::emitLog(infra::LogLevel::Error, kTag, "Font kerning table not sorted");
+            reset();
+            return false;
+        }
+    }
+
+    m_readAt = std::move(readAt);
+    m_lineHeight = lineHeight;
+    m_ascent = ascent;
+    m_bitmapBase = kernOffset + static_cast<uint32_t>(kernCount) * KERN_RECORD_BYTES;
+    m_cacheLimit = cacheBytes;
+    m_loaded = true;
+    return true;
+}
+
+bool BitmapFont::preload(uint16_t first, uint16_t last, size_t maxBytes) {
+    if (!m_loaded) {
+        return false;
+    }
+    const Glyph *fallback = glyph('?');
+    const auto wanted = [first, last, fallback](const Glyph &g) {
+        return (g.codepoint >= first && g.codepoint <= last) || &g == fallback;
+    };
+
+    size_t total = 0;
+    for (const Glyph &g : m_glyphs) {
+        total += wanted(g) ? g.bitmapBytes() : 0;
+    }
+    if (total > maxBytes) {
+        return false;
+    }
+
+    std::vector<uint8_t> block(total);
+    std::vector<int32_t> offsets(m_glyphs.size(), -1);
+    size_t used = 0;
+    for (size_t i = 0; i < m_glyphs.size(); ++i) {
+        const Glyph &g = m_glyphs[i];
+        const size_t bytes = g.bitmapBytes();
+        if (!wanted(g) || bytes == 0) {
+            continue;
+        }
+        if (m_readAt(m_bitmapBase + g.bitmapOffset, block.data() + used, bytes) != bytes) {
+            infra::emitLog(infra::LogLevel::Warn, kTag,
+                           "Failed to preload glyph %u bitmap", static_cast<unsigned>(g.codepoint));
+            return false;
+        }
+        offsets[i] = static_cast<int32_t>(used);
+        used += bytes;
+    }
+
+    m_preloaded.swap(block);
+    for (size_t i = 0; i < m_glyphs.size(); ++i) {
+        m_glyphs[i].preloadOffset = offsets[i];
+    }
+    // Cached copies of preloaded glyphs are now dead weight
+    m_cache.clear();
+    m_cacheStats.bytes = 0;
+    m_cacheStats.preloadedBytes = m_preloaded.size();
+    return true;
+}
+
+const BitmapFont::Glyph *BitmapFont::glyph(uint16_t codepoint) const {
+    if (m_glyphs.empty()) {
+        return nullptr;
+    }
+    const auto find = [this](uint16_t cp) -> const Glyph * {
+        auto it = std::lower_bound(m_glyphs.begin(), m_glyphs.end(), cp,
+                                   [](const Glyph &g, uint16_t value) { return g.codepoint < value; });
+        return (it != m_glyphs.end() && it->codepoint == cp) ? &*it : nullptr;
+    };
+    if (const Glyph *g = find(codepoint)) {
+        return g;
+    }
+    if (const Glyph *g = find('?')) {
+        return g;
+    }
+    return &m_glyphs.front();
+}
+
+int8_t BitmapFont::kerning(uint16_t left, uint16_t right) const {
+    const uint32_t key = (static_cast<uint32_t>(left) << 16) | right;
+    auto it = std::lower_bound(m_kernKeys.begin(), m_kernKeys.end(), key);
+    if (it == m_kernKeys.end() || *it != key) {
+        return 0;
+    }
+    return m_kernAdjust[static_cast<size_t>(it - m_kernKeys.begin())];
+}
+
+int BitmapFont::advance(uint16_t codepoint, uint16_t next) const {
+    const Glyph *g = glyph(codepoint);
+    if (!g) {
+        return 0;
+    }
+    return g->advance + (next ? kerning(codepoint, next) : 0);
+}
+
+int BitmapFont::measure(const char *text, size_t length) const {
+    int width = 0;
+    for (size_t i = 0; i < length; ++i) {
+        const uint16_t cp = static_cast<uint8_t>(text[i]);
+        const uint16_t next = (i + 1 < length) ? static_cast<uint8_t>(text[i + 1]) : 0;
+        width += advance(cp, next);
+    }
+    return width;
+}
+
+const uint8_t *BitmapFont::bitmap(const Glyph &glyph) {
+    const size_t bytes = glyph.bitmapBytes();
+    if (!m_loaded || bytes == 0) {
+        return nullptr;
+    }
+
+    if (glyph.preloadOffset >= 0) {
+        ++m_cacheStats.hits;
+        return m_preloaded.data() + glyph.preloadOffset;
+    }
+
+    auto cached = m_cache.find(glyph.codepoint);
+    if (cached != m_cache.end()) {
+        ++m_cacheStats.hits;
+        return cached->second.data();
+    }
+
+    ++m_cacheStats.misses;
+    if (m_cacheStats.bytes + bytes > m_cacheLimit && !m_cache.empty()) {
+        // Flush rather than track recency: a fortune uses a few dozen glyphs.
+        m_cacheStats.evictions += static_cast<uint32_t>(m_cache.size());
+        m_cache.clear();
+        m_cacheStats.bytes = 0;
+    }
+
+    std::vector<uint8_t> data(bytes);
+    if (m_readAt(m_bitmapBase + glyph.bitmapOffset, data.data(), bytes) != bytes) {
+        infra::emitLog(infra::LogLevel::Warn, kTag,
+                       "Failed to read glyph %u bitmap", static_cast<unsigned>(glyph.codepoint));
+        return nullptr;
+    }
+    m_cacheStats.bytes += bytes;
+    auto inserted = m_cache.emplace(glyph.codepoint, std::move(data));
+    return inserted.first->second.data();
+}
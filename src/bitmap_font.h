@@ -0,0 +1,104 @@
+#ifndef BITMAP_FONT_H
+#define BITMAP_FONT_H
+
+#include <functional>
+#include <map>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Proportional 1-bit font loaded from a `.dfnt` file (see
+ * scripts/bdf_to_dfnt.py). Metrics and kerning pairs are read up front;
+ * glyph bitmaps are read on first use and cached per glyph, unless
+ * preload() has already pulled them into memory.
+ *
+ * File layout (little-endian):
+ *   header  16 bytes: "DFNT", version u8, lineHeight u8, ascent u8, pad u8,
+ *                     glyphCount u16, kernCount u16, reserved u32
+ *   glyphs  12 bytes each, sorted by codepoint: codepoint u16, advance u8,
+ *                     width u8, height u8, xOffset i8, yOffset u8 (rows from
+ *                     the line top), pad u8, bitmapOffset u32
+ *   kerning  6 bytes each, sorted by (left, right): left u16, right u16,
+ *                     adjust i8, pad u8
+ *   bitmaps rows of ceil(width / 8) bytes, MSB = leftmost dot, 1 = black
+ */
+class BitmapFont {
+public:
+    using ReadAt = std::function<size_t(uint32_t offset, uint8_t *data, size_t length)>;
+
+    static constexpr uint8_t VERSION = 1;
+    static constexpr size_t HEADER_BYTES = 16;
+    static constexpr size_t GLYPH_RECORD_BYTES = 12;
+    static constexpr size_t KERN_RECORD_BYTES = 6;
+    static constexpr size_t DEFAULT_CACHE_BYTES = 8 * 1024;
+
+    struct Glyph {
+        uint16_t codepoint = 0;
+        uint8_t advance = 0;
+        uint8_t width = 0;
+        uint8_t height = 0;
+        int8_t xOffset = 0;
+        uint8_t yOffset = 0;
+        uint32_t bitmapOffset = 0;
+        int32_t preloadOffset = -1;  // Into the preloaded bitmaps, -1 if not preloaded
+
+        size_t rowBytes() const { return (static_cast<size_t>(width) + 7) / 8; }
+        size_t bitmapBytes() const { return rowBytes() * height; }
+    };
+
+    struct CacheStats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t evictions = 0;
+        size_t bytes = 0;
+        size_t preloadedBytes = 0;
+    };
+
+    BitmapFont();
+
+    // Reads the header, glyph metrics and kerning table. The callback stays
+    // in use for glyph bitmaps until the font is reset or reloaded.
+    bool load(ReadAt readAt, size_t cacheBytes = DEFAULT_CACHE_BYTES);
+    void reset();
+    // Reads every bitmap in [first, last], plus the fallback glyph, into one
+    // block that is never evicted, so rendering those glyphs needs no reads.
+    // Loads nothing and returns false when they would take more than
+    // maxBytes or a read fails.
+    bool preload(uint16_t first, uint16_t last, size_t maxBytes);
+
+    bool isLoaded() const { return m_loaded; }
+    uint8_t lineHeight() const { return m_lineHeight; }
+    uint8_t ascent() const { return m_ascent; }
+    size_t glyphCount() const { return m_glyphs.size(); }
+
+    // Falls back to '?' and then to the first glyph for unknown codepoints.
+    const Glyph *glyph(uint16_t codepoint) const;
+    int8_t kerning(uint16_t left, uint16_t right) const;
+    // Advance of `codepoint` when followed by `next` (0 for end of text).
+    int advance(uint16_t codepoint, uint16_t next) const;
+    // Pixel width of a run of Latin-1 text, including kerning.
+    int measure(const char *text, size_t length) const;
+
+    // Cached bitmap for a glyph, or nullptr if it cannot be read.
+    const uint8_t *bitmap(const Glyph &glyph);
+    const CacheStats &cacheStats() const { return m_cacheStats; }
+
+private:
+    ReadAt m_readAt;
+    bool m_loaded;
+    uint8_t m_lineHeight;
+    uint8_t m_ascent;
+    uint32_t m_bitmapBase;
+    std::vector<Glyph> m_glyphs;
+    std::vector<uint32_t> m_kernKeys;  // (left << 16) | right, sorted
+    std::vector<int8_t> m_kernAdjust;
+
+    std::vector<uint8_t> m_preloaded;
+
+    size_t m_cacheLimit;
+    std::map<uint16_t, std::vector<uint8_t>> m_cache;
+    CacheStats m_cacheStats;
+};
+
+#endif  // BITMAP_FONT_H
@@ -5,6 +5,7 @@
 #include <cstdlib>
 
 #include "config_manager.h"
+#include "infra/log_sink.h"
 
 #ifndef UNIT_TEST
 #include "finger_sensor.h"
@@ -72,6 +73,57 @@ void CliCommandRouter::handleCommand(String cmd) {
         return;
     }
 
+    if (cmd == "mem" || cmd == "memory") {
+        if (m_deps.memoryReporter) {
+            m_deps.memoryReporter(*m_deps.printer);
+        } else {
+            m_deps.printer->println(">>> ERROR: Memory monitor unavailable\n");
+        }
+        return;
+    }
+
+    if (cmd == "perf" || cmd == "perf reset") {
+        if (!m_deps.loopProfileReporter) {
+            m_deps.printer->println(">>> ERROR: Loop profiler unavailable\n");
+            return;
+        }
+        if (cmd == "perf reset") {
+            if (m_deps.loopProfileReset) {
+                m_deps.loopProfileReset();
+            }
+            m_deps.printer->println(">>> Loop profile reset\n");
+            return;
+        }
+        m_deps.loopProfileReporter(*m_deps.printer);
+        return;
+    }
+
+    if (cmd == "audiostats" || cmd == "audiostats reset") {
+        if (!m_deps.audioStatsReporter) {
+            m_deps.printer->println(">>> ERROR: Audio player unavailable\n");
+            return;
+        }
+        if (cmd == "audiostats reset") {
+            if (m_deps.audioStatsReset) {
+                m_deps.audioStatsReset();
+            }
+            m_deps.printer->println(">>> Audio stats reset\n");
+            return;
+        }
+        m_deps.audioStatsReporter(*m_deps.printer);
+        return;
+    }
+
+    if (cmd == "loglevel" || cmd.indexOf("loglevel ") == 0) {
+        String args = cmd.substring(strlen("loglevel"));
+        args.trim();
+        infra::runLogLevelCommand(args.c_str(), [this](const char *line) {
+            m_deps.printer->printf(">>> %s\n", line);
+        });
+        m_deps.printer->println();
+        return;
+    }
+
     if (cmd == "ptest") {
         auto *printerDevice = thermalPrinter();
         if (!printerDevice) {
@@ -99,6 +151,8 @@ void CliCommandRouter::handleCommand(String cmd) {
         m_deps.printer->println("\n=== PRINTER STATUS ===");
         m_deps.printer->printf("Ready:      %s\n", printerDevice->isReady() ? "YES" : "NO");
         m_deps.printer->printf("Printing:   %s\n", printerDevice->isPrinting() ? "YES" : "NO");
+        m_deps.printer->printf("Queued:     %u\n", static_cast<unsigned>(printerDevice->queuedJobCount()));
+        m_deps.printer->printf("Paper low:  %s\n", printerDevice->isPaperLow() ? "YES" : "NO");
         m_deps.printer->printf("Error flag: %s\n\n", printerDevice->hasError() ? "YES" : "NO");
         return;
     }
@@ -118,6 +172,10 @@ void CliCommandRouter::printHelp() {
     m_deps.printer->println("\n=== CLI COMMANDS ===");
     m_deps.printer->println("help | ?           - Show this help message");
     m_deps.printer->println("fhelp | f?        - Finger sensor help");
+    m_deps.printer->println("mem               - Heap and allocation stats");
+    m_deps.printer->println("perf [reset]      - Loop stage timing (min/avg/p99/max)");
+    m_deps.printer->println("audiostats [reset] - Audio underruns, buffer fill, SD latency");
+    m_deps.printer->println("loglevel [tag] [level] - Show/set log filters (verbose..error, off)");
     m_deps.printer->println();
 }
 
@@ -133,6 +191,11 @@ void CliCommandRouter::printFingerHelp() {
     m_deps.printer->println("falpha <0-1>       - Set smoothing alpha");
     m_deps.printer->println("fdrift <0-0.1>     - Set baseline drift factor");
     m_deps.printer->println("fmultisample <N>   - Set sample averaging count");
+    m_deps.printer->println("fdetect [name]     - Get/Set detector (threshold, cusum, ph)");
+    m_deps.printer->println("ffilter <med> <hampel> - Set prefilter windows (odd, 1/0 = off)");
+    m_deps.printer->println("ftrace start [path] - Capture samples to SD (default /touch_trace.bin)");
+    m_deps.printer->println("ftrace touch|idle|none - Label the samples that follow");
+    m_deps.printer->println("ftrace stop        - Finish the capture");
     m_deps.printer->println();
 }
 
@@ -352,6 +415,110 @@ bool CliCommandRouter::handleFingerCommand(String &cmd) {
         return true;
     }
 
+    if (cmd == "fdetect" || cmd.indexOf("fdetect ") == 0) {
+        if (!sensor) {
+            return missingSensor();
+        }
+        String name = cmd.substring(strlen("fdetect"));
+        name.trim();
+        if (name.length() == 0) {
+            const TouchDetector::Config &config = sensor->getDetectorConfig();
+            m_deps.printer->printf(">>> Detector: %s (median %u, hampel %u)\n\n",
+                                   TouchDetector::algorithmName(config.algorithm),
+                                   config.medianWindow,
+                                   config.hampelWindow);
+            return true;
+        }
+        TouchDetector::Algorithm algorithm;
+        if (!TouchDetector::parseAlgorithm(name.c_str(), algorithm)) {
+            m_deps.printer->println(">>> ERROR: Detector must be threshold, cusum or ph\n");
+            return true;
+        }
+        sensor->setDetectionAlgorithm(algorithm);
+        m_deps.printer->printf(">>> Detector set to %s\n\n", TouchDetector::algorithmName(algorithm));
+        return true;
+    }
+
+    if (cmd == "ftrace" || cmd.indexOf("ftrace ") == 0) {
+        if (!sensor) {
+            return missingSensor();
+        }
+        String args = cmd.substring(strlen("ftrace"));
+        args.trim();
+        if (args.length() == 0) {
+            if (sensor->isTracing()) {
+                const TouchTraceWriter::Stats stats = sensor->getTraceStats();
+                m_deps.printer->printf(">>> Trace running: %u samples, %u dropped, label %s\n\n",
+                                       stats.records,
+                                       stats.droppedRecords,
+                                       TouchTraceWriter::labelName(sensor->getTraceLabel()));
+            } else {
+                m_deps.printer->println(">>> No trace running. Use ftrace start [path]\n");
+            }
+            return true;
+        }
+        if (args == "start" || args.indexOf("start ") == 0) {
+            String path = args.substring(strlen("start"));
+            path.trim();
+            if (path.length() == 0) {
+                path = "/touch_trace.bin";
+            }
+            if (sensor->startTrace(path.c_str())) {
+                m_deps.printer->printf(">>> Capturing touch trace to %s\n\n", path.c_str());
+            } else {
+                m_deps.printer->println(">>> ERROR: Could not open trace file\n");
+            }
+            return true;
+        }
+        if (args == "stop") {
+            const bool wasTracing = sensor->isTracing();
+            if (sensor->stopTrace()) {
+                m_deps.printer->printf(">>> Trace saved (%u samples)\n\n", sensor->getTraceStats().records);
+            } else if (wasTracing) {
+                m_deps.printer->println(">>> ERROR: Trace write failed; file is incomplete\n");
+            } else {
+                m_deps.printer->println(">>> No trace running\n");
+            }
+            return true;
+        }
+        TouchLabel label;
+        if (args == "touch") {
+            label = TouchLabel::Touch;
+        } else if (args == "idle") {
+            label = TouchLabel::Idle;
+        } else if (args == "none") {
+            label = TouchLabel::None;
+        } else {
+            m_deps.printer->println(">>> ERROR: Usage ftrace [start [path] | stop | touch | idle | none]\n");
+            return true;
+        }
+        sensor->setTraceLabel(label);
+        m_deps.printer->printf(">>> Trace label: %s\n\n", TouchTraceWriter::labelName(label));
+        return true;
+    }
+
+    if (cmd.indexOf("ffilter ") == 0) {
+        if (!sensor) {
+            return missingSensor();
+        }
+        String args = cmd.substring(strlen("ffilter"));
+        args.trim();
+        int spaceIdx = args.indexOf(' ');
+        if (spaceIdx <= 0) {
+            m_deps.printer->println(">>> ERROR: Usage ffilter <median> <hampel>\n");
+            return true;
+        }
+        int median = args.substring(0, spaceIdx).toInt();
+        int hampel = args.substring(spaceIdx + 1).toInt();
+        if (median >= 1 && hampel >= 0 &&
+            sensor->setPrefilterWindows(static_cast<uint8_t>(median), static_cast<uint8_t>(hampel))) {
+            m_deps.printer->printf(">>> Prefilters set: median=%d hampel=%d\n\n", median, hampel);
+        } else {
+            m_deps.printer->println(">>> ERROR: Windows must be median 1-15, hampel 0-15\n");
+        }
+        return true;
+    }
+
     return false;
 }
 
@@ -399,7 +566,7 @@ bool CliCommandRouter::handleServoCommand(String &cmd) {
                 int minUs = servo->getMinMicroseconds();
                 m_deps.printer->printf(">>> Moving to MIN: %d° (%d µs)\n", minDeg, minUs);
                 servo->smoothMove(minDeg, 500);
-                m_deps.printer->printf(">>> Servo moved to MIN: %d degrees (%d µs)\n\n", minDeg, minUs);
+                m_deps.printer->printf(">>> Servo move to MIN queued: %d degrees (%d µs)\n\n", minDeg, minUs);
             } else {
                 servoNotInitialized();
             }
@@ -436,7 +603,7 @@ bool CliCommandRouter::handleServoCommand(String &cmd) {
                 int maxUs = servo->getMaxMicroseconds();
                 m_deps.printer->printf(">>> Moving to MAX: %d° (%d µs)\n", maxDeg, maxUs);
                 servo->smoothMove(maxDeg, 500);
-                m_deps.printer->printf(">>> Servo moved to MAX: %d degrees (%d µs)\n\n", maxDeg, maxUs);
+                m_deps.printer->printf(">>> Servo move to MAX queued: %d degrees (%d µs)\n\n", maxDeg, maxUs);
             } else {
                 servoNotInitialized();
             }
@@ -33,6 +33,11 @@ public:
         ThermalPrinter *thermalPrinter = nullptr;
         std::function<void()> configPrinter;
         std::function<void(IPrinter &)> sdInfoPrinter;
+        std::function<void(IPrinter &)> memoryReporter;
+        std::function<void(IPrinter &)> loopProfileReporter;
+        std::function<void()> loopProfileReset;
+        std::function<void(IPrinter &)> audioStatsReporter;
+        std::function<void()> audioStatsReset;
         std::function<void(String)> legacyHandler;
     };
 
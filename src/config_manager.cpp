@@ -1,16 +1,20 @@
 #include "config_manager.h"
 #include "infra/filesystem.h"
 #include "infra/log_sink.h"
+#include "touch_detector.h"
+#include <algorithm>
+#include <cctype>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #ifndef UNIT_TEST
 #include "infra/sd_mmc_filesystem.h"
-#include "logging_manager.h"
 #include "SD_MMC.h"
 #endif
 
 ConfigManager::ConfigManager()
-    : m_fileSystem(nullptr),
+    : m_arena(512, infra::ArenaMemory::PreferPsram),
+      m_fileSystem(nullptr),
       m_logSink(nullptr)
 {
 }
@@ -58,36 +62,35 @@ bool ConfigManager::loadConfig()
     }
 
     m_config.clear();
+    m_arena.clear();
+    // Capped so a huge file cannot demand one giant block; the rest grows on demand
+    m_arena.reserve(std::min<size_t>(configFile->size(), ARENA_RESERVE_BYTES));
 
     log(infra::LogLevel::Info, "📄 Reading configuration file:");
-    while (configFile->available())
+    bool parsed = true;
+    while (parsed && configFile->available())
     {
         String line = configFile->readStringUntil('\n');
         line.trim();
         if (line.length() > 0 && line[0] != '#')
         {
-            parseConfigLine(line);
-            // Output the key-value pair
-            int separatorIndex = line.indexOf('=');
-            if (separatorIndex != -1)
-            {
-                String key = line.substring(0, separatorIndex);
-                String value = line.substring(separatorIndex + 1);
-                key.trim();
-                value.trim();
-
-                String loggedValue = value;
-                if (key.equalsIgnoreCase("wifi_password") || key.equalsIgnoreCase("ota_password"))
-                {
-                    loggedValue = value.length() > 0 ? "[SET]" : "[NOT SET]";
-                }
-
-                log(infra::LogLevel::Debug, "  %s: %s", key.c_str(), loggedValue.c_str());
-            }
+            parsed = parseConfigLine(line);
         }
     }
 
     configFile->close();
+    if (!parsed)
+    {
+        // Drop the partial config so every getter falls back to its default
+        log(infra::LogLevel::Error, "Config file does not fit in memory (%u bytes stored); using defaults",
+            static_cast<unsigned>(m_arena.stats().bytesUsed));
+        m_config.clear();
+        m_config.shrink_to_fit();
+        m_arena.clear();
+        speakerVolume = 100;
+        return false;
+    }
+    m_arena.releaseIndex();
 
     // Validate speaker volume
     speakerVolume = getValue("speaker_volume", "100").toInt();
@@ -166,6 +169,19 @@ bool ConfigManager::loadConfig()
         log(infra::LogLevel::Warn, "Mouth LED pulse period out of range (200-10000 ms). Getter will return default.");
     }
 
+    int ledPwmBits = getValue("led_pwm_bits", "12").toInt();
+    if (ledPwmBits < 8 || ledPwmBits > 16)
+    {
+        log(infra::LogLevel::Warn, "LED PWM resolution out of range (8-16 bits). Getter will return default.");
+    }
+
+    int ledAudioAttack = getValue("led_audio_attack_ms", "20").toInt();
+    int ledAudioRelease = getValue("led_audio_release_ms", "250").toInt();
+    if (ledAudioAttack < 0 || ledAudioAttack > 1000 || ledAudioRelease < 0 || ledAudioRelease > 5000)
+    {
+        log(infra::LogLevel::Warn, "LED audio attack/release out of range (0-1000 / 0-5000 ms). Getters will return defaults.");
+    }
+
     // Validate finger tuning parameters
     uint32_t fingerCyclesInit = strtoul(getValue("finger_cycles_init", "0x1000").c_str(), nullptr, 0);
     uint32_t fingerCyclesMeasure = strtoul(getValue("finger_cycles_measure", "0x1000").c_str(), nullptr, 0);
@@ -193,6 +209,20 @@ bool ConfigManager::loadConfig()
         log(infra::LogLevel::Warn, "Finger multisample count invalid (1-255). Getter will use default.");
     }
 
+    TouchDetector::Algorithm fingerDetector;
+    if (!TouchDetector::parseAlgorithm(getValue("finger_detector", "threshold").c_str(), fingerDetector))
+    {
+        log(infra::LogLevel::Warn, "Finger detector unknown (threshold, cusum, page-hinkley). Getter will use default.");
+    }
+
+    int fingerMedian = getValue("finger_median_window", "1").toInt();
+    int fingerHampel = getValue("finger_hampel_window", "0").toInt();
+    if (fingerMedian < 1 || fingerMedian > TouchDetector::MAX_WINDOW ||
+        fingerHampel < 0 || fingerHampel > TouchDetector::MAX_WINDOW)
+    {
+        log(infra::LogLevel::Warn, "Finger prefilter windows out of range (median 1-15, hampel 0-15). Getters will use defaults.");
+    }
+
     // Validate printer baud rate
     int printerBaud = getValue("printer_baud", "9600").toInt();
     if (printerBaud < 1200 || printerBaud > 115200)
@@ -203,49 +233,69 @@ bool ConfigManager::loadConfig()
     return true;
 }
 
-void ConfigManager::parseConfigLine(const String &line)
+bool ConfigManager::parseConfigLine(const String &line)
 {
     int separatorIndex = line.indexOf('=');
-    if (separatorIndex != -1)
+    if (separatorIndex == -1)
+    {
+        return true;
+    }
+
+    // Trim both halves in place and intern them straight from the line
+    const char *text = line.c_str();
+    size_t keyEnd = static_cast<size_t>(separatorIndex);
+    while (keyEnd > 0 && isspace(static_cast<unsigned char>(text[keyEnd - 1])))
     {
-        String key = line.substring(0, separatorIndex);
-        String value = line.substring(separatorIndex + 1);
-        key.trim();
-        value.trim();
-        m_config[key] = value;
+        --keyEnd;
     }
+    size_t valueStart = static_cast<size_t>(separatorIndex) + 1;
+    size_t valueEnd = line.length();
+    while (valueStart < valueEnd && isspace(static_cast<unsigned char>(text[valueStart])))
+    {
+        ++valueStart;
+    }
+    const char *key = m_arena.intern(text, keyEnd);
+    const char *value = m_arena.intern(text + valueStart, valueEnd - valueStart);
+    if (!key || !value)
+    {
+        return false;
+    }
+
+    auto it = std::lower_bound(m_config.begin(), m_config.end(), key,
+                               [](const ConfigEntry &entry, const char *name) { return strcmp(entry.key, name) < 0; });
+    if (it != m_config.end() && strcmp(it->key, key) == 0)
+    {
+        it->value = value;
+    }
+    else
+    {
+        m_config.insert(it, ConfigEntry{key, value});
+    }
+
+    const bool secret = strcasecmp(key, "wifi_password") == 0 || strcasecmp(key, "ota_password") == 0;
+    log(infra::LogLevel::Debug, "  %s: %s", key, secret ? (*value ? "[SET]" : "[NOT SET]") : value);
+    return true;
+}
+
+const char *ConfigManager::findValue(const char *key) const
+{
+    auto it = std::lower_bound(m_config.begin(), m_config.end(), key,
+                               [](const ConfigEntry &entry, const char *name) { return strcmp(entry.key, name) < 0; });
+    return (it != m_config.end() && strcmp(it->key, key) == 0) ? it->value : nullptr;
 }
 
 void ConfigManager::log(infra::LogLevel level, const char *fmt, ...) const
 {
-    char buffer[256]{0};
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    infra::logToSinkOrRing(m_logSink, level, TAG, fmt, args);
     va_end(args);
-
-    if (m_logSink) {
-        m_logSink->log(level, TAG, buffer);
-        return;
-    }
-
-    if (infra::ILogSink *sink = infra::getLogSink()) {
-        sink->log(level, TAG, buffer);
-        return;
-    }
-
-#ifndef UNIT_TEST
-    LoggingManager::instance().log(static_cast<::LogLevel>(level), TAG, "%s", buffer);
-#else
-    (void)level;
-    (void)buffer;
-#endif
 }
 
 String ConfigManager::getValue(const String &key, const String &defaultValue) const
 {
-    auto it = m_config.find(key);
-    return (it != m_config.end()) ? it->second : defaultValue;
+    const char *value = findValue(key.c_str());
+    return value ? String(value) : defaultValue;
 }
 
 String ConfigManager::getBluetoothSpeakerName() const
@@ -271,9 +321,9 @@ int ConfigManager::getServoMaxDegrees() const
 
 void ConfigManager::printConfig() const
 {
-    for (const auto &pair : m_config)
+    for (const auto &entry : m_config)
     {
-        log(infra::LogLevel::Info, "%s: %s", pair.first.c_str(), pair.second.c_str());
+        log(infra::LogLevel::Info, "%s: %s", entry.key, entry.value);
     }
     log(infra::LogLevel::Info, "Speaker Volume: %d", speakerVolume);
 }
@@ -388,6 +438,34 @@ uint8_t ConfigManager::getFingerMultisample() const
     return static_cast<uint8_t>(value);
 }
 
+String ConfigManager::getFingerDetector() const
+{
+    String value = getValue("finger_detector", "threshold");
+    TouchDetector::Algorithm algorithm;
+    if (!TouchDetector::parseAlgorithm(value.c_str(), algorithm)) {
+        return "threshold";
+    }
+    return value;
+}
+
+uint8_t ConfigManager::getFingerMedianWindow() const
+{
+    int value = getValue("finger_median_window", "1").toInt();
+    if (value < 1 || value > TouchDetector::MAX_WINDOW) {
+        return 1;
+    }
+    return static_cast<uint8_t>(value);
+}
+
+uint8_t ConfigManager::getFingerHampelWindow() const
+{
+    int value = getValue("finger_hampel_window", "0").toInt();
+    if (value < 0 || value > TouchDetector::MAX_WINDOW) {
+        return 0;
+    }
+    return static_cast<uint8_t>(value);
+}
+
 unsigned long ConfigManager::getFingerDetectMs() const
 {
     unsigned long value = getValue("finger_detect_ms", "120").toInt();
@@ -454,6 +532,12 @@ String ConfigManager::getFortunesJson() const
     return getValue("fortunes_json", "/printer/fortunes_littlekid.json");
 }
 
+String ConfigManager::getPrinterFont() const
+{
+    // Empty keeps the printer's built-in font
+    return getValue("printer_font", "");
+}
+
 uint8_t ConfigManager::getMouthLedBright() const
 {
     int value = getValue("mouth_led_bright", "255").toInt();
@@ -480,3 +564,37 @@ unsigned long ConfigManager::getMouthLedPulsePeriodMs() const
     }
     return value;
 }
+
+uint8_t ConfigManager::getLedPwmBits() const
+{
+    int value = getValue("led_pwm_bits", "12").toInt();
+    if (value < 8 || value > 16) {
+        return 12;
+    }
+    return static_cast<uint8_t>(value);
+}
+
+bool ConfigManager::getLedGamma() const
+{
+    // Default: true (levels follow perceived brightness)
+    String value = getValue("led_gamma", "true");
+    return !(value.equalsIgnoreCase("false") || value == "0");
+}
+
+uint32_t ConfigManager::getLedAudioAttackMs() const
+{
+    int value = getValue("led_audio_attack_ms", "20").toInt();
+    if (value < 0 || value > 1000) {
+        return 20;
+    }
+    return static_cast<uint32_t>(value);
+}
+
+uint32_t ConfigManager::getLedAudioReleaseMs() const
+{
+    int value = getValue("led_audio_release_ms", "250").toInt();
+    if (value < 0 || value > 5000) {
+        return 250;
+    }
+    return static_cast<uint32_t>(value);
+}
@@ -3,7 +3,8 @@
 
 #include <Arduino.h>
 #include <FS.h>
-#include <map>
+#include <vector>
+#include "infra/string_arena.h"
 
 namespace infra {
 class IFileSystem;
@@ -48,6 +49,9 @@ public:
     float getFingerFilterAlpha() const;
     float getFingerBaselineDrift() const;
     uint8_t getFingerMultisample() const;
+    String getFingerDetector() const;
+    uint8_t getFingerMedianWindow() const;
+    uint8_t getFingerHampelWindow() const;
 
     // Timing configuration
     unsigned long getFingerDetectMs() const;
@@ -60,21 +64,37 @@ public:
     int getPrinterBaud() const;
     String getPrinterLogo() const;
     String getFortunesJson() const;
+    String getPrinterFont() const;
 
     // Mouth LED configuration
     uint8_t getMouthLedBright() const;
     uint8_t getMouthLedPulseMin() const;
     uint8_t getMouthLedPulseMax() const;
     unsigned long getMouthLedPulsePeriodMs() const;
+    uint8_t getLedPwmBits() const;
+    bool getLedGamma() const;
+    uint32_t getLedAudioAttackMs() const;
+    uint32_t getLedAudioReleaseMs() const;
 
 private:
+    // Keys and values are interned in m_arena; entries stay sorted by key
+    struct ConfigEntry {
+        const char *key;
+        const char *value;
+    };
+
+    // First arena block; a typical config.txt fits in it
+    static constexpr size_t ARENA_RESERVE_BYTES = 2048;
+
     ConfigManager();
-    std::map<String, String> m_config;
+    infra::StringArena m_arena;
+    std::vector<ConfigEntry> m_config;
     int speakerVolume;
     int m_servoMinDegrees;
     int m_servoMaxDegrees;
 
-    void parseConfigLine(const String& line);
+    bool parseConfigLine(const String& line);
+    const char *findValue(const char *key) const;
     void log(infra::LogLevel level, const char *fmt, ...) const;
 
     infra::IFileSystem *m_fileSystem;
@@ -283,14 +283,14 @@ void DeathController::update(uint32_t nowMs, const FingerReadout &finger) {
                 m_manualHoldActive = true;
                 m_manualHoldStartMs = nowMs;
                 m_manualHoldSatisfied = false;
-                infra::emitLog(infra::LogLevel::Debug, kTag,
-                               "Manual calibration hold started (delta=%.4f threshold=%.4f)",
-                               finger.normalizedDelta,
-                               threshold);
+                INFRA_LOG(infra::LogLevel::Debug, kTag,
+                          "Manual calibration hold started (delta=%.4f threshold=%.4f)",
+                          finger.normalizedDelta,
+                          threshold);
             } else if (!m_manualHoldSatisfied && nowMs - m_manualHoldStartMs >= kManualCalibrationHoldMs) {
                 m_manualHoldSatisfied = true;
-                infra::emitLog(infra::LogLevel::Debug, kTag,
-                               "Manual calibration hold satisfied after %lu ms", static_cast<unsigned long>(nowMs - m_manualHoldStartMs));
+                INFRA_LOG(infra::LogLevel::Debug, kTag,
+                          "Manual calibration hold satisfied after %lu ms", static_cast<unsigned long>(nowMs - m_manualHoldStartMs));
                 transitionTo(State::ManualCalibration, "Manual calibration requested");
                 return;
             }
@@ -75,6 +75,7 @@ bool FortuneServiceAdapter::ensureLoaded(const std::string &path) {
     bool loaded = m_generator.loadFortunes(String(path.c_str()));
     if (loaded) {
         m_loadedPath = path;
+        m_prefetched.clear();
     } else {
         infra::emitLog(infra::LogLevel::Warn, kTag,
                        "Failed to load fortunes from %s", path.c_str());
@@ -83,16 +84,35 @@ bool FortuneServiceAdapter::ensureLoaded(const std::string &path) {
 }
 
 std::string FortuneServiceAdapter::generateFortune() {
+    if (!m_prefetched.empty()) {
+        std::string fortune;
+        fortune.swap(m_prefetched);
+        return fortune;
+    }
     String fortune = m_generator.generateFortune();
     return std::string(fortune.c_str());
 }
 
+bool FortuneServiceAdapter::prefetch() {
+    if (!m_prefetched.empty()) {
+        return true;
+    }
+    if (!m_generator.isLoaded()) {
+        return false;
+    }
+    String fortune = m_generator.generateFortune();
+    m_prefetched = fortune.c_str();
+    return !m_prefetched.empty();
+}
+
 PrinterStatusAdapter::PrinterStatusAdapter(ThermalPrinter &printer)
     : m_printer(printer) {
 }
 
 bool PrinterStatusAdapter::isReady() const {
-    return m_printer.isReady();
+    // Skip the print when the printer reports a fault; jobs already queued
+    // wait for it to recover
+    return m_printer.canAcceptJob();
 }
 
 ManualCalibrationAdapter::ManualCalibrationAdapter(LightController &lights, FingerSensor &sensor, ConfigManager &config)
@@ -38,9 +38,15 @@ public:
     bool ensureLoaded(const std::string &path) override;
     std::string generateFortune() override;
 
+    // Generates the next fortune ahead of time; generateFortune() hands it out
+    // first. Returns false until templates are loaded.
+    bool prefetch();
+    const std::string &prefetched() const { return m_prefetched; }
+
 private:
     FortuneGenerator &m_generator;
     std::string m_loadedPath;
+    std::string m_prefetched;
 };
 
 class PrinterStatusAdapter : public DeathController::IPrinterStatus {
@@ -0,0 +1,120 @@
+#include "escpos_stream.h"
+
+namespace {
+constexpr size_t RASTER_HEADER_BYTES = 8;  // GS v 0 m xL xH yL yH
+}  // namespace
+
+uint32_t PrintStream::totalDotLines() const {
+    uint32_t total = 0;
+    for (const auto &entry : marks) {
+        total += entry.dotLines;
+    }
+    return total;
+}
+
+EscPosWriter::EscPosWriter(PrintStream &stream)
+    : m_stream(stream),
+      m_lineSpacing(DEFAULT_LINE_SPACING_DOTS) {
+}
+
+void EscPosWriter::initialize() {
+    put(0x1B);
+    put('@');
+    m_lineSpacing = DEFAULT_LINE_SPACING_DOTS;
+    setDefaultLineSpacing();
+    setJustification(0);
+}
+
+void EscPosWriter::setJustification(uint8_t mode) {
+    put(0x1B);
+    put('a');
+    put(mode > 2 ? 0 : mode);
+}
+
+void EscPosWriter::setDefaultLineSpacing() {
+    put(0x1B);
+    put('2');
+    m_lineSpacing = DEFAULT_LINE_SPACING_DOTS;
+}
+
+void EscPosWriter::setLineSpacing(uint8_t dots) {
+    put(0x1B);
+    put('3');
+    put(dots);
+    m_lineSpacing = dots;
+}
+
+void EscPosWriter::text(const char *data, size_t length) {
+    if (!data) {
+        return;
+    }
+    m_stream.bytes.insert(m_stream.bytes.end(),
+                          reinterpret_cast<const uint8_t *>(data),
+                          reinterpret_cast<const uint8_t *>(data) + length);
+}
+
+void EscPosWriter::textLine(const char *data, size_t length) {
+    text(data, length);
+    newline();
+}
+
+void EscPosWriter::newline() {
+    put('\n');
+    mark(m_lineSpacing);
+}
+
+void EscPosWriter::feed(uint8_t lines) {
+    for (uint8_t i = 0; i < lines; ++i) {
+        newline();
+    }
+}
+
+void EscPosWriter::feedDots(uint8_t dots) {
+    if (dots == 0) {
+        return;
+    }
+    put(0x1B);
+    put('J');
+    put(dots);
+    mark(dots);
+}
+
+bool EscPosWriter::raster(const uint8_t *block, size_t length) {
+    if (!block || length < RASTER_HEADER_BYTES ||
+        block[0] != 0x1D || block[1] != 'v' || block[2] != '0') {
+        return false;
+    }
+    const size_t rowBytes = static_cast<size_t>(block[4]) | (static_cast<size_t>(block[5]) << 8);
+    const size_t rows = static_cast<size_t>(block[6]) | (static_cast<size_t>(block[7]) << 8);
+    if (rowBytes == 0 || length < RASTER_HEADER_BYTES + rowBytes * rows) {
+        return false;
+    }
+
+    m_stream.bytes.insert(m_stream.bytes.end(), block, block + RASTER_HEADER_BYTES);
+    const uint8_t *row = block + RASTER_HEADER_BYTES;
+    for (size_t i = 0; i < rows; ++i, row += rowBytes) {
+        m_stream.bytes.insert(m_stream.bytes.end(), row, row + rowBytes);
+        mark(1);
+    }
+    return true;
+}
+
+void EscPosWriter::raw(const uint8_t *data, size_t length, uint32_t dotLines) {
+    if (data && length > 0) {
+        m_stream.bytes.insert(m_stream.bytes.end(), data, data + length);
+    }
+    if (dotLines > 0) {
+        mark(dotLines);
+    }
+}
+
+void EscPosWriter::put(uint8_t byte) {
+    m_stream.bytes.push_back(byte);
+}
+
+void EscPosWriter::mark(uint32_t dotLines) {
+    PrintStream::Mark entry;
+    entry.endOffset = m_stream.bytes.size();
+    entry.dotLines = dotLines;
+    m_stream.marks.push_back(entry);
+}
@@ -0,0 +1,63 @@
+#ifndef ESCPOS_STREAM_H
+#define ESCPOS_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * A fully rendered print job: the ESC/POS bytes plus "marks" recording how
+ * many dot lines the head must advance once the bytes up to a given offset
+ * have been received. The spooler uses the marks to model head speed.
+ */
+struct PrintStream {
+    struct Mark {
+        size_t endOffset = 0;
+        uint32_t dotLines = 0;
+    };
+
+    std::vector<uint8_t> bytes;
+    std::vector<Mark> marks;
+
+    void clear() {
+        bytes.clear();
+        marks.clear();
+    }
+    bool empty() const { return bytes.empty(); }
+    uint32_t totalDotLines() const;
+};
+
+// Appends ESC/POS commands to a PrintStream, tracking line spacing so each
+// newline and raster row is charged the right number of dot lines.
+class EscPosWriter {
+public:
+    static constexpr uint8_t DEFAULT_LINE_SPACING_DOTS = 32;
+
+    explicit EscPosWriter(PrintStream &stream);
+
+    void initialize();                   // ESC @, default spacing, left aligned
+    void setJustification(uint8_t mode); // 0=left, 1=center, 2=right
+    void setDefaultLineSpacing();        // ESC 2
+    void setLineSpacing(uint8_t dots);   // ESC 3 n
+    void text(const char *data, size_t length);
+    void textLine(const char *data, size_t length);
+    void newline();
+    void feed(uint8_t lines);
+    void feedDots(uint8_t dots);         // ESC J n
+    // Appends a pre-built GS v 0 block, charging one dot line per raster row.
+    // Returns false (and appends nothing) if the header is malformed.
+    bool raster(const uint8_t *block, size_t length);
+    // Raw bytes with an explicit head cost.
+    void raw(const uint8_t *data, size_t length, uint32_t dotLines);
+
+    uint8_t lineSpacingDots() const { return m_lineSpacing; }
+
+private:
+    void put(uint8_t byte);
+    void mark(uint32_t dotLines);
+
+    PrintStream &m_stream;
+    uint8_t m_lineSpacing;
+};
+
+#endif  // ESCPOS_STREAM_H
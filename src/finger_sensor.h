@@ -3,13 +3,24 @@
 
 #include <Arduino.h>
 #include <Print.h>
+#include <memory>
+
+#include "finger_sensor_core.h"
+#include "infra/arduino_time_provider.h"
+#include "infra/filesystem.h"
+#include "infra/periodic_timer.h"
+#include "touch_detector.h"
+#include "touch_sampler.h"
+#include "touch_trace.h"
 
 class FingerSensor {
 public:
     explicit FingerSensor(int pin);
+    ~FingerSensor();
 
     void begin();
-    void update();
+    // sdBusAvailable gates touch trace writes (AudioPlayer::hasSdHeadroom())
+    void update(bool sdBusAvailable = true);
     void calibrate();
 
     bool isFingerDetected() const;      // Immediate threshold detection
@@ -37,70 +48,54 @@ public:
     bool setFilterAlpha(float alpha);
     bool setBaselineDrift(float drift);
     bool setMultisampleCount(uint8_t count);
+    void setDetectionAlgorithm(TouchDetector::Algorithm algorithm);
+    bool setPrefilterWindows(uint8_t medianWindow, uint8_t hampelWindow);
+    const TouchDetector::Config &getDetectorConfig() const;
+
+    // Binary capture of every sample for offline tuning (see touch_trace.h)
+    void setFileSystem(infra::IFileSystem *fileSystem);
+    bool startTrace(const char *path);
+    bool stopTrace();
+    bool isTracing() const;
+    void setTraceLabel(TouchLabel label);
+    TouchLabel getTraceLabel() const;
+    TouchTraceWriter::Stats getTraceStats() const;
 
     void printStatus(Print &out) const;
     void printSettings(Print &out) const;
 
 private:
-    void startCalibration(bool logMessage);
-    void performCalibration();
-    void updateDetection(unsigned long currentTime, float normalizedDelta, bool currentlyDetected);
+    void processSample(unsigned long sampleTime, float sample);
+    bool startSampler();
+    static uint32_t readTouchRaw(void *context);
     void printStreamSample();
+    infra::IFileSystem *fileSystem();
 
     int m_pin;
 
-    float m_thresholdRatio;          // Normalized delta threshold (e.g., 0.002 = 0.2 %)
-    unsigned long m_stableDurationMs;
-
-    float m_rawValue;
-    float m_lastRawSample;
-    float m_lastAverageSample;
-    float m_baseline;
-    float m_filtered;
-    float m_normalizedDelta;
-    float m_noiseAbsolute;
-    float m_noiseNormalized;
-    float m_sensitivity;
-    float m_manualMinThreshold;
-
-    bool m_isCalibrated;
-    bool m_isCalibrating;
-    unsigned long m_calibrationStartMs;
-    uint16_t m_calibrationSamples;
-    double m_calibrationSum;
-    float m_calibrationMinSample;
-    float m_calibrationMaxSample;
-    unsigned long m_detectionEnableTime;
-    bool m_isSettling;
-    unsigned long m_settleEndTime;
-
-    bool m_touchActive;
-    bool m_stableTouch;
-    unsigned long m_detectionStartMs;
+    // Touch readings come from a background task; update() only drains them
+    infra::ArduinoTimeProvider m_clock;
+    std::unique_ptr<infra::IPeriodicTimer> m_samplerTask;
+    TouchSampler m_sampler;
+
+    // Calibration, thresholds and the touch decision
+    FingerSensorCore m_core;
+
+    infra::IFileSystem *m_fileSystem;
+    TouchTraceWriter m_trace;
+
     unsigned long m_lastUpdateMs;
     bool m_streamEnabled;
     unsigned long m_streamIntervalMs;
     unsigned long m_lastStreamPrintMs;
 
-    static constexpr unsigned long CALIBRATION_TIME_MS = 1000; // Gather samples for 1 s
-    static constexpr unsigned long UPDATE_INTERVAL_MS = 10;    // Update every 10 ms
-    static constexpr unsigned long SETTLE_TIME_MS = 2000;      // Ignore detections while environment settles post-calibration
-    static constexpr float FILTER_ALPHA_DEFAULT = 0.3f;     // Default smoothing coefficient
-    static constexpr float MIN_THRESHOLD_RATIO = 0.0001f;   // 0.01 %
-    static constexpr float MAX_THRESHOLD_RATIO = 0.05f;     // 5 %
-    static constexpr float MIN_SENSITIVITY = 0.0f;
-    static constexpr float MAX_SENSITIVITY = 1.0f;
-    static constexpr float DEFAULT_SENSITIVITY = 0.15f;
-    static constexpr float MIN_NOISE_NORMALIZED = 0.001f;   // 0.1 % default noise floor
+    static constexpr unsigned long UPDATE_INTERVAL_MS = 10;    // Inline fallback: update every 10 ms
+    static constexpr uint32_t SAMPLER_PERIOD_US = 1000;        // One touch reading per RTOS tick
 
     static uint16_t s_touchCyclesInitial;   // touchSetCycles initial
     static uint16_t s_touchCyclesMeasure;   // touchSetCycles measure
-    static float s_filterAlpha;             // exponential smoothing
-    static float s_baselineDrift;           // baseline drift factor
     static uint8_t s_multisampleCount;      // number of samples averaged
 
-    float computeAdaptiveThreshold(float baseline) const;
-    void applyManualThresholdClamp();
     float readTouchAverage() const;
 };
 
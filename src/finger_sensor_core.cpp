@@ -0,0 +1,317 @@
+#include "finger_sensor_core.h"
+
+#include "infra/log_sink.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr const char *TAG = "FingerSensor";
+}
+
+FingerSensorCore::FingerSensorCore()
+    : m_detector(),
+      m_thresholdRatio(0.002f),
+      m_manualMinThreshold(0.0f),
+      m_sensitivity(DEFAULT_SENSITIVITY),
+      m_stableDurationMs(120),
+      m_rawValue(0.0f),
+      m_noiseAbsolute(0.0f),
+      m_noiseNormalized(0.0f),
+      m_isCalibrated(false),
+      m_isCalibrating(false),
+      m_calibrationStartMs(0),
+      m_calibrationSamples(0),
+      m_calibrationSum(0.0),
+      m_calibrationMinSample(std::numeric_limits<float>::max()),
+      m_calibrationMaxSample(std::numeric_limits<float>::lowest()),
+      m_detectionEnableTime(0),
+      m_isSettling(false),
+      m_settleEndTime(0),
+      m_touchActive(false),
+      m_stableTouch(false),
+      m_detectionStartMs(0)
+{
+    TouchDetector::Config config;
+    config.filterAlpha = FILTER_ALPHA_DEFAULT;
+    config.baselineDrift = BASELINE_DRIFT_DEFAULT;
+    m_detector.configure(config);
+    m_detector.setThresholdRatio(m_thresholdRatio);
+}
+
+void FingerSensorCore::startCalibration(uint32_t nowMs, bool logMessage)
+{
+    m_isCalibrated = false;
+    m_isCalibrating = true;
+    m_calibrationStartMs = nowMs;
+    m_calibrationSamples = 0;
+    m_calibrationSum = 0.0;
+    m_calibrationMinSample = std::numeric_limits<float>::max();
+    m_calibrationMaxSample = std::numeric_limits<float>::lowest();
+    m_noiseAbsolute = 0.0f;
+    m_noiseNormalized = 0.0f;
+    m_detectionEnableTime = 0;
+    m_isSettling = false;
+    m_settleEndTime = 0;
+    m_touchActive = false;
+    m_stableTouch = false;
+    m_detectionStartMs = 0;
+
+    if (logMessage) {
+        infra::emitLog(infra::LogLevel::Info, TAG, "Starting finger sensor calibration... keep the mouth clear.");
+    }
+}
+
+void FingerSensorCore::processSample(uint32_t currentTime, float sample)
+{
+    if (!m_isCalibrated) {
+        performCalibration(currentTime, sample);
+        return;
+    }
+
+    m_rawValue = sample;
+
+    // The detector tracks throughout settling but only decides once armed
+    const bool armed = !m_isSettling && (m_detectionEnableTime == 0 || currentTime >= m_detectionEnableTime);
+    const bool currentlyDetected = m_detector.update(sample, armed);
+    const float normalizedDelta = m_detector.normalizedDelta();
+
+    if (m_isSettling) {
+        const float baseline = m_detector.baseline();
+        float baselineReference = baseline > 1.0f ? baseline : 1.0f;
+        if (normalizedDelta > m_noiseNormalized) {
+            m_noiseNormalized = normalizedDelta;
+            m_noiseAbsolute = m_noiseNormalized * baselineReference;
+        }
+        if (currentTime >= m_settleEndTime) {
+            m_isSettling = false;
+            m_noiseAbsolute = m_noiseNormalized * baselineReference;
+            m_thresholdRatio = computeAdaptiveThreshold();
+            applyManualThresholdClamp();
+            m_detectionEnableTime = currentTime;
+            infra::emitLog(infra::LogLevel::Info, TAG,
+                           "Finger sensor settle complete — noise=%.3f%% threshold=%.3f%%",
+                           m_noiseNormalized * 100.0f,
+                           m_thresholdRatio * 100.0f);
+        }
+    }
+
+    updateDetection(currentTime, normalizedDelta, currentlyDetected);
+}
+
+bool FingerSensorCore::setThresholdRatio(float ratio)
+{
+    if (ratio < MIN_THRESHOLD_RATIO || ratio > 1.0f) {
+        return false;
+    }
+    m_manualMinThreshold = ratio;
+    applyManualThresholdClamp();
+    if (m_isCalibrated) {
+        infra::emitLog(infra::LogLevel::Info, TAG, "Minimum threshold clamp set to %.3f%% (effective threshold %.3f%%)",
+                       m_manualMinThreshold * 100.0f,
+                       m_thresholdRatio * 100.0f);
+    } else {
+        infra::emitLog(infra::LogLevel::Info, TAG, "Minimum threshold clamp set to %.3f%% (calibration pending)",
+                       m_manualMinThreshold * 100.0f);
+    }
+    return true;
+}
+
+bool FingerSensorCore::setStableDurationMs(uint32_t durationMs)
+{
+    if (durationMs < 30 || durationMs > 1000) {
+        return false;
+    }
+    m_stableDurationMs = durationMs;
+    infra::emitLog(infra::LogLevel::Info, TAG, "Stable touch duration set to %lums",
+                   static_cast<unsigned long>(m_stableDurationMs));
+    return true;
+}
+
+bool FingerSensorCore::setSensitivity(float sensitivity)
+{
+    if (sensitivity < MIN_SENSITIVITY || sensitivity > MAX_SENSITIVITY) {
+        return false;
+    }
+    m_sensitivity = sensitivity;
+    if (m_isCalibrated) {
+        m_thresholdRatio = computeAdaptiveThreshold();
+        applyManualThresholdClamp();
+        infra::emitLog(infra::LogLevel::Info, TAG,
+                       "Sensitivity set to %.1f%% — adaptive threshold now %.3f%% (noise=%.3f%%)",
+                       m_sensitivity * 100.0f,
+                       m_thresholdRatio * 100.0f,
+                       m_noiseNormalized * 100.0f);
+    } else {
+        infra::emitLog(infra::LogLevel::Info, TAG, "Sensitivity set to %.1f%% (calibration pending)", m_sensitivity * 100.0f);
+    }
+    return true;
+}
+
+bool FingerSensorCore::setFilterAlpha(float alpha)
+{
+    if (alpha < 0.0f || alpha > 1.0f) {
+        return false;
+    }
+    TouchDetector::Config config = m_detector.config();
+    config.filterAlpha = alpha;
+    applyDetectorConfig(config);
+    infra::emitLog(infra::LogLevel::Info, TAG, "Filter alpha set to %.4f", alpha);
+    return true;
+}
+
+bool FingerSensorCore::setBaselineDrift(float drift)
+{
+    if (drift < 0.0f || drift > 0.1f) {
+        return false;
+    }
+    TouchDetector::Config config = m_detector.config();
+    config.baselineDrift = drift;
+    applyDetectorConfig(config);
+    infra::emitLog(infra::LogLevel::Info, TAG, "Baseline drift set to %.6f", drift);
+    return true;
+}
+
+void FingerSensorCore::setDetectionAlgorithm(TouchDetector::Algorithm algorithm)
+{
+    TouchDetector::Config config = m_detector.config();
+    config.algorithm = algorithm;
+    applyDetectorConfig(config);
+    infra::emitLog(infra::LogLevel::Info, TAG, "Touch detector set to %s", TouchDetector::algorithmName(algorithm));
+}
+
+bool FingerSensorCore::setPrefilterWindows(uint8_t medianWindow, uint8_t hampelWindow)
+{
+    if (medianWindow == 0 || medianWindow > TouchDetector::MAX_WINDOW || hampelWindow > TouchDetector::MAX_WINDOW) {
+        return false;
+    }
+    TouchDetector::Config config = m_detector.config();
+    config.medianWindow = medianWindow;
+    config.hampelWindow = hampelWindow;
+    applyDetectorConfig(config);
+    infra::emitLog(infra::LogLevel::Info, TAG, "Touch prefilters set: median=%u hampel=%u",
+                   m_detector.config().medianWindow,
+                   m_detector.config().hampelWindow);
+    return true;
+}
+
+void FingerSensorCore::performCalibration(uint32_t now, float sample)
+{
+    if (!m_isCalibrating) {
+        return;
+    }
+
+    // Samples measured before the calibration request belong to the old setup
+    if (static_cast<int32_t>(now - m_calibrationStartMs) < 0) {
+        return;
+    }
+    uint32_t elapsed = now - m_calibrationStartMs;
+
+    m_calibrationSum += sample;
+    ++m_calibrationSamples;
+    if (sample < m_calibrationMinSample) {
+        m_calibrationMinSample = sample;
+    }
+    if (sample > m_calibrationMaxSample) {
+        m_calibrationMaxSample = sample;
+    }
+
+    if (elapsed < CALIBRATION_TIME_MS) {
+        if (m_calibrationSamples % 25 == 0) {
+            INFRA_LOG(infra::LogLevel::Debug, TAG, "Calibration sampling (%u samples)", m_calibrationSamples);
+        }
+        return;
+    }
+
+    if (m_calibrationSamples == 0) {
+        infra::emitLog(infra::LogLevel::Error, TAG, "Calibration failed — no samples collected.");
+        startCalibration(now, false);
+        return;
+    }
+
+    const float baseline = static_cast<float>(m_calibrationSum / m_calibrationSamples);
+    m_detector.reset(baseline);
+    float baselineReference = baseline > 1.0f ? baseline : 1.0f;
+    float deltaBelow = std::max(0.0f, baseline - m_calibrationMinSample);
+    float deltaAbove = std::max(0.0f, m_calibrationMaxSample - baseline);
+    m_noiseAbsolute = std::max(deltaBelow, deltaAbove);
+    m_noiseNormalized = m_noiseAbsolute / baselineReference;
+    if (m_noiseNormalized < MIN_NOISE_NORMALIZED) {
+        m_noiseNormalized = MIN_NOISE_NORMALIZED;
+        m_noiseAbsolute = m_noiseNormalized * baselineReference;
+    }
+    m_thresholdRatio = computeAdaptiveThreshold();
+    applyManualThresholdClamp();
+    m_isCalibrated = true;
+    m_isCalibrating = false;
+    m_calibrationSamples = 0;
+    m_calibrationSum = 0.0;
+    m_isSettling = true;
+    m_settleEndTime = now + SETTLE_TIME_MS;
+    m_detectionEnableTime = m_settleEndTime;
+
+    infra::emitLog(infra::LogLevel::Info, TAG,
+                   "Finger sensor calibrated — baseline=%.0f noise=%.3f%% sensitivity=%.1f%% threshold=%.3f%% (min clamp=%.3f%%) settling %lums",
+                   baseline,
+                   m_noiseNormalized * 100.0f,
+                   m_sensitivity * 100.0f,
+                   m_thresholdRatio * 100.0f,
+                   m_manualMinThreshold * 100.0f,
+                   static_cast<unsigned long>(SETTLE_TIME_MS));
+}
+
+void FingerSensorCore::updateDetection(uint32_t currentTime, float normalizedDelta, bool currentlyDetected)
+{
+    if (currentlyDetected) {
+        if (!m_touchActive) {
+            m_touchActive = true;
+            m_detectionStartMs = currentTime;
+            infra::emitLog(infra::LogLevel::Info, TAG, "Finger touch detected (Δ=%.3f%%)", normalizedDelta * 100.0f);
+        }
+
+        if (!m_stableTouch && (currentTime - m_detectionStartMs) >= m_stableDurationMs) {
+            m_stableTouch = true;
+            infra::emitLog(infra::LogLevel::Info, TAG, "Finger touch stabilized after %lums",
+                           static_cast<unsigned long>(currentTime - m_detectionStartMs));
+        }
+    } else {
+        if (m_touchActive) {
+            infra::emitLog(infra::LogLevel::Info, TAG, "Finger removed (Δ=%.3f%%)", normalizedDelta * 100.0f);
+        }
+        m_touchActive = false;
+        m_stableTouch = false;
+        m_detectionStartMs = 0;
+    }
+}
+
+void FingerSensorCore::applyDetectorConfig(const TouchDetector::Config &config)
+{
+    // configure() clears the filter windows and any half-accumulated statistic
+    m_detector.configure(config);
+    m_touchActive = false;
+    m_stableTouch = false;
+    m_detectionStartMs = 0;
+}
+
+float FingerSensorCore::computeAdaptiveThreshold() const
+{
+    float noiseNorm = m_noiseNormalized;
+    if (noiseNorm <= 0.0f) {
+        noiseNorm = MIN_THRESHOLD_RATIO;
+    }
+    float adaptive = noiseNorm * (1.0f + m_sensitivity);
+    adaptive = std::max(adaptive, MIN_THRESHOLD_RATIO);
+    adaptive = std::min(adaptive, MAX_THRESHOLD_RATIO);
+    return adaptive;
+}
+
+void FingerSensorCore::applyManualThresholdClamp()
+{
+    if (m_manualMinThreshold > 0.0f) {
+        m_thresholdRatio = std::max(m_thresholdRatio, m_manualMinThreshold);
+    }
+    if (m_thresholdRatio > MAX_THRESHOLD_RATIO) {
+        m_thresholdRatio = MAX_THRESHOLD_RATIO;
+    }
+    m_detector.setThresholdRatio(m_thresholdRatio);
+}
@@ -0,0 +1,95 @@
+#ifndef FINGER_SENSOR_CORE_H
+#define FINGER_SENSOR_CORE_H
+
+#include <stdint.h>
+
+#include "touch_detector.h"
+
+/**
+ * Hardware-free half of FingerSensor: calibration, post-calibration settling,
+ * the noise-adaptive threshold, the TouchDetector pipeline and the
+ * stable-touch debounce. It consumes averaged samples with their measurement
+ * time, so the device feeds it from TouchSampler and the host replays
+ * recorded traces through exactly the same code.
+ */
+class FingerSensorCore {
+public:
+    static constexpr uint32_t CALIBRATION_TIME_MS = 1000;  // Gather samples for 1 s
+    static constexpr uint32_t SETTLE_TIME_MS = 2000;       // Ignore detections while environment settles post-calibration
+    static constexpr float FILTER_ALPHA_DEFAULT = 0.3f;    // Default smoothing coefficient
+    static constexpr float BASELINE_DRIFT_DEFAULT = 0.0001f;
+    static constexpr float MIN_THRESHOLD_RATIO = 0.0001f;  // 0.01 %
+    static constexpr float MAX_THRESHOLD_RATIO = 0.05f;    // 5 %
+    static constexpr float MIN_SENSITIVITY = 0.0f;
+    static constexpr float MAX_SENSITIVITY = 1.0f;
+    static constexpr float DEFAULT_SENSITIVITY = 0.15f;
+    static constexpr float MIN_NOISE_NORMALIZED = 0.001f;  // 0.1 % default noise floor
+
+    FingerSensorCore();
+
+    // Discards the current baseline; samples measured before nowMs are ignored.
+    void startCalibration(uint32_t nowMs, bool logMessage);
+    void processSample(uint32_t sampleTimeMs, float sample);
+
+    bool setThresholdRatio(float ratio);  // Manual minimum clamp on the adaptive threshold
+    bool setStableDurationMs(uint32_t durationMs);
+    bool setSensitivity(float sensitivity);
+    bool setFilterAlpha(float alpha);
+    bool setBaselineDrift(float drift);
+    void setDetectionAlgorithm(TouchDetector::Algorithm algorithm);
+    bool setPrefilterWindows(uint8_t medianWindow, uint8_t hampelWindow);
+
+    bool isCalibrated() const { return m_isCalibrated; }
+    bool isSettling() const { return m_isSettling; }
+    uint32_t settleEndMs() const { return m_settleEndTime; }
+    uint32_t detectionEnableMs() const { return m_detectionEnableTime; }
+    bool isTouchActive() const { return m_touchActive; }
+    bool hasStableTouch() const { return m_stableTouch; }
+
+    float rawValue() const { return m_rawValue; }
+    float baseline() const { return m_detector.baseline(); }
+    float filtered() const { return m_detector.filtered(); }
+    float normalizedDelta() const { return m_detector.normalizedDelta(); }
+    float thresholdRatio() const { return m_thresholdRatio; }
+    float manualMinThreshold() const { return m_manualMinThreshold; }
+    float sensitivity() const { return m_sensitivity; }
+    float noiseNormalized() const { return m_noiseNormalized; }
+    float noiseAbsolute() const { return m_noiseAbsolute; }
+    uint32_t stableDurationMs() const { return m_stableDurationMs; }
+    const TouchDetector &detector() const { return m_detector; }
+
+private:
+    void performCalibration(uint32_t sampleTimeMs, float sample);
+    void updateDetection(uint32_t currentTime, float normalizedDelta, bool currentlyDetected);
+    void applyDetectorConfig(const TouchDetector::Config &config);
+    float computeAdaptiveThreshold() const;
+    void applyManualThresholdClamp();
+
+    TouchDetector m_detector;
+
+    float m_thresholdRatio;  // Normalized delta threshold (e.g., 0.002 = 0.2 %)
+    float m_manualMinThreshold;
+    float m_sensitivity;
+    uint32_t m_stableDurationMs;
+
+    float m_rawValue;
+    float m_noiseAbsolute;
+    float m_noiseNormalized;
+
+    bool m_isCalibrated;
+    bool m_isCalibrating;
+    uint32_t m_calibrationStartMs;
+    uint16_t m_calibrationSamples;
+    double m_calibrationSum;
+    float m_calibrationMinSample;
+    float m_calibrationMaxSample;
+    uint32_t m_detectionEnableTime;
+    bool m_isSettling;
+    uint32_t m_settleEndTime;
+
+    bool m_touchActive;
+    bool m_stableTouch;
+    uint32_t m_detectionStartMs;
+};
+
+#endif  // FINGER_SENSOR_CORE_H
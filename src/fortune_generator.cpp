@@ -1,21 +1,28 @@
 #include "fortune_generator.h"
 #include "infra/filesystem.h"
+#include "infra/alloc_tracker.h"
 #include "infra/random_source.h"
-#include <ArduinoJson.h>
+#include <algorithm>
+#include <cctype>
 #include <cstdarg>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
 #ifndef UNIT_TEST
 #include "infra/sd_mmc_filesystem.h"
 #include "infra/arduino_random_source.h"
-#include "logging_manager.h"
 #include "SD_MMC.h"
 #endif
 #include "infra/log_sink.h"
 
 static constexpr const char* TAG = "FortuneGenerator";
+// Template lengths and segment offsets are 16-bit
+static_assert(FortuneGenerator::MAX_ENTRY_LENGTH <= 0xFFFF, "entry length must fit FortuneTemplate");
 
 FortuneGenerator::FortuneGenerator()
-    : loaded(false),
+    : m_arena(infra::StringArena::DEFAULT_BLOCK_BYTES, infra::ArenaMemory::PreferPsram),
+      loaded(false),
       m_fileSystem(nullptr),
       m_randomSource(nullptr),
       m_logSink(nullptr) {
@@ -35,6 +42,7 @@ void FortuneGenerator::setLogSink(infra::ILogSink *sink) {
 }
 
 bool FortuneGenerator::loadFortunes(const String& filePath) {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Fortune);
     infra::IFileSystem *fs = resolveFileSystem();
     resolveLogSink();
     if (!fs) {
@@ -48,58 +56,67 @@ bool FortuneGenerator::loadFortunes(const String& filePath) {
         return false;
     }
 
-    String jsonString = file->readString();
+    // A failed load leaves the generator empty rather than half-replaced
+    clearLibrary();
+    // Only a hint: if it fails, interning grows the arena block by block
+    m_arena.reserve(std::min<size_t>(file->size(), ARENA_RESERVE_BYTES));
+    infra::IFile *source = file.get();
+    infra::JsonPullParser parser([source](uint8_t *buffer, size_t length) {
+        return source->read(buffer, length);
+    }, MAX_ENTRY_LENGTH);
+    LoadState state;
+    const bool parsed = parseLibrary(parser, state);
     file->close();
-    
-#if defined(__GNUC__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#endif
-    DynamicJsonDocument doc(2048);
-#if defined(__GNUC__)
-#pragma GCC diagnostic pop
-#endif
-    DeserializationError error = deserializeJson(doc, jsonString.c_str());
-
-    if (error) {
-        log(infra::LogLevel::Error, "Failed to parse fortune JSON: %s", error.c_str());
+    if (!parsed && parser.error() && strcmp(parser.error(), "string too long") == 0) {
+        log(infra::LogLevel::Error, "Fortune entry at byte %u is longer than %u bytes",
+            static_cast<unsigned>(parser.offset()), static_cast<unsigned>(MAX_ENTRY_LENGTH));
+        clearLibrary();
+        return false;
+    }
+    if (!parsed) {
+        log(infra::LogLevel::Error, "Failed to parse fortune JSON at byte %u: %s",
+            static_cast<unsigned>(parser.offset()),
+            parser.error() ? parser.error() : "unexpected structure");
+        clearLibrary();
         return false;
     }
 
-    // Parse version
-    if (!doc["version"].is<int>()) {
+    if (!state.hasVersion) {
         log(infra::LogLevel::Error, "Fortune file missing version");
+        clearLibrary();
         return false;
     }
-
-    // Parse templates
-    if (!doc["templates"].is<JsonArray>()) {
+    if (!state.hasTemplates) {
         log(infra::LogLevel::Error, "Fortune file missing or invalid templates");
+        clearLibrary();
         return false;
     }
-    parseTemplates(doc["templates"]);
-
-    // Parse wordlists
-    if (!doc["wordlists"].is<JsonObject>()) {
+    if (!state.hasWordlists) {
         log(infra::LogLevel::Error, "Fortune file missing or invalid wordlists");
+        clearLibrary();
         return false;
     }
-    parseWordlists(doc["wordlists"]);
-    
-    // Validate all templates
-    for (const auto& template_obj : templates) {
-        if (!validateTemplate(template_obj)) {
-            log(infra::LogLevel::Error, "Invalid template: %s", template_obj.template_text.c_str());
-            return false;
-        }
+
+    if (!buildLibrary(state)) {
+        clearLibrary();
+        return false;
     }
 
+    m_arena.releaseIndex();
+    templates.shrink_to_fit();
     loaded = true;
-    log(infra::LogLevel::Info, "Loaded %u fortune templates", static_cast<unsigned>(templates.size()));
+    const auto &arena = m_arena.stats();
+    log(infra::LogLevel::Info, "Loaded %u fortune templates, %u rules (%u strings, %u unique, %u bytes of text)",
+        static_cast<unsigned>(templates.size()),
+        static_cast<unsigned>(m_rules.size()),
+        static_cast<unsigned>(arena.strings),
+        static_cast<unsigned>(arena.uniqueStrings),
+        static_cast<unsigned>(arena.bytesUsed));
     return true;
 }
 
 String FortuneGenerator::generateFortune() {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Fortune);
     resolveLogSink();
     if (!loaded || templates.empty()) {
         log(infra::LogLevel::Warn, "generateFortune called before templates loaded");
@@ -113,152 +130,461 @@ String FortuneGenerator::generateFortune() {
     }
 
     // Select random template
-    int templateIndex = randomSource->nextInt(0, static_cast<int>(templates.size()));
-    const FortuneTemplate &fortuneTemplate = templates[templateIndex];
+    const FortuneTemplate &fortuneTemplate = templates[choose(m_templateChoice, *randomSource)];
 
-    if (fortuneTemplate.tokens.empty()) {
+    if (fortuneTemplate.slotWordlists.empty()) {
         log(infra::LogLevel::Warn, "Template has no tokens; returning literal text");
-        return fortuneTemplate.template_text;
-    }
-
-    std::map<String, String> replacements;
-    for (const auto &token : fortuneTemplate.tokens) {
-        String replacement = getRandomWord(token);
-        replacements[token] = replacement;
+        return fortuneTemplate.text;
     }
 
-    return replaceTokens(fortuneTemplate, replacements);
+    String result;
+    result.reserve(std::min(fortuneTemplate.maxLength, MAX_FORTUNE_LENGTH));
+    expand(fortuneTemplate, *randomSource, result);
+    return result;
 }
 
 bool FortuneGenerator::isLoaded() {
     return loaded;
 }
 
-String FortuneGenerator::replaceTokens(const FortuneTemplate& fortuneTemplate, const std::map<String, String>& replacements) {
-    String result;
-    const String &templateText = fortuneTemplate.template_text;
+void FortuneGenerator::clearLibrary() {
+    loaded = false;
+    templates.clear();
+    m_templateChoice = FortuneChoice();
+    wordlists.clear();
+    m_rules.clear();
+    m_frames.clear();
+    m_picks.clear();
+    m_arena.clear();
+}
 
-    int length = templateText.length();
-    int index = 0;
-    while (index < length) {
-        int tokenStart = templateText.indexOf("{{", index);
-        if (tokenStart == -1) {
-            result += templateText.substring(index);
+bool FortuneGenerator::parseLibrary(infra::JsonPullParser &parser, LoadState &state) {
+    using Token = infra::JsonPullParser::Token;
+    if (parser.next() != Token::BeginObject) {
+        return false;
+    }
+    for (;;) {
+        Token token = parser.next();
+        if (token == Token::EndObject) {
             break;
         }
-
-        result += templateText.substring(index, tokenStart);
-        int tokenEnd = templateText.indexOf("}}", tokenStart + 2);
-        if (tokenEnd == -1) {
-            log(infra::LogLevel::Warn, "Unterminated token in template: %s", templateText.c_str());
-            result += templateText.substring(tokenStart);
-            break;
+        if (token != Token::Key) {
+            return false;
         }
+        const std::string key = parser.text();
+        token = parser.next();
+        if (key == "version") {
+            // Integer versions only, as before
+            state.hasVersion = token == Token::Number &&
+                               parser.text().find_first_of(".eE") == std::string::npos;
+        } else if (key == "templates" && token == Token::BeginArray) {
+            if (!parseTemplates(parser, state)) {
+                return false;
+            }
+            state.hasTemplates = true;
+        } else if (key == "wordlists" && token == Token::BeginObject) {
+            if (!parseWordlists(parser)) {
+                return false;
+            }
+            state.hasWordlists = true;
+        } else if (key == "no_repeat" && token == Token::BeginObject) {
+            if (!parseNoRepeat(parser, state)) {
+                return false;
+            }
+        } else if (!parser.skipValue(token)) {
+            return false;
+        }
+    }
+    return parser.next() == Token::End;
+}
 
-        String token = templateText.substring(tokenStart + 2, tokenEnd);
-        token.trim();
-        auto it = replacements.find(token);
-        if (it != replacements.end()) {
-            result += it->second;
-        } else {
-            log(infra::LogLevel::Warn, "Missing replacement for token '%s'; leaving placeholder", token.c_str());
-            result += "{{" + token + "}}";
+bool FortuneGenerator::parseEntry(infra::JsonPullParser &parser, infra::JsonPullParser::Token token,
+                                  const char *&text, uint32_t &weight) {
+    using Token = infra::JsonPullParser::Token;
+    text = nullptr;
+    weight = 1;
+    if (token == Token::String) {
+        text = m_arena.intern(parser.text().data(), parser.text().size());
+        return text || outOfMemory();
+    }
+    if (token != Token::BeginObject) {
+        // Other entries are ignored
+        return parser.skipValue(token);
+    }
+
+    // {"text": "...", "weight": n}; unknown keys are ignored
+    for (token = parser.next(); token != Token::EndObject; token = parser.next()) {
+        if (token != Token::Key) {
+            return false;
+        }
+        const bool isText = parser.text() == "text";
+        const bool isWeight = parser.text() == "weight";
+        token = parser.next();
+        if (isText && token == Token::String) {
+            text = m_arena.intern(parser.text().data(), parser.text().size());
+            if (!text) {
+                return outOfMemory();
+            }
+        } else if (isWeight && token == Token::Number) {
+            const std::string &number = parser.text();
+            if (number.find_first_not_of("0123456789") != std::string::npos || number.size() > 7 ||
+                strtoul(number.c_str(), nullptr, 10) > MAX_WEIGHT) {
+                log(infra::LogLevel::Error, "Invalid weight %s (expected 0..%u)", number.c_str(),
+                    static_cast<unsigned>(MAX_WEIGHT));
+                return false;
+            }
+            weight = static_cast<uint32_t>(strtoul(number.c_str(), nullptr, 10));
+        } else if (!parser.skipValue(token)) {
+            return false;
         }
-        index = tokenEnd + 2;
     }
+    if (!text) {
+        log(infra::LogLevel::Warn, "Weighted entry without text skipped");
+    }
+    return true;
+}
 
-    return result;
+bool FortuneGenerator::outOfMemory() {
+    log(infra::LogLevel::Error, "Out of memory after %u bytes of fortune text",
+        static_cast<unsigned>(m_arena.stats().bytesUsed));
+    return false;
 }
 
-String FortuneGenerator::getRandomWord(const String& category) {
-    resolveLogSink();
-    if (wordlists.find(category) != wordlists.end() && !wordlists[category].empty()) {
-        infra::IRandomSource *randomSource = resolveRandomSource();
-        if (!randomSource) {
-            log(infra::LogLevel::Error, "Random source unavailable when fetching token '%s'", category.c_str());
-            return wordlists[category].front();
+bool FortuneGenerator::parseTemplates(infra::JsonPullParser &parser, LoadState &state) {
+    using Token = infra::JsonPullParser::Token;
+    for (Token token = parser.next(); token != Token::EndArray; token = parser.next()) {
+        const char *text = nullptr;
+        uint32_t weight = 1;
+        if (!parseEntry(parser, token, text, weight)) {
+            return false;
         }
-        int index = randomSource->nextInt(0, static_cast<int>(wordlists[category].size()));
-        return wordlists[category][index];
+        if (!text) {
+            continue;
+        }
+        FortuneTemplate template_obj;
+        template_obj.text = text;
+        template_obj.length = static_cast<uint16_t>(strlen(text));
+        templates.push_back(std::move(template_obj));
+        state.templateWeights.push_back(weight);
     }
-    log(infra::LogLevel::Warn, "Wordlist missing or empty for token '%s'", category.c_str());
-    return "mystery"; // Fallback word
+    return true;
 }
 
-bool FortuneGenerator::validateTemplate(const FortuneTemplate& fortuneTemplate) {
-    if (fortuneTemplate.tokens.empty()) {
-        log(infra::LogLevel::Warn, "Template has no tokens: %s", fortuneTemplate.template_text.c_str());
+bool FortuneGenerator::parseWordlists(infra::JsonPullParser &parser) {
+    using Token = infra::JsonPullParser::Token;
+    for (;;) {
+        Token token = parser.next();
+        if (token == Token::EndObject) {
+            return true;
+        }
+        if (token != Token::Key) {
+            return false;
+        }
+        FortuneWordlist wordList;
+        wordList.name = m_arena.intern(parser.text().data(), parser.text().size());
+        if (!wordList.name) {
+            return outOfMemory();
+        }
+
+        std::vector<uint32_t> weights;
+        token = parser.next();
+        if (token == Token::BeginArray) {
+            for (token = parser.next(); token != Token::EndArray; token = parser.next()) {
+                const char *text = nullptr;
+                uint32_t weight = 1;
+                if (!parseEntry(parser, token, text, weight)) {
+                    return false;
+                }
+                if (text) {
+                    wordList.words.push_back(text);
+                    weights.push_back(weight);
+                }
+            }
+        } else if (!parser.skipValue(token)) {
+            return false;
+        }
+        wordList.words.shrink_to_fit();
+        if (!weights.empty() && !wordList.choice.table.build(weights)) {
+            log(infra::LogLevel::Warn, "Wordlist '%s' has no pickable words", wordList.name);
+        }
+
+        log(infra::LogLevel::Info, "Loaded %u words for category '%s'",
+            static_cast<unsigned>(wordList.words.size()), wordList.name);
+        const int existing = findWordlist(wordList.name, strlen(wordList.name));
+        if (existing >= 0) {
+            wordlists[existing] = std::move(wordList);
+        } else {
+            wordlists.push_back(std::move(wordList));
+        }
     }
+}
 
-    for (const auto &token : fortuneTemplate.tokens) {
-        if (wordlists.find(token) == wordlists.end() || wordlists[token].empty()) {
-            log(infra::LogLevel::Warn, "Token '%s' has no wordlist or empty wordlist", token.c_str());
+bool FortuneGenerator::parseNoRepeat(infra::JsonPullParser &parser, LoadState &state) {
+    using Token = infra::JsonPullParser::Token;
+    for (Token token = parser.next(); token != Token::EndObject; token = parser.next()) {
+        if (token != Token::Key) {
             return false;
         }
+        std::string name = parser.text();
+        token = parser.next();
+        if (token != Token::Number || parser.text().find_first_not_of("0123456789") != std::string::npos) {
+            log(infra::LogLevel::Warn, "Ignoring no_repeat for '%s': not a count", name.c_str());
+            if (!parser.skipValue(token)) {
+                return false;
+            }
+            continue;
+        }
+        const unsigned long window = strtoul(parser.text().c_str(), nullptr, 10);
+        state.noRepeat.emplace_back(std::move(name), static_cast<uint32_t>(std::min(window, 0xFFFFul)));
     }
-    
     return true;
 }
 
-void FortuneGenerator::parseWordlists(JsonObject wordlistsObj) {
-    wordlists.clear();
-    
-    for (JsonPair pair : wordlistsObj) {
-        String category = pair.key().c_str();
-        JsonArray words = pair.value().as<JsonArray>();
-        
-        std::vector<String> wordList;
-        for (JsonVariant word : words) {
-            const char *value = word.as<const char*>();
-            if (value) {
-                wordList.emplace_back(value);
+bool FortuneGenerator::buildLibrary(LoadState &state) {
+    if (!templates.empty() && !m_templateChoice.table.build(state.templateWeights)) {
+        log(infra::LogLevel::Error, "Fortune file has no pickable templates");
+        return false;
+    }
+
+    // No-repeat windows are clamped so there is always something left to pick
+    for (const auto &entry : state.noRepeat) {
+        FortuneChoice *choice = nullptr;
+        if (entry.first == "templates") {
+            choice = &m_templateChoice;
+        } else {
+            const int index = findWordlist(entry.first.c_str(), entry.first.size());
+            choice = index >= 0 ? &wordlists[index].choice : nullptr;
+        }
+        if (!choice) {
+            log(infra::LogLevel::Warn, "no_repeat names unknown wordlist '%s'", entry.first.c_str());
+            continue;
+        }
+        const size_t active = choice->table.activeCount();
+        choice->window = static_cast<uint16_t>(std::min<size_t>(entry.second, active > 0 ? active - 1 : 0));
+        choice->recent.clear();
+        choice->recent.reserve(choice->window);
+    }
+
+    // Words that hold tokens become rules, compiled like templates
+    for (auto &wordList : wordlists) {
+        for (size_t i = 0; i < wordList.words.size(); ++i) {
+            if (!strstr(wordList.words[i], "{{")) {
+                continue;
+            }
+            if (m_rules.size() >= 0xFFFE) {
+                log(infra::LogLevel::Error, "Fortune file has too many nested rules");
+                return false;
+            }
+            if (wordList.rules.empty()) {
+                wordList.rules.assign(wordList.words.size(), 0);
             }
+            FortuneTemplate rule;
+            rule.text = wordList.words[i];
+            rule.length = static_cast<uint16_t>(strlen(rule.text));
+            m_rules.push_back(std::move(rule));
+            wordList.rules[i] = static_cast<uint16_t>(m_rules.size());
         }
+    }
 
-        wordlists[category] = wordList;
-        log(infra::LogLevel::Info, "Loaded %u words for category '%s'", static_cast<unsigned>(wordList.size()), category.c_str());
+    // Validate and compile all templates and rules
+    for (auto *list : {&templates, &m_rules}) {
+        for (auto &template_obj : *list) {
+            if (!compileTemplate(template_obj)) {
+                log(infra::LogLevel::Error, "Invalid template: %s", template_obj.text);
+                return false;
+            }
+        }
     }
+    return true;
 }
 
-void FortuneGenerator::parseTemplates(JsonArray templatesArray) {
-    templates.clear();
-    
-    for (JsonVariant template_var : templatesArray) {
-        FortuneTemplate template_obj;
-        const char *text = template_var.as<const char*>();
-        if (text) {
-            template_obj.template_text = text;
-            template_obj.tokens = extractTokens(template_obj.template_text);
-            templates.push_back(template_obj);
+int FortuneGenerator::findWordlist(const char *name, size_t length) const {
+    for (size_t i = 0; i < wordlists.size(); ++i) {
+        const char *candidate = wordlists[i].name;
+        if (strncmp(candidate, name, length) == 0 && candidate[length] == '\0') {
+            return static_cast<int>(i);
         }
     }
+    return -1;
 }
 
-std::vector<String> FortuneGenerator::extractTokens(const String& templateText) {
-    std::vector<String> tokens;
-    int startPos = 0;
-    while (true) {
-        int tokenStart = templateText.indexOf("{{", startPos);
-        if (tokenStart == -1) break;
-        int tokenEnd = templateText.indexOf("}}", tokenStart + 2);
-        if (tokenEnd == -1) break;
-        String token = templateText.substring(tokenStart + 2, tokenEnd);
-        token.trim();
-        if (token.length() > 0) {
-            bool exists = false;
-            for (const auto &existing : tokens) {
-                if (existing == token) {
-                    exists = true;
-                    break;
-                }
+bool FortuneGenerator::compileTemplate(FortuneTemplate& fortuneTemplate) {
+    const char *text = fortuneTemplate.text;
+    const size_t length = fortuneTemplate.length;
+    fortuneTemplate.segments.clear();
+    fortuneTemplate.slotWordlists.clear();
+    fortuneTemplate.maxLength = 0;
+
+    const auto find = [text, length](const char *marker, size_t from) -> size_t {
+        for (size_t i = from; i + 1 < length; ++i) {
+            if (text[i] == marker[0] && text[i + 1] == marker[1]) {
+                return i;
             }
-            if (!exists) {
-                tokens.push_back(token);
+        }
+        return length;
+    };
+    const auto addLiteral = [&fortuneTemplate](size_t start, size_t end) {
+        if (end <= start) {
+            return;
+        }
+        FortuneTemplate::Segment segment;
+        segment.offset = static_cast<uint16_t>(start);
+        segment.length = static_cast<uint16_t>(end - start);
+        fortuneTemplate.segments.push_back(segment);
+        fortuneTemplate.maxLength += segment.length;
+    };
+
+    // Token names of the slots so far, as spans of the template text
+    std::vector<std::pair<size_t, size_t>> slotNames;
+    size_t index = 0;
+    while (index < length) {
+        const size_t tokenStart = find("{{", index);
+        if (tokenStart == length) {
+            addLiteral(index, length);
+            break;
+        }
+        addLiteral(index, tokenStart);
+        const size_t tokenEnd = find("}}", tokenStart + 2);
+        if (tokenEnd == length) {
+            log(infra::LogLevel::Warn, "Unterminated token in template: %s", text);
+            addLiteral(tokenStart, length);
+            break;
+        }
+        index = tokenEnd + 2;
+
+        size_t nameStart = tokenStart + 2;
+        size_t nameEnd = tokenEnd;
+        while (nameStart < nameEnd && isspace(static_cast<unsigned char>(text[nameStart]))) {
+            ++nameStart;
+        }
+        while (nameEnd > nameStart && isspace(static_cast<unsigned char>(text[nameEnd - 1]))) {
+            --nameEnd;
+        }
+        const size_t nameLength = nameEnd - nameStart;
+        if (nameLength == 0) {
+            addLiteral(tokenStart, index);
+            continue;
+        }
+
+        size_t slot = 0;
+        while (slot < slotNames.size() &&
+               !(slotNames[slot].second == nameLength &&
+                 memcmp(text + slotNames[slot].first, text + nameStart, nameLength) == 0)) {
+            ++slot;
+        }
+        if (slot == slotNames.size()) {
+            const int wordlist = findWordlist(text + nameStart, nameLength);
+            if (wordlist < 0 || wordlists[wordlist].choice.table.activeCount() == 0) {
+                log(infra::LogLevel::Warn, "Token '%.*s' has no wordlist or empty wordlist",
+                    static_cast<int>(nameLength), text + nameStart);
+                return false;
+            }
+            slotNames.emplace_back(nameStart, nameLength);
+            fortuneTemplate.slotWordlists.push_back(static_cast<uint16_t>(wordlist));
+        }
+
+        size_t longest = 0;
+        for (const char *word : wordlists[fortuneTemplate.slotWordlists[slot]].words) {
+            longest = std::max(longest, strlen(word));
+        }
+        FortuneTemplate::Segment segment;
+        segment.slot = static_cast<int16_t>(slot);
+        fortuneTemplate.segments.push_back(segment);
+        fortuneTemplate.maxLength += longest;
+    }
+
+    if (fortuneTemplate.slotWordlists.empty()) {
+        log(infra::LogLevel::Warn, "Template has no tokens: %s", text);
+    }
+    fortuneTemplate.segments.shrink_to_fit();
+    return true;
+}
+
+size_t FortuneGenerator::choose(FortuneChoice &choice, infra::IRandomSource &random) {
+    size_t pick = choice.table.pick(random);
+    if (choice.window == 0) {
+        return pick;
+    }
+    // Redraw a bounded number of times to dodge recent picks; the window is
+    // smaller than the list, so this nearly always succeeds quickly
+    const auto recent = [&choice](size_t candidate) {
+        return std::find(choice.recent.begin(), choice.recent.end(), candidate) != choice.recent.end();
+    };
+    for (int attempt = 0; attempt < MAX_REDRAWS && recent(pick); ++attempt) {
+        pick = choice.table.pick(random);
+    }
+    if (choice.recent.size() < choice.window) {
+        choice.recent.push_back(static_cast<uint16_t>(pick));
+    } else {
+        choice.recent[choice.recentHead] = static_cast<uint16_t>(pick);
+        choice.recentHead = static_cast<uint16_t>((choice.recentHead + 1) % choice.window);
+    }
+    return pick;
+}
+
+void FortuneGenerator::pushFrame(const FortuneTemplate &source, infra::IRandomSource &random) {
+    // Draw one word per distinct token, in order, so a repeated token
+    // repeats its word
+    const size_t base = m_picks.size();
+    for (uint16_t wordlist : source.slotWordlists) {
+        m_picks.push_back(static_cast<uint16_t>(choose(wordlists[wordlist].choice, random)));
+    }
+    m_frames.push_back(Frame{&source, 0, base});
+}
+
+void FortuneGenerator::expand(const FortuneTemplate &root, infra::IRandomSource &random, String &result) {
+    // Iterative so nested rules cannot exhaust the task stack; a rule that
+    // would nest deeper than the limit expands to nothing
+    bool depthLimited = false;
+    bool truncated = false;
+    const auto append = [&result, &truncated](const char *text, size_t length) {
+        size_t room = MAX_FORTUNE_LENGTH - result.length();
+        if (length > room) {
+            // Cut on a UTF-8 character boundary
+            while (room > 0 && (static_cast<uint8_t>(text[room]) & 0xC0) == 0x80) {
+                --room;
             }
+            length = room;
+            truncated = true;
+        }
+        result.concat(text, static_cast<unsigned>(length));
+    };
+
+    m_frames.clear();
+    m_picks.clear();
+    pushFrame(root, random);
+    while (!m_frames.empty() && !truncated) {
+        Frame &frame = m_frames.back();
+        if (frame.segment == frame.source->segments.size()) {
+            m_picks.resize(frame.picks);
+            m_frames.pop_back();
+            continue;
         }
-        startPos = tokenEnd + 2;
+        const FortuneTemplate &source = *frame.source;
+        const FortuneTemplate::Segment &segment = source.segments[frame.segment++];
+        if (segment.slot < 0) {
+            append(source.text + segment.offset, segment.length);
+            continue;
+        }
+        const FortuneWordlist &wordList = wordlists[source.slotWordlists[segment.slot]];
+        const uint16_t word = m_picks[frame.picks + segment.slot];
+        const uint16_t rule = wordList.rules.empty() ? 0 : wordList.rules[word];
+        if (rule == 0) {
+            append(wordList.words[word], strlen(wordList.words[word]));
+        } else if (m_frames.size() < MAX_EXPANSION_DEPTH) {
+            pushFrame(m_rules[rule - 1], random);  // invalidates `frame`
+        } else {
+            depthLimited = true;
+        }
+    }
+
+    if (depthLimited) {
+        log(infra::LogLevel::Warn, "Fortune rules nested deeper than %u; inner rules dropped",
+            static_cast<unsigned>(MAX_EXPANSION_DEPTH));
+    }
+    if (truncated) {
+        log(infra::LogLevel::Warn, "Fortune truncated at %u bytes", static_cast<unsigned>(MAX_FORTUNE_LENGTH));
     }
-    return tokens;
 }
 
 infra::IFileSystem* FortuneGenerator::resolveFileSystem() {
@@ -294,21 +620,8 @@ infra::ILogSink* FortuneGenerator::resolveLogSink() {
 }
 
 void FortuneGenerator::log(infra::LogLevel level, const char *fmt, ...) {
-    char buffer[256];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    infra::logToSinkOrRing(m_logSink, level, TAG, fmt, args);
     va_end(args);
-
-    if (infra::ILogSink *sink = resolveLogSink()) {
-        sink->log(level, TAG, buffer);
-    }
-#ifndef UNIT_TEST
-    else {
-        LoggingManager::instance().log(static_cast<::LogLevel>(level), TAG, "%s", buffer);
-    }
-#else
-    (void)level;
-    (void)buffer;
-#endif
 }
@@ -2,10 +2,13 @@
 #define FORTUNE_GENERATOR_H
 
 #include <Arduino.h>
-#include <ArduinoJson.h>
+#include <string>
+#include <utility>
 #include <vector>
-#include <map>
+#include "infra/alias_table.h"
+#include "infra/json_pull_parser.h"
 #include "infra/log_sink.h"
+#include "infra/string_arena.h"
 
 namespace infra {
 class IFileSystem;
@@ -15,13 +18,60 @@ void setLogSink(ILogSink *sink);
 ILogSink *getLogSink();
 }
 
+// A template compiled into literal spans of its text and token slots
 struct FortuneTemplate {
-    String template_text;
-    std::vector<String> tokens;
+    struct Segment {
+        uint16_t offset = 0;
+        uint16_t length = 0;
+        int16_t slot = -1;  // token slot, or -1 for a literal span
+    };
+
+    const char *text = nullptr;  // interned in the generator's arena
+    uint16_t length = 0;
+    std::vector<Segment> segments;
+    std::vector<uint16_t> slotWordlists;  // wordlist id for each distinct token
+    size_t maxLength = 0;                 // longest output, not counting nested rules
+};
+
+// Weighted choice over a list plus a memory of its most recent picks
+struct FortuneChoice {
+    infra::AliasTable table;
+    uint16_t window = 0;           // recent picks to avoid repeating
+    std::vector<uint16_t> recent;  // ring of the last `window` picks
+    uint16_t recentHead = 0;
+};
+
+struct FortuneWordlist {
+    const char *name = nullptr;
+    std::vector<const char *> words;
+    // Per word: 1 + index of its compiled rule when the word itself holds
+    // tokens, 0 for plain text. Empty when no word in the list is a rule.
+    std::vector<uint16_t> rules;
+    FortuneChoice choice;
 };
 
+/**
+ * Loads a fortune library (JSON: version, templates, wordlists) by streaming
+ * it through a pull parser. Every template and word is interned once into a
+ * string arena, so load memory is the library's text plus small indexes
+ * regardless of file size; templates are compiled for one-pass generation.
+ *
+ * Entries may be plain strings or {"text": ..., "weight": n} objects, and a
+ * word that contains {{tokens}} is itself expanded as a nested rule. The
+ * optional "no_repeat" object maps a wordlist name (or "templates") to how
+ * many of its recent picks to avoid.
+ */
 class FortuneGenerator {
 public:
+    static constexpr size_t MAX_EXPANSION_DEPTH = 6;
+    static constexpr size_t MAX_FORTUNE_LENGTH = 480;
+    static constexpr uint32_t MAX_WEIGHT = 1000000;
+    // Up-front arena block for typical libraries; larger ones grow block by block
+    static constexpr size_t ARENA_RESERVE_BYTES = 8 * 1024;
+    // Longest template, word or key the parser accepts (JSON-decoded bytes).
+    // A longer string fails the load rather than being silently dropped.
+    static constexpr size_t MAX_ENTRY_LENGTH = 4096;
+
     FortuneGenerator();
     bool loadFortunes(const String& filePath);
     void setFileSystem(infra::IFileSystem *fileSystem);
@@ -30,21 +80,56 @@ public:
     String generateFortune();
     bool isLoaded();
 
+    size_t templateCount() const { return templates.size(); }
+    size_t wordlistCount() const { return wordlists.size(); }
+    size_t ruleCount() const { return m_rules.size(); }
+    const infra::StringArena::Stats &arenaStats() const { return m_arena.stats(); }
+
 private:
+    struct LoadState {
+        bool hasVersion = false;
+        bool hasTemplates = false;
+        bool hasWordlists = false;
+        std::vector<uint32_t> templateWeights;
+        std::vector<std::pair<std::string, uint32_t>> noRepeat;
+    };
+
+    // One template being expanded; its slot picks start at `picks` in m_picks
+    struct Frame {
+        const FortuneTemplate *source;
+        size_t segment;
+        size_t picks;
+    };
+
+    static constexpr int MAX_REDRAWS = 8;
+
+    infra::StringArena m_arena;
     std::vector<FortuneTemplate> templates;
-    std::map<String, std::vector<String>> wordlists;
+    FortuneChoice m_templateChoice;
+    std::vector<FortuneWordlist> wordlists;
+    std::vector<FortuneTemplate> m_rules;
+    std::vector<Frame> m_frames;     // scratch: expansion stack
+    std::vector<uint16_t> m_picks;   // scratch: chosen word per slot, per frame
     bool loaded;
 
     infra::IFileSystem *m_fileSystem;
     infra::IRandomSource *m_randomSource;
     infra::ILogSink *m_logSink;
 
-    String replaceTokens(const FortuneTemplate& fortuneTemplate, const std::map<String, String>& replacements);
-    String getRandomWord(const String& category);
-    bool validateTemplate(const FortuneTemplate& fortuneTemplate);
-    void parseWordlists(JsonObject wordlistsObj);
-    void parseTemplates(JsonArray templatesArray);
-    std::vector<String> extractTokens(const String& templateText);
+    void clearLibrary();
+    bool parseLibrary(infra::JsonPullParser &parser, LoadState &state);
+    bool parseTemplates(infra::JsonPullParser &parser, LoadState &state);
+    bool parseWordlists(infra::JsonPullParser &parser);
+    bool parseNoRepeat(infra::JsonPullParser &parser, LoadState &state);
+    bool parseEntry(infra::JsonPullParser &parser, infra::JsonPullParser::Token token,
+                    const char *&text, uint32_t &weight);
+    bool outOfMemory();
+    bool buildLibrary(LoadState &state);
+    bool compileTemplate(FortuneTemplate& fortuneTemplate);
+    int findWordlist(const char *name, size_t length) const;
+    size_t choose(FortuneChoice &choice, infra::IRandomSource &random);
+    void pushFrame(const FortuneTemplate &source, infra::IRandomSource &random);
+    void expand(const FortuneTemplate &root, infra::IRandomSource &random, String &result);
     infra::IFileSystem* resolveFileSystem();
     infra::IRandomSource* resolveRandomSource();
     infra::ILogSink* resolveLogSink();
@@ -0,0 +1,84 @@
+#include "alias_table.h"
+
+#include "random_source.h"
+
+namespace infra {
+
+AliasTable::AliasTable() : m_size(0), m_active(0), m_threshold(), m_alias() {
+}
+
+bool AliasTable::build(const std::vector<uint32_t> &weights) {
+    clear();
+    const size_t count = weights.size();
+    if (count == 0 || count > MAX_ENTRIES) {
+        return false;
+    }
+
+    uint64_t total = 0;
+    bool equal = true;
+    for (uint32_t weight : weights) {
+        total += weight;
+        equal = equal && weight == weights[0];
+        m_active += weight > 0 ? 1 : 0;
+    }
+    if (total == 0) {
+        m_active = 0;
+        return false;
+    }
+    m_size = count;
+    if (equal) {
+        return true;
+    }
+
+    // Scale so the average column holds exactly `total`, then pair each
+    // under-full column with an over-full one. Integer arithmetic keeps the
+    // table exact for any weights.
+    std::vector<uint64_t> scaled(count);
+    std::vector<uint16_t> small;
+    std::vector<uint16_t> large;
+    for (size_t i = 0; i < count; ++i) {
+        scaled[i] = static_cast<uint64_t>(weights[i]) * count;
+        (scaled[i] < total ? small : large).push_back(static_cast<uint16_t>(i));
+    }
+
+    m_threshold.assign(count, COIN_RANGE);
+    m_alias.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        m_alias[i] = static_cast<uint16_t>(i);
+    }
+    while (!small.empty() && !large.empty()) {
+        const uint16_t under = small.back();
+        small.pop_back();
+        const uint16_t over = large.back();
+        m_threshold[under] = static_cast<uint32_t>(scaled[under] * COIN_RANGE / total);
+        m_alias[under] = over;
+        scaled[over] -= total - scaled[under];
+        if (scaled[over] < total) {
+            large.pop_back();
+            small.push_back(over);
+        }
+    }
+    // Whatever is left is full up to rounding
+    return true;
+}
+
+void AliasTable::clear() {
+    m_size = 0;
+    m_active = 0;
+    m_threshold.clear();
+    m_alias.clear();
+}
+
+size_t AliasTable::pick(IRandomSource &random) const {
+    if (m_size == 0) {
+        return 0;
+    }
+    const size_t column = static_cast<size_t>(random.nextInt(0, static_cast<int>(m_size)));
+    if (m_threshold.empty()) {
+        return column;
+    }
+    const uint32_t coin = static_cast<uint32_t>(random.nextInt(0, static_cast<int>(COIN_RANGE)));
+    return coin < m_threshold[column] ? column : m_alias[column];
+}
+
+} // namespace infra
@@ -0,0 +1,46 @@
+#ifndef INFRA_ALIAS_TABLE_H
+#define INFRA_ALIAS_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace infra {
+
+class IRandomSource;
+
+/**
+ * Weighted random choice in O(1) per pick (Walker/Vose alias method). The
+ * table is built once from integer weights; each pick costs one column draw
+ * and one coin draw. When every weight is equal no table is stored and a pick
+ * is a single uniform draw, so unweighted lists consume the random source
+ * exactly as a plain nextInt(0, size) would.
+ */
+class AliasTable {
+public:
+    static constexpr uint32_t COIN_RANGE = 1u << 16;
+    static constexpr size_t MAX_ENTRIES = 0xFFFF;
+
+    AliasTable();
+
+    // False when there are no entries, too many, or every weight is zero.
+    bool build(const std::vector<uint32_t> &weights);
+    void clear();
+
+    size_t pick(IRandomSource &random) const;
+
+    size_t size() const { return m_size; }
+    bool uniform() const { return m_threshold.empty(); }
+    // Entries with a non-zero weight, i.e. those that can be picked.
+    size_t activeCount() const { return m_active; }
+
+private:
+    size_t m_size;
+    size_t m_active;
+    std::vector<uint32_t> m_threshold;  // keep the column if coin < threshold
+    std::vector<uint16_t> m_alias;
+};
+
+} // namespace infra
+
+#endif // INFRA_ALIAS_TABLE_H
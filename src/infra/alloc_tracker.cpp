@@ -0,0 +1,306 @@
+#include "alloc_tracker.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "runtime/module_options.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <pthread.h>
+#endif
+
+namespace infra {
+
+namespace {
+
+struct TagCounters {
+    std::atomic<uint32_t> allocations{0};
+    std::atomic<uint32_t> frees{0};
+    std::atomic<uint32_t> failures{0};
+    std::atomic<uint64_t> bytesAllocated{0};
+    std::atomic<uint32_t> liveBytes{0};
+    std::atomic<uint32_t> peakLiveBytes{0};
+};
+
+TagCounters s_tagCounters[kAllocTagCount];
+TagCounters s_totals;
+
+const char *const kTagNames[kAllocTagCount] = {
+    "other",
+    "logging",
+    "fortune",
+    "printer",
+    "audio",
+    "animator",
+    "controller",
+    "cli",
+    "network",
+};
+
+#ifdef ARDUINO
+// The tag belongs to the task, so a task that preempts the loop (LogDrain,
+// the A2DP callback, WiFi) is not charged to whatever scope the loop holds.
+// It lives in a FreeRTOS thread-local storage pointer, encoded as tag + 1 so
+// an untouched slot (null) reads as Other. Slot 0 belongs to the pthread
+// API; with no spare slot the tag goes through a pthread key, which ESP-IDF
+// keeps in that same slot. Before the scheduler starts (static constructors)
+// there is only one context, so a plain variable serves.
+#if configNUM_THREAD_LOCAL_STORAGE_POINTERS > 1
+constexpr BaseType_t kTagStorageIndex = configNUM_THREAD_LOCAL_STORAGE_POINTERS - 1;
+#else
+// Tasks may open their first scope concurrently; pthread_once makes exactly
+// one of them create the key and the others wait for it.
+pthread_key_t s_tagKey;
+pthread_once_t s_tagKeyOnce = PTHREAD_ONCE_INIT;
+std::atomic<bool> s_tagKeyReady{false};
+
+void createTagKey() {
+    s_tagKeyReady.store(pthread_key_create(&s_tagKey, nullptr) == 0, std::memory_order_release);
+}
+#endif
+
+AllocTag s_bootTag = AllocTag::Other;
+
+bool schedulerRunning() {
+    return xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+}
+
+void *encodeTag(AllocTag tag) {
+    return reinterpret_cast<void *>(static_cast<uintptr_t>(tag) + 1);
+}
+
+AllocTag decodeTag(void *value) {
+    const uintptr_t raw = reinterpret_cast<uintptr_t>(value);
+    return raw == 0 ? AllocTag::Other : static_cast<AllocTag>(raw - 1);
+}
+
+AllocTag loadTag() {
+    if (!schedulerRunning()) {
+        return s_bootTag;
+    }
+#if configNUM_THREAD_LOCAL_STORAGE_POINTERS > 1
+    return decodeTag(pvTaskGetThreadLocalStoragePointer(nullptr, kTagStorageIndex));
+#else
+    return s_tagKeyReady.load(std::memory_order_acquire) ? decodeTag(pthread_getspecific(s_tagKey))
+                                                         : AllocTag::Other;
+#endif
+}
+
+void storeTag(AllocTag tag) {
+    if (!schedulerRunning()) {
+        s_bootTag = tag;
+        return;
+    }
+#if configNUM_THREAD_LOCAL_STORAGE_POINTERS > 1
+    vTaskSetThreadLocalStoragePointer(nullptr, kTagStorageIndex, encodeTag(tag));
+#else
+    pthread_once(&s_tagKeyOnce, createTagKey);
+    if (s_tagKeyReady.load(std::memory_order_acquire)) {
+        pthread_setspecific(s_tagKey, encodeTag(tag));
+    }
+#endif
+}
+#else
+thread_local AllocTag t_currentTag = AllocTag::Other;
+
+AllocTag loadTag() {
+    return t_currentTag;
+}
+
+void storeTag(AllocTag tag) {
+    t_currentTag = tag;
+}
+#endif
+
+size_t tagIndex(AllocTag tag) {
+    const size_t index = static_cast<size_t>(tag);
+    return index < kAllocTagCount ? index : 0;
+}
+
+void raisePeak(std::atomic<uint32_t> &peak, uint32_t live) {
+    uint32_t current = peak.load(std::memory_order_relaxed);
+    while (live > current &&
+           !peak.compare_exchange_weak(current, live, std::memory_order_relaxed)) {
+    }
+}
+
+void addAllocation(TagCounters &counters, size_t bytes) {
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+    const uint32_t live =
+        counters.liveBytes.fetch_add(static_cast<uint32_t>(bytes), std::memory_order_relaxed) +
+        static_cast<uint32_t>(bytes);
+    raisePeak(counters.peakLiveBytes, live);
+}
+
+void addFree(TagCounters &counters, size_t bytes) {
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.liveBytes.fetch_sub(static_cast<uint32_t>(bytes), std::memory_order_relaxed);
+}
+
+AllocCounters snapshot(const TagCounters &counters) {
+    AllocCounters result;
+    result.allocations = counters.allocations.load(std::memory_order_relaxed);
+    result.frees = counters.frees.load(std::memory_order_relaxed);
+    result.failures = counters.failures.load(std::memory_order_relaxed);
+    result.bytesAllocated = counters.bytesAllocated.load(std::memory_order_relaxed);
+    result.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+    result.peakLiveBytes = counters.peakLiveBytes.load(std::memory_order_relaxed);
+    return result;
+}
+
+}  // namespace
+
+const char *allocTagName(AllocTag tag) {
+    return kTagNames[tagIndex(tag)];
+}
+
+bool allocTrackingEnabled() {
+    return APP_ENABLE_ALLOC_TRACKING != 0;
+}
+
+AllocCounters allocCounters(AllocTag tag) {
+    return snapshot(s_tagCounters[tagIndex(tag)]);
+}
+
+AllocCounters allocTotals() {
+    return snapshot(s_totals);
+}
+
+void resetAllocPeaks() {
+    for (auto &counters : s_tagCounters) {
+        counters.peakLiveBytes.store(counters.liveBytes.load(std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+    }
+    s_totals.peakLiveBytes.store(s_totals.liveBytes.load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+}
+
+AllocTag currentAllocTag() {
+    return loadTag();
+}
+
+void recordAllocation(AllocTag tag, size_t bytes) {
+    addAllocation(s_tagCounters[tagIndex(tag)], bytes);
+    addAllocation(s_totals, bytes);
+}
+
+void recordFree(AllocTag tag, size_t bytes) {
+    addFree(s_tagCounters[tagIndex(tag)], bytes);
+    addFree(s_totals, bytes);
+}
+
+void recordAllocationFailure(AllocTag tag) {
+    s_tagCounters[tagIndex(tag)].failures.fetch_add(1, std::memory_order_relaxed);
+    s_totals.failures.fetch_add(1, std::memory_order_relaxed);
+}
+
+ScopedAllocTag::ScopedAllocTag(AllocTag tag)
+    : m_previous(loadTag()) {
+    storeTag(tag);
+}
+
+ScopedAllocTag::~ScopedAllocTag() {
+    storeTag(m_previous);
+}
+
+}  // namespace infra
+
+#if APP_ENABLE_ALLOC_TRACKING
+
+// Global allocation hooks. Every block carries a small header recording its
+// size and owning tag so frees are credited back to the subsystem that made
+// the allocation, whichever task releases it.
+namespace {
+
+struct AllocHeader {
+    uint32_t size;
+    infra::AllocTag tag;
+};
+
+constexpr size_t kHeaderSize =
+    ((sizeof(AllocHeader) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t)) *
+    alignof(std::max_align_t);
+
+void *trackedAlloc(size_t size) {
+    const infra::AllocTag tag = infra::currentAllocTag();
+    void *raw = std::malloc(size + kHeaderSize);
+    if (!raw) {
+        infra::recordAllocationFailure(tag);
+        return nullptr;
+    }
+    auto *header = static_cast<AllocHeader *>(raw);
+    header->size = static_cast<uint32_t>(size);
+    header->tag = tag;
+    infra::recordAllocation(tag, size);
+    return static_cast<unsigned char *>(raw) + kHeaderSize;
+}
+
+void trackedFree(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    void *raw = static_cast<unsigned char *>(ptr) - kHeaderSize;
+    const auto *header = static_cast<const AllocHeader *>(raw);
+    infra::recordFree(header->tag, header->size);
+    std::free(raw);
+}
+
+void *trackedAllocOrThrow(size_t size) {
+    void *ptr = trackedAlloc(size);
+    if (!ptr) {
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return ptr;
+}
+
+}  // namespace
+
+void *operator new(size_t size) {
+    return trackedAllocOrThrow(size);
+}
+
+void *operator new[](size_t size) {
+    return trackedAllocOrThrow(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return trackedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return trackedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    trackedFree(ptr);
+}
+
+#endif  // APP_ENABLE_ALLOC_TRACKING
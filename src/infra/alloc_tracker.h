@@ -0,0 +1,75 @@
+#ifndef INFRA_ALLOC_TRACKER_H
+#define INFRA_ALLOC_TRACKER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace infra {
+
+/**
+ * Subsystems that heap allocations are attributed to. Code marks its
+ * allocation-heavy paths with ScopedAllocTag; anything outside a scope is
+ * counted as Other.
+ */
+enum class AllocTag : uint8_t {
+    Other = 0,
+    Logging,
+    Fortune,
+    Printer,
+    Audio,
+    Animator,
+    Controller,
+    Cli,
+    Network,
+    Count
+};
+
+struct AllocCounters {
+    uint32_t allocations = 0;
+    uint32_t frees = 0;
+    uint32_t failures = 0;
+    uint64_t bytesAllocated = 0;
+    uint32_t liveBytes = 0;
+    uint32_t peakLiveBytes = 0;
+};
+
+constexpr size_t kAllocTagCount = static_cast<size_t>(AllocTag::Count);
+
+const char *allocTagName(AllocTag tag);
+
+// True when the global operator new/delete hooks are compiled in
+// (APP_ENABLE_ALLOC_TRACKING). Counters stay zero otherwise.
+bool allocTrackingEnabled();
+
+AllocCounters allocCounters(AllocTag tag);
+AllocCounters allocTotals();
+void resetAllocPeaks();
+
+AllocTag currentAllocTag();
+
+// Records an allocation or free against a tag. Called by the operator new
+// hooks; exposed so non-C++ allocators can report into the same counters.
+void recordAllocation(AllocTag tag, size_t bytes);
+void recordFree(AllocTag tag, size_t bytes);
+void recordAllocationFailure(AllocTag tag);
+
+/**
+ * RAII marker that attributes allocations made on the current task (host:
+ * thread) to a subsystem until it goes out of scope. Other tasks keep
+ * their own tag while this one holds a scope.
+ */
+class ScopedAllocTag {
+public:
+    explicit ScopedAllocTag(AllocTag tag);
+    ~ScopedAllocTag();
+
+    ScopedAllocTag(const ScopedAllocTag &) = delete;
+    ScopedAllocTag &operator=(const ScopedAllocTag &) = delete;
+
+private:
+    AllocTag m_previous;
+};
+
+}  // namespace infra
+
+#endif  // INFRA_ALLOC_TRACKER_H
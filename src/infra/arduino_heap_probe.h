@@ -0,0 +1,28 @@
+#ifndef INFRA_ARDUINO_HEAP_PROBE_H
+#define INFRA_ARDUINO_HEAP_PROBE_H
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#include "infra/heap_probe.h"
+
+namespace infra {
+
+// Reports the internal 8-bit heap, which is where String and container
+// allocations land and where fragmentation hurts first.
+class ArduinoHeapProbe : public IHeapProbe {
+public:
+    HeapStats sample() const override {
+        constexpr uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+        HeapStats stats;
+        stats.freeBytes = heap_caps_get_free_size(caps);
+        stats.largestFreeBlock = heap_caps_get_largest_free_block(caps);
+        stats.minimumFreeBytes = heap_caps_get_minimum_free_size(caps);
+        stats.totalBytes = heap_caps_get_total_size(caps);
+        return stats;
+    }
+};
+
+}  // namespace infra
+
+#endif  // INFRA_ARDUINO_HEAP_PROBE_H
@@ -0,0 +1,91 @@
+#ifndef INFRA_ESP_PERIODIC_TIMER_H
+#define INFRA_ESP_PERIODIC_TIMER_H
+
+#include <atomic>
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "infra/periodic_timer.h"
+
+namespace infra {
+
+// esp_timer in task dispatch mode: callbacks run on the high-priority
+// esp_timer task, so they stay on schedule while the Arduino loop is busy.
+class EspPeriodicTimer : public IPeriodicTimer {
+public:
+    explicit EspPeriodicTimer(const char *name)
+        : m_name(name), m_handle(nullptr), m_callback(nullptr), m_context(nullptr), m_running(false),
+          m_inCallback(false) {}
+
+    ~EspPeriodicTimer() override {
+        stop();
+        if (m_handle) {
+            esp_timer_delete(m_handle);
+        }
+    }
+
+    bool start(uint32_t periodMicros, Callback callback, void *context) override {
+        stop();
+        if (m_handle) {
+            esp_timer_delete(m_handle);
+            m_handle = nullptr;
+        }
+        m_callback = callback;
+        m_context = context;
+        esp_timer_create_args_t args = {};
+        args.callback = &EspPeriodicTimer::dispatch;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = m_name;
+        if (esp_timer_create(&args, &m_handle) != ESP_OK) {
+            m_handle = nullptr;
+            return false;
+        }
+        m_running.store(true);
+        if (esp_timer_start_periodic(m_handle, periodMicros) != ESP_OK) {
+            m_running.store(false);
+        }
+        return m_running.load();
+    }
+
+    // esp_timer_stop() does not wait for a callback already running on the
+    // esp_timer task, so wait here until it has returned. Must not be called
+    // from the callback itself.
+    void stop() override {
+        if (!m_handle || !m_running.load()) {
+            return;
+        }
+        // Sequentially consistent with dispatch(): either the callback sees
+        // m_running false and skips, or this sees it in flight and waits
+        m_running.store(false);
+        esp_timer_stop(m_handle);
+        while (m_inCallback.load()) {
+            vTaskDelay(1);
+        }
+    }
+
+    bool isRunning() const override { return m_running.load(std::memory_order_acquire); }
+
+private:
+    static void dispatch(void *arg) {
+        auto *self = static_cast<EspPeriodicTimer *>(arg);
+        self->m_inCallback.store(true);
+        if (self->m_running.load()) {
+            self->m_callback(self->m_context);
+        }
+        self->m_inCallback.store(false, std::memory_order_release);
+    }
+
+    const char *m_name;
+    esp_timer_handle_t m_handle;
+    Callback m_callback;
+    void *m_context;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_inCallback;  // set by the esp_timer task around each callback
+};
+
+}  // namespace infra
+
+#endif  // INFRA_ESP_PERIODIC_TIMER_H
@@ -13,6 +13,14 @@ public:
     virtual bool available() = 0;
     virtual String readString() = 0;
     virtual String readStringUntil(char delimiter) = 0;
+    // Reads up to `length` bytes; returns 0 at end of file.
+    virtual size_t read(uint8_t *buffer, size_t length) = 0;
+    // Total size in bytes, for sizing buffers before reading.
+    virtual size_t size() = 0;
+    // Writes up to `length` bytes; returns the count actually written.
+    virtual size_t write(const uint8_t *buffer, size_t length) = 0;
+    // Commits buffered writes to the medium; a no-op where writes are direct.
+    virtual void flush() {}
     virtual void close() = 0;
 };
 
@@ -22,6 +30,10 @@ public:
 
     virtual bool exists(const char *path) const = 0;
     virtual std::unique_ptr<IFile> open(const char *path, const char *mode) = 0;
+    virtual bool remove(const char *path) = 0;
+    virtual bool rename(const char *from, const char *to) = 0;
+    // Succeeds when the directory already exists.
+    virtual bool makeDirectory(const char *path) = 0;
 };
 
 } // namespace infra
@@ -0,0 +1,90 @@
+#ifndef INFRA_FREERTOS_PERIODIC_TASK_H
+#define INFRA_FREERTOS_PERIODIC_TASK_H
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "infra/periodic_timer.h"
+
+namespace infra {
+
+// Dedicated FreeRTOS task paced with vTaskDelayUntil. For callbacks that
+// block for a noticeable time (e.g. a touch measurement) and so must not sit
+// on the shared esp_timer task. Period resolution is one RTOS tick.
+class FreeRtosPeriodicTask : public IPeriodicTimer {
+public:
+    FreeRtosPeriodicTask(const char *name, uint32_t stackBytes, UBaseType_t priority, BaseType_t core)
+        : m_name(name),
+          m_stackBytes(stackBytes),
+          m_priority(priority),
+          m_core(core),
+          m_handle(nullptr),
+          m_callback(nullptr),
+          m_context(nullptr),
+          m_periodTicks(1),
+          m_running(false) {}
+
+    ~FreeRtosPeriodicTask() override { stop(); }
+
+    bool start(uint32_t periodMicros, Callback callback, void *context) override {
+        stop();
+        if (!callback) {
+            return false;
+        }
+        m_callback = callback;
+        m_context = context;
+        const TickType_t ticks = pdMS_TO_TICKS(periodMicros / 1000);
+        m_periodTicks = ticks > 0 ? ticks : 1;
+        m_running.store(true, std::memory_order_release);
+        TaskHandle_t handle = nullptr;
+        if (xTaskCreatePinnedToCore(&FreeRtosPeriodicTask::run, m_name, m_stackBytes, this, m_priority,
+                                    &handle, m_core) != pdPASS) {
+            m_running.store(false, std::memory_order_release);
+            return false;
+        }
+        m_handle.store(handle, std::memory_order_release);
+        return true;
+    }
+
+    // Cooperative: the task finishes its current callback and deletes itself,
+    // so a callback is never cut off halfway through a peripheral access.
+    void stop() override {
+        if (!m_handle.load(std::memory_order_acquire)) {
+            return;
+        }
+        m_running.store(false, std::memory_order_release);
+        while (m_handle.load(std::memory_order_acquire)) {
+            vTaskDelay(1);
+        }
+    }
+
+    bool isRunning() const override { return m_running.load(std::memory_order_acquire); }
+
+private:
+    static void run(void *param) {
+        auto *self = static_cast<FreeRtosPeriodicTask *>(param);
+        TickType_t wake = xTaskGetTickCount();
+        while (self->m_running.load(std::memory_order_acquire)) {
+            self->m_callback(self->m_context);
+            vTaskDelayUntil(&wake, self->m_periodTicks);
+        }
+        self->m_handle.store(nullptr, std::memory_order_release);
+        vTaskDelete(nullptr);
+    }
+
+    const char *m_name;
+    uint32_t m_stackBytes;
+    UBaseType_t m_priority;
+    BaseType_t m_core;
+    std::atomic<TaskHandle_t> m_handle;  // cleared by the task as it exits
+    Callback m_callback;
+    void *m_context;
+    TickType_t m_periodTicks;
+    std::atomic<bool> m_running;
+};
+
+}  // namespace infra
+
+#endif  // INFRA_FREERTOS_PERIODIC_TASK_H
@@ -0,0 +1,27 @@
+#ifndef INFRA_HEAP_PROBE_H
+#define INFRA_HEAP_PROBE_H
+
+#include <stdint.h>
+
+namespace infra {
+
+struct HeapStats {
+    uint32_t freeBytes = 0;
+    uint32_t largestFreeBlock = 0;
+    uint32_t minimumFreeBytes = 0;   // Lowest free-heap watermark since boot
+    uint32_t totalBytes = 0;
+};
+
+/**
+ * Interface surface for heap queries.
+ * Lets host tests feed scripted heap readings without touching heap_caps.
+ */
+class IHeapProbe {
+public:
+    virtual ~IHeapProbe() = default;
+    virtual HeapStats sample() const = 0;
+};
+
+}  // namespace infra
+
+#endif  // INFRA_HEAP_PROBE_H
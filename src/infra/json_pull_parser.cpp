@@ -0,0 +1,360 @@
+#include "json_pull_parser.h"
+
+#include <cstring>
+#include <utility>
+
+namespace infra {
+
+namespace {
+bool isSpace(int c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+int hexValue(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+}  // namespace
+
+JsonPullParser::JsonPullParser(Reader reader, size_t maxStringLength)
+    : m_reader(std::move(reader)),
+      m_maxString(maxStringLength),
+      m_buffer(),
+      m_pos(0),
+      m_len(0),
+      m_offset(0),
+      m_eof(false),
+      m_stack(),
+      m_expect(Expect::Value),
+      m_text(),
+      m_error(nullptr) {
+}
+
+JsonPullParser::Token JsonPullParser::next() {
+    if (m_error) {
+        return Token::Error;
+    }
+    for (;;) {
+        const int c = peekNonSpace();
+        switch (m_expect) {
+            case Expect::Done:
+                return c < 0 ? Token::End : fail("trailing characters after document");
+
+            case Expect::Colon:
+                if (c != ':') {
+                    return fail("expected ':' after key");
+                }
+                get();
+                m_expect = Expect::Value;
+                continue;
+
+            case Expect::CommaOrEnd:
+                if (c == ',') {
+                    get();
+                    m_expect = m_stack.back() == '{' ? Expect::Key : Expect::Value;
+                    continue;
+                }
+                if ((c == '}' && m_stack.back() == '{') || (c == ']' && m_stack.back() == '[')) {
+                    return close();
+                }
+                return fail("expected ',' or end of container");
+
+            case Expect::KeyOrEnd:
+                if (c == '}') {
+                    return close();
+                }
+                // fall through
+            case Expect::Key:
+                if (c != '"') {
+                    return fail("expected object key");
+                }
+                get();
+                if (!readString()) {
+                    return Token::Error;
+                }
+                m_expect = Expect::Colon;
+                return Token::Key;
+
+            case Expect::ValueOrEnd:
+                if (c == ']') {
+                    return close();
+                }
+                // fall through
+            case Expect::Value:
+                return readValue(c);
+        }
+    }
+}
+
+bool JsonPullParser::skipValue(Token first) {
+    if (first != Token::BeginObject && first != Token::BeginArray) {
+        return first != Token::Error && first != Token::End;
+    }
+    size_t depth = 1;
+    while (depth > 0) {
+        switch (next()) {
+            case Token::BeginObject:
+            case Token::BeginArray:
+                ++depth;
+                break;
+            case Token::EndObject:
+            case Token::EndArray:
+                --depth;
+                break;
+            case Token::Error:
+            case Token::End:
+                return false;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+int JsonPullParser::peek() {
+    if (m_pos >= m_len) {
+        if (m_eof) {
+            return -1;
+        }
+        m_len = m_reader ? m_reader(m_buffer, sizeof(m_buffer)) : 0;
+        m_pos = 0;
+        if (m_len == 0) {
+            m_eof = true;
+            return -1;
+        }
+    }
+    return m_buffer[m_pos];
+}
+
+int JsonPullParser::get() {
+    const int c = peek();
+    if (c >= 0) {
+        ++m_pos;
+        ++m_offset;
+    }
+    return c;
+}
+
+int JsonPullParser::peekNonSpace() {
+    int c = peek();
+    while (isSpace(c)) {
+        get();
+        c = peek();
+    }
+    return c;
+}
+
+JsonPullParser::Token JsonPullParser::fail(const char *message) {
+    if (!m_error) {
+        m_error = message;
+    }
+    return Token::Error;
+}
+
+JsonPullParser::Token JsonPullParser::readValue(int c) {
+    if (c < 0) {
+        return fail("unexpected end of input");
+    }
+    if (c == '{' || c == '[') {
+        if (m_stack.size() >= MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+        get();
+        m_stack.push_back(static_cast<char>(c));
+        m_expect = c == '{' ? Expect::KeyOrEnd : Expect::ValueOrEnd;
+        return c == '{' ? Token::BeginObject : Token::BeginArray;
+    }
+
+    Token token;
+    if (c == '"') {
+        get();
+        if (!readString()) {
+            return Token::Error;
+        }
+        token = Token::String;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        if (!readNumber()) {
+            return Token::Error;
+        }
+        token = Token::Number;
+    } else if (c == 't') {
+        if (!readLiteral("true")) {
+            return Token::Error;
+        }
+        token = Token::True;
+    } else if (c == 'f') {
+        if (!readLiteral("false")) {
+            return Token::Error;
+        }
+        token = Token::False;
+    } else if (c == 'n') {
+        if (!readLiteral("null")) {
+            return Token::Error;
+        }
+        token = Token::Null;
+    } else {
+        return fail("unexpected character");
+    }
+    afterValue();
+    return token;
+}
+
+JsonPullParser::Token JsonPullParser::close() {
+    const char open = m_stack.back();
+    get();
+    m_stack.pop_back();
+    afterValue();
+    return open == '{' ? Token::EndObject : Token::EndArray;
+}
+
+void JsonPullParser::afterValue() {
+    m_expect = m_stack.empty() ? Expect::Done : Expect::CommaOrEnd;
+}
+
+bool JsonPullParser::readString() {
+    m_text.clear();
+    for (;;) {
+        int c = get();
+        if (c < 0) {
+            fail("unterminated string");
+            return false;
+        }
+        if (c == '"') {
+            return true;
+        }
+        if (c < 0x20) {
+            fail("control character in string");
+            return false;
+        }
+        if (c == '\\') {
+            c = get();
+            switch (c) {
+                case '"':
+                case '\\':
+                case '/':
+                    break;
+                case 'b':
+                    c = '\b';
+                    break;
+                case 'f':
+                    c = '\f';
+                    break;
+                case 'n':
+                    c = '\n';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case 'u': {
+                    uint32_t codepoint = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        const int digit = hexValue(get());
+                        if (digit < 0) {
+                            fail("bad \\u escape");
+                            return false;
+                        }
+                        codepoint = (codepoint << 4) | static_cast<uint32_t>(digit);
+                    }
+                    if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                        // High surrogate: the low half must follow as another \u escape
+                        uint32_t low = 0;
+                        if (get() != '\\' || get() != 'u') {
+                            fail("unpaired surrogate");
+                            return false;
+                        }
+                        for (int i = 0; i < 4; ++i) {
+                            const int digit = hexValue(get());
+                            if (digit < 0) {
+                                fail("bad \\u escape");
+                                return false;
+                            }
+                            low = (low << 4) | static_cast<uint32_t>(digit);
+                        }
+                        if (low < 0xDC00 || low > 0xDFFF) {
+                            fail("unpaired surrogate");
+                            return false;
+                        }
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    if (!appendCodepoint(codepoint)) {
+                        return false;
+                    }
+                    continue;
+                }
+                default:
+                    fail("bad escape in string");
+                    return false;
+            }
+        }
+        if (m_text.size() >= m_maxString) {
+            fail("string too long");
+            return false;
+        }
+        m_text.push_back(static_cast<char>(c));
+    }
+}
+
+bool JsonPullParser::appendCodepoint(uint32_t codepoint) {
+    if (codepoint == 0 || (codepoint >= 0xDC00 && codepoint <= 0xDFFF)) {
+        fail("invalid code point in string");
+        return false;
+    }
+    char utf8[4];
+    size_t count;
+    if (codepoint < 0x80) {
+        utf8[0] = static_cast<char>(codepoint);
+        count = 1;
+    } else if (codepoint < 0x800) {
+        utf8[0] = static_cast<char>(0xC0 | (codepoint >> 6));
+        utf8[1] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        count = 2;
+    } else if (codepoint < 0x10000) {
+        utf8[0] = static_cast<char>(0xE0 | (codepoint >> 12));
+        utf8[1] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        utf8[2] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        count = 3;
+    } else {
+        utf8[0] = static_cast<char>(0xF0 | (codepoint >> 18));
+        utf8[1] = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        utf8[2] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        utf8[3] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        count = 4;
+    }
+    if (m_text.size() + count > m_maxString) {
+        fail("string too long");
+        return false;
+    }
+    m_text.append(utf8, count);
+    return true;
+}
+
+bool JsonPullParser::readNumber() {
+    m_text.clear();
+    int c = peek();
+    while (c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E' || (c >= '0' && c <= '9')) {
+        if (m_text.size() >= 32) {
+            fail("number too long");
+            return false;
+        }
+        m_text.push_back(static_cast<char>(get()));
+        c = peek();
+    }
+    return true;
+}
+
+bool JsonPullParser::readLiteral(const char *literal) {
+    for (const char *p = literal; *p; ++p) {
+        if (get() != *p) {
+            fail("invalid literal");
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace infra
@@ -0,0 +1,92 @@
+#ifndef INFRA_JSON_PULL_PARSER_H
+#define INFRA_JSON_PULL_PARSER_H
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace infra {
+
+/**
+ * Incremental JSON tokenizer. Reads its input through a small buffer and
+ * hands back one token at a time, so memory use is bounded by the longest
+ * string and the nesting depth rather than the document size. Strings are
+ * unescaped (\uXXXX becomes UTF-8); numbers are returned as their text.
+ */
+class JsonPullParser {
+public:
+    // Fills `buffer` with up to `length` bytes; returns 0 at end of input.
+    using Reader = std::function<size_t(uint8_t *buffer, size_t length)>;
+
+    enum class Token : uint8_t {
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+        End,
+        Error
+    };
+
+    static constexpr size_t DEFAULT_MAX_STRING = 1024;
+    static constexpr size_t MAX_DEPTH = 32;
+
+    explicit JsonPullParser(Reader reader, size_t maxStringLength = DEFAULT_MAX_STRING);
+
+    Token next();
+    // Consumes the rest of a value whose first token was `first`.
+    bool skipValue(Token first);
+
+    // Text of the last Key, String or Number token.
+    const std::string &text() const { return m_text; }
+    const char *error() const { return m_error; }
+    // Bytes consumed so far, for error messages.
+    size_t offset() const { return m_offset; }
+
+private:
+    enum class Expect : uint8_t {
+        Value,
+        ValueOrEnd,
+        Key,
+        KeyOrEnd,
+        Colon,
+        CommaOrEnd,
+        Done
+    };
+
+    int peek();
+    int get();
+    int peekNonSpace();
+    Token fail(const char *message);
+    Token readValue(int c);
+    Token close();
+    bool readString();
+    bool readNumber();
+    bool readLiteral(const char *literal);
+    bool appendCodepoint(uint32_t codepoint);
+    void afterValue();
+
+    Reader m_reader;
+    size_t m_maxString;
+    uint8_t m_buffer[128];
+    size_t m_pos;
+    size_t m_len;
+    size_t m_offset;
+    bool m_eof;
+
+    std::vector<char> m_stack;
+    Expect m_expect;
+    std::string m_text;
+    const char *m_error;
+};
+
+} // namespace infra
+
+#endif // INFRA_JSON_PULL_PARSER_H
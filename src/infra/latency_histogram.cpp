@@ -0,0 +1,68 @@
+#include "latency_histogram.h"
+
+namespace infra {
+
+void LatencyHistogram::record(uint32_t micros) {
+    if (m_count == 0 || micros < m_minUs) {
+        m_minUs = micros;
+    }
+    if (micros > m_maxUs) {
+        m_maxUs = micros;
+    }
+    ++m_count;
+    m_totalUs += micros;
+    ++m_buckets[bucketIndex(micros)];
+}
+
+void LatencyHistogram::reset() {
+    *this = LatencyHistogram{};
+}
+
+uint32_t LatencyHistogram::avgUs() const {
+    return m_count ? static_cast<uint32_t>(m_totalUs / m_count) : 0;
+}
+
+uint32_t LatencyHistogram::percentileUs(uint32_t perMille) const {
+    if (m_count == 0) {
+        return 0;
+    }
+    // Rank of the sample at or above the requested fraction (1-based).
+    const uint64_t rank = (static_cast<uint64_t>(m_count) * perMille + 999) / 1000;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank && m_buckets[i] > 0) {
+            const uint32_t bound = bucketUpperBound(i);
+            if (bound > m_maxUs) {
+                return m_maxUs;
+            }
+            return bound < m_minUs ? m_minUs : bound;
+        }
+    }
+    return m_maxUs;
+}
+
+size_t LatencyHistogram::bucketIndex(uint32_t micros) {
+    if (micros < EXACT_BUCKETS) {
+        return micros;
+    }
+    const uint32_t exponent = 31 - static_cast<uint32_t>(__builtin_clz(micros));
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    const uint32_t sub = (micros >> (exponent - 2)) & 0x3;
+    const size_t index = EXACT_BUCKETS + (exponent - 2) * 4 + sub;
+    return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < EXACT_BUCKETS) {
+        return static_cast<uint32_t>(index);
+    }
+    const uint32_t exponent = static_cast<uint32_t>((index - EXACT_BUCKETS) / 4) + 2;
+    const uint32_t sub = static_cast<uint32_t>((index - EXACT_BUCKETS) % 4);
+    const uint32_t width = 1u << (exponent - 2);
+    return ((4 + sub) << (exponent - 2)) + width - 1;
+}
+
+}  // namespace infra
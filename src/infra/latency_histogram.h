@@ -0,0 +1,44 @@
+#ifndef INFRA_LATENCY_HISTOGRAM_H
+#define INFRA_LATENCY_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace infra {
+
+/**
+ * Fixed-size log-linear histogram of microsecond durations. Exact buckets for
+ * 0-3 µs, then four sub-buckets per power of two up to ~4 s, so reported
+ * percentiles are at most 25% above the true value. No allocation; one writer.
+ */
+class LatencyHistogram {
+public:
+    void record(uint32_t micros);
+    void reset();
+
+    uint32_t count() const { return m_count; }
+    uint32_t minUs() const { return m_count ? m_minUs : 0; }
+    uint32_t maxUs() const { return m_maxUs; }
+    uint32_t avgUs() const;
+
+    // perMille: 500 for the median, 990 for p99.
+    uint32_t percentileUs(uint32_t perMille) const;
+
+    static constexpr size_t EXACT_BUCKETS = 4;
+    static constexpr uint32_t MAX_EXPONENT = 21;
+    static constexpr size_t BUCKET_COUNT = EXACT_BUCKETS + (MAX_EXPONENT - 1) * 4;
+
+    static size_t bucketIndex(uint32_t micros);
+    static uint32_t bucketUpperBound(size_t index);
+
+private:
+    uint32_t m_count = 0;
+    uint32_t m_minUs = 0;
+    uint32_t m_maxUs = 0;
+    uint64_t m_totalUs = 0;
+    uint32_t m_buckets[BUCKET_COUNT] = {};
+};
+
+}  // namespace infra
+
+#endif  // INFRA_LATENCY_HISTOGRAM_H
@@ -0,0 +1,485 @@
+#include "infra/log_record.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace infra {
+
+namespace {
+
+enum class Length : uint8_t { None, Char, Short, Long, LongLong, Max, Size, PtrDiff, LongDouble };
+
+enum class ArgKind : uint8_t { Signed, Unsigned, Character, Floating, String, Pointer, Count, Unknown };
+
+// One printf conversion, split into the pieces needed to rebuild it
+struct Spec {
+    const char *flagsBegin;
+    const char *flagsEnd;
+    const char *widthBegin;
+    const char *widthEnd;
+    const char *precisionBegin;
+    const char *precisionEnd;
+    bool widthStar;
+    bool hasPrecision;
+    bool precisionStar;
+    Length length;
+    char conversion;
+    const char *end;  // One past the conversion character
+};
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// p points at the '%' of a conversion that is not "%%"
+bool parseSpec(const char *p, Spec &spec) {
+    ++p;
+    spec.flagsBegin = p;
+    while (*p && strchr("-+ #0", *p)) {
+        ++p;
+    }
+    spec.flagsEnd = p;
+
+    spec.widthStar = *p == '*';
+    spec.widthBegin = p;
+    if (spec.widthStar) {
+        ++p;
+    } else {
+        while (isDigit(*p)) {
+            ++p;
+        }
+    }
+    spec.widthEnd = p;
+
+    spec.hasPrecision = *p == '.';
+    spec.precisionStar = false;
+    spec.precisionBegin = spec.precisionEnd = p;
+    if (spec.hasPrecision) {
+        ++p;
+        spec.precisionStar = *p == '*';
+        spec.precisionBegin = p;
+        if (spec.precisionStar) {
+            ++p;
+        } else {
+            while (isDigit(*p)) {
+                ++p;
+            }
+        }
+        spec.precisionEnd = p;
+    }
+
+    spec.length = Length::None;
+    switch (*p) {
+        case 'h':
+            ++p;
+            spec.length = Length::Short;
+            if (*p == 'h') {
+                ++p;
+                spec.length = Length::Char;
+            }
+            break;
+        case 'l':
+            ++p;
+            spec.length = Length::Long;
+            if (*p == 'l') {
+                ++p;
+                spec.length = Length::LongLong;
+            }
+            break;
+        case 'j': ++p; spec.length = Length::Max; break;
+        case 'z': ++p; spec.length = Length::Size; break;
+        case 't': ++p; spec.length = Length::PtrDiff; break;
+        case 'L': ++p; spec.length = Length::LongDouble; break;
+        default: break;
+    }
+
+    spec.conversion = *p;
+    if (!spec.conversion) {
+        return false;
+    }
+    spec.end = p + 1;
+    return true;
+}
+
+ArgKind kindOf(char conversion) {
+    switch (conversion) {
+        case 'd': case 'i':
+            return ArgKind::Signed;
+        case 'u': case 'o': case 'x': case 'X':
+            return ArgKind::Unsigned;
+        case 'c':
+            return ArgKind::Character;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            return ArgKind::Floating;
+        case 's':
+            return ArgKind::String;
+        case 'p':
+            return ArgKind::Pointer;
+        case 'n':
+            return ArgKind::Count;
+        default:
+            return ArgKind::Unknown;
+    }
+}
+
+class Packer {
+public:
+    Packer(uint8_t *out, size_t capacity) : m_out(out), m_capacity(capacity), m_used(0) {}
+
+    template <typename T>
+    bool put(T value) {
+        if (m_capacity - m_used < sizeof(T)) {
+            return false;
+        }
+        memcpy(m_out + m_used, &value, sizeof(T));
+        m_used += sizeof(T);
+        return true;
+    }
+
+    // False when the string had to be cut short (what fits is still stored)
+    bool putString(const char *text, bool &stored) {
+        stored = false;
+        if (m_capacity - m_used < 2) {
+            return false;
+        }
+        if (!text) {
+            text = "(null)";
+        }
+        size_t length = strnlen(text, LOG_RECORD_MAX_STRING + 1);
+        const bool cut = length > LOG_RECORD_MAX_STRING || length > m_capacity - m_used - 2;
+        length = length < LOG_RECORD_MAX_STRING ? length : LOG_RECORD_MAX_STRING;
+        length = length < m_capacity - m_used - 2 ? length : m_capacity - m_used - 2;
+        m_out[m_used++] = static_cast<uint8_t>(length);
+        memcpy(m_out + m_used, text, length);
+        m_used += length;
+        m_out[m_used++] = '\0';
+        stored = true;
+        return !cut;
+    }
+
+    size_t used() const { return m_used; }
+
+private:
+    uint8_t *m_out;
+    size_t m_capacity;
+    size_t m_used;
+};
+
+class Unpacker {
+public:
+    Unpacker(const uint8_t *data, size_t size) : m_data(data), m_size(size), m_offset(0) {}
+
+    template <typename T>
+    bool get(T &value) {
+        if (m_size - m_offset < sizeof(T)) {
+            return false;
+        }
+        memcpy(&value, m_data + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    bool getString(const char *&text) {
+        if (m_size - m_offset < 2) {
+            return false;
+        }
+        const size_t length = m_data[m_offset];
+        if (m_size - m_offset < length + 2 || m_data[m_offset + 1 + length] != '\0') {
+            return false;
+        }
+        text = reinterpret_cast<const char *>(m_data + m_offset + 1);
+        m_offset += length + 2;
+        return true;
+    }
+
+private:
+    const uint8_t *m_data;
+    size_t m_size;
+    size_t m_offset;
+};
+
+class Output {
+public:
+    Output(char *out, size_t size) : m_out(out), m_size(size), m_length(0) {
+        if (m_size) {
+            m_out[0] = '\0';
+        }
+    }
+
+    void put(char c) {
+        if (m_length + 1 < m_size) {
+            m_out[m_length++] = c;
+            m_out[m_length] = '\0';
+        }
+    }
+
+    void put(const char *text) {
+        while (*text) {
+            put(*text++);
+        }
+    }
+
+    template <typename T>
+    void format(const char *spec, T value) {
+        if (m_length + 1 >= m_size) {
+            return;
+        }
+        const int written = snprintf(m_out + m_length, m_size - m_length, spec, value);
+        if (written > 0) {
+            const size_t room = m_size - m_length - 1;
+            m_length += static_cast<size_t>(written) < room ? static_cast<size_t>(written) : room;
+        }
+    }
+
+    size_t length() const { return m_length; }
+
+private:
+    char *m_out;
+    size_t m_size;
+    size_t m_length;
+};
+
+void appendRange(char *&cursor, const char *limit, const char *begin, const char *end) {
+    while (begin < end && cursor < limit) {
+        *cursor++ = *begin++;
+    }
+}
+
+void appendNumber(char *&cursor, const char *limit, int value) {
+    char digits[16];
+    const int length = snprintf(digits, sizeof(digits), "%d", value);
+    appendRange(cursor, limit, digits, digits + (length > 0 ? length : 0));
+}
+
+}  // namespace
+
+size_t packLogArgs(const char *format, va_list args, uint8_t *out, size_t capacity, bool *truncated) {
+    bool cut = false;
+    Packer packer(out, capacity);
+    va_list ap;
+    va_copy(ap, args);
+
+    const char *p = format;
+    while (p && *p && !cut) {
+        if (*p != '%') {
+            ++p;
+            continue;
+        }
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        Spec spec;
+        if (!parseSpec(p, spec)) {
+            break;
+        }
+        p = spec.end;
+
+        if (spec.widthStar && !packer.put<int32_t>(va_arg(ap, int))) {
+            cut = true;
+            break;
+        }
+        if (spec.precisionStar && !packer.put<int32_t>(va_arg(ap, int))) {
+            cut = true;
+            break;
+        }
+
+        bool ok = true;
+        switch (kindOf(spec.conversion)) {
+            case ArgKind::Signed: {
+                int64_t value;
+                switch (spec.length) {
+                    case Length::Long: value = va_arg(ap, long); break;
+                    case Length::LongLong: value = va_arg(ap, long long); break;
+                    case Length::Max: value = va_arg(ap, intmax_t); break;
+                    case Length::Size: value = static_cast<int64_t>(va_arg(ap, size_t)); break;
+                    case Length::PtrDiff: value = va_arg(ap, ptrdiff_t); break;
+                    // Promoted to int by the call; narrow back as printf would
+                    case Length::Short: value = static_cast<short>(va_arg(ap, int)); break;
+                    case Length::Char: value = static_cast<signed char>(va_arg(ap, int)); break;
+                    default: value = va_arg(ap, int); break;
+                }
+                ok = packer.put(value);
+                break;
+            }
+            case ArgKind::Unsigned: {
+                uint64_t value;
+                switch (spec.length) {
+                    case Length::Long: value = va_arg(ap, unsigned long); break;
+                    case Length::LongLong: value = va_arg(ap, unsigned long long); break;
+                    case Length::Max: value = va_arg(ap, uintmax_t); break;
+                    case Length::Size: value = va_arg(ap, size_t); break;
+                    case Length::PtrDiff: value = static_cast<uint64_t>(va_arg(ap, ptrdiff_t)); break;
+                    case Length::Short: value = static_cast<unsigned short>(va_arg(ap, unsigned int)); break;
+                    case Length::Char: value = static_cast<unsigned char>(va_arg(ap, unsigned int)); break;
+                    default: value = va_arg(ap, unsigned int); break;
+                }
+                ok = packer.put(value);
+                break;
+            }
+            case ArgKind::Character:
+                ok = packer.put<int64_t>(va_arg(ap, int));
+                break;
+            case ArgKind::Floating:
+                ok = packer.put<double>(spec.length == Length::LongDouble
+                                            ? static_cast<double>(va_arg(ap, long double))
+                                            : va_arg(ap, double));
+                break;
+            case ArgKind::String: {
+                bool stored = false;
+                ok = packer.putString(va_arg(ap, const char *), stored);
+                break;
+            }
+            case ArgKind::Pointer:
+                ok = packer.put<uint64_t>(reinterpret_cast<uintptr_t>(va_arg(ap, void *)));
+                break;
+            case ArgKind::Count:
+                (void)va_arg(ap, void *);  // %n is never written through
+                break;
+            case ArgKind::Unknown:
+            default:
+                ok = false;  // The argument's type is unknown, so nothing after it can be read
+                break;
+        }
+        cut = !ok;
+    }
+
+    va_end(ap);
+    if (truncated) {
+        *truncated = cut;
+    }
+    return packer.used();
+}
+
+size_t formatLogArgs(const char *format, const uint8_t *args, size_t argBytes, char *out, size_t size) {
+    Output output(out, size);
+    if (!format) {
+        return 0;
+    }
+    Unpacker unpacker(args, argBytes);
+
+    const char *p = format;
+    while (*p) {
+        if (*p != '%') {
+            output.put(*p++);
+            continue;
+        }
+        if (p[1] == '%') {
+            output.put('%');
+            p += 2;
+            continue;
+        }
+        Spec spec;
+        if (!parseSpec(p, spec)) {
+            output.put(p);
+            break;
+        }
+        p = spec.end;
+
+        // Rebuild the conversion with '*' resolved and a length modifier
+        // matching the packed type
+        char rebuilt[48];
+        char *cursor = rebuilt;
+        const char *limit = rebuilt + sizeof(rebuilt) - 4;
+        bool missing = false;
+        *cursor++ = '%';
+        appendRange(cursor, limit, spec.flagsBegin, spec.flagsEnd);
+        if (spec.widthStar) {
+            int32_t width = 0;
+            missing = !unpacker.get(width);
+            appendNumber(cursor, limit, width);
+        } else {
+            appendRange(cursor, limit, spec.widthBegin, spec.widthEnd);
+        }
+        if (spec.precisionStar) {
+            int32_t precision = 0;
+            missing = !unpacker.get(precision) || missing;
+            if (precision >= 0) {
+                *cursor++ = '.';
+                appendNumber(cursor, limit, precision);
+            }
+        } else if (spec.hasPrecision) {
+            *cursor++ = '.';
+            appendRange(cursor, limit, spec.precisionBegin, spec.precisionEnd);
+        }
+
+        const ArgKind kind = kindOf(spec.conversion);
+        if (kind == ArgKind::Signed || kind == ArgKind::Unsigned) {
+            *cursor++ = 'l';
+            *cursor++ = 'l';
+        }
+        *cursor++ = spec.conversion;
+        *cursor = '\0';
+
+        if (missing) {
+            output.put('?');
+            continue;
+        }
+        switch (kind) {
+            case ArgKind::Signed: {
+                int64_t value;
+                if (unpacker.get(value)) {
+                    output.format(rebuilt, static_cast<long long>(value));
+                } else {
+                    output.put('?');
+                }
+                break;
+            }
+            case ArgKind::Unsigned: {
+                uint64_t value;
+                if (unpacker.get(value)) {
+                    output.format(rebuilt, static_cast<unsigned long long>(value));
+                } else {
+                    output.put('?');
+                }
+                break;
+            }
+            case ArgKind::Character: {
+                int64_t value;
+                if (unpacker.get(value)) {
+                    output.format(rebuilt, static_cast<int>(value));
+                } else {
+                    output.put('?');
+                }
+                break;
+            }
+            case ArgKind::Floating: {
+                double value;
+                if (unpacker.get(value)) {
+                    output.format(rebuilt, value);
+                } else {
+                    output.put('?');
+                }
+                break;
+            }
+            case ArgKind::String: {
+                const char *text = nullptr;
+                if (unpacker.getString(text)) {
+                    output.format(rebuilt, text);
+                } else {
+                    output.put('?');
+                }
+                break;
+            }
+            case ArgKind::Pointer: {
+                uint64_t value;
+                if (unpacker.get(value)) {
+                    output.format(rebuilt, reinterpret_cast<void *>(static_cast<uintptr_t>(value)));
+                } else {
+                    output.put('?');
+                }
+                break;
+            }
+            case ArgKind::Count:
+                break;
+            case ArgKind::Unknown:
+            default:
+                output.put('?');
+                break;
+        }
+    }
+    return output.length();
+}
+
+}  // namespace infra
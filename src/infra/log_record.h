@@ -0,0 +1,64 @@
+#ifndef INFRA_LOG_RECORD_H
+#define INFRA_LOG_RECORD_H
+
+#include <cstdarg>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace infra {
+
+/**
+ * Binary log record: a fixed header followed by the printf arguments packed
+ * as raw values. The format string is kept by pointer, so it must be a
+ * literal (every LOG_* call site and ESP-IDF's own logging pass literals);
+ * %s arguments are the only thing copied, since they often point at
+ * temporaries. Turning a record into text happens later, on the consumer,
+ * by walking the format again against the packed values.
+ *
+ * Packing: integer conversions and %c are stored as 8-byte integers,
+ * floating point as double, %p as an 8-byte address, and %s as a length
+ * byte followed by the characters and a terminating NUL. '*' widths and
+ * precisions are stored as integers in argument order.
+ */
+struct LogRecordHeader {
+    // The first 8 bytes are all a wrap-padding record carries
+    uint32_t stamp;        // Ring position of the record; written last to publish it
+    uint16_t size;         // Header plus arguments, padded to LOG_RECORD_ALIGN
+    uint8_t flags;
+    uint8_t level;
+
+    uint32_t sequence;
+    uint32_t timestampMs;
+    const char *format;
+    uint16_t argBytes;
+    uint8_t tagId;
+    uint8_t reserved;
+};
+
+enum LogRecordFlags : uint8_t {
+    LOG_RECORD_PADDING = 0x01,   // Fills the ring's tail so records never wrap
+    LOG_RECORD_TRUNCATED = 0x02, // Arguments did not all fit
+    LOG_RECORD_RAW = 0x04        // Format carries its own prefix and newline (ESP-IDF lines)
+};
+
+constexpr size_t LOG_RECORD_ALIGN = 8;
+constexpr size_t LOG_RECORD_MAX_ARG_BYTES = 192;
+constexpr size_t LOG_RECORD_MAX_STRING = 120;
+
+constexpr size_t logRecordSize(size_t argBytes) {
+    return (sizeof(LogRecordHeader) + argBytes + LOG_RECORD_ALIGN - 1) & ~(LOG_RECORD_ALIGN - 1);
+}
+
+// Packs the arguments `format` consumes. Returns the bytes written; sets
+// *truncated when an argument did not fit or the format has a conversion
+// that cannot be packed (packing stops there).
+size_t packLogArgs(const char *format, va_list args, uint8_t *out, size_t capacity, bool *truncated);
+
+// Formats `format` against packed arguments into out (always terminated).
+// Conversions past the end of the packed data print as "?". Returns the
+// length written.
+size_t formatLogArgs(const char *format, const uint8_t *args, size_t argBytes, char *out, size_t size);
+
+}  // namespace infra
+
+#endif  // INFRA_LOG_RECORD_H
@@ -0,0 +1,249 @@
+#include "infra/log_record_ring.h"
+
+#include <new>
+#include <string.h>
+
+namespace infra {
+
+namespace {
+
+constexpr size_t MIN_CAPACITY = 1024;
+constexpr size_t PREFIX_BYTES = 8;  // stamp, size, flags, level
+constexpr size_t MAX_RECORD = logRecordSize(LOG_RECORD_MAX_ARG_BYTES);
+
+static_assert(offsetof(LogRecordHeader, stamp) == 0, "stamp leads the record");
+static_assert(offsetof(LogRecordHeader, sequence) == PREFIX_BYTES, "padding records carry only the prefix");
+static_assert(MAX_RECORD <= MIN_CAPACITY / 4, "records must be small next to the ring");
+
+uint16_t prefixSize(const uint8_t *record) {
+    uint16_t size;
+    memcpy(&size, record + offsetof(LogRecordHeader, size), sizeof(size));
+    return size;
+}
+
+uint8_t prefixFlags(const uint8_t *record) {
+    return record[offsetof(LogRecordHeader, flags)];
+}
+
+}  // namespace
+
+LogRecordRing::LogRecordRing()
+    : m_storage(),
+      m_buffer(nullptr),
+      m_capacity(0),
+      m_mask(0),
+      m_policy(Policy::Overwrite),
+      m_head(0),
+      m_lapped(false),
+      m_sequence(0),
+      m_appended(0),
+      m_dropped(0) {
+}
+
+bool LogRecordRing::begin(size_t capacityBytes, Policy policy) {
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < capacityBytes && capacity < (static_cast<size_t>(1) << 30)) {
+        capacity <<= 1;
+    }
+    std::unique_ptr<uint64_t[]> storage(new (std::nothrow) uint64_t[capacity / sizeof(uint64_t)]);
+    if (!storage) {
+        return false;
+    }
+    // 0xFFFFFFFF is odd, so no unwritten slot looks like a published record
+    memset(storage.get(), 0xFF, capacity);
+
+    m_storage = std::move(storage);
+    m_buffer = reinterpret_cast<uint8_t *>(m_storage.get());
+    m_capacity = capacity;
+    m_mask = static_cast<uint32_t>(capacity - 1);
+    m_policy = policy;
+    m_head.store(0, std::memory_order_release);
+    m_lapped.store(false, std::memory_order_release);
+    m_sequence.store(0, std::memory_order_relaxed);
+    m_appended.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+bool LogRecordRing::append(uint8_t level,
+                           uint8_t tagId,
+                           uint32_t timestampMs,
+                           const char *format,
+                           const uint8_t *args,
+                           size_t argBytes,
+                           uint8_t flags) {
+    if (!m_buffer) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (argBytes > LOG_RECORD_MAX_ARG_BYTES) {
+        argBytes = LOG_RECORD_MAX_ARG_BYTES;
+        flags |= LOG_RECORD_TRUNCATED;
+    }
+    const uint32_t size = static_cast<uint32_t>(logRecordSize(argBytes));
+
+    // Claim [start, next): optional padding to the end of the lap, then the record
+    uint32_t start = m_head.load(std::memory_order_relaxed);
+    uint32_t pad;
+    uint32_t next;
+    do {
+        const uint32_t offset = start & m_mask;
+        pad = offset + size > m_capacity ? static_cast<uint32_t>(m_capacity) - offset : 0;
+        if (m_policy == Policy::KeepOldest && static_cast<uint64_t>(start) + pad + size > m_capacity) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        next = start + pad + size;
+    } while (!m_head.compare_exchange_weak(start, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+    if (next - 1 >= m_capacity || next < start) {
+        m_lapped.store(true, std::memory_order_relaxed);
+    }
+
+    if (pad) {
+        uint8_t *record = at(start);
+        storeStamp(start, start + 1);  // Odd stamps never match a position
+        const uint16_t padSize = static_cast<uint16_t>(pad);
+        memcpy(record + offsetof(LogRecordHeader, size), &padSize, sizeof(padSize));
+        record[offsetof(LogRecordHeader, flags)] = LOG_RECORD_PADDING;
+        record[offsetof(LogRecordHeader, level)] = 0;
+        storeStamp(start, start);
+    }
+
+    const uint32_t position = start + pad;
+    storeStamp(position, position + 1);
+    LogRecordHeader header{};
+    header.stamp = position + 1;
+    header.size = static_cast<uint16_t>(size);
+    header.flags = flags;
+    header.level = level;
+    header.sequence = m_sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+    header.timestampMs = timestampMs;
+    header.format = format;
+    header.argBytes = static_cast<uint16_t>(argBytes);
+    header.tagId = tagId;
+    uint8_t *record = at(position);
+    memcpy(record, &header, sizeof(header));
+    if (argBytes) {
+        memcpy(record + sizeof(header), args, argBytes);
+    }
+    storeStamp(position, position);
+    m_appended.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool LogRecordRing::read(Cursor &cursor, Record &record) const {
+    if (!m_buffer) {
+        return false;
+    }
+    // Each pass either returns or moves the cursor forward by at least one
+    // record, so a lap of padding and skips bounds the loop
+    for (size_t pass = 0; pass <= m_capacity / LOG_RECORD_ALIGN; ++pass) {
+        const uint32_t head = m_head.load(std::memory_order_acquire);
+        const uint32_t position = cursor.position;
+        if (position == head) {
+            return false;
+        }
+        if (head - position > m_capacity) {
+            jump(cursor, resync(head - static_cast<uint32_t>(m_capacity), head));
+            continue;
+        }
+        if (loadStamp(position) != position) {
+            if (++cursor.stalls < STALL_LIMIT) {
+                return false;
+            }
+            jump(cursor, resync(position + LOG_RECORD_ALIGN, head));
+            continue;
+        }
+
+        const uint8_t *data = at(position);
+        const uint16_t size = prefixSize(data);
+        const uint32_t offset = position & m_mask;
+        if (size < PREFIX_BYTES || size % LOG_RECORD_ALIGN || offset + size > m_capacity) {
+            jump(cursor, resync(position + LOG_RECORD_ALIGN, head));
+            continue;
+        }
+        if (prefixFlags(data) & LOG_RECORD_PADDING) {
+            cursor.position = position + size;
+            cursor.stalls = 0;
+            continue;
+        }
+        if (size < sizeof(LogRecordHeader) || size > MAX_RECORD) {
+            jump(cursor, resync(position + LOG_RECORD_ALIGN, head));
+            continue;
+        }
+
+        memcpy(&record.header, data, sizeof(LogRecordHeader));
+        size_t argBytes = record.header.argBytes;
+        if (argBytes > size - sizeof(LogRecordHeader)) {
+            argBytes = size - sizeof(LogRecordHeader);
+        }
+        record.header.argBytes = static_cast<uint16_t>(argBytes);
+        memcpy(record.args, data + sizeof(LogRecordHeader), argBytes);
+
+        // Seqlock-style check: if a writer claimed this space while we were
+        // copying, the copy may be torn
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint32_t after = m_head.load(std::memory_order_relaxed);
+        if (after - position > m_capacity) {
+            jump(cursor, resync(after - static_cast<uint32_t>(m_capacity), after));
+            continue;
+        }
+        cursor.position = position + size;
+        cursor.stalls = 0;
+        return true;
+    }
+    return false;
+}
+
+LogRecordRing::Cursor LogRecordRing::oldest() const {
+    Cursor cursor;
+    const uint32_t head = m_head.load(std::memory_order_acquire);
+    if (m_buffer && m_lapped.load(std::memory_order_acquire)) {
+        cursor.position = resync(head - static_cast<uint32_t>(m_capacity), head);
+    }
+    return cursor;
+}
+
+LogRecordRing::Cursor LogRecordRing::newest() const {
+    Cursor cursor;
+    cursor.position = m_head.load(std::memory_order_acquire);
+    return cursor;
+}
+
+size_t LogRecordRing::used() const {
+    if (m_lapped.load(std::memory_order_acquire)) {
+        return m_capacity;
+    }
+    return m_head.load(std::memory_order_acquire);
+}
+
+uint32_t LogRecordRing::loadStamp(uint32_t position) const {
+    return __atomic_load_n(reinterpret_cast<const uint32_t *>(at(position)), __ATOMIC_ACQUIRE);
+}
+
+void LogRecordRing::storeStamp(uint32_t position, uint32_t stamp) {
+    __atomic_store_n(reinterpret_cast<uint32_t *>(at(position)), stamp, __ATOMIC_RELEASE);
+}
+
+uint32_t LogRecordRing::resync(uint32_t position, uint32_t head) const {
+    position = (position + LOG_RECORD_ALIGN - 1) & ~static_cast<uint32_t>(LOG_RECORD_ALIGN - 1);
+    // Bounded by one lap of 8-byte steps
+    while (position != head && head - position <= m_capacity) {
+        if (loadStamp(position) == position) {
+            const uint16_t size = prefixSize(at(position));
+            if (size >= PREFIX_BYTES && size % LOG_RECORD_ALIGN == 0 && (position & m_mask) + size <= m_capacity) {
+                return position;
+            }
+        }
+        position += LOG_RECORD_ALIGN;
+    }
+    return head;
+}
+
+void LogRecordRing::jump(Cursor &cursor, uint32_t position) {
+    cursor.lostBytes += position - cursor.position;
+    cursor.position = position;
+    cursor.stalls = 0;
+}
+
+}  // namespace infra
@@ -0,0 +1,109 @@
+#ifndef INFRA_LOG_RECORD_RING_H
+#define INFRA_LOG_RECORD_RING_H
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infra/log_record.h"
+
+namespace infra {
+
+/**
+ * Lock-free byte ring of binary log records (log_record.h). Any task may
+ * append: a writer claims space by advancing the head with a compare-and-
+ * swap, fills it in, and publishes the record by storing its ring position
+ * into the header's stamp last. Records never straddle the end of the
+ * buffer; the tail of a lap is filled with a padding record instead.
+ *
+ * Readers keep their own Cursor, so any number of consumers (serial, SD,
+ * telnet) drain the same ring independently and never block writers. A
+ * reader copies a record out and then checks the head has not lapped it;
+ * a record overwritten mid-copy is discarded rather than returned torn.
+ * A reader that falls a whole buffer behind skips ahead to the oldest
+ * record still intact and counts the bytes it lost.
+ *
+ * Overwrite rings keep the newest records. KeepOldest rings stop accepting
+ * records once full (the startup log).
+ */
+class LogRecordRing {
+public:
+    enum class Policy : uint8_t { Overwrite, KeepOldest };
+
+    struct Cursor {
+        uint32_t position = 0;
+        uint32_t lostBytes = 0;  // Skipped because writers lapped this reader
+        uint16_t stalls = 0;     // Reads spent waiting on an unpublished record
+    };
+
+    // A record still unpublished after this many reads is skipped (its
+    // writer was preempted for a long time, or the cursor lost sync)
+    static constexpr uint16_t STALL_LIMIT = 256;
+
+    // A record copied out of the ring
+    struct Record {
+        LogRecordHeader header;
+        uint8_t args[LOG_RECORD_MAX_ARG_BYTES];
+    };
+
+    LogRecordRing();
+
+    LogRecordRing(const LogRecordRing &) = delete;
+    LogRecordRing &operator=(const LogRecordRing &) = delete;
+
+    // Allocates the buffer once; capacity is rounded up to a power of two
+    // (minimum 1 KB). Not safe while other tasks are logging.
+    bool begin(size_t capacityBytes, Policy policy = Policy::Overwrite);
+    bool isReady() const { return m_buffer != nullptr; }
+
+    // Returns false when the record was dropped (ring not ready, or a full
+    // KeepOldest ring).
+    bool append(uint8_t level,
+                uint8_t tagId,
+                uint32_t timestampMs,
+                const char *format,
+                const uint8_t *args,
+                size_t argBytes,
+                uint8_t flags);
+
+    // Copies the next record after the cursor and advances it. False when
+    // the reader is caught up (or the next record is still being written).
+    bool read(Cursor &cursor, Record &record) const;
+
+    // Cursor at the oldest intact record, or at the head (only new records)
+    Cursor oldest() const;
+    Cursor newest() const;
+
+    size_t capacity() const { return m_capacity; }
+    // Bytes between the oldest intact data and the head
+    size_t used() const;
+    uint32_t head() const { return m_head.load(std::memory_order_acquire); }
+    uint32_t appended() const { return m_appended.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint32_t lastSequence() const { return m_sequence.load(std::memory_order_relaxed); }
+
+private:
+    uint8_t *at(uint32_t position) const { return m_buffer + (position & m_mask); }
+    uint32_t loadStamp(uint32_t position) const;
+    void storeStamp(uint32_t position, uint32_t stamp);
+    // First record boundary at or after position, found by its stamp
+    uint32_t resync(uint32_t position, uint32_t head) const;
+    static void jump(Cursor &cursor, uint32_t position);
+
+    std::unique_ptr<uint64_t[]> m_storage;  // uint64_t keeps headers aligned
+    uint8_t *m_buffer;
+    size_t m_capacity;
+    uint32_t m_mask;
+    Policy m_policy;
+
+    std::atomic<uint32_t> m_head;
+    std::atomic<bool> m_lapped;  // Head has passed the capacity once
+    std::atomic<uint32_t> m_sequence;
+    std::atomic<uint32_t> m_appended;
+    std::atomic<uint32_t> m_dropped;
+};
+
+}  // namespace infra
+
+#endif  // INFRA_LOG_RECORD_RING_H
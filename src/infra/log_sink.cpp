@@ -1,6 +1,8 @@
 #include "log_sink.h"
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
+#include <strings.h>
 #ifndef UNIT_TEST
 #include "logging_manager.h"
 #endif
@@ -9,6 +11,9 @@ namespace infra {
 
 static ILogSink *g_sink = nullptr;
 
+static const char *const kLevelNames[] = {"verbose", "debug", "info", "warn", "error", "off"};
+static constexpr size_t kLevelCount = sizeof(kLevelNames) / sizeof(kLevelNames[0]);
+
 void setLogSink(ILogSink *sink) {
     g_sink = sink;
 }
@@ -17,22 +22,164 @@ ILogSink *getLogSink() {
     return g_sink;
 }
 
-void emitLog(LogLevel level, const char *tag, const char *fmt, ...) {
-    if (!fmt) {
-        return;
+bool logEnabled(LogLevel level, const char *tag) {
+    if (!logLevelCompiled(level)) {
+        return false;
     }
+    LogTagTable &tags = logTags();
+    const uint8_t value = static_cast<uint8_t>(level);
+    if (!tags.passesFloor(value)) {
+        return false;
+    }
+    return !tags.hasOverrides() || tags.enabled(value, tags.idFor(tag));
+}
+
+static void formatToSink(ILogSink *sink, LogLevel level, const char *tag, const char *fmt, va_list args) {
     char buffer[256];
-    va_list args;
-    va_start(args, fmt);
     vsnprintf(buffer, sizeof(buffer), fmt, args);
-    va_end(args);
+    sink->log(level, tag ? tag : "", buffer);
+}
+
+static void writeLogV(LogLevel level, const char *tag, const char *fmt, va_list args) {
     if (g_sink) {
-        g_sink->log(level, tag ? tag : "", buffer);
+        formatToSink(g_sink, level, tag, fmt, args);
         return;
     }
 #ifndef UNIT_TEST
-    LoggingManager::instance().log(static_cast<::LogLevel>(level), tag ? tag : "", "%s", buffer);
+    // Formatting is deferred: the record keeps fmt and the raw arguments
+    LoggingManager::instance().logv(static_cast<::LogLevel>(level), tag ? tag : "", fmt, args);
 #endif
 }
 
+void logToSinkOrRing(ILogSink *sink, LogLevel level, const char *tag, const char *fmt, va_list args) {
+    if (!fmt) {
+        return;
+    }
+    if (!sink) {
+        sink = g_sink;
+    }
+    if (sink) {
+        formatToSink(sink, level, tag, fmt, args);
+    } else if (logEnabled(level, tag)) {
+        writeLogV(level, tag, fmt, args);
+    }
+}
+
+void emitLog(LogLevel level, const char *tag, const char *fmt, ...) {
+    if (!fmt || !logEnabled(level, tag)) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    writeLogV(level, tag, fmt, args);
+    va_end(args);
+}
+
+void writeLog(LogLevel level, const char *tag, const char *fmt, ...) {
+    if (!fmt) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    writeLogV(level, tag, fmt, args);
+    va_end(args);
+}
+
+void setLogLevel(LogLevel level) {
+    logTags().setDefaultLevel(static_cast<uint8_t>(level));
+}
+
+LogLevel logLevel() {
+    return static_cast<LogLevel>(logTags().defaultLevel());
+}
+
+bool setTagLogLevel(const char *tag, LogLevel level) {
+    return logTags().setLevel(tag, static_cast<uint8_t>(level));
+}
+
+bool clearTagLogLevel(const char *tag) {
+    return logTags().setLevel(tag, LogTagTable::INHERIT);
+}
+
+const char *logLevelName(LogLevel level) {
+    const size_t index = static_cast<size_t>(level);
+    return index < kLevelCount ? kLevelNames[index] : "?";
+}
+
+bool parseLogLevel(const char *text, LogLevel &level) {
+    if (!text || !text[0]) {
+        return false;
+    }
+    for (size_t i = 0; i < kLevelCount; ++i) {
+        const bool letter = text[1] == '\0' && (text[0] | 0x20) == kLevelNames[i][0];
+        if (letter || strcasecmp(text, kLevelNames[i]) == 0) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool runLogLevelCommand(const char *args, const LogLineWriter &write) {
+    char first[LogTagTable::MAX_NAME] = {0};
+    char second[16] = {0};
+    char extra[2] = {0};
+    const int count = args ? sscanf(args, "%23s %15s %1s", first, second, extra) : 0;
+    char line[96];
+    LogTagTable &tags = logTags();
+
+    if (count <= 0) {
+        snprintf(line, sizeof(line), "Log level: %s (compiled minimum %s)",
+                 logLevelName(logLevel()), logLevelName(static_cast<LogLevel>(LOG_MIN_LEVEL)));
+        write(line);
+        for (size_t id = 0; id < tags.size(); ++id) {
+            const uint8_t level = tags.level(static_cast<uint8_t>(id));
+            if (level != LogTagTable::INHERIT) {
+                snprintf(line, sizeof(line), "  %-*s %s", static_cast<int>(LogTagTable::MAX_NAME - 1),
+                         tags.name(static_cast<uint8_t>(id)), logLevelName(static_cast<LogLevel>(level)));
+                write(line);
+            }
+        }
+        return true;
+    }
+
+    LogLevel level;
+    if (count == 1) {
+        if (strcasecmp(first, "reset") == 0) {
+            tags.clearLevels();
+            setLogLevel(LogLevel::Verbose);
+            write("Log levels reset");
+            return true;
+        }
+        if (parseLogLevel(first, level)) {
+            setLogLevel(level);
+            snprintf(line, sizeof(line), "Log level set to %s", logLevelName(level));
+            write(line);
+            return true;
+        }
+    } else if (count == 2) {
+        if (strcasecmp(second, "default") == 0) {
+            if (clearTagLogLevel(first)) {
+                snprintf(line, sizeof(line), "%s follows the default level", first);
+                write(line);
+            } else {
+                snprintf(line, sizeof(line), "Unknown log tag: %s", first);
+                write(line);
+            }
+            return true;
+        }
+        if (parseLogLevel(second, level)) {
+            if (setTagLogLevel(first, level)) {
+                snprintf(line, sizeof(line), "%s log level set to %s", first, logLevelName(level));
+            } else {
+                snprintf(line, sizeof(line), "Unknown log tag: %s", first);
+            }
+            write(line);
+            return true;
+        }
+    }
+    write("Usage: loglevel [<level> | <tag> <level|default> | reset]  (levels: verbose debug info warn error off)");
+    return false;
+}
+
 } // namespace infra
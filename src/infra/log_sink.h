@@ -2,6 +2,15 @@
 #define INFRA_LOG_SINK_H
 
 #include <cstdarg>
+#include <functional>
+
+#include "infra/log_tag_table.h"
+
+// Calls below this level compile to nothing (0 = Verbose ... 4 = Error,
+// 5 = all off). Set per environment in platformio.ini.
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
 
 namespace infra {
 
@@ -10,7 +19,8 @@ enum class LogLevel : unsigned char {
     Debug,
     Info,
     Warn,
-    Error
+    Error,
+    Off  // Filter threshold only; records never carry it
 };
 
 class ILogSink {
@@ -21,8 +31,70 @@ public:
 
 void setLogSink(ILogSink *sink);
 ILogSink *getLogSink();
+
+constexpr bool logLevelCompiled(LogLevel level) {
+    return static_cast<int>(level) >= LOG_MIN_LEVEL;
+}
+
+// Runtime filter, checked before anything is formatted or packed
+inline bool logEnabled(LogLevel level, LogSite &site, const char *tag) {
+    LogTagTable &tags = logTags();
+    const uint8_t value = static_cast<uint8_t>(level);
+    if (!tags.passesFloor(value)) {
+        return false;
+    }
+    return !tags.hasOverrides() || tags.enabled(value, site.idFor(tag));
+}
+bool logEnabled(LogLevel level, const char *tag);
+
+// Filters, then formats for the sink (or hands the record to the logging
+// front end). Arguments are evaluated by the caller either way; the
+// INFRA_LOG/LOG_* macros skip that too when the level is off.
 void emitLog(LogLevel level, const char *tag, const char *fmt, ...);
+// As emitLog without the filter, for callers that already checked it
+void writeLog(LogLevel level, const char *tag, const char *fmt, ...);
+// For classes that take an injected sink: a non-null sink (or else the
+// global one) gets the formatted line, unfiltered, as tests expect.
+// Otherwise the runtime filter applies and fmt and args go to the log ring,
+// which packs each argument on its own and keeps the fmt pointer, so fmt
+// must be a string literal.
+void logToSinkOrRing(ILogSink *sink, LogLevel level, const char *tag, const char *fmt, va_list args);
+
+void setLogLevel(LogLevel level);
+LogLevel logLevel();
+// LogLevel::Off silences the tag; clearTagLogLevel returns it to the default.
+// Both fail for a tag that has not logged yet.
+bool setTagLogLevel(const char *tag, LogLevel level);
+bool clearTagLogLevel(const char *tag);
+
+const char *logLevelName(LogLevel level);
+// Accepts names (verbose..error, off) and their first letters, any case
+bool parseLogLevel(const char *text, LogLevel &level);
+
+// Console "loglevel" command shared by the serial CLI and telnet. args is
+// everything after the command word:
+//   ""                 report the default level and tag overrides
+//   "<level>"          set the default level
+//   "<tag> <level>"    override one tag
+//   "<tag> default"    drop the override
+//   "reset"            default back to Verbose, all overrides cleared
+// Returns false (after writing a usage line) when args do not parse.
+using LogLineWriter = std::function<void(const char *line)>;
+bool runLogLevelCommand(const char *args, const LogLineWriter &write);
 
 } // namespace infra
 
+// Disabled levels drop out at compile time: the call is still type-checked but
+// its arguments are never evaluated and no code is emitted. level must be a
+// constant.
+#define INFRA_LOG(level, tag, fmt, ...)                                              \
+    do {                                                                             \
+        if constexpr (::infra::logLevelCompiled(level)) {                            \
+            static ::infra::LogSite s_logSite;                                       \
+            if (::infra::logEnabled(level, s_logSite, tag)) {                        \
+                ::infra::writeLog(level, tag, fmt, ##__VA_ARGS__);                   \
+            }                                                                        \
+        }                                                                            \
+    } while (0)
+
 #endif // INFRA_LOG_SINK_H
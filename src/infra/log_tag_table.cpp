@@ -0,0 +1,161 @@
+#include "infra/log_tag_table.h"
+
+#include <string.h>
+#include <strings.h>
+
+namespace infra {
+
+LogTagTable::LogTagTable()
+    : m_slots(),
+      m_count(0),
+      m_defaultLevel(0),
+      m_floor(0),
+      m_overrides(false),
+      m_levelGeneration(0) {
+    for (Slot &slot : m_slots) {
+        slot.key.store(nullptr, std::memory_order_relaxed);
+        slot.ready.store(false, std::memory_order_relaxed);
+        slot.level.store(INHERIT, std::memory_order_relaxed);
+        slot.name[0] = '\0';
+    }
+}
+
+uint8_t LogTagTable::idFor(const char *tag) {
+    if (!tag || !tag[0]) {
+        return NO_TAG;
+    }
+    const size_t count = size();
+    for (size_t i = 0; i < count; ++i) {
+        if (m_slots[i].key.load(std::memory_order_acquire) == tag) {
+            return static_cast<uint8_t>(i);
+        }
+    }
+    const uint8_t existing = find(tag);
+    if (existing != NO_TAG) {
+        return existing;
+    }
+
+    const size_t index = m_count.fetch_add(1, std::memory_order_acq_rel);
+    if (index >= MAX_TAGS) {
+        m_count.store(MAX_TAGS, std::memory_order_release);
+        return NO_TAG;
+    }
+    Slot &slot = m_slots[index];
+    strncpy(slot.name, tag, MAX_NAME - 1);
+    slot.name[MAX_NAME - 1] = '\0';
+    slot.key.store(tag, std::memory_order_release);
+    slot.ready.store(true, std::memory_order_release);
+    return static_cast<uint8_t>(index);
+}
+
+uint8_t LogTagTable::find(const char *name) const {
+    if (!name) {
+        return NO_TAG;
+    }
+    const size_t count = size();
+    for (size_t i = 0; i < count; ++i) {
+        const Slot &slot = m_slots[i];
+        if (slot.ready.load(std::memory_order_acquire) && strncasecmp(slot.name, name, MAX_NAME - 1) == 0) {
+            return static_cast<uint8_t>(i);
+        }
+    }
+    return NO_TAG;
+}
+
+const char *LogTagTable::name(uint8_t id) const {
+    if (id >= MAX_TAGS || !m_slots[id].ready.load(std::memory_order_acquire)) {
+        return "?";
+    }
+    return m_slots[id].name;
+}
+
+bool LogTagTable::matches(uint8_t id, const char *tag) const {
+    return id < MAX_TAGS && tag && m_slots[id].key.load(std::memory_order_acquire) == tag;
+}
+
+size_t LogTagTable::size() const {
+    const size_t count = m_count.load(std::memory_order_acquire);
+    return count < MAX_TAGS ? count : MAX_TAGS;
+}
+
+void LogTagTable::setDefaultLevel(uint8_t level) {
+    m_defaultLevel.store(level, std::memory_order_relaxed);
+    refreshFilter();
+}
+
+bool LogTagTable::setLevel(const char *name, uint8_t level) {
+    const uint8_t id = find(name);
+    if (id == NO_TAG) {
+        return false;
+    }
+    m_slots[id].level.store(level, std::memory_order_relaxed);
+    refreshFilter();
+    return true;
+}
+
+uint8_t LogTagTable::level(uint8_t id) const {
+    return id < MAX_TAGS ? m_slots[id].level.load(std::memory_order_relaxed) : INHERIT;
+}
+
+void LogTagTable::clearLevels() {
+    for (Slot &slot : m_slots) {
+        slot.level.store(INHERIT, std::memory_order_relaxed);
+    }
+    refreshFilter();
+}
+
+bool LogTagTable::enabled(uint8_t level, uint8_t id) const {
+    if (!passesFloor(level)) {
+        return false;
+    }
+    if (!hasOverrides()) {
+        return true;  // The floor is the default level
+    }
+    uint8_t threshold = this->level(id);
+    if (threshold == INHERIT) {
+        threshold = defaultLevel();
+    }
+    return level >= threshold;
+}
+
+void LogTagTable::refreshFilter() {
+    // A setter on another task may change a level mid-scan; its bump of the
+    // generation sends this loop round again, so the last store wins with
+    // every change seen
+    uint32_t generation = m_levelGeneration.fetch_add(1, std::memory_order_acq_rel) + 1;
+    for (;;) {
+        uint8_t floor = defaultLevel();
+        bool overrides = false;
+        for (const Slot &slot : m_slots) {
+            const uint8_t level = slot.level.load(std::memory_order_relaxed);
+            if (level != INHERIT) {
+                overrides = true;
+                floor = level < floor ? level : floor;
+            }
+        }
+        m_overrides.store(overrides, std::memory_order_relaxed);
+        m_floor.store(floor, std::memory_order_relaxed);
+        const uint32_t now = m_levelGeneration.load(std::memory_order_acquire);
+        if (now == generation) {
+            return;
+        }
+        generation = now;
+    }
+}
+
+uint8_t LogSite::idFor(const char *tag) {
+    LogTagTable &tags = logTags();
+    uint8_t id = m_id.load(std::memory_order_relaxed);
+    if (!tags.matches(id, tag)) {
+        id = tags.idFor(tag);
+        m_id.store(id, std::memory_order_relaxed);
+    }
+    return id;
+}
+
+LogTagTable &logTags() {
+    static LogTagTable s_tags;
+    return s_tags;
+}
+
+}  // namespace infra
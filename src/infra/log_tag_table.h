@@ -0,0 +1,96 @@
+#ifndef INFRA_LOG_TAG_TABLE_H
+#define INFRA_LOG_TAG_TABLE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace infra {
+
+/**
+ * Interns log tags into small ids so binary log records carry one byte
+ * instead of a string. Names are copied, so a tag only has to live for the
+ * call that registers it. Lookups compare the caller's pointer first (tags
+ * are file-level constants, so this almost always hits) and fall back to the
+ * name, ignoring case so console commands can name tags in any case.
+ * Insertion is lock-free; two tasks registering the same new tag at the
+ * same instant may get two ids for it, which only costs a slot.
+ *
+ * The table also holds the runtime level filter: a default minimum level
+ * plus optional per-tag overrides. enabled() rejects most disabled calls
+ * with one relaxed load of the lowest level any tag accepts, and only
+ * looks at the tag once an override exists.
+ */
+class LogTagTable {
+public:
+    static constexpr size_t MAX_TAGS = 64;
+    static constexpr size_t MAX_NAME = 24;
+    static constexpr uint8_t NO_TAG = 0xFF;   // Table full or no tag given
+    static constexpr uint8_t INHERIT = 0xFF;  // Tag follows the default level
+
+    LogTagTable();
+
+    LogTagTable(const LogTagTable &) = delete;
+    LogTagTable &operator=(const LogTagTable &) = delete;
+
+    uint8_t idFor(const char *tag);
+    // Without registering; NO_TAG when unknown
+    uint8_t find(const char *name) const;
+    // "?" for NO_TAG or an unused id
+    const char *name(uint8_t id) const;
+    // True when id was registered with this exact tag pointer
+    bool matches(uint8_t id, const char *tag) const;
+    size_t size() const;
+
+    // Levels are infra::LogLevel values; anything above Error disables
+    void setDefaultLevel(uint8_t level);
+    uint8_t defaultLevel() const { return m_defaultLevel.load(std::memory_order_relaxed); }
+    // INHERIT clears the override. False when the tag has never logged.
+    bool setLevel(const char *name, uint8_t level);
+    // INHERIT when the tag has no override
+    uint8_t level(uint8_t id) const;
+    void clearLevels();
+
+    bool passesFloor(uint8_t level) const { return level >= m_floor.load(std::memory_order_relaxed); }
+    bool hasOverrides() const { return m_overrides.load(std::memory_order_relaxed); }
+    bool enabled(uint8_t level, uint8_t id) const;
+
+private:
+    struct Slot {
+        std::atomic<const char *> key;
+        std::atomic<bool> ready;
+        std::atomic<uint8_t> level;
+        char name[MAX_NAME];
+    };
+
+    // Recomputes the floor and override flag after a level change
+    void refreshFilter();
+
+    Slot m_slots[MAX_TAGS];
+    std::atomic<size_t> m_count;
+    std::atomic<uint8_t> m_defaultLevel;
+    std::atomic<uint8_t> m_floor;  // Lowest level any tag accepts
+    std::atomic<bool> m_overrides;
+    std::atomic<uint32_t> m_levelGeneration;
+};
+
+/**
+ * Per-call-site cache of a tag id, so filtering by tag does not scan the
+ * table on every call. The cached id is only a hint: it is checked against
+ * the table's tag pointer, so a site whose tag varies stays correct.
+ */
+class LogSite {
+public:
+    constexpr LogSite() : m_id(LogTagTable::NO_TAG) {}
+    uint8_t idFor(const char *tag);
+
+private:
+    std::atomic<uint8_t> m_id;
+};
+
+// Shared by the logging front end and every consumer that formats records
+LogTagTable &logTags();
+
+}  // namespace infra
+
+#endif  // INFRA_LOG_TAG_TABLE_H
@@ -0,0 +1,26 @@
+#ifndef INFRA_PERIODIC_TIMER_H
+#define INFRA_PERIODIC_TIMER_H
+
+#include <stdint.h>
+
+namespace infra {
+
+/**
+ * Fixed-period callback source. Implementations must not call back from a
+ * hard ISR; the callback may take short critical sections and write LEDC.
+ * stop() returns only once no callback is running and none will start, so
+ * the caller may then touch whatever the callback drives.
+ */
+class IPeriodicTimer {
+public:
+    using Callback = void (*)(void *context);
+
+    virtual ~IPeriodicTimer() = default;
+    virtual bool start(uint32_t periodMicros, Callback callback, void *context) = 0;
+    virtual void stop() = 0;
+    virtual bool isRunning() const = 0;
+};
+
+}  // namespace infra
+
+#endif  // INFRA_PERIODIC_TIMER_H
@@ -26,6 +26,33 @@ String SDMMCFile::readStringUntil(char delimiter) {
     return m_file.readStringUntil(delimiter);
 }
 
+size_t SDMMCFile::read(uint8_t *buffer, size_t length) {
+    if (!m_file) {
+        return 0;
+    }
+    return m_file.read(buffer, length);
+}
+
+size_t SDMMCFile::size() {
+    if (!m_file) {
+        return 0;
+    }
+    return m_file.size();
+}
+
+size_t SDMMCFile::write(const uint8_t *buffer, size_t length) {
+    if (!m_file) {
+        return 0;
+    }
+    return m_file.write(buffer, length);
+}
+
+void SDMMCFile::flush() {
+    if (m_file) {
+        m_file.flush();
+    }
+}
+
 void SDMMCFile::close() {
     if (m_file) {
         m_file.close();
@@ -44,4 +71,16 @@ std::unique_ptr<IFile> SDMMCFileSystem::open(const char *path, const char *mode)
     return std::unique_ptr<IFile>(new SDMMCFile(std::move(file)));
 }
 
+bool SDMMCFileSystem::remove(const char *path) {
+    return SD_MMC.remove(path);
+}
+
+bool SDMMCFileSystem::rename(const char *from, const char *to) {
+    return SD_MMC.rename(from, to);
+}
+
+bool SDMMCFileSystem::makeDirectory(const char *path) {
+    return SD_MMC.exists(path) || SD_MMC.mkdir(path);
+}
+
 } // namespace infra
@@ -14,6 +14,10 @@ public:
     bool available() override;
     String readString() override;
     String readStringUntil(char delimiter) override;
+    size_t read(uint8_t *buffer, size_t length) override;
+    size_t size() override;
+    size_t write(const uint8_t *buffer, size_t length) override;
+    void flush() override;
     void close() override;
 
 private:
@@ -27,6 +31,9 @@ public:
 
     bool exists(const char *path) const override;
     std::unique_ptr<IFile> open(const char *path, const char *mode) override;
+    bool remove(const char *path) override;
+    bool rename(const char *from, const char *to) override;
+    bool makeDirectory(const char *path) override;
 };
 
 } // namespace infra
@@ -0,0 +1,203 @@
+#include "string_arena.h"
+
+#include <cstdlib>
+#include <cstring>
+#ifndef UNIT_TEST
+#include <esp_heap_caps.h>
+#endif
+
+namespace infra {
+
+namespace {
+constexpr size_t INITIAL_INDEX_SLOTS = 64;
+}
+
+StringArena::StringArena() : StringArena(DEFAULT_BLOCK_BYTES) {
+}
+
+StringArena::StringArena(size_t blockBytes, ArenaMemory memory)
+    : m_blockBytes(blockBytes < 64 ? 64 : blockBytes),
+      m_memory(memory),
+      m_blocks(),
+      m_cursor(nullptr),
+      m_remaining(0),
+      m_index(),
+      m_indexCount(0),
+      m_indexReleased(false),
+      m_stats() {
+}
+
+const char *StringArena::intern(const char *text, size_t length) {
+    if (!text) {
+        text = "";
+        length = 0;
+    }
+    ++m_stats.strings;
+
+    uint32_t h = 0;
+    size_t slot = 0;
+    if (!m_indexReleased) {
+        if ((m_indexCount + 1) * 2 > m_index.size()) {
+            growIndex();
+        }
+        h = hash(text, length);
+        if (const char *existing = find(text, length, h, slot)) {
+            return existing;
+        }
+    }
+
+    char *copy = allocateBytes(length + 1);
+    if (!copy) {
+        return nullptr;
+    }
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    ++m_stats.uniqueStrings;
+    m_stats.bytesUsed += length + 1;
+
+    if (!m_indexReleased) {
+        m_index[slot] = copy;
+        ++m_indexCount;
+    }
+    return copy;
+}
+
+void StringArena::releaseIndex() {
+    std::vector<const char *>().swap(m_index);
+    m_indexCount = 0;
+    m_indexReleased = true;
+    m_stats.indexBytes = 0;
+}
+
+void StringArena::clear() {
+    m_blocks.clear();
+    m_cursor = nullptr;
+    m_remaining = 0;
+    std::vector<const char *>().swap(m_index);
+    m_indexCount = 0;
+    m_indexReleased = false;
+    m_stats = Stats();
+}
+
+bool StringArena::reserve(size_t bytes) {
+    if (bytes <= m_remaining) {
+        return true;
+    }
+    return startBlock(bytes > m_blockBytes ? bytes : m_blockBytes);
+}
+
+void *StringArena::allocate(size_t bytes, size_t alignment) {
+    const size_t misalignment = reinterpret_cast<uintptr_t>(m_cursor) & (alignment - 1);
+    const size_t padding = misalignment ? alignment - misalignment : 0;
+    if (padding > m_remaining || bytes > m_remaining - padding) {
+        // Anything that does not fit goes to a fresh, malloc-aligned block
+        if (bytes > m_blockBytes / 2) {
+            char *block = newBlock(bytes);
+            m_stats.bytesUsed += block ? bytes : 0;
+            return block;
+        }
+        if (!startBlock(m_blockBytes)) {
+            return nullptr;
+        }
+    } else {
+        m_cursor += padding;
+        m_remaining -= padding;
+    }
+    m_stats.bytesUsed += bytes;
+    return allocateBytes(bytes);
+}
+
+char *StringArena::allocateBytes(size_t bytes) {
+    if (bytes > m_remaining) {
+        if (bytes > m_blockBytes / 2) {
+            // Large allocations get their own block so the current one keeps filling
+            return newBlock(bytes);
+        }
+        if (!startBlock(m_blockBytes)) {
+            return nullptr;
+        }
+    }
+    char *result = m_cursor;
+    m_cursor += bytes;
+    m_remaining -= bytes;
+    return result;
+}
+
+bool StringArena::startBlock(size_t bytes) {
+    char *block = newBlock(bytes);
+    if (!block) {
+        // The current block stays usable for anything that still fits
+        return false;
+    }
+    m_cursor = block;
+    m_remaining = bytes;
+    return true;
+}
+
+char *StringArena::newBlock(size_t bytes) {
+    char *block = nullptr;
+#ifndef UNIT_TEST
+    if (m_memory == ArenaMemory::PreferPsram) {
+        block = static_cast<char *>(heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        m_stats.psramBlocks += block ? 1 : 0;
+    }
+#endif
+    if (!block) {
+        block = static_cast<char *>(std::malloc(bytes));
+    }
+    if (!block) {
+        ++m_stats.failedBlocks;
+        return nullptr;
+    }
+    m_blocks.emplace_back(block);
+    m_stats.bytesReserved += bytes;
+    ++m_stats.blocks;
+    return block;
+}
+
+void StringArena::BlockDeleter::operator()(char *block) const {
+    // heap_caps_malloc memory is released through free() as well
+    std::free(block);
+}
+
+const char *StringArena::find(const char *text, size_t length, uint32_t h, size_t &slot) const {
+    const size_t mask = m_index.size() - 1;
+    for (slot = h & mask; m_index[slot]; slot = (slot + 1) & mask) {
+        const char *candidate = m_index[slot];
+        // strncmp stops at the end of a shorter candidate; memcmp would read past it
+        if (strncmp(candidate, text, length) == 0 && candidate[length] == '\0') {
+            return candidate;
+        }
+    }
+    return nullptr;
+}
+
+void StringArena::growIndex() {
+    std::vector<const char *> old;
+    old.swap(m_index);
+    m_index.assign(old.empty() ? INITIAL_INDEX_SLOTS : old.size() * 2, nullptr);
+    const size_t mask = m_index.size() - 1;
+    for (const char *entry : old) {
+        if (!entry) {
+            continue;
+        }
+        size_t slot = hash(entry, strlen(entry)) & mask;
+        while (m_index[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        m_index[slot] = entry;
+    }
+    m_stats.indexBytes = m_index.size() * sizeof(const char *);
+}
+
+uint32_t StringArena::hash(const char *text, size_t length) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= static_cast<uint8_t>(text[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+} // namespace infra
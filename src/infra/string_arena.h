@@ -0,0 +1,95 @@
+#ifndef INFRA_STRING_ARENA_H
+#define INFRA_STRING_ARENA_H
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+namespace infra {
+
+enum class ArenaMemory : uint8_t {
+    Internal,
+    PreferPsram,  // falls back to internal RAM when no PSRAM is present
+};
+
+/**
+ * Append-only storage for content loaded once and read many times. Strings
+ * are copied into large blocks with a NUL terminator, so each costs its
+ * length plus one byte instead of a heap allocation, and pointers stay valid
+ * until clear(). Small trivially-copyable arrays can be bump-allocated from
+ * the same blocks.
+ *
+ * While the dedup index exists, interning an identical string returns the
+ * existing copy. Call releaseIndex() once loading is done to free it. A
+ * loader can reserve() an estimate of its input up front so most of the load
+ * lands in one contiguous block.
+ *
+ * Running out of memory never aborts: intern() and allocate() return nullptr
+ * and reserve() returns false, so a loader can give up on content that does
+ * not fit and keep running.
+ */
+class StringArena {
+public:
+    struct Stats {
+        size_t strings = 0;        // intern() calls
+        size_t uniqueStrings = 0;  // copies actually stored
+        size_t bytesUsed = 0;
+        size_t bytesReserved = 0;
+        size_t blocks = 0;
+        size_t psramBlocks = 0;
+        size_t indexBytes = 0;
+        size_t failedBlocks = 0;   // block allocations that found no memory
+    };
+
+    static constexpr size_t DEFAULT_BLOCK_BYTES = 1024;
+
+    StringArena();
+    explicit StringArena(size_t blockBytes, ArenaMemory memory = ArenaMemory::Internal);
+    StringArena(StringArena &&) = default;
+    StringArena &operator=(StringArena &&) = default;
+
+    const char *intern(const char *text, size_t length);
+    // Makes sure the next `bytes` of allocations fit in the current block.
+    bool reserve(size_t bytes);
+    void *allocate(size_t bytes, size_t alignment);
+    template <typename T>
+    T *allocateArray(size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+                      "arena memory is never destructed");
+        return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+    }
+    void releaseIndex();
+    void clear();
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    struct BlockDeleter {
+        void operator()(char *block) const;
+    };
+    using Block = std::unique_ptr<char, BlockDeleter>;
+
+    char *allocateBytes(size_t bytes);
+    bool startBlock(size_t bytes);
+    char *newBlock(size_t bytes);
+    const char *find(const char *text, size_t length, uint32_t hash, size_t &slot) const;
+    void growIndex();
+    static uint32_t hash(const char *text, size_t length);
+
+    size_t m_blockBytes;
+    ArenaMemory m_memory;
+    std::vector<Block> m_blocks;
+    char *m_cursor;
+    size_t m_remaining;
+
+    std::vector<const char *> m_index;  // open addressing, power-of-two size
+    size_t m_indexCount;
+    bool m_indexReleased;
+    Stats m_stats;
+};
+
+} // namespace infra
+
+#endif // INFRA_STRING_ARENA_H
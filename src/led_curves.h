@@ -0,0 +1,103 @@
+#ifndef LED_CURVES_H
+#define LED_CURVES_H
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Compile-time LED lookup tables, so effects run on integer lookups instead
+ * of float math.
+ *
+ * GAMMA_Q16 maps a perceived brightness level (0-255) to linear light
+ * (Q16, 0-65535) along the CIE 1931 lightness curve. Equal level steps then
+ * look equally bright, and the dim end gets the fine PWM steps a
+ * high-resolution LEDC channel can give it.
+ *
+ * HALF_COSINE_Q16 is (1 - cos(pi * t)) / 2 sampled at SINE_SEGMENTS + 1
+ * points; halfCosineQ16() interpolates it for the sinusoidal pulse easing.
+ */
+namespace led_curves {
+
+constexpr uint32_t ONE_Q16 = 1u << 16;
+constexpr size_t SINE_SEGMENTS = 64;
+
+namespace detail {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Taylor series; accurate to ~1e-12 over [0, pi], the only range used here
+constexpr double cosine(double x) {
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 16; ++n) {
+        term *= -x * x / static_cast<double>((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr uint32_t roundToUnsigned(double value) {
+    return static_cast<uint32_t>(value + 0.5);
+}
+
+constexpr std::array<uint16_t, 256> makeGamma() {
+    std::array<uint16_t, 256> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        const double lightness = static_cast<double>(i) * 100.0 / 255.0;
+        double luminance = lightness / 903.3;
+        if (lightness > 8.0) {
+            const double f = (lightness + 16.0) / 116.0;
+            luminance = f * f * f;
+        }
+        table[i] = static_cast<uint16_t>(roundToUnsigned(luminance * 65535.0));
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, SINE_SEGMENTS + 1> makeHalfCosine() {
+    std::array<uint32_t, SINE_SEGMENTS + 1> table{};
+    for (size_t i = 0; i <= SINE_SEGMENTS; ++i) {
+        const double t = static_cast<double>(i) / static_cast<double>(SINE_SEGMENTS);
+        table[i] = roundToUnsigned((0.5 - 0.5 * cosine(PI * t)) * static_cast<double>(ONE_Q16));
+    }
+    return table;
+}
+
+}  // namespace detail
+
+inline constexpr std::array<uint16_t, 256> GAMMA_Q16 = detail::makeGamma();
+inline constexpr std::array<uint32_t, SINE_SEGMENTS + 1> HALF_COSINE_Q16 = detail::makeHalfCosine();
+
+static_assert(GAMMA_Q16[0] == 0 && GAMMA_Q16[255] == 65535, "gamma table endpoints");
+static_assert(HALF_COSINE_Q16[0] == 0 && HALF_COSINE_Q16[SINE_SEGMENTS] == ONE_Q16, "half-cosine endpoints");
+static_assert(HALF_COSINE_Q16[SINE_SEGMENTS / 2] == ONE_Q16 / 2, "half-cosine midpoint");
+
+// (1 - cos(pi * t)) / 2 for t in Q16 [0, ONE_Q16]
+inline uint32_t halfCosineQ16(uint32_t t) {
+    if (t >= ONE_Q16) {
+        return ONE_Q16;
+    }
+    constexpr uint32_t SHIFT = 10;  // 65536 / SINE_SEGMENTS
+    static_assert((ONE_Q16 >> SHIFT) == SINE_SEGMENTS, "segment width");
+    const uint32_t index = t >> SHIFT;
+    const uint32_t fraction = t & ((1u << SHIFT) - 1);
+    const uint32_t a = HALF_COSINE_Q16[index];
+    const uint32_t b = HALF_COSINE_Q16[index + 1];
+    return a + (((b - a) * fraction) >> SHIFT);
+}
+
+// PWM duty for a perceived level on a `bits`-wide LEDC channel. With
+// gamma off the level maps linearly, as the original 8-bit output did. A
+// non-zero level never rounds down to dark.
+inline uint32_t levelToDuty(uint8_t level, uint8_t bits, bool gamma = true) {
+    bits = bits < 1 ? 1 : (bits > 16 ? 16 : bits);
+    const uint32_t maxDuty = (1u << bits) - 1;
+    const uint32_t linear = gamma ? GAMMA_Q16[level] : (static_cast<uint32_t>(level) * 65535u + 127u) / 255u;
+    const uint32_t duty = (linear * maxDuty + 32767u) / 65535u;
+    return (level > 0 && duty == 0) ? 1 : duty;
+}
+
+}  // namespace led_curves
+
+#endif  // LED_CURVES_H
@@ -0,0 +1,224 @@
+#include "led_effect_engine.h"
+
+#include <algorithm>
+
+#include "led_curves.h"
+
+LedEffectEngine::Timeline::Timeline()
+    : m_frames(),
+      m_count(0),
+      m_cycleMs(0),
+      m_repeat(1) {
+}
+
+bool LedEffectEngine::Timeline::add(uint32_t atMs, uint8_t level, Easing easing) {
+    if (m_count >= MAX_KEYFRAMES || (m_count > 0 && atMs < m_frames[m_count - 1].atMs)) {
+        return false;
+    }
+    Keyframe &frame = m_frames[m_count++];
+    frame.atMs = atMs;
+    frame.level = level;
+    frame.easing = easing;
+    return true;
+}
+
+uint32_t LedEffectEngine::Timeline::cycleMs() const {
+    const uint32_t lastMs = m_count ? m_frames[m_count - 1].atMs : 0;
+    return std::max<uint32_t>(1, std::max(m_cycleMs, lastMs));
+}
+
+uint32_t LedEffectEngine::Timeline::durationMs() const {
+    if (m_repeat < 0) {
+        return 0;
+    }
+    return cycleMs() * static_cast<uint32_t>(std::max<int16_t>(1, m_repeat));
+}
+
+LedEffectEngine::Timeline LedEffectEngine::Timeline::blink(int count,
+                                                           uint32_t onMs,
+                                                           uint32_t offMs,
+                                                           uint8_t onLevel,
+                                                           uint8_t offLevel) {
+    // One blink per cycle, so the count is not limited by MAX_KEYFRAMES
+    Timeline timeline;
+    onMs = std::max<uint32_t>(1, onMs);
+    timeline.add(0, onLevel);
+    timeline.add(onMs, offLevel);
+    timeline.setCycleMs(onMs + offMs);
+    timeline.setRepeat(static_cast<int16_t>(std::max(1, std::min(count, 1000))));
+    return timeline;
+}
+
+LedEffectEngine::Timeline LedEffectEngine::Timeline::blinkSets(int count,
+                                                               uint32_t onMs,
+                                                               uint32_t offMs,
+                                                               uint32_t restMs,
+                                                               int16_t sets,
+                                                               uint8_t onLevel,
+                                                               uint8_t offLevel) {
+    Timeline timeline;
+    count = std::max(1, std::min(count, static_cast<int>(MAX_KEYFRAMES / 2)));
+    onMs = std::max<uint32_t>(1, onMs);
+    uint32_t at = 0;
+    for (int i = 0; i < count; ++i) {
+        timeline.add(at, onLevel);
+        timeline.add(at + onMs, offLevel);
+        at += onMs + (i + 1 < count ? offMs : restMs);
+    }
+    timeline.setCycleMs(at);
+    timeline.setRepeat(sets < 0 ? REPEAT_FOREVER : std::max<int16_t>(1, sets));
+    return timeline;
+}
+
+LedEffectEngine::Timeline LedEffectEngine::Timeline::pulse(uint8_t minLevel, uint8_t maxLevel, uint32_t periodMs) {
+    Timeline timeline;
+    periodMs = std::max<uint32_t>(2, periodMs);
+    timeline.add(0, minLevel);
+    timeline.add(periodMs / 2, maxLevel, Easing::Sine);
+    timeline.add(periodMs, minLevel, Easing::Sine);
+    timeline.setRepeat(REPEAT_FOREVER);
+    return timeline;
+}
+
+LedEffectEngine::LedEffectEngine(size_t channels, Writer writer, void *context)
+    : m_channels(),
+      m_channelCount(std::min(channels, MAX_CHANNELS)),
+      m_writer(writer),
+      m_context(context) {
+}
+
+void LedEffectEngine::setLevel(uint8_t channel, uint8_t level) {
+    if (channel < m_channelCount) {
+        m_channels[channel].base = level;
+    }
+}
+
+uint8_t LedEffectEngine::baseLevel(uint8_t channel) const {
+    return channel < m_channelCount ? m_channels[channel].base : 0;
+}
+
+bool LedEffectEngine::play(uint8_t channel, Layer layer, const Timeline &timeline, uint32_t startMs) {
+    Slot *slot = slotFor(channel, layer);
+    if (!slot || timeline.size() == 0) {
+        return false;
+    }
+    slot->timeline = timeline;
+    slot->startMs = startMs;
+    slot->cursor = 0;
+    slot->lastCycleMs = 0;
+    slot->active = true;
+    return true;
+}
+
+void LedEffectEngine::stop(uint8_t channel, Layer layer) {
+    Slot *slot = slotFor(channel, layer);
+    if (slot) {
+        slot->active = false;
+    }
+}
+
+bool LedEffectEngine::isActive(uint8_t channel, Layer layer) const {
+    const Slot *slot = slotFor(channel, layer);
+    return slot && slot->active;
+}
+
+void LedEffectEngine::update(uint32_t nowMs) {
+    for (size_t c = 0; c < m_channelCount; ++c) {
+        Channel &channel = m_channels[c];
+        uint8_t level = channel.base;
+        bool covered = false;
+        for (size_t i = EFFECT_LAYERS; i-- > 0;) {
+            Slot &slot = channel.slots[i];
+            if (!slot.active || static_cast<int32_t>(nowMs - slot.startMs) < 0) {
+                continue;
+            }
+            // Layers under the winner still expire on time, they just are not evaluated
+            const uint32_t elapsed = nowMs - slot.startMs;
+            const uint32_t duration = slot.timeline.durationMs();
+            if (duration && elapsed >= duration) {
+                slot.active = false;
+                continue;
+            }
+            if (!covered) {
+                level = evaluate(slot, elapsed);
+                covered = true;
+            }
+        }
+
+        if (!channel.written || level != channel.output) {
+            channel.output = level;
+            channel.written = true;
+            if (m_writer) {
+                m_writer(m_context, static_cast<uint8_t>(c), level);
+            }
+        }
+    }
+}
+
+uint8_t LedEffectEngine::level(uint8_t channel) const {
+    return channel < m_channelCount ? m_channels[channel].output : 0;
+}
+
+uint32_t LedEffectEngine::easeQ16(Easing easing, uint32_t t) {
+    using led_curves::ONE_Q16;
+    t = std::min(t, ONE_Q16);
+    const uint64_t x = t;
+    switch (easing) {
+        case Easing::Step:
+            return t >= ONE_Q16 ? ONE_Q16 : 0;
+        case Easing::EaseIn:
+            return static_cast<uint32_t>((x * x) >> 16);
+        case Easing::EaseOut: {
+            const uint64_t rest = ONE_Q16 - x;
+            return ONE_Q16 - static_cast<uint32_t>((rest * rest) >> 16);
+        }
+        case Easing::EaseInOut:
+            return static_cast<uint32_t>((x * x * (3ull * ONE_Q16 - 2ull * x)) >> 32);
+        case Easing::Sine:
+            return led_curves::halfCosineQ16(t);
+        case Easing::Linear:
+        default:
+            return t;
+    }
+}
+
+LedEffectEngine::Slot *LedEffectEngine::slotFor(uint8_t channel, Layer layer) {
+    if (channel >= m_channelCount || layer == Layer::Base) {
+        return nullptr;
+    }
+    return &m_channels[channel].slots[static_cast<size_t>(layer) - 1];
+}
+
+const LedEffectEngine::Slot *LedEffectEngine::slotFor(uint8_t channel, Layer layer) const {
+    if (channel >= m_channelCount || layer == Layer::Base) {
+        return nullptr;
+    }
+    return &m_channels[channel].slots[static_cast<size_t>(layer) - 1];
+}
+
+uint8_t LedEffectEngine::evaluate(Slot &slot, uint32_t elapsedMs) {
+    const Timeline &timeline = slot.timeline;
+    const uint32_t t = elapsedMs % timeline.cycleMs();
+    if (t < slot.lastCycleMs) {
+        slot.cursor = 0;  // Wrapped into the next cycle
+    }
+    slot.lastCycleMs = t;
+
+    // Time only moves forward within a cycle, so the cursor does too
+    while (slot.cursor + 1 < timeline.size() && timeline[slot.cursor + 1].atMs <= t) {
+        ++slot.cursor;
+    }
+    const Keyframe &from = timeline[slot.cursor];
+    if (slot.cursor + 1 >= timeline.size() || t < from.atMs) {
+        return from.level;
+    }
+    const Keyframe &to = timeline[slot.cursor + 1];
+    if (to.easing == Easing::Step) {
+        return from.level;
+    }
+    const uint32_t progress = static_cast<uint32_t>((static_cast<uint64_t>(t - from.atMs) << 16) / (to.atMs - from.atMs));
+    const int32_t delta = static_cast<int32_t>(to.level) - static_cast<int32_t>(from.level);
+    // Eased value stays between the two levels, so the Q16 sum is never negative
+    const int32_t value = (static_cast<int32_t>(from.level) << 16) + delta * static_cast<int32_t>(easeQ16(to.easing, progress));
+    return static_cast<uint8_t>((value + (1 << 15)) >> 16);
+}
@@ -0,0 +1,138 @@
+#ifndef LED_EFFECT_ENGINE_H
+#define LED_EFFECT_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Non-blocking LED effects. Each channel has a steady base level plus three
+ * priority layers, each of which can play a keyframe timeline. update(now)
+ * shows the highest active layer on every channel and calls the writer only
+ * when a channel's level changes, so it costs O(channels) per call and never
+ * waits on an effect to finish. When a finite effect ends, the layer below
+ * shows through again. Levels are perceived brightness (0-255); the writer
+ * maps them to PWM duty.
+ */
+class LedEffectEngine {
+public:
+    enum class Easing : uint8_t {
+        Step = 0,   // Jump to the keyframe's level when it is reached
+        Linear,
+        EaseIn,
+        EaseOut,
+        EaseInOut,
+        Sine        // Half cosine: a sinusoidal swing between two keyframes
+    };
+
+    // Higher layers win. Base is the steady level set with setLevel().
+    enum class Layer : uint8_t {
+        Base = 0,
+        Ambient,   // Long-running looks (mouth pulse)
+        Notify,    // One-shot attention blinks
+        Alert      // Error patterns
+    };
+
+    static constexpr size_t MAX_CHANNELS = 4;
+    static constexpr size_t MAX_KEYFRAMES = 16;
+    static constexpr int16_t REPEAT_FOREVER = -1;
+
+    struct Keyframe {
+        uint32_t atMs = 0;      // Offset from the start of the cycle
+        uint8_t level = 0;
+        Easing easing = Easing::Step;  // Shapes the ramp from the previous keyframe
+    };
+
+    class Timeline {
+    public:
+        Timeline();
+
+        // Keyframes must be added in time order. Returns false when full or
+        // out of order.
+        bool add(uint32_t atMs, uint8_t level, Easing easing = Easing::Step);
+        // Cycle length; defaults to the last keyframe's time. The last level
+        // holds until the cycle ends.
+        void setCycleMs(uint32_t cycleMs) { m_cycleMs = cycleMs; }
+        void setRepeat(int16_t cycles) { m_repeat = cycles; }
+
+        size_t size() const { return m_count; }
+        const Keyframe &operator[](size_t index) const { return m_frames[index]; }
+        uint32_t cycleMs() const;
+        int16_t repeat() const { return m_repeat; }
+        // Total play time, or 0 for a timeline that repeats forever.
+        uint32_t durationMs() const;
+
+        // count blinks of onMs at onLevel separated by offMs at offLevel,
+        // ending on offLevel.
+        static Timeline blink(int count, uint32_t onMs, uint32_t offMs, uint8_t onLevel, uint8_t offLevel);
+        // Sets of blinks with restMs at offLevel between sets. At most
+        // MAX_KEYFRAMES / 2 blinks per set.
+        static Timeline blinkSets(int count,
+                                  uint32_t onMs,
+                                  uint32_t offMs,
+                                  uint32_t restMs,
+                                  int16_t sets,
+                                  uint8_t onLevel,
+                                  uint8_t offLevel);
+        // Endless sinusoidal swing from minLevel up to maxLevel and back.
+        static Timeline pulse(uint8_t minLevel, uint8_t maxLevel, uint32_t periodMs);
+
+    private:
+        Keyframe m_frames[MAX_KEYFRAMES];
+        size_t m_count;
+        uint32_t m_cycleMs;
+        int16_t m_repeat;
+    };
+
+    using Writer = void (*)(void *context, uint8_t channel, uint8_t level);
+
+    LedEffectEngine(size_t channels, Writer writer, void *context);
+
+    void setLevel(uint8_t channel, uint8_t level);
+    uint8_t baseLevel(uint8_t channel) const;
+
+    // Starts timeline on a layer at startMs (which may be in the future),
+    // replacing whatever that layer was playing. The Base layer only takes
+    // setLevel().
+    bool play(uint8_t channel, Layer layer, const Timeline &timeline, uint32_t startMs);
+    void stop(uint8_t channel, Layer layer);
+    // True while the layer has an effect that has not finished (including
+    // one waiting for its start time). Finished effects clear on update().
+    bool isActive(uint8_t channel, Layer layer) const;
+
+    void update(uint32_t nowMs);
+    uint8_t level(uint8_t channel) const;
+    size_t channels() const { return m_channelCount; }
+
+    // Easing in Q16 fixed point: t and the result run 0..65536. Integer only,
+    // the sine curve comes from a compile-time table (led_curves.h).
+    static uint32_t easeQ16(Easing easing, uint32_t t);
+
+private:
+    static constexpr size_t EFFECT_LAYERS = 3;  // Ambient, Notify, Alert
+
+    struct Slot {
+        Timeline timeline;
+        uint32_t startMs = 0;
+        size_t cursor = 0;      // Keyframe at or before the last evaluated time
+        uint32_t lastCycleMs = 0;
+        bool active = false;
+    };
+
+    struct Channel {
+        uint8_t base = 0;
+        uint8_t output = 0;
+        bool written = false;
+        Slot slots[EFFECT_LAYERS];
+    };
+
+    Slot *slotFor(uint8_t channel, Layer layer);
+    const Slot *slotFor(uint8_t channel, Layer layer) const;
+    static uint8_t evaluate(Slot &slot, uint32_t elapsedMs);
+
+    Channel m_channels[MAX_CHANNELS];
+    size_t m_channelCount;
+    Writer m_writer;
+    void *m_context;
+};
+
+#endif  // LED_EFFECT_ENGINE_H
@@ -1,6 +1,6 @@
 #include "light_controller.h"
 #include <algorithm>
-#include <math.h>
+#include "led_curves.h"
 #include "logging_manager.h"
 #include <cstdio>
 
@@ -12,16 +12,17 @@ LightController::LightController(int eyePin, int mouthPin)
     : _eyePin(eyePin),
       _mouthPin(mouthPin),
       _currentBrightness(BRIGHTNESS_OFF),
+      _pwmBits(PWM_RESOLUTION),
+      _gammaCorrection(true),
       _mouthMode(MouthMode::OFF),
       _mouthBright(PWM_MAX),
+      _mouthAudioLevel(PWM_MAX),
       _mouthPulseMin(40),
       _mouthPulseMax(PWM_MAX),
       _mouthPulsePeriodMs(1500),
-      _mouthLastUpdateMs(0),
-      _mouthPreviousMode(MouthMode::OFF),
-      _mouthBlinkRestorePrevious(false),
-      _mouthBlink{false, 0, 120, 120, 0, false, PWM_MAX, BRIGHTNESS_OFF},
-      _eyePattern{false, false, 0, 0, 100, 100, 700, 0, false, BRIGHTNESS_MAX, BRIGHTNESS_OFF, BRIGHTNESS_MAX, 0} {}
+      _pendingEyeLevel(-1),
+      _pendingMouthAudioLevel(-1),
+      _effects(CHANNEL_COUNT, &LightController::writeChannel, this) {}
 
 // Initializes the LightController
 // Sets up PWM channels and attaches them to the eye and mouth pins
@@ -33,8 +34,9 @@ void LightController::begin()
 
     // Set up PWM channels for eye and mouth LEDs
     // Using the same frequency and resolution for both channels
-    ledcSetup(PWM_CHANNEL_EYE, PWM_FREQUENCY, PWM_RESOLUTION);
-    ledcSetup(PWM_CHANNEL_MOUTH, PWM_FREQUENCY, PWM_RESOLUTION);
+    if (!setupPwmChannels(_pwmBits)) {
+        setupPwmChannels(PWM_RESOLUTION_MIN);
+    }
 
     // Attach the PWM channels to the respective pins
     ledcAttachPin(_eyePin, PWM_CHANNEL_EYE);
@@ -45,23 +47,60 @@ void LightController::begin()
 
     configureMouthLED(PWM_MAX, 40, PWM_MAX, 1500);
     setMouthOff();
+    update();
 }
 
-// Sets the brightness of the eye LED unless an error pattern is active
-void LightController::setEyeBrightness(uint8_t brightness)
+bool LightController::setPwmResolution(uint8_t bits)
 {
-    brightness = constrain(brightness, BRIGHTNESS_OFF, BRIGHTNESS_MAX);
-    if (_eyePattern.active) {
-        _eyePattern.storedNormalBrightness = brightness;
+    if (bits < PWM_RESOLUTION_MIN || bits > PWM_RESOLUTION_MAX) {
+        LOG_WARN(LIGHT_TAG, "PWM resolution %u out of range (%d-%d bits)", bits, PWM_RESOLUTION_MIN, PWM_RESOLUTION_MAX);
+        return false;
+    }
+    if (bits == _pwmBits) {
+        return true;
+    }
+    const uint8_t previous = _pwmBits;
+    if (!setupPwmChannels(bits)) {
+        setupPwmChannels(previous);
+        return false;
+    }
+    // Duty values are resolution-specific, so write both channels again
+    applyEyeBrightness(_effects.level(CHANNEL_EYE), true);
+    applyMouthBrightness(_effects.level(CHANNEL_MOUTH));
+    return true;
+}
+
+uint8_t LightController::getPwmResolution() const
+{
+    return _pwmBits;
+}
+
+void LightController::setGammaCorrection(bool enabled)
+{
+    if (enabled == _gammaCorrection) {
         return;
     }
-    applyEyeBrightness(brightness);
-    _eyePattern.storedNormalBrightness = _currentBrightness;
+    _gammaCorrection = enabled;
+    applyEyeBrightness(_effects.level(CHANNEL_EYE), true);
+    applyMouthBrightness(_effects.level(CHANNEL_MOUTH));
+    LOG_INFO(LIGHT_TAG, "LED gamma correction %s", enabled ? "on" : "off");
+}
+
+bool LightController::isGammaCorrected() const
+{
+    return _gammaCorrection;
+}
+
+// Records the steady brightness of the eye LED; update() applies it, and it
+// shows once no effect covers it
+void LightController::setEyeBrightness(uint8_t brightness)
+{
+    _pendingEyeLevel.store(constrain(brightness, BRIGHTNESS_OFF, BRIGHTNESS_MAX), std::memory_order_relaxed);
 }
 
 bool LightController::isEyePatternActive() const
 {
-    return _eyePattern.active;
+    return _effects.isActive(CHANNEL_EYE, LedEffectEngine::Layer::Alert);
 }
 
 void LightController::startEyeBlinkPattern(int numBlinks,
@@ -73,48 +112,53 @@ void LightController::startEyeBlinkPattern(int numBlinks,
                                            int repeatSets,
                                            const char *label)
 {
-    numBlinks = std::max(1, numBlinks);
-    _eyePattern.active = true;
-    _eyePattern.indefinite = (repeatSets < 0);
-    _eyePattern.setsRemaining = _eyePattern.indefinite ? 0 : std::max(1, repeatSets);
-    _eyePattern.blinksPerSet = numBlinks;
-    _eyePattern.completedBlinks = 0;
-    _eyePattern.onDurationMs = std::max<unsigned long>(10, onDurationMs);
-    _eyePattern.offDurationMs = std::max<unsigned long>(10, offDurationMs);
-    _eyePattern.repeatDelayMs = repeatDelayMs;
-    _eyePattern.nextToggleMs = 0;
-    _eyePattern.isOnPhase = false;
-    _eyePattern.onBrightness = constrain(onBrightness, BRIGHTNESS_OFF, BRIGHTNESS_MAX);
-    _eyePattern.offBrightness = constrain(offBrightness, BRIGHTNESS_OFF, BRIGHTNESS_MAX);
-    _eyePattern.storedNormalBrightness = _currentBrightness;
+    numBlinks = constrain(numBlinks, 1, static_cast<int>(LedEffectEngine::MAX_KEYFRAMES / 2));
+    onDurationMs = std::max<unsigned long>(10, onDurationMs);
+    offDurationMs = std::max<unsigned long>(10, offDurationMs);
+    onBrightness = constrain(onBrightness, BRIGHTNESS_OFF, BRIGHTNESS_MAX);
+    offBrightness = constrain(offBrightness, BRIGHTNESS_OFF, BRIGHTNESS_MAX);
+    const int16_t sets = repeatSets < 0 ? LedEffectEngine::REPEAT_FOREVER
+                                        : static_cast<int16_t>(constrain(repeatSets, 1, INT16_MAX));
+    _effects.play(CHANNEL_EYE,
+                  LedEffectEngine::Layer::Alert,
+                  LedEffectEngine::Timeline::blinkSets(numBlinks,
+                                                       onDurationMs,
+                                                       offDurationMs,
+                                                       repeatDelayMs,
+                                                       sets,
+                                                       onBrightness,
+                                                       offBrightness),
+                  millis());
+    _effects.update(millis());
+
     const char *labelText = (label && label[0]) ? label : "unspecified";
     char repeatBuffer[16];
     const char *repeatDescription;
-    if (_eyePattern.indefinite) {
+    if (sets < 0) {
         repeatDescription = "infinite";
     } else {
-        snprintf(repeatBuffer, sizeof(repeatBuffer), "%d", _eyePattern.setsRemaining);
+        snprintf(repeatBuffer, sizeof(repeatBuffer), "%d", sets);
         repeatDescription = repeatBuffer;
     }
     LOG_INFO(LIGHT_TAG,
              "Eye blink pattern start (%s): blinks=%d on=%lums off=%lums repeats=%s delay=%lums bright=%u/%u",
              labelText,
              numBlinks,
-             _eyePattern.onDurationMs,
-             _eyePattern.offDurationMs,
+             onDurationMs,
+             offDurationMs,
              repeatDescription,
-             _eyePattern.repeatDelayMs,
-             _eyePattern.onBrightness,
-             _eyePattern.offBrightness);
+             repeatDelayMs,
+             onBrightness,
+             offBrightness);
 }
 
 void LightController::stopEyeBlinkPattern()
 {
-    if (!_eyePattern.active) {
+    if (!isEyePatternActive()) {
         return;
     }
-    _eyePattern.active = false;
-    applyEyeBrightness(_eyePattern.storedNormalBrightness);
+    _effects.stop(CHANNEL_EYE, LedEffectEngine::Layer::Alert);
+    _effects.update(millis());
 }
 
 void LightController::configureMouthLED(uint8_t bright, uint8_t pulseMin, uint8_t pulseMax, unsigned long pulsePeriodMs)
@@ -126,27 +170,30 @@ void LightController::configureMouthLED(uint8_t bright, uint8_t pulseMin, uint8_
         std::swap(_mouthPulseMin, _mouthPulseMax);
     }
     _mouthPulsePeriodMs = pulsePeriodMs < 200 ? 200 : pulsePeriodMs; // Prevent hyper-fast pulsing
+    setMouthMode(_mouthMode); // Pick up the new levels in the current mode
 }
 
 void LightController::setMouthOff()
 {
-    _mouthBlink.active = false;
-    _mouthMode = MouthMode::OFF;
-    applyMouthBrightness(BRIGHTNESS_OFF);
+    _effects.stop(CHANNEL_MOUTH, LedEffectEngine::Layer::Notify);
+    setMouthMode(MouthMode::OFF);
 }
 
 void LightController::setMouthBright()
 {
-    _mouthBlink.active = false;
-    _mouthMode = MouthMode::BRIGHT;
-    applyMouthBrightness(_mouthBright);
+    _effects.stop(CHANNEL_MOUTH, LedEffectEngine::Layer::Notify);
+    setMouthMode(MouthMode::BRIGHT);
 }
 
 void LightController::setMouthPulse()
 {
-    _mouthBlink.active = false;
-    _mouthMode = MouthMode::PULSE;
-    _mouthLastUpdateMs = 0;
+    _effects.stop(CHANNEL_MOUTH, LedEffectEngine::Layer::Notify);
+    setMouthMode(MouthMode::PULSE);
+}
+
+void LightController::setMouthAudioLevel(uint8_t level)
+{
+    _pendingMouthAudioLevel.store(level, std::memory_order_relaxed);
 }
 
 void LightController::startMouthBlinkSequence(int numBlinks,
@@ -157,45 +204,58 @@ void LightController::startMouthBlinkSequence(int numBlinks,
                                               const char *label)
 {
     numBlinks = std::max(1, numBlinks);
-    _mouthPreviousMode = _mouthMode == MouthMode::BLINKING ? MouthMode::OFF : _mouthMode;
-    _mouthBlinkRestorePrevious = restorePreviousMode;
-    _mouthMode = MouthMode::BLINKING;
-    _mouthBlink.active = true;
-    _mouthBlink.blinksRemaining = numBlinks;
-    _mouthBlink.onDurationMs = std::max<unsigned long>(10, onDurationMs);
-    _mouthBlink.offDurationMs = std::max<unsigned long>(10, offDurationMs);
-    _mouthBlink.nextToggleMs = 0;
-    _mouthBlink.isOnPhase = false;
-    _mouthBlink.onBrightness = constrain(blinkBrightness, 0, PWM_MAX);
-    _mouthBlink.offBrightness = BRIGHTNESS_OFF;
+    onDurationMs = std::max<unsigned long>(10, onDurationMs);
+    offDurationMs = std::max<unsigned long>(10, offDurationMs);
+    blinkBrightness = constrain(blinkBrightness, 0, PWM_MAX);
+    if (!restorePreviousMode) {
+        // The blink covers the mode underneath; switch it now so the mouth is off afterwards
+        setMouthMode(MouthMode::OFF);
+    }
+    _effects.play(CHANNEL_MOUTH,
+                  LedEffectEngine::Layer::Notify,
+                  LedEffectEngine::Timeline::blink(numBlinks, onDurationMs, offDurationMs, blinkBrightness, BRIGHTNESS_OFF),
+                  millis());
+    _effects.update(millis());
     LOG_INFO(LIGHT_TAG,
              "Mouth blink pattern start (%s): blinks=%d on=%lums off=%lums brightness=%u restore=%s",
              label && label[0] ? label : "unspecified",
              numBlinks,
-             _mouthBlink.onDurationMs,
-             _mouthBlink.offDurationMs,
-             _mouthBlink.onBrightness,
+             onDurationMs,
+             offDurationMs,
+             blinkBrightness,
              restorePreviousMode ? "true" : "false");
 }
 
 bool LightController::isMouthBlinking() const
 {
-    return _mouthBlink.active;
+    return _effects.isActive(CHANNEL_MOUTH, LedEffectEngine::Layer::Notify);
 }
 
 void LightController::update()
 {
-    unsigned long now = millis();
-    if (_mouthMode == MouthMode::PULSE) {
-        updateMouthPulse(now);
-    } else if (_mouthMode == MouthMode::BLINKING) {
-        updateMouthBlink(now);
-    }
+    applyPendingLevels();
+    _effects.update(millis());
+}
 
-    if (_eyePattern.active) {
-        updateEyePattern(now);
+void LightController::applyPendingLevels()
+{
+    // Only the latest request matters, so taking it resets the slot
+    const int16_t eye = _pendingEyeLevel.exchange(-1, std::memory_order_relaxed);
+    if (eye >= 0) {
+        _effects.setLevel(CHANNEL_EYE, static_cast<uint8_t>(eye));
+    }
+    const int16_t mouth = _pendingMouthAudioLevel.exchange(-1, std::memory_order_relaxed);
+    if (mouth >= 0) {
+        const uint8_t level = static_cast<uint8_t>(mouth);
+        if (level != _mouthAudioLevel) {
+            _mouthAudioLevel = level;
+            if (_mouthMode == MouthMode::BRIGHT) {
+                _effects.setLevel(CHANNEL_MOUTH, mouthBrightLevel());
+            }
+        }
     }
 }
+
 // Blinks the eye LED a specified number of times
 // @param numBlinks: Number of times to blink
 // @param onBrightness: Brightness level when eye is on
@@ -203,18 +263,18 @@ void LightController::update()
 void LightController::blinkEyes(int numBlinks, int onBrightness, int offBrightness)
 {
     LOG_INFO(LIGHT_TAG,
-             "Blocking eye blink pattern: blinks=%d bright=%d/%d",
+             "Eye blink: blinks=%d bright=%d/%d",
              numBlinks,
              onBrightness,
              offBrightness);
-    for (int i = 0; i < numBlinks; i++)
-    {
-        setEyeBrightness(onBrightness);
-        delay(200); // Eye on for 100ms
-        setEyeBrightness(offBrightness);
-        delay(200); // Eye off for 100ms
-    }
-    setEyeBrightness(onBrightness); // Ensure eye is on at the end of blinking sequence
+    const uint8_t on = constrain(onBrightness, BRIGHTNESS_OFF, BRIGHTNESS_MAX);
+    const uint8_t off = constrain(offBrightness, BRIGHTNESS_OFF, BRIGHTNESS_MAX);
+    setEyeBrightness(on); // Eye stays on once the blinks finish
+    _effects.play(CHANNEL_EYE,
+                  LedEffectEngine::Layer::Notify,
+                  LedEffectEngine::Timeline::blink(numBlinks, SIMPLE_BLINK_PERIOD_MS / 2, SIMPLE_BLINK_PERIOD_MS / 2, on, off),
+                  millis());
+    _effects.update(millis());
 }
 
 // Blinks the mouth LED a specified number of times
@@ -222,116 +282,94 @@ void LightController::blinkEyes(int numBlinks, int onBrightness, int offBrightne
 void LightController::blinkMouth(int numBlinks)
 {
     LOG_INFO(LIGHT_TAG,
-             "Blocking mouth blink pattern: blinks=%d",
+             "Mouth blink: blinks=%d",
              numBlinks);
-    MouthMode previousMode = _mouthMode;
-    for (int i = 0; i < numBlinks; i++)
-    {
-        applyMouthBrightness(BRIGHTNESS_MAX); // Mouth LED on
-        delay(200); // Mouth LED on for 100ms
-        applyMouthBrightness(BRIGHTNESS_OFF); // Mouth LED off
-        delay(200); // Mouth LED off for 100ms
-    }
-    if (previousMode == MouthMode::BRIGHT) {
-        setMouthBright();
-    } else if (previousMode == MouthMode::PULSE) {
-        setMouthPulse();
-    } else {
-        setMouthOff();
-    }
+    _effects.play(CHANNEL_MOUTH,
+                  LedEffectEngine::Layer::Notify,
+                  LedEffectEngine::Timeline::blink(numBlinks, SIMPLE_BLINK_PERIOD_MS / 2, SIMPLE_BLINK_PERIOD_MS / 2, BRIGHTNESS_MAX, BRIGHTNESS_OFF),
+                  millis());
+    _effects.update(millis());
 }
 
-// Blinks eye and mouth LEDs sequentially with non-blocking delay
+// Blinks eye and mouth LEDs sequentially
 // @param numBlinks: Number of times to blink each (eye first, then mouth after 1000ms delay)
 void LightController::blinkLights(int numBlinks)
 {
     LOG_INFO(LIGHT_TAG,
-             "Blocking combo blink pattern: blinks=%d",
+             "Combo blink: blinks=%d",
              numBlinks);
-    // Start by blinking eye LED
     blinkEyes(numBlinks);
-    
-    // Wait 1000ms using non-blocking delay (using millis() to avoid blocking)
-    unsigned long startTime = millis();
-    while (millis() - startTime < 1000)
-    {
-        yield(); // Allow other tasks to run during wait
-    }
-    
-    // Then blink mouth LED
-    blinkMouth(numBlinks);
+
+    // The mouth timeline is queued to start once the eye is done, plus 1000ms
+    const unsigned long mouthStart = millis() + std::max(1, numBlinks) * SIMPLE_BLINK_PERIOD_MS + 1000;
+    _effects.play(CHANNEL_MOUTH,
+                  LedEffectEngine::Layer::Notify,
+                  LedEffectEngine::Timeline::blink(numBlinks, SIMPLE_BLINK_PERIOD_MS / 2, SIMPLE_BLINK_PERIOD_MS / 2, BRIGHTNESS_MAX, BRIGHTNESS_OFF),
+                  mouthStart);
 }
 
-void LightController::applyMouthBrightness(uint8_t brightness)
+bool LightController::isBlinking() const
 {
-    ledcWrite(PWM_CHANNEL_MOUTH, constrain(brightness, 0, PWM_MAX));
+    return _effects.isActive(CHANNEL_EYE, LedEffectEngine::Layer::Notify) ||
+           _effects.isActive(CHANNEL_MOUTH, LedEffectEngine::Layer::Notify);
 }
 
-void LightController::updateMouthPulse(unsigned long now)
+void LightController::writeChannel(void *context, uint8_t channel, uint8_t level)
 {
-    if (_mouthPulsePeriodMs == 0) {
-        applyMouthBrightness(_mouthPulseMax);
-        return;
+    auto *self = static_cast<LightController *>(context);
+    if (channel == CHANNEL_EYE) {
+        self->applyEyeBrightness(level);
+    } else if (channel == CHANNEL_MOUTH) {
+        self->applyMouthBrightness(level);
     }
+}
 
-    if (_mouthLastUpdateMs != 0 && now - _mouthLastUpdateMs < 15) {
-        return; // Limit update rate to reduce jitter
+void LightController::setMouthMode(MouthMode mode)
+{
+    _mouthMode = mode;
+    if (mode == MouthMode::PULSE) {
+        // Phase follows the clock, so re-entering pulse mode does not restart the swing
+        const unsigned long now = millis();
+        _effects.setLevel(CHANNEL_MOUTH, BRIGHTNESS_OFF);
+        _effects.play(CHANNEL_MOUTH,
+                      LedEffectEngine::Layer::Ambient,
+                      LedEffectEngine::Timeline::pulse(_mouthPulseMin, _mouthPulseMax, _mouthPulsePeriodMs),
+                      now - now % _mouthPulsePeriodMs);
+    } else {
+        _effects.stop(CHANNEL_MOUTH, LedEffectEngine::Layer::Ambient);
+        _effects.setLevel(CHANNEL_MOUTH, mode == MouthMode::BRIGHT ? mouthBrightLevel() : BRIGHTNESS_OFF);
     }
-    _mouthLastUpdateMs = now;
-
-    float phase = static_cast<float>(now % _mouthPulsePeriodMs) / static_cast<float>(_mouthPulsePeriodMs);
-    float angle = phase * TWO_PI;
-    float normalized = (sinf(angle) + 1.0f) * 0.5f; // Range 0..1
-    uint8_t brightness = static_cast<uint8_t>(_mouthPulseMin + normalized * (_mouthPulseMax - _mouthPulseMin));
-    applyMouthBrightness(brightness);
+    _effects.update(millis());
 }
 
-void LightController::updateMouthBlink(unsigned long now)
+uint8_t LightController::mouthBrightLevel() const
 {
-    if (!_mouthBlink.active) {
-        _mouthMode = _mouthBlinkRestorePrevious ? _mouthPreviousMode : MouthMode::OFF;
-        if (_mouthMode == MouthMode::OFF) {
-            applyMouthBrightness(BRIGHTNESS_OFF);
-        } else if (_mouthMode == MouthMode::BRIGHT) {
-            applyMouthBrightness(_mouthBright);
-        } else if (_mouthMode == MouthMode::PULSE) {
-            _mouthLastUpdateMs = 0;
-        }
-        return;
-    }
+    return static_cast<uint8_t>((static_cast<uint32_t>(_mouthBright) * _mouthAudioLevel + PWM_MAX / 2) / PWM_MAX);
+}
 
-    if (_mouthBlink.nextToggleMs != 0 && now < _mouthBlink.nextToggleMs) {
-        return;
+// The LEDC timer tops out at 80 MHz / 2^bits, so wide resolutions lower the frequency
+bool LightController::setupPwmChannels(uint8_t bits)
+{
+    const uint32_t frequency = std::min<uint32_t>(PWM_FREQUENCY, 80000000UL >> bits);
+    if (ledcSetup(PWM_CHANNEL_EYE, frequency, bits) == 0 || ledcSetup(PWM_CHANNEL_MOUTH, frequency, bits) == 0) {
+        LOG_ERROR(LIGHT_TAG, "LEDC setup failed at %u bits / %lu Hz", bits, static_cast<unsigned long>(frequency));
+        return false;
     }
+    _pwmBits = bits;
+    LOG_INFO(LIGHT_TAG, "LED PWM: %u bits at %lu Hz", bits, static_cast<unsigned long>(frequency));
+    return true;
+}
 
-    if (!_mouthBlink.isOnPhase) {
-        applyMouthBrightness(_mouthBlink.onBrightness);
-        _mouthBlink.isOnPhase = true;
-        _mouthBlink.nextToggleMs = now + _mouthBlink.onDurationMs;
-    } else {
-        applyMouthBrightness(_mouthBlink.offBrightness);
-        _mouthBlink.isOnPhase = false;
-        _mouthBlink.nextToggleMs = now + _mouthBlink.offDurationMs;
-        _mouthBlink.blinksRemaining--;
-        if (_mouthBlink.blinksRemaining <= 0) {
-            _mouthBlink.active = false;
-            _mouthMode = _mouthBlinkRestorePrevious ? _mouthPreviousMode : MouthMode::OFF;
-            if (_mouthMode == MouthMode::OFF) {
-                applyMouthBrightness(BRIGHTNESS_OFF);
-            } else if (_mouthMode == MouthMode::BRIGHT) {
-                applyMouthBrightness(_mouthBright);
-            } else if (_mouthMode == MouthMode::PULSE) {
-                _mouthLastUpdateMs = 0;
-            }
-        }
-    }
+void LightController::applyMouthBrightness(uint8_t brightness)
+{
+    ledcWrite(PWM_CHANNEL_MOUTH, led_curves::levelToDuty(brightness, _pwmBits, _gammaCorrection));
 }
 
-void LightController::applyEyeBrightness(uint8_t brightness)
+void LightController::applyEyeBrightness(uint8_t brightness, bool force)
 {
     brightness = constrain(brightness, BRIGHTNESS_OFF, BRIGHTNESS_MAX);
 
-    if (brightness != _currentBrightness)
+    if (brightness != _currentBrightness || force)
     {
         if (brightness == BRIGHTNESS_MAX)
         {
@@ -345,47 +383,8 @@ void LightController::applyEyeBrightness(uint8_t brightness)
             {
                 ledcAttachPin(_eyePin, PWM_CHANNEL_EYE);
             }
-            ledcWrite(PWM_CHANNEL_EYE, brightness);
+            ledcWrite(PWM_CHANNEL_EYE, led_curves::levelToDuty(brightness, _pwmBits, _gammaCorrection));
         }
         _currentBrightness = brightness;
     }
 }
-
-void LightController::updateEyePattern(unsigned long now)
-{
-    if (!_eyePattern.active) {
-        return;
-    }
-
-    if (_eyePattern.nextToggleMs != 0 && now < _eyePattern.nextToggleMs) {
-        return;
-    }
-
-    if (!_eyePattern.isOnPhase) {
-        applyEyeBrightness(_eyePattern.onBrightness);
-        _eyePattern.isOnPhase = true;
-        _eyePattern.nextToggleMs = now + _eyePattern.onDurationMs;
-    } else {
-        applyEyeBrightness(_eyePattern.offBrightness);
-        _eyePattern.isOnPhase = false;
-        _eyePattern.completedBlinks++;
-
-        if (_eyePattern.completedBlinks >= _eyePattern.blinksPerSet) {
-            _eyePattern.completedBlinks = 0;
-            if (_eyePattern.indefinite) {
-                _eyePattern.nextToggleMs = now + _eyePattern.repeatDelayMs;
-            } else {
-                _eyePattern.setsRemaining--;
-                if (_eyePattern.setsRemaining > 0) {
-                    _eyePattern.nextToggleMs = now + _eyePattern.repeatDelayMs;
-                } else {
-                    _eyePattern.active = false;
-                    applyEyeBrightness(_eyePattern.storedNormalBrightness);
-                    return;
-                }
-            }
-        } else {
-            _eyePattern.nextToggleMs = now + _eyePattern.offDurationMs;
-        }
-    }
-}
@@ -2,14 +2,23 @@
 #define LIGHT_CONTROLLER_H
 
 #include <Arduino.h>
+#include <atomic>
+
+#include "led_effect_engine.h"
 
 // PWM configuration constants
-#define PWM_FREQUENCY 5000  // PWM frequency in Hz
-#define PWM_RESOLUTION 8    // PWM resolution in bits
-#define PWM_MAX 255         // Maximum PWM value (2^8 - 1)
+#define PWM_FREQUENCY 5000  // PWM frequency in Hz (lowered when the resolution cannot reach it)
+#define PWM_RESOLUTION 12   // Default PWM resolution in bits
+#define PWM_RESOLUTION_MIN 8
+#define PWM_RESOLUTION_MAX 16
+#define PWM_MAX 255         // Maximum brightness level; duty is looked up per resolution (led_curves.h)
 #define PWM_CHANNEL_EYE 6   // PWM channel for eye LED (moved high to avoid servo collisions)
 #define PWM_CHANNEL_MOUTH 7 // PWM channel for mouth LED (moved high to avoid servo collisions)
 
+// The LED effect engine and the LEDC writes belong to the loop task: call
+// everything here from it, except setEyeBrightness() and
+// setMouthAudioLevel(). Those only record the requested level, which
+// update() applies on its next tick, so the audio callback may call them.
 class LightController
 {
 public:
@@ -26,7 +35,15 @@ public:
     // Initializes the LightController: Sets up PWM channels and attaches them to the eye and mouth pins
     void begin();
 
-    // Sets the brightness of the eye LED
+    // Changes the LEDC resolution (PWM_RESOLUTION_MIN-PWM_RESOLUTION_MAX bits) and
+    // re-applies the current levels. Brightness levels stay 0-255 either way.
+    bool setPwmResolution(uint8_t bits);
+    uint8_t getPwmResolution() const;
+    // Gamma correction maps levels along the perceived-brightness curve (on by default)
+    void setGammaCorrection(bool enabled);
+    bool isGammaCorrected() const;
+
+    // Requests the steady brightness of the eye LED; shown from the next update()
     // @param brightness: uint8_t value between 0 (off) and 255 (max brightness)
     void setEyeBrightness(uint8_t brightness);
     bool isEyePatternActive() const;
@@ -47,6 +64,10 @@ public:
     void setMouthOff();
     void setMouthBright();
     void setMouthPulse();
+    // Scales the BRIGHT mouth level by an audio envelope (0-255) so the mouth
+    // glows with speech; BRIGHTNESS_MAX leaves the configured level as is.
+    // Applied from the next update().
+    void setMouthAudioLevel(uint8_t level);
     void startMouthBlinkSequence(int numBlinks,
                                  unsigned long onDurationMs = 120,
                                  unsigned long offDurationMs = 120,
@@ -55,16 +76,18 @@ public:
                                  const char *label = nullptr);
     bool isMouthBlinking() const;
 
-    // Update function to be called from loop() for animations
+    // Applies requested levels and steps the effects; call once per loop
     void update();
 
-    // Blinks the eye LED a specified number of times
+    // Blinks the eye LED a specified number of times without blocking; the eye
+    // is left at onBrightness afterwards
     // @param numBlinks: Number of times to blink
     // @param onBrightness: Brightness level when eye is on (default: BRIGHTNESS_MAX)
     // @param offBrightness: Brightness level when eye is off (default: BRIGHTNESS_OFF)
     void blinkEyes(int numBlinks, int onBrightness = BRIGHTNESS_MAX, int offBrightness = BRIGHTNESS_OFF);
 
-    // Blinks the mouth LED a specified number of times
+    // Blinks the mouth LED a specified number of times without blocking, then
+    // returns to the current mouth mode
     // @param numBlinks: Number of times to blink
     void blinkMouth(int numBlinks);
 
@@ -72,62 +95,51 @@ public:
     // @param numBlinks: Number of times to blink each (eye first, then mouth after 1000ms delay)
     void blinkLights(int numBlinks);
 
+    // True while a blink started by blinkEyes/blinkMouth/blinkLights is still playing
+    bool isBlinking() const;
+
+    static constexpr unsigned long SIMPLE_BLINK_PERIOD_MS = 400; // One on+off cycle of blinkEyes/blinkMouth
+
 private:
+    enum Channel : uint8_t {
+        CHANNEL_EYE = 0,
+        CHANNEL_MOUTH = 1,
+        CHANNEL_COUNT = 2
+    };
+
     int _eyePin;            // Pin number for the eye LED (GPIO 32)
     int _mouthPin;          // Pin number for the mouth LED (GPIO 33)
     int _currentBrightness; // Current brightness level of the eye LED
+    uint8_t _pwmBits;
+    bool _gammaCorrection;
 
     enum class MouthMode {
         OFF,
         BRIGHT,
-        PULSE,
-        BLINKING
+        PULSE
     };
 
     MouthMode _mouthMode;
     uint8_t _mouthBright;
+    uint8_t _mouthAudioLevel;
     uint8_t _mouthPulseMin;
     uint8_t _mouthPulseMax;
     unsigned long _mouthPulsePeriodMs;
-    unsigned long _mouthLastUpdateMs;
-    MouthMode _mouthPreviousMode;
-    bool _mouthBlinkRestorePrevious;
-
-    struct MouthBlinkState {
-        bool active;
-        int blinksRemaining;
-        unsigned long onDurationMs;
-        unsigned long offDurationMs;
-        unsigned long nextToggleMs;
-        bool isOnPhase;
-        uint8_t onBrightness;
-        uint8_t offBrightness;
-    };
-
-    struct EyePatternState {
-        bool active;
-        bool indefinite;
-        int blinksPerSet;
-        int completedBlinks;
-        unsigned long onDurationMs;
-        unsigned long offDurationMs;
-        unsigned long repeatDelayMs;
-        unsigned long nextToggleMs;
-        bool isOnPhase;
-        uint8_t onBrightness;
-        uint8_t offBrightness;
-        uint8_t storedNormalBrightness;
-        int setsRemaining;
-    };
-
-    MouthBlinkState _mouthBlink;
-    EyePatternState _eyePattern;
-
+    // Levels published by the setters (from any task), -1 once applied
+    std::atomic<int16_t> _pendingEyeLevel;
+    std::atomic<int16_t> _pendingMouthAudioLevel;
+
+    // Base levels, the mouth pulse (Ambient), blinks (Notify) and the eye
+    // error pattern (Alert) all play through one engine
+    LedEffectEngine _effects;
+
+    static void writeChannel(void *context, uint8_t channel, uint8_t level);
+    void setMouthMode(MouthMode mode);
+    void applyPendingLevels();
+    uint8_t mouthBrightLevel() const;
+    bool setupPwmChannels(uint8_t bits);
     void applyMouthBrightness(uint8_t brightness);
-    void updateMouthPulse(unsigned long now);
-    void updateMouthBlink(unsigned long now);
-    void updateEyePattern(unsigned long now);
-    void applyEyeBrightness(uint8_t brightness);
+    void applyEyeBrightness(uint8_t brightness, bool force = false);
 };
 
 #endif // LIGHT_CONTROLLER_H
@@ -1,10 +1,14 @@
 #include "logging_manager.h"
+#include "infra/alloc_tracker.h"
 
 #ifdef ARDUINO
 
-#include <ESPLogger.h>
+#include <algorithm>
+
+#include "infra/log_tag_table.h"
 
 static constexpr const char* TAG = "LoggingManager";
+static constexpr const char* ESP_IDF_TAG = "esp-idf";
 
 LoggingManager& LoggingManager::instance() {
     static LoggingManager s_instance;
@@ -13,133 +17,225 @@ LoggingManager& LoggingManager::instance() {
 
 LoggingManager::LoggingManager()
     : m_serial(nullptr),
-      m_sdLogger(nullptr),
       m_serialForwardingEnabled(true),
-      m_initialized(false),
-      m_capacity(0),
-      m_startupCapacity(0),
-      m_count(0),
-      m_head(0),
-      m_sequence(0),
-      m_bufferMutex(portMUX_INITIALIZER_UNLOCKED) {}
-
-void LoggingManager::begin(HardwareSerial* serial, size_t bufferCapacity, size_t startupCapacity) {
+      m_initialized(false) {}
+
+void LoggingManager::begin(HardwareSerial* serial, size_t bufferBytes, size_t startupBytes) {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Logging);
     m_serial = serial;
-    m_capacity = bufferCapacity;
-    m_startupCapacity = startupCapacity;
-    m_entries.clear();
-    m_entries.resize(bufferCapacity);
-    m_startupEntries.clear();
-    m_startupEntries.reserve(startupCapacity);
-    m_count = 0;
-    m_head = 0;
-    m_sequence = 0;
+    if (!m_ring.begin(bufferBytes) || !m_startup.begin(startupBytes, infra::LogRecordRing::Policy::KeepOldest)) {
+        if (m_serial) {
+            m_serial->println("E/LoggingManager: log buffers could not be allocated");
+        }
+        return;
+    }
+    m_serialCursor = m_ring.newest();
+    m_sdCursor = m_ring.newest();
     m_initialized = true;
 
     esp_log_level_set("*", ESP_LOG_INFO);
     esp_log_set_vprintf(&LoggingManager::vprintfHook);
 
-    LOG_INFO(TAG, "LoggingManager initialized (capacity=%u, startup=%u)", static_cast<unsigned>(bufferCapacity),
-             static_cast<unsigned>(startupCapacity));
-}
+    if (!m_drainTask) {
+        m_drainTask.reset(new infra::FreeRtosPeriodicTask("LogDrain", 4096, 1, 1));
+    }
+    if (!m_drainTask->start(DRAIN_PERIOD_US, &LoggingManager::drainTick, this)) {
+        LOG_ERROR(TAG, "Log drain task failed to start; serial log output is off");
+    }
 
-void LoggingManager::setSdLogger(ESPLogger* logger) {
-    portENTER_CRITICAL(&m_bufferMutex);
-    m_sdLogger = logger;
-    portEXIT_CRITICAL(&m_bufferMutex);
+    LOG_INFO(TAG, "LoggingManager initialized (ring=%u bytes, startup=%u bytes)",
+             static_cast<unsigned>(m_ring.capacity()), static_cast<unsigned>(m_startup.capacity()));
 }
 
 void LoggingManager::enableSerialForwarding(bool enabled) {
-    m_serialForwardingEnabled = enabled;
+    m_serialForwardingEnabled.store(enabled, std::memory_order_release);
 }
 
-void LoggingManager::registerListener(const std::function<void(const LogEntry&)>& listener) {
-    portENTER_CRITICAL(&m_bufferMutex);
-    m_listeners.push_back(listener);
-    portEXIT_CRITICAL(&m_bufferMutex);
+void LoggingManager::drainTick(void* context) {
+    static_cast<LoggingManager*>(context)->pump();
 }
 
-void LoggingManager::getEntriesSince(uint32_t lastSequence, std::vector<LogEntry>& out) const {
-    portENTER_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
-    if (m_count == 0) {
-        portEXIT_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
+void LoggingManager::pump() {
+    if (!m_initialized) {
         return;
     }
-
-    size_t startIndex = (m_head + m_capacity - m_count) % m_capacity;
-    for (size_t i = 0; i < m_count; ++i) {
-        const LogEntry& entry = m_entries[(startIndex + i) % m_capacity];
-        if (entry.sequence > lastSequence && entry.sequence != 0) {
-            out.push_back(entry);
+    infra::LogRecordRing::Record record;
+    char line[LINE_BYTES];
+
+    if (m_serialForwardingEnabled.load(std::memory_order_acquire) && m_serial) {
+        const uint32_t lostBefore = m_serialCursor.lostBytes;
+        for (size_t i = 0; i < PUMP_BATCH && m_ring.read(m_serialCursor, record); ++i) {
+            const size_t length = formatRecord(record, line, sizeof(line));
+            m_serial->write(reinterpret_cast<const uint8_t*>(line), length);
+            m_serial->write('\n');
         }
+        if (m_serialCursor.lostBytes != lostBefore) {
+            m_serial->printf("W/%s: %lu log bytes lost (serial fell behind)\n", TAG,
+                             static_cast<unsigned long>(m_serialCursor.lostBytes - lostBefore));
+        }
+    } else {
+        m_serialCursor = m_ring.newest();
     }
+}
 
-    portEXIT_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
+bool LoggingManager::beginSdLog(infra::IFileSystem* fileSystem, const SdLogWriter::Settings& settings) {
+    if (!m_initialized || !m_sdLog.begin(fileSystem, settings)) {
+        return false;
+    }
+    // Start at the oldest record still in memory, so the boot log lands too
+    m_sdCursor = m_ring.oldest();
+    char path[SdLogWriter::MAX_PATH];
+    m_sdLog.filePath(0, path, sizeof(path));
+    LOG_INFO(TAG, "SD log: %s (%lu bytes, rotating at %lu KB)", path,
+             static_cast<unsigned long>(m_sdLog.fileBytes()),
+             static_cast<unsigned long>(settings.maxFileBytes / 1024));
+    return true;
 }
 
-void LoggingManager::getStartupEntries(std::vector<LogEntry>& out) const {
-    portENTER_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
-    out.insert(out.end(), m_startupEntries.begin(), m_startupEntries.end());
-    portEXIT_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
+void LoggingManager::serviceSdLog(uint32_t nowMs, bool busAvailable) {
+    if (!m_sdLog.isActive()) {
+        return;
+    }
+    infra::LogRecordRing::Record record;
+    char line[LINE_BYTES];
+    const uint32_t lostBefore = m_sdCursor.lostBytes;
+    // Pull only what the block can take; the rest waits in the ring
+    while (m_sdLog.hasRoom() && m_ring.read(m_sdCursor, record)) {
+        m_sdLog.append(line, formatTimestamped(record, line, sizeof(line)), nowMs);
+    }
+    if (m_sdCursor.lostBytes != lostBefore) {
+        const int length = snprintf(line, sizeof(line), "[%lu ms] W/%s: %lu log bytes lost (SD log fell behind)",
+                                    static_cast<unsigned long>(nowMs), TAG,
+                                    static_cast<unsigned long>(m_sdCursor.lostBytes - lostBefore));
+        m_sdLog.append(line, std::min(static_cast<size_t>(length), sizeof(line) - 1), nowMs);
+    }
+    m_sdLog.service(nowMs, busAvailable);
 }
 
-uint32_t LoggingManager::latestSequence() const {
-    portENTER_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
-    uint32_t seq = m_sequence;
-    portEXIT_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
-    return seq;
+void LoggingManager::flushSdLog() {
+    if (!m_sdLog.isActive()) {
+        return;
+    }
+    serviceSdLog(millis(), false);
+    m_sdLog.flush();
 }
 
-size_t LoggingManager::entryCount() const {
-    portENTER_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
-    size_t count = m_count;
-    portEXIT_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
-    return count;
+const infra::LogRecordRing& LoggingManager::ring(Source source) const {
+    return source == Source::Startup ? m_startup : m_ring;
 }
 
-size_t LoggingManager::bufferCapacity() const {
-    return m_capacity;
+infra::LogRecordRing::Cursor LoggingManager::oldestCursor(Source source) const {
+    return ring(source).oldest();
 }
 
-size_t LoggingManager::startupCount() const {
-    portENTER_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
-    size_t count = m_startupEntries.size();
-    portEXIT_CRITICAL(&const_cast<LoggingManager*>(this)->m_bufferMutex);
-    return count;
+infra::LogRecordRing::Cursor LoggingManager::newestCursor() const {
+    return m_ring.newest();
 }
 
-void LoggingManager::log(LogLevel level, const char* tag, const char* fmt, ...) {
-    if (!m_initialized) {
-        return;
+infra::LogRecordRing::Cursor LoggingManager::lastRecordsCursor(size_t count) const {
+    // The ring only walks forward: count what is there, then skip the rest.
+    // Both passes are bounded by the ring size and copy one record at a time.
+    infra::LogRecordRing::Record record;
+    infra::LogRecordRing::Cursor cursor = m_ring.oldest();
+    size_t available = 0;
+    for (infra::LogRecordRing::Cursor probe = cursor; m_ring.read(probe, record);) {
+        ++available;
+    }
+    size_t skip = available > count ? available - count : 0;
+    while (skip > 0 && m_ring.read(cursor, record)) {
+        --skip;
+    }
+    return cursor;
+}
+
+size_t LoggingManager::readLines(Source source, infra::LogRecordRing::Cursor& cursor, size_t maxLines,
+                                 const LineWriter& write) const {
+    if (!m_initialized || !write) {
+        return 0;
+    }
+    const infra::LogRecordRing& from = ring(source);
+    infra::LogRecordRing::Record record;
+    char line[LINE_BYTES];
+    size_t lines = 0;
+    while (lines < maxLines && from.read(cursor, record)) {
+        size_t length = formatTimestamped(record, line, sizeof(line) - 1);
+        line[length++] = '\n';
+        line[length] = '\0';
+        write(line, length);
+        ++lines;
     }
+    return lines;
+}
 
+size_t LoggingManager::bufferUsed() const {
+    return m_ring.used();
+}
+
+size_t LoggingManager::bufferCapacity() const {
+    return m_ring.capacity();
+}
+
+size_t LoggingManager::startupUsed() const {
+    return m_startup.used();
+}
+
+uint32_t LoggingManager::droppedRecords() const {
+    return m_ring.dropped();
+}
+
+void LoggingManager::log(LogLevel level, const char* tag, const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    va_list argsCopy;
-    va_copy(argsCopy, args);
-    int needed = vsnprintf(nullptr, 0, fmt, argsCopy);
-    va_end(argsCopy);
+    logv(level, tag, fmt, args);
+    va_end(args);
+}
 
-    if (needed <= 0) {
-        va_end(args);
+void LoggingManager::logv(LogLevel level, const char* tag, const char* fmt, va_list args) {
+    if (!m_initialized || !fmt) {
         return;
     }
+    append(level, infra::logTags().idFor(tag), fmt, args, 0);
+}
 
-    std::vector<char> buffer(static_cast<size_t>(needed) + 1);
-    vsnprintf(buffer.data(), buffer.size(), fmt, args);
-    va_end(args);
-
-    String message = String(levelToPrefix(level)) + "/" + tag + ": " + String(buffer.data());
-    message.replace("\r", "");
+void LoggingManager::append(LogLevel level, uint8_t tagId, const char* fmt, va_list args, uint8_t flags) {
+    uint8_t packed[infra::LOG_RECORD_MAX_ARG_BYTES];
+    bool truncated = false;
+    const size_t bytes = infra::packLogArgs(fmt, args, packed, sizeof(packed), &truncated);
+    if (truncated) {
+        flags |= infra::LOG_RECORD_TRUNCATED;
+    }
+    const uint32_t now = millis();
+    const uint8_t levelValue = static_cast<uint8_t>(level);
+    m_ring.append(levelValue, tagId, now, fmt, packed, bytes, flags);
+    m_startup.append(levelValue, tagId, now, fmt, packed, bytes, flags);
+}
 
-    if (m_serialForwardingEnabled && m_serial) {
-        m_serial->print(message);
-        if (!message.endsWith("\n")) {
-            m_serial->print("\n");
-        }
+size_t LoggingManager::formatRecord(const infra::LogRecordRing::Record& record, char* out, size_t size) {
+    if (!out || size == 0) {
+        return 0;
+    }
+    size_t length = 0;
+    if (!(record.header.flags & infra::LOG_RECORD_RAW)) {
+        const int written = snprintf(out, size, "%s/%s: ",
+                                     levelToPrefix(static_cast<LogLevel>(record.header.level)),
+                                     infra::logTags().name(record.header.tagId));
+        length = written > 0 ? std::min(static_cast<size_t>(written), size - 1) : 0;
+    }
+    length += infra::formatLogArgs(record.header.format, record.args, record.header.argBytes,
+                                   out + length, size - length);
+    while (length > 0 && (out[length - 1] == '\n' || out[length - 1] == '\r')) {
+        out[--length] = '\0';
     }
+    return length;
+}
 
-    pushLine(level, message);
+size_t LoggingManager::formatTimestamped(const infra::LogRecordRing::Record& record, char* out, size_t size) {
+    if (!out || size == 0) {
+        return 0;
+    }
+    const int prefix = snprintf(out, size, "[%lu ms] ", static_cast<unsigned long>(record.header.timestampMs));
+    const size_t offset = prefix > 0 ? std::min(static_cast<size_t>(prefix), size - 1) : 0;
+    return offset + formatRecord(record, out + offset, size - offset);
 }
 
 int LoggingManager::vprintfHook(const char* fmt, va_list args) {
@@ -152,94 +248,33 @@ int LoggingManager::handleVprintf(const char* fmt, va_list args) {
         char fallback[256];
         int len = vsnprintf(fallback, sizeof(fallback), fmt, args);
         if (len > 0 && m_serial) {
-            m_serial->write(reinterpret_cast<const uint8_t*>(fallback), len);
+            m_serial->write(reinterpret_cast<const uint8_t*>(fallback), std::min<size_t>(len, sizeof(fallback) - 1));
         }
         return len;
     }
-
-    va_list argsCopy;
-    va_copy(argsCopy, args);
-    int needed = vsnprintf(nullptr, 0, fmt, argsCopy);
-    va_end(argsCopy);
-
-    if (needed <= 0) {
-        return needed;
-    }
-
-    std::vector<char> buffer(static_cast<size_t>(needed) + 1);
-    vsnprintf(buffer.data(), buffer.size(), fmt, args);
-
-    String line = String(buffer.data());
-    LogLevel level = inferLevelFromLine(line);
-
-    if (m_serialForwardingEnabled && m_serial) {
-        m_serial->write(reinterpret_cast<const uint8_t*>(buffer.data()), needed);
-    }
-
-    // Remove trailing newline characters
-    while (line.length() > 0 && (line.endsWith("\n") || line.endsWith("\r"))) {
-        line.remove(line.length() - 1);
+    if (!fmt) {
+        return 0;
     }
 
-    if (line.length() > 0) {
-        pushLine(level, line);
+    // ESP-IDF formats are literals that already carry "L (time) tag: " and a newline
+    static uint8_t s_espTagId = infra::logTags().idFor(ESP_IDF_TAG);
+    const LogLevel level = inferLevelFromFormat(fmt);
+    if (!infra::logTags().enabled(static_cast<uint8_t>(level), s_espTagId)) {
+        return 0;
     }
-
-    return needed;
-}
-
-void LoggingManager::pushLine(LogLevel level, const String& line) {
-    LogEntry entry;
-    entry.timestamp = millis();
-    entry.level = level;
-    entry.message = line;
-
-    portENTER_CRITICAL(&m_bufferMutex);
-    entry.sequence = ++m_sequence;
-
-    if (m_capacity == 0) {
-        portEXIT_CRITICAL(&m_bufferMutex);
-        return;
-    }
-
-    m_entries[m_head] = entry;
-    m_head = (m_head + 1) % m_capacity;
-    if (m_count < m_capacity) {
-        ++m_count;
-    }
-
-    if (m_startupEntries.size() < m_startupCapacity) {
-        pushStartup(entry);
-    }
-
-    if (m_sdLogger) {
-        m_sdLogger->append(line.c_str(), true);
-    }
-
-    auto listeners = m_listeners;
-    portEXIT_CRITICAL(&m_bufferMutex);
-
-    for (auto& listener : listeners) {
-        if (listener) {
-            listener(entry);
-        }
-    }
-}
-
-void LoggingManager::pushStartup(const LogEntry& entry) {
-    m_startupEntries.push_back(entry);
+    append(level, s_espTagId, fmt, args, infra::LOG_RECORD_RAW);
+    return 0;
 }
 
-LogLevel LoggingManager::inferLevelFromLine(const String& line) {
-    if (line.length() > 0) {
-        char levelChar = line.charAt(0);
-        if (levelChar == 'E') return LogLevel::Error;
-        if (levelChar == 'W') return LogLevel::Warn;
-        if (levelChar == 'I') return LogLevel::Info;
-        if (levelChar == 'D') return LogLevel::Debug;
-        if (levelChar == 'V') return LogLevel::Verbose;
+LogLevel LoggingManager::inferLevelFromFormat(const char* fmt) {
+    switch (fmt[0]) {
+        case 'E': return LogLevel::Error;
+        case 'W': return LogLevel::Warn;
+        case 'I': return LogLevel::Info;
+        case 'D': return LogLevel::Debug;
+        case 'V': return LogLevel::Verbose;
+        default:  return LogLevel::Info;
     }
-    return LogLevel::Info;
 }
 
 const char* LoggingManager::levelToPrefix(LogLevel level) {
@@ -2,19 +2,25 @@
 #define LOGGING_MANAGER_H
 
 #include <Arduino.h>
+#include <atomic>
 #include <functional>
-#include <vector>
+#include <memory>
 
 #ifdef ARDUINO
 #include <esp_log.h>
+#include "infra/freertos_periodic_task.h"
 #else
 #include <cstdarg>
 using esp_log_level_t = int;
 #endif
 
+#include "infra/log_record_ring.h"
 #include "infra/log_sink.h"
+#include "sd_log_writer.h"
 
-class ESPLogger;
+namespace infra {
+class IFileSystem;
+}
 
 enum class LogLevel : uint8_t {
     Verbose = 0,
@@ -26,71 +32,101 @@ enum class LogLevel : uint8_t {
 
 #ifdef ARDUINO
 
-struct LogEntry {
-    uint32_t timestamp;
-    LogLevel level;
-    String message;
-    uint32_t sequence;
-};
-
+/**
+ * Logging front end. log() packs the format pointer, tag id and raw
+ * arguments into a binary record (infra/log_record.h) in a lock-free ring
+ * and returns; nothing is formatted and nothing is allocated on the
+ * calling task. A low-priority drain task formats records for the serial
+ * port; telnet keeps its own cursor and formats a few lines per update
+ * through readLines(). The SD log reads the
+ * ring with its own cursor from the main loop (serviceSdLog()), where it
+ * shares the card with audio refills. The first startupBytes of records
+ * are also kept in a separate ring that is never overwritten, for
+ * replaying the boot log.
+ */
 class LoggingManager {
 public:
     static LoggingManager& instance();
 
-    void begin(HardwareSerial* serial, size_t bufferCapacity = 2000, size_t startupCapacity = 500);
-    void setSdLogger(ESPLogger* logger);
-    void enableSerialForwarding(bool enabled);
+    static constexpr size_t LINE_BYTES = 256;
 
-    void registerListener(const std::function<void(const LogEntry&)>& listener);
+    void begin(HardwareSerial* serial, size_t bufferBytes = 16384, size_t startupBytes = 8192);
+    void enableSerialForwarding(bool enabled);
 
-    void getEntriesSince(uint32_t lastSequence, std::vector<LogEntry>& out) const;
-    void getStartupEntries(std::vector<LogEntry>& out) const;
-    uint32_t latestSequence() const;
-    size_t entryCount() const;
+    // Formats pending records for serial; runs on the drain task
+    void pump();
+
+    // Persists the log to SD from the oldest record still in the ring.
+    // serviceSdLog() formats new records into the writer's block and writes
+    // it when busAvailable; call it from the task that owns the SD bus.
+    bool beginSdLog(infra::IFileSystem* fileSystem, const SdLogWriter::Settings& settings = SdLogWriter::Settings());
+    void serviceSdLog(uint32_t nowMs, bool busAvailable);
+    // Writes what is buffered regardless of audio (before a reboot)
+    void flushSdLog();
+    const SdLogWriter& sdLog() const { return m_sdLog; }
+
+    // On-demand readers hold a cursor into the rolling or startup ring and
+    // pull from it with readLines(), which formats at most maxLines records
+    // as "[ms ms] L/Tag: message\n" into a stack buffer and hands each line
+    // to write. No lock is taken and nothing is allocated; a cursor that
+    // was lapped skips ahead and counts the loss in lostBytes.
+    enum class Source : uint8_t { Rolling, Startup };
+    using LineWriter = std::function<void(const char* line, size_t length)>;
+
+    infra::LogRecordRing::Cursor oldestCursor(Source source) const;
+    // Only records logged from now on
+    infra::LogRecordRing::Cursor newestCursor() const;
+    // At the last `count` records of the rolling log
+    infra::LogRecordRing::Cursor lastRecordsCursor(size_t count) const;
+    size_t readLines(Source source, infra::LogRecordRing::Cursor& cursor, size_t maxLines,
+                     const LineWriter& write) const;
+
+    size_t bufferUsed() const;
     size_t bufferCapacity() const;
-    size_t startupCount() const;
+    size_t startupUsed() const;
+    uint32_t droppedRecords() const;
 
     void log(LogLevel level, const char* tag, const char* fmt, ...);
+    void logv(LogLevel level, const char* tag, const char* fmt, va_list args);
+
+    // "L/Tag: message", or a raw ESP-IDF line as it was written, without
+    // the trailing newline. Returns the length written.
+    static size_t formatRecord(const infra::LogRecordRing::Record& record, char* out, size_t size);
+    // formatRecord() behind a "[ms ms] " timestamp
+    static size_t formatTimestamped(const infra::LogRecordRing::Record& record, char* out, size_t size);
 
     static int vprintfHook(const char* fmt, va_list args);
 
 private:
     LoggingManager();
 
+    static constexpr size_t PUMP_BATCH = 32;          // Records per consumer per drain tick
+    static constexpr uint32_t DRAIN_PERIOD_US = 20000;
+
+    static void drainTick(void* context);
     int handleVprintf(const char* fmt, va_list args);
-    void pushLine(LogLevel level, const String& line);
-    void pushStartup(const LogEntry& entry);
-    static LogLevel inferLevelFromLine(const String& line);
+    void append(LogLevel level, uint8_t tagId, const char* fmt, va_list args, uint8_t flags);
+    const infra::LogRecordRing& ring(Source source) const;
+    static LogLevel inferLevelFromFormat(const char* fmt);
     static const char* levelToPrefix(LogLevel level);
     static esp_log_level_t toEspLevel(LogLevel level);
 
     HardwareSerial* m_serial;
-    ESPLogger* m_sdLogger;
-    bool m_serialForwardingEnabled;
+    std::atomic<bool> m_serialForwardingEnabled;
     bool m_initialized;
 
-    size_t m_capacity;
-    size_t m_startupCapacity;
-    size_t m_count;
-    size_t m_head;
-    uint32_t m_sequence;
-
-    std::vector<LogEntry> m_entries;
-    std::vector<LogEntry> m_startupEntries;
-    std::vector<std::function<void(const LogEntry&)>> m_listeners;
-
-    portMUX_TYPE m_bufferMutex;
+    infra::LogRecordRing m_ring;
+    infra::LogRecordRing m_startup;
+    // Touched only by the drain task
+    infra::LogRecordRing::Cursor m_serialCursor;
+    std::unique_ptr<infra::FreeRtosPeriodicTask> m_drainTask;
+    // Touched only by the task calling serviceSdLog()
+    infra::LogRecordRing::Cursor m_sdCursor;
+    SdLogWriter m_sdLog;
 };
 
 #else  // !ARDUINO
 
-struct LogEntry {
-    uint32_t timestamp = 0;
-    LogLevel level = LogLevel::Info;
-    String message;
-    uint32_t sequence = 0;
-};
-
 class LoggingManager {
 public:
     static LoggingManager& instance() {
@@ -99,32 +135,43 @@ public:
     }
 
     void begin(HardwareSerial*, size_t = 0, size_t = 0) {}
-    void setSdLogger(ESPLogger*) {}
     void enableSerialForwarding(bool) {}
+    void pump() {}
+
+    bool beginSdLog(infra::IFileSystem*, const SdLogWriter::Settings& = SdLogWriter::Settings()) { return false; }
+    void serviceSdLog(uint32_t, bool) {}
+    void flushSdLog() {}
+    const SdLogWriter& sdLog() const { return m_sdLog; }
 
-    void registerListener(const std::function<void(const LogEntry&)>&) {}
+    enum class Source : uint8_t { Rolling, Startup };
+    using LineWriter = std::function<void(const char*, size_t)>;
 
-    void getEntriesSince(uint32_t, std::vector<LogEntry>&) const {}
-    void getStartupEntries(std::vector<LogEntry>&) const {}
-    uint32_t latestSequence() const { return 0; }
-    size_t entryCount() const { return 0; }
+    infra::LogRecordRing::Cursor oldestCursor(Source) const { return infra::LogRecordRing::Cursor(); }
+    infra::LogRecordRing::Cursor newestCursor() const { return infra::LogRecordRing::Cursor(); }
+    infra::LogRecordRing::Cursor lastRecordsCursor(size_t) const { return infra::LogRecordRing::Cursor(); }
+    size_t readLines(Source, infra::LogRecordRing::Cursor&, size_t, const LineWriter&) const { return 0; }
+    size_t bufferUsed() const { return 0; }
     size_t bufferCapacity() const { return 0; }
-    size_t startupCount() const { return 0; }
+    size_t startupUsed() const { return 0; }
+    uint32_t droppedRecords() const { return 0; }
 
     void log(LogLevel, const char*, const char*, ...) {}
+    void logv(LogLevel, const char*, const char*, va_list) {}
 
     static int vprintfHook(const char*, va_list) { return 0; }
 
 private:
     LoggingManager() = default;
+
+    SdLogWriter m_sdLog;
 };
 
 #endif  // ARDUINO
 
-#define LOG_VERBOSE(tag, fmt, ...) do { infra::emitLog(infra::LogLevel::Verbose, tag, fmt, ##__VA_ARGS__); } while (0)
-#define LOG_DEBUG(tag, fmt, ...)   do { infra::emitLog(infra::LogLevel::Debug, tag, fmt, ##__VA_ARGS__); } while (0)
-#define LOG_INFO(tag, fmt, ...)    do { infra::emitLog(infra::LogLevel::Info, tag, fmt, ##__VA_ARGS__); } while (0)
-#define LOG_WARN(tag, fmt, ...)    do { infra::emitLog(infra::LogLevel::Warn, tag, fmt, ##__VA_ARGS__); } while (0)
-#define LOG_ERROR(tag, fmt, ...)   do { infra::emitLog(infra::LogLevel::Error, tag, fmt, ##__VA_ARGS__); } while (0)
+#define LOG_VERBOSE(tag, fmt, ...) INFRA_LOG(infra::LogLevel::Verbose, tag, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(tag, fmt, ...)   INFRA_LOG(infra::LogLevel::Debug, tag, fmt, ##__VA_ARGS__)
+#define LOG_INFO(tag, fmt, ...)    INFRA_LOG(infra::LogLevel::Info, tag, fmt, ##__VA_ARGS__)
+#define LOG_WARN(tag, fmt, ...)    INFRA_LOG(infra::LogLevel::Warn, tag, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(tag, fmt, ...)   INFRA_LOG(infra::LogLevel::Error, tag, fmt, ##__VA_ARGS__)
 
 #endif // LOGGING_MANAGER_H
@@ -0,0 +1,367 @@
+#include "logo_raster.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "infra/log_sink.h"
+
+namespace {
+constexpr const char *kTag = "LogoRaster";
+constexpr size_t BMP_FILE_HEADER_BYTES = 14;
+constexpr size_t BMP_INFO_HEADER_BYTES = 40;
+
+constexpr uint8_t BAYER_8X8[8][8] = {
+    {0, 32, 8, 40, 2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44, 4, 36, 14, 46, 6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    {3, 35, 11, 43, 1, 33, 9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47, 7, 39, 13, 45, 5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+uint16_t readLE16(const uint8_t *data) {
+    return static_cast<uint16_t>(data[0]) |
+           static_cast<uint16_t>(data[1]) << 8;
+}
+
+uint32_t readLE32(const uint8_t *data) {
+    return static_cast<uint32_t>(data[0]) |
+           (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) |
+           (static_cast<uint32_t>(data[3]) << 24);
+}
+
+void writeLE16(uint8_t *out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value & 0xFF);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void writeLE32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint8_t gray(uint8_t b, uint8_t g, uint8_t r) {
+    // BT.601 weights without floating point
+    return static_cast<uint8_t>((static_cast<uint32_t>(r) * 30 +
+                                 static_cast<uint32_t>(g) * 59 +
+                                 static_cast<uint32_t>(b) * 11 + 50) / 100);
+}
+
+// Area-weighted resample of one line. Source pixel i covers [i*dn, (i+1)*dn)
+// and output pixel o covers [o*sn, (o+1)*sn), so overlaps sum to sn.
+void resampleLine(const uint8_t *src, uint16_t sn, uint8_t *dst, uint16_t dn) {
+    if (sn == dn) {
+        std::memcpy(dst, src, sn);
+        return;
+    }
+    for (uint32_t o = 0; o < dn; ++o) {
+        const uint32_t start = o * sn;
+        const uint32_t end = start + sn;
+        uint32_t sum = 0;
+        for (uint32_t i = start / dn; i * dn < end; ++i) {
+            const uint32_t overlap = std::min(end, (i + 1) * dn) - std::max(start, i * dn);
+            sum += static_cast<uint32_t>(src[i]) * overlap;
+        }
+        dst[o] = static_cast<uint8_t>((sum + sn / 2) / sn);
+    }
+}
+}  // namespace
+
+BmpGraySource::BmpGraySource(ReadAt readAt)
+    : m_readAt(std::move(readAt)),
+      m_width(0),
+      m_height(0),
+      m_bitsPerPixel(0),
+      m_bottomUp(true),
+      m_dataOffset(0),
+      m_strideBytes(0),
+      m_palette(),
+      m_row() {
+}
+
+bool BmpGraySource::open() {
+    uint8_t header[BMP_FILE_HEADER_BYTES + BMP_INFO_HEADER_BYTES];
+    if (!m_readAt || m_readAt(0, header, sizeof(header)) != sizeof(header)) {
+        infra::emitLog(infra::LogLevel::Error, kTag, "Bitmap header too short");
+        return false;
+    }
+    if (header[0] != 'B' || header[1] != 'M') {
+        infra::emitLog(infra::LogLevel::Error, kTag, "Bitmap signature mismatch (expected BM)");
+        return false;
+    }
+
+    m_dataOffset = readLE32(header + 10);
+    const uint32_t dibHeaderSize = readLE32(header + 14);
+    const int32_t width = static_cast<int32_t>(readLE32(header + 18));
+    const int32_t height = static_cast<int32_t>(readLE32(header + 22));
+    const uint16_t planes = readLE16(header + 26);
+    m_bitsPerPixel = readLE16(header + 28);
+    const uint32_t compression = readLE32(header + 30);
+    uint32_t colorsUsed = readLE32(header + 46);
+
+    if (dibHeaderSize < BMP_INFO_HEADER_BYTES) {
+        infra::emitLog(infra::LogLevel::Error, kTag,
+                       "Unsupported BMP DIB header size: %u", static_cast<unsigned>(dibHeaderSize));
+        return false;
+    }
+    if (planes != 1 || compression != 0) {
+        infra::emitLog(infra::LogLevel::Error, kTag,
+                       "Unsupported BMP layout (planes=%u compression=%u)",
+                       static_cast<unsigned>(planes), static_cast<unsigned>(compression));
+        return false;
+    }
+    if (m_bitsPerPixel != 1 && m_bitsPerPixel != 4 && m_bitsPerPixel != 8 &&
+        m_bitsPerPixel != 24 && m_bitsPerPixel != 32) {
+        infra::emitLog(infra::LogLevel::Error, kTag,
+                       "Unsupported BMP depth: %u bpp", static_cast<unsigned>(m_bitsPerPixel));
+        return false;
+    }
+
+    const int32_t absWidth = width < 0 ? -width : width;
+    const int32_t absHeight = height < 0 ? -height : height;
+    if (absWidth <= 0 || absHeight <= 0 || absWidth > MAX_DIMENSION || absHeight > MAX_DIMENSION) {
+        infra::emitLog(infra::LogLevel::Error, kTag,
+                       "Invalid BMP dimensions: %ldx%ld", static_cast<long>(width), static_cast<long>(height));
+        return false;
+    }
+    m_width = static_cast<uint16_t>(absWidth);
+    m_height = static_cast<uint16_t>(absHeight);
+    m_bottomUp = height > 0;
+    m_strideBytes = ((static_cast<uint32_t>(m_width) * m_bitsPerPixel + 31) / 32) * 4;
+
+    if (m_bitsPerPixel <= 8) {
+        const uint32_t maxColors = 1u << m_bitsPerPixel;
+        if (colorsUsed == 0 || colorsUsed > maxColors) {
+            colorsUsed = maxColors;
+        }
+        uint8_t entries[256 * 4];
+        const uint32_t paletteOffset = BMP_FILE_HEADER_BYTES + dibHeaderSize;
+        const size_t paletteBytes = colorsUsed * 4;
+        if (m_readAt(paletteOffset, entries, paletteBytes) != paletteBytes) {
+            infra::emitLog(infra::LogLevel::Error, kTag, "Failed to read BMP palette");
+            return false;
+        }
+        std::memset(m_palette, 0, sizeof(m_palette));
+        for (uint32_t i = 0; i < colorsUsed; ++i) {
+            m_palette[i] = gray(entries[i * 4], entries[i * 4 + 1], entries[i * 4 + 2]);
+        }
+    }
+
+    m_row.assign(m_strideBytes, 0);
+    return true;
+}
+
+bool BmpGraySource::readRow(uint16_t y, uint8_t *out) {
+    if (y >= m_height || m_row.empty()) {
+        return false;
+    }
+    const uint32_t sourceRow = m_bottomUp ? (m_height - 1u - y) : y;
+    const uint32_t offset = m_dataOffset + sourceRow * m_strideBytes;
+    if (m_readAt(offset, m_row.data(), m_strideBytes) != m_strideBytes) {
+        infra::emitLog(infra::LogLevel::Error, kTag,
+                       "Failed to read BMP row %u", static_cast<unsigned>(sourceRow));
+        return false;
+    }
+
+    const uint8_t *row = m_row.data();
+    switch (m_bitsPerPixel) {
+        case 1:
+            for (uint16_t x = 0; x < m_width; ++x) {
+                out[x] = m_palette[(row[x >> 3] >> (7 - (x & 7))) & 0x01];
+            }
+            break;
+        case 4:
+            for (uint16_t x = 0; x < m_width; ++x) {
+                out[x] = m_palette[(row[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F];
+            }
+            break;
+        case 8:
+            for (uint16_t x = 0; x < m_width; ++x) {
+                out[x] = m_palette[row[x]];
+            }
+            break;
+        default: {
+            const uint32_t step = m_bitsPerPixel / 8;
+            for (uint16_t x = 0; x < m_width; ++x) {
+                const uint8_t *px = row + x * step;
+                out[x] = gray(px[0], px[1], px[2]);
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+uint32_t LogoRasterizer::Options::key() const {
+    return static_cast<uint32_t>(maxWidthDots) |
+           (static_cast<uint32_t>(dither) << 16) |
+           (static_cast<uint32_t>(scaleUp ? 1 : 0) << 20) |
+           (static_cast<uint32_t>(centre ? 1 : 0) << 21) |
+           (static_cast<uint32_t>(threshold) << 24);
+}
+
+void LogoRasterizer::CacheHeader::encode(uint8_t *out) const {
+    writeLE32(out, MAGIC);
+    writeLE16(out + 4, VERSION);
+    writeLE16(out + 6, 0);
+    writeLE32(out + 8, sourceBytes);
+    writeLE32(out + 12, sourceStamp);
+    writeLE32(out + 16, optionsKey);
+    writeLE32(out + 20, payloadBytes);
+}
+
+bool LogoRasterizer::CacheHeader::decode(const uint8_t *data, size_t length) {
+    if (!data || length < SIZE || readLE32(data) != MAGIC || readLE16(data + 4) != VERSION) {
+        return false;
+    }
+    sourceBytes = readLE32(data + 8);
+    sourceStamp = readLE32(data + 12);
+    optionsKey = readLE32(data + 16);
+    payloadBytes = readLE32(data + 20);
+    return true;
+}
+
+LogoRasterizer::LogoRasterizer(const Options &options)
+    : m_options(options),
+      m_width(0),
+      m_errorCurrent(),
+      m_errorNext() {
+    if (m_options.maxWidthDots == 0) {
+        m_options.maxWidthDots = 384;
+    }
+}
+
+void LogoRasterizer::scaledSize(uint16_t sourceWidth,
+                                uint16_t sourceHeight,
+                                const Options &options,
+                                uint16_t &outWidth,
+                                uint16_t &outHeight) {
+    outWidth = sourceWidth;
+    outHeight = sourceHeight;
+    const bool tooWide = sourceWidth > options.maxWidthDots;
+    const bool stretch = options.scaleUp && sourceWidth < options.maxWidthDots;
+    if (sourceWidth == 0 || (!tooWide && !stretch)) {
+        return;
+    }
+    outWidth = options.maxWidthDots;
+    const uint32_t scaled = (static_cast<uint32_t>(sourceHeight) * outWidth + sourceWidth / 2) / sourceWidth;
+    outHeight = static_cast<uint16_t>(std::max<uint32_t>(1, std::min<uint32_t>(scaled, 0xFFFF)));
+}
+
+bool LogoRasterizer::rasterize(IGrayRowSource &source, std::vector<uint8_t> &out) {
+    const uint16_t sw = source.width();
+    const uint16_t sh = source.height();
+    if (sw == 0 || sh == 0) {
+        infra::emitLog(infra::LogLevel::Error, kTag, "Logo source is empty");
+        return false;
+    }
+
+    uint16_t dh = 0;
+    scaledSize(sw, sh, m_options, m_width, dh);
+    const uint16_t dw = m_width;
+    if (dh > m_options.maxHeightDots) {
+        infra::emitLog(infra::LogLevel::Error, kTag,
+                       "Logo would be %u dot rows tall; the limit is %u",
+                       static_cast<unsigned>(dh), static_cast<unsigned>(m_options.maxHeightDots));
+        return false;
+    }
+
+    const uint16_t payloadBytes = static_cast<uint16_t>((dw + 7) / 8);
+    const uint16_t maxRowBytes = static_cast<uint16_t>((m_options.maxWidthDots + 7) / 8);
+    const uint16_t padBytes = (m_options.centre && payloadBytes < maxRowBytes)
+                                  ? static_cast<uint16_t>((maxRowBytes - payloadBytes) / 2)
+                                  : 0;
+    const uint16_t rowBytes = static_cast<uint16_t>(padBytes + payloadBytes);
+
+    std::vector<uint8_t> sourceRow(sw);
+    std::vector<uint8_t> scaledRow(dw);
+    std::vector<uint32_t> accum(dw);
+    std::vector<uint8_t> grayRow(dw);
+    m_errorCurrent.assign(dw + 2u, 0);
+    m_errorNext.assign(dw + 2u, 0);
+
+    const size_t start = out.size();
+    out.reserve(start + 8 + static_cast<size_t>(rowBytes) * dh);
+    const uint8_t header[] = {0x1D, 'v', '0', 0x00,
+                              static_cast<uint8_t>(rowBytes & 0xFF), static_cast<uint8_t>(rowBytes >> 8),
+                              static_cast<uint8_t>(dh & 0xFF), static_cast<uint8_t>(dh >> 8)};
+    out.insert(out.end(), header, header + sizeof(header));
+
+    int32_t cachedRow = -1;
+    for (uint32_t o = 0; o < dh; ++o) {
+        // Vertical pass: same area weighting as resampleLine, over rows
+        const uint32_t spanStart = o * sh;
+        const uint32_t spanEnd = spanStart + sh;
+        std::fill(accum.begin(), accum.end(), 0);
+        for (uint32_t i = spanStart / dh; i * dh < spanEnd; ++i) {
+            if (static_cast<int32_t>(i) != cachedRow) {
+                if (!source.readRow(static_cast<uint16_t>(i), sourceRow.data())) {
+                    out.resize(start);
+                    return false;
+                }
+                resampleLine(sourceRow.data(), sw, scaledRow.data(), dw);
+                cachedRow = static_cast<int32_t>(i);
+            }
+            const uint32_t overlap = std::min(spanEnd, (i + 1) * dh) - std::max(spanStart, i * dh);
+            for (uint16_t x = 0; x < dw; ++x) {
+                accum[x] += static_cast<uint32_t>(scaledRow[x]) * overlap;
+            }
+        }
+        for (uint16_t x = 0; x < dw; ++x) {
+            grayRow[x] = static_cast<uint8_t>((accum[x] + sh / 2) / sh);
+        }
+
+        out.insert(out.end(), padBytes, 0x00);
+        const size_t bitsOffset = out.size();
+        out.insert(out.end(), payloadBytes, 0x00);
+        ditherRow(grayRow.data(), static_cast<uint16_t>(o), out.data() + bitsOffset);
+    }
+    return true;
+}
+
+void LogoRasterizer::ditherRow(const uint8_t *gray, uint16_t y, uint8_t *bits) {
+    const uint16_t width = m_width;
+    switch (m_options.dither) {
+        case Dither::Threshold:
+            for (uint16_t x = 0; x < width; ++x) {
+                if (gray[x] < m_options.threshold) {
+                    bits[x >> 3] |= static_cast<uint8_t>(0x80 >> (x & 7));
+                }
+            }
+            break;
+
+        case Dither::Ordered:
+            for (uint16_t x = 0; x < width; ++x) {
+                // Cell thresholds spread evenly over 0..255
+                const uint16_t level = static_cast<uint16_t>((BAYER_8X8[y & 7][x & 7] * 2 + 1) * 255 / 128);
+                if (gray[x] < level) {
+                    bits[x >> 3] |= static_cast<uint8_t>(0x80 >> (x & 7));
+                }
+            }
+            break;
+
+        case Dither::FloydSteinberg: {
+            // Error rows are offset by one so x-1 and x+1 never go out of range.
+            std::swap(m_errorCurrent, m_errorNext);
+            std::fill(m_errorNext.begin(), m_errorNext.end(), 0);
+            for (uint16_t x = 0; x < width; ++x) {
+                const int value = static_cast<int>(gray[x]) + m_errorCurrent[x + 1];
+                const bool black = value < m_options.threshold;
+                if (black) {
+                    bits[x >> 3] |= static_cast<uint8_t>(0x80 >> (x & 7));
+                }
+                const int error = value - (black ? 0 : 255);
+                m_errorCurrent[x + 2] = static_cast<int16_t>(m_errorCurrent[x + 2] + error * 7 / 16);
+                m_errorNext[x] = static_cast<int16_t>(m_errorNext[x] + error * 3 / 16);
+                m_errorNext[x + 1] = static_cast<int16_t>(m_errorNext[x + 1] + error * 5 / 16);
+                m_errorNext[x + 2] = static_cast<int16_t>(m_errorNext[x + 2] + error / 16);
+            }
+            break;
+        }
+    }
+}
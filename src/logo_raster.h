@@ -0,0 +1,118 @@
+#ifndef LOGO_RASTER_H
+#define LOGO_RASTER_H
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Supplies an image one grayscale row at a time, top row first.
+ * 0 is black and 255 is white.
+ */
+class IGrayRowSource {
+public:
+    virtual ~IGrayRowSource() = default;
+    virtual uint16_t width() const = 0;
+    virtual uint16_t height() const = 0;
+    virtual bool readRow(uint16_t y, uint8_t *out) = 0;
+};
+
+/**
+ * Reads uncompressed BMPs (1/4/8-bit palette, 24/32-bit BGR) through a
+ * random-access callback, so a logo never has to sit in RAM whole.
+ */
+class BmpGraySource : public IGrayRowSource {
+public:
+    // Reads up to `length` bytes at `offset`; returns bytes read.
+    using ReadAt = std::function<size_t(uint32_t offset, uint8_t *data, size_t length)>;
+
+    static constexpr uint16_t MAX_DIMENSION = 4096;
+
+    explicit BmpGraySource(ReadAt readAt);
+
+    // Parses the header and palette. Must succeed before readRow().
+    bool open();
+
+    uint16_t width() const override { return m_width; }
+    uint16_t height() const override { return m_height; }
+    uint16_t bitsPerPixel() const { return m_bitsPerPixel; }
+    bool readRow(uint16_t y, uint8_t *out) override;
+
+private:
+    ReadAt m_readAt;
+    uint16_t m_width;
+    uint16_t m_height;
+    uint16_t m_bitsPerPixel;
+    bool m_bottomUp;
+    uint32_t m_dataOffset;
+    uint32_t m_strideBytes;
+    uint8_t m_palette[256];
+    std::vector<uint8_t> m_row;
+};
+
+/**
+ * Scales a grayscale image to the printer width, dithers it to 1 bit and
+ * emits a single ESC/POS `GS v 0` raster block.
+ */
+class LogoRasterizer {
+public:
+    enum class Dither : uint8_t {
+        Threshold,
+        FloydSteinberg,
+        Ordered  // 8x8 Bayer
+    };
+
+    struct Options {
+        uint16_t maxWidthDots = 384;
+        Dither dither = Dither::FloydSteinberg;
+        uint8_t threshold = 128;
+        bool scaleUp = false;  // Stretch narrower images to maxWidthDots
+        bool centre = true;    // Left-pad the raster to centre it on the paper
+        // Taller rasters are refused: the block is held in RAM whole, and a
+        // 384-dot row costs 48 bytes, so 1024 rows is already 48 KB.
+        uint16_t maxHeightDots = 1024;
+
+        // Changes whenever the output for the same source would change.
+        uint32_t key() const;
+    };
+
+    // Header of the pre-packed raster cached next to the source image.
+    struct CacheHeader {
+        static constexpr uint32_t MAGIC = 0x5453524CUL;  // "LRST"
+        // 2: rasters over Options::maxHeightDots are no longer written
+        static constexpr uint16_t VERSION = 2;
+        static constexpr size_t SIZE = 24;
+
+        uint32_t sourceBytes = 0;
+        uint32_t sourceStamp = 0;
+        uint32_t optionsKey = 0;
+        uint32_t payloadBytes = 0;
+
+        void encode(uint8_t *out) const;
+        // False on a wrong magic or version.
+        bool decode(const uint8_t *data, size_t length);
+    };
+
+    explicit LogoRasterizer(const Options &options);
+
+    // Appends one GS v 0 block to `out`. On failure `out` is left unchanged.
+    bool rasterize(IGrayRowSource &source, std::vector<uint8_t> &out);
+
+    // Size of the dithered image (before centring) for a given source.
+    static void scaledSize(uint16_t sourceWidth,
+                           uint16_t sourceHeight,
+                           const Options &options,
+                           uint16_t &outWidth,
+                           uint16_t &outHeight);
+
+private:
+    void ditherRow(const uint8_t *gray, uint16_t y, uint8_t *bits);
+
+    Options m_options;
+    uint16_t m_width;
+    std::vector<int16_t> m_errorCurrent;
+    std::vector<int16_t> m_errorNext;
+};
+
+#endif  // LOGO_RASTER_H
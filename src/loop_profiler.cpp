@@ -0,0 +1,134 @@
+#include "loop_profiler.h"
+
+#include <cstdio>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_cpu.h>
+#else
+#include <chrono>
+#endif
+
+namespace {
+
+const char *const kStageNames[LoopProfiler::STAGE_COUNT] = {
+    "audio",
+    "sdlog",
+    "bluetooth",
+    "finger",
+    "printer",
+    "lights",
+    "servo",
+    "connectivity",
+    "uart",
+    "controller",
+    "cli",
+    "loop",
+};
+
+#ifdef ARDUINO
+uint32_t defaultTicks() {
+    return esp_cpu_get_ccount();
+}
+
+uint32_t defaultTicksPerMicro() {
+    const uint32_t mhz = getCpuFrequencyMhz();
+    return mhz > 0 ? mhz : 1;
+}
+#else
+uint32_t defaultTicks() {
+    using namespace std::chrono;
+    return static_cast<uint32_t>(
+        duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+uint32_t defaultTicksPerMicro() {
+    return 1;
+}
+#endif
+
+size_t stageIndex(LoopProfiler::Stage stage) {
+    const size_t index = static_cast<size_t>(stage);
+    return index < LoopProfiler::STAGE_COUNT ? index : LoopProfiler::STAGE_COUNT - 1;
+}
+
+}  // namespace
+
+LoopProfiler::LoopProfiler()
+    : m_ticks(defaultTicks),
+      m_ticksPerMicro(defaultTicksPerMicro()) {
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        m_stages[i].budgetUs = (i == static_cast<size_t>(Stage::Loop))
+                                   ? DEFAULT_LOOP_BUDGET_US
+                                   : DEFAULT_STAGE_BUDGET_US;
+    }
+}
+
+void LoopProfiler::setClock(TickFn ticks, uint32_t ticksPerMicro) {
+    m_ticks = ticks ? ticks : defaultTicks;
+    m_ticksPerMicro = ticksPerMicro > 0 ? ticksPerMicro : 1;
+}
+
+void LoopProfiler::record(Stage stage, uint32_t micros) {
+    StageData &data = m_stages[stageIndex(stage)];
+    data.histogram.record(micros);
+    if (data.budgetUs > 0 && micros > data.budgetUs) {
+        ++data.overBudget;
+    }
+}
+
+// Clears samples but keeps the configured budgets.
+void LoopProfiler::reset() {
+    for (auto &data : m_stages) {
+        data.histogram.reset();
+        data.overBudget = 0;
+    }
+}
+
+void LoopProfiler::setBudgetUs(Stage stage, uint32_t budgetUs) {
+    m_stages[stageIndex(stage)].budgetUs = budgetUs;
+}
+
+LoopProfiler::StageStats LoopProfiler::stats(Stage stage) const {
+    const StageData &data = m_stages[stageIndex(stage)];
+    StageStats result;
+    result.samples = data.histogram.count();
+    result.minUs = data.histogram.minUs();
+    result.avgUs = data.histogram.avgUs();
+    result.maxUs = data.histogram.maxUs();
+    result.p50Us = data.histogram.percentileUs(500);
+    result.p99Us = data.histogram.percentileUs(990);
+    result.budgetUs = data.budgetUs;
+    result.overBudget = data.overBudget;
+    return result;
+}
+
+void LoopProfiler::writeReport(const LineWriter &write) const {
+    if (!write) {
+        return;
+    }
+    char line[112];
+    write("=== LOOP PROFILE (us) ===");
+    write("Stage            count     min     avg     p50     p99     max  >budget");
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        const auto stage = static_cast<Stage>(i);
+        const StageStats s = stats(stage);
+        if (s.samples == 0) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%-12s %9u %7u %7u %7u %7u %7u %8u",
+                 stageName(stage),
+                 static_cast<unsigned>(s.samples),
+                 static_cast<unsigned>(s.minUs),
+                 static_cast<unsigned>(s.avgUs),
+                 static_cast<unsigned>(s.p50Us),
+                 static_cast<unsigned>(s.p99Us),
+                 static_cast<unsigned>(s.maxUs),
+                 static_cast<unsigned>(s.overBudget));
+        write(line);
+    }
+}
+
+const char *LoopProfiler::stageName(Stage stage) {
+    return kStageNames[stageIndex(stage)];
+}
@@ -0,0 +1,100 @@
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+#include "infra/latency_histogram.h"
+
+/**
+ * Per-stage timing for AppController::loop. Each stage keeps a latency
+ * histogram (min/avg/max/percentiles) and a count of samples over its budget.
+ * Timestamps come from the CPU cycle counter on ESP32 and steady_clock on the
+ * host; only the loop task touches it, so no locking is needed.
+ */
+class LoopProfiler {
+public:
+    enum class Stage : uint8_t {
+        Audio = 0,
+        SdLog,
+        Bluetooth,
+        Finger,
+        Printer,
+        Lights,
+        Servo,
+        Connectivity,
+        Uart,
+        Controller,
+        Cli,
+        Loop,
+        Count
+    };
+
+    struct StageStats {
+        uint32_t samples = 0;
+        uint32_t minUs = 0;
+        uint32_t avgUs = 0;
+        uint32_t maxUs = 0;
+        uint32_t p50Us = 0;
+        uint32_t p99Us = 0;
+        uint32_t budgetUs = 0;
+        uint32_t overBudget = 0;
+    };
+
+    using TickFn = uint32_t (*)();
+    using LineWriter = std::function<void(const char *line)>;
+
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::Count);
+    static constexpr uint32_t DEFAULT_STAGE_BUDGET_US = 5000;
+    static constexpr uint32_t DEFAULT_LOOP_BUDGET_US = 10000;
+
+    // Times the enclosing block and records it against a stage.
+    class Scope {
+    public:
+        Scope(LoopProfiler &profiler, Stage stage)
+            : m_profiler(profiler), m_stage(stage), m_start(profiler.nowTicks()) {}
+        ~Scope() { m_profiler.record(m_stage, m_profiler.elapsedMicros(m_start)); }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        LoopProfiler &m_profiler;
+        Stage m_stage;
+        uint32_t m_start;
+    };
+
+    LoopProfiler();
+
+    // Overrides the tick source (host tests). ticksPerMicro must be non-zero.
+    void setClock(TickFn ticks, uint32_t ticksPerMicro);
+
+    uint32_t nowTicks() const { return m_ticks(); }
+    uint32_t elapsedMicros(uint32_t startTicks) const {
+        return (m_ticks() - startTicks) / m_ticksPerMicro;
+    }
+
+    void record(Stage stage, uint32_t micros);
+    void reset();
+
+    void setBudgetUs(Stage stage, uint32_t budgetUs);
+    StageStats stats(Stage stage) const;
+
+    void writeReport(const LineWriter &write) const;
+
+    static const char *stageName(Stage stage);
+
+private:
+    struct StageData {
+        infra::LatencyHistogram histogram;
+        uint32_t budgetUs = 0;
+        uint32_t overBudget = 0;
+    };
+
+    StageData m_stages[STAGE_COUNT];
+    TickFn m_ticks;
+    uint32_t m_ticksPerMicro;
+};
+
+#endif  // LOOP_PROFILER_H
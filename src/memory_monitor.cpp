@@ -0,0 +1,118 @@
+#include "memory_monitor.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "infra/alloc_tracker.h"
+#include "infra/log_sink.h"
+
+static constexpr const char* TAG = "Memory";
+
+MemoryMonitor::MemoryMonitor(infra::IHeapProbe &probe)
+    : m_probe(probe) {}
+
+void MemoryMonitor::update(uint32_t nowMs) {
+    if (m_logIntervalMs == 0) {
+        return;
+    }
+    if (m_logged && nowMs - m_lastLogMs < m_logIntervalMs) {
+        return;
+    }
+    m_logged = true;
+    m_lastLogMs = nowMs;
+
+    sample();
+    char line[160];
+    writeSummary(line, sizeof(line));
+    infra::emitLog(infra::LogLevel::Info, TAG, "%s", line);
+}
+
+infra::HeapStats MemoryMonitor::sample() {
+    m_last = m_probe.sample();
+    if (m_sampleCount == 0 || m_last.largestFreeBlock < m_minLargestFreeBlock) {
+        m_minLargestFreeBlock = m_last.largestFreeBlock;
+    }
+    ++m_sampleCount;
+    return m_last;
+}
+
+uint32_t MemoryMonitor::fragmentationPercent(const infra::HeapStats &stats) {
+    if (stats.freeBytes == 0 || stats.largestFreeBlock >= stats.freeBytes) {
+        return 0;
+    }
+    const uint64_t unreachable = stats.freeBytes - stats.largestFreeBlock;
+    return static_cast<uint32_t>((unreachable * 100U) / stats.freeBytes);
+}
+
+void MemoryMonitor::writeSummary(char *buffer, size_t size) const {
+    if (!buffer || size == 0) {
+        return;
+    }
+    const infra::AllocCounters totals = infra::allocTotals();
+    snprintf(buffer, size,
+             "Heap free=%u min=%u largest=%u (low %u) frag=%u%% live=%u peak=%u allocs=%u",
+             static_cast<unsigned>(m_last.freeBytes),
+             static_cast<unsigned>(m_last.minimumFreeBytes),
+             static_cast<unsigned>(m_last.largestFreeBlock),
+             static_cast<unsigned>(m_minLargestFreeBlock),
+             static_cast<unsigned>(fragmentationPercent(m_last)),
+             static_cast<unsigned>(totals.liveBytes),
+             static_cast<unsigned>(totals.peakLiveBytes),
+             static_cast<unsigned>(totals.allocations));
+}
+
+void MemoryMonitor::writeReport(const LineWriter &write) {
+    if (!write) {
+        return;
+    }
+    sample();
+
+    char line[128];
+    write("=== MEMORY ===");
+    snprintf(line, sizeof(line), "Heap free:       %u / %u bytes",
+             static_cast<unsigned>(m_last.freeBytes),
+             static_cast<unsigned>(m_last.totalBytes));
+    write(line);
+    snprintf(line, sizeof(line), "Min free:        %u bytes (since boot)",
+             static_cast<unsigned>(m_last.minimumFreeBytes));
+    write(line);
+    snprintf(line, sizeof(line), "Largest block:   %u bytes (low %u)",
+             static_cast<unsigned>(m_last.largestFreeBlock),
+             static_cast<unsigned>(m_minLargestFreeBlock));
+    write(line);
+    snprintf(line, sizeof(line), "Fragmentation:   %u%%",
+             static_cast<unsigned>(fragmentationPercent(m_last)));
+    write(line);
+
+    if (!infra::allocTrackingEnabled()) {
+        write("Allocation tracking disabled (APP_ENABLE_ALLOC_TRACKING=0)");
+        return;
+    }
+
+    write("Subsystem      allocs     frees      live      peak       total");
+    const auto writeRow = [&](const char *name, const infra::AllocCounters &counters) {
+        snprintf(line, sizeof(line), "%-10s %10u %9u %9u %9u %11" PRIu64,
+                 name,
+                 static_cast<unsigned>(counters.allocations),
+                 static_cast<unsigned>(counters.frees),
+                 static_cast<unsigned>(counters.liveBytes),
+                 static_cast<unsigned>(counters.peakLiveBytes),
+                 counters.bytesAllocated);
+        write(line);
+    };
+    for (size_t i = 0; i < infra::kAllocTagCount; ++i) {
+        const auto tag = static_cast<infra::AllocTag>(i);
+        const infra::AllocCounters counters = infra::allocCounters(tag);
+        if (counters.allocations == 0 && counters.failures == 0) {
+            continue;
+        }
+        writeRow(infra::allocTagName(tag), counters);
+    }
+    const infra::AllocCounters totals = infra::allocTotals();
+    writeRow("total", totals);
+    if (totals.failures > 0) {
+        snprintf(line, sizeof(line), "Failed allocations: %u",
+                 static_cast<unsigned>(totals.failures));
+        write(line);
+    }
+}
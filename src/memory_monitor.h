@@ -0,0 +1,51 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+#include "infra/heap_probe.h"
+
+/**
+ * Samples heap health (free, largest block, watermarks) and the per-subsystem
+ * allocation counters, emitting a periodic log line and an on-demand report
+ * for the CLI/telnet `mem` command.
+ */
+class MemoryMonitor {
+public:
+    using LineWriter = std::function<void(const char *line)>;
+
+    static constexpr uint32_t DEFAULT_LOG_INTERVAL_MS = 60000;
+
+    explicit MemoryMonitor(infra::IHeapProbe &probe);
+
+    // Samples the heap and emits the summary line once per log interval.
+    void update(uint32_t nowMs);
+
+    infra::HeapStats sample();
+
+    void setLogIntervalMs(uint32_t intervalMs) { m_logIntervalMs = intervalMs; }
+    uint32_t logIntervalMs() const { return m_logIntervalMs; }
+
+    const infra::HeapStats &lastSample() const { return m_last; }
+    uint32_t minLargestFreeBlock() const { return m_minLargestFreeBlock; }
+    uint32_t sampleCount() const { return m_sampleCount; }
+
+    // Percentage of free heap not reachable as a single block.
+    static uint32_t fragmentationPercent(const infra::HeapStats &stats);
+
+    void writeSummary(char *buffer, size_t size) const;
+    void writeReport(const LineWriter &write);
+
+private:
+    infra::IHeapProbe &m_probe;
+    infra::HeapStats m_last;
+    uint32_t m_minLargestFreeBlock = 0;
+    uint32_t m_sampleCount = 0;
+    uint32_t m_logIntervalMs = DEFAULT_LOG_INTERVAL_MS;
+    uint32_t m_lastLogMs = 0;
+    bool m_logged = false;
+};
+
+#endif  // MEMORY_MONITOR_H
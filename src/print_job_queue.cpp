@@ -0,0 +1,343 @@
+#include "print_job_queue.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "infra/log_sink.h"
+
+namespace {
+constexpr const char *kTag = "PrintQueue";
+
+bool timeReached(uint32_t nowMs, uint32_t atMs) {
+    return static_cast<int32_t>(nowMs - atMs) >= 0;
+}
+
+void appendEscaped(std::string &out, const std::string &text) {
+    for (char c : text) {
+        switch (c) {
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            default:
+                out += c;
+                break;
+        }
+    }
+}
+
+bool unescape(const std::string &in, size_t start, std::string &out) {
+    out.clear();
+    for (size_t i = start; i < in.size(); ++i) {
+        if (in[i] != '\\') {
+            out += in[i];
+            continue;
+        }
+        if (++i >= in.size()) {
+            return false;
+        }
+        switch (in[i]) {
+            case '\\':
+                out += '\\';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+// Parses "<unsigned> " at `pos`, advancing past the separator.
+bool readNumber(const std::string &line, size_t &pos, uint32_t &value) {
+    const size_t end = line.find(' ', pos);
+    if (end == std::string::npos || end == pos) {
+        return false;
+    }
+    uint32_t result = 0;
+    for (size_t i = pos; i < end; ++i) {
+        if (line[i] < '0' || line[i] > '9') {
+            return false;
+        }
+        result = result * 10 + static_cast<uint32_t>(line[i] - '0');
+    }
+    value = result;
+    pos = end + 1;
+    return true;
+}
+}  // namespace
+
+PrintJobQueue::PrintJobQueue() : PrintJobQueue(Config()) {
+}
+
+PrintJobQueue::PrintJobQueue(const Config &config)
+    : m_config(config),
+      m_jobs(),
+      m_history(),
+      m_nextId(1),
+      m_revision(0),
+      m_stats() {
+    if (m_config.capacity == 0) {
+        m_config.capacity = 1;
+    }
+    if (m_config.maxAttempts == 0) {
+        m_config.maxAttempts = 1;
+    }
+}
+
+uint32_t PrintJobQueue::enqueue(const std::string &text) {
+    if (full()) {
+        ++m_stats.rejected;
+        infra::emitLog(infra::LogLevel::Warn, kTag,
+                       "Print queue full (%u jobs); fortune dropped",
+                       static_cast<unsigned>(m_jobs.size()));
+        return 0;
+    }
+    Job job;
+    job.id = m_nextId++;
+    if (m_nextId == 0) {
+        m_nextId = 1;
+    }
+    job.text = text;
+    m_jobs.push_back(std::move(job));
+    ++m_stats.enqueued;
+    ++m_revision;
+    return m_jobs.back().id;
+}
+
+const PrintJobQueue::Job *PrintJobQueue::next(uint32_t nowMs) const {
+    for (const auto &job : m_jobs) {
+        if (job.status == Status::Printing) {
+            return nullptr;  // One job on the printer at a time
+        }
+    }
+    for (const auto &job : m_jobs) {
+        if (job.status == Status::Pending && (job.attempts == 0 || timeReached(nowMs, job.retryAtMs))) {
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+const PrintJobQueue::Job *PrintJobQueue::active() const {
+    for (const auto &job : m_jobs) {
+        if (job.status == Status::Printing) {
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+bool PrintJobQueue::start(uint32_t id) {
+    Job *job = find(id);
+    if (!job || job->status != Status::Pending || active()) {
+        return false;
+    }
+    job->status = Status::Printing;
+    ++job->attempts;
+    ++m_revision;
+    return true;
+}
+
+bool PrintJobQueue::complete(uint32_t id) {
+    auto it = std::find_if(m_jobs.begin(), m_jobs.end(), [id](const Job &job) { return job.id == id; });
+    if (it == m_jobs.end() || it->status != Status::Printing) {
+        return false;
+    }
+    ++m_stats.completed;
+    finish(it, Status::Done);
+    return true;
+}
+
+bool PrintJobQueue::fail(uint32_t id, uint32_t nowMs) {
+    auto it = std::find_if(m_jobs.begin(), m_jobs.end(), [id](const Job &job) { return job.id == id; });
+    if (it == m_jobs.end() || it->status != Status::Printing) {
+        return false;
+    }
+    if (it->attempts >= m_config.maxAttempts) {
+        ++m_stats.failed;
+        infra::emitLog(infra::LogLevel::Error, kTag,
+                       "Print job #%lu failed after %u attempts; dropping it",
+                       static_cast<unsigned long>(id),
+                       static_cast<unsigned>(it->attempts));
+        finish(it, Status::Failed);
+        return false;
+    }
+    it->status = Status::Pending;
+    it->retryAtMs = nowMs + m_config.retryDelayMs;
+    ++m_stats.retried;
+    ++m_revision;
+    infra::emitLog(infra::LogLevel::Warn, kTag,
+                   "Print job #%lu attempt %u failed; retrying in %lu ms",
+                   static_cast<unsigned long>(id),
+                   static_cast<unsigned>(it->attempts),
+                   static_cast<unsigned long>(m_config.retryDelayMs));
+    return true;
+}
+
+bool PrintJobQueue::requeue(uint32_t id) {
+    Job *job = find(id);
+    if (!job || job->status != Status::Printing) {
+        return false;
+    }
+    job->status = Status::Pending;
+    if (job->attempts > 0) {
+        --job->attempts;
+    }
+    job->retryAtMs = 0;
+    ++m_revision;
+    infra::emitLog(infra::LogLevel::Info, kTag,
+                   "Print job #%lu back in the queue until the printer recovers",
+                   static_cast<unsigned long>(id));
+    return true;
+}
+
+bool PrintJobQueue::status(uint32_t id, Status &out) const {
+    for (const auto &job : m_jobs) {
+        if (job.id == id) {
+            out = job.status;
+            return true;
+        }
+    }
+    for (const auto &entry : m_history) {
+        if (entry.first == id) {
+            out = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *PrintJobQueue::statusName(Status status) {
+    switch (status) {
+        case Status::Pending:
+            return "pending";
+        case Status::Printing:
+            return "printing";
+        case Status::Done:
+            return "done";
+        case Status::Failed:
+            return "failed";
+    }
+    return "unknown";
+}
+
+std::string PrintJobQueue::encode() const {
+    char header[48];
+    snprintf(header, sizeof(header), "%s %u %lu %u\n",
+             FILE_MAGIC,
+             FILE_VERSION,
+             static_cast<unsigned long>(m_nextId),
+             static_cast<unsigned>(m_jobs.size()));
+    std::string out(header);
+    for (const auto &job : m_jobs) {
+        char prefix[24];
+        snprintf(prefix, sizeof(prefix), "%lu %u ",
+                 static_cast<unsigned long>(job.id),
+                 static_cast<unsigned>(job.attempts));
+        out += prefix;
+        appendEscaped(out, job.text);
+        out += '\n';
+    }
+    return out;
+}
+
+bool PrintJobQueue::decode(const std::string &data) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while (start < data.size()) {
+        size_t end = data.find('\n', start);
+        if (end == std::string::npos) {
+            return false;  // Every record ends in a newline; a missing one means truncation
+        }
+        lines.push_back(data.substr(start, end - start));
+        start = end + 1;
+    }
+    if (lines.empty()) {
+        return false;
+    }
+
+    const std::string magic = std::string(FILE_MAGIC) + " ";
+    if (lines[0].compare(0, magic.size(), magic) != 0) {
+        infra::emitLog(infra::LogLevel::Warn, kTag, "Print queue file has no header");
+        return false;
+    }
+    size_t pos = magic.size();
+    uint32_t version = 0;
+    uint32_t nextId = 0;
+    uint32_t count = 0;
+    const std::string header = lines[0] + " ";
+    if (!readNumber(header, pos, version) || !readNumber(header, pos, nextId) ||
+        !readNumber(header, pos, count) || version != FILE_VERSION) {
+        infra::emitLog(infra::LogLevel::Warn, kTag, "Print queue file header invalid");
+        return false;
+    }
+    if (count != lines.size() - 1) {
+        infra::emitLog(infra::LogLevel::Warn, kTag,
+                       "Print queue file truncated (%u of %lu jobs)",
+                       static_cast<unsigned>(lines.size() - 1),
+                       static_cast<unsigned long>(count));
+        return false;
+    }
+
+    std::deque<Job> jobs;
+    for (size_t i = 1; i < lines.size(); ++i) {
+        Job job;
+        uint32_t attempts = 0;
+        pos = 0;
+        if (!readNumber(lines[i], pos, job.id) || !readNumber(lines[i], pos, attempts) ||
+            job.id == 0 || !unescape(lines[i], pos, job.text)) {
+            infra::emitLog(infra::LogLevel::Warn, kTag, "Print queue file has a malformed job record");
+            return false;
+        }
+        job.attempts = static_cast<uint8_t>(std::min<uint32_t>(attempts, 0xFF));
+        job.status = Status::Pending;
+        job.retryAtMs = 0;
+        nextId = std::max(nextId, job.id + 1);
+        jobs.push_back(std::move(job));
+    }
+    if (jobs.size() > m_config.capacity) {
+        infra::emitLog(infra::LogLevel::Warn, kTag,
+                       "Print queue file holds %u jobs; keeping the oldest %u",
+                       static_cast<unsigned>(jobs.size()),
+                       static_cast<unsigned>(m_config.capacity));
+        jobs.resize(m_config.capacity);
+    }
+
+    m_jobs = std::move(jobs);
+    m_history.clear();
+    m_nextId = nextId ? nextId : 1;
+    ++m_revision;
+    return true;
+}
+
+PrintJobQueue::Job *PrintJobQueue::find(uint32_t id) {
+    for (auto &job : m_jobs) {
+        if (job.id == id) {
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+void PrintJobQueue::finish(std::deque<Job>::iterator it, Status status) {
+    m_history.emplace_back(it->id, status);
+    while (m_history.size() > m_config.historySize) {
+        m_history.pop_front();
+    }
+    m_jobs.erase(it);
+    ++m_revision;
+}
@@ -0,0 +1,102 @@
+#ifndef PRINT_JOB_QUEUE_H
+#define PRINT_JOB_QUEUE_H
+
+#include <deque>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/**
+ * Bounded FIFO of fortune print jobs. Each job gets an id, a status and a
+ * retry budget; a failed attempt is retried after a delay until the budget
+ * runs out. The live jobs can be encoded to text and restored after a
+ * reboot, so a paper-out or power cycle does not lose queued slips.
+ *
+ * Pure logic: the caller supplies time and does the file I/O.
+ */
+class PrintJobQueue {
+public:
+    enum class Status : uint8_t {
+        Pending,
+        Printing,
+        Done,
+        Failed
+    };
+
+    struct Job {
+        uint32_t id = 0;
+        std::string text;
+        Status status = Status::Pending;
+        uint8_t attempts = 0;
+        uint32_t retryAtMs = 0;
+    };
+
+    struct Config {
+        size_t capacity = 8;
+        uint8_t maxAttempts = 3;
+        uint32_t retryDelayMs = 5000;
+        size_t historySize = 8;  // finished jobs kept for status queries
+    };
+
+    struct Stats {
+        uint32_t enqueued = 0;
+        uint32_t completed = 0;
+        uint32_t retried = 0;
+        uint32_t failed = 0;
+        uint32_t rejected = 0;
+    };
+
+    static constexpr const char *FILE_MAGIC = "DFPQ";
+    static constexpr unsigned FILE_VERSION = 1;
+
+    PrintJobQueue();
+    explicit PrintJobQueue(const Config &config);
+
+    // Returns the new job's id, or 0 when the queue is full.
+    uint32_t enqueue(const std::string &text);
+    // Oldest pending job whose retry delay has passed, or nullptr.
+    const Job *next(uint32_t nowMs) const;
+    // The job currently printing, or nullptr.
+    const Job *active() const;
+
+    bool start(uint32_t id);
+    bool complete(uint32_t id);
+    // Records a failed attempt. Returns true if the job will be retried.
+    bool fail(uint32_t id, uint32_t nowMs);
+    // Puts a printing job back at pending without spending an attempt, for
+    // a printer fault (paper, cover) rather than a problem with the job.
+    bool requeue(uint32_t id);
+
+    // Status of a live or recently finished job; false for unknown ids.
+    bool status(uint32_t id, Status &out) const;
+    static const char *statusName(Status status);
+
+    size_t size() const { return m_jobs.size(); }
+    bool empty() const { return m_jobs.empty(); }
+    bool full() const { return m_jobs.size() >= m_config.capacity; }
+    size_t capacity() const { return m_config.capacity; }
+    const Stats &stats() const { return m_stats; }
+
+    // Bumped whenever the persisted form changes.
+    uint32_t revision() const { return m_revision; }
+
+    // One header line, then one line per live job with its text escaped.
+    std::string encode() const;
+    // Replaces the queue with decoded jobs; jobs that were printing come
+    // back as pending. Leaves the queue untouched and returns false on a
+    // malformed or truncated file.
+    bool decode(const std::string &data);
+
+private:
+    Job *find(uint32_t id);
+    void finish(std::deque<Job>::iterator it, Status status);
+
+    Config m_config;
+    std::deque<Job> m_jobs;
+    std::deque<std::pair<uint32_t, Status>> m_history;
+    uint32_t m_nextId;
+    uint32_t m_revision;
+    Stats m_stats;
+};
+
+#endif  // PRINT_JOB_QUEUE_H
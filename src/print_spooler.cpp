@@ -0,0 +1,199 @@
+#include "print_spooler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr uint64_t SCALE = 1000000ULL;  // Bucket values are kept in millionths
+}  // namespace
+
+PrintSpooler::PrintSpooler(IByteSink &sink)
+    : m_sink(sink),
+      m_timing(),
+      m_clearToSend(),
+      m_stream(),
+      m_bands(),
+      m_jobBytes(0),
+      m_offset(0),
+      m_markIndex(0),
+      m_busy(false),
+      m_clockValid(false),
+      m_lastMicros(0),
+      m_jobStartMicros(0),
+      m_byteTokens(0),
+      m_headBacklog(0),
+      m_stats() {
+}
+
+void PrintSpooler::setTiming(const Timing &timing) {
+    m_timing = timing;
+    if (m_timing.bitsPerByte == 0) {
+        m_timing.bitsPerByte = 10;
+    }
+    if (m_timing.burstBytes == 0) {
+        m_timing.burstBytes = 1;
+    }
+}
+
+void PrintSpooler::setClearToSend(ClearToSend clearToSend) {
+    m_clearToSend = std::move(clearToSend);
+}
+
+bool PrintSpooler::load(PrintStream &&stream) {
+    return load(std::move(stream), nullptr);
+}
+
+bool PrintSpooler::load(PrintStream &&stream, std::unique_ptr<IBandSource> bands) {
+    if (m_busy) {
+        return false;
+    }
+    m_stream = std::move(stream);
+    m_bands = std::move(bands);
+    m_jobBytes = 0;
+    m_offset = 0;
+    m_markIndex = 0;
+    m_busy = !m_stream.bytes.empty() || m_bands;
+    m_clockValid = false;
+    return true;
+}
+
+void PrintSpooler::abort() {
+    m_stream.clear();
+    m_bands.reset();
+    m_offset = 0;
+    m_markIndex = 0;
+    m_busy = false;
+}
+
+void PrintSpooler::refill(uint32_t nowMicros) {
+    if (!m_clockValid) {
+        // New job: start with a full burst and assume the head is idle.
+        m_clockValid = true;
+        m_lastMicros = nowMicros;
+        m_jobStartMicros = nowMicros;
+        m_byteTokens = static_cast<uint64_t>(m_timing.burstBytes) * SCALE;
+        m_headBacklog = 0;
+        return;
+    }
+
+    const uint64_t elapsed = static_cast<uint32_t>(nowMicros - m_lastMicros);
+    m_lastMicros = nowMicros;
+
+    const uint64_t bytesPerSec = m_timing.baud / m_timing.bitsPerByte;
+    const uint64_t maxTokens = static_cast<uint64_t>(m_timing.burstBytes) * SCALE;
+    m_byteTokens = std::min(maxTokens, m_byteTokens + elapsed * bytesPerSec);
+
+    const uint64_t drained = elapsed * m_timing.headDotLinesPerSec;
+    m_headBacklog = drained >= m_headBacklog ? 0 : m_headBacklog - drained;
+}
+
+size_t PrintSpooler::pump(uint32_t nowMicros) {
+    if (!m_busy) {
+        return 0;
+    }
+    refill(nowMicros);
+
+    if (m_clearToSend && !m_clearToSend()) {
+        ++m_stats.flowWaits;
+        return 0;
+    }
+
+    const uint64_t headLimit = static_cast<uint64_t>(m_timing.headBufferDotLines) * SCALE;
+    size_t written = 0;
+    bool done = false;
+
+    while (true) {
+        if (m_offset >= m_stream.bytes.size() && !nextBand()) {
+            done = true;
+            break;
+        }
+        const size_t total = m_stream.bytes.size();
+        if (m_timing.headDotLinesPerSec > 0 && m_headBacklog >= headLimit) {
+            ++m_stats.headWaits;
+            break;
+        }
+
+        // Stop at the next mark so its head cost is charged as soon as the
+        // bytes that trigger it are out.
+        size_t chunkEnd = total;
+        if (m_markIndex < m_stream.marks.size()) {
+            chunkEnd = std::min(chunkEnd, m_stream.marks[m_markIndex].endOffset);
+        }
+        size_t chunk = chunkEnd - m_offset;
+        chunk = std::min<size_t>(chunk, static_cast<size_t>(m_byteTokens / SCALE));
+        chunk = std::min(chunk, m_sink.availableForWrite());
+
+        if (chunk > 0) {
+            const size_t sent = m_sink.write(m_stream.bytes.data() + m_offset, chunk);
+            if (sent == 0) {
+                break;
+            }
+            m_offset += sent;
+            written += sent;
+            m_byteTokens -= static_cast<uint64_t>(sent) * SCALE;
+        }
+
+        bool charged = false;
+        while (m_markIndex < m_stream.marks.size() &&
+               m_stream.marks[m_markIndex].endOffset <= m_offset) {
+            if (m_timing.headDotLinesPerSec > 0) {
+                m_headBacklog += static_cast<uint64_t>(m_stream.marks[m_markIndex].dotLines) * SCALE;
+            }
+            ++m_markIndex;
+            charged = true;
+        }
+
+        if (chunk == 0 && !charged) {
+            break;
+        }
+    }
+
+    m_stats.bytesSent += static_cast<uint32_t>(written);
+    m_jobBytes += static_cast<uint32_t>(written);
+    if (done) {
+        finishJob(nowMicros);
+    }
+    return written;
+}
+
+bool PrintSpooler::nextBand() {
+    if (!m_bands) {
+        return false;
+    }
+    m_stream.clear();
+    m_offset = 0;
+    m_markIndex = 0;
+    while (m_stream.bytes.empty()) {
+        if (!m_bands->nextBand(m_stream)) {
+            m_bands.reset();
+            return false;
+        }
+    }
+    return true;
+}
+
+void PrintSpooler::finishJob(uint32_t nowMicros) {
+    ++m_stats.jobs;
+    m_stats.lastJobBytes = m_jobBytes;
+    m_stats.lastJobMicros = nowMicros - m_jobStartMicros;
+    m_busy = false;
+    m_stream.clear();
+    m_bands.reset();
+    m_offset = 0;
+    m_markIndex = 0;
+}
+
+uint32_t PrintSpooler::estimateMicros(const PrintStream &stream, const Timing &timing) {
+    return estimateMicros(stream.bytes.size(), stream.totalDotLines(), timing);
+}
+
+uint32_t PrintSpooler::estimateMicros(size_t bytes, uint32_t dotLines, const Timing &timing) {
+    const uint32_t bytesPerSec = timing.bitsPerByte ? timing.baud / timing.bitsPerByte : timing.baud / 10;
+    uint64_t serial = bytesPerSec ? (static_cast<uint64_t>(bytes) * SCALE) / bytesPerSec : 0;
+    uint64_t head = 0;
+    if (timing.headDotLinesPerSec > 0) {
+        const uint32_t buffered = std::min(dotLines, timing.headBufferDotLines);
+        head = (static_cast<uint64_t>(dotLines - buffered) * SCALE) / timing.headDotLinesPerSec;
+    }
+    return static_cast<uint32_t>(std::max(serial, head));
+}
@@ -0,0 +1,110 @@
+#ifndef PRINT_SPOOLER_H
+#define PRINT_SPOOLER_H
+
+#include <functional>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "escpos_stream.h"
+
+/**
+ * Streams a rendered PrintStream to the printer as fast as it can safely take
+ * it. Two token buckets gate output:
+ *  - serial: bytes/s from the baud rate, with a small burst for the UART FIFO;
+ *  - head: dot lines charged by the stream's marks drain at the head speed,
+ *    and output pauses once the printer is too far behind.
+ * An optional clear-to-send hook (DTR/busy pin or status poll) can hold
+ * output regardless of the model. A job may be followed by a band source
+ * that renders the rest of it on demand, one band at a time.
+ */
+class PrintSpooler {
+public:
+    class IByteSink {
+    public:
+        virtual ~IByteSink() = default;
+        virtual size_t availableForWrite() = 0;
+        virtual size_t write(const uint8_t *data, size_t length) = 0;
+    };
+
+    // Produces the remainder of a job a band at a time so the whole page never
+    // sits in RAM. nextBand() appends to an empty stream and returns false
+    // once there is nothing left.
+    class IBandSource {
+    public:
+        virtual ~IBandSource() = default;
+        virtual bool nextBand(PrintStream &stream) = 0;
+        virtual size_t totalBytes() const = 0;
+        virtual uint32_t totalDotLines() const = 0;
+    };
+
+    struct Timing {
+        uint32_t baud = 9600;
+        uint8_t bitsPerByte = 10;             // 8N1
+        uint32_t headDotLinesPerSec = 400;    // ~50 mm/s at 8 dots/mm
+        uint32_t headBufferDotLines = 96;     // How far we may run ahead of the head
+        uint16_t burstBytes = 64;
+    };
+
+    struct Stats {
+        uint32_t jobs = 0;
+        uint32_t bytesSent = 0;
+        uint32_t headWaits = 0;   // pump() calls held back by the head model
+        uint32_t flowWaits = 0;   // pump() calls held back by clear-to-send
+        uint32_t lastJobBytes = 0;
+        uint32_t lastJobMicros = 0;
+    };
+
+    using ClearToSend = std::function<bool()>;
+
+    explicit PrintSpooler(IByteSink &sink);
+
+    void setTiming(const Timing &timing);
+    const Timing &timing() const { return m_timing; }
+    void setClearToSend(ClearToSend clearToSend);
+
+    // Takes ownership of a rendered job, optionally followed by bands rendered
+    // on demand. Returns false while another job runs.
+    bool load(PrintStream &&stream);
+    bool load(PrintStream &&stream, std::unique_ptr<IBandSource> bands);
+    void abort();
+
+    // Writes whatever the buckets allow. Returns bytes written.
+    size_t pump(uint32_t nowMicros);
+
+    bool isBusy() const { return m_busy; }
+    // Bytes left in the current buffer; bands not yet rendered are not counted.
+    size_t bytesRemaining() const { return m_busy ? m_stream.bytes.size() - m_offset : 0; }
+    const Stats &stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+    // Lower bound on how long a stream takes under the given timing.
+    static uint32_t estimateMicros(const PrintStream &stream, const Timing &timing);
+    static uint32_t estimateMicros(size_t bytes, uint32_t dotLines, const Timing &timing);
+
+private:
+    void refill(uint32_t nowMicros);
+    bool nextBand();
+    void finishJob(uint32_t nowMicros);
+
+    IByteSink &m_sink;
+    Timing m_timing;
+    ClearToSend m_clearToSend;
+
+    PrintStream m_stream;
+    std::unique_ptr<IBandSource> m_bands;
+    uint32_t m_jobBytes;
+    size_t m_offset;
+    size_t m_markIndex;
+    bool m_busy;
+
+    bool m_clockValid;
+    uint32_t m_lastMicros;
+    uint32_t m_jobStartMicros;
+    uint64_t m_byteTokens;    // bytes * 1e6
+    uint64_t m_headBacklog;   // dot lines * 1e6
+
+    Stats m_stats;
+};
+
+#endif  // PRINT_SPOOLER_H
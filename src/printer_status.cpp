@@ -0,0 +1,138 @@
+#include "printer_status.h"
+
+namespace {
+bool timeReached(uint32_t nowMs, uint32_t atMs) {
+    return static_cast<int32_t>(nowMs - atMs) >= 0;
+}
+
+bool sameStatus(const PrinterStatusMonitor::Status &a, const PrinterStatusMonitor::Status &b) {
+    return a.known == b.known &&
+           a.responding == b.responding &&
+           a.paperNearEnd == b.paperNearEnd &&
+           a.paperOut == b.paperOut &&
+           a.coverOpen == b.coverOpen &&
+           a.overheat == b.overheat &&
+           a.errorStop == b.errorStop;
+}
+}  // namespace
+
+PrinterStatusMonitor::PrinterStatusMonitor(IPort &port) : PrinterStatusMonitor(port, Config()) {
+}
+
+PrinterStatusMonitor::PrinterStatusMonitor(IPort &port, const Config &config)
+    : m_port(port),
+      m_config(config),
+      m_status(),
+      m_cycle(),
+      m_stats(),
+      m_pending(0),
+      m_queryIndex(0),
+      m_sentAtMs(0),
+      m_nextPollMs(0),
+      m_missed(0),
+      m_everAnswered(false) {
+    if (m_config.missedLimit == 0) {
+        m_config.missedLimit = 1;
+    }
+}
+
+void PrinterStatusMonitor::reset() {
+    m_status = Status();
+    m_cycle = Status();
+    m_stats = Stats();
+    m_pending = 0;
+    m_queryIndex = 0;
+    m_sentAtMs = 0;
+    m_nextPollMs = 0;
+    m_missed = 0;
+    m_everAnswered = false;
+}
+
+bool PrinterStatusMonitor::update(uint32_t nowMs, bool lineIdle) {
+    bool changed = false;
+
+    int received;
+    while ((received = m_port.read()) >= 0) {
+        const uint8_t value = static_cast<uint8_t>(received);
+        if (m_pending == 0 || !isStatusByte(value)) {
+            ++m_stats.strayBytes;
+            continue;
+        }
+        ++m_stats.replies;
+        apply(m_pending, value);
+        m_pending = 0;
+        m_missed = 0;
+        if (++m_queryIndex >= QUERY_COUNT) {
+            m_queryIndex = 0;
+            m_everAnswered = true;
+            ++m_stats.cycles;
+            m_cycle.known = true;
+            m_cycle.responding = true;
+            changed = commit() || changed;
+            m_nextPollMs = nowMs + m_config.pollIntervalMs;
+        }
+    }
+
+    if (m_pending != 0 && timeReached(nowMs, m_sentAtMs + m_config.responseTimeoutMs)) {
+        ++m_stats.timeouts;
+        m_pending = 0;
+        m_queryIndex = 0;  // Restart the cycle so a report is never half old, half new
+        if (m_missed < 0xFF) {
+            ++m_missed;
+        }
+        if (m_everAnswered && m_missed >= m_config.missedLimit && m_status.responding) {
+            m_status.responding = false;
+            changed = true;
+        }
+        m_nextPollMs = nowMs + m_config.pollIntervalMs;
+    }
+
+    if (m_pending == 0 && lineIdle && timeReached(nowMs, m_nextPollMs)) {
+        if (m_queryIndex == 0) {
+            m_cycle = Status();
+        }
+        const uint8_t query = QUERIES[m_queryIndex];
+        const uint8_t command[3] = {DLE, EOT, query};
+        if (m_port.write(command, sizeof(command)) == sizeof(command)) {
+            m_pending = query;
+            m_sentAtMs = nowMs;
+            ++m_stats.queries;
+        }
+    }
+    return changed;
+}
+
+void PrinterStatusMonitor::pollNow(uint32_t nowMs) {
+    if (m_pending == 0) {
+        m_queryIndex = 0;
+    }
+    m_nextPollMs = nowMs;
+}
+
+void PrinterStatusMonitor::apply(uint8_t query, uint8_t value) {
+    switch (query) {
+        case 2:  // Offline status
+            m_cycle.coverOpen = (value & 0x04) != 0;
+            m_cycle.paperOut = m_cycle.paperOut || (value & 0x20) != 0;
+            m_cycle.errorStop = m_cycle.errorStop || (value & 0x40) != 0;
+            break;
+        case 3:  // Error status
+            m_cycle.errorStop = m_cycle.errorStop || (value & 0x08) != 0;
+            m_cycle.overheat = (value & 0x20) != 0;
+            break;
+        case 4:  // Roll paper sensor status
+            m_cycle.paperNearEnd = (value & 0x0C) != 0;
+            m_cycle.paperOut = m_cycle.paperOut || (value & 0x60) != 0;
+            break;
+        default:
+            break;
+    }
+}
+
+bool PrinterStatusMonitor::commit() {
+    if (sameStatus(m_status, m_cycle)) {
+        return false;
+    }
+    m_status = m_cycle;
+    return true;
+}
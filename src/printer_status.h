@@ -0,0 +1,95 @@
+#ifndef PRINTER_STATUS_H
+#define PRINTER_STATUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Non-blocking ESC/POS real-time status poller. Every poll interval it sends
+ * `DLE EOT n` for the offline (2), error (3) and paper sensor (4) reports,
+ * one at a time, and decodes each single-byte reply as it arrives. A printer
+ * that never answers (RX not wired) stays "unknown" and is not treated as
+ * faulty; one that answered before and then goes quiet is reported offline.
+ *
+ * Status requests must not be interleaved with job data, so the caller only
+ * lets a new query out while the line is idle.
+ */
+class PrinterStatusMonitor {
+public:
+    class IPort {
+    public:
+        virtual ~IPort() = default;
+        virtual size_t write(const uint8_t *data, size_t length) = 0;
+        // Next received byte, or -1 when none is waiting.
+        virtual int read() = 0;
+    };
+
+    struct Config {
+        uint32_t pollIntervalMs = 1000;
+        uint32_t responseTimeoutMs = 200;
+        uint8_t missedLimit = 3;  // consecutive timeouts before "offline"
+    };
+
+    struct Status {
+        bool known = false;       // a full poll has been answered at least once
+        bool responding = false;
+        bool paperNearEnd = false;
+        bool paperOut = false;
+        bool coverOpen = false;
+        bool overheat = false;    // auto-recoverable error, head too hot on thermal units
+        bool errorStop = false;   // printer reports it stopped on an error
+
+        bool offline() const { return known && !responding; }
+        bool fault() const { return paperOut || coverOpen || overheat || offline(); }
+    };
+
+    struct Stats {
+        uint32_t queries = 0;
+        uint32_t replies = 0;
+        uint32_t timeouts = 0;
+        uint32_t strayBytes = 0;
+        uint32_t cycles = 0;      // full polls answered
+    };
+
+    static constexpr uint8_t DLE = 0x10;
+    static constexpr uint8_t EOT = 0x04;
+
+    PrinterStatusMonitor(IPort &port);
+    PrinterStatusMonitor(IPort &port, const Config &config);
+
+    // Drains replies and, when `lineIdle`, sends the next query that is due.
+    // Returns true when the decoded status changed.
+    bool update(uint32_t nowMs, bool lineIdle);
+    void reset();
+    // Makes a fresh poll cycle due now (e.g. right after a job went out), so
+    // the next completed cycle reflects the printer after that point.
+    void pollNow(uint32_t nowMs);
+
+    const Status &status() const { return m_status; }
+    const Stats &stats() const { return m_stats; }
+    bool awaitingReply() const { return m_pending != 0; }
+
+    // Replies have bits 1 and 4 set and bits 0 and 7 clear.
+    static bool isStatusByte(uint8_t value) { return (value & 0x93) == 0x12; }
+
+private:
+    static constexpr uint8_t QUERIES[] = {2, 3, 4};
+    static constexpr size_t QUERY_COUNT = sizeof(QUERIES) / sizeof(QUERIES[0]);
+
+    void apply(uint8_t query, uint8_t value);
+    bool commit();
+
+    IPort &m_port;
+    Config m_config;
+    Status m_status;
+    Status m_cycle;          // fields decoded during the current poll cycle
+    Stats m_stats;
+    uint8_t m_pending;       // query awaiting a reply, 0 when none
+    size_t m_queryIndex;
+    uint32_t m_sentAtMs;
+    uint32_t m_nextPollMs;
+    uint8_t m_missed;
+    bool m_everAnswered;
+};
+
+#endif  // PRINTER_STATUS_H
@@ -0,0 +1,269 @@
+#include "raster_text.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+constexpr size_t RASTER_HEADER_BYTES = 8;  // GS v 0 m xL xH yL yH
+constexpr uint8_t MAX_FEED_DOTS = 255;
+
+uint16_t measure(const BitmapFont &font, const std::string &text) {
+    const int width = font.measure(text.data(), text.size());
+    return static_cast<uint16_t>(std::max(0, std::min(width, 0xFFFF)));
+}
+
+void pushLine(const BitmapFont &font, std::string &text, std::vector<TextLine> &out) {
+    TextLine line;
+    line.widthPx = measure(font, text);
+    line.text.swap(text);
+    out.push_back(std::move(line));
+    text.clear();
+}
+
+uint32_t rasterRows(const std::vector<uint8_t> &block) {
+    if (block.size() < RASTER_HEADER_BYTES) {
+        return 0;
+    }
+    return static_cast<uint32_t>(block[6]) | (static_cast<uint32_t>(block[7]) << 8);
+}
+}  // namespace
+
+void wrapText(const BitmapFont &font,
+              const char *text,
+              size_t length,
+              uint16_t maxWidthPx,
+              std::vector<TextLine> &out) {
+    if (!text) {
+        return;
+    }
+
+    size_t start = 0;
+    while (start <= length) {
+        size_t end = start;
+        while (end < length && text[end] != '\n') {
+            ++end;
+        }
+
+        std::string current;
+        size_t pos = start;
+        bool anyWord = false;
+        while (pos < end) {
+            while (pos < end && text[pos] == ' ') {
+                ++pos;
+            }
+            size_t wordEnd = pos;
+            while (wordEnd < end && text[wordEnd] != ' ') {
+                ++wordEnd;
+            }
+            if (wordEnd == pos) {
+                break;
+            }
+            anyWord = true;
+            const std::string word(text + pos, wordEnd - pos);
+            pos = wordEnd;
+
+            std::string candidate = current.empty() ? word : current + " " + word;
+            if (measure(font, candidate) <= maxWidthPx) {
+                current.swap(candidate);
+                continue;
+            }
+            if (!current.empty()) {
+                pushLine(font, current, out);
+            }
+            if (measure(font, word) <= maxWidthPx) {
+                current = word;
+                continue;
+            }
+            // Break an over-long word between glyphs
+            for (char c : word) {
+                std::string next = current + c;
+                if (!current.empty() && measure(font, next) > maxWidthPx) {
+                    pushLine(font, current, out);
+                    next = std::string(1, c);
+                }
+                current.swap(next);
+            }
+        }
+        if (!current.empty() || !anyWord) {
+            pushLine(font, current, out);
+        }
+
+        if (end >= length) {
+            break;
+        }
+        start = end + 1;
+    }
+}
+
+RasterComposer::RasterComposer(BitmapFont &font, uint16_t widthDots)
+    : m_font(font),
+      m_widthDots(widthDots),
+      m_rowBytes(static_cast<uint16_t>((widthDots + 7) / 8)),
+      m_items(),
+      m_next(0),
+      m_textLines(0),
+      m_band() {
+}
+
+void RasterComposer::addRaster(const std::vector<uint8_t> *block) {
+    if (!block || block->empty()) {
+        return;
+    }
+    Item item;
+    item.kind = Item::Kind::Raster;
+    item.block = block;
+    m_items.push_back(item);
+}
+
+size_t RasterComposer::addText(const char *text, size_t length, TextAlign align) {
+    std::vector<TextLine> lines;
+    wrapText(m_font, text, length, m_widthDots, lines);
+    for (auto &line : lines) {
+        Item item;
+        item.kind = Item::Kind::Text;
+        item.line = std::move(line);
+        item.align = align;
+        m_items.push_back(std::move(item));
+    }
+    m_textLines += lines.size();
+    return lines.size();
+}
+
+void RasterComposer::addBlankDots(uint16_t dots) {
+    if (dots == 0) {
+        return;
+    }
+    Item item;
+    item.kind = Item::Kind::Blank;
+    item.dots = dots;
+    m_items.push_back(item);
+}
+
+void RasterComposer::addBlankLines(uint8_t lines) {
+    const uint16_t lineHeight = m_font.lineHeight() ? m_font.lineHeight() : EscPosWriter::DEFAULT_LINE_SPACING_DOTS;
+    addBlankDots(static_cast<uint16_t>(lines * lineHeight));
+}
+
+bool RasterComposer::nextBand(PrintStream &stream) {
+    EscPosWriter out(stream);
+    while (m_next < m_items.size()) {
+        const Item &item = m_items[m_next++];
+        switch (item.kind) {
+            case Item::Kind::Raster:
+                if (out.raster(item.block->data(), item.block->size())) {
+                    return true;
+                }
+                break;  // Malformed block: skip it
+
+            case Item::Kind::Text:
+                if (m_font.lineHeight() == 0) {
+                    break;
+                }
+                renderLine(item);
+                return out.raster(m_band.data(), m_band.size());
+
+            case Item::Kind::Blank: {
+                uint16_t remaining = item.dots;
+                while (remaining > 0) {
+                    const uint8_t dots = static_cast<uint8_t>(std::min<uint16_t>(remaining, MAX_FEED_DOTS));
+                    out.feedDots(dots);
+                    remaining = static_cast<uint16_t>(remaining - dots);
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void RasterComposer::renderLine(const Item &item) {
+    const uint16_t rows = m_font.lineHeight();
+    m_band.assign(RASTER_HEADER_BYTES + static_cast<size_t>(m_rowBytes) * rows, 0x00);
+    m_band[0] = 0x1D;
+    m_band[1] = 'v';
+    m_band[2] = '0';
+    m_band[3] = 0x00;
+    m_band[4] = static_cast<uint8_t>(m_rowBytes & 0xFF);
+    m_band[5] = static_cast<uint8_t>(m_rowBytes >> 8);
+    m_band[6] = static_cast<uint8_t>(rows & 0xFF);
+    m_band[7] = static_cast<uint8_t>(rows >> 8);
+    uint8_t *pixels = m_band.data() + RASTER_HEADER_BYTES;
+
+    int x = 0;
+    const int slack = static_cast<int>(m_widthDots) - item.line.widthPx;
+    if (item.align == TextAlign::Centre) {
+        x = std::max(0, slack / 2);
+    } else if (item.align == TextAlign::Right) {
+        x = std::max(0, slack);
+    }
+
+    const std::string &text = item.line.text;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const uint16_t cp = static_cast<uint8_t>(text[i]);
+        const uint16_t next = (i + 1 < text.size()) ? static_cast<uint8_t>(text[i + 1]) : 0;
+        const BitmapFont::Glyph *glyph = m_font.glyph(cp);
+        if (!glyph) {
+            continue;
+        }
+        const uint8_t *bits = m_font.bitmap(*glyph);
+        if (bits) {
+            const size_t glyphRowBytes = glyph->rowBytes();
+            for (uint16_t gy = 0; gy < glyph->height; ++gy) {
+                const uint32_t y = static_cast<uint32_t>(glyph->yOffset) + gy;
+                if (y >= rows) {
+                    break;
+                }
+                uint8_t *row = pixels + y * m_rowBytes;
+                const uint8_t *src = bits + gy * glyphRowBytes;
+                for (uint16_t gx = 0; gx < glyph->width; ++gx) {
+                    if (!(src[gx >> 3] & (0x80 >> (gx & 7)))) {
+                        continue;
+                    }
+                    const int px = x + glyph->xOffset + gx;
+                    if (px >= 0 && px < m_widthDots) {
+                        row[px >> 3] |= static_cast<uint8_t>(0x80 >> (px & 7));
+                    }
+                }
+            }
+        }
+        x += m_font.advance(cp, next);
+    }
+}
+
+size_t RasterComposer::totalBytes() const {
+    size_t total = 0;
+    const size_t textBand = RASTER_HEADER_BYTES + static_cast<size_t>(m_rowBytes) * m_font.lineHeight();
+    for (const auto &item : m_items) {
+        switch (item.kind) {
+            case Item::Kind::Raster:
+                total += item.block->size();
+                break;
+            case Item::Kind::Text:
+                total += textBand;
+                break;
+            case Item::Kind::Blank:
+                total += 3 * ((item.dots + MAX_FEED_DOTS - 1) / MAX_FEED_DOTS);
+                break;
+        }
+    }
+    return total;
+}
+
+uint32_t RasterComposer::totalDotLines() const {
+    uint32_t total = 0;
+    for (const auto &item : m_items) {
+        switch (item.kind) {
+            case Item::Kind::Raster:
+                total += rasterRows(*item.block);
+                break;
+            case Item::Kind::Text:
+                total += m_font.lineHeight();
+                break;
+            case Item::Kind::Blank:
+                total += item.dots;
+                break;
+        }
+    }
+    return total;
+}
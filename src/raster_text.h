@@ -0,0 +1,76 @@
+#ifndef RASTER_TEXT_H
+#define RASTER_TEXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "bitmap_font.h"
+#include "print_spooler.h"
+
+enum class TextAlign : uint8_t {
+    Left,
+    Centre,
+    Right
+};
+
+struct TextLine {
+    std::string text;
+    uint16_t widthPx = 0;
+};
+
+// Word-wraps Latin-1 text to `maxWidthPx` using the font's advances and
+// kerning. Honors '\n'; words wider than a line are broken between glyphs.
+void wrapText(const BitmapFont &font,
+              const char *text,
+              size_t length,
+              uint16_t maxWidthPx,
+              std::vector<TextLine> &out);
+
+/**
+ * Composes a printout from pre-built raster blocks (the logo), text and
+ * spacing, and hands it to the spooler one band at a time. Text is laid out
+ * when added; pixels are only produced per band, so RAM use is one text
+ * line of raster regardless of the fortune's length.
+ */
+class RasterComposer : public PrintSpooler::IBandSource {
+public:
+    RasterComposer(BitmapFont &font, uint16_t widthDots = 384);
+
+    // The block is referenced, not copied; it must outlive the job.
+    void addRaster(const std::vector<uint8_t> *block);
+    // Returns the number of wrapped lines added.
+    size_t addText(const char *text, size_t length, TextAlign align);
+    void addBlankDots(uint16_t dots);
+    void addBlankLines(uint8_t lines);
+
+    bool nextBand(PrintStream &stream) override;
+    size_t totalBytes() const override;
+    uint32_t totalDotLines() const override;
+
+    size_t textLines() const { return m_textLines; }
+    size_t bandBufferBytes() const { return m_band.capacity(); }
+
+private:
+    struct Item {
+        enum class Kind : uint8_t { Raster, Text, Blank };
+        Kind kind = Kind::Blank;
+        const std::vector<uint8_t> *block = nullptr;
+        TextLine line;
+        TextAlign align = TextAlign::Left;
+        uint16_t dots = 0;
+    };
+
+    void renderLine(const Item &item);
+
+    BitmapFont &m_font;
+    uint16_t m_widthDots;
+    uint16_t m_rowBytes;
+    std::vector<Item> m_items;
+    size_t m_next;
+    size_t m_textLines;
+    std::vector<uint8_t> m_band;
+};
+
+#endif  // RASTER_TEXT_H
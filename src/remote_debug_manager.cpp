@@ -1,6 +1,13 @@
 #include "remote_debug_manager.h"
+
+#include <algorithm>
+#include <stdint.h>
+
+#include "audio_player.h"
 #include "ota_manager.h"
 #include "bluetooth_controller.h"
+#include "loop_profiler.h"
+#include "memory_monitor.h"
 #include "esp_system.h"
 #include "infra/log_sink.h"
 
@@ -11,7 +18,9 @@ RemoteDebugManager::RemoteDebugManager()
       m_enabled(false),
       m_port(23),
       m_autoStreaming(false),
-      m_lastBroadcastSequence(0) {}
+      m_memoryMonitor(nullptr),
+      m_loopProfiler(nullptr),
+      m_audioPlayer(nullptr) {}
 
 bool RemoteDebugManager::begin(int port) {
     m_port = port;
@@ -27,7 +36,7 @@ bool RemoteDebugManager::begin(int port) {
 
     m_server->begin();
     m_enabled = true;
-    m_lastBroadcastSequence = LoggingManager::instance().latestSequence();
+    m_streamCursor = LoggingManager::instance().newestCursor();
 
     infra::emitLog(infra::LogLevel::Info, TAG,
                    "Telnet server started on %d (connect with: telnet %s %d)",
@@ -43,7 +52,12 @@ void RemoteDebugManager::update() {
 
     handleClient();
 
-    if (m_autoStreaming && hasClient()) {
+    if (!hasClient()) {
+        return;
+    }
+    if (m_dump.active) {
+        continueDump();
+    } else if (m_autoStreaming) {
         streamNewEntries();
     }
 }
@@ -99,14 +113,26 @@ void RemoteDebugManager::setBluetoothController(BluetoothController* controller)
     m_bluetooth = controller;
 }
 
+void RemoteDebugManager::setMemoryMonitor(MemoryMonitor* monitor) {
+    m_memoryMonitor = monitor;
+}
+
+void RemoteDebugManager::setLoopProfiler(LoopProfiler* profiler) {
+    m_loopProfiler = profiler;
+}
+
+void RemoteDebugManager::setAudioPlayer(AudioPlayer* player) {
+    m_audioPlayer = player;
+}
+
 void RemoteDebugManager::handleClient() {
     if (!m_client || !m_client.connected()) {
         WiFiClient pending = m_server->available();
         if (pending) {
-            infra::emitLog(infra::LogLevel::Debug, TAG,
-                           "Telnet pending from %s (connected=%d, available=%d)",
-                           pending.remoteIP().toString().c_str(),
-                           pending.connected(), pending.available());
+            INFRA_LOG(infra::LogLevel::Debug, TAG,
+                      "Telnet pending from %s (connected=%d, available=%d)",
+                      pending.remoteIP().toString().c_str(),
+                      pending.connected(), pending.available());
         }
 
         if (m_client) {
@@ -120,14 +146,15 @@ void RemoteDebugManager::handleClient() {
         if (m_client) {
             infra::emitLog(infra::LogLevel::Info, TAG, "Telnet client connected from %s",
                            m_client.remoteIP().toString().c_str());
-            m_lastBroadcastSequence = LoggingManager::instance().latestSequence();
+            m_streamCursor = LoggingManager::instance().newestCursor();
+            m_dump.active = false;
 
             if (m_connectionCallback) {
                 m_connectionCallback();
             }
 
             m_client.println("🛜 RemoteDebug connected");
-            m_client.println("Commands: status, wifi, ota, log, startup, head N, tail N, stream on|off, bluetooth on|off, reboot, help");
+            m_client.println("Commands: status, wifi, ota, mem, perf, audiostats, log, startup, head N, tail N, stream on|off, bluetooth on|off, reboot, help");
             m_client.println("🛜 Hint: run 'startup' to replay boot log; use 'log' for rolling buffer.");
         }
     } else {
@@ -141,9 +168,9 @@ void RemoteDebugManager::handleClient() {
 
 void RemoteDebugManager::processCommand(const String& command) {
     if (command.equalsIgnoreCase("status")) {
-        size_t total = LoggingManager::instance().entryCount();
+        size_t used = LoggingManager::instance().bufferUsed();
         size_t capacity = LoggingManager::instance().bufferCapacity();
-        size_t startup = LoggingManager::instance().startupCount();
+        size_t startup = LoggingManager::instance().startupUsed();
         OTAManager* ota = OTAManager::instance();
         const char* otaStatus = "disabled";
         if (ota && ota->isEnabled()) {
@@ -156,10 +183,27 @@ void RemoteDebugManager::processCommand(const String& command) {
                         WiFi.isConnected() ? "connected" : "disconnected",
                         otaStatus,
                         m_autoStreaming ? "on" : "off");
-        m_client.printf("🛜 Log buffer: %u/%u entries, Startup log: %u lines\n",
-                        static_cast<unsigned>(total),
+        m_client.printf("🛜 Log buffer: %u/%u bytes, Startup log: %u bytes\n",
+                        static_cast<unsigned>(used),
                         static_cast<unsigned>(capacity),
                         static_cast<unsigned>(startup));
+        const SdLogWriter& sdLog = LoggingManager::instance().sdLog();
+        if (sdLog.isActive()) {
+            const SdLogWriter::Stats& sd = sdLog.stats();
+            m_client.printf("🛜 SD log: %lu KB written, %u buffered, %lu deferred, %lu failed, %lu rotations\n",
+                            static_cast<unsigned long>(sd.bytesWritten / 1024),
+                            static_cast<unsigned>(sdLog.buffered()),
+                            static_cast<unsigned long>(sd.deferrals),
+                            static_cast<unsigned long>(sd.failedWrites),
+                            static_cast<unsigned long>(sd.rotations));
+        } else {
+            m_client.println("🛜 SD log: off");
+        }
+        if (m_audioPlayer) {
+            char audioSummary[128];
+            m_audioPlayer->telemetry().writeSummary(audioSummary, sizeof(audioSummary));
+            m_client.printf("🛜 Audio: %s\n", audioSummary);
+        }
     } else if (command.equalsIgnoreCase("wifi")) {
         m_client.printf("🛜 WiFi: %s (%s)\n",
                         WiFi.isConnected() ? "connected" : "disconnected",
@@ -173,34 +217,70 @@ void RemoteDebugManager::processCommand(const String& command) {
         } else {
             m_client.println("🛜 OTA: Disabled");
         }
+    } else if (command.equalsIgnoreCase("mem") || command.equalsIgnoreCase("memory")) {
+        if (!m_memoryMonitor) {
+            m_client.println("🛜 Memory monitor unavailable");
+            return;
+        }
+        m_memoryMonitor->writeReport([this](const char* line) {
+            m_client.printf("🛜 %s\n", line);
+        });
+    } else if (command.equalsIgnoreCase("perf") || command.equalsIgnoreCase("perf reset")) {
+        if (!m_loopProfiler) {
+            m_client.println("🛜 Loop profiler unavailable");
+            return;
+        }
+        if (command.equalsIgnoreCase("perf reset")) {
+            m_loopProfiler->reset();
+            m_client.println("🛜 Loop profile reset");
+            return;
+        }
+        m_loopProfiler->writeReport([this](const char* line) {
+            m_client.printf("🛜 %s\n", line);
+        });
+    } else if (command.equalsIgnoreCase("audiostats") || command.equalsIgnoreCase("audiostats reset")) {
+        if (!m_audioPlayer) {
+            m_client.println("🛜 Audio player unavailable");
+            return;
+        }
+        if (command.equalsIgnoreCase("audiostats reset")) {
+            m_audioPlayer->resetTelemetry();
+            m_client.println("🛜 Audio stats reset");
+            return;
+        }
+        m_audioPlayer->telemetry().writeReport([this](const char* line) {
+            m_client.printf("🛜 %s\n", line);
+        });
+    } else if (command.equalsIgnoreCase("loglevel") || command.startsWith("loglevel ")) {
+        String args = command.substring(strlen("loglevel"));
+        args.trim();
+        infra::runLogLevelCommand(args.c_str(), [this](const char* line) {
+            m_client.printf("🛜 %s\n", line);
+        });
     } else if (command.equalsIgnoreCase("log")) {
-        sendRollingLog();
+        m_client.println("🛜 Rolling log:");
+        startDump(LoggingManager::Source::Rolling,
+                  LoggingManager::instance().oldestCursor(LoggingManager::Source::Rolling),
+                  SIZE_MAX, "rolling log");
     } else if (command.equalsIgnoreCase("startup")) {
-        sendStartupLog();
+        m_client.println("🛜 Startup log:");
+        startDump(LoggingManager::Source::Startup,
+                  LoggingManager::instance().oldestCursor(LoggingManager::Source::Startup),
+                  SIZE_MAX, "startup log");
     } else if (command.startsWith("head")) {
         int lines = command.substring(4).toInt();
         if (lines <= 0) lines = 10;
-        std::vector<LogEntry> entries;
-        uint32_t latest = LoggingManager::instance().latestSequence();
-        uint32_t startSeq = (lines >= static_cast<int>(latest)) ? 0 : (latest - static_cast<uint32_t>(lines));
-        LoggingManager::instance().getEntriesSince(startSeq, entries);
-        if (entries.size() > static_cast<size_t>(lines)) {
-            entries.erase(entries.begin(), entries.end() - lines);
-        }
         m_client.printf("🛜 Last %d lines:\n", lines);
-        for (const auto& entry : entries) {
-            m_client.printf("[%lu ms] %s\n", static_cast<unsigned long>(entry.timestamp), entry.message.c_str());
-        }
+        startDump(LoggingManager::Source::Rolling,
+                  LoggingManager::instance().lastRecordsCursor(static_cast<size_t>(lines)),
+                  static_cast<size_t>(lines), "log");
     } else if (command.startsWith("tail")) {
         int lines = command.substring(4).toInt();
         if (lines <= 0) lines = 10;
-        std::vector<LogEntry> entries;
-        LoggingManager::instance().getStartupEntries(entries);
         m_client.printf("🛜 First %d lines:\n", lines);
-        for (size_t i = 0; i < entries.size() && i < static_cast<size_t>(lines); ++i) {
-            const auto& entry = entries[i];
-            m_client.printf("[%lu ms] %s\n", static_cast<unsigned long>(entry.timestamp), entry.message.c_str());
-        }
+        startDump(LoggingManager::Source::Startup,
+                  LoggingManager::instance().oldestCursor(LoggingManager::Source::Startup),
+                  static_cast<size_t>(lines), "startup log");
     } else if (command.startsWith("stream")) {
         if (command.endsWith("on")) {
             m_autoStreaming = true;
@@ -234,6 +314,7 @@ void RemoteDebugManager::processCommand(const String& command) {
     } else if (command.equalsIgnoreCase("reboot") || command.equalsIgnoreCase("restart")) {
         m_client.println("🛜 Rebooting in 1 second…");
         m_client.flush();
+        LoggingManager::instance().flushSdLog();
         delay(1000);
         esp_restart();
     } else if (command.equalsIgnoreCase("help")) {
@@ -241,6 +322,10 @@ void RemoteDebugManager::processCommand(const String& command) {
         m_client.println("  status        - Show system status");
         m_client.println("  wifi          - Show Wi-Fi information");
         m_client.println("  ota           - Show OTA status");
+        m_client.println("  mem           - Show heap and allocation stats");
+        m_client.println("  perf [reset]  - Show/reset loop stage timings");
+        m_client.println("  audiostats [reset] - Show/reset audio underrun and latency stats");
+        m_client.println("  loglevel [tag] [level] - Show/set log filters (verbose..error, off, default)");
         m_client.println("  log           - Dump rolling log buffer");
         m_client.println("  startup       - Dump startup log buffer");
         m_client.println("  head [N]      - Show last N log entries");
@@ -260,44 +345,51 @@ void RemoteDebugManager::sendToClient(const String& message) {
     }
 }
 
-void RemoteDebugManager::streamNewEntries() {
-    std::vector<LogEntry> entries;
-    LoggingManager::instance().getEntriesSince(m_lastBroadcastSequence, entries);
-    if (entries.empty()) {
-        return;
-    }
-
-    for (const auto& entry : entries) {
-        m_client.printf("[%lu ms] %s\n", static_cast<unsigned long>(entry.timestamp), entry.message.c_str());
-        m_lastBroadcastSequence = entry.sequence;
-    }
+void RemoteDebugManager::writeLogLine(const char* line, size_t length) {
+    m_client.write(reinterpret_cast<const uint8_t*>(line), length);
 }
 
-void RemoteDebugManager::sendStartupLog() {
-    std::vector<LogEntry> entries;
-    LoggingManager::instance().getStartupEntries(entries);
-    if (entries.empty()) {
-        m_client.println("🛜 Startup log empty");
-        return;
+void RemoteDebugManager::streamNewEntries() {
+    // A bounded batch per update; whatever is left waits in the ring
+    const uint32_t lostBefore = m_streamCursor.lostBytes;
+    LoggingManager::instance().readLines(LoggingManager::Source::Rolling, m_streamCursor, LINES_PER_UPDATE,
+                                         [this](const char* line, size_t length) { writeLogLine(line, length); });
+    if (m_streamCursor.lostBytes != lostBefore) {
+        m_client.printf("🛜 %lu log bytes skipped (stream fell behind)\n",
+                        static_cast<unsigned long>(m_streamCursor.lostBytes - lostBefore));
     }
+}
 
-    m_client.printf("🛜 Startup log (%u lines):\n", static_cast<unsigned>(entries.size()));
-    for (const auto& entry : entries) {
-        m_client.printf("[%lu ms] %s\n", static_cast<unsigned long>(entry.timestamp), entry.message.c_str());
-    }
+void RemoteDebugManager::startDump(LoggingManager::Source source, infra::LogRecordRing::Cursor cursor,
+                                   size_t maxLines, const char* label) {
+    m_dump.active = true;
+    m_dump.source = source;
+    m_dump.cursor = cursor;
+    m_dump.remaining = maxLines;
+    m_dump.sent = 0;
+    m_dump.label = label;
 }
 
-void RemoteDebugManager::sendRollingLog() {
-    std::vector<LogEntry> entries;
-    LoggingManager::instance().getEntriesSince(0, entries);
-    if (entries.empty()) {
-        m_client.println("🛜 Rolling log empty");
+void RemoteDebugManager::continueDump() {
+    const size_t budget = std::min(LINES_PER_UPDATE, m_dump.remaining);
+    const size_t sent = LoggingManager::instance().readLines(
+        m_dump.source, m_dump.cursor, budget,
+        [this](const char* line, size_t length) { writeLogLine(line, length); });
+    m_dump.sent += sent;
+    m_dump.remaining -= sent;
+    if (sent == budget && m_dump.remaining > 0) {
         return;
     }
 
-    m_client.printf("🛜 Rolling log (%u entries):\n", static_cast<unsigned>(entries.size()));
-    for (const auto& entry : entries) {
-        m_client.printf("[%lu ms] %s\n", static_cast<unsigned long>(entry.timestamp), entry.message.c_str());
-        m_lastBroadcastSequence = entry.sequence;
+    m_dump.active = false;
+    if (m_dump.sent == 0) {
+        m_client.printf("🛜 No lines in %s\n", m_dump.label);
+    } else {
+        m_client.printf("🛜 End of %s (%u lines)\n", m_dump.label, static_cast<unsigned>(m_dump.sent));
+    }
+    // A rolling listing that reached the head already showed everything the
+    // live stream would have; carry on from there
+    if (m_dump.source == LoggingManager::Source::Rolling && sent < budget) {
+        m_streamCursor = m_dump.cursor;
     }
 }
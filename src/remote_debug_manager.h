@@ -5,7 +5,10 @@
 #include <WiFi.h>
 #include "logging_manager.h"
 
+class AudioPlayer;
 class BluetoothController;
+class LoopProfiler;
+class MemoryMonitor;
 
 class RemoteDebugManager {
 public:
@@ -27,6 +30,9 @@ public:
     void setAutoStreaming(bool enabled);
     bool isAutoStreaming() const;
     void setBluetoothController(BluetoothController* controller);
+    void setMemoryMonitor(MemoryMonitor* monitor);
+    void setLoopProfiler(LoopProfiler* profiler);
+    void setAudioPlayer(AudioPlayer* player);
     
 private:
     WiFiServer* m_server;
@@ -34,8 +40,23 @@ private:
     bool m_enabled;
     int m_port;
     bool m_autoStreaming;
-    uint32_t m_lastBroadcastSequence;
+    // Live stream position in the rolling log
+    infra::LogRecordRing::Cursor m_streamCursor;
+    // A log/startup/head/tail listing in progress; it goes out a batch per
+    // update and holds the live stream back until it is done
+    struct LogDump {
+        bool active = false;
+        LoggingManager::Source source = LoggingManager::Source::Rolling;
+        infra::LogRecordRing::Cursor cursor;
+        size_t remaining = 0;
+        size_t sent = 0;
+        const char* label = "";
+    };
+    LogDump m_dump;
     BluetoothController* m_bluetooth;
+    MemoryMonitor* m_memoryMonitor;
+    LoopProfiler* m_loopProfiler;
+    AudioPlayer* m_audioPlayer;
     
     std::function<void()> m_connectionCallback;
     std::function<void()> m_disconnectionCallback;
@@ -43,9 +64,13 @@ private:
     void handleClient();
     void sendToClient(const String& message);
     void processCommand(const String& command);
+    static constexpr size_t LINES_PER_UPDATE = 16;
+
     void streamNewEntries();
-    void sendStartupLog();
-    void sendRollingLog();
+    void startDump(LoggingManager::Source source, infra::LogRecordRing::Cursor cursor, size_t maxLines,
+                   const char* label);
+    void continueDump();
+    void writeLogLine(const char* line, size_t length);
 };
 
 #endif // REMOTE_DEBUG_MANAGER_H
@@ -37,5 +37,12 @@
 #define APP_ENABLE_BLUETOOTH 1
 #endif
 
+// Per-subsystem heap accounting via global operator new/delete. Adds a small
+// header to every C++ allocation, so the firmware envs turn it off and only
+// esp32dev_diag (and the host tests) build it in.
+#ifndef APP_ENABLE_ALLOC_TRACKING
+#define APP_ENABLE_ALLOC_TRACKING 1
+#endif
+
 #endif  // RUNTIME_MODULE_OPTIONS_H
 
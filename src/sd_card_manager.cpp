@@ -3,7 +3,11 @@
 #include "SD_MMC.h"
 #include "sdmmc_cmd.h"
 #include <Arduino.h>
+#include <cctype>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
 
 static constexpr const char* TAG = "SDCard";
 static constexpr const char* SD_MOUNT_POINT = "/sdcard";
@@ -86,6 +90,8 @@ bool SDCardManager::processSkitFiles(SDCardContent& content) {
     }
 
     infra::emitLog(infra::LogLevel::Info, TAG, "Processing %u skits", static_cast<unsigned>(skitFiles.size()));
+    content.skits.reserve(skitFiles.size());
+    content.audioFiles.reserve(skitFiles.size());
     for (const auto& fileName : skitFiles) {
         String baseName = fileName.substring(0, fileName.lastIndexOf('.'));
         String txtFileName = baseName + ".txt";
@@ -94,9 +100,9 @@ bool SDCardManager::processSkitFiles(SDCardContent& content) {
 
         if (fileExists(fullTxtPath.c_str())) {
             ParsedSkit parsedSkit = parseSkitFile(fullWavPath, fullTxtPath);
-            content.skits.push_back(parsedSkit);
             infra::emitLog(infra::LogLevel::Info, TAG, "Processed skit '%s' (%u lines)",
                            fileName.c_str(), static_cast<unsigned>(parsedSkit.lines.size()));
+            content.skits.push_back(std::move(parsedSkit));
         } else {
             infra::emitLog(infra::LogLevel::Warn, TAG, "Skit '%s' missing txt file", fileName.c_str());
         }
@@ -118,30 +124,56 @@ ParsedSkit SDCardManager::parseSkitFile(const String& wavFile, const String& txt
         return parsedSkit;
     }
 
+    // Parse from a fixed line buffer: no String temporaries per line, so
+    // loading many skits does not salt the heap with short-lived blocks
+    char line[96];
     size_t lineNumber = 0;
     while (file.available()) {
-        String line = readLine(file);
-        line.trim();
-        if (line.length() == 0) continue;
+        size_t length = file.readBytesUntil('\n', line, sizeof(line) - 1);
+        if (length == sizeof(line) - 1) {
+            // The buffer filled before the newline: drop the rest of this line
+            // so it is not parsed as a line of its own. The fields all come
+            // first, so the kept part still parses.
+            size_t dropped = 0;
+            int next;
+            while ((next = file.read()) >= 0 && next != '\n') {
+                ++dropped;
+            }
+            if (dropped > 0) {
+                infra::emitLog(infra::LogLevel::Warn, TAG, "%s: line longer than %u bytes; %u bytes ignored",
+                               txtFile.c_str(), static_cast<unsigned>(sizeof(line) - 1),
+                               static_cast<unsigned>(dropped));
+            }
+        }
+        while (length > 0 && isspace(static_cast<unsigned char>(line[length - 1]))) {
+            --length;
+        }
+        line[length] = '\0';
+        const char *text = line;
+        while (isspace(static_cast<unsigned char>(*text))) {
+            ++text;
+        }
+        if (*text == '\0') continue;
 
         ParsedSkitLine skitLine;
-        int commaIndex1 = line.indexOf(',');
-        int commaIndex2 = line.indexOf(',', commaIndex1 + 1);
-        int commaIndex3 = line.indexOf(',', commaIndex2 + 1);
+        const char *comma1 = strchr(text, ',');
+        const char *comma2 = comma1 ? strchr(comma1 + 1, ',') : nullptr;
+        const char *comma3 = comma2 ? strchr(comma2 + 1, ',') : nullptr;
 
         skitLine.lineNumber = lineNumber++;
-        skitLine.speaker = line.charAt(0);
-        skitLine.timestamp = line.substring(commaIndex1 + 1, commaIndex2).toInt();
-        skitLine.duration = line.substring(commaIndex2 + 1, commaIndex3).toInt();
+        skitLine.speaker = text[0];
+        skitLine.timestamp = comma1 ? strtoul(comma1 + 1, nullptr, 10) : 0;
+        skitLine.duration = comma2 ? strtoul(comma2 + 1, nullptr, 10) : 0;
 
-        if (commaIndex3 != -1) {
-            skitLine.jawPosition = line.substring(commaIndex3 + 1).toFloat();
+        if (comma3) {
+            skitLine.jawPosition = strtof(comma3 + 1, nullptr);
         } else {
             skitLine.jawPosition = -1;  // Indicating dynamic jaw movement
         }
 
         parsedSkit.lines.push_back(skitLine);
     }
+    parsedSkit.lines.shrink_to_fit();
 
     file.close();
     return parsedSkit;
@@ -0,0 +1,200 @@
+#include "sd_log_writer.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+constexpr uint8_t MAX_FILES = 16;
+}  // namespace
+
+SdLogWriter::SdLogWriter()
+    : m_fileSystem(nullptr),
+      m_file(),
+      m_settings(),
+      m_directory(),
+      m_buffer(),
+      m_used(0),
+      m_firstLineMs(0),
+      m_fileBytes(0),
+      m_deferred(false),
+      m_stats() {
+}
+
+bool SdLogWriter::begin(infra::IFileSystem *fileSystem, const Settings &settings) {
+    end();
+    const char *directory = settings.directory ? settings.directory : "";
+    size_t length = strlen(directory);
+    while (length > 1 && directory[length - 1] == '/') {
+        --length;
+    }
+    if (!fileSystem || directory[0] != '/' || length >= MAX_DIRECTORY) {
+        return false;
+    }
+    memcpy(m_directory, directory, length);
+    m_directory[length] = '\0';
+    if (length == 1) {
+        m_directory[0] = '\0';  // Root: paths become "/log0.txt"
+    }
+
+    m_settings = settings;
+    m_settings.directory = m_directory;
+    if (m_settings.maxFiles == 0) {
+        m_settings.maxFiles = 1;
+    } else if (m_settings.maxFiles > MAX_FILES) {
+        m_settings.maxFiles = MAX_FILES;
+    }
+    if (m_settings.maxFileBytes < BLOCK_BYTES) {
+        m_settings.maxFileBytes = BLOCK_BYTES;
+    }
+    m_used = 0;
+    m_deferred = false;
+    m_stats = Stats();
+
+    if (m_directory[0] && !fileSystem->makeDirectory(m_directory)) {
+        return false;
+    }
+    m_fileSystem = fileSystem;
+    if (!openCurrent()) {
+        m_fileSystem = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void SdLogWriter::end() {
+    if (!m_fileSystem) {
+        return;
+    }
+    flush();
+    if (m_file) {
+        m_file->close();
+        m_file.reset();
+    }
+    m_fileSystem = nullptr;
+}
+
+bool SdLogWriter::append(const char *line, size_t length, uint32_t nowMs) {
+    if (!m_fileSystem || !line) {
+        return false;
+    }
+    if (!hasRoom()) {
+        ++m_stats.droppedLines;
+        return false;
+    }
+    if (length > MAX_LINE_BYTES - 1) {
+        length = MAX_LINE_BYTES - 1;
+    }
+    if (m_used == 0) {
+        m_firstLineMs = nowMs;
+    }
+    memcpy(m_buffer + m_used, line, length);
+    m_used += length;
+    m_buffer[m_used++] = '\n';
+    ++m_stats.lines;
+    return true;
+}
+
+bool SdLogWriter::blockDue(uint32_t nowMs) const {
+    if (!m_fileSystem || m_used == 0) {
+        return false;
+    }
+    return m_used >= blockSpan() || nowMs - m_firstLineMs >= m_settings.maxBlockAgeMs;
+}
+
+bool SdLogWriter::service(uint32_t nowMs, bool busAvailable) {
+    if (!blockDue(nowMs)) {
+        return false;
+    }
+    if (!busAvailable) {
+        if (!m_deferred) {
+            ++m_stats.deferrals;
+            m_deferred = true;
+        }
+        return false;
+    }
+    m_deferred = false;
+    const size_t span = blockSpan();
+    return writeBytes(m_used < span ? m_used : span, nowMs);
+}
+
+bool SdLogWriter::flush() {
+    bool ok = true;
+    while (m_fileSystem && m_used > 0) {
+        const size_t span = blockSpan();
+        ok = writeBytes(m_used < span ? m_used : span, m_firstLineMs) && ok;
+    }
+    return ok;
+}
+
+void SdLogWriter::filePath(uint8_t index, char *out, size_t size) const {
+    snprintf(out, size, "%s/log%u.txt", m_directory, static_cast<unsigned>(index));
+}
+
+size_t SdLogWriter::blockSpan() const {
+    return BLOCK_BYTES - (m_fileBytes % BLOCK_BYTES);
+}
+
+bool SdLogWriter::openCurrent() {
+    char path[MAX_PATH];
+    filePath(0, path, sizeof(path));
+    m_file = m_fileSystem->open(path, "a");
+    if (!m_file) {
+        return false;
+    }
+    m_fileBytes = static_cast<uint32_t>(m_file->size());
+    return true;
+}
+
+bool SdLogWriter::writeBytes(size_t count, uint32_t nowMs) {
+    size_t written = 0;
+    if (m_file || openCurrent()) {
+        written = m_file->write(m_buffer, count);
+        m_file->flush();
+    }
+    const bool ok = written == count;
+    if (written) {
+        m_fileBytes += static_cast<uint32_t>(written);
+        m_stats.bytesWritten += static_cast<uint32_t>(written);
+        ++m_stats.blocksWritten;
+    }
+    if (!ok) {
+        // A full or pulled card: drop the block rather than let the buffer
+        // wedge, and reopen on the next attempt
+        ++m_stats.failedWrites;
+        m_stats.lostBytes += static_cast<uint32_t>(count - written);
+        if (m_file) {
+            m_file->close();
+            m_file.reset();
+        }
+    }
+    m_used -= count;
+    memmove(m_buffer, m_buffer + count, m_used);
+    m_firstLineMs = nowMs;
+
+    if (ok && m_fileBytes >= m_settings.maxFileBytes) {
+        rotate();
+    }
+    return ok;
+}
+
+void SdLogWriter::rotate() {
+    if (m_file) {
+        m_file->close();
+        m_file.reset();
+    }
+    char from[MAX_PATH];
+    char to[MAX_PATH];
+    filePath(static_cast<uint8_t>(m_settings.maxFiles - 1), to, sizeof(to));
+    m_fileSystem->remove(to);
+    for (uint8_t index = static_cast<uint8_t>(m_settings.maxFiles - 1); index > 0; --index) {
+        filePath(static_cast<uint8_t>(index - 1), from, sizeof(from));
+        filePath(index, to, sizeof(to));
+        if (m_fileSystem->exists(from)) {
+            m_fileSystem->rename(from, to);
+        }
+    }
+    ++m_stats.rotations;
+    m_fileBytes = 0;
+    // A failed open is retried by the next write
+    openCurrent();
+}
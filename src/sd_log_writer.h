@@ -0,0 +1,95 @@
+#ifndef SD_LOG_WRITER_H
+#define SD_LOG_WRITER_H
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infra/filesystem.h"
+
+/**
+ * Persists log lines to the SD card without competing with audio for the
+ * bus. Lines collect in RAM and reach the card a 4 KB block at a time, at
+ * block-aligned file offsets, so the card sees whole-page appends and one
+ * FAT update per block instead of one per line. The caller decides when the
+ * bus may be used (AudioPlayer::hasSdHeadroom()); a due block simply waits.
+ *
+ * Files rotate by size: <dir>/log0.txt is written, and when it reaches
+ * maxFileBytes it becomes log1.txt and so on, dropping the oldest beyond
+ * maxFiles. A block that sits half full for maxBlockAgeMs is written
+ * anyway, so quiet periods still reach the card.
+ */
+class SdLogWriter {
+public:
+    static constexpr size_t BLOCK_BYTES = 4096;
+    static constexpr size_t MAX_LINE_BYTES = 256;  // Including the newline
+    static constexpr size_t MAX_DIRECTORY = 24;
+    static constexpr size_t MAX_PATH = MAX_DIRECTORY + 16;
+
+    struct Settings {
+        const char *directory = "/logs";
+        uint32_t maxFileBytes = 256 * 1024;
+        uint8_t maxFiles = 4;             // Current file plus rotated ones
+        uint32_t maxBlockAgeMs = 15000;
+    };
+
+    struct Stats {
+        uint32_t lines = 0;
+        uint32_t blocksWritten = 0;
+        uint32_t bytesWritten = 0;
+        uint32_t rotations = 0;
+        uint32_t deferrals = 0;      // Due blocks held back for the audio buffer
+        uint32_t failedWrites = 0;
+        uint32_t droppedLines = 0;   // Appended with no room
+        uint32_t lostBytes = 0;      // Buffered but never written (failed writes)
+    };
+
+    SdLogWriter();
+
+    SdLogWriter(const SdLogWriter &) = delete;
+    SdLogWriter &operator=(const SdLogWriter &) = delete;
+
+    // Opens (or creates) the current file for appending; no SD access after
+    // this except from service() and flush().
+    bool begin(infra::IFileSystem *fileSystem, const Settings &settings);
+    // Writes what is buffered and closes the file.
+    void end();
+    bool isActive() const { return m_fileSystem != nullptr; }
+
+    // Stop feeding lines once this is false; service() makes room again
+    bool hasRoom() const { return m_used < BLOCK_BYTES; }
+    bool append(const char *line, size_t length, uint32_t nowMs);
+
+    bool blockDue(uint32_t nowMs) const;
+    // Writes at most one block, and only when one is due and busAvailable.
+    // Returns true when it wrote.
+    bool service(uint32_t nowMs, bool busAvailable);
+    // Writes everything buffered now, bus or not (before a reboot).
+    bool flush();
+
+    size_t buffered() const { return m_used; }
+    uint32_t fileBytes() const { return m_fileBytes; }
+    const Stats &stats() const { return m_stats; }
+    void filePath(uint8_t index, char *out, size_t size) const;
+
+private:
+    // Bytes that take the file to its next block boundary
+    size_t blockSpan() const;
+    bool openCurrent();
+    bool writeBytes(size_t count, uint32_t nowMs);
+    void rotate();
+
+    infra::IFileSystem *m_fileSystem;
+    std::unique_ptr<infra::IFile> m_file;
+    Settings m_settings;
+    char m_directory[MAX_DIRECTORY];
+    // A block plus one line of spill, so every write can be a full block
+    uint8_t m_buffer[BLOCK_BYTES + MAX_LINE_BYTES];
+    size_t m_used;
+    uint32_t m_firstLineMs;
+    uint32_t m_fileBytes;
+    bool m_deferred;
+    Stats m_stats;
+};
+
+#endif  // SD_LOG_WRITER_H
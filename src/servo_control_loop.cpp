@@ -0,0 +1,199 @@
+#include "servo_control_loop.h"
+
+ServoControlLoop::ServoControlLoop(infra::IPeriodicTimer *timer)
+    : m_timer(timer),
+      m_write(nullptr),
+      m_writeContext(nullptr),
+      m_periodMicros(1000000 / DEFAULT_RATE_HZ),
+      m_elapsedMicros(0),
+      m_mailbox(NO_TARGET),
+      m_commandHead(0),
+      m_commandTail(0),
+      m_moving(false),
+      m_lastWritten(0),
+      m_hasWritten(false),
+      m_ticks(0),
+      m_writes(0),
+      m_directTargets(0),
+      m_coalescedTargets(0),
+      m_droppedCommands(0) {
+}
+
+ServoControlLoop::~ServoControlLoop() {
+    stop();
+}
+
+bool ServoControlLoop::start(uint32_t rateHz, WriteFn write, void *context, int initialDegrees) {
+    stop();
+
+    m_write = write;
+    m_writeContext = context;
+    m_periodMicros = rateHz > 0 ? 1000000 / rateHz : 1000000 / DEFAULT_RATE_HZ;
+    m_elapsedMicros = 0;
+    // Stale direct targets are dropped; queued commands (configure, moves) are kept.
+    m_mailbox.store(NO_TARGET, std::memory_order_relaxed);
+    m_planner.reset(initialDegrees);
+    m_lastWritten.store(m_planner.position(), std::memory_order_relaxed);
+    m_hasWritten = true;  // Caller has already put the servo at initialDegrees
+    m_moving.store(false, std::memory_order_release);
+
+    if (!m_timer || rateHz == 0) {
+        return false;
+    }
+    return m_timer->start(m_periodMicros, &ServoControlLoop::onTimer, this);
+}
+
+void ServoControlLoop::stop() {
+    if (m_timer) {
+        m_timer->stop();
+    }
+}
+
+bool ServoControlLoop::isRunning() const {
+    return m_timer && m_timer->isRunning();
+}
+
+void ServoControlLoop::postTarget(int degrees) {
+    const int32_t previous = m_mailbox.exchange(static_cast<int32_t>(degrees), std::memory_order_acq_rel);
+    if (previous != NO_TARGET) {
+        m_coalescedTargets.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool ServoControlLoop::moveTo(const Keyframe &keyframe) {
+    Command command;
+    command.type = CommandType::MoveTo;
+    command.keyframe = keyframe;
+    return pushCommand(command);
+}
+
+bool ServoControlLoop::enqueue(const Keyframe &keyframe) {
+    Command command;
+    command.type = CommandType::Enqueue;
+    command.keyframe = keyframe;
+    return pushCommand(command);
+}
+
+bool ServoControlLoop::cancel() {
+    Command command;
+    command.type = CommandType::Cancel;
+    return pushCommand(command);
+}
+
+bool ServoControlLoop::configure(int minDegrees, int maxDegrees, float maxVelocityDps, float maxAccelerationDps2) {
+    Command command;
+    command.type = CommandType::Configure;
+    command.minDegrees = minDegrees;
+    command.maxDegrees = maxDegrees;
+    command.maxVelocity = maxVelocityDps;
+    command.maxAcceleration = maxAccelerationDps2;
+    return pushCommand(command);
+}
+
+void ServoControlLoop::tick() {
+    m_elapsedMicros += m_periodMicros;
+    step(static_cast<uint32_t>(m_elapsedMicros / 1000));
+}
+
+void ServoControlLoop::step(uint32_t nowMs) {
+    m_ticks.fetch_add(1, std::memory_order_relaxed);
+
+    const int32_t target = m_mailbox.exchange(NO_TARGET, std::memory_order_acq_rel);
+    if (target != NO_TARGET) {
+        m_planner.reset(static_cast<int>(target));
+        m_directTargets.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Command command;
+    while (popCommand(command)) {
+        applyCommand(command, nowMs);
+    }
+
+    m_planner.update(nowMs);
+    write(m_planner.position());
+
+    if (m_planner.isMoving()) {
+        m_moving.store(true, std::memory_order_release);
+        return;
+    }
+    // Clear first, then look for commands queued since the last pop. A move
+    // pushed after this check sets the flag itself, after our store; one
+    // pushed before it is seen here. Both sides are seq_cst so the store and
+    // the load cannot be reordered past each other.
+    m_moving.store(false);
+    if (m_commandHead.load(std::memory_order_acquire) != m_commandTail.load()) {
+        m_moving.store(true);
+    }
+}
+
+ServoControlLoop::Stats ServoControlLoop::stats() const {
+    Stats snapshot;
+    snapshot.ticks = m_ticks.load(std::memory_order_relaxed);
+    snapshot.writes = m_writes.load(std::memory_order_relaxed);
+    snapshot.directTargets = m_directTargets.load(std::memory_order_relaxed);
+    snapshot.coalescedTargets = m_coalescedTargets.load(std::memory_order_relaxed);
+    snapshot.droppedCommands = m_droppedCommands.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void ServoControlLoop::onTimer(void *context) {
+    static_cast<ServoControlLoop *>(context)->tick();
+}
+
+// Single producer (loop task), single consumer (control task). One slot is
+// kept free to tell full from empty, hence the +1 in the ring size.
+bool ServoControlLoop::pushCommand(const Command &command) {
+    const size_t tail = m_commandTail.load(std::memory_order_relaxed);
+    const size_t next = (tail + 1) % (COMMAND_CAPACITY + 1);
+    if (next == m_commandHead.load(std::memory_order_acquire)) {
+        m_droppedCommands.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_commands[tail] = command;
+    // seq_cst, paired with the clear at the end of step()
+    m_commandTail.store(next);
+    if (command.type == CommandType::MoveTo || command.type == CommandType::Enqueue) {
+        m_moving.store(true);
+    }
+    return true;
+}
+
+bool ServoControlLoop::popCommand(Command &command) {
+    const size_t head = m_commandHead.load(std::memory_order_relaxed);
+    if (head == m_commandTail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    command = m_commands[head];
+    m_commandHead.store((head + 1) % (COMMAND_CAPACITY + 1), std::memory_order_release);
+    return true;
+}
+
+void ServoControlLoop::applyCommand(const Command &command, uint32_t nowMs) {
+    switch (command.type) {
+        case CommandType::MoveTo:
+            m_planner.moveTo(command.keyframe, nowMs);
+            break;
+        case CommandType::Enqueue:
+            m_planner.enqueue(command.keyframe);
+            break;
+        case CommandType::Cancel:
+            m_planner.cancel();
+            break;
+        case CommandType::Configure:
+            m_planner.setBounds(command.minDegrees, command.maxDegrees);
+            m_planner.setLimits(command.maxVelocity, command.maxAcceleration);
+            break;
+    }
+}
+
+void ServoControlLoop::write(int degrees) {
+    if (m_hasWritten && degrees == m_lastWritten.load(std::memory_order_relaxed)) {
+        return;
+    }
+    m_hasWritten = true;
+    m_lastWritten.store(degrees, std::memory_order_relaxed);
+    m_writes.fetch_add(1, std::memory_order_relaxed);
+    if (m_write) {
+        m_write(m_writeContext, degrees);
+    }
+}
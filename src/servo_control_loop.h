@@ -0,0 +1,120 @@
+#ifndef SERVO_CONTROL_LOOP_H
+#define SERVO_CONTROL_LOOP_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infra/periodic_timer.h"
+#include "servo_motion_planner.h"
+
+/**
+ * Fixed-rate servo control. A periodic timer calls tick(), which drains the
+ * inputs, advances the motion planner and writes the servo only when the
+ * whole-degree position changes.
+ *
+ * Inputs are lock-free so producers never block the control task:
+ *  - postTarget(): latest-wins mailbox for direct targets (audio jaw sync).
+ *    Any task may post; a new target replaces one not yet consumed and
+ *    preempts planned motion.
+ *  - moveTo()/enqueue()/cancel()/configure(): single-producer command ring,
+ *    loop task only.
+ */
+class ServoControlLoop {
+public:
+    using Keyframe = ServoMotionPlanner::Keyframe;
+    using WriteFn = void (*)(void *context, int degrees);
+
+    struct Stats {
+        uint32_t ticks = 0;
+        uint32_t writes = 0;
+        uint32_t directTargets = 0;
+        uint32_t coalescedTargets = 0;  // Posted targets replaced before a tick consumed them
+        uint32_t droppedCommands = 0;
+    };
+
+    static constexpr uint32_t DEFAULT_RATE_HZ = 100;
+    static constexpr size_t COMMAND_CAPACITY = 8;
+
+    explicit ServoControlLoop(infra::IPeriodicTimer *timer);
+    ~ServoControlLoop();
+
+    ServoControlLoop(const ServoControlLoop &) = delete;
+    ServoControlLoop &operator=(const ServoControlLoop &) = delete;
+
+    // Starts ticking at rateHz from initialDegrees. Returns false when the
+    // timer is missing or refuses to start; the caller can then drive
+    // step(now) from its loop instead.
+    bool start(uint32_t rateHz, WriteFn write, void *context, int initialDegrees);
+    // Returns after any tick in flight has finished writing.
+    void stop();
+    bool isRunning() const;
+
+    void postTarget(int degrees);
+
+    bool moveTo(const Keyframe &keyframe);
+    bool enqueue(const Keyframe &keyframe);
+    bool cancel();
+    bool configure(int minDegrees, int maxDegrees, float maxVelocityDps, float maxAccelerationDps2);
+
+    // Timer entry point; advances the clock by one period.
+    void tick();
+    // Single control step at an explicit time (fallback when no timer runs).
+    void step(uint32_t nowMs);
+
+    bool isMoving() const { return m_moving.load(std::memory_order_acquire); }
+    int lastWritten() const { return m_lastWritten.load(std::memory_order_relaxed); }
+    uint32_t periodMicros() const { return m_periodMicros; }
+    Stats stats() const;
+
+private:
+    enum class CommandType : uint8_t {
+        MoveTo,
+        Enqueue,
+        Cancel,
+        Configure
+    };
+
+    struct Command {
+        CommandType type = CommandType::Cancel;
+        Keyframe keyframe;
+        int minDegrees = 0;
+        int maxDegrees = 0;
+        float maxVelocity = 0.0f;
+        float maxAcceleration = 0.0f;
+    };
+
+    static void onTimer(void *context);
+
+    bool pushCommand(const Command &command);
+    bool popCommand(Command &command);
+    void applyCommand(const Command &command, uint32_t nowMs);
+    void write(int degrees);
+
+    static constexpr int32_t NO_TARGET = INT32_MIN;
+
+    infra::IPeriodicTimer *m_timer;
+    WriteFn m_write;
+    void *m_writeContext;
+    uint32_t m_periodMicros;
+    uint64_t m_elapsedMicros;
+
+    ServoMotionPlanner m_planner;
+
+    std::atomic<int32_t> m_mailbox;
+    Command m_commands[COMMAND_CAPACITY + 1];
+    std::atomic<size_t> m_commandHead;  // Consumer index
+    std::atomic<size_t> m_commandTail;  // Producer index
+
+    std::atomic<bool> m_moving;
+    std::atomic<int> m_lastWritten;
+    bool m_hasWritten;
+
+    std::atomic<uint32_t> m_ticks;
+    std::atomic<uint32_t> m_writes;
+    std::atomic<uint32_t> m_directTargets;
+    std::atomic<uint32_t> m_coalescedTargets;
+    std::atomic<uint32_t> m_droppedCommands;
+};
+
+#endif  // SERVO_CONTROL_LOOP_H
@@ -1,6 +1,7 @@
 #include "servo_controller.h"
 #include "logging_manager.h"
 #include "config_manager.h"
+#include "infra/esp_periodic_timer.h"
 #include <algorithm>
 #include <cmath>
 
@@ -17,7 +18,11 @@ ServoController::ServoController()
       smoothedPosition(0),
       lastPosition(0),
       maxObservedRMS(0),
-      shouldInterruptMovement(false)
+      maxVelocityDps(DEFAULT_MAX_VELOCITY_DPS),
+      maxAccelerationDps2(DEFAULT_MAX_ACCELERATION_DPS2),
+      controlTimer(new infra::EspPeriodicTimer("servo")),
+      controlLoop(controlTimer.get()),
+      controlLoopStarted(false)
 {
 }
 
@@ -57,6 +62,7 @@ void ServoController::initialize(int pin, int minDeg, int maxDeg)
     LOG_DEBUG(TAG, "Servo animation init: moving to min position (%d degrees)", minDegrees);
     setPosition(minDegrees);
     LOG_INFO(TAG, "Servo animation init complete");
+    startControlLoop();
 }
 
 void ServoController::initialize(int pin, int minDeg, int maxDeg, int minUs, int maxUs)
@@ -95,9 +101,21 @@ void ServoController::initialize(int pin, int minDeg, int maxDeg, int minUs, int
     LOG_DEBUG(TAG, "Servo animation init: moving to min position (%d degrees)", minDegrees);
     setPosition(minDegrees);
     LOG_INFO(TAG, "Servo animation init complete");
+    startControlLoop();
 }
 
 void ServoController::setPosition(int degrees)
+{
+    // Direct targets win over planned motion. Once the control loop runs they go
+    // through its mailbox, so callers on any task never touch LEDC themselves.
+    const int constrainedDegrees = constrain(degrees, minDegrees, maxDegrees);
+    controlLoop.postTarget(constrainedDegrees);
+    if (!controlLoop.isRunning()) {
+        writeAngle(constrainedDegrees);
+    }
+}
+
+void ServoController::writeAngle(int degrees)
 {
     int constrainedDegrees = constrain(degrees, minDegrees, maxDegrees);
     int angleToSend = constrainedDegrees;
@@ -109,14 +127,6 @@ void ServoController::setPosition(int degrees)
     
     servo.write(angleToSend);
 
-    // LOG_DEBUG(TAG,
-    //           "setPosition(%d°) within [%d,%d]° (µs %d-%d)",
-    //           angleToSend,
-    //           minDegrees,
-    //           maxDegrees,
-    //           minMicroseconds,
-    //           maxMicroseconds);
-
     // Track the original (non-inverted) position for our own bookkeeping
     currentPosition = constrainedDegrees;
 }
@@ -136,6 +146,7 @@ void ServoController::setMinMaxDegrees(int minDeg, int maxDeg)
 {
     minDegrees = minDeg;
     maxDegrees = maxDeg;
+    controlLoop.configure(minDegrees, maxDegrees, maxVelocityDps, maxAccelerationDps2);
 }
 
 int ServoController::mapRMSToPosition(double rms, double silenceThreshold)
@@ -178,44 +189,71 @@ void ServoController::updatePosition(int targetPosition, double alpha, int minMo
 
 void ServoController::smoothMove(int targetPosition, int duration)
 {
-    int startPosition = currentPosition;
-    unsigned long startTime = millis();
-    unsigned long endTime = startTime + duration;
+    moveTo(targetPosition, duration > 0 ? static_cast<uint32_t>(duration) : 0, Easing::Linear);
+}
 
-    shouldInterruptMovement = false;
+void ServoController::moveTo(int targetPosition, uint32_t durationMs, Easing easing, uint32_t holdMs)
+{
+    ServoMotionPlanner::Keyframe keyframe;
+    keyframe.targetDegrees = targetPosition;
+    keyframe.durationMs = durationMs;
+    keyframe.easing = easing;
+    keyframe.holdMs = holdMs;
+    if (!controlLoop.moveTo(keyframe)) {
+        LOG_WARN(TAG, "Servo command queue full; dropping move to %d degrees", targetPosition);
+    }
+}
 
-    while (millis() < endTime)
-    {
-        if (shouldInterruptMovement)
-        {
-            shouldInterruptMovement = false;
-            return;
-        }
-
-        unsigned long currentTime = millis();
-        float progress = static_cast<float>(currentTime - startTime) / duration;
-
-        if (progress < 0.0f)
-        {
-            progress = 0.0f;
-        }
-        else if (progress > 1.0f)
-        {
-            progress = 1.0f;
-        }
-
-        int newPosition = startPosition + (targetPosition - startPosition) * progress;
+bool ServoController::queueMove(int targetPosition, uint32_t durationMs, Easing easing, uint32_t holdMs)
+{
+    ServoMotionPlanner::Keyframe keyframe;
+    keyframe.targetDegrees = targetPosition;
+    keyframe.durationMs = durationMs;
+    keyframe.easing = easing;
+    keyframe.holdMs = holdMs;
+    if (!controlLoop.enqueue(keyframe)) {
+        LOG_WARN(TAG, "Servo command queue full; dropping move to %d degrees", targetPosition);
+        return false;
+    }
+    return true;
+}
 
-        setPosition(newPosition);
-        delay(20);
+void ServoController::update(unsigned long now)
+{
+    if (controlLoopStarted && !controlLoop.isRunning())
+    {
+        controlLoop.step(static_cast<uint32_t>(now));
     }
+}
 
-    setPosition(targetPosition);
+void ServoController::setMotionLimits(float maxVelocity, float maxAcceleration)
+{
+    maxVelocityDps = maxVelocity;
+    maxAccelerationDps2 = maxAcceleration;
+    controlLoop.configure(minDegrees, maxDegrees, maxVelocityDps, maxAccelerationDps2);
 }
 
 void ServoController::interruptMovement()
 {
-    shouldInterruptMovement = true;
+    controlLoop.cancel();
+}
+
+void ServoController::startControlLoop()
+{
+    controlLoopStarted = true;
+    if (controlLoop.start(CONTROL_RATE_HZ, &ServoController::writeFromControlLoop, this, currentPosition))
+    {
+        LOG_INFO(TAG, "Servo control loop running at %u Hz", static_cast<unsigned>(CONTROL_RATE_HZ));
+    }
+    else
+    {
+        LOG_WARN(TAG, "Servo control timer unavailable; stepping from loop() instead");
+    }
+}
+
+void ServoController::writeFromControlLoop(void *context, int degrees)
+{
+    static_cast<ServoController *>(context)->writeAngle(degrees);
 }
 
 void ServoController::reattachWithConfigLimits()
@@ -225,6 +263,9 @@ void ServoController::reattachWithConfigLimits()
     maxMicroseconds = config.getServoUSMax();
     reverseDirection = config.getServoReverse();
 
+    // Keep the control task off the servo while it is re-attached and swept;
+    // stop() waits out a tick that is already writing.
+    controlLoop.stop();
     servo.detach();
     servo.attach(servoPin,
                 Servo::CHANNEL_NOT_ATTACHED,
@@ -254,4 +295,5 @@ void ServoController::reattachWithConfigLimits()
     LOG_DEBUG(TAG, "Servo config animation: moving to min position (%d degrees)", minDegrees);
     setPosition(minDegrees);
     LOG_INFO(TAG, "Servo config animation complete");
+    startControlLoop();
 }
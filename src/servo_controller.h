@@ -4,11 +4,17 @@
 #include <Arduino.h>
 #include <Servo.h>
 
+#include <memory>
+
+#include "infra/periodic_timer.h"
+#include "servo_control_loop.h"
+#include "servo_motion_planner.h"
+
 class ServoController {
 private:
     Servo servo;
     int servoPin;
-    int currentPosition;
+    volatile int currentPosition;  // Written by the control task once the loop runs
     int minDegrees;
     int maxDegrees;
     int minMicroseconds;  // Hard limits - NEVER exceed these
@@ -17,9 +23,24 @@ private:
     double smoothedPosition;
     int lastPosition;
     double maxObservedRMS;
-    bool shouldInterruptMovement;  // Renamed from interruptMovement
+    float maxVelocityDps;
+    float maxAccelerationDps2;
+    std::unique_ptr<infra::IPeriodicTimer> controlTimer;
+    ServoControlLoop controlLoop;
+    bool controlLoopStarted;
+
+    void writeAngle(int degrees);
+    void startControlLoop();
+    static void writeFromControlLoop(void *context, int degrees);
 
 public:
+    using Easing = ServoMotionPlanner::Easing;
+
+    // Default motion limits for planned moves (direct setPosition writes are unlimited)
+    static constexpr float DEFAULT_MAX_VELOCITY_DPS = 360.0f;
+    static constexpr float DEFAULT_MAX_ACCELERATION_DPS2 = 3000.0f;
+    static constexpr uint32_t CONTROL_RATE_HZ = ServoControlLoop::DEFAULT_RATE_HZ;
+
     ServoController();
     void initialize(int pin, int minDeg, int maxDeg);
     void initialize(int pin, int minDeg, int maxDeg, int minUs, int maxUs);
@@ -29,7 +50,17 @@ public:
     void setMinMaxDegrees(int minDeg, int maxDeg);
     int mapRMSToPosition(double rms, double silenceThreshold);
     void updatePosition(int targetPosition, double alpha, int minMovementThreshold);
+    // Non-blocking linear move from the current position; preempts queued motion
     void smoothMove(int targetPosition, int duration);
+    // Preempting move with easing and an optional hold at the target
+    void moveTo(int targetPosition, uint32_t durationMs, Easing easing, uint32_t holdMs = 0);
+    // Appends a keyframe after any queued motion; returns false when the queue is full
+    bool queueMove(int targetPosition, uint32_t durationMs, Easing easing, uint32_t holdMs = 0);
+    // Steps the control loop from loop() when the control timer could not start
+    void update(unsigned long now);
+    bool isMoving() const { return controlLoop.isMoving(); }
+    ServoControlLoop::Stats controlStats() const { return controlLoop.stats(); }
+    void setMotionLimits(float maxVelocityDps, float maxAccelerationDps2);
     void interruptMovement();
     
     // Re-attach servo with config limits (call after config loads)
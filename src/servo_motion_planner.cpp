@@ -0,0 +1,206 @@
+#include "servo_motion_planner.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr float ARRIVAL_TOLERANCE_DEGREES = 0.01f;
+
+float clampFloat(float value, float low, float high) {
+    if (value < low) {
+        return low;
+    }
+    if (value > high) {
+        return high;
+    }
+    return value;
+}
+
+}  // namespace
+
+ServoMotionPlanner::ServoMotionPlanner()
+    : m_head(0),
+      m_count(0),
+      m_active(false),
+      m_position(0.0f),
+      m_velocity(0.0f),
+      m_lastUpdateMs(0),
+      m_hasLastUpdate(false),
+      m_lastReported(0),
+      m_minDegrees(0),
+      m_maxDegrees(180),
+      m_maxVelocity(0.0f),
+      m_maxAcceleration(0.0f) {
+}
+
+void ServoMotionPlanner::setBounds(int minDegrees, int maxDegrees) {
+    if (minDegrees > maxDegrees) {
+        const int swap = minDegrees;
+        minDegrees = maxDegrees;
+        maxDegrees = swap;
+    }
+    m_minDegrees = minDegrees;
+    m_maxDegrees = maxDegrees;
+    m_position = clampToBounds(m_position);
+}
+
+void ServoMotionPlanner::setLimits(float maxVelocityDps, float maxAccelerationDps2) {
+    m_maxVelocity = maxVelocityDps > 0.0f ? maxVelocityDps : 0.0f;
+    m_maxAcceleration = maxAccelerationDps2 > 0.0f ? maxAccelerationDps2 : 0.0f;
+}
+
+void ServoMotionPlanner::reset(int positionDegrees) {
+    m_head = 0;
+    m_count = 0;
+    m_active = false;
+    m_position = clampToBounds(static_cast<float>(positionDegrees));
+    m_velocity = 0.0f;
+    m_lastReported = position();
+}
+
+bool ServoMotionPlanner::enqueue(const Keyframe &keyframe) {
+    if (m_count >= MAX_KEYFRAMES) {
+        return false;
+    }
+    m_queue[(m_head + m_count) % MAX_KEYFRAMES] = keyframe;
+    ++m_count;
+    return true;
+}
+
+void ServoMotionPlanner::moveTo(const Keyframe &keyframe, uint32_t nowMs) {
+    m_head = 0;
+    m_count = 0;
+    if (!m_hasLastUpdate) {
+        m_lastUpdateMs = nowMs;
+        m_hasLastUpdate = true;
+    }
+    startSegment(keyframe, nowMs);
+}
+
+void ServoMotionPlanner::cancel() {
+    m_head = 0;
+    m_count = 0;
+    m_active = false;
+    m_velocity = 0.0f;
+}
+
+bool ServoMotionPlanner::update(uint32_t nowMs) {
+    float dt = 0.0f;
+    if (m_hasLastUpdate) {
+        dt = static_cast<float>(nowMs - m_lastUpdateMs) / 1000.0f;
+    }
+    m_lastUpdateMs = nowMs;
+    m_hasLastUpdate = true;
+
+    if (!m_active) {
+        Keyframe next;
+        if (!popKeyframe(next)) {
+            m_velocity = 0.0f;
+            return false;
+        }
+        startSegment(next, nowMs);
+    }
+
+    const uint32_t elapsed = nowMs - m_segment.startMs;
+    float t = 1.0f;
+    if (m_segment.durationMs > 0 && elapsed < m_segment.durationMs) {
+        t = static_cast<float>(elapsed) / static_cast<float>(m_segment.durationMs);
+    }
+    const float span = m_segment.targetDegrees - m_segment.startDegrees;
+    const float desired = m_segment.startDegrees + span * ease(m_segment.easing, t);
+    const bool limited = m_maxVelocity > 0.0f || m_maxAcceleration > 0.0f;
+
+    if (dt > 0.0f) {
+        float next = desired;
+        if (limited) {
+            float velocity = (desired - m_position) / dt;
+            const float remaining = m_segment.targetDegrees - m_position;
+            if (m_maxAcceleration > 0.0f) {
+                // Brake early enough to stop on the target instead of overshooting:
+                // the fastest v that still satisfies v*dt/2 + v^2/(2a) <= remaining.
+                const float brake = m_maxAcceleration * dt;
+                const float stopVelocity =
+                    0.5f * (std::sqrt(brake * brake + 8.0f * m_maxAcceleration * std::fabs(remaining)) - brake);
+                if (velocity * remaining > 0.0f && std::fabs(velocity) > stopVelocity) {
+                    velocity = std::copysign(stopVelocity, velocity);
+                }
+                const float maxDelta = m_maxAcceleration * dt;
+                velocity = clampFloat(velocity, m_velocity - maxDelta, m_velocity + maxDelta);
+            }
+            if (m_maxVelocity > 0.0f) {
+                velocity = clampFloat(velocity, -m_maxVelocity, m_maxVelocity);
+            }
+            next = m_position + velocity * dt;
+            if (remaining * (m_segment.targetDegrees - next) < 0.0f) {
+                next = m_segment.targetDegrees;
+            }
+        }
+        next = clampToBounds(next);
+        m_velocity = (next - m_position) / dt;
+        m_position = next;
+    } else if (!limited) {
+        m_position = clampToBounds(desired);
+    }
+
+    const bool timeUp = elapsed >= m_segment.durationMs + m_segment.holdMs;
+    if (timeUp && std::fabs(m_segment.targetDegrees - m_position) <= ARRIVAL_TOLERANCE_DEGREES) {
+        m_position = m_segment.targetDegrees;
+        m_active = false;
+        Keyframe next;
+        if (popKeyframe(next)) {
+            startSegment(next, nowMs);
+        } else {
+            m_velocity = 0.0f;
+        }
+    }
+
+    const int current = position();
+    if (current != m_lastReported) {
+        m_lastReported = current;
+        return true;
+    }
+    return false;
+}
+
+int ServoMotionPlanner::position() const {
+    return static_cast<int>(std::lround(m_position));
+}
+
+float ServoMotionPlanner::ease(Easing easing, float t) {
+    t = clampFloat(t, 0.0f, 1.0f);
+    switch (easing) {
+        case Easing::EaseIn:
+            return t * t;
+        case Easing::EaseOut:
+            return 1.0f - (1.0f - t) * (1.0f - t);
+        case Easing::EaseInOut:
+            return t * t * (3.0f - 2.0f * t);
+        case Easing::Linear:
+        default:
+            return t;
+    }
+}
+
+void ServoMotionPlanner::startSegment(const Keyframe &keyframe, uint32_t nowMs) {
+    m_segment.startDegrees = m_position;
+    m_segment.targetDegrees = clampToBounds(static_cast<float>(keyframe.targetDegrees));
+    m_segment.startMs = nowMs;
+    m_segment.durationMs = keyframe.durationMs;
+    m_segment.holdMs = keyframe.holdMs;
+    m_segment.easing = keyframe.easing;
+    m_active = true;
+}
+
+bool ServoMotionPlanner::popKeyframe(Keyframe &out) {
+    if (m_count == 0) {
+        return false;
+    }
+    out = m_queue[m_head];
+    m_head = (m_head + 1) % MAX_KEYFRAMES;
+    --m_count;
+    return true;
+}
+
+float ServoMotionPlanner::clampToBounds(float degrees) const {
+    return clampFloat(degrees, static_cast<float>(m_minDegrees), static_cast<float>(m_maxDegrees));
+}
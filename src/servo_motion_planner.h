@@ -0,0 +1,92 @@
+#ifndef SERVO_MOTION_PLANNER_H
+#define SERVO_MOTION_PLANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Time-sliced jaw motion. Keyframes are queued and then advanced by update(now)
+ * from the loop (or a timer task). Each step follows an easing curve and is
+ * clamped to the configured velocity/acceleration limits, so the caller never
+ * blocks waiting for the servo to arrive.
+ */
+class ServoMotionPlanner {
+public:
+    enum class Easing : uint8_t {
+        Linear = 0,
+        EaseIn,
+        EaseOut,
+        EaseInOut
+    };
+
+    struct Keyframe {
+        int targetDegrees = 0;
+        uint32_t durationMs = 0;
+        Easing easing = Easing::EaseInOut;
+        uint32_t holdMs = 0;  // Dwell at the target before the next keyframe starts
+    };
+
+    static constexpr size_t MAX_KEYFRAMES = 8;
+
+    ServoMotionPlanner();
+
+    void setBounds(int minDegrees, int maxDegrees);
+    // Limits in degrees/s and degrees/s^2; zero disables the limit.
+    void setLimits(float maxVelocityDps, float maxAccelerationDps2);
+
+    // Snaps to a position and drops any queued motion.
+    void reset(int positionDegrees);
+
+    // Appends a keyframe after the queued ones. Returns false when full.
+    bool enqueue(const Keyframe &keyframe);
+    // Preempts current motion: drops the queue and heads for the keyframe from
+    // the current position, keeping the current velocity.
+    void moveTo(const Keyframe &keyframe, uint32_t nowMs);
+    // Stops where the jaw is now.
+    void cancel();
+
+    // Advances motion to nowMs. Returns true when the whole-degree position changed.
+    bool update(uint32_t nowMs);
+
+    int position() const;
+    float positionExact() const { return m_position; }
+    float velocity() const { return m_velocity; }
+    bool isMoving() const { return m_active || m_count > 0; }
+    size_t queued() const { return m_count; }
+
+    static float ease(Easing easing, float t);
+
+private:
+    struct Segment {
+        float startDegrees = 0.0f;
+        float targetDegrees = 0.0f;
+        uint32_t startMs = 0;
+        uint32_t durationMs = 0;
+        uint32_t holdMs = 0;
+        Easing easing = Easing::Linear;
+    };
+
+    void startSegment(const Keyframe &keyframe, uint32_t nowMs);
+    bool popKeyframe(Keyframe &out);
+    float clampToBounds(float degrees) const;
+
+    Keyframe m_queue[MAX_KEYFRAMES];
+    size_t m_head;
+    size_t m_count;
+
+    Segment m_segment;
+    bool m_active;
+
+    float m_position;
+    float m_velocity;
+    uint32_t m_lastUpdateMs;
+    bool m_hasLastUpdate;
+    int m_lastReported;
+
+    int m_minDegrees;
+    int m_maxDegrees;
+    float m_maxVelocity;
+    float m_maxAcceleration;
+};
+
+#endif  // SERVO_MOTION_PLANNER_H
@@ -16,6 +16,7 @@
 
 #include "skull_audio_animator.h"
 #include "logging_manager.h"
+#include "infra/alloc_tracker.h"
 
 static constexpr const char* TAG = "SkullAnimator";
 #include <cmath>
@@ -37,6 +38,8 @@ SkullAudioAnimator::SkullAudioAnimator(bool isPrimary, ServoController &servoCon
       m_currentSkitLineNumber(-1),
       m_smoothedAmplitude(0.0),
       m_previousJawPosition(servoMinDegrees),
+      m_eyeLevel(-1),
+      m_mouthLevel(-1),
       FFT(vReal, vImag, SAMPLES, SAMPLE_RATE),
       m_jawHoldActive(false),
       m_jawHoldPosition(servoMinDegrees)
@@ -46,6 +49,8 @@ SkullAudioAnimator::SkullAudioAnimator(bool isPrimary, ServoController &servoCon
 // Main function to process incoming audio frames and update animations
 void SkullAudioAnimator::processAudioFrames(const Frame *frames, int32_t frameCount, const String &currentFile, unsigned long playbackTime)
 {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Animator);
+
     // Update internal state based on new audio data
     m_currentFile = currentFile;
     m_currentPlaybackTime = playbackTime;
@@ -53,10 +58,12 @@ void SkullAudioAnimator::processAudioFrames(const Frame *frames, int32_t frameCo
 
     // Serial.printf("SkullAudioAnimator::processAudioFrames() m_currentFile: %s, m_isAudioPlaying: %s, frameCount: %d, isSpeaking: %s\n", m_currentFile.c_str(), m_isAudioPlaying ? "true" : "false", frameCount, m_isCurrentlySpeaking ? "true" : "false");
 
-    // Process audio frames for various animations
+    // Process audio frames for various animations; the block is measured once
+    // and the jaw and lights both work from that record
     updateSkit();
-    updateEyes();
-    updateJawPosition(frames, frameCount);
+    const AudioBlockFeatures block = measureBlock(frames, frameCount);
+    updateJawPosition(block);
+    updateLights(block);
 }
 
 void SkullAudioAnimator::setPlaybackEnded(const String &filePath)
@@ -73,7 +80,7 @@ void SkullAudioAnimator::setPlaybackEnded(const String &filePath)
 
     // Process audio frames for various animations
     updateSkit();
-    updateEyes();
+    updateLights(AudioBlockFeatures());
 }
 
 void SkullAudioAnimator::setJawHoldOverride(bool active, int holdPositionDegrees)
@@ -92,6 +99,11 @@ void SkullAudioAnimator::setJawHoldOverride(bool active, int holdPositionDegrees
     }
 }
 
+void SkullAudioAnimator::setLightEnvelope(const AudioEnvelope::Settings &settings)
+{
+    m_lightEnvelope.configure(settings);
+}
+
 // Updates the current skit state and speaking status based on audio playback
 // States:
 // - No audio files = not speaking
@@ -182,25 +194,52 @@ void SkullAudioAnimator::updateSkit()
     }
 }
 
-// Updates the eye brightness based on the speaking state
-void SkullAudioAnimator::updateEyes()
+// Eyes swing between dim and max with the speech envelope; while not
+// speaking the envelope releases back down to dim instead of snapping. The
+// mouth LED is scaled the same way while audio plays (see
+// LightController::setMouthAudioLevel). This runs on the A2DP callback, so
+// it only publishes target levels; LightController::update() applies them
+// on the loop task. Levels are only published when they change.
+void SkullAudioAnimator::updateLights(const AudioBlockFeatures &block)
 {
-    if (m_isCurrentlySpeaking)
+    uint8_t eyeLevel = LightController::BRIGHTNESS_DIM;
+    uint8_t mouthLevel = LightController::BRIGHTNESS_MAX;
+    if (block.frames == 0)
     {
-        m_lightController.setEyeBrightness(LightController::BRIGHTNESS_MAX);
+        // Playback ended: settle immediately and re-sync with whatever else set the LEDs
+        m_lightEnvelope.reset();
+        m_eyeLevel = -1;
+        m_mouthLevel = -1;
     }
     else
     {
-        m_lightController.setEyeBrightness(LightController::BRIGHTNESS_DIM);
+        AudioBlockFeatures drive = block;
+        if (!m_isCurrentlySpeaking)
+        {
+            drive.rms = 0.0f;
+        }
+        m_lightEnvelope.update(drive);
+        eyeLevel = m_lightEnvelope.level(LightController::BRIGHTNESS_DIM, LightController::BRIGHTNESS_MAX);
+        mouthLevel = m_lightEnvelope.level(MOUTH_AUDIO_FLOOR, LightController::BRIGHTNESS_MAX);
+    }
+
+    if (eyeLevel != m_eyeLevel)
+    {
+        m_lightController.setEyeBrightness(eyeLevel);
+        m_eyeLevel = eyeLevel;
+    }
+    if (mouthLevel != m_mouthLevel)
+    {
+        m_lightController.setMouthAudioLevel(mouthLevel);
+        m_mouthLevel = mouthLevel;
     }
 }
 
-void SkullAudioAnimator::updateJawPosition(const Frame *frames, int32_t frameCount)
+void SkullAudioAnimator::updateJawPosition(const AudioBlockFeatures &block)
 {
-    // Interrupt any ongoing smooth movement
-    m_servoController.interruptMovement();
-
-    if (frameCount <= 0)
+    // setPosition posts to the servo control loop's mailbox; it preempts any
+    // planned motion and only the latest target per control tick is applied.
+    if (block.frames == 0)
     {
         if (m_jawHoldActive)
         {
@@ -225,8 +264,7 @@ void SkullAudioAnimator::updateJawPosition(const Frame *frames, int32_t frameCou
 
     // Process audio-driven jaw motion while audio is playing
     {
-        // Compute RMS amplitude over the frames
-        double rmsAmplitude = calculateRMSFromFrames(frames, frameCount);
+        double rmsAmplitude = block.rms;
 
         // Apply exponential smoothing to the amplitude
         m_smoothedAmplitude = AMPLITUDE_SMOOTHING_FACTOR * rmsAmplitude + (1 - AMPLITUDE_SMOOTHING_FACTOR) * m_smoothedAmplitude;
@@ -258,8 +296,12 @@ void SkullAudioAnimator::updateJawPosition(const Frame *frames, int32_t frameCou
     }
 }
 
-double SkullAudioAnimator::calculateRMSFromFrames(const Frame *frames, int32_t frameCount)
+AudioBlockFeatures SkullAudioAnimator::measureBlock(const Frame *frames, int32_t frameCount)
 {
+    if (!frames || frameCount <= 0)
+    {
+        return AudioBlockFeatures();
+    }
     double sum = 0.0;
     for (int32_t i = 0; i < frameCount; i++)
     {
@@ -268,8 +310,8 @@ double SkullAudioAnimator::calculateRMSFromFrames(const Frame *frames, int32_t f
         sum += sample1 * sample1;
         sum += sample2 * sample2;
     }
-    int numSamples = frameCount * 2; // Two channels
-    return sqrt(sum / numSamples);
+    const uint32_t numSamples = static_cast<uint32_t>(frameCount) * 2; // Two channels
+    return AudioBlockFeatures::fromSumOfSquares(sum, numSamples, static_cast<uint32_t>(frameCount), SAMPLE_RATE);
 }
 
 int SkullAudioAnimator::mapFloat(double x, double in_min, double in_max, int out_min, int out_max)
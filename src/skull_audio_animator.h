@@ -3,6 +3,7 @@
 
 #include "servo_controller.h"
 #include "arduinoFFT.h"
+#include "audio_envelope.h"
 #include "light_controller.h"
 #include "parsed_skit.h"
 #include "BluetoothA2DPSource.h" // For Frame definition
@@ -47,6 +48,9 @@ public:
     // Holds the jaw at a fixed position when no audio is playing (e.g., wait-for-finger prompt)
     void setJawHoldOverride(bool active, int holdPositionDegrees = 0);
 
+    // Attack/release and level range of the envelope that drives the eye and mouth LEDs
+    void setLightEnvelope(const AudioEnvelope::Settings &settings);
+
 private:
     ServoController &m_servoController;
     LightController &m_lightController;
@@ -62,6 +66,9 @@ private:
     arduinoFFT FFT;
     double m_smoothedAmplitude; // Exponential smoothing of amplitude
     int m_previousJawPosition;  // Previous jaw position for smoothing
+    AudioEnvelope m_lightEnvelope;
+    int16_t m_eyeLevel;         // Last level written to the LEDs, -1 when unknown
+    int16_t m_mouthLevel;
 
     String m_currentFile;
     unsigned long m_currentPlaybackTime;
@@ -89,17 +96,20 @@ private:
     // Helps achieve "mostly open" and "mostly closed" effect by ignoring minor fluctuations.
     static constexpr double AMPLITUDE_THRESHOLD = 1000.0;
 
+    // Lowest mouth modulation while audio plays; the mouth never fully goes dark mid-sentence
+    static constexpr uint8_t MOUTH_AUDIO_FLOOR = 60;
+
     // Updates the jaw position based on the audio amplitude
-    void updateJawPosition(const Frame *frames, int32_t frameCount);
+    void updateJawPosition(const AudioBlockFeatures &block);
 
-    // Updates the eye brightness based on the speaking state
-    void updateEyes();
+    // Follows the audio envelope with the eye and mouth LEDs, writing only on change
+    void updateLights(const AudioBlockFeatures &block);
 
     // Updates the current skit state and speaking status based on audio playback
     void updateSkit();
 
-    // Calculates the Root Mean Square (RMS) of the audio samples
-    double calculateRMSFromFrames(const Frame *frames, int32_t frameCount);
+    // Measures the block once (RMS over both channels) for the jaw and the LEDs
+    AudioBlockFeatures measureBlock(const Frame *frames, int32_t frameCount);
     int mapFloat(double x, double in_min, double in_max, int out_min, int out_max);
 
     int m_servoMinDegrees;
@@ -1,29 +1,24 @@
 #include "thermal_printer.h"
 #include "logging_manager.h"
+#include "infra/alloc_tracker.h"
 
 #include <SD_MMC.h>
 #include <algorithm>
+#include <cstring>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace {
-constexpr size_t BMP_HEADER_BYTES = 54;
+constexpr const char *RASTER_CACHE_SUFFIX = ".raster";
+constexpr const char *PRINT_QUEUE_PATH = "/printer/print_queue.txt";
+constexpr const char *PRINT_QUEUE_TMP_PATH = "/printer/print_queue.txt.tmp";
 
-uint16_t readLE16(const uint8_t *data) {
-    return static_cast<uint16_t>(data[0]) |
-           static_cast<uint16_t>(data[1]) << 8;
-}
-
-uint32_t readLE32(const uint8_t *data) {
-    return static_cast<uint32_t>(data[0]) |
-           (static_cast<uint32_t>(data[1]) << 8) |
-           (static_cast<uint32_t>(data[2]) << 16) |
-           (static_cast<uint32_t>(data[3]) << 24);
-}
-
-int luminance(uint8_t b, uint8_t g, uint8_t r) {
-    // Approximate luminance without floating point (BT.601 weights)
-    return static_cast<int>(r) * 30 + static_cast<int>(g) * 59 + static_cast<int>(b) * 11;
+LogoRasterizer::Options logoRasterOptions(uint16_t maxWidthDots) {
+    LogoRasterizer::Options options;
+    options.maxWidthDots = maxWidthDots;
+    options.dither = LogoRasterizer::Dither::FloydSteinberg;
+    return options;
 }
 } // namespace
 
@@ -34,22 +29,50 @@ ThermalPrinter::ThermalPrinter(HardwareSerial &serialPort, int txPin, int rxPin,
       txPin(txPin),
       rxPin(rxPin),
       printerBaud((baud < 1200 || baud > 115200) ? 9600 : baud),
+      flowControlPin(-1),
       logoPath(),
       initialized(false),
       hasErrorState(false),
-      lastCommandTime(0),
-      jobStage(PrintJobStage::Idle),
-      pendingFortune(),
-      fortuneLines(),
-      fortuneLineIndex(0),
-      lineCharIndex(0),
-      feedLinesRemaining(0),
+      serialSink(serialPort),
+      spooler(serialSink),
+      statusMonitor(serialSink),
+      jobActive(false),
+      jobSent(false),
+      confirmAfterCycle(0),
+      confirmTimeouts(0),
+      jobQueue(),
+      activeJobId(0),
+      persistedRevision(0),
+      queueDirty(false),
+      queueDirtySinceMs(0),
+      preparedJob(),
+      preparedBands(),
+      preparedFortune(),
+      preparedBodyLineCount(0),
       logoCache(),
       logoCacheValid(false),
-      logoCacheOffset(0),
-      logoFallbackPending(false),
-      fortuneBodyLineCount(0),
-      lastSerialWriteMs(0) {
+      logoCacheAttempted(false),
+      fontPath(),
+      fontFile(),
+      font(),
+      fortuneBodyLineCount(0) {
+}
+
+size_t ThermalPrinter::SerialByteSink::availableForWrite() {
+    const int available = port.availableForWrite();
+    return available > 0 ? static_cast<size_t>(available) : 0;
+}
+
+size_t ThermalPrinter::SerialByteSink::write(const uint8_t *data, size_t length) {
+    return port.write(data, length);
+}
+
+int ThermalPrinter::SerialByteSink::read() {
+    return port.read();
+}
+
+void ThermalPrinter::setFlowControlPin(int pin) {
+    flowControlPin = pin;
 }
 
 void ThermalPrinter::begin() {
@@ -58,29 +81,124 @@ void ThermalPrinter::begin() {
     initialized = true;
     hasErrorState = false;
     sendInitSequence();
-    LOG_INFO(TAG, "Thermal printer initialized at %d baud (TX=%d RX=%d)",
+    statusMonitor.reset();
+
+    PrintSpooler::Timing timing;
+    timing.baud = static_cast<uint32_t>(printerBaud);
+    timing.headDotLinesPerSec = HEAD_DOT_LINES_PER_SEC;
+    timing.headBufferDotLines = HEAD_BUFFER_DOT_LINES;
+    spooler.setTiming(timing);
+    if (flowControlPin >= 0) {
+        pinMode(flowControlPin, INPUT);
+        const int pin = flowControlPin;
+        spooler.setClearToSend([pin]() { return digitalRead(pin) == LOW; });
+    } else {
+        spooler.setClearToSend(nullptr);
+    }
+
+    LOG_INFO(TAG, "Thermal printer initialized at %d baud (TX=%d RX=%d, flow control %s)",
              printerBaud,
              txPin,
-             rxPin);
-    resetPrintJob();
+             rxPin,
+             flowControlPin >= 0 ? "on" : "off");
+    releaseActiveJob(false);
+
+    // Cache the logo now so the first fortune does not pay for the SD read
+    if (!ensureLogoCache() && logoPath.length() != 0) {
+        LOG_WARN(TAG, "Printer logo not cached at boot; text logo will be used");
+    }
+    loadFont();
+    loadQueue();
 }
 
-void ThermalPrinter::update() {
+void ThermalPrinter::update(bool sdBusAvailable) {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Printer);
     if (!initialized) {
         return;
     }
 
-    processPrintJob();
+    spooler.pump(micros());
+    if (jobActive && hasErrorState) {
+        // Give the slip back to the queue; it reprints once the printer recovers
+        releaseActiveJob(statusMonitor.status().offline());
+    } else if (jobActive && !jobSent && !spooler.isBusy()) {
+        // Every byte is out, but the paper may still run out under the head.
+        // Keep the job until a status poll taken from here on comes back clean.
+        jobSent = true;
+        confirmAfterCycle = statusMonitor.stats().cycles + (statusMonitor.awaitingReply() ? 1 : 0);
+        confirmTimeouts = statusMonitor.stats().timeouts;
+        statusMonitor.pollNow(millis());
+    }
+    // Status requests only go out while the spooler is idle so they never land inside raster data
+    if (statusMonitor.update(millis(), !spooler.isBusy())) {
+        applyPrinterStatus();
+    }
+    if (jobActive && jobSent) {
+        confirmActiveJob();
+    }
+    startNextJob();
+    persistQueue(millis(), sdBusAvailable);
+}
 
-    if (lastCommandTime > 0 && millis() - lastCommandTime > COMMAND_TIMEOUT_MS) {
-        if (!hasErrorState) {
-            handleError();
-        }
-        lastCommandTime = 0;
+void ThermalPrinter::confirmActiveJob() {
+    if (hasErrorState) {
+        releaseActiveJob(statusMonitor.status().offline());
+        return;
+    }
+    const PrinterStatusMonitor::Stats &polls = statusMonitor.stats();
+    const bool confirmed = static_cast<int32_t>(polls.cycles - confirmAfterCycle) > 0;
+    // A printer with no status line (RX unwired) can only be trusted to have printed
+    const bool unconfirmable = !statusMonitor.status().known && polls.timeouts != confirmTimeouts;
+    if (!confirmed && !unconfirmable) {
+        return;
+    }
+
+    jobActive = false;
+    jobSent = false;
+    jobQueue.complete(activeJobId);
+    const auto &stats = spooler.stats();
+    LOG_INFO(TAG, "Fortune print job #%lu completed (%u body lines, %u bytes in %lu ms%s)",
+             static_cast<unsigned long>(activeJobId),
+             static_cast<unsigned>(fortuneBodyLineCount),
+             static_cast<unsigned>(stats.lastJobBytes),
+             static_cast<unsigned long>(stats.lastJobMicros / 1000),
+             confirmed ? "" : ", printer status unavailable");
+    activeJobId = 0;
+}
+
+void ThermalPrinter::releaseActiveJob(bool printerFailed) {
+    spooler.abort();
+    if (jobActive && printerFailed) {
+        jobQueue.fail(activeJobId, millis());
+    } else if (jobActive) {
+        // Paper, cover and config changes are no fault of the job
+        jobQueue.requeue(activeJobId);
+    }
+    jobActive = false;
+    jobSent = false;
+    activeJobId = 0;
+    fortuneBodyLineCount = 0;
+}
+
+void ThermalPrinter::applyPrinterStatus() {
+    const PrinterStatusMonitor::Status &status = statusMonitor.status();
+    if (status.paperNearEnd && !status.paperOut) {
+        LOG_WARN(TAG, "Printer paper roll nearly empty");
+    }
+    if (status.fault()) {
+        handleError(status.paperOut     ? "paper out"
+                    : status.coverOpen  ? "cover open"
+                    : status.overheat   ? "print head overheated"
+                                        : "printer stopped answering status requests");
+    } else if (hasErrorState) {
+        hasErrorState = false;
+        LOG_INFO(TAG, "Thermal printer recovered; resuming print queue (%u job(s) waiting)",
+                 static_cast<unsigned>(jobQueue.size()));
     }
 }
 
 void ThermalPrinter::setLogoPath(const String &path) {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Printer);
     String trimmed = path;
     trimmed.trim();
     logoPath = trimmed;
@@ -89,8 +207,14 @@ void ThermalPrinter::setLogoPath(const String &path) {
     } else {
         LOG_INFO(TAG, "Printer logo path set to %s", logoPath.c_str());
     }
+    // Raster jobs reference the logo cache; drop them before it changes.
+    if (initialized) {
+        releaseActiveJob(false);
+    }
     logoCacheValid = false;
+    logoCacheAttempted = false;
     logoCache.clear();
+    discardPreparedJob();
     if (logoPath.length() != 0) {
         ensureLogoCache();
     }
@@ -100,78 +224,272 @@ bool ThermalPrinter::printFortune(const String &fortune) {
     return queueFortunePrint(fortune);
 }
 
-bool ThermalPrinter::printLogo() {
+bool ThermalPrinter::queueFortunePrint(const String &fortune) {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Printer);
     if (!initialized) {
+        LOG_WARN(TAG, "Thermal printer not initialized; skipping fortune print");
         return false;
     }
 
-    setJustification(1);              // Center logo
-    setDefaultLineSpacing();
+    const uint32_t id = jobQueue.enqueue(std::string(fortune.c_str(), fortune.length()));
+    if (id == 0) {
+        return false;
+    }
+    LOG_INFO(TAG, "Queued fortune print job #%lu (%u of %u queue slots used)%s",
+             static_cast<unsigned long>(id),
+             static_cast<unsigned>(jobQueue.size()),
+             static_cast<unsigned>(jobQueue.capacity()),
+             hasErrorState ? "; printer in error state, job will wait" : "");
+    startNextJob();
+    return true;
+}
 
-    bool success = printBitmapLogo();
-    if (!success) {
-        printTextLogoFallback();
+bool ThermalPrinter::canAcceptJob() const {
+    return initialized && !jobQueue.full() && !statusMonitor.status().fault();
+}
+
+bool ThermalPrinter::jobStatus(uint32_t id, PrintJobQueue::Status &status) const {
+    return jobQueue.status(id, status);
+}
+
+void ThermalPrinter::startNextJob() {
+    // A busy spooler without an active job is still sending a test page
+    if (!initialized || hasErrorState || jobActive || spooler.isBusy()) {
+        return;
+    }
+    const PrintJobQueue::Job *job = jobQueue.next(millis());
+    if (!job) {
+        return;
+    }
+    const uint32_t id = job->id;
+    const uint8_t attempt = static_cast<uint8_t>(job->attempts + 1);
+    const String fortune(job->text.c_str());
+
+    size_t bodyLineCount = 0;
+    PrintStream stream;
+    std::unique_ptr<PrintSpooler::IBandSource> bands;
+    const bool prepared = hasPreparedJob(fortune);
+    if (prepared) {
+        stream = std::move(preparedJob);
+        bands = std::move(preparedBands);
+        bodyLineCount = preparedBodyLineCount;
+        discardPreparedJob();
+    } else {
+        bodyLineCount = renderFortuneJob(fortune, stream, bands);
+    }
+    const size_t jobBytes = stream.bytes.size() + (bands ? bands->totalBytes() : 0);
+    const uint32_t jobDotLines = stream.totalDotLines() + (bands ? bands->totalDotLines() : 0);
+    const uint32_t estimateMs = PrintSpooler::estimateMicros(jobBytes, jobDotLines, spooler.timing()) / 1000;
+    const bool raster = static_cast<bool>(bands);
+    if (!spooler.load(std::move(stream), std::move(bands))) {
+        LOG_WARN(TAG, "Thermal printer spooler busy; print job #%lu stays queued",
+                 static_cast<unsigned long>(id));
+        return;
+    }
+    jobQueue.start(id);
+    activeJobId = id;
+    jobActive = true;
+    fortuneBodyLineCount = bodyLineCount;
+
+    LOG_INFO(TAG, "Printing %s fortune job #%lu, attempt %u (%u chars, %u lines, %u bytes, ~%lu ms, %s)",
+             raster ? "raster" : "text",
+             static_cast<unsigned long>(id),
+             static_cast<unsigned>(attempt),
+             static_cast<unsigned>(fortune.length()),
+             static_cast<unsigned>(fortuneBodyLineCount),
+             static_cast<unsigned>(jobBytes),
+             static_cast<unsigned long>(estimateMs),
+             prepared ? "pre-rendered" : "rendered on demand");
+}
+
+void ThermalPrinter::loadQueue() {
+    if (SD_MMC.exists(PRINT_QUEUE_PATH)) {
+        if (!readQueueFile(PRINT_QUEUE_PATH)) {
+            LOG_WARN(TAG, "Print queue file %s unreadable; starting with an empty queue", PRINT_QUEUE_PATH);
+        }
+    } else if (SD_MMC.exists(PRINT_QUEUE_TMP_PATH)) {
+        // A reset between replacing the old file and renaming the new one
+        // leaves only the new copy
+        if (!readQueueFile(PRINT_QUEUE_TMP_PATH)) {
+            LOG_WARN(TAG, "Print queue file %s unreadable; starting with an empty queue", PRINT_QUEUE_TMP_PATH);
+        } else if (!SD_MMC.rename(PRINT_QUEUE_TMP_PATH, PRINT_QUEUE_PATH)) {
+            LOG_WARN(TAG, "Print queue recovered from %s but could not be renamed", PRINT_QUEUE_TMP_PATH);
+        } else {
+            LOG_WARN(TAG, "Print queue recovered from %s", PRINT_QUEUE_TMP_PATH);
+        }
     }
-    return success;
+    if (!jobQueue.empty()) {
+        LOG_INFO(TAG, "Resuming %u queued print job(s) from %s",
+                 static_cast<unsigned>(jobQueue.size()),
+                 PRINT_QUEUE_PATH);
+    }
+    persistedRevision = jobQueue.revision();
+    queueDirty = false;
 }
 
-bool ThermalPrinter::queueFortunePrint(const String &fortune) {
-    if (!initialized) {
-        LOG_WARN(TAG, "Thermal printer not initialized; skipping fortune print");
+bool ThermalPrinter::readQueueFile(const char *path) {
+    File file = SD_MMC.open(path, FILE_READ);
+    if (!file) {
         return false;
     }
-    if (hasErrorState) {
-        LOG_WARN(TAG, "Thermal printer in error state; skipping fortune print");
-        return false;
+    std::string data;
+    data.resize(file.size());
+    const size_t read = data.empty() ? 0 : file.read(reinterpret_cast<uint8_t *>(&data[0]), data.size());
+    file.close();
+    return read == data.size() && jobQueue.decode(data);
+}
+
+void ThermalPrinter::persistQueue(uint32_t nowMs, bool sdBusAvailable) {
+    if (jobQueue.revision() == persistedRevision) {
+        queueDirty = false;
+        return;
+    }
+    if (!queueDirty) {
+        queueDirty = true;
+        queueDirtySinceMs = nowMs;
+    }
+    // Let a burst of changes settle, then wait for the audio buffer to have
+    // room before touching the card it streams from
+    if (nowMs - queueDirtySinceMs < QUEUE_PERSIST_DELAY_MS || !sdBusAvailable) {
+        return;
+    }
+    persistedRevision = jobQueue.revision();
+    queueDirty = false;
+
+    // Write beside the live file and swap, so a reset mid-write keeps the old
+    // queue; loadQueue() falls back to the new copy if the swap is cut short
+    const std::string data = jobQueue.encode();
+    File file = SD_MMC.open(PRINT_QUEUE_TMP_PATH, FILE_WRITE);
+    if (!file) {
+        LOG_WARN(TAG, "Could not write print queue %s", PRINT_QUEUE_TMP_PATH);
+        return;
+    }
+    const bool ok = file.write(reinterpret_cast<const uint8_t *>(data.data()), data.size()) == data.size();
+    file.close();
+    if (!ok) {
+        LOG_WARN(TAG, "Short write to print queue %s; keeping the previous copy", PRINT_QUEUE_TMP_PATH);
+        SD_MMC.remove(PRINT_QUEUE_TMP_PATH);
+        return;
+    }
+    SD_MMC.remove(PRINT_QUEUE_PATH);
+    if (!SD_MMC.rename(PRINT_QUEUE_TMP_PATH, PRINT_QUEUE_PATH)) {
+        LOG_WARN(TAG, "Could not replace print queue %s", PRINT_QUEUE_PATH);
     }
-    if (jobStage != PrintJobStage::Idle) {
-        LOG_WARN(TAG, "Thermal printer already busy with a print job");
+}
+
+bool ThermalPrinter::prepareFortuneJob(const String &fortune) {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Printer);
+    if (fortune.length() == 0) {
         return false;
     }
+    if (hasPreparedJob(fortune)) {
+        return true;
+    }
 
-    pendingFortune = fortune;
+    const unsigned long startUs = micros();
+    discardPreparedJob();
+    const size_t bodyLineCount = renderFortuneJob(fortune, preparedJob, preparedBands);
+    preparedFortune = fortune;
+    preparedBodyLineCount = bodyLineCount;
+    LOG_INFO(TAG, "Pre-rendered fortune print job (%u lines, %u bytes) in %lu us",
+             static_cast<unsigned>(bodyLineCount),
+             static_cast<unsigned>(preparedJob.bytes.size() + (preparedBands ? preparedBands->totalBytes() : 0)),
+             static_cast<unsigned long>(micros() - startUs));
+    return true;
+}
+
+bool ThermalPrinter::hasPreparedJob(const String &fortune) const {
+    return hasPreparedJob() && preparedFortune == fortune;
+}
+
+bool ThermalPrinter::hasPreparedJob() const {
+    return !preparedJob.empty() || preparedBands;
+}
+
+void ThermalPrinter::discardPreparedJob() {
+    preparedJob.clear();
+    preparedBands.reset();
+    preparedFortune = String();
+    preparedBodyLineCount = 0;
+}
+
+size_t ThermalPrinter::renderFortuneJob(const String &fortune,
+                                        PrintStream &stream,
+                                        std::unique_ptr<PrintSpooler::IBandSource> &bands) {
+    if (font.isLoaded()) {
+        return renderRasterFortuneJob(fortune, stream, bands);
+    }
 
     std::vector<String> bodyLines;
-    buildFortuneLines(pendingFortune, bodyLines);
-    fortuneBodyLineCount = bodyLines.size();
-
-    fortuneLines.clear();
-    fortuneLines.emplace_back("Your fortune:");
-    fortuneLines.emplace_back("");
-    fortuneLines.insert(fortuneLines.end(), bodyLines.begin(), bodyLines.end());
-    fortuneLines.emplace_back("");
-    fortuneLines.emplace_back("--- Death ---");
-    fortuneLines.emplace_back("");
-
-    fortuneLineIndex = 0;
-    lineCharIndex = 0;
-    feedLinesRemaining = 3;
-    logoCacheOffset = 0;
-    logoFallbackPending = false;
-    lastSerialWriteMs = 0;
-
-    jobStage = PrintJobStage::InitSequence;
-    LOG_INFO(TAG, "Queued fortune print job (%u chars, %u lines)",
-             static_cast<unsigned>(fortune.length()),
-             static_cast<unsigned>(fortuneBodyLineCount));
-    return true;
+    buildFortuneLines(fortune, bodyLines);
+
+    EscPosWriter out(stream);
+    out.initialize();
+
+    out.setJustification(1);
+    out.setDefaultLineSpacing();
+    bool logoPrinted = false;
+    if (ensureLogoCache() && !logoCache.empty()) {
+        logoPrinted = out.raster(logoCache.data(), logoCache.size());
+        if (!logoPrinted) {
+            LOG_WARN(TAG, "Cached logo raster malformed; falling back to text logo");
+        }
+    }
+
+    out.setJustification(0);
+    out.setDefaultLineSpacing();
+
+    const auto line = [&out](const char *text) { out.textLine(text, strlen(text)); };
+    if (!logoPrinted) {
+        line("******************************");
+        line("      DEATH'S FORTUNE");
+        line("           TELLER");
+        line("******************************");
+    }
+    line("");
+    line("Your fortune:");
+    line("");
+    for (const auto &bodyLine : bodyLines) {
+        out.textLine(bodyLine.c_str(), bodyLine.length());
+    }
+    line("");
+    line("--- Death ---");
+    line("");
+    out.feed(3);
+    return bodyLines.size();
+}
+
+size_t ThermalPrinter::renderRasterFortuneJob(const String &fortune,
+                                              PrintStream &stream,
+                                              std::unique_ptr<PrintSpooler::IBandSource> &bands) {
+    EscPosWriter out(stream);
+    out.initialize();
+
+    std::unique_ptr<RasterComposer> composer(new RasterComposer(font, PRINTER_MAX_WIDTH_DOTS));
+    const auto text = [&composer](const char *value, TextAlign align) {
+        return composer->addText(value, strlen(value), align);
+    };
+    if (ensureLogoCache() && !logoCache.empty()) {
+        composer->addRaster(&logoCache);
+    } else {
+        text("DEATH'S FORTUNE TELLER", TextAlign::Centre);
+    }
+    composer->addBlankLines(1);
+    text("Your fortune:", TextAlign::Left);
+    composer->addBlankLines(1);
+    const size_t bodyLines = fortune.length() > 0
+                                 ? composer->addText(fortune.c_str(), fortune.length(), TextAlign::Left)
+                                 : text("[No fortune available]", TextAlign::Left);
+    composer->addBlankLines(1);
+    text("--- Death ---", TextAlign::Centre);
+    composer->addBlankLines(4);
+
+    bands = std::move(composer);
+    return bodyLines;
 }
 
 bool ThermalPrinter::isPrinting() const {
-    return jobStage != PrintJobStage::Idle;
-}
-
-void ThermalPrinter::resetPrintJob() {
-    jobStage = PrintJobStage::Idle;
-    pendingFortune.clear();
-    fortuneLines.clear();
-    fortuneLineIndex = 0;
-    lineCharIndex = 0;
-    feedLinesRemaining = 0;
-    logoCacheOffset = 0;
-    logoFallbackPending = false;
-    fortuneBodyLineCount = 0;
-    lastSerialWriteMs = 0;
+    return spooler.isBusy() || !jobQueue.empty();
 }
 
 bool ThermalPrinter::printTestPage() {
@@ -184,12 +502,22 @@ bool ThermalPrinter::printTestPage() {
         return false;
     }
 
-    sendInitSequence();
+    if (jobActive || spooler.isBusy()) {
+        LOG_WARN(TAG, "Thermal printer busy with a job; cannot print test page");
+        return false;
+    }
+
+    PrintStream stream;
+    EscPosWriter out(stream);
+    out.initialize();
+    const uint8_t selfTest[] = {0x12, 'T'}; // DC2 T — built-in self-test
+    out.raw(selfTest, sizeof(selfTest), SELF_TEST_DOT_LINES);
+    out.feed(3);
+    if (!spooler.load(std::move(stream))) {
+        LOG_WARN(TAG, "Thermal printer spooler busy; cannot print test page");
+        return false;
+    }
     LOG_INFO(TAG, "Triggering printer self-test page");
-    serial.write(0x12); // DC2
-    serial.write('T');  // 'T' — built-in self-test
-    feedLines(3);
-    lastCommandTime = 0;
     return true;
 }
 
@@ -201,46 +529,12 @@ bool ThermalPrinter::hasError() {
     return hasErrorState;
 }
 
-void ThermalPrinter::sendCommand(uint8_t cmd) {
-    if (!initialized) {
-        return;
-    }
-    serial.write(cmd);
-}
-
-void ThermalPrinter::sendCommand(uint8_t cmd, uint8_t param) {
-    if (!initialized) {
-        return;
-    }
-    serial.write(cmd);
-    serial.write(param);
-}
-
-void ThermalPrinter::sendCommand(uint8_t cmd, uint8_t *data, size_t length) {
-    if (!initialized) {
-        return;
-    }
-    serial.write(cmd);
-    serial.write(data, length);
-}
-
-bool ThermalPrinter::waitForResponse(unsigned long timeoutMs) {
-    unsigned long startTime = millis();
-    while (millis() - startTime < timeoutMs) {
-        if (serial.available()) {
-            return true;
-        }
-        delay(10);
-    }
-    return false;
-}
-
-void ThermalPrinter::handleError() {
+void ThermalPrinter::handleError(const char *reason) {
     if (hasErrorState) {
         return;
     }
     hasErrorState = true;
-    LOG_ERROR(TAG, "Thermal printer error - check paper, cover, and power");
+    LOG_ERROR(TAG, "Thermal printer error (%s) - check paper, cover, and power", reason);
 }
 
 void ThermalPrinter::sendInitSequence() {
@@ -264,15 +558,6 @@ void ThermalPrinter::setJustification(uint8_t mode) {
     serial.write(value);
 }
 
-void ThermalPrinter::setLineSpacing(uint8_t dots) {
-    if (!initialized) {
-        return;
-    }
-    serial.write(0x1B);
-    serial.write('3');
-    serial.write(dots);
-}
-
 void ThermalPrinter::setDefaultLineSpacing() {
     if (!initialized) {
         return;
@@ -281,36 +566,73 @@ void ThermalPrinter::setDefaultLineSpacing() {
     serial.write('2');
 }
 
-void ThermalPrinter::feedLines(uint8_t count) {
-    if (!initialized) {
+void ThermalPrinter::setFontPath(const String &path) {
+    String trimmed = path;
+    trimmed.trim();
+    if (trimmed == fontPath && (font.isLoaded() || !initialized)) {
         return;
     }
-    for (uint8_t i = 0; i < count; ++i) {
-        serial.write('\n');
+    fontPath = trimmed;
+    if (initialized) {
+        releaseActiveJob(false);
+        discardPreparedJob();
+        loadFont();
     }
 }
 
-void ThermalPrinter::writeByte(uint8_t byte, std::vector<uint8_t> *buffer) {
-    if (buffer) {
-        buffer->push_back(byte);
-    } else {
-        serial.write(byte);
+bool ThermalPrinter::loadFont() {
+    infra::ScopedAllocTag allocTag(infra::AllocTag::Printer);
+    font.reset();
+    if (fontFile) {
+        fontFile.close();
+    }
+    if (fontPath.length() == 0) {
+        return false;
     }
-}
 
-void ThermalPrinter::writeData(const uint8_t *data, size_t length, std::vector<uint8_t> *buffer) {
-    if (buffer) {
-        buffer->insert(buffer->end(), data, data + length);
-    } else {
-        serial.write(data, length);
+    fontFile = SD_MMC.open(fontPath.c_str(), FILE_READ);
+    if (!fontFile) {
+        LOG_WARN(TAG, "Printer font not found: %s; using the printer's built-in font", fontPath.c_str());
+        return false;
     }
+    const bool loaded = font.load([this](uint32_t offset, uint8_t *data, size_t length) -> size_t {
+        if (!fontFile || !fontFile.seek(offset)) {
+            return 0;
+        }
+        return fontFile.read(data, length);
+    });
+    if (!loaded) {
+        fontFile.close();
+        LOG_WARN(TAG, "Printer font %s unreadable; using the printer's built-in font", fontPath.c_str());
+        return false;
+    }
+    // Jobs render from the loop while audio streams from the same card, so
+    // read the bitmaps now. Text is Latin-1, so 0-255 is every glyph a job
+    // can reach and the file is no longer needed; failing that, keep ASCII
+    // in RAM and read the rest on first use.
+    const char *preloaded = "Latin-1";
+    if (font.preload(0x00, 0xFF, FONT_PRELOAD_BYTES)) {
+        fontFile.close();
+    } else if (font.preload(0x20, 0x7E, FONT_PRELOAD_BYTES)) {
+        preloaded = "ASCII";
+    } else {
+        preloaded = "no";
+    }
+    LOG_INFO(TAG, "Loaded printer font %s (%u glyphs, %u dot lines, %s glyphs preloaded in %u bytes)",
+             fontPath.c_str(),
+             static_cast<unsigned>(font.glyphCount()),
+             static_cast<unsigned>(font.lineHeight()),
+             preloaded,
+             static_cast<unsigned>(font.cacheStats().preloadedBytes));
+    return true;
 }
 
 bool ThermalPrinter::ensureLogoCache() {
     if (logoCacheValid) {
         return true;
     }
-    if (logoPath.length() == 0) {
+    if (logoPath.length() == 0 || logoCacheAttempted) {
+        // A failed load is not retried mid-show; setLogoPath() re-arms it.
         return false;
     }
     return loadLogoCache();
@@ -321,212 +643,107 @@ bool ThermalPrinter::loadLogoCache() {
         return false;
     }
 
+    logoCacheAttempted = true;
     File file = SD_MMC.open(logoPath.c_str(), FILE_READ);
     if (!file) {
         LOG_WARN(TAG, "Printer logo file not found: %s", logoPath.c_str());
         return false;
     }
 
+    const LogoRasterizer::Options options = logoRasterOptions(PRINTER_MAX_WIDTH_DOTS);
+    LogoRasterizer::CacheHeader expected;
+    expected.sourceBytes = static_cast<uint32_t>(file.size());
+    expected.sourceStamp = static_cast<uint32_t>(file.getLastWrite());
+    expected.optionsKey = options.key();
+
     logoCache.clear();
-    bool success = processBitmap(file, &logoCache);
-    file.close();
-    if (success) {
+    if (readRasterCache(expected)) {
+        file.close();
         logoCacheValid = true;
-        LOG_INFO(TAG, "Cached printer logo (%u bytes)", static_cast<unsigned>(logoCache.size()));
-    } else {
-        logoCache.clear();
-        logoCacheValid = false;
+        LOG_INFO(TAG, "Loaded pre-packed printer logo (%u bytes)", static_cast<unsigned>(logoCache.size()));
+        return true;
     }
-    return success;
-}
 
-bool ThermalPrinter::printBitmapLogo() {
-    if (!ensureLogoCache()) {
-        LOG_WARN(TAG, "No cached logo available; falling back to text logo");
+    const unsigned long startMs = millis();
+    BmpGraySource source([&file](uint32_t offset, uint8_t *data, size_t length) -> size_t {
+        if (!file.seek(offset)) {
+            return 0;
+        }
+        return file.read(data, length);
+    });
+    LogoRasterizer rasterizer(options);
+    const bool success = source.open() && rasterizer.rasterize(source, logoCache);
+    file.close();
+    if (!success) {
+        logoCache.clear();
+        logoCacheValid = false;
         return false;
     }
 
-    if (logoCache.empty()) {
-        LOG_WARN(TAG, "Cached logo buffer empty; falling back to text logo");
-        return false;
-    }
+    logoCacheValid = true;
+    LOG_INFO(TAG, "Converted printer logo %ux%u @%u bpp (%u bytes) in %lu ms",
+             static_cast<unsigned>(source.width()),
+             static_cast<unsigned>(source.height()),
+             static_cast<unsigned>(source.bitsPerPixel()),
+             static_cast<unsigned>(logoCache.size()),
+             static_cast<unsigned long>(millis() - startMs));
 
-    constexpr size_t CHUNK_SIZE = 128;
-    size_t offset = 0;
-    while (offset < logoCache.size()) {
-        size_t remaining = logoCache.size() - offset;
-        size_t toWrite = remaining < CHUNK_SIZE ? remaining : CHUNK_SIZE;
-        serial.write(logoCache.data() + offset, toWrite);
-        offset += toWrite;
-        delay(0);
-    }
+    expected.payloadBytes = static_cast<uint32_t>(logoCache.size());
+    writeRasterCache(expected);
     return true;
 }
 
-bool ThermalPrinter::printBitmapFromFile(File &file) {
-    return processBitmap(file, nullptr);
-}
-
-bool ThermalPrinter::processBitmap(File &file, std::vector<uint8_t> *buffer) {
-    uint8_t header[BMP_HEADER_BYTES];
-    size_t bytesRead = file.read(header, sizeof(header));
-    if (bytesRead != sizeof(header)) {
-        LOG_ERROR(TAG, "Bitmap header too short (%u bytes)", static_cast<unsigned>(bytesRead));
-        return false;
-    }
-
-    if (header[0] != 'B' || header[1] != 'M') {
-        LOG_ERROR(TAG, "Bitmap signature mismatch (expected BM)");
-        return false;
-    }
-
-    uint32_t dataOffset = readLE32(header + 10);
-    uint32_t dibHeaderSize = readLE32(header + 14);
-    if (dibHeaderSize < 40) {
-        LOG_ERROR(TAG, "Unsupported BMP DIB header size: %u", static_cast<unsigned>(dibHeaderSize));
-        return false;
-    }
-
-    int32_t width = static_cast<int32_t>(readLE32(header + 18));
-    int32_t height = static_cast<int32_t>(readLE32(header + 22));
-    uint16_t planes = readLE16(header + 26);
-    uint16_t bitsPerPixel = readLE16(header + 28);
-    uint32_t compression = readLE32(header + 30);
-
-    int32_t absWidth = width < 0 ? -width : width;
-    int32_t absHeight = height < 0 ? -height : height;
-
-    if (planes != 1) {
-        LOG_ERROR(TAG, "Unsupported BMP plane count: %u", planes);
-        return false;
-    }
-
-    if (compression != 0) {
-        LOG_ERROR(TAG, "Compressed BMP logos are not supported (compression=%u)", static_cast<unsigned>(compression));
+bool ThermalPrinter::readRasterCache(const LogoRasterizer::CacheHeader &expected) {
+    const String cachePath = logoPath + RASTER_CACHE_SUFFIX;
+    if (!SD_MMC.exists(cachePath.c_str())) {
         return false;
     }
-
-    if (bitsPerPixel != 1) {
-        LOG_ERROR(TAG, "Only 1-bit BMP logos are supported (bpp=%u)", static_cast<unsigned>(bitsPerPixel));
+    File cache = SD_MMC.open(cachePath.c_str(), FILE_READ);
+    if (!cache) {
         return false;
     }
 
-    if (absWidth <= 0 || absHeight <= 0) {
-        LOG_ERROR(TAG, "Invalid BMP dimensions: %ldx%ld", static_cast<long>(width), static_cast<long>(height));
+    uint8_t raw[LogoRasterizer::CacheHeader::SIZE];
+    LogoRasterizer::CacheHeader header;
+    const bool headerOk = cache.read(raw, sizeof(raw)) == sizeof(raw) &&
+                          header.decode(raw, sizeof(raw)) &&
+                          header.sourceBytes == expected.sourceBytes &&
+                          header.sourceStamp == expected.sourceStamp &&
+                          header.optionsKey == expected.optionsKey &&
+                          header.payloadBytes == cache.size() - sizeof(raw);
+    if (!headerOk) {
+        cache.close();
+        LOG_INFO(TAG, "Printer logo cache %s is stale; reconverting", cachePath.c_str());
         return false;
     }
 
-    if (absWidth > PRINTER_MAX_WIDTH_DOTS) {
-        LOG_ERROR(TAG, "BMP width %ld exceeds printer limit of %u dots", static_cast<long>(absWidth), PRINTER_MAX_WIDTH_DOTS);
-        return false;
-    }
-
-    if (absHeight > 65535) {
-        LOG_ERROR(TAG, "BMP height %ld exceeds ESC/POS limit (65535)", static_cast<long>(absHeight));
-        return false;
-    }
-
-    bool invertBits = false;
-    uint32_t paletteStart = 14 + dibHeaderSize;
-    if (!file.seek(paletteStart)) {
-        LOG_ERROR(TAG, "Failed to seek to BMP palette");
-        return false;
-    }
-
-    uint8_t palette[8];
-    size_t paletteBytes = file.read(palette, sizeof(palette));
-    if (paletteBytes != sizeof(palette)) {
-        LOG_ERROR(TAG, "Failed to read BMP palette (%u bytes)", static_cast<unsigned>(paletteBytes));
+    logoCache.resize(header.payloadBytes);
+    const size_t read = cache.read(logoCache.data(), logoCache.size());
+    cache.close();
+    if (read != logoCache.size()) {
+        logoCache.clear();
         return false;
     }
-
-    int lum0 = luminance(palette[0], palette[1], palette[2]);
-    int lum1 = luminance(palette[4], palette[5], palette[6]);
-    int blackIndex = (lum0 <= lum1) ? 0 : 1;
-    if (blackIndex == 0) {
-        invertBits = true;
-    }
-
-    return streamBitmap(file, width, height, dataOffset, invertBits, buffer);
+    return true;
 }
 
-bool ThermalPrinter::streamBitmap(File &file, int32_t width, int32_t height, uint32_t dataOffset, bool invert, std::vector<uint8_t> *buffer) {
-    int32_t absWidth = width < 0 ? -width : width;
-    int32_t absHeight = height < 0 ? -height : height;
-    bool bottomUp = height > 0;
-
-    const uint16_t payloadBytes = static_cast<uint16_t>((absWidth + 7) / 8);
-    const uint16_t strideBytes = static_cast<uint16_t>(((payloadBytes + 3) / 4) * 4);
-    const uint16_t maxRowBytes = static_cast<uint16_t>((PRINTER_MAX_WIDTH_DOTS + 7) / 8);
-    const uint16_t padBytes = (payloadBytes < maxRowBytes) ? static_cast<uint16_t>((maxRowBytes - payloadBytes) / 2) : 0;
-
-    if (!file.seek(dataOffset)) {
-        LOG_ERROR(TAG, "Failed to seek to BMP pixel data (offset %lu)", static_cast<unsigned long>(dataOffset));
-        return false;
+void ThermalPrinter::writeRasterCache(const LogoRasterizer::CacheHeader &header) {
+    const String cachePath = logoPath + RASTER_CACHE_SUFFIX;
+    File cache = SD_MMC.open(cachePath.c_str(), FILE_WRITE);
+    if (!cache) {
+        LOG_WARN(TAG, "Could not write printer logo cache %s", cachePath.c_str());
+        return;
     }
 
-    std::unique_ptr<uint8_t[]> rowBuffer(new (std::nothrow) uint8_t[strideBytes]);
-    std::unique_ptr<uint8_t[]> lineBuffer(new (std::nothrow) uint8_t[payloadBytes]);
-    if (!rowBuffer || !lineBuffer) {
-        LOG_ERROR(TAG, "Insufficient memory for bitmap buffers (%u stride bytes)", static_cast<unsigned>(strideBytes));
-        return false;
+    uint8_t raw[LogoRasterizer::CacheHeader::SIZE];
+    header.encode(raw);
+    const bool ok = cache.write(raw, sizeof(raw)) == sizeof(raw) &&
+                    cache.write(logoCache.data(), logoCache.size()) == logoCache.size();
+    cache.close();
+    if (!ok) {
+        LOG_WARN(TAG, "Short write to printer logo cache %s; removing", cachePath.c_str());
+        SD_MMC.remove(cachePath.c_str());
     }
-
-    const uint8_t mode = 0x00;
-    const uint16_t sendRowBytes = padBytes + payloadBytes;
-
-    writeByte(0x1D, buffer);
-    writeByte('v', buffer);
-    writeByte('0', buffer);
-    writeByte(mode, buffer);
-    writeByte(static_cast<uint8_t>(sendRowBytes & 0xFF), buffer);
-    writeByte(static_cast<uint8_t>((sendRowBytes >> 8) & 0xFF), buffer);
-    writeByte(static_cast<uint8_t>(absHeight & 0xFF), buffer);
-    writeByte(static_cast<uint8_t>((absHeight >> 8) & 0xFF), buffer);
-
-    const uint8_t remainBitsMask = (absWidth % 8 == 0) ? 0xFF : static_cast<uint8_t>(0xFF << (8 - (absWidth % 8)));
-
-    for (int32_t row = 0; row < absHeight; ++row) {
-        int32_t sourceRow = bottomUp ? (absHeight - 1 - row) : row;
-        uint32_t offset = dataOffset + static_cast<uint32_t>(sourceRow) * strideBytes;
-        if (!file.seek(offset)) {
-            LOG_ERROR(TAG, "Failed to seek to BMP row %ld (offset %lu)", static_cast<long>(sourceRow), static_cast<unsigned long>(offset));
-            return false;
-        }
-
-        size_t rowBytes = file.read(rowBuffer.get(), strideBytes);
-        if (rowBytes != strideBytes) {
-            LOG_ERROR(TAG, "Failed to read BMP row %ld (%u bytes)", static_cast<long>(sourceRow), static_cast<unsigned>(rowBytes));
-            return false;
-        }
-
-        for (uint16_t i = 0; i < payloadBytes; ++i) {
-            uint8_t value = rowBuffer[i];
-            if (invert) {
-                value = static_cast<uint8_t>(~value);
-            }
-            lineBuffer[i] = value;
-        }
-
-        if (payloadBytes > 0 && remainBitsMask != 0xFF) {
-            lineBuffer[payloadBytes - 1] &= remainBitsMask;
-        }
-
-        for (uint16_t i = 0; i < padBytes; ++i) {
-            writeByte(0x00, buffer);
-        }
-        writeData(lineBuffer.get(), payloadBytes, buffer);
-    }
-
-    return true;
-}
-
-bool ThermalPrinter::printTextLogoFallback() {
-    serial.println("******************************");
-    serial.println("      DEATH'S FORTUNE");
-    serial.println("           TELLER");
-    serial.println("******************************");
-    return false;
 }
 
 void ThermalPrinter::buildFortuneLines(const String &fortune, std::vector<String> &outLines) {
@@ -593,158 +810,3 @@ void ThermalPrinter::buildFortuneLines(const String &fortune, std::vector<String
         appendWrapped(trimmed);
     }
 }
-
-void ThermalPrinter::printFortuneBody(const String &fortune) {
-    std::vector<String> lines;
-    buildFortuneLines(fortune, lines);
-    for (const auto &line : lines) {
-        if (line.length() == 0) {
-            serial.println();
-        } else {
-            serial.println(line);
-        }
-    }
-}
-
-void ThermalPrinter::processPrintJob() {
-    if (jobStage == PrintJobStage::Idle) {
-        return;
-    }
-
-    auto canWrite = [this]() -> bool {
-        unsigned long now = millis();
-        if (lastSerialWriteMs != 0 && now - lastSerialWriteMs < SERIAL_WRITE_INTERVAL_MS) {
-            return false;
-        }
-        return serial.availableForWrite() > 0;
-    };
-
-    switch (jobStage) {
-        case PrintJobStage::InitSequence:
-            sendInitSequence();
-            jobStage = PrintJobStage::LogoStart;
-            break;
-
-        case PrintJobStage::LogoStart:
-            setJustification(1);
-            setDefaultLineSpacing();
-            if (ensureLogoCache() && !logoCache.empty()) {
-                logoCacheOffset = 0;
-                jobStage = PrintJobStage::LogoRow;
-            } else {
-                logoFallbackPending = true;
-                jobStage = PrintJobStage::LogoComplete;
-            }
-            break;
-
-        case PrintJobStage::LogoRow: {
-            if (logoCacheOffset >= logoCache.size()) {
-                jobStage = PrintJobStage::LogoComplete;
-                break;
-            }
-            if (!canWrite()) {
-                return;
-            }
-            size_t writable = serial.availableForWrite();
-            if (writable == 0) {
-                return;
-            }
-            size_t remaining = logoCache.size() - logoCacheOffset;
-            size_t toWrite = std::min<size_t>(LOGO_CHUNK_SIZE, remaining);
-            toWrite = std::min(toWrite, writable);
-            serial.write(logoCache.data() + logoCacheOffset, toWrite);
-            logoCacheOffset += toWrite;
-            lastSerialWriteMs = millis();
-            if (logoCacheOffset >= logoCache.size()) {
-                jobStage = PrintJobStage::LogoComplete;
-            }
-            break;
-        }
-
-        case PrintJobStage::LogoComplete:
-            jobStage = PrintJobStage::BodyHeader;
-            break;
-
-        case PrintJobStage::BodyHeader: {
-            std::vector<String> prefix;
-            if (logoFallbackPending) {
-                prefix.emplace_back("******************************");
-                prefix.emplace_back("      DEATH'S FORTUNE");
-                prefix.emplace_back("           TELLER");
-                prefix.emplace_back("******************************");
-                logoFallbackPending = false;
-            }
-            prefix.emplace_back(String());
-            fortuneLines.insert(fortuneLines.begin(), prefix.begin(), prefix.end());
-
-            setJustification(0);
-            setDefaultLineSpacing();
-            fortuneLineIndex = 0;
-            lineCharIndex = 0;
-            jobStage = PrintJobStage::BodyLine;
-            break;
-        }
-
-        case PrintJobStage::BodyLine: {
-            if (fortuneLineIndex >= fortuneLines.size()) {
-                jobStage = PrintJobStage::Feed;
-                break;
-            }
-
-            unsigned long now = millis();
-            if (lastSerialWriteMs != 0 && now - lastSerialWriteMs < SERIAL_WRITE_INTERVAL_MS) {
-                return;
-            }
-
-            size_t writable = serial.availableForWrite();
-            if (writable == 0) {
-                return;
-            }
-
-            const String &line = fortuneLines[fortuneLineIndex];
-            if (lineCharIndex < line.length()) {
-                size_t remaining = line.length() - lineCharIndex;
-                size_t toWrite = std::min<size_t>(remaining, writable);
-                serial.write(reinterpret_cast<const uint8_t *>(line.c_str() + lineCharIndex), toWrite);
-                lineCharIndex += toWrite;
-                lastSerialWriteMs = now;
-                return;
-            }
-
-            serial.write('\n');
-            lastSerialWriteMs = millis();
-            ++fortuneLineIndex;
-            lineCharIndex = 0;
-            return;
-        }
-
-        case PrintJobStage::Feed: {
-            if (feedLinesRemaining == 0) {
-                jobStage = PrintJobStage::Complete;
-                break;
-            }
-
-            if (!canWrite()) {
-                return;
-            }
-            if (serial.availableForWrite() == 0) {
-                return;
-            }
-
-            serial.write('\n');
-            lastSerialWriteMs = millis();
-            if (feedLinesRemaining > 0) {
-                --feedLinesRemaining;
-            }
-            break;
-        }
-
-        case PrintJobStage::Complete:
-            LOG_INFO(TAG, "Fortune print job completed (%u body lines)", static_cast<unsigned>(fortuneBodyLineCount));
-            resetPrintJob();
-            break;
-
-        case PrintJobStage::Idle:
-            break;
-    }
-}
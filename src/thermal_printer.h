@@ -7,87 +7,144 @@
 #include <vector>
 #include <memory>
 
+#include "bitmap_font.h"
+#include "escpos_stream.h"
+#include "logo_raster.h"
+#include "print_job_queue.h"
+#include "print_spooler.h"
+#include "printer_status.h"
+#include "raster_text.h"
+
 class ThermalPrinter {
 public:
     ThermalPrinter(HardwareSerial &serialPort, int txPin, int rxPin, int baud = 9600);
     void begin();
-    void update();
+    // Queue changes are saved to SD from here, coalesced and only while
+    // sdBusAvailable (AudioPlayer::hasSdHeadroom()), like the SD log.
+    void update(bool sdBusAvailable = true);
     bool printFortune(const String &fortune); // legacy synchronous API (queues job now)
-    bool printLogo();
     bool isReady();
     bool hasError();
     void setLogoPath(const String &path);
+    // Spools the printer's built-in self-test; false while a job is printing.
     bool printTestPage();
+    // Adds the fortune to the print queue; false when the queue is full.
+    // Queued jobs survive a reboot and are retried after a failed attempt.
     bool queueFortunePrint(const String &fortune);
+    // True while a job is printing or waiting in the queue.
     bool isPrinting() const;
+    // False while the queue is full or the printer reports paper out, cover
+    // open, overheat or has stopped answering status requests.
+    bool canAcceptJob() const;
+    const PrinterStatusMonitor::Status &printerStatus() const { return statusMonitor.status(); }
+    bool isPaperLow() const { return statusMonitor.status().paperNearEnd; }
+    bool jobStatus(uint32_t id, PrintJobQueue::Status &status) const;
+    size_t queuedJobCount() const { return jobQueue.size(); }
+
+    // Renders a fortune job ahead of time; queueFortunePrint() with the same
+    // text then loads it without rendering. Only one job is held.
+    bool prepareFortuneJob(const String &fortune);
+    bool hasPreparedJob(const String &fortune) const;
+    bool hasPreparedJob() const;
+    void discardPreparedJob();
+
+    // Optional `.dfnt` font on SD. When it loads, fortunes are printed as
+    // raster bands in that font; otherwise the printer's built-in font is used.
+    void setFontPath(const String &path);
+
+    // Optional printer busy/DTR input (LOW = ready). Call before begin(); -1 disables.
+    void setFlowControlPin(int pin);
+    const PrintSpooler::Stats &spoolerStats() const { return spooler.stats(); }
 
 private:
-    enum class PrintJobStage {
-        Idle,
-        InitSequence,
-        LogoStart,
-        LogoRow,
-        LogoComplete,
-        BodyHeader,
-        BodyLine,
-        Feed,
-        Complete
+    class SerialByteSink : public PrintSpooler::IByteSink, public PrinterStatusMonitor::IPort {
+    public:
+        explicit SerialByteSink(HardwareSerial &port) : port(port) {}
+        size_t availableForWrite() override;
+        size_t write(const uint8_t *data, size_t length) override;
+        int read() override;
+
+    private:
+        HardwareSerial &port;
     };
 
     HardwareSerial &serial;
     int txPin;
     int rxPin;
     int printerBaud;
+    int flowControlPin;
     String logoPath;
 
     bool initialized;
     bool hasErrorState;
-    unsigned long lastCommandTime;
-    static constexpr unsigned long COMMAND_TIMEOUT_MS = 5000;
     static constexpr uint16_t PRINTER_MAX_WIDTH_DOTS = 384;
     static constexpr uint8_t DEFAULT_LINE_SPACING_DOTS = 32;
     static constexpr size_t MAX_TEXT_COLUMNS = 32;
+    // Conservative head speed for the CSN-A2 class printers (~50 mm/s at 8 dots/mm)
+    static constexpr uint32_t HEAD_DOT_LINES_PER_SEC = 400;
+    // Dot lines the printer can buffer ahead of the head before we pause
+    static constexpr uint32_t HEAD_BUFFER_DOT_LINES = 96;
+    // Queue changes within this window (enqueue, start, complete) share one write
+    static constexpr uint32_t QUEUE_PERSIST_DELAY_MS = 1000;
+    // Glyph bitmaps held in RAM so rendering a job never reads the font from SD
+    static constexpr size_t FONT_PRELOAD_BYTES = 16 * 1024;
+    // Head time charged for the self-test page so a queued job waits behind it
+    static constexpr uint32_t SELF_TEST_DOT_LINES = 1200;
 
-    void sendCommand(uint8_t cmd);
-    void sendCommand(uint8_t cmd, uint8_t param);
-    void sendCommand(uint8_t cmd, uint8_t *data, size_t length);
-    bool waitForResponse(unsigned long timeoutMs = 1000);
-    void handleError();
+    void handleError(const char *reason);
+    void applyPrinterStatus();
     void sendInitSequence();
     void setJustification(uint8_t mode);
-    void setLineSpacing(uint8_t dots);
     void setDefaultLineSpacing();
-    void feedLines(uint8_t count);
-    bool printBitmapLogo();
-    bool printBitmapFromFile(File &file);
-    bool processBitmap(File &file, std::vector<uint8_t> *buffer);
-    bool streamBitmap(File &file, int32_t width, int32_t height, uint32_t dataOffset, bool invert, std::vector<uint8_t> *buffer);
-    bool printTextLogoFallback();
-    void printFortuneBody(const String &fortune);
-    void writeByte(uint8_t byte, std::vector<uint8_t> *buffer);
-    void writeData(const uint8_t *data, size_t length, std::vector<uint8_t> *buffer);
     bool ensureLogoCache();
     bool loadLogoCache();
+    bool readRasterCache(const LogoRasterizer::CacheHeader &expected);
+    void writeRasterCache(const LogoRasterizer::CacheHeader &header);
     void buildFortuneLines(const String &fortune, std::vector<String> &outLines);
-    void processPrintJob();
-    void resetPrintJob();
+    size_t renderFortuneJob(const String &fortune,
+                            PrintStream &stream,
+                            std::unique_ptr<PrintSpooler::IBandSource> &bands);
+    size_t renderRasterFortuneJob(const String &fortune,
+                                  PrintStream &stream,
+                                  std::unique_ptr<PrintSpooler::IBandSource> &bands);
+    bool loadFont();
+    // Stops the active job and puts it back in the queue. Only a printer that
+    // stopped answering spends one of the job's attempts.
+    void releaseActiveJob(bool printerFailed);
+    void confirmActiveJob();
+    void startNextJob();
+    void loadQueue();
+    bool readQueueFile(const char *path);
+    void persistQueue(uint32_t nowMs, bool sdBusAvailable);
+
+    SerialByteSink serialSink;
+    PrintSpooler spooler;
+    PrinterStatusMonitor statusMonitor;
+    bool jobActive;
+    // The active job's bytes are all out; it completes on the next clean
+    // status poll (or when the printer has never answered one)
+    bool jobSent;
+    uint32_t confirmAfterCycle;
+    uint32_t confirmTimeouts;
+    PrintJobQueue jobQueue;
+    uint32_t activeJobId;
+    uint32_t persistedRevision;
+    bool queueDirty;
+    uint32_t queueDirtySinceMs;
 
-    PrintJobStage jobStage;
-    String pendingFortune;
-    std::vector<String> fortuneLines;
-    size_t fortuneLineIndex;
-    size_t lineCharIndex;
-    uint8_t feedLinesRemaining;
+    PrintStream preparedJob;
+    std::unique_ptr<PrintSpooler::IBandSource> preparedBands;
+    String preparedFortune;
+    size_t preparedBodyLineCount;
 
     std::vector<uint8_t> logoCache;
     bool logoCacheValid;
-    size_t logoCacheOffset;
-    bool logoFallbackPending;
-    size_t fortuneBodyLineCount;
-    unsigned long lastSerialWriteMs;
+    bool logoCacheAttempted;
 
-    static constexpr size_t LOGO_CHUNK_SIZE = 32;
-    static constexpr unsigned long SERIAL_WRITE_INTERVAL_MS = 4;
+    String fontPath;
+    File fontFile;
+    BitmapFont font;
+    size_t fortuneBodyLineCount;
 };
 
 #endif // THERMAL_PRINTER_H
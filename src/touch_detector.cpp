@@ -0,0 +1,208 @@
+#include "touch_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr float MAD_TO_SIGMA = 1.4826f;         // MAD of a normal distribution -> sigma
+constexpr float MIN_ROBUST_SIGMA_RATIO = 0.0002f;  // Flat windows still tolerate 0.02 % jitter
+constexpr float IDLE_MEAN_ALPHA = 1.0f / 64.0f;
+
+uint8_t oddWindow(uint8_t size) {
+    if (size > TouchDetector::MAX_WINDOW) {
+        size = TouchDetector::MAX_WINDOW;
+    }
+    if (size > 1 && size % 2 == 0) {
+        --size;
+    }
+    return size;
+}
+
+float clampUnit(float value, float upper) {
+    return value < 0.0f ? 0.0f : (value > upper ? upper : value);
+}
+}  // namespace
+
+TouchDetector::TouchDetector()
+    : m_config(),
+      m_threshold(0.002f),
+      m_raw(),
+      m_cleaned(),
+      m_outliers(0),
+      m_primed(false),
+      m_filtered(0.0f),
+      m_baseline(0.0f),
+      m_delta(0.0f),
+      m_touched(false),
+      m_statistic(0.0f),
+      m_idleMean(0.0f) {
+}
+
+void TouchDetector::configure(const Config &config) {
+    m_config = config;
+    m_config.medianWindow = std::max<uint8_t>(1, oddWindow(config.medianWindow));
+    m_config.hampelWindow = oddWindow(config.hampelWindow);
+    m_config.hampelSigmas = std::max(config.hampelSigmas, 1.0f);
+    m_config.filterAlpha = clampUnit(config.filterAlpha, 1.0f);
+    m_config.baselineDrift = clampUnit(config.baselineDrift, 0.1f);
+    m_config.cusumSlack = clampUnit(config.cusumSlack, 1.0f);
+    m_config.cusumLimit = std::max(config.cusumLimit, 0.1f);
+    m_raw = Window();
+    m_cleaned = Window();
+    m_statistic = 0.0f;
+}
+
+void TouchDetector::reset(float baseline) {
+    m_raw = Window();
+    m_cleaned = Window();
+    m_outliers = 0;
+    m_primed = true;
+    m_filtered = baseline;
+    m_baseline = baseline;
+    m_delta = 0.0f;
+    m_touched = false;
+    m_statistic = 0.0f;
+    m_idleMean = 0.0f;
+}
+
+void TouchDetector::setThresholdRatio(float ratio) {
+    m_threshold = ratio > 0.0f ? ratio : 0.0f;
+}
+
+bool TouchDetector::update(float sample, bool armed) {
+    if (!m_primed) {
+        reset(sample);
+    }
+
+    float value = rejectOutlier(sample);
+    if (m_config.medianWindow > 1) {
+        m_cleaned.push(value, m_config.medianWindow);
+        value = m_cleaned.median(m_config.medianWindow);
+    }
+
+    const float alpha = m_config.filterAlpha;
+    m_filtered = alpha * value + (1.0f - alpha) * m_filtered;
+
+    if (!m_touched) {
+        const float drift = m_config.baselineDrift;
+        m_baseline = drift * m_filtered + (1.0f - drift) * m_baseline;
+    }
+
+    const float denominator = m_baseline > 1.0f ? m_baseline : 1.0f;
+    m_delta = (m_baseline - m_filtered) / denominator;
+    return decide(armed);
+}
+
+float TouchDetector::score() const {
+    if (m_threshold <= 0.0f) {
+        return 0.0f;
+    }
+    if (m_config.algorithm == Algorithm::Threshold) {
+        return normalizedDelta() / m_threshold;
+    }
+    return m_statistic / (m_config.cusumLimit * m_threshold);
+}
+
+const char *TouchDetector::algorithmName(Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::Threshold:
+            return "threshold";
+        case Algorithm::Cusum:
+            return "cusum";
+        case Algorithm::PageHinkley:
+            return "page-hinkley";
+    }
+    return "unknown";
+}
+
+bool TouchDetector::parseAlgorithm(const char *name, Algorithm &algorithm) {
+    if (!name) {
+        return false;
+    }
+    if (strcmp(name, "threshold") == 0) {
+        algorithm = Algorithm::Threshold;
+    } else if (strcmp(name, "cusum") == 0) {
+        algorithm = Algorithm::Cusum;
+    } else if (strcmp(name, "page-hinkley") == 0 || strcmp(name, "ph") == 0) {
+        algorithm = Algorithm::PageHinkley;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+float TouchDetector::rejectOutlier(float sample) {
+    const uint8_t window = m_config.hampelWindow;
+    if (window <= 1) {
+        return sample;
+    }
+    // The reference window keeps raw samples; feeding back the replacements
+    // would pin the median and reject a genuine step forever
+    m_raw.push(sample, window);
+    if (m_raw.count < window) {
+        return sample;
+    }
+
+    const float median = m_raw.median(window);
+    Window deviations;
+    for (uint8_t i = 0; i < window; ++i) {
+        deviations.values[i] = std::fabs(m_raw.values[i] - median);
+    }
+    deviations.count = window;
+    const float floor = MIN_ROBUST_SIGMA_RATIO * std::fabs(m_baseline);
+    const float sigma = std::max(MAD_TO_SIGMA * deviations.median(window), floor);
+    if (std::fabs(sample - median) > m_config.hampelSigmas * sigma) {
+        ++m_outliers;
+        return median;
+    }
+    return sample;
+}
+
+bool TouchDetector::decide(bool armed) {
+    if (!armed) {
+        m_touched = false;
+        m_statistic = 0.0f;
+        m_idleMean += IDLE_MEAN_ALPHA * (m_delta - m_idleMean);
+        return false;
+    }
+
+    if (m_config.algorithm == Algorithm::Threshold) {
+        m_touched = m_delta >= m_threshold;
+        return m_touched;
+    }
+
+    const float reference = m_config.algorithm == Algorithm::PageHinkley ? m_idleMean : 0.0f;
+    const float slack = m_config.cusumSlack * m_threshold;
+    const float limit = m_config.cusumLimit * m_threshold;
+    if (!m_touched) {
+        m_idleMean += IDLE_MEAN_ALPHA * (m_delta - m_idleMean);
+        m_statistic = std::max(0.0f, m_statistic + (m_delta - reference) - slack);
+    } else {
+        m_statistic = std::max(0.0f, m_statistic + slack - (m_delta - reference));
+    }
+    if (m_statistic >= limit) {
+        m_touched = !m_touched;
+        m_statistic = 0.0f;
+    }
+    return m_touched;
+}
+
+void TouchDetector::Window::push(float value, uint8_t size) {
+    values[next] = value;
+    next = static_cast<uint8_t>((next + 1) % size);
+    if (count < size) {
+        ++count;
+    }
+}
+
+float TouchDetector::Window::median(uint8_t size) const {
+    const uint8_t n = count < size ? count : size;
+    if (n == 0) {
+        return 0.0f;
+    }
+    float sorted[MAX_WINDOW];
+    std::copy(values, values + n, sorted);
+    std::nth_element(sorted, sorted + n / 2, sorted + n);
+    return sorted[n / 2];
+}
@@ -0,0 +1,115 @@
+#ifndef TOUCH_DETECTOR_H
+#define TOUCH_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Finger detection pipeline, one averaged touch sample at a time:
+ *
+ *   Hampel outlier rejection -> median -> EMA -> baseline -> change detector
+ *
+ * Both pre-filters are optional. The Hampel stage replaces a sample that is
+ * more than `hampelSigmas` robust deviations (1.4826 * MAD) from the median
+ * of the last `hampelWindow` raw samples, which removes crowd and ESD spikes
+ * without smearing them. The median stage then smooths what is left. A real
+ * step (a finger) passes both once half the window has seen the new level,
+ * so each adds roughly window/2 samples of latency.
+ *
+ * Change detectors, all on the normalized delta d = (baseline - filtered) /
+ * baseline, which grows when a finger lowers the reading:
+ *  - Threshold: touched while d >= threshold (the original behaviour).
+ *  - Cusum: S = max(0, S + d - k), touch when S >= h. Weak but sustained
+ *    shifts accumulate; short excursions do not.
+ *  - PageHinkley: CUSUM around a slowly tracked idle mean of d instead of
+ *    zero, so a standing offset (a nearby body, a drifting baseline) is
+ *    absorbed rather than accumulated.
+ * For both sequential tests k = cusumSlack * threshold and h = cusumLimit *
+ * threshold, and release mirrors onset: the deficit below k accumulates
+ * until it reaches h.
+ *
+ * Pure logic with no Arduino dependencies, so recorded traces can be
+ * replayed through it on the host.
+ */
+class TouchDetector {
+public:
+    enum class Algorithm : uint8_t {
+        Threshold = 0,
+        Cusum,
+        PageHinkley
+    };
+
+    struct Config {
+        Algorithm algorithm = Algorithm::Threshold;
+        uint8_t medianWindow = 1;     // Odd, 1 disables
+        uint8_t hampelWindow = 0;     // Odd, 0 or 1 disables
+        float hampelSigmas = 3.0f;
+        float filterAlpha = 0.3f;     // EMA weight of the newest sample
+        float baselineDrift = 0.0001f;
+        float cusumSlack = 0.5f;      // k, as a fraction of the threshold
+        float cusumLimit = 3.0f;      // h, as a multiple of the threshold
+    };
+
+    static constexpr uint8_t MAX_WINDOW = 15;
+
+    TouchDetector();
+
+    // Windows are forced odd and clamped to MAX_WINDOW; filter history is
+    // cleared but the baseline is kept.
+    void configure(const Config &config);
+    const Config &config() const { return m_config; }
+
+    // Starts from a calibrated baseline with empty filters and statistics.
+    void reset(float baseline);
+    void setThresholdRatio(float ratio);
+    float thresholdRatio() const { return m_threshold; }
+
+    // Runs one sample through the pipeline and returns the touch decision.
+    // While not armed (calibration settling) the filters and baseline still
+    // track but no touch is reported and the statistics stay at zero.
+    bool update(float sample, bool armed = true);
+
+    bool isTouched() const { return m_touched; }
+    float filtered() const { return m_filtered; }
+    float baseline() const { return m_baseline; }
+    // Clamped at zero: readings above the baseline are not a touch
+    float normalizedDelta() const { return m_delta > 0.0f ? m_delta : 0.0f; }
+    // Statistic over the level that flips the touch state (delta / threshold
+    // for Threshold; onset or release progress for the sequential tests)
+    float score() const;
+    uint32_t outliersRejected() const { return m_outliers; }
+
+    static const char *algorithmName(Algorithm algorithm);
+    static bool parseAlgorithm(const char *name, Algorithm &algorithm);
+
+private:
+    struct Window {
+        float values[MAX_WINDOW] = {};
+        uint8_t next = 0;
+        uint8_t count = 0;
+
+        void push(float value, uint8_t size);
+        float median(uint8_t size) const;
+    };
+
+    float rejectOutlier(float sample);
+    bool decide(bool armed);
+
+    Config m_config;
+    float m_threshold;
+
+    Window m_raw;      // Hampel reference: unmodified samples
+    Window m_cleaned;  // Median input: samples after outlier rejection
+    uint32_t m_outliers;
+
+    bool m_primed;
+    float m_filtered;
+    float m_baseline;
+    float m_delta;
+
+    bool m_touched;
+    float m_statistic;
+    float m_idleMean;  // Page-Hinkley reference
+};
+
+#endif  // TOUCH_DETECTOR_H
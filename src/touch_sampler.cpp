@@ -0,0 +1,125 @@
+#include "touch_sampler.h"
+
+TouchSampler::TouchSampler(infra::IPeriodicTimer *timer, const infra::ITimeProvider *clock)
+    : m_timer(timer),
+      m_clock(clock),
+      m_read(nullptr),
+      m_readContext(nullptr),
+      m_periodMicros(DEFAULT_PERIOD_MICROS),
+      m_elapsedMicros(0),
+      m_samplesPerBlock(1),
+      m_blockSum(0),
+      m_blockReadings(0),
+      m_blockTarget(1),
+      m_ring(),
+      m_head(0),
+      m_tail(0),
+      m_ticks(0),
+      m_published(0),
+      m_dropped(0),
+      m_maxReadMicros(0) {
+}
+
+TouchSampler::~TouchSampler() {
+    stop();
+}
+
+bool TouchSampler::start(uint32_t periodMicros, ReadFn read, void *context, uint8_t samplesPerBlock) {
+    stop();
+
+    m_read = read;
+    m_readContext = context;
+    m_periodMicros = periodMicros > 0 ? periodMicros : DEFAULT_PERIOD_MICROS;
+    m_elapsedMicros = 0;
+    setSamplesPerBlock(samplesPerBlock);
+    m_blockSum = 0;
+    m_blockReadings = 0;
+    m_blockTarget = this->samplesPerBlock();
+    // Samples from a previous run describe a stale configuration
+    m_head.store(m_tail.load(std::memory_order_acquire), std::memory_order_release);
+
+    if (!m_timer || !read) {
+        return false;
+    }
+    return m_timer->start(m_periodMicros, &TouchSampler::onTimer, this);
+}
+
+void TouchSampler::stop() {
+    if (m_timer) {
+        m_timer->stop();
+    }
+}
+
+bool TouchSampler::isRunning() const {
+    return m_timer && m_timer->isRunning();
+}
+
+void TouchSampler::setSamplesPerBlock(uint8_t count) {
+    m_samplesPerBlock.store(count > 0 ? count : 1, std::memory_order_relaxed);
+}
+
+void TouchSampler::tick() {
+    m_ticks.fetch_add(1, std::memory_order_relaxed);
+    m_elapsedMicros += m_periodMicros;
+
+    const uint64_t readStart = m_clock ? m_clock->nowMicros() : 0;
+    m_blockSum += m_read(m_readContext);
+    ++m_blockReadings;
+    if (m_clock) {
+        const uint64_t readMicros = m_clock->nowMicros() - readStart;
+        if (readMicros > m_maxReadMicros.load(std::memory_order_relaxed)) {
+            m_maxReadMicros.store(static_cast<uint32_t>(readMicros), std::memory_order_relaxed);
+        }
+    }
+    if (m_blockReadings < m_blockTarget) {
+        return;
+    }
+
+    Sample sample;
+    sample.timestampMs = m_clock ? m_clock->nowMillis() : static_cast<uint32_t>(m_elapsedMicros / 1000);
+    sample.value = static_cast<float>(m_blockSum) / static_cast<float>(m_blockReadings);
+    sample.readings = m_blockReadings;
+    m_blockSum = 0;
+    m_blockReadings = 0;
+    m_blockTarget = samplesPerBlock();
+
+    // One slot is kept free to tell full from empty, hence the +1 in the ring size.
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    const size_t next = (tail + 1) % (RING_CAPACITY + 1);
+    if (next == m_head.load(std::memory_order_acquire)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_ring[tail] = sample;
+    m_tail.store(next, std::memory_order_release);
+    m_published.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TouchSampler::pop(Sample &sample) {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    sample = m_ring[head];
+    m_head.store((head + 1) % (RING_CAPACITY + 1), std::memory_order_release);
+    return true;
+}
+
+size_t TouchSampler::pending() const {
+    const size_t head = m_head.load(std::memory_order_acquire);
+    const size_t tail = m_tail.load(std::memory_order_acquire);
+    return (tail + RING_CAPACITY + 1 - head) % (RING_CAPACITY + 1);
+}
+
+TouchSampler::Stats TouchSampler::stats() const {
+    Stats snapshot;
+    snapshot.ticks = m_ticks.load(std::memory_order_relaxed);
+    snapshot.published = m_published.load(std::memory_order_relaxed);
+    snapshot.dropped = m_dropped.load(std::memory_order_relaxed);
+    snapshot.maxReadMicros = m_maxReadMicros.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void TouchSampler::onTimer(void *context) {
+    static_cast<TouchSampler *>(context)->tick();
+}
@@ -0,0 +1,90 @@
+#ifndef TOUCH_SAMPLER_H
+#define TOUCH_SAMPLER_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "infra/periodic_timer.h"
+#include "infra/time_provider.h"
+
+/**
+ * Background capacitive sampling. A periodic timer calls tick(), which takes
+ * one raw reading; every `samplesPerBlock` readings are averaged into a
+ * timestamped Sample and published to a lock-free ring. The loop task drains
+ * the ring with pop(), so it never waits on the touch peripheral and every
+ * sample carries the time it was measured rather than the time it was read.
+ *
+ * Single producer (timer task), single consumer (loop task). When the ring
+ * is full the new sample is dropped and counted.
+ */
+class TouchSampler {
+public:
+    using ReadFn = uint32_t (*)(void *context);
+
+    struct Sample {
+        uint32_t timestampMs = 0;  // when the last reading of the block finished
+        float value = 0.0f;        // mean of the block's readings
+        uint16_t readings = 0;
+    };
+
+    struct Stats {
+        uint32_t ticks = 0;
+        uint32_t published = 0;
+        uint32_t dropped = 0;
+        uint32_t maxReadMicros = 0;  // slowest single reading
+    };
+
+    static constexpr uint32_t DEFAULT_PERIOD_MICROS = 1000;
+    static constexpr size_t RING_CAPACITY = 32;
+
+    TouchSampler(infra::IPeriodicTimer *timer, const infra::ITimeProvider *clock);
+    ~TouchSampler();
+
+    TouchSampler(const TouchSampler &) = delete;
+    TouchSampler &operator=(const TouchSampler &) = delete;
+
+    // Starts reading every periodMicros. Returns false when the timer is
+    // missing or refuses to start; the caller then samples inline.
+    bool start(uint32_t periodMicros, ReadFn read, void *context, uint8_t samplesPerBlock);
+    void stop();
+    bool isRunning() const;
+
+    // Takes effect at the next block boundary.
+    void setSamplesPerBlock(uint8_t count);
+    uint8_t samplesPerBlock() const { return m_samplesPerBlock.load(std::memory_order_relaxed); }
+
+    // Timer entry point: one reading.
+    void tick();
+
+    bool pop(Sample &sample);
+    size_t pending() const;
+    uint32_t periodMicros() const { return m_periodMicros; }
+    Stats stats() const;
+
+private:
+    static void onTimer(void *context);
+
+    infra::IPeriodicTimer *m_timer;
+    const infra::ITimeProvider *m_clock;
+    ReadFn m_read;
+    void *m_readContext;
+    uint32_t m_periodMicros;
+    uint64_t m_elapsedMicros;  // tick clock, used when there is no time provider
+
+    std::atomic<uint8_t> m_samplesPerBlock;
+    uint32_t m_blockSum;
+    uint16_t m_blockReadings;
+    uint8_t m_blockTarget;
+
+    Sample m_ring[RING_CAPACITY + 1];
+    std::atomic<size_t> m_head;  // Consumer index
+    std::atomic<size_t> m_tail;  // Producer index
+
+    std::atomic<uint32_t> m_ticks;
+    std::atomic<uint32_t> m_published;
+    std::atomic<uint32_t> m_dropped;
+    std::atomic<uint32_t> m_maxReadMicros;
+};
+
+#endif  // TOUCH_SAMPLER_H
@@ -0,0 +1,167 @@
+#include "touch_trace.h"
+
+#include <cstring>
+#include <utility>
+
+namespace {
+constexpr uint8_t MAGIC[4] = {'D', 'T', 'T', 'R'};
+
+void putU16(uint8_t *out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void putU32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint16_t getU16(const uint8_t *in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t getU32(const uint8_t *in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+}  // namespace
+
+TouchTraceWriter::TouchTraceWriter()
+    : m_file(),
+      m_buffer(),
+      m_used(0),
+      m_label(TouchLabel::None),
+      m_stats() {
+}
+
+bool TouchTraceWriter::begin(std::unique_ptr<infra::IFile> file, const TouchTraceHeader &header) {
+    end();
+    if (!file) {
+        return false;
+    }
+    m_file = std::move(file);
+    m_used = 0;
+    m_label = TouchLabel::None;
+    m_stats = Stats();
+
+    uint8_t *out = m_buffer;
+    memcpy(out, MAGIC, sizeof(MAGIC));
+    putU16(out + 4, VERSION);
+    putU16(out + 6, header.readingsPerSample);
+    putU32(out + 8, header.readingPeriodMicros);
+    putU32(out + 12, header.startMs);
+    m_used = HEADER_BYTES;
+    return true;
+}
+
+bool TouchTraceWriter::append(uint32_t timestampMs, float value) {
+    if (!m_file) {
+        return false;
+    }
+    if (m_used + RECORD_BYTES > BUFFER_BYTES) {
+        // The card has been held back too long; a gap beats a stalled loop
+        ++m_stats.droppedRecords;
+        return true;
+    }
+    uint8_t *out = m_buffer + m_used;
+    uint32_t bits;
+    static_assert(sizeof(bits) == sizeof(value), "f32 records");
+    memcpy(&bits, &value, sizeof(bits));
+    putU32(out, timestampMs);
+    putU32(out + 4, bits);
+    out[8] = static_cast<uint8_t>(m_label);
+    m_used += RECORD_BYTES;
+    ++m_stats.records;
+    return true;
+}
+
+bool TouchTraceWriter::service(bool busAvailable) {
+    if (!m_file) {
+        return false;
+    }
+    if (m_used < FLUSH_BYTES) {
+        return true;
+    }
+    if (!busAvailable) {
+        ++m_stats.deferrals;
+        return true;
+    }
+    return flush();
+}
+
+bool TouchTraceWriter::end() {
+    if (!m_file) {
+        return false;
+    }
+    const bool ok = flush();
+    if (m_file) {
+        m_file->close();
+        m_file.reset();
+    }
+    return ok;
+}
+
+bool TouchTraceWriter::flush() {
+    if (m_used == 0) {
+        return true;
+    }
+    const size_t written = m_file->write(m_buffer, m_used);
+    m_stats.bytesWritten += static_cast<uint32_t>(written);
+    ++m_stats.flushes;
+    const bool ok = written == m_used;
+    m_used = 0;
+    if (!ok) {
+        // A full or pulled card: stop rather than write a trace with holes
+        ++m_stats.failedWrites;
+        m_file->close();
+        m_file.reset();
+    }
+    return ok;
+}
+
+bool TouchTraceWriter::parse(const uint8_t *data,
+                             size_t length,
+                             TouchTraceHeader &header,
+                             std::vector<TouchTraceRecord> &records) {
+    records.clear();
+    if (!data || length < HEADER_BYTES || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+    header.version = getU16(data + 4);
+    if (header.version != VERSION) {
+        return false;
+    }
+    header.readingsPerSample = getU16(data + 6);
+    header.readingPeriodMicros = getU32(data + 8);
+    header.startMs = getU32(data + 12);
+
+    // A trailing partial record (power lost mid-write) is dropped
+    const size_t count = (length - HEADER_BYTES) / RECORD_BYTES;
+    records.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t *in = data + HEADER_BYTES + i * RECORD_BYTES;
+        TouchTraceRecord record;
+        record.timestampMs = getU32(in);
+        const uint32_t bits = getU32(in + 4);
+        memcpy(&record.value, &bits, sizeof(bits));
+        record.label = in[8] <= static_cast<uint8_t>(TouchLabel::Touch) ? static_cast<TouchLabel>(in[8]) : TouchLabel::None;
+        records.push_back(record);
+    }
+    return true;
+}
+
+const char *TouchTraceWriter::labelName(TouchLabel label) {
+    switch (label) {
+        case TouchLabel::Idle:
+            return "idle";
+        case TouchLabel::Touch:
+            return "touch";
+        case TouchLabel::None:
+            break;
+    }
+    return "none";
+}
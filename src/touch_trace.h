@@ -0,0 +1,95 @@
+#ifndef TOUCH_TRACE_H
+#define TOUCH_TRACE_H
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "infra/filesystem.h"
+
+/**
+ * Binary finger-sensor traces for offline tuning. A 16-byte header is
+ * followed by fixed 9-byte records, all little-endian:
+ *
+ *   header: "DTTR" | u16 version | u16 readings per sample | u32 reading period us | u32 start ms
+ *   record: u32 timestamp ms | f32 sample | u8 label
+ *
+ * Captured with one reading per sample, a trace holds raw touchRead values
+ * and can be re-averaged on replay; otherwise it holds the sampler's block
+ * averages as FingerSensor saw them.
+ */
+enum class TouchLabel : uint8_t {
+    None = 0,   // Unlabelled: not scored
+    Idle = 1,   // Mouth known to be empty
+    Touch = 2   // Finger known to be in the mouth
+};
+
+struct TouchTraceHeader {
+    uint16_t version = 0;
+    uint16_t readingsPerSample = 1;
+    uint32_t readingPeriodMicros = 0;
+    uint32_t startMs = 0;
+};
+
+struct TouchTraceRecord {
+    uint32_t timestampMs = 0;
+    float value = 0.0f;
+    TouchLabel label = TouchLabel::None;
+};
+
+// Buffers records in RAM and writes them out a block at a time, so the SD
+// card sees one write per FLUSH_BYTES rather than one per sample. Only
+// service() and end() touch the card, and the caller decides when the bus
+// may be used (AudioPlayer::hasSdHeadroom()), as with SdLogWriter. While the
+// bus is held back the buffer keeps filling; once it is full, new records
+// are dropped and counted rather than blocking the sampler drain.
+class TouchTraceWriter {
+public:
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t HEADER_BYTES = 16;
+    static constexpr size_t RECORD_BYTES = 9;
+    static constexpr size_t FLUSH_BYTES = RECORD_BYTES * 57;    // ~512 bytes per write
+    static constexpr size_t BUFFER_BYTES = FLUSH_BYTES * 4;     // ~230 ms at 1 kHz
+
+    struct Stats {
+        uint32_t records = 0;
+        uint32_t bytesWritten = 0;
+        uint32_t flushes = 0;
+        uint32_t deferrals = 0;       // Due writes held back for the audio buffer
+        uint32_t droppedRecords = 0;  // Arrived with the buffer full
+        uint32_t failedWrites = 0;
+    };
+
+    TouchTraceWriter();
+
+    bool begin(std::unique_ptr<infra::IFile> file, const TouchTraceHeader &header);
+    // Buffers one record; never writes. Returns false once the trace is closed.
+    bool append(uint32_t timestampMs, float value);
+    // Writes the buffer when FLUSH_BYTES are waiting and busAvailable.
+    // Returns false once a write has failed; the trace is then closed.
+    bool service(bool busAvailable);
+    bool end();
+    bool isActive() const { return static_cast<bool>(m_file); }
+
+    void setLabel(TouchLabel label) { m_label = label; }
+    TouchLabel label() const { return m_label; }
+    Stats stats() const { return m_stats; }
+
+    static bool parse(const uint8_t *data,
+                      size_t length,
+                      TouchTraceHeader &header,
+                      std::vector<TouchTraceRecord> &records);
+    static const char *labelName(TouchLabel label);
+
+private:
+    bool flush();
+
+    std::unique_ptr<infra::IFile> m_file;
+    uint8_t m_buffer[BUFFER_BYTES];
+    size_t m_used;
+    TouchLabel m_label;
+    Stats m_stats;
+};
+
+#endif  // TOUCH_TRACE_H
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <queue>
@@ -9,8 +11,9 @@
 
 class FakeFile : public infra::IFile {
 public:
-    explicit FakeFile(const std::string &content)
-        : m_closed(false)
+    // Writes land in `sink` as well when one is given (files opened for writing)
+    explicit FakeFile(const std::string &content, std::string *sink = nullptr)
+        : m_content(content), m_sink(sink), m_offset(0), m_closed(false)
     {
         std::stringstream ss(content);
         std::string line;
@@ -50,6 +53,29 @@ public:
         return String(next);
     }
 
+    size_t read(uint8_t *buffer, size_t length) override {
+        if (m_closed || m_offset >= m_content.size()) {
+            return 0;
+        }
+        const size_t count = std::min(length, m_content.size() - m_offset);
+        std::memcpy(buffer, m_content.data() + m_offset, count);
+        m_offset += count;
+        return count;
+    }
+
+    size_t size() override {
+        return m_content.size();
+    }
+
+    size_t write(const uint8_t *buffer, size_t length) override {
+        if (m_closed || !m_sink) {
+            return 0;
+        }
+        m_content.append(reinterpret_cast<const char *>(buffer), length);
+        m_sink->append(reinterpret_cast<const char *>(buffer), length);
+        return length;
+    }
+
     void close() override {
         m_closed = true;
         while (!m_lines.empty()) {
@@ -59,6 +85,9 @@ public:
 
 private:
     std::queue<std::string> m_lines;
+    std::string m_content;
+    std::string *m_sink;
+    size_t m_offset;
     bool m_closed;
 };
 
@@ -72,7 +101,14 @@ public:
         return path && m_files.find(path) != m_files.end();
     }
 
-    std::unique_ptr<infra::IFile> open(const char *path, const char *) override {
+    std::unique_ptr<infra::IFile> open(const char *path, const char *mode) override {
+        if (path && mode && (mode[0] == 'w' || mode[0] == 'a')) {
+            std::string &content = m_files[path];
+            if (mode[0] == 'w') {
+                content.clear();
+            }
+            return std::unique_ptr<infra::IFile>(new FakeFile(content, &content));
+        }
         auto it = m_files.find(path ? path : "");
         if (it == m_files.end()) {
             return nullptr;
@@ -80,6 +116,30 @@ public:
         return std::unique_ptr<infra::IFile>(new FakeFile(it->second));
     }
 
+    bool remove(const char *path) override {
+        return path && m_files.erase(path) > 0;
+    }
+
+    bool rename(const char *from, const char *to) override {
+        auto it = m_files.find(from ? from : "");
+        if (it == m_files.end() || !to) {
+            return false;
+        }
+        std::string content = it->second;
+        m_files.erase(it);
+        m_files[to] = content;
+        return true;
+    }
+
+    bool makeDirectory(const char *path) override {
+        return path && path[0] == '/';
+    }
+
+    const std::string *contents(const std::string &path) const {
+        auto it = m_files.find(path);
+        return it == m_files.end() ? nullptr : &it->second;
+    }
+
 private:
     std::map<std::string, std::string> m_files;
 };
@@ -3,6 +3,11 @@
 
 #include <Arduino.h>
 
+#include <string>
+
+#include "touch_detector.h"
+#include "touch_trace.h"
+
 class Print {
 public:
     virtual ~Print() = default;
@@ -31,6 +36,27 @@ public:
     bool setFilterAlpha(float value) { filterAlpha = value; return value >= 0.0f && value <= 1.0f; }
     bool setBaselineDrift(float value) { baselineDrift = value; return value >= 0.0f && value <= 0.1f; }
     bool setMultisampleCount(uint8_t count) { multisampleCount = count; return count >= 1; }
+    void setDetectionAlgorithm(TouchDetector::Algorithm algorithm) { detectorConfig.algorithm = algorithm; }
+    bool setPrefilterWindows(uint8_t median, uint8_t hampel) {
+        detectorConfig.medianWindow = median;
+        detectorConfig.hampelWindow = hampel;
+        return median >= 1 && median <= TouchDetector::MAX_WINDOW && hampel <= TouchDetector::MAX_WINDOW;
+    }
+    const TouchDetector::Config &getDetectorConfig() const { return detectorConfig; }
+    bool startTrace(const char *path) {
+        tracePath = path ? path : "";
+        tracing = true;
+        return true;
+    }
+    bool stopTrace() {
+        const bool wasTracing = tracing;
+        tracing = false;
+        return wasTracing;
+    }
+    bool isTracing() const { return tracing; }
+    void setTraceLabel(TouchLabel label) { traceLabel = label; }
+    TouchLabel getTraceLabel() const { return traceLabel; }
+    TouchTraceWriter::Stats getTraceStats() const { return TouchTraceWriter::Stats(); }
     void printStatus(Print &) const { statusPrinted = true; }
     void printSettings(Print &) const { settingsPrinted = true; }
     bool isFingerDetected() const { return fingerDetected; }
@@ -49,6 +75,10 @@ public:
     float filterAlpha = 0.3f;
     float baselineDrift = 0.01f;
     uint8_t multisampleCount = 1;
+    TouchDetector::Config detectorConfig;
+    bool tracing = false;
+    std::string tracePath;
+    TouchLabel traceLabel = TouchLabel::None;
     mutable bool statusPrinted = false;
     mutable bool settingsPrinted = false;
     bool fingerDetected = false;
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "infra/periodic_timer.h"
+
+// Host stand-in for esp_timer: the test advances time and the callback fires
+// once per elapsed period, synchronously.
+class ManualPeriodicTimer : public infra::IPeriodicTimer {
+public:
+    bool start(uint32_t periodMicros, Callback callback, void *context) override {
+        if (failStart || periodMicros == 0 || !callback) {
+            return false;
+        }
+        period = periodMicros;
+        m_callback = callback;
+        m_context = context;
+        m_pending = 0;
+        running = true;
+        ++starts;
+        return true;
+    }
+
+    void stop() override { running = false; }
+
+    bool isRunning() const override { return running; }
+
+    void advanceMicros(uint64_t micros) {
+        m_pending += micros;
+        while (running && m_pending >= period) {
+            m_pending -= period;
+            ++fired;
+            m_callback(m_context);
+        }
+    }
+
+    void advanceMillis(uint32_t millis) { advanceMicros(static_cast<uint64_t>(millis) * 1000); }
+
+    bool failStart = false;
+    bool running = false;
+    uint32_t period = 0;
+    uint32_t starts = 0;
+    uint32_t fired = 0;
+
+private:
+    Callback m_callback = nullptr;
+    void *m_context = nullptr;
+    uint64_t m_pending = 0;
+};
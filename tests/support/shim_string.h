@@ -82,6 +82,19 @@ public:
         return String(m_data.substr(s, e - s));
     }
 
+    bool reserve(unsigned int size) {
+        m_data.reserve(size);
+        return true;
+    }
+
+    bool concat(const char *cstr, unsigned int length) {
+        if (!cstr) {
+            return false;
+        }
+        m_data.append(cstr, length);
+        return true;
+    }
+
     String &operator+=(const String &other) {
         m_data += other.m_data;
         return *this;
@@ -29,6 +29,10 @@ public:
     void setPrinting(bool value) { printing = value; }
     bool isPrinting() const { return printing; }
     bool hasPendingFortune() const { return jobStage != PrintJobStage::Idle; }
+    size_t queuedJobCount() const { return queuedJobs; }
+    bool isPaperLow() const { return paperLow; }
+    void setPaperLow(bool value) { paperLow = value; }
+    void setQueuedJobCount(size_t count) { queuedJobs = count; }
 
     void setHasError(bool value) { errorState = value; }
     bool hasError() const { return errorState; }
@@ -63,6 +67,8 @@ private:
     bool errorState = false;
     PrintJobStage jobStage = PrintJobStage::Idle;
     size_t queuedLines = 0;
+    size_t queuedJobs = 0;
+    bool paperLow = false;
 };
 
 #endif  // THERMAL_PRINTER_STUB_H
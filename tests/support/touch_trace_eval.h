@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "touch_detector.h"
+
+// A touch trace: one averaged sample per period, with the labelled spans
+// [start, end) (sample indices) during which a finger was in the mouth.
+struct TouchTrace {
+    uint32_t periodMs = 32;
+    std::vector<float> samples;
+    std::vector<std::pair<size_t, size_t>> touches;
+};
+
+struct DetectionMetrics {
+    size_t truePositives = 0;
+    size_t falsePositives = 0;
+    size_t misses = 0;
+    float meanDetectMs = 0.0f;
+    uint32_t maxDetectMs = 0;
+
+    float precision() const {
+        const size_t reported = truePositives + falsePositives;
+        return reported ? static_cast<float>(truePositives) / static_cast<float>(reported) : 1.0f;
+    }
+    float recall() const {
+        const size_t labelled = truePositives + misses;
+        return labelled ? static_cast<float>(truePositives) / static_cast<float>(labelled) : 1.0f;
+    }
+    float f1() const {
+        const float p = precision();
+        const float r = recall();
+        return (p + r) > 0.0f ? 2.0f * p * r / (p + r) : 0.0f;
+    }
+};
+
+// Calibrates like FingerSensor's calibration window (mean of the first
+// calibrationSamples, noise = worst deviation floored at 0.1 %, threshold =
+// noise * (1 + sensitivity)), then replays the rest of the trace. Each touch onset inside a labelled span
+// is a true positive timed from the span start; an onset anywhere else, or a
+// second onset in the same span, is a false positive.
+inline DetectionMetrics evaluateDetector(TouchDetector &detector,
+                                         const TouchTrace &trace,
+                                         size_t calibrationSamples,
+                                         float sensitivity = 0.15f) {
+    DetectionMetrics metrics;
+    calibrationSamples = std::min(calibrationSamples, trace.samples.size());
+    if (calibrationSamples == 0) {
+        return metrics;
+    }
+
+    double sum = 0.0;
+    float minSample = trace.samples[0];
+    float maxSample = trace.samples[0];
+    for (size_t i = 0; i < calibrationSamples; ++i) {
+        sum += trace.samples[i];
+        minSample = std::min(minSample, trace.samples[i]);
+        maxSample = std::max(maxSample, trace.samples[i]);
+    }
+    const float baseline = static_cast<float>(sum / calibrationSamples);
+    const float noise = std::max(std::max(baseline - minSample, maxSample - baseline) / baseline, 0.001f);
+    detector.reset(baseline);
+    detector.setThresholdRatio(noise * (1.0f + sensitivity));
+
+    std::vector<bool> matched(trace.touches.size(), false);
+    uint64_t detectSum = 0;
+    bool wasTouched = false;
+    for (size_t i = calibrationSamples; i < trace.samples.size(); ++i) {
+        const bool touched = detector.update(trace.samples[i]);
+        if (touched && !wasTouched) {
+            bool hit = false;
+            for (size_t t = 0; t < trace.touches.size(); ++t) {
+                if (i >= trace.touches[t].first && i < trace.touches[t].second && !matched[t]) {
+                    matched[t] = true;
+                    hit = true;
+                    const uint32_t detectMs = static_cast<uint32_t>(i - trace.touches[t].first) * trace.periodMs;
+                    detectSum += detectMs;
+                    metrics.maxDetectMs = std::max(metrics.maxDetectMs, detectMs);
+                    break;
+                }
+            }
+            if (hit) {
+                ++metrics.truePositives;
+            } else {
+                ++metrics.falsePositives;
+            }
+        }
+        wasTouched = touched;
+    }
+    metrics.misses = trace.touches.size() - metrics.truePositives;
+    if (metrics.truePositives) {
+        metrics.meanDetectMs = static_cast<float>(detectSum) / static_cast<float>(metrics.truePositives);
+    }
+    return metrics;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "finger_sensor_core.h"
+#include "infra/time_provider.h"
+#include "manual_periodic_timer.h"
+#include "touch_sampler.h"
+#include "touch_trace.h"
+#include "touch_trace_eval.h"
+
+// FingerSensor settings a replay can vary without re-flashing
+struct ReplaySettings {
+    float filterAlpha = FingerSensorCore::FILTER_ALPHA_DEFAULT;
+    float baselineDrift = FingerSensorCore::BASELINE_DRIFT_DEFAULT;
+    float thresholdRatio = 0.0f;  // Manual minimum clamp; 0 leaves the adaptive threshold alone
+    float sensitivity = FingerSensorCore::DEFAULT_SENSITIVITY;
+    TouchDetector::Algorithm algorithm = TouchDetector::Algorithm::Threshold;
+    uint8_t medianWindow = 1;
+    uint8_t hampelWindow = 0;
+    uint8_t readingsPerSample = 32;  // Only used for raw (one reading per sample) traces
+};
+
+namespace touch_replay_detail {
+
+class TraceClock : public infra::ITimeProvider {
+public:
+    uint32_t nowMillis() const override { return static_cast<uint32_t>(micros / 1000); }
+    uint64_t nowMicros() const override { return micros; }
+
+    uint64_t micros = 0;
+};
+
+// Stands in for touchRead(): each call returns the next recorded reading and
+// moves the clock to the time it was taken
+struct RecordedPad {
+    const std::vector<TouchTraceRecord> *records = nullptr;
+    TraceClock *clock = nullptr;
+    size_t next = 0;
+    TouchLabel label = TouchLabel::None;
+
+    static uint32_t read(void *context) {
+        auto *pad = static_cast<RecordedPad *>(context);
+        const TouchTraceRecord &record = (*pad->records)[pad->next++];
+        pad->clock->micros = static_cast<uint64_t>(record.timestampMs) * 1000;
+        pad->label = record.label;
+        return static_cast<uint32_t>(std::lround(std::max(0.0f, record.value)));
+    }
+};
+
+// Scores touch onsets against the labels as samples come out of the core
+class OnsetScorer {
+public:
+    void observe(const FingerSensorCore &core, uint32_t timestampMs, TouchLabel label) {
+        const bool armed = core.isCalibrated() && !core.isSettling();
+        if (label == TouchLabel::Touch && m_label != TouchLabel::Touch && armed) {
+            ++m_spans;
+            m_spanStart = timestampMs;
+            m_spanMatched = false;
+        }
+        m_label = label;
+
+        const bool active = core.isTouchActive();
+        if (active && !m_wasActive) {
+            if (label == TouchLabel::Touch && m_spans > 0 && !m_spanMatched) {
+                m_spanMatched = true;
+                ++metrics.truePositives;
+                const uint32_t detectMs = timestampMs - m_spanStart;
+                m_detectSum += detectMs;
+                metrics.maxDetectMs = std::max(metrics.maxDetectMs, detectMs);
+            } else if (label != TouchLabel::None) {
+                ++metrics.falsePositives;
+            }
+        }
+        m_wasActive = active;
+    }
+
+    DetectionMetrics finish() {
+        metrics.misses = m_spans - metrics.truePositives;
+        if (metrics.truePositives) {
+            metrics.meanDetectMs = static_cast<float>(m_detectSum) / static_cast<float>(metrics.truePositives);
+        }
+        return metrics;
+    }
+
+    DetectionMetrics metrics;
+
+private:
+    TouchLabel m_label = TouchLabel::None;
+    size_t m_spans = 0;
+    uint32_t m_spanStart = 0;
+    bool m_spanMatched = false;
+    bool m_wasActive = false;
+    uint64_t m_detectSum = 0;
+};
+
+}  // namespace touch_replay_detail
+
+// Replays a captured trace through FingerSensor's calibration, filter and
+// threshold logic. Raw traces (one reading per sample) go through the real
+// TouchSampler with a stubbed touchRead, so the multisample count can be
+// varied too; averaged traces are fed to the core as recorded. Only touches
+// labelled after calibration and settling are scored, and unlabelled
+// stretches never count against a setting.
+inline DetectionMetrics replayTrace(const TouchTraceHeader &header,
+                                    const std::vector<TouchTraceRecord> &records,
+                                    const ReplaySettings &settings) {
+    using namespace touch_replay_detail;
+    FingerSensorCore core;
+    core.setFilterAlpha(settings.filterAlpha);
+    core.setBaselineDrift(settings.baselineDrift);
+    core.setSensitivity(settings.sensitivity);
+    if (settings.thresholdRatio > 0.0f) {
+        core.setThresholdRatio(settings.thresholdRatio);
+    }
+    core.setDetectionAlgorithm(settings.algorithm);
+    core.setPrefilterWindows(settings.medianWindow, settings.hampelWindow);
+
+    OnsetScorer scorer;
+    if (records.empty()) {
+        return scorer.finish();
+    }
+    core.startCalibration(records.front().timestampMs, false);
+
+    if (header.readingsPerSample == 1 && settings.readingsPerSample > 1) {
+        TraceClock clock;
+        ManualPeriodicTimer timer;
+        RecordedPad pad;
+        pad.records = &records;
+        pad.clock = &clock;
+        TouchSampler sampler(&timer, &clock);
+        const uint32_t period = header.readingPeriodMicros ? header.readingPeriodMicros : 1000;
+        sampler.start(period, &RecordedPad::read, &pad, settings.readingsPerSample);
+        TouchSampler::Sample sample;
+        while (pad.next < records.size()) {
+            timer.advanceMicros(period);
+            while (sampler.pop(sample)) {
+                core.processSample(sample.timestampMs, sample.value);
+                scorer.observe(core, sample.timestampMs, pad.label);
+            }
+        }
+        sampler.stop();
+    } else {
+        for (const TouchTraceRecord &record : records) {
+            core.processSample(record.timestampMs, record.value);
+            scorer.observe(core, record.timestampMs, record.label);
+        }
+    }
+    return scorer.finish();
+}
+
+struct SweepResult {
+    ReplaySettings settings;
+    DetectionMetrics metrics;
+};
+
+// Every combination of the given values on top of `base`, best first: highest
+// F1, then fastest mean detection.
+inline std::vector<SweepResult> sweepTrace(const TouchTraceHeader &header,
+                                           const std::vector<TouchTraceRecord> &records,
+                                           const ReplaySettings &base,
+                                           const std::vector<float> &filterAlphas,
+                                           const std::vector<float> &baselineDrifts,
+                                           const std::vector<float> &thresholdRatios) {
+    std::vector<SweepResult> results;
+    for (float alpha : filterAlphas) {
+        for (float drift : baselineDrifts) {
+            for (float threshold : thresholdRatios) {
+                SweepResult result;
+                result.settings = base;
+                result.settings.filterAlpha = alpha;
+                result.settings.baselineDrift = drift;
+                result.settings.thresholdRatio = threshold;
+                result.metrics = replayTrace(header, records, result.settings);
+                results.push_back(result);
+            }
+        }
+    }
+    std::stable_sort(results.begin(), results.end(), [](const SweepResult &a, const SweepResult &b) {
+        if (a.metrics.f1() != b.metrics.f1()) {
+            return a.metrics.f1() > b.metrics.f1();
+        }
+        return a.metrics.meanDetectMs < b.metrics.meanDetectMs;
+    });
+    return results;
+}
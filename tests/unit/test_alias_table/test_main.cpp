@@ -0,0 +1,95 @@
+#include <unity.h>
+#include "infra/alias_table.h"
+#include "infra/random_source.h"
+
+#include <vector>
+
+namespace {
+
+// Replays fixed draws, clamped into the requested range
+class ScriptedRandomSource : public infra::IRandomSource {
+public:
+    int nextInt(int minInclusive, int maxExclusive) override {
+        ++calls;
+        const int value = values.empty() ? 0 : values[next++ % values.size()];
+        return value < minInclusive ? minInclusive : (value >= maxExclusive ? maxExclusive - 1 : value);
+    }
+
+    std::vector<int> values;
+    size_t next = 0;
+    size_t calls = 0;
+};
+
+// Counts the pick for every possible (column, coin) draw
+std::vector<uint32_t> tally(const infra::AliasTable &table) {
+    std::vector<uint32_t> counts(table.size(), 0);
+    ScriptedRandomSource random;
+    for (size_t column = 0; column < table.size(); ++column) {
+        for (uint32_t coin = 0; coin < infra::AliasTable::COIN_RANGE; ++coin) {
+            random.values = {static_cast<int>(column), static_cast<int>(coin)};
+            random.next = 0;
+            ++counts[table.pick(random)];
+        }
+    }
+    return counts;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_equal_weights_use_a_single_uniform_draw(void) {
+    infra::AliasTable table;
+    TEST_ASSERT_TRUE(table.build({3, 3, 3, 3}));
+    TEST_ASSERT_TRUE(table.uniform());
+
+    ScriptedRandomSource random;
+    random.values = {2};
+    const size_t pick = table.pick(random);
+    TEST_ASSERT_EQUAL_UINT32(2, pick);
+    TEST_ASSERT_EQUAL_UINT32(1, random.calls);
+}
+
+static void test_weighted_picks_match_weights_exactly(void) {
+    infra::AliasTable table;
+    TEST_ASSERT_TRUE(table.build({1, 2, 5, 0}));
+    TEST_ASSERT_FALSE(table.uniform());
+    TEST_ASSERT_EQUAL_UINT32(4, table.size());
+    TEST_ASSERT_EQUAL_UINT32(3, table.activeCount());
+
+    // 4 columns x 65536 coins = 262144 outcomes, split 1:2:5:0
+    const std::vector<uint32_t> counts = tally(table);
+    TEST_ASSERT_EQUAL_UINT32(32768, counts[0]);
+    TEST_ASSERT_EQUAL_UINT32(65536, counts[1]);
+    TEST_ASSERT_EQUAL_UINT32(163840, counts[2]);
+    TEST_ASSERT_EQUAL_UINT32(0, counts[3]);
+}
+
+static void test_uneven_weights_stay_within_rounding(void) {
+    infra::AliasTable table;
+    TEST_ASSERT_TRUE(table.build({7, 1, 3}));
+    const std::vector<uint32_t> counts = tally(table);
+    const uint32_t outcomes = 3 * infra::AliasTable::COIN_RANGE;
+    const uint32_t expected[] = {outcomes * 7 / 11, outcomes / 11, outcomes * 3 / 11};
+    for (size_t i = 0; i < 3; ++i) {
+        TEST_ASSERT_UINT32_WITHIN(3, expected[i], counts[i]);
+    }
+}
+
+static void test_build_rejects_empty_and_all_zero(void) {
+    infra::AliasTable table;
+    TEST_ASSERT_FALSE(table.build({}));
+    TEST_ASSERT_FALSE(table.build({0, 0}));
+    TEST_ASSERT_EQUAL_UINT32(0, table.size());
+    TEST_ASSERT_EQUAL_UINT32(0, table.activeCount());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_equal_weights_use_a_single_uniform_draw);
+    RUN_TEST(test_weighted_picks_match_weights_exactly);
+    RUN_TEST(test_uneven_weights_stay_within_rounding);
+    RUN_TEST(test_build_rejects_empty_and_all_zero);
+    return UNITY_END();
+}
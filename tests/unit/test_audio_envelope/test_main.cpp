@@ -0,0 +1,126 @@
+#include <unity.h>
+
+#include "audio_envelope.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr uint32_t SAMPLE_RATE = 44100;
+
+AudioBlockFeatures block(float rms, uint32_t frames) {
+    AudioBlockFeatures features;
+    features.rms = rms;
+    features.frames = frames;
+    features.durationUs = static_cast<uint32_t>((static_cast<uint64_t>(frames) * 1000000ull) / SAMPLE_RATE);
+    return features;
+}
+
+// Feeds a constant level for roughly durationMs in blocks of `frames`
+void feed(AudioEnvelope &envelope, float rms, uint32_t durationMs, uint32_t frames) {
+    const uint32_t blocks = (durationMs * SAMPLE_RATE + frames * 500) / (frames * 1000);
+    for (uint32_t i = 0; i < blocks; ++i) {
+        envelope.update(block(rms, frames));
+    }
+}
+
+AudioEnvelope::Settings settings(uint32_t attackMs, uint32_t releaseMs) {
+    AudioEnvelope::Settings s;
+    s.attackMs = attackMs;
+    s.releaseMs = releaseMs;
+    s.floorRms = 0.0f;
+    s.ceilingRms = 1000.0f;
+    return s;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_block_features_from_sum_of_squares(void) {
+    // Two channels at a constant +-300: RMS 300
+    const AudioBlockFeatures features = AudioBlockFeatures::fromSumOfSquares(300.0 * 300.0 * 256, 256, 128, SAMPLE_RATE);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 300.0f, features.rms);
+    TEST_ASSERT_EQUAL_UINT32(128, features.frames);
+    TEST_ASSERT_EQUAL_UINT32(2902, features.durationUs);
+
+    const AudioBlockFeatures empty = AudioBlockFeatures::fromSumOfSquares(0.0, 0, 0, SAMPLE_RATE);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, empty.rms);
+    TEST_ASSERT_EQUAL_UINT32(0, empty.durationUs);
+}
+
+static void test_attack_reaches_one_time_constant(void) {
+    AudioEnvelope envelope(settings(20, 250));
+    feed(envelope, 1000.0f, 20, 128);
+    // 1 - e^-1 after one time constant
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.632f, envelope.value());
+}
+
+static void test_release_is_slower_than_attack(void) {
+    AudioEnvelope envelope(settings(20, 250));
+    feed(envelope, 1000.0f, 200, 128);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, envelope.value());
+
+    feed(envelope, 0.0f, 20, 128);
+    // Only ~8% of the way down after an attack time constant
+    TEST_ASSERT_FLOAT_WITHIN(0.03f, 0.923f, envelope.value());
+    feed(envelope, 0.0f, 230, 128);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.368f, envelope.value());
+}
+
+static void test_response_does_not_depend_on_block_size(void) {
+    AudioEnvelope small(settings(20, 250));
+    AudioEnvelope large(settings(20, 250));
+    feed(small, 800.0f, 30, 64);
+    feed(large, 800.0f, 30, 441);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, small.value(), large.value());
+}
+
+static void test_zero_time_constant_follows_input(void) {
+    AudioEnvelope envelope(settings(0, 0));
+    envelope.update(block(500.0f, 128));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, envelope.value());
+    envelope.update(block(0.0f, 128));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, envelope.value());
+}
+
+static void test_level_maps_between_floor_and_ceiling(void) {
+    AudioEnvelope::Settings s = settings(0, 0);
+    s.floorRms = 200.0f;
+    s.ceilingRms = 3000.0f;
+    AudioEnvelope envelope(s);
+
+    envelope.update(block(150.0f, 128));
+    TEST_ASSERT_EQUAL_UINT8(100, envelope.level(100, 255));
+    envelope.update(block(1600.0f, 128));
+    TEST_ASSERT_EQUAL_UINT8(178, envelope.level(100, 255));
+    envelope.update(block(9000.0f, 128));
+    TEST_ASSERT_EQUAL_UINT8(255, envelope.level(100, 255));
+
+    envelope.reset();
+    TEST_ASSERT_EQUAL_UINT8(100, envelope.level(100, 255));
+}
+
+static void test_settings_keep_ceiling_above_floor(void) {
+    AudioEnvelope::Settings s;
+    s.floorRms = 500.0f;
+    s.ceilingRms = 100.0f;
+    AudioEnvelope envelope(s);
+    TEST_ASSERT_TRUE(envelope.settings().ceilingRms > envelope.settings().floorRms);
+
+    envelope.update(block(10000.0f, 128));
+    TEST_ASSERT_FALSE(std::isnan(envelope.value()));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_block_features_from_sum_of_squares);
+    RUN_TEST(test_attack_reaches_one_time_constant);
+    RUN_TEST(test_release_is_slower_than_attack);
+    RUN_TEST(test_response_does_not_depend_on_block_size);
+    RUN_TEST(test_zero_time_constant_follows_input);
+    RUN_TEST(test_level_maps_between_floor_and_ceiling);
+    RUN_TEST(test_settings_keep_ceiling_above_floor);
+    return UNITY_END();
+}
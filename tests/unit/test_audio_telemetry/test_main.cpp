@@ -0,0 +1,138 @@
+#include <unity.h>
+
+#include "audio_telemetry.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t CAPACITY = 8192;
+constexpr uint32_t FRAMES = 128;
+
+std::vector<std::string> collectReport(const AudioTelemetry &telemetry) {
+    std::vector<std::string> lines;
+    telemetry.writeReport([&lines](const char *line) { lines.emplace_back(line); });
+    return lines;
+}
+
+bool reportContains(const std::vector<std::string> &lines, const char *needle) {
+    for (const auto &line : lines) {
+        if (line.find(needle) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_consecutive_short_callbacks_count_as_one_event(void) {
+    AudioTelemetry telemetry;
+    telemetry.recordCallback(4096, CAPACITY, FRAMES, 0, true);
+    telemetry.recordCallback(256, CAPACITY, FRAMES, 64, true);
+    telemetry.recordCallback(0, CAPACITY, FRAMES, FRAMES, true);
+    telemetry.recordCallback(2048, CAPACITY, FRAMES, 0, true);
+    telemetry.recordCallback(0, CAPACITY, FRAMES, FRAMES, true);
+
+    TEST_ASSERT_EQUAL_UINT32(5, telemetry.callbacks());
+    TEST_ASSERT_EQUAL_UINT32(2, telemetry.underrunEvents());
+    TEST_ASSERT_EQUAL_UINT32(3, telemetry.underrunCallbacks());
+    TEST_ASSERT_EQUAL_UINT32(64 + FRAMES + FRAMES, telemetry.silentFrames());
+    TEST_ASSERT_EQUAL_UINT32(5 * FRAMES, telemetry.framesRequested());
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.minStreamingFillBytes());
+}
+
+static void test_silence_after_playback_is_not_an_underrun(void) {
+    AudioTelemetry telemetry;
+    telemetry.recordCallback(512, CAPACITY, FRAMES, 0, true);
+    telemetry.recordCallback(100, CAPACITY, FRAMES, 103, false);
+    telemetry.recordCallback(0, CAPACITY, FRAMES, FRAMES, false);
+
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.underrunEvents());
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.silentFrames());
+    TEST_ASSERT_EQUAL_UINT32(512, telemetry.minStreamingFillBytes());
+}
+
+static void test_fill_histogram_buckets_by_eighths(void) {
+    AudioTelemetry telemetry;
+    telemetry.recordCallback(0, CAPACITY, FRAMES, FRAMES, false);
+    telemetry.recordCallback(1023, CAPACITY, FRAMES, 0, false);
+    telemetry.recordCallback(1024, CAPACITY, FRAMES, 0, false);
+    telemetry.recordCallback(CAPACITY, CAPACITY, FRAMES, 0, false);
+
+    TEST_ASSERT_EQUAL_UINT32(2, telemetry.fillBucket(0));
+    TEST_ASSERT_EQUAL_UINT32(1, telemetry.fillBucket(1));
+    TEST_ASSERT_EQUAL_UINT32(1, telemetry.fillBucket(AudioTelemetry::FILL_BUCKETS - 1));
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.fillBucket(AudioTelemetry::FILL_BUCKETS));
+}
+
+static void test_latency_histograms_track_sd_and_open(void) {
+    AudioTelemetry telemetry;
+    for (int i = 0; i < 99; ++i) {
+        telemetry.recordSdRead(400);
+    }
+    telemetry.recordSdRead(12000);
+    telemetry.recordFileOpen(8000, true);
+    telemetry.recordFileOpen(30000, false);
+    telemetry.recordRefill(1500, 4096);
+    telemetry.recordRefill(900, 512);
+
+    TEST_ASSERT_EQUAL_UINT32(100, telemetry.sdReadLatency().count());
+    TEST_ASSERT_EQUAL_UINT32(400, telemetry.sdReadLatency().minUs());
+    TEST_ASSERT_EQUAL_UINT32(12000, telemetry.sdReadLatency().maxUs());
+    TEST_ASSERT_TRUE(telemetry.sdReadLatency().percentileUs(990) < 500);
+    TEST_ASSERT_EQUAL_UINT32(2, telemetry.fileOpenLatency().count());
+    TEST_ASSERT_EQUAL_UINT32(1, telemetry.openFailures());
+    TEST_ASSERT_EQUAL_UINT32(2, telemetry.refillLatency().count());
+    TEST_ASSERT_EQUAL_UINT32(1200, telemetry.refillLatency().avgUs());
+    TEST_ASSERT_EQUAL_UINT64(4608, telemetry.bytesRefilled());
+}
+
+static void test_reset_clears_everything(void) {
+    AudioTelemetry telemetry;
+    telemetry.recordCallback(0, CAPACITY, FRAMES, FRAMES, true);
+    telemetry.recordSdRead(100);
+    telemetry.recordFileOpen(100, false);
+    telemetry.reset();
+
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.callbacks());
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.underrunEvents());
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.fillBucket(0));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, telemetry.minStreamingFillBytes());
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.sdReadLatency().count());
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.openFailures());
+
+    // A short callback right after reset starts a fresh event.
+    telemetry.recordCallback(0, CAPACITY, FRAMES, FRAMES, true);
+    TEST_ASSERT_EQUAL_UINT32(1, telemetry.underrunEvents());
+}
+
+static void test_report_and_summary_include_key_figures(void) {
+    AudioTelemetry telemetry;
+    telemetry.recordCallback(0, CAPACITY, FRAMES, FRAMES, true);
+    telemetry.recordSdRead(700);
+
+    const auto lines = collectReport(telemetry);
+    TEST_ASSERT_EQUAL_STRING("=== AUDIO STATS ===", lines.front().c_str());
+    TEST_ASSERT_TRUE(reportContains(lines, "Underruns:       1 events"));
+    TEST_ASSERT_TRUE(reportContains(lines, "sd read"));
+
+    char summary[128];
+    telemetry.writeSummary(summary, sizeof(summary));
+    TEST_ASSERT_TRUE(std::string(summary).find("underruns=1 silent=128") != std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_consecutive_short_callbacks_count_as_one_event);
+    RUN_TEST(test_silence_after_playback_is_not_an_underrun);
+    RUN_TEST(test_fill_histogram_buckets_by_eighths);
+    RUN_TEST(test_latency_histograms_track_sd_and_open);
+    RUN_TEST(test_reset_clears_everything);
+    RUN_TEST(test_report_and_summary_include_key_figures);
+    return UNITY_END();
+}
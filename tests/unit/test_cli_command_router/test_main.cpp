@@ -2,6 +2,7 @@
 #include <unity.h>
 
 #include "cli_command_router.h"
+#include "infra/log_sink.h"
 
 #include <cstdarg>
 #include <cstdio>
@@ -64,6 +65,11 @@ struct RouterFixture {
     int servoPinValue = 23;
     bool configPrinted = false;
     bool sdPrinted = false;
+    bool memPrinted = false;
+    bool perfPrinted = false;
+    bool perfReset = false;
+    bool audioStatsPrinted = false;
+    bool audioStatsReset = false;
     bool fallbackCalled = false;
     String lastFallbackCommand;
     CliCommandRouter router;
@@ -89,6 +95,20 @@ private:
             sdPrinted = true;
             out.println("\n=== SD SUMMARY ===");
         };
+        deps.memoryReporter = [&](CliCommandRouter::IPrinter &out) {
+            memPrinted = true;
+            out.println("=== MEMORY ===");
+        };
+        deps.loopProfileReporter = [&](CliCommandRouter::IPrinter &out) {
+            perfPrinted = true;
+            out.println("=== LOOP PROFILE (us) ===");
+        };
+        deps.loopProfileReset = [&]() { perfReset = true; };
+        deps.audioStatsReporter = [&](CliCommandRouter::IPrinter &out) {
+            audioStatsPrinted = true;
+            out.println("=== AUDIO STATS ===");
+        };
+        deps.audioStatsReset = [&]() { audioStatsReset = true; };
         deps.thermalPrinter = &printerDevice;
         if (withFallback) {
             deps.legacyHandler = [&](String cmd) {
@@ -202,6 +222,30 @@ static void test_fmultisample_sets_count() {
     TEST_ASSERT_EQUAL_UINT8(5, fx.sensor.multisampleCount);
 }
 
+static void test_fdetect_and_ffilter_configure_detector() {
+    RouterFixture fx;
+    fx.router.handleCommand("fdetect cusum");
+    TEST_ASSERT_TRUE(fx.sensor.detectorConfig.algorithm == TouchDetector::Algorithm::Cusum);
+    fx.router.handleCommand("fdetect bogus");
+    TEST_ASSERT_TRUE(fx.sensor.detectorConfig.algorithm == TouchDetector::Algorithm::Cusum);
+    fx.router.handleCommand("ffilter 3 7");
+    TEST_ASSERT_EQUAL_UINT8(3, fx.sensor.detectorConfig.medianWindow);
+    TEST_ASSERT_EQUAL_UINT8(7, fx.sensor.detectorConfig.hampelWindow);
+}
+
+static void test_ftrace_starts_labels_and_stops_capture() {
+    RouterFixture fx;
+    fx.router.handleCommand("ftrace start");
+    TEST_ASSERT_TRUE(fx.sensor.tracing);
+    TEST_ASSERT_EQUAL_STRING("/touch_trace.bin", fx.sensor.tracePath.c_str());
+    fx.router.handleCommand("ftrace touch");
+    TEST_ASSERT_TRUE(fx.sensor.traceLabel == TouchLabel::Touch);
+    fx.router.handleCommand("ftrace stop");
+    TEST_ASSERT_FALSE(fx.sensor.tracing);
+    fx.router.handleCommand("ftrace start /traces/night.bin");
+    TEST_ASSERT_EQUAL_STRING("/traces/night.bin", fx.sensor.tracePath.c_str());
+}
+
 static void test_fstatus_invokes_sensor_status() {
     RouterFixture fx;
     fx.router.handleCommand("fstatus");
@@ -242,6 +286,66 @@ static void test_sdcard_alias_uses_provider() {
     TEST_ASSERT_TRUE(fx.sdPrinted);
 }
 
+static void test_mem_command_uses_provider() {
+    RouterFixture fx;
+    fx.router.handleCommand("mem");
+    TEST_ASSERT_TRUE(fx.memPrinted);
+    TEST_ASSERT_EQUAL_STRING("=== MEMORY ===", fx.printer.lines.back().c_str());
+}
+
+static void test_mem_command_without_provider_reports_error() {
+    CapturePrinter printer;
+    CliCommandRouter::Dependencies deps;
+    deps.printer = &printer;
+    CliCommandRouter router(deps);
+    router.handleCommand("memory");
+    TEST_ASSERT_TRUE(printer.transcript.find("Memory monitor unavailable") != std::string::npos);
+}
+
+static void test_perf_command_uses_provider() {
+    RouterFixture fx;
+    fx.router.handleCommand("perf");
+    TEST_ASSERT_TRUE(fx.perfPrinted);
+    TEST_ASSERT_FALSE(fx.perfReset);
+}
+
+static void test_perf_reset_clears_profile() {
+    RouterFixture fx;
+    fx.router.handleCommand("PERF RESET");
+    TEST_ASSERT_TRUE(fx.perfReset);
+    TEST_ASSERT_FALSE(fx.perfPrinted);
+    TEST_ASSERT_TRUE(fx.printer.transcript.find("Loop profile reset") != std::string::npos);
+}
+
+static void test_audiostats_command_uses_provider() {
+    RouterFixture fx;
+    fx.router.handleCommand("audiostats");
+    TEST_ASSERT_TRUE(fx.audioStatsPrinted);
+    fx.router.handleCommand("audiostats reset");
+    TEST_ASSERT_TRUE(fx.audioStatsReset);
+}
+
+static void test_audiostats_without_player_reports_error() {
+    CapturePrinter printer;
+    CliCommandRouter::Dependencies deps;
+    deps.printer = &printer;
+    CliCommandRouter router(deps);
+    router.handleCommand("audiostats");
+    TEST_ASSERT_TRUE(printer.transcript.find("Audio player unavailable") != std::string::npos);
+}
+
+static void test_loglevel_sets_and_reports_filters() {
+    RouterFixture fx;
+    fx.router.handleCommand("LogLevel Warn");
+    TEST_ASSERT_EQUAL(static_cast<int>(infra::LogLevel::Warn), static_cast<int>(infra::logLevel()));
+    fx.router.handleCommand("loglevel");
+    TEST_ASSERT_TRUE(fx.printer.transcript.find(">>> Log level: warn") != std::string::npos);
+    fx.router.handleCommand("loglevel loud");
+    TEST_ASSERT_TRUE(fx.printer.transcript.find("Usage: loglevel") != std::string::npos);
+    fx.router.handleCommand("loglevel reset");
+    TEST_ASSERT_EQUAL(static_cast<int>(infra::LogLevel::Verbose), static_cast<int>(infra::logLevel()));
+}
+
 static void test_ptest_runs_when_ready() {
     RouterFixture fx;
     fx.printerDevice.setReady(true);
@@ -295,6 +399,7 @@ static void test_smin_moves_to_min() {
     fx.servo.setInitialState(40, 0, 80, 1400, 1600);
     fx.router.handleCommand("smin");
     TEST_ASSERT_EQUAL(0, fx.servo.lastSmoothMoveTarget);
+    TEST_ASSERT_TRUE(fx.printer.transcript.find("Servo move to MIN queued: 0 degrees (1400 µs)") != std::string::npos);
 }
 
 static void test_smin_adjusts_microseconds() {
@@ -311,6 +416,7 @@ static void test_smax_moves_to_max() {
     fx.servo.setInitialState(10, 0, 80, 1400, 1600);
     fx.router.handleCommand("smax");
     TEST_ASSERT_EQUAL(80, fx.servo.lastSmoothMoveTarget);
+    TEST_ASSERT_TRUE(fx.printer.transcript.find("Servo move to MAX queued: 80 degrees (1600 µs)") != std::string::npos);
 }
 
 static void test_smic_sets_pulse_width() {
@@ -380,12 +486,21 @@ int main() {
     RUN_TEST(test_falpha_sets_filter_alpha);
     RUN_TEST(test_fdrift_sets_baseline_drift);
     RUN_TEST(test_fmultisample_sets_count);
+    RUN_TEST(test_fdetect_and_ffilter_configure_detector);
+    RUN_TEST(test_ftrace_starts_labels_and_stops_capture);
     RUN_TEST(test_fstatus_invokes_sensor_status);
     RUN_TEST(test_fsettings_invokes_sensor_settings);
     RUN_TEST(test_config_command_invokes_printer);
     RUN_TEST(test_settings_alias_invokes_printer);
     RUN_TEST(test_sd_command_uses_provider);
     RUN_TEST(test_sdcard_alias_uses_provider);
+    RUN_TEST(test_mem_command_uses_provider);
+    RUN_TEST(test_mem_command_without_provider_reports_error);
+    RUN_TEST(test_perf_command_uses_provider);
+    RUN_TEST(test_perf_reset_clears_profile);
+    RUN_TEST(test_audiostats_command_uses_provider);
+    RUN_TEST(test_audiostats_without_player_reports_error);
+    RUN_TEST(test_loglevel_sets_and_reports_filters);
     RUN_TEST(test_ptest_runs_when_ready);
     RUN_TEST(test_ptest_reports_when_not_ready);
     RUN_TEST(test_ptest_failure_path);
@@ -58,6 +58,7 @@ static void test_defaults_align_with_spec(void) {
     TEST_ASSERT_TRUE(config.loadConfig());
     TEST_ASSERT_EQUAL_FLOAT(0.002f, config.getCapThreshold());
     TEST_ASSERT_EQUAL_STRING("/printer/fortunes_littlekid.json", config.getFortunesJson().c_str());
+    TEST_ASSERT_EQUAL_STRING("", config.getPrinterFont().c_str());
 }
 
 static void test_invalid_servo_values_fall_back(void) {
@@ -133,6 +134,70 @@ static void test_invalid_led_pulse_defaults(void) {
     TEST_ASSERT_EQUAL(1500UL, config.getMouthLedPulsePeriodMs());
 }
 
+static void test_led_pwm_keys_validate(void) {
+    FakeFileSystem fs;
+    fs.addFile("/config.txt",
+               "led_pwm_bits=14\n"
+               "led_gamma=false\n"
+               "led_audio_attack_ms=5\n"
+               "led_audio_release_ms=400\n");
+
+    ConfigManager &config = ConfigManager::getInstance();
+    config.setFileSystem(&fs);
+
+    TEST_ASSERT_TRUE(config.loadConfig());
+    TEST_ASSERT_EQUAL_UINT8(14, config.getLedPwmBits());
+    TEST_ASSERT_FALSE(config.getLedGamma());
+    TEST_ASSERT_EQUAL_UINT32(5, config.getLedAudioAttackMs());
+    TEST_ASSERT_EQUAL_UINT32(400, config.getLedAudioReleaseMs());
+
+    fs.addFile("/config.txt", "led_pwm_bits=20\nled_audio_release_ms=9000\n");
+    TEST_ASSERT_TRUE(config.loadConfig());
+    TEST_ASSERT_EQUAL_UINT8(12, config.getLedPwmBits());
+    TEST_ASSERT_TRUE(config.getLedGamma());
+    TEST_ASSERT_EQUAL_UINT32(20, config.getLedAudioAttackMs());
+    TEST_ASSERT_EQUAL_UINT32(250, config.getLedAudioReleaseMs());
+}
+
+static void test_finger_detector_keys_validate(void) {
+    FakeFileSystem fs;
+    fs.addFile("/config.txt",
+               "finger_detector=ph\n"
+               "finger_median_window=3\n"
+               "finger_hampel_window=40\n");
+
+    ConfigManager &config = ConfigManager::getInstance();
+    config.setFileSystem(&fs);
+
+    TEST_ASSERT_TRUE(config.loadConfig());
+    TEST_ASSERT_EQUAL_STRING("ph", config.getFingerDetector().c_str());
+    TEST_ASSERT_EQUAL_UINT8(3, config.getFingerMedianWindow());
+    TEST_ASSERT_EQUAL_UINT8(0, config.getFingerHampelWindow());
+
+    fs.addFile("/config.txt", "finger_detector=magic\n");
+    TEST_ASSERT_TRUE(config.loadConfig());
+    TEST_ASSERT_EQUAL_STRING("threshold", config.getFingerDetector().c_str());
+    TEST_ASSERT_EQUAL_UINT8(1, config.getFingerMedianWindow());
+}
+
+static void test_duplicate_keys_keep_last_value_and_trim(void) {
+    FakeFileSystem fs;
+    fs.addFile("/config.txt",
+               "  role = primary  \n"
+               "wifi_ssid=First\n"
+               "role=secondary\n"
+               "printer_logo =\n");
+
+    ConfigManager &config = ConfigManager::getInstance();
+    config.setFileSystem(&fs);
+
+    TEST_ASSERT_TRUE(config.loadConfig());
+    TEST_ASSERT_EQUAL_STRING("secondary", config.getRole().c_str());
+    TEST_ASSERT_EQUAL_STRING("First", config.getWiFiSSID().c_str());
+    TEST_ASSERT_EQUAL_STRING("", config.getValue("printer_logo", "unset").c_str());
+    TEST_ASSERT_EQUAL_STRING("unset", config.getValue("missing", "unset").c_str());
+}
+
 int main(int argc, char **argv) {
     UNITY_BEGIN();
     RUN_TEST(test_load_config_happy_path);
@@ -142,5 +207,8 @@ int main(int argc, char **argv) {
     RUN_TEST(test_logs_warning_for_invalid_speaker_volume);
     RUN_TEST(test_invalid_timing_defaults);
     RUN_TEST(test_invalid_led_pulse_defaults);
+    RUN_TEST(test_led_pwm_keys_validate);
+    RUN_TEST(test_finger_detector_keys_validate);
+    RUN_TEST(test_duplicate_keys_keep_last_value_and_trim);
     return UNITY_END();
 }
@@ -0,0 +1,224 @@
+#include <unity.h>
+#include "fortune_generator.h"
+#include "fake_filesystem.h"
+#include "infra/random_source.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Compares the compiled FortuneGenerator against the previous per-call
+// implementation (token map built for every fortune, template rescanned with
+// indexOf/substring). Both draw from identically seeded sources, so their
+// output must match exactly; the throughput of each is printed.
+
+namespace {
+
+constexpr int ITERATIONS = 20000;
+
+const std::vector<std::string> TEMPLATES = {
+    "Your {{item}} will {{fate}} before the {{event}}.",
+    "Beware the {{creature}} that guards your {{item}}.",
+    "When the {{event}} comes, {{creature}} will {{fate}}.",
+    "Death sees a {{creature}} in your future.",
+    "The {{creature}} and the {{creature}} will {{fate}} at the {{event}}, but your {{item}} is safe.",
+};
+
+const std::vector<std::pair<std::string, std::vector<std::string>>> WORDLISTS = {
+    {"item", {"lunchbox", "left sock", "library book", "pumpkin"}},
+    {"fate", {"vanish", "glow", "sing at midnight", "grow whiskers"}},
+    {"event", {"full moon", "next snow", "school bell", "harvest"}},
+    {"creature", {"bat", "raven", "friendly ghost", "black cat"}},
+};
+
+class LcgRandomSource : public infra::IRandomSource {
+public:
+    explicit LcgRandomSource(uint32_t seed) : state(seed) {}
+
+    int nextInt(int minInclusive, int maxExclusive) override {
+        state = state * 1664525u + 1013904223u;
+        const int span = maxExclusive - minInclusive;
+        return span > 0 ? minInclusive + static_cast<int>((state >> 8) % static_cast<uint32_t>(span)) : minInclusive;
+    }
+
+private:
+    uint32_t state;
+};
+
+// The generator as it was before templates were compiled at load time
+class LegacyGenerator {
+public:
+    explicit LegacyGenerator(infra::IRandomSource &random) : random(random) {
+        for (const auto &text : TEMPLATES) {
+            Template entry;
+            entry.text = text.c_str();
+            entry.tokens = extractTokens(entry.text);
+            templates.push_back(entry);
+        }
+        for (const auto &list : WORDLISTS) {
+            std::vector<String> words;
+            for (const auto &word : list.second) {
+                words.emplace_back(word.c_str());
+            }
+            wordlists[String(list.first.c_str())] = words;
+        }
+    }
+
+    String generate() {
+        const Template &entry = templates[random.nextInt(0, static_cast<int>(templates.size()))];
+        std::map<String, String> replacements;
+        for (const auto &token : entry.tokens) {
+            replacements[token] = randomWord(token);
+        }
+        return replaceTokens(entry.text, replacements);
+    }
+
+private:
+    struct Template {
+        String text;
+        std::vector<String> tokens;
+    };
+
+    String randomWord(const String &category) {
+        if (wordlists.find(category) != wordlists.end() && !wordlists[category].empty()) {
+            return wordlists[category][random.nextInt(0, static_cast<int>(wordlists[category].size()))];
+        }
+        return "mystery";
+    }
+
+    static std::vector<String> extractTokens(const String &text) {
+        std::vector<String> tokens;
+        int start = 0;
+        while (true) {
+            const int open = text.indexOf("{{", start);
+            if (open == -1) break;
+            const int close = text.indexOf("}}", open + 2);
+            if (close == -1) break;
+            String token = text.substring(open + 2, close);
+            token.trim();
+            bool exists = false;
+            for (const auto &existing : tokens) {
+                exists = exists || existing == token;
+            }
+            if (token.length() > 0 && !exists) {
+                tokens.push_back(token);
+            }
+            start = close + 2;
+        }
+        return tokens;
+    }
+
+    static String replaceTokens(const String &text, const std::map<String, String> &replacements) {
+        String result;
+        const int length = text.length();
+        int index = 0;
+        while (index < length) {
+            const int open = text.indexOf("{{", index);
+            if (open == -1) {
+                result += text.substring(index);
+                break;
+            }
+            result += text.substring(index, open);
+            const int close = text.indexOf("}}", open + 2);
+            if (close == -1) {
+                result += text.substring(open);
+                break;
+            }
+            String token = text.substring(open + 2, close);
+            token.trim();
+            auto it = replacements.find(token);
+            result += it != replacements.end() ? it->second : "{{" + token + "}}";
+            index = close + 2;
+        }
+        return result;
+    }
+
+    infra::IRandomSource &random;
+    std::vector<Template> templates;
+    std::map<String, std::vector<String>> wordlists;
+};
+
+std::string fortuneJson() {
+    std::string json = "{\"version\": 1, \"templates\": [";
+    for (size_t i = 0; i < TEMPLATES.size(); ++i) {
+        json += (i ? ", \"" : "\"") + TEMPLATES[i] + "\"";
+    }
+    json += "], \"wordlists\": {";
+    for (size_t i = 0; i < WORDLISTS.size(); ++i) {
+        json += (i ? ", \"" : "\"") + WORDLISTS[i].first + "\": [";
+        for (size_t w = 0; w < WORDLISTS[i].second.size(); ++w) {
+            json += (w ? ", \"" : "\"") + WORDLISTS[i].second[w] + "\"";
+        }
+        json += "]";
+    }
+    return json + "}}";
+}
+
+template <typename Fn>
+double fortunesPerSecond(Fn generate, size_t &checksum) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        checksum += static_cast<size_t>(generate().length());
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() > 0 ? ITERATIONS / elapsed.count() : 0.0;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_compiled_output_matches_legacy(void) {
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json", fortuneJson());
+    FortuneGenerator generator;
+    LcgRandomSource compiledRandom(42);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&compiledRandom);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+
+    LcgRandomSource legacyRandom(42);
+    LegacyGenerator legacy(legacyRandom);
+    for (int i = 0; i < 500; ++i) {
+        const String expected = legacy.generate();
+        const String actual = generator.generateFortune();
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), actual.c_str());
+    }
+}
+
+static void test_benchmark_fortunes_per_second(void) {
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json", fortuneJson());
+    FortuneGenerator generator;
+    LcgRandomSource compiledRandom(7);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&compiledRandom);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+
+    LcgRandomSource legacyRandom(7);
+    LegacyGenerator legacy(legacyRandom);
+
+    size_t legacyChars = 0;
+    size_t compiledChars = 0;
+    const double legacyRate = fortunesPerSecond([&legacy]() { return legacy.generate(); }, legacyChars);
+    const double compiledRate = fortunesPerSecond([&generator]() { return generator.generateFortune(); }, compiledChars);
+
+    std::printf("fortune benchmark (%d fortunes): legacy %.0f/s, compiled %.0f/s (%.2fx)\n",
+                ITERATIONS,
+                legacyRate,
+                compiledRate,
+                legacyRate > 0 ? compiledRate / legacyRate : 0.0);
+    TEST_ASSERT_EQUAL_UINT32(legacyChars, compiledChars);
+    TEST_ASSERT_TRUE(compiledRate > 0);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_compiled_output_matches_legacy);
+    RUN_TEST(test_benchmark_fortunes_per_second);
+    return UNITY_END();
+}
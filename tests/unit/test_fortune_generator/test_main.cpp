@@ -6,6 +6,10 @@
 #include "fake_log_sink.h"
 #include "fixture_loader.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 class FakeRandomSource : public infra::IRandomSource {
 public:
     int nextInt(int minInclusive, int maxExclusive) override {
@@ -17,6 +21,17 @@ public:
     int forcedValue = 0;
 };
 
+class SequenceRandomSource : public infra::IRandomSource {
+public:
+    int nextInt(int minInclusive, int maxExclusive) override {
+        const int value = values.empty() ? 0 : values[next++ % values.size()];
+        return std::max(minInclusive, std::min(value, maxExclusive - 1));
+    }
+
+    std::vector<int> values;
+    size_t next = 0;
+};
+
 static constexpr const char *FORTUNE_TAG = "FortuneGenerator";
 
 void setUp(void) {}
@@ -95,10 +110,274 @@ static void test_load_fails_when_wordlist_missing_token(void) {
     infra::setLogSink(nullptr);
 }
 
+static void test_compiled_template_reuses_word_for_repeated_token(void) {
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json",
+               "{\"version\": 1,"
+               " \"templates\": [\"{{ a }} meets {{b}}; {{a}} flees{{\"],"
+               " \"wordlists\": {\"a\": [\"owl\", \"bat\"], \"b\": [\"moon\", \"fog\", \"crow\"]}}");
+
+    FortuneGenerator generator;
+    SequenceRandomSource random;
+    infra::setLogSink(nullptr);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+
+    // Template pick, then one draw per distinct token in order of first use
+    random.values = {0, 1, 2};
+    String fortune = generator.generateFortune();
+    TEST_ASSERT_EQUAL_STRING("bat meets crow; bat flees{{", fortune.c_str());
+    TEST_ASSERT_EQUAL_UINT32(3, random.next);
+}
+
+static void test_large_library_streams_and_interns_words(void) {
+    // Two wordlists sharing most of their words, well past one parser buffer
+    std::string json = "{\"version\": 1, \"notes\": {\"skip\": [1, true, null]},"
+                       " \"templates\": [\"{{omen}} / {{echo}}\"], \"wordlists\": {";
+    for (int list = 0; list < 2; ++list) {
+        json += list ? ", \"echo\": [" : "\"omen\": [";
+        for (int i = 0; i < 2000; ++i) {
+            json += (i ? ", \"" : "\"") + std::string("word-") + std::to_string(i) + "\"";
+        }
+        json += "]";
+    }
+    json += "}}";
+
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json", json);
+    FortuneGenerator generator;
+    SequenceRandomSource random;
+    infra::setLogSink(nullptr);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+    TEST_ASSERT_EQUAL_UINT32(1, generator.templateCount());
+    TEST_ASSERT_EQUAL_UINT32(2, generator.wordlistCount());
+
+    // Template, two names and 4000 words interned; the second list is all duplicates
+    const auto &stats = generator.arenaStats();
+    TEST_ASSERT_EQUAL_UINT32(4003, stats.strings);
+    TEST_ASSERT_EQUAL_UINT32(2003, stats.uniqueStrings);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.indexBytes);
+    // Only the first 8 KB is reserved up front; the rest grows block by block
+    TEST_ASSERT_TRUE(stats.blocks > 1);
+    TEST_ASSERT_TRUE(stats.bytesReserved >= stats.bytesUsed);
+    TEST_ASSERT_TRUE(stats.bytesReserved < json.size());
+
+    random.values = {0, 1999, 7};
+    String fortune = generator.generateFortune();
+    TEST_ASSERT_EQUAL_STRING("word-1999 / word-7", fortune.c_str());
+}
+
+static void test_load_fails_on_malformed_json_and_clears_library(void) {
+    FakeFileSystem fs;
+    fs.addFile("/good.json", loadFixture("fortune_valid.json"));
+    fs.addFile("/bad.json", "{\"version\": 1, \"templates\": [\"{{a}}\"], \"wordlists\": {\"a\": [\"x\",]}}");
+
+    FortuneGenerator generator;
+    FakeRandomSource random;
+    infra::setLogSink(nullptr);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/good.json"));
+    TEST_ASSERT_FALSE(generator.loadFortunes("/bad.json"));
+    TEST_ASSERT_FALSE(generator.isLoaded());
+    TEST_ASSERT_EQUAL_UINT32(0, generator.templateCount());
+    TEST_ASSERT_EQUAL_UINT32(0, generator.arenaStats().bytesReserved);
+}
+
+static void test_nested_rules_expand_with_their_own_tokens(void) {
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json",
+               "{\"version\": 1,"
+               " \"templates\": [\"Beware {{omen}}.\"],"
+               " \"wordlists\": {\"omen\": [\"fog\", \"a {{beast}} at the {{place}}\"],"
+               " \"beast\": [\"crow\", \"{{size}} bat\"], \"size\": [\"tiny\"],"
+               " \"place\": [\"gate\", \"door\"]}}");
+
+    FortuneGenerator generator;
+    SequenceRandomSource random;
+    infra::setLogSink(nullptr);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+    TEST_ASSERT_EQUAL_UINT32(2, generator.ruleCount());
+
+    // Template, omen, then the rule's beast and place, then the nested size
+    random.values = {0, 1, 1, 1, 0};
+    String fortune = generator.generateFortune();
+    TEST_ASSERT_EQUAL_STRING("Beware a tiny bat at the door.", fortune.c_str());
+    TEST_ASSERT_EQUAL_UINT32(5, random.next);
+}
+
+static void test_self_referencing_rule_stops_at_depth_limit(void) {
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json",
+               "{\"version\": 1, \"templates\": [\"<{{loop}}>\"],"
+               " \"wordlists\": {\"loop\": [\"({{loop}})\"]}}");
+
+    FortuneGenerator generator;
+    SequenceRandomSource random;
+    FakeLogSink logSink;
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    generator.setLogSink(&logSink);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+
+    logSink.clear();
+    String fortune = generator.generateFortune();
+    std::string expected = "<" + std::string(FortuneGenerator::MAX_EXPANSION_DEPTH - 1, '(') +
+                           std::string(FortuneGenerator::MAX_EXPANSION_DEPTH - 1, ')') + ">";
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), fortune.c_str());
+    TEST_ASSERT_FALSE(logSink.entries.empty());
+    infra::setLogSink(nullptr);
+}
+
+static void test_output_is_bounded(void) {
+    const std::string word(200, 'w');
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json",
+               "{\"version\": 1, \"templates\": [\"{{w}}{{w}}{{w}}\"],"
+               " \"wordlists\": {\"w\": [\"" + word + "\"]}}");
+
+    FortuneGenerator generator;
+    SequenceRandomSource random;
+    infra::setLogSink(nullptr);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+    String fortune = generator.generateFortune();
+    TEST_ASSERT_EQUAL_UINT32(FortuneGenerator::MAX_FORTUNE_LENGTH, fortune.length());
+}
+
+static void test_weights_steer_choices_and_zero_weight_is_never_picked(void) {
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json",
+               "{\"version\": 1, \"templates\": [\"{{w}}\"],"
+               " \"wordlists\": {\"w\": [{\"text\": \"never\", \"weight\": 0},"
+               " {\"text\": \"rare\", \"weight\": 1}, {\"text\": \"common\", \"weight\": 3, \"note\": [1]}]}}");
+
+    FortuneGenerator generator;
+    SequenceRandomSource random;
+    infra::setLogSink(nullptr);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+
+    // Sweep every column and a spread of coins; count what comes out
+    int rare = 0;
+    int common = 0;
+    for (int column = 0; column < 3; ++column) {
+        for (int coin = 0; coin < 65536; coin += 256) {
+            random.values = {0, column, coin};
+            random.next = 0;
+            const String fortune = generator.generateFortune();
+            TEST_ASSERT_TRUE(fortune != "never");
+            rare += fortune == "rare" ? 1 : 0;
+            common += fortune == "common" ? 1 : 0;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(768, rare + common);
+    TEST_ASSERT_EQUAL_INT(192, rare);
+}
+
+static void test_no_repeat_window_avoids_recent_picks(void) {
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json",
+               "{\"version\": 1, \"no_repeat\": {\"w\": 2, \"templates\": 5},"
+               " \"templates\": [\"{{w}}\"], \"wordlists\": {\"w\": [\"a\", \"b\", \"c\"]}}");
+
+    FortuneGenerator generator;
+    SequenceRandomSource random;
+    infra::setLogSink(nullptr);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+
+    // The random source keeps offering "a"; the window forces a, b, c, a...
+    std::string sequence;
+    for (int i = 0; i < 6; ++i) {
+        random.values = {0, 0, 1, 2};
+        random.next = 0;
+        sequence += generator.generateFortune().c_str();
+    }
+    TEST_ASSERT_EQUAL_STRING("abcabc", sequence.c_str());
+}
+
+static void test_invalid_weight_fails_load(void) {
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json",
+               "{\"version\": 1, \"templates\": [{\"text\": \"{{w}}\", \"weight\": 1.5}],"
+               " \"wordlists\": {\"w\": [\"a\"]}}");
+
+    FortuneGenerator generator;
+    FakeRandomSource random;
+    infra::setLogSink(nullptr);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    TEST_ASSERT_FALSE(generator.loadFortunes("/fortunes.json"));
+    TEST_ASSERT_FALSE(generator.isLoaded());
+}
+
+static void test_long_template_loads_up_to_the_entry_limit(void) {
+    // Longer than the parser's default string limit, inside the generator's
+    const std::string text = std::string(1500, 't') + "{{w}}";
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json",
+               "{\"version\": 1, \"templates\": [\"" + text + "\"], \"wordlists\": {\"w\": [\"a\"]}}");
+
+    FortuneGenerator generator;
+    FakeRandomSource random;
+    infra::setLogSink(nullptr);
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/fortunes.json"));
+    TEST_ASSERT_EQUAL_UINT32(1, generator.templateCount());
+    TEST_ASSERT_EQUAL_UINT32(FortuneGenerator::MAX_FORTUNE_LENGTH, generator.generateFortune().length());
+}
+
+static void test_entry_over_the_limit_fails_load_with_a_clear_error(void) {
+    const std::string text(FortuneGenerator::MAX_ENTRY_LENGTH + 1, 't');
+    FakeFileSystem fs;
+    fs.addFile("/fortunes.json",
+               "{\"version\": 1, \"templates\": [\"" + text + "\"], \"wordlists\": {\"w\": [\"a\"]}}");
+
+    FortuneGenerator generator;
+    FakeRandomSource random;
+    FakeLogSink logSink;
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    generator.setLogSink(&logSink);
+    TEST_ASSERT_FALSE(generator.loadFortunes("/fortunes.json"));
+    TEST_ASSERT_FALSE(generator.isLoaded());
+
+    bool foundError = false;
+    for (const auto &entry : logSink.entries) {
+        if (entry.level == infra::LogLevel::Error &&
+            entry.message.find("longer than 4096 bytes") != std::string::npos) {
+            foundError = true;
+        }
+    }
+    TEST_ASSERT_TRUE_MESSAGE(foundError, "Expected an error naming the entry length limit");
+    infra::setLogSink(nullptr);
+}
+
 int main(int argc, char **argv) {
     UNITY_BEGIN();
     RUN_TEST(test_load_fortunes_from_fake_fs);
     RUN_TEST(test_load_fails_without_version);
     RUN_TEST(test_load_fails_when_wordlist_missing_token);
+    RUN_TEST(test_compiled_template_reuses_word_for_repeated_token);
+    RUN_TEST(test_large_library_streams_and_interns_words);
+    RUN_TEST(test_load_fails_on_malformed_json_and_clears_library);
+    RUN_TEST(test_nested_rules_expand_with_their_own_tokens);
+    RUN_TEST(test_self_referencing_rule_stops_at_depth_limit);
+    RUN_TEST(test_output_is_bounded);
+    RUN_TEST(test_weights_steer_choices_and_zero_weight_is_never_picked);
+    RUN_TEST(test_no_repeat_window_avoids_recent_picks);
+    RUN_TEST(test_invalid_weight_fails_load);
+    RUN_TEST(test_long_template_loads_up_to_the_entry_limit);
+    RUN_TEST(test_entry_over_the_limit_fails_load_with_a_clear_error);
     return UNITY_END();
 }
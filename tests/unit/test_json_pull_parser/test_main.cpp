@@ -0,0 +1,114 @@
+#include <unity.h>
+#include "infra/json_pull_parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+
+using Token = infra::JsonPullParser::Token;
+
+namespace {
+
+// Serves `text` at most `chunk` bytes per read, to exercise buffer refills
+infra::JsonPullParser::Reader readerFor(const std::string &text, size_t chunk = 128) {
+    auto offset = std::make_shared<size_t>(0);
+    return [text, chunk, offset](uint8_t *buffer, size_t length) {
+        const size_t count = std::min({length, chunk, text.size() - *offset});
+        std::memcpy(buffer, text.data() + *offset, count);
+        *offset += count;
+        return count;
+    };
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_tokenizes_nested_document(void) {
+    infra::JsonPullParser parser(readerFor(" {\"a\": [1, -2.5e3, true, false, null], \"b\": {}} "));
+    const Token expected[] = {Token::BeginObject, Token::Key, Token::BeginArray, Token::Number,
+                              Token::Number, Token::True, Token::False, Token::Null, Token::EndArray,
+                              Token::Key, Token::BeginObject, Token::EndObject, Token::EndObject, Token::End};
+    for (Token token : expected) {
+        const Token actual = parser.next();
+        TEST_ASSERT_EQUAL_INT(static_cast<int>(token), static_cast<int>(actual));
+        if (actual == Token::Number && parser.text() != "1") {
+            TEST_ASSERT_EQUAL_STRING("-2.5e3", parser.text().c_str());
+        }
+    }
+    TEST_ASSERT_NULL(parser.error());
+}
+
+static void test_unescapes_strings_to_utf8(void) {
+    infra::JsonPullParser parser(readerFor("[\"a\\\"b\\\\c\\/\\n\", \"\\u00e9\\u20ac\\ud83d\\udc80\"]"));
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::BeginArray), static_cast<int>(parser.next()));
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::String), static_cast<int>(parser.next()));
+    TEST_ASSERT_EQUAL_STRING("a\"b\\c/\n", parser.text().c_str());
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::String), static_cast<int>(parser.next()));
+    TEST_ASSERT_EQUAL_STRING("\xC3\xA9\xE2\x82\xAC\xF0\x9F\x92\x80", parser.text().c_str());
+}
+
+static void test_long_strings_span_small_reads(void) {
+    const std::string word(300, 'x');
+    infra::JsonPullParser parser(readerFor("{\"" + word + "\": \"" + word + "\"}", 7));
+    parser.next();
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::Key), static_cast<int>(parser.next()));
+    TEST_ASSERT_EQUAL_UINT32(word.size(), parser.text().size());
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::String), static_cast<int>(parser.next()));
+    TEST_ASSERT_EQUAL_STRING(word.c_str(), parser.text().c_str());
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::EndObject), static_cast<int>(parser.next()));
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::End), static_cast<int>(parser.next()));
+}
+
+static void test_skip_value_consumes_nested_containers(void) {
+    infra::JsonPullParser parser(readerFor("{\"skip\": {\"x\": [[1], {\"y\": []}]}, \"keep\": 3}"));
+    parser.next();
+    parser.next();
+    TEST_ASSERT_TRUE(parser.skipValue(parser.next()));
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::Key), static_cast<int>(parser.next()));
+    TEST_ASSERT_EQUAL_STRING("keep", parser.text().c_str());
+}
+
+static void test_reports_errors_with_offset(void) {
+    const char *invalid[] = {
+        "{\"a\" 1}", "[1,]", "[1 2]", "{\"a\": tru}", "[\"open", "[\"\\u0000\"]",
+        "[\"\\ud800\"]", "[1]]", "{\"a\": [}", "[\"tab\there\"]",
+    };
+    for (const char *json : invalid) {
+        infra::JsonPullParser parser(readerFor(json));
+        Token token = parser.next();
+        while (token != Token::Error && token != Token::End) {
+            token = parser.next();
+        }
+        TEST_ASSERT_EQUAL_INT_MESSAGE(static_cast<int>(Token::Error), static_cast<int>(token), json);
+        TEST_ASSERT_NOT_NULL(parser.error());
+        // Errors are sticky
+        TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::Error), static_cast<int>(parser.next()));
+    }
+
+    infra::JsonPullParser parser(readerFor("[1, x]"));
+    parser.next();
+    parser.next();
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::Error), static_cast<int>(parser.next()));
+    TEST_ASSERT_EQUAL_UINT32(4, parser.offset());
+}
+
+static void test_rejects_strings_over_limit(void) {
+    infra::JsonPullParser parser(readerFor("[\"abcdef\"]"), 5);
+    parser.next();
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(Token::Error), static_cast<int>(parser.next()));
+    TEST_ASSERT_EQUAL_STRING("string too long", parser.error());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tokenizes_nested_document);
+    RUN_TEST(test_unescapes_strings_to_utf8);
+    RUN_TEST(test_long_strings_span_small_reads);
+    RUN_TEST(test_skip_value_consumes_nested_containers);
+    RUN_TEST(test_reports_errors_with_offset);
+    RUN_TEST(test_rejects_strings_over_limit);
+    return UNITY_END();
+}
@@ -0,0 +1,252 @@
+#include <unity.h>
+
+#include "led_curves.h"
+#include "led_effect_engine.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+using Easing = LedEffectEngine::Easing;
+using Layer = LedEffectEngine::Layer;
+using Timeline = LedEffectEngine::Timeline;
+
+constexpr uint8_t EYE = 0;
+constexpr uint8_t MOUTH = 1;
+
+struct Write {
+    uint8_t channel;
+    uint8_t level;
+};
+
+struct Recorder {
+    std::vector<Write> writes;
+
+    static void write(void *context, uint8_t channel, uint8_t level) {
+        static_cast<Recorder *>(context)->writes.push_back({channel, level});
+    }
+
+    size_t countFor(uint8_t channel) const {
+        size_t count = 0;
+        for (const Write &write : writes) {
+            count += write.channel == channel ? 1 : 0;
+        }
+        return count;
+    }
+};
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_easing_curves_hit_endpoints(void) {
+    const Easing curves[] = {Easing::Linear, Easing::EaseIn, Easing::EaseOut, Easing::EaseInOut, Easing::Sine};
+    for (Easing easing : curves) {
+        TEST_ASSERT_EQUAL_UINT(0, LedEffectEngine::easeQ16(easing, 0));
+        TEST_ASSERT_EQUAL_UINT(led_curves::ONE_Q16, LedEffectEngine::easeQ16(easing, led_curves::ONE_Q16));
+        uint32_t previous = 0;
+        for (uint32_t t = 0; t <= led_curves::ONE_Q16; t += 1024) {
+            const uint32_t eased = LedEffectEngine::easeQ16(easing, t);
+            TEST_ASSERT_TRUE(eased >= previous);
+            previous = eased;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(32768, LedEffectEngine::easeQ16(Easing::Sine, 32768));
+    TEST_ASSERT_EQUAL_UINT(32768, LedEffectEngine::easeQ16(Easing::EaseInOut, 32768));
+    TEST_ASSERT_EQUAL_UINT(16384, LedEffectEngine::easeQ16(Easing::EaseIn, 32768));
+    TEST_ASSERT_EQUAL_UINT(0, LedEffectEngine::easeQ16(Easing::Step, led_curves::ONE_Q16 - 1));
+}
+
+static void test_half_cosine_table_tracks_cosine(void) {
+    for (uint32_t t = 0; t <= led_curves::ONE_Q16; t += 97) {
+        const double x = static_cast<double>(t) / led_curves::ONE_Q16;
+        const double expected = (0.5 - 0.5 * std::cos(3.14159265358979 * x)) * led_curves::ONE_Q16;
+        TEST_ASSERT_TRUE(std::fabs(expected - led_curves::halfCosineQ16(t)) < 16.0);  // < 0.025 % of full scale
+    }
+}
+
+static void test_gamma_duty_is_monotonic_with_fine_low_end(void) {
+    TEST_ASSERT_EQUAL_UINT(0, led_curves::levelToDuty(0, 12));
+    TEST_ASSERT_EQUAL_UINT(4095, led_curves::levelToDuty(255, 12));
+    TEST_ASSERT_EQUAL_UINT(65535, led_curves::levelToDuty(255, 16));
+    TEST_ASSERT_EQUAL_UINT(255, led_curves::levelToDuty(255, 8, false));
+    TEST_ASSERT_EQUAL_UINT(100, led_curves::levelToDuty(100, 8, false));  // Linear matches the old 8-bit output
+
+    // Half brightness by eye is well under half the duty
+    TEST_ASSERT_TRUE(led_curves::levelToDuty(128, 12) < 4095 / 4);
+
+    size_t distinctLow8 = 0;
+    size_t distinctLow12 = 0;
+    uint32_t previous8 = 0;
+    uint32_t previous12 = 0;
+    for (int level = 1; level <= 255; ++level) {
+        const uint32_t duty8 = led_curves::levelToDuty(static_cast<uint8_t>(level), 8);
+        const uint32_t duty12 = led_curves::levelToDuty(static_cast<uint8_t>(level), 12);
+        TEST_ASSERT_TRUE(duty8 >= previous8 && duty12 >= previous12);
+        TEST_ASSERT_TRUE(duty12 > 0);
+        if (level <= 64) {
+            distinctLow8 += duty8 != previous8 ? 1 : 0;
+            distinctLow12 += duty12 != previous12 ? 1 : 0;
+        }
+        previous8 = duty8;
+        previous12 = duty12;
+    }
+    // The dim quarter is where 8 bits steps visibly; 12 bits resolves nearly every level
+    TEST_ASSERT_TRUE(distinctLow8 < 32);
+    TEST_ASSERT_TRUE(distinctLow12 > 56);
+}
+
+static void test_timeline_rejects_out_of_order_and_overflow(void) {
+    Timeline timeline;
+    TEST_ASSERT_TRUE(timeline.add(0, 10));
+    TEST_ASSERT_TRUE(timeline.add(100, 20));
+    TEST_ASSERT_FALSE(timeline.add(50, 30));
+    TEST_ASSERT_EQUAL_UINT(100, timeline.cycleMs());
+    TEST_ASSERT_EQUAL_UINT(100, timeline.durationMs());
+    timeline.setRepeat(LedEffectEngine::REPEAT_FOREVER);
+    TEST_ASSERT_EQUAL_UINT(0, timeline.durationMs());
+
+    for (size_t i = timeline.size(); i < LedEffectEngine::MAX_KEYFRAMES; ++i) {
+        TEST_ASSERT_TRUE(timeline.add(static_cast<uint32_t>(200 + i), 0));
+    }
+    TEST_ASSERT_FALSE(timeline.add(1000, 0));
+
+    // Sets of blinks: last off of each set is stretched to the rest time
+    const Timeline sets = Timeline::blinkSets(3, 120, 120, 800, 2, 255, 0);
+    TEST_ASSERT_EQUAL_UINT(6, sets.size());
+    TEST_ASSERT_EQUAL_UINT(3 * 120 + 2 * 120 + 800, sets.cycleMs());
+    TEST_ASSERT_EQUAL_UINT(2 * (3 * 120 + 2 * 120 + 800), sets.durationMs());
+}
+
+static void test_blink_plays_then_reveals_base_level(void) {
+    Recorder recorder;
+    LedEffectEngine engine(2, &Recorder::write, &recorder);
+    engine.setLevel(EYE, 100);
+    engine.update(0);
+    TEST_ASSERT_EQUAL_UINT(2, recorder.writes.size());  // First update writes every channel
+    TEST_ASSERT_EQUAL_UINT(100, engine.level(EYE));
+
+    TEST_ASSERT_TRUE(engine.play(EYE, Layer::Notify, Timeline::blink(3, 200, 200, 255, 0), 1000));
+    engine.update(999);
+    TEST_ASSERT_EQUAL_UINT(100, engine.level(EYE));  // Not started yet
+    TEST_ASSERT_TRUE(engine.isActive(EYE, Layer::Notify));
+
+    const uint32_t probes[] = {1000, 1199, 1200, 1399, 1400, 1600, 1800, 2199};
+    const uint8_t expected[] = {255, 255, 0, 0, 255, 0, 255, 0};
+    for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); ++i) {
+        engine.update(probes[i]);
+        TEST_ASSERT_EQUAL_UINT(expected[i], engine.level(EYE));
+    }
+    engine.update(2200);
+    TEST_ASSERT_FALSE(engine.isActive(EYE, Layer::Notify));
+    TEST_ASSERT_EQUAL_UINT(100, engine.level(EYE));
+
+    // Writes happen only on change: the first update, six blink edges, the return to base
+    TEST_ASSERT_EQUAL_UINT(1 + 6 + 1, recorder.countFor(EYE));
+    TEST_ASSERT_EQUAL_UINT(1, recorder.countFor(MOUTH));
+}
+
+static void test_higher_layer_covers_lower_until_it_ends(void) {
+    Recorder recorder;
+    LedEffectEngine engine(2, &Recorder::write, &recorder);
+    engine.setLevel(MOUTH, 0);
+    engine.play(MOUTH, Layer::Ambient, Timeline::pulse(40, 240, 1000), 0);
+    engine.play(MOUTH, Layer::Alert, Timeline::blinkSets(2, 100, 100, 500, 1, 255, 10), 0);
+
+    engine.update(50);
+    TEST_ASSERT_EQUAL_UINT(255, engine.level(MOUTH));
+    engine.update(150);
+    TEST_ASSERT_EQUAL_UINT(10, engine.level(MOUTH));
+    engine.update(799);
+    TEST_ASSERT_EQUAL_UINT(10, engine.level(MOUTH));  // Rest at the off level
+
+    // The alert ends at 800 and the pulse shows through at its own phase
+    engine.update(1000 + 500);
+    TEST_ASSERT_FALSE(engine.isActive(MOUTH, Layer::Alert));
+    TEST_ASSERT_TRUE(engine.isActive(MOUTH, Layer::Ambient));
+    TEST_ASSERT_EQUAL_UINT(240, engine.level(MOUTH));
+
+    engine.stop(MOUTH, Layer::Ambient);
+    engine.update(1600);
+    TEST_ASSERT_EQUAL_UINT(0, engine.level(MOUTH));
+}
+
+static void test_covered_finite_layer_still_expires(void) {
+    LedEffectEngine engine(1, nullptr, nullptr);
+    engine.play(EYE, Layer::Alert, Timeline::blinkSets(1, 100, 100, 100, LedEffectEngine::REPEAT_FOREVER, 255, 0), 0);
+    engine.play(EYE, Layer::Notify, Timeline::blink(2, 50, 50, 200, 0), 0);
+    engine.update(100);
+    engine.update(250);
+    TEST_ASSERT_FALSE(engine.isActive(EYE, Layer::Notify));
+    TEST_ASSERT_TRUE(engine.isActive(EYE, Layer::Alert));
+}
+
+static void test_pulse_follows_sine_and_survives_sparse_updates(void) {
+    LedEffectEngine engine(1, nullptr, nullptr);
+    engine.play(EYE, Layer::Ambient, Timeline::pulse(0, 200, 1000), 0);
+
+    engine.update(0);
+    TEST_ASSERT_EQUAL_UINT(0, engine.level(EYE));
+    engine.update(250);
+    TEST_ASSERT_EQUAL_UINT(100, engine.level(EYE));
+    engine.update(500);
+    TEST_ASSERT_EQUAL_UINT(200, engine.level(EYE));
+    engine.update(750);
+    TEST_ASSERT_EQUAL_UINT(100, engine.level(EYE));
+
+    // Jumping several cycles ahead lands on the same phase
+    engine.update(7250);
+    TEST_ASSERT_EQUAL_UINT(100, engine.level(EYE));
+    engine.update(7500);
+    TEST_ASSERT_EQUAL_UINT(200, engine.level(EYE));
+    engine.update(8100);
+    TEST_ASSERT_INT_WITHIN(1, 19, engine.level(EYE));  // 200 * (1 - cos(0.2 pi)) / 2
+}
+
+static void test_custom_keyframes_ease_between_levels(void) {
+    Timeline fade;
+    fade.add(0, 0);
+    fade.add(100, 200, Easing::Linear);
+    fade.add(200, 200);
+    fade.add(300, 0, Easing::EaseIn);
+    LedEffectEngine engine(1, nullptr, nullptr);
+    engine.setLevel(EYE, 42);
+    engine.play(EYE, Layer::Notify, fade, 10);
+
+    engine.update(60);
+    TEST_ASSERT_EQUAL_UINT(100, engine.level(EYE));
+    engine.update(160);
+    TEST_ASSERT_EQUAL_UINT(200, engine.level(EYE));
+    engine.update(260);
+    TEST_ASSERT_EQUAL_UINT(150, engine.level(EYE));  // 200 - 200 * 0.5^2
+    engine.update(310);
+    TEST_ASSERT_EQUAL_UINT(42, engine.level(EYE));
+}
+
+static void test_rejects_bad_channels_and_layers(void) {
+    LedEffectEngine engine(2, nullptr, nullptr);
+    const Timeline blink = Timeline::blink(1, 10, 10, 255, 0);
+    TEST_ASSERT_FALSE(engine.play(2, Layer::Notify, blink, 0));
+    TEST_ASSERT_FALSE(engine.play(EYE, Layer::Base, blink, 0));
+    TEST_ASSERT_FALSE(engine.play(EYE, Layer::Notify, Timeline(), 0));
+    engine.setLevel(7, 99);
+    TEST_ASSERT_EQUAL_UINT(0, engine.baseLevel(7));
+    TEST_ASSERT_FALSE(engine.isActive(7, Layer::Alert));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_easing_curves_hit_endpoints);
+    RUN_TEST(test_half_cosine_table_tracks_cosine);
+    RUN_TEST(test_gamma_duty_is_monotonic_with_fine_low_end);
+    RUN_TEST(test_timeline_rejects_out_of_order_and_overflow);
+    RUN_TEST(test_blink_plays_then_reveals_base_level);
+    RUN_TEST(test_higher_layer_covers_lower_until_it_ends);
+    RUN_TEST(test_covered_finite_layer_still_expires);
+    RUN_TEST(test_pulse_follows_sine_and_survives_sparse_updates);
+    RUN_TEST(test_custom_keyframes_ease_between_levels);
+    RUN_TEST(test_rejects_bad_channels_and_layers);
+    return UNITY_END();
+}
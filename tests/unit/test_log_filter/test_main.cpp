@@ -0,0 +1,220 @@
+#include <unity.h>
+
+#include "infra/log_sink.h"
+#include "infra/log_tag_table.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct CapturedLog {
+    infra::LogLevel level;
+    std::string tag;
+    std::string message;
+};
+
+class CaptureSink : public infra::ILogSink {
+public:
+    void log(infra::LogLevel level, const char *tag, const char *message) override {
+        entries.push_back({level, tag, message});
+    }
+
+    std::vector<CapturedLog> entries;
+};
+
+CaptureSink g_sink;
+int g_evaluations = 0;
+
+int countEvaluation() {
+    return ++g_evaluations;
+}
+
+const char kChattyTag[] = "Chatty";
+const char kQuietTag[] = "Quiet";
+
+std::vector<std::string> runCommand(const char *args, bool *ok = nullptr) {
+    std::vector<std::string> lines;
+    const bool result = infra::runLogLevelCommand(args, [&lines](const char *line) {
+        lines.emplace_back(line);
+    });
+    if (ok) {
+        *ok = result;
+    }
+    return lines;
+}
+
+}  // namespace
+
+void setUp(void) {
+    infra::logTags().clearLevels();
+    infra::setLogLevel(infra::LogLevel::Verbose);
+    infra::logTags().idFor(kChattyTag);
+    infra::logTags().idFor(kQuietTag);
+    g_sink.entries.clear();
+    g_evaluations = 0;
+    infra::setLogSink(&g_sink);
+}
+
+void tearDown(void) {
+    infra::setLogSink(nullptr);
+}
+
+static void test_default_level_passes_everything(void) {
+    INFRA_LOG(infra::LogLevel::Verbose, kChattyTag, "v %d", 1);
+    INFRA_LOG(infra::LogLevel::Error, kChattyTag, "e %d", 2);
+
+    TEST_ASSERT_EQUAL(2, g_sink.entries.size());
+    TEST_ASSERT_EQUAL_STRING("v 1", g_sink.entries[0].message.c_str());
+    TEST_ASSERT_EQUAL_STRING("Chatty", g_sink.entries[1].tag.c_str());
+}
+
+static void test_filtered_call_does_not_evaluate_arguments(void) {
+    infra::setLogLevel(infra::LogLevel::Warn);
+
+    INFRA_LOG(infra::LogLevel::Info, kChattyTag, "value %d", countEvaluation());
+    TEST_ASSERT_EQUAL(0, g_evaluations);
+    TEST_ASSERT_EQUAL(0, g_sink.entries.size());
+
+    INFRA_LOG(infra::LogLevel::Warn, kChattyTag, "value %d", countEvaluation());
+    TEST_ASSERT_EQUAL(1, g_evaluations);
+    TEST_ASSERT_EQUAL(1, g_sink.entries.size());
+}
+
+static void test_tag_override_below_default(void) {
+    infra::setLogLevel(infra::LogLevel::Warn);
+    TEST_ASSERT_TRUE(infra::setTagLogLevel(kChattyTag, infra::LogLevel::Debug));
+
+    INFRA_LOG(infra::LogLevel::Debug, kChattyTag, "chatty debug");
+    INFRA_LOG(infra::LogLevel::Verbose, kChattyTag, "chatty verbose");
+    INFRA_LOG(infra::LogLevel::Info, kQuietTag, "quiet info");
+    INFRA_LOG(infra::LogLevel::Warn, kQuietTag, "quiet warn");
+
+    TEST_ASSERT_EQUAL(2, g_sink.entries.size());
+    TEST_ASSERT_EQUAL_STRING("chatty debug", g_sink.entries[0].message.c_str());
+    TEST_ASSERT_EQUAL_STRING("quiet warn", g_sink.entries[1].message.c_str());
+}
+
+static void test_tag_off_and_back_to_default(void) {
+    TEST_ASSERT_TRUE(infra::setTagLogLevel(kChattyTag, infra::LogLevel::Off));
+    INFRA_LOG(infra::LogLevel::Error, kChattyTag, "silenced");
+    INFRA_LOG(infra::LogLevel::Verbose, kQuietTag, "still on");
+    TEST_ASSERT_EQUAL(1, g_sink.entries.size());
+
+    TEST_ASSERT_TRUE(infra::clearTagLogLevel(kChattyTag));
+    TEST_ASSERT_FALSE(infra::logTags().hasOverrides());
+    INFRA_LOG(infra::LogLevel::Verbose, kChattyTag, "back");
+    TEST_ASSERT_EQUAL(2, g_sink.entries.size());
+}
+
+static void test_tags_match_ignoring_case(void) {
+    TEST_ASSERT_TRUE(infra::setTagLogLevel("chatty", infra::LogLevel::Error));
+    TEST_ASSERT_FALSE(infra::logEnabled(infra::LogLevel::Warn, kChattyTag));
+    TEST_ASSERT_TRUE(infra::logEnabled(infra::LogLevel::Error, kChattyTag));
+    TEST_ASSERT_FALSE(infra::setTagLogLevel("NeverLogged", infra::LogLevel::Error));
+}
+
+static void test_emit_log_is_filtered_too(void) {
+    infra::setLogLevel(infra::LogLevel::Info);
+    infra::emitLog(infra::LogLevel::Debug, kQuietTag, "dropped");
+    infra::emitLog(infra::LogLevel::Info, kQuietTag, "kept");
+    infra::writeLog(infra::LogLevel::Debug, kQuietTag, "unfiltered");
+
+    TEST_ASSERT_EQUAL(2, g_sink.entries.size());
+    TEST_ASSERT_EQUAL_STRING("kept", g_sink.entries[0].message.c_str());
+    TEST_ASSERT_EQUAL_STRING("unfiltered", g_sink.entries[1].message.c_str());
+}
+
+static void test_site_cache_follows_changing_tag(void) {
+    infra::setLogLevel(infra::LogLevel::Error);
+    TEST_ASSERT_TRUE(infra::setTagLogLevel(kChattyTag, infra::LogLevel::Verbose));
+
+    const char *tags[] = {kChattyTag, kQuietTag, kChattyTag, kQuietTag};
+    for (const char *tag : tags) {
+        INFRA_LOG(infra::LogLevel::Info, tag, "%s", tag);
+    }
+
+    TEST_ASSERT_EQUAL(2, g_sink.entries.size());
+    TEST_ASSERT_EQUAL_STRING("Chatty", g_sink.entries[0].message.c_str());
+    TEST_ASSERT_EQUAL_STRING("Chatty", g_sink.entries[1].message.c_str());
+}
+
+static void test_floor_tracks_lowest_override(void) {
+    infra::LogTagTable &tags = infra::logTags();
+    infra::setLogLevel(infra::LogLevel::Error);
+    TEST_ASSERT_FALSE(tags.passesFloor(static_cast<uint8_t>(infra::LogLevel::Warn)));
+
+    infra::setTagLogLevel(kQuietTag, infra::LogLevel::Debug);
+    TEST_ASSERT_TRUE(tags.passesFloor(static_cast<uint8_t>(infra::LogLevel::Debug)));
+    TEST_ASSERT_FALSE(tags.passesFloor(static_cast<uint8_t>(infra::LogLevel::Verbose)));
+
+    infra::clearTagLogLevel(kQuietTag);
+    TEST_ASSERT_FALSE(tags.passesFloor(static_cast<uint8_t>(infra::LogLevel::Warn)));
+}
+
+static void test_parse_level_names_and_letters(void) {
+    infra::LogLevel level = infra::LogLevel::Verbose;
+    TEST_ASSERT_TRUE(infra::parseLogLevel("WARN", level));
+    TEST_ASSERT_EQUAL(static_cast<int>(infra::LogLevel::Warn), static_cast<int>(level));
+    TEST_ASSERT_TRUE(infra::parseLogLevel("d", level));
+    TEST_ASSERT_EQUAL(static_cast<int>(infra::LogLevel::Debug), static_cast<int>(level));
+    TEST_ASSERT_TRUE(infra::parseLogLevel("off", level));
+    TEST_ASSERT_EQUAL(static_cast<int>(infra::LogLevel::Off), static_cast<int>(level));
+    TEST_ASSERT_FALSE(infra::parseLogLevel("loud", level));
+    TEST_ASSERT_FALSE(infra::parseLogLevel("", level));
+    TEST_ASSERT_EQUAL_STRING("error", infra::logLevelName(infra::LogLevel::Error));
+}
+
+static void test_command_sets_and_reports(void) {
+    bool ok = false;
+    std::vector<std::string> lines = runCommand("info", &ok);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL(static_cast<int>(infra::LogLevel::Info), static_cast<int>(infra::logLevel()));
+
+    lines = runCommand("chatty verbose", &ok);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL_STRING("chatty log level set to verbose", lines[0].c_str());
+
+    lines = runCommand("");
+    TEST_ASSERT_EQUAL(2, lines.size());
+    TEST_ASSERT_EQUAL_STRING("Log level: info (compiled minimum verbose)", lines[0].c_str());
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, lines[1].find("Chatty"));
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, lines[1].find("verbose"));
+
+    lines = runCommand("chatty default", &ok);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL(1, runCommand("").size());
+
+    lines = runCommand("nosuchtag warn");
+    TEST_ASSERT_EQUAL_STRING("Unknown log tag: nosuchtag", lines[0].c_str());
+
+    runCommand("reset");
+    TEST_ASSERT_EQUAL(static_cast<int>(infra::LogLevel::Verbose), static_cast<int>(infra::logLevel()));
+}
+
+static void test_command_rejects_bad_arguments(void) {
+    bool ok = true;
+    std::vector<std::string> lines = runCommand("loud", &ok);
+    TEST_ASSERT_FALSE(ok);
+    TEST_ASSERT_EQUAL(0, lines[0].find("Usage: loglevel"));
+
+    runCommand("chatty warn extra", &ok);
+    TEST_ASSERT_FALSE(ok);
+    TEST_ASSERT_EQUAL(static_cast<int>(infra::LogLevel::Verbose), static_cast<int>(infra::logLevel()));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_level_passes_everything);
+    RUN_TEST(test_filtered_call_does_not_evaluate_arguments);
+    RUN_TEST(test_tag_override_below_default);
+    RUN_TEST(test_tag_off_and_back_to_default);
+    RUN_TEST(test_tags_match_ignoring_case);
+    RUN_TEST(test_emit_log_is_filtered_too);
+    RUN_TEST(test_site_cache_follows_changing_tag);
+    RUN_TEST(test_floor_tracks_lowest_override);
+    RUN_TEST(test_parse_level_names_and_letters);
+    RUN_TEST(test_command_sets_and_reports);
+    RUN_TEST(test_command_rejects_bad_arguments);
+    return UNITY_END();
+}
@@ -0,0 +1,338 @@
+#include <unity.h>
+
+#include "infra/log_record.h"
+#include "infra/log_record_ring.h"
+#include "infra/log_tag_table.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using infra::LogRecordRing;
+
+struct Packed {
+    uint8_t bytes[infra::LOG_RECORD_MAX_ARG_BYTES];
+    size_t size = 0;
+    bool truncated = false;
+};
+
+Packed packInto(size_t capacity, const char *format, va_list args) {
+    Packed packed;
+    packed.size = infra::packLogArgs(format, args, packed.bytes, capacity, &packed.truncated);
+    return packed;
+}
+
+Packed pack(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    const Packed packed = packInto(infra::LOG_RECORD_MAX_ARG_BYTES, format, args);
+    va_end(args);
+    return packed;
+}
+
+Packed packSmall(size_t capacity, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    const Packed packed = packInto(capacity, format, args);
+    va_end(args);
+    return packed;
+}
+
+std::string render(const char *format, const Packed &packed) {
+    char text[256];
+    infra::formatLogArgs(format, packed.bytes, packed.size, text, sizeof(text));
+    return text;
+}
+
+std::string expected(const char *format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    return text;
+}
+
+const char *const COUNTER_FORMAT = "writer=%d count=%u check=%u";
+
+bool appendCounter(LogRecordRing &ring, int writer, unsigned count) {
+    const unsigned check = static_cast<unsigned>(writer) * 100003u + count;
+    const Packed packed = pack(COUNTER_FORMAT, writer, count, check);
+    return ring.append(2, 0, count, COUNTER_FORMAT, packed.bytes, packed.size, 0);
+}
+
+// Decodes a counter record; false if it is not one or its fields disagree
+bool readCounter(const LogRecordRing::Record &record, int &writer, unsigned &count) {
+    if (record.header.format != COUNTER_FORMAT) {
+        return false;
+    }
+    char text[96];
+    infra::formatLogArgs(record.header.format, record.args, record.header.argBytes, text, sizeof(text));
+    unsigned check = 0;
+    if (sscanf(text, "writer=%d count=%u check=%u", &writer, &count, &check) != 3) {
+        return false;
+    }
+    return check == static_cast<unsigned>(writer) * 100003u + count;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_packed_args_format_like_printf(void) {
+    const char *format = "%d|%5u|%-4x|%08.3f|%c|%lld|%zu|%s|%.2s|%%|%ld";
+    const Packed packed = pack(format, -42, 7u, 0xabu, 3.14159, 'Z', -1234567890123LL, static_cast<size_t>(99), "skull",
+                               "jaw", 123456L);
+    TEST_ASSERT_FALSE(packed.truncated);
+    TEST_ASSERT_EQUAL_STRING(expected(format, -42, 7u, 0xabu, 3.14159, 'Z', -1234567890123LL, static_cast<size_t>(99),
+                                      "skull", "jaw", 123456L)
+                                 .c_str(),
+                             render(format, packed).c_str());
+}
+
+static void test_star_width_and_precision(void) {
+    const char *format = "[%*d] [%-*s] [%.*f]";
+    const Packed packed = pack(format, 6, 42, 5, "ab", 1, 2.75);
+    TEST_ASSERT_EQUAL_STRING(expected(format, 6, 42, 5, "ab", 1, 2.75).c_str(), render(format, packed).c_str());
+}
+
+static void test_short_and_char_lengths_narrow_like_printf(void) {
+    const char *format = "%hu|%hd|%hhx|%hhd|%hhu|%5hu";
+    const Packed packed = pack(format, 70000, 40000, 0x1ff, 200, -1, 65535);
+    TEST_ASSERT_FALSE(packed.truncated);
+    TEST_ASSERT_EQUAL_STRING(expected(format, 70000, 40000, 0x1ff, 200, -1, 65535).c_str(),
+                             render(format, packed).c_str());
+    TEST_ASSERT_EQUAL_STRING("4464|-25536|ff|-56|255|65535", render(format, packed).c_str());
+}
+
+static void test_strings_are_copied_at_log_time(void) {
+    char name[16];
+    strcpy(name, "raven");
+    const Packed packed = pack("bird=%s", name);
+    strcpy(name, "crow");
+    TEST_ASSERT_EQUAL_STRING("bird=raven", render("bird=%s", packed).c_str());
+
+    const Packed null = pack("%s", static_cast<const char *>(nullptr));
+    TEST_ASSERT_EQUAL_STRING("(null)", render("%s", null).c_str());
+}
+
+static void test_oversized_arguments_are_truncated(void) {
+    const std::string longText(300, 'x');
+    const Packed packed = pack("%s!", longText.c_str());
+    TEST_ASSERT_TRUE(packed.truncated);
+    TEST_ASSERT_EQUAL_size_t(infra::LOG_RECORD_MAX_STRING + 1, render("%s!", packed).size());
+
+    // Far more integers than fit: the tail renders as '?'
+    std::string format;
+    for (int i = 0; i < 40; ++i) {
+        format += "%d ";
+    }
+    const Packed many = packSmall(24, format.c_str(), 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+                                  20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40);
+    TEST_ASSERT_TRUE(many.truncated);
+    TEST_ASSERT_EQUAL_size_t(24, many.size);
+    TEST_ASSERT_EQUAL_STRING("1 2 3 ? ? ", render(format.c_str(), many).substr(0, 10).c_str());
+}
+
+static void test_tag_table_interns_by_pointer_and_name(void) {
+    infra::LogTagTable tags;
+    static const char *const AUDIO = "Audio";
+    const std::string copy = "Audio";
+    const uint8_t id = tags.idFor(AUDIO);
+    TEST_ASSERT_EQUAL_UINT8(id, tags.idFor(AUDIO));
+    TEST_ASSERT_EQUAL_UINT8(id, tags.idFor(copy.c_str()));
+    TEST_ASSERT_EQUAL_STRING("Audio", tags.name(id));
+    TEST_ASSERT_EQUAL_UINT8(infra::LogTagTable::NO_TAG, tags.find("Servo"));
+    TEST_ASSERT_EQUAL_UINT8(infra::LogTagTable::NO_TAG, tags.idFor(""));
+    TEST_ASSERT_EQUAL_STRING("?", tags.name(infra::LogTagTable::NO_TAG));
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < infra::LogTagTable::MAX_TAGS + 4; ++i) {
+        names.push_back("tag" + std::to_string(i));
+    }
+    for (const std::string &name : names) {
+        tags.idFor(name.c_str());
+    }
+    TEST_ASSERT_EQUAL_size_t(infra::LogTagTable::MAX_TAGS, tags.size());
+    TEST_ASSERT_EQUAL_UINT8(infra::LogTagTable::NO_TAG, tags.idFor("one-too-many"));
+}
+
+static void test_ring_delivers_records_to_independent_cursors(void) {
+    LogRecordRing ring;
+    TEST_ASSERT_TRUE(ring.begin(2048));
+    LogRecordRing::Cursor early = ring.newest();
+    for (unsigned i = 0; i < 5; ++i) {
+        TEST_ASSERT_TRUE(appendCounter(ring, 1, i));
+    }
+    LogRecordRing::Cursor late = ring.newest();
+    TEST_ASSERT_TRUE(appendCounter(ring, 1, 5));
+
+    LogRecordRing::Record record;
+    int writer = 0;
+    unsigned count = 0;
+    for (unsigned i = 0; i < 6; ++i) {
+        TEST_ASSERT_TRUE(ring.read(early, record));
+        TEST_ASSERT_TRUE(readCounter(record, writer, count));
+        TEST_ASSERT_EQUAL_UINT32(i, count);
+        TEST_ASSERT_EQUAL_UINT32(i + 1, record.header.sequence);
+    }
+    TEST_ASSERT_FALSE(ring.read(early, record));
+
+    TEST_ASSERT_TRUE(ring.read(late, record));
+    TEST_ASSERT_TRUE(readCounter(record, writer, count));
+    TEST_ASSERT_EQUAL_UINT32(5, count);
+    TEST_ASSERT_FALSE(ring.read(late, record));
+    TEST_ASSERT_EQUAL_UINT32(0, early.lostBytes);
+}
+
+static void test_ring_wraps_with_padding_for_a_keeping_up_reader(void) {
+    LogRecordRing ring;
+    TEST_ASSERT_TRUE(ring.begin(1024));
+    LogRecordRing::Cursor cursor = ring.newest();
+    LogRecordRing::Record record;
+    int writer = 0;
+    unsigned count = 0;
+    for (unsigned i = 0; i < 500; ++i) {
+        TEST_ASSERT_TRUE(appendCounter(ring, 2, i));
+        if (i % 3 == 2) {
+            for (unsigned expect = i - 2; expect <= i; ++expect) {
+                TEST_ASSERT_TRUE(ring.read(cursor, record));
+                TEST_ASSERT_TRUE(readCounter(record, writer, count));
+                TEST_ASSERT_EQUAL_UINT32(expect, count);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, cursor.lostBytes);
+    TEST_ASSERT_EQUAL_size_t(1024, ring.used());
+}
+
+static void test_lapped_reader_skips_to_oldest_intact_record(void) {
+    LogRecordRing ring;
+    TEST_ASSERT_TRUE(ring.begin(1024));
+    LogRecordRing::Cursor cursor = ring.newest();
+    for (unsigned i = 0; i < 200; ++i) {
+        TEST_ASSERT_TRUE(appendCounter(ring, 3, i));
+    }
+
+    LogRecordRing::Record record;
+    int writer = 0;
+    unsigned count = 0;
+    unsigned previous = 0;
+    unsigned reads = 0;
+    while (ring.read(cursor, record)) {
+        TEST_ASSERT_TRUE(readCounter(record, writer, count));
+        if (reads > 0) {
+            TEST_ASSERT_EQUAL_UINT32(previous + 1, count);
+        }
+        previous = count;
+        ++reads;
+    }
+    TEST_ASSERT_TRUE(cursor.lostBytes > 0);
+    TEST_ASSERT_EQUAL_UINT32(199, previous);
+    // Nearly a whole buffer of history survives the lap
+    TEST_ASSERT_TRUE(reads * 64 > 1024 - 128);
+
+    LogRecordRing::Cursor fresh = ring.oldest();
+    unsigned freshReads = 0;
+    while (ring.read(fresh, record)) {
+        ++freshReads;
+    }
+    TEST_ASSERT_EQUAL_UINT32(reads, freshReads);
+}
+
+static void test_keep_oldest_ring_stops_when_full(void) {
+    LogRecordRing ring;
+    TEST_ASSERT_TRUE(ring.begin(1024, LogRecordRing::Policy::KeepOldest));
+    unsigned accepted = 0;
+    for (unsigned i = 0; i < 100; ++i) {
+        accepted += appendCounter(ring, 4, i) ? 1 : 0;
+    }
+    TEST_ASSERT_TRUE(accepted > 0 && accepted < 100);
+    TEST_ASSERT_EQUAL_UINT32(100 - accepted, ring.dropped());
+
+    LogRecordRing::Cursor cursor = ring.oldest();
+    LogRecordRing::Record record;
+    int writer = 0;
+    unsigned count = 0;
+    for (unsigned i = 0; i < accepted; ++i) {
+        TEST_ASSERT_TRUE(ring.read(cursor, record));
+        TEST_ASSERT_TRUE(readCounter(record, writer, count));
+        TEST_ASSERT_EQUAL_UINT32(i, count);
+    }
+    TEST_ASSERT_FALSE(ring.read(cursor, record));
+}
+
+static void test_concurrent_writers_never_yield_torn_records(void) {
+    LogRecordRing ring;
+    TEST_ASSERT_TRUE(ring.begin(4096));
+    constexpr int WRITERS = 4;
+    constexpr unsigned PER_WRITER = 20000;
+    std::atomic<int> finished{0};
+    std::vector<std::thread> threads;
+    for (int w = 0; w < WRITERS; ++w) {
+        threads.emplace_back([&ring, &finished, w]() {
+            for (unsigned i = 0; i < PER_WRITER; ++i) {
+                appendCounter(ring, w, i);
+            }
+            finished.fetch_add(1);
+        });
+    }
+
+    LogRecordRing::Cursor cursor = ring.newest();
+    LogRecordRing::Record record;
+    unsigned last[WRITERS] = {};
+    bool seen[WRITERS] = {};
+    unsigned reads = 0;
+    unsigned bad = 0;
+    unsigned reordered = 0;
+    for (;;) {
+        const bool done = finished.load() == WRITERS;
+        if (!ring.read(cursor, record)) {
+            if (done) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        int writer = -1;
+        unsigned count = 0;
+        if (!readCounter(record, writer, count) || writer < 0 || writer >= WRITERS) {
+            ++bad;
+            continue;
+        }
+        reordered += (seen[writer] && count <= last[writer]) ? 1 : 0;
+        seen[writer] = true;
+        last[writer] = count;
+        ++reads;
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, bad);
+    TEST_ASSERT_EQUAL_UINT32(0, reordered);
+    TEST_ASSERT_TRUE(reads > 0);
+    TEST_ASSERT_EQUAL_UINT32(WRITERS * PER_WRITER, ring.appended());
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_packed_args_format_like_printf);
+    RUN_TEST(test_star_width_and_precision);
+    RUN_TEST(test_short_and_char_lengths_narrow_like_printf);
+    RUN_TEST(test_strings_are_copied_at_log_time);
+    RUN_TEST(test_oversized_arguments_are_truncated);
+    RUN_TEST(test_tag_table_interns_by_pointer_and_name);
+    RUN_TEST(test_ring_delivers_records_to_independent_cursors);
+    RUN_TEST(test_ring_wraps_with_padding_for_a_keeping_up_reader);
+    RUN_TEST(test_lapped_reader_skips_to_oldest_intact_record);
+    RUN_TEST(test_keep_oldest_ring_stops_when_full);
+    RUN_TEST(test_concurrent_writers_never_yield_torn_records);
+    return UNITY_END();
+}
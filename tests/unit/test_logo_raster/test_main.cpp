@@ -0,0 +1,306 @@
+#include <unity.h>
+
+#include "escpos_stream.h"
+#include "logo_raster.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+void putLE16(std::vector<uint8_t> &out, size_t at, uint16_t value) {
+    out[at] = static_cast<uint8_t>(value & 0xFF);
+    out[at + 1] = static_cast<uint8_t>(value >> 8);
+}
+
+void putLE32(std::vector<uint8_t> &out, size_t at, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[at + i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+// Builds an uncompressed BMP. `pixels` are top-down, one value per pixel:
+// palette indices for <= 8 bpp, 0xRRGGBB for 24 bpp. Positive height is
+// stored bottom-up like most encoders write it.
+std::vector<uint8_t> makeBmp(int32_t width,
+                             int32_t height,
+                             uint16_t bpp,
+                             const std::vector<uint32_t> &palette,
+                             const std::vector<uint32_t> &pixels) {
+    const uint32_t absHeight = height < 0 ? -height : height;
+    const uint32_t stride = ((width * bpp + 31) / 32) * 4;
+    const uint32_t dataOffset = 14 + 40 + static_cast<uint32_t>(palette.size()) * 4;
+    std::vector<uint8_t> bmp(dataOffset + stride * absHeight, 0);
+
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    putLE32(bmp, 2, static_cast<uint32_t>(bmp.size()));
+    putLE32(bmp, 10, dataOffset);
+    putLE32(bmp, 14, 40);
+    putLE32(bmp, 18, static_cast<uint32_t>(width));
+    putLE32(bmp, 22, static_cast<uint32_t>(height));
+    putLE16(bmp, 26, 1);
+    putLE16(bmp, 28, bpp);
+    putLE32(bmp, 46, static_cast<uint32_t>(palette.size()));
+    for (size_t i = 0; i < palette.size(); ++i) {
+        putLE32(bmp, 54 + i * 4, palette[i]);  // 0x00RRGGBB is BGRA in memory
+    }
+
+    for (uint32_t y = 0; y < absHeight; ++y) {
+        const uint32_t stored = height > 0 ? absHeight - 1 - y : y;
+        uint8_t *row = bmp.data() + dataOffset + stored * stride;
+        for (int32_t x = 0; x < width; ++x) {
+            const uint32_t value = pixels[y * width + x];
+            switch (bpp) {
+                case 1:
+                    row[x / 8] |= static_cast<uint8_t>((value & 1) << (7 - (x % 8)));
+                    break;
+                case 8:
+                    row[x] = static_cast<uint8_t>(value);
+                    break;
+                case 24:
+                    row[x * 3] = static_cast<uint8_t>(value & 0xFF);
+                    row[x * 3 + 1] = static_cast<uint8_t>((value >> 8) & 0xFF);
+                    row[x * 3 + 2] = static_cast<uint8_t>((value >> 16) & 0xFF);
+                    break;
+            }
+        }
+    }
+    return bmp;
+}
+
+std::vector<uint32_t> grayPalette() {
+    std::vector<uint32_t> palette(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+        palette[i] = (i << 16) | (i << 8) | i;
+    }
+    return palette;
+}
+
+BmpGraySource::ReadAt readFrom(const std::vector<uint8_t> &data) {
+    return [&data](uint32_t offset, uint8_t *out, size_t length) -> size_t {
+        if (offset >= data.size()) {
+            return 0;
+        }
+        const size_t count = std::min(length, data.size() - offset);
+        std::memcpy(out, data.data() + offset, count);
+        return count;
+    };
+}
+
+bool rasterizeBmp(const std::vector<uint8_t> &bmp,
+                  const LogoRasterizer::Options &options,
+                  std::vector<uint8_t> &out) {
+    BmpGraySource source(readFrom(bmp));
+    if (!source.open()) {
+        return false;
+    }
+    LogoRasterizer rasterizer(options);
+    return rasterizer.rasterize(source, out);
+}
+
+LogoRasterizer::Options smallOptions(uint16_t width, LogoRasterizer::Dither dither) {
+    LogoRasterizer::Options options;
+    options.maxWidthDots = width;
+    options.dither = dither;
+    return options;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_one_bit_bmp_matches_legacy_raster(void) {
+    // Index 0 = black, 1 = white; 10x2 with a partial last byte
+    const std::vector<uint32_t> pixels = {
+        0, 1, 0, 1, 0, 1, 0, 1, 0, 0,
+        1, 1, 1, 1, 0, 0, 0, 0, 1, 0,
+    };
+    const auto bmp = makeBmp(10, 2, 1, {0x000000, 0xFFFFFF}, pixels);
+
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(rasterizeBmp(bmp, smallOptions(16, LogoRasterizer::Dither::FloydSteinberg), out));
+    const uint8_t golden[] = {0x1D, 'v', '0', 0, 2, 0, 2, 0,
+                              0xAA, 0xC0,
+                              0x0F, 0x40};
+    TEST_ASSERT_EQUAL_UINT32(sizeof(golden), out.size());
+    TEST_ASSERT_EQUAL_MEMORY(golden, out.data(), sizeof(golden));
+}
+
+static void test_grayscale_threshold_and_centring(void) {
+    std::vector<uint32_t> pixels;
+    for (uint32_t x = 0; x < 8; ++x) {
+        pixels.push_back(x * 32);
+    }
+    const auto bmp = makeBmp(8, -1, 8, grayPalette(), pixels);
+
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(rasterizeBmp(bmp, smallOptions(32, LogoRasterizer::Dither::Threshold), out));
+    // 1 payload byte centred in a 4-byte row: one pad byte on the left
+    const uint8_t golden[] = {0x1D, 'v', '0', 0, 2, 0, 1, 0, 0x00, 0xF0};
+    TEST_ASSERT_EQUAL_UINT32(sizeof(golden), out.size());
+    TEST_ASSERT_EQUAL_MEMORY(golden, out.data(), sizeof(golden));
+}
+
+static void test_ordered_dither_golden(void) {
+    const std::vector<uint32_t> pixels(8 * 4, 128);
+    const auto bmp = makeBmp(8, 4, 8, grayPalette(), pixels);
+
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(rasterizeBmp(bmp, smallOptions(8, LogoRasterizer::Dither::Ordered), out));
+    const uint8_t golden[] = {0x1D, 'v', '0', 0, 1, 0, 4, 0,
+                              0x55, 0xAA, 0x55, 0xAA};  // 50% gray: checkerboard
+    TEST_ASSERT_EQUAL_UINT32(sizeof(golden), out.size());
+    TEST_ASSERT_EQUAL_MEMORY(golden, out.data(), sizeof(golden));
+}
+
+static void test_floyd_steinberg_golden_and_density(void) {
+    const std::vector<uint32_t> pixels(16 * 8, 64);  // 25% white
+    const auto bmp = makeBmp(16, 8, 8, grayPalette(), pixels);
+
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(rasterizeBmp(bmp, smallOptions(16, LogoRasterizer::Dither::FloydSteinberg), out));
+    TEST_ASSERT_EQUAL_UINT32(8 + 2 * 8, out.size());
+
+    const uint8_t goldenRows[] = {0xFF, 0xFF, 0xAA, 0xAA, 0xFF, 0xFF, 0xAA, 0xAA,
+                                  0xFF, 0xFF, 0xAA, 0xAB, 0xFF, 0xFD, 0xAA, 0xAF};
+    TEST_ASSERT_EQUAL_MEMORY(goldenRows, out.data() + 8, sizeof(goldenRows));
+
+    uint32_t black = 0;
+    for (size_t i = 8; i < out.size(); ++i) {
+        black += __builtin_popcount(out[i]);
+    }
+    TEST_ASSERT_UINT32_WITHIN(4, 96, black);  // ~75% of 128 dots
+}
+
+static void test_wide_logo_is_scaled_to_printer_width(void) {
+    // 16x2 of black/white pairs; halving gives alternating dots
+    std::vector<uint32_t> pixels;
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 16; ++x) {
+            pixels.push_back((x / 2) % 2 ? 255 : 0);
+        }
+    }
+    const auto bmp = makeBmp(16, 2, 8, grayPalette(), pixels);
+
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(rasterizeBmp(bmp, smallOptions(8, LogoRasterizer::Dither::Threshold), out));
+    const uint8_t golden[] = {0x1D, 'v', '0', 0, 1, 0, 1, 0, 0xAA};
+    TEST_ASSERT_EQUAL_UINT32(sizeof(golden), out.size());
+    TEST_ASSERT_EQUAL_MEMORY(golden, out.data(), sizeof(golden));
+
+    uint16_t width = 0;
+    uint16_t height = 0;
+    LogoRasterizer::scaledSize(768, 300, LogoRasterizer::Options(), width, height);
+    TEST_ASSERT_EQUAL_UINT16(384, width);
+    TEST_ASSERT_EQUAL_UINT16(150, height);
+    LogoRasterizer::scaledSize(200, 100, LogoRasterizer::Options(), width, height);
+    TEST_ASSERT_EQUAL_UINT16(200, width);
+}
+
+static void test_colour_bmp_converts_to_gray_and_feeds_escpos_writer(void) {
+    // Top-down 24-bit: dark red and dark blue are black, yellow and white are not
+    const std::vector<uint32_t> pixels = {0x400000, 0xFFFF00, 0x000040, 0xFFFFFF,
+                                          0xFFFFFF, 0x000000, 0xFFFFFF, 0x000000};
+    const auto bmp = makeBmp(4, -2, 24, {}, pixels);
+
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(rasterizeBmp(bmp, smallOptions(8, LogoRasterizer::Dither::Threshold), out));
+    const uint8_t golden[] = {0x1D, 'v', '0', 0, 1, 0, 2, 0, 0xA0, 0x50};
+    TEST_ASSERT_EQUAL_MEMORY(golden, out.data(), sizeof(golden));
+
+    PrintStream stream;
+    EscPosWriter writer(stream);
+    TEST_ASSERT_TRUE(writer.raster(out.data(), out.size()));
+    TEST_ASSERT_EQUAL_UINT32(2, stream.totalDotLines());
+}
+
+static void test_rejects_unsupported_or_truncated_bmps(void) {
+    auto bmp = makeBmp(8, 1, 8, grayPalette(), std::vector<uint32_t>(8, 0));
+    std::vector<uint8_t> compressed = bmp;
+    compressed[30] = 1;  // BI_RLE8
+    BmpGraySource rle(readFrom(compressed));
+    TEST_ASSERT_FALSE(rle.open());
+
+    std::vector<uint8_t> truncated(bmp.begin(), bmp.end() - 4);
+    std::vector<uint8_t> out = {0x42};
+    TEST_ASSERT_FALSE(rasterizeBmp(truncated, smallOptions(8, LogoRasterizer::Dither::Threshold), out));
+    TEST_ASSERT_EQUAL_UINT32(1, out.size());  // Output untouched on failure
+
+    const std::vector<uint8_t> junk(60, 0x00);
+    BmpGraySource notBmp(readFrom(junk));
+    TEST_ASSERT_FALSE(notBmp.open());
+}
+
+static void test_rejects_logo_taller_than_the_height_limit(void) {
+    // A full-width 4096-row source would need ~196 KB of raster
+    class TallSource : public IGrayRowSource {
+    public:
+        uint16_t width() const override { return 384; }
+        uint16_t height() const override { return 4096; }
+        bool readRow(uint16_t y, uint8_t *out) override {
+            (void)y;
+            std::memset(out, 0, 384);
+            ++reads;
+            return true;
+        }
+        int reads = 0;
+    };
+    TallSource tall;
+    LogoRasterizer rasterizer{LogoRasterizer::Options()};
+    std::vector<uint8_t> out = {0x42};
+    TEST_ASSERT_FALSE(rasterizer.rasterize(tall, out));
+    TEST_ASSERT_EQUAL_UINT32(1, out.size());
+    TEST_ASSERT_EQUAL_INT(0, tall.reads);
+
+    // The limit applies to the scaled height: 8x20 halved to 4x10 fits in 10 rows
+    const auto bmp = makeBmp(8, 20, 8, grayPalette(), std::vector<uint32_t>(160, 0));
+    LogoRasterizer::Options options = smallOptions(4, LogoRasterizer::Dither::Threshold);
+    options.maxHeightDots = 10;
+    TEST_ASSERT_TRUE(rasterizeBmp(bmp, options, out));
+    options.maxHeightDots = 9;
+    out.clear();
+    TEST_ASSERT_FALSE(rasterizeBmp(bmp, options, out));
+    TEST_ASSERT_TRUE(out.empty());
+}
+
+static void test_cache_header_round_trip(void) {
+    LogoRasterizer::CacheHeader header;
+    header.sourceBytes = 12345;
+    header.sourceStamp = 0x5F000000;
+    header.optionsKey = LogoRasterizer::Options().key();
+    header.payloadBytes = 4808;
+
+    uint8_t encoded[LogoRasterizer::CacheHeader::SIZE];
+    header.encode(encoded);
+
+    LogoRasterizer::CacheHeader decoded;
+    TEST_ASSERT_TRUE(decoded.decode(encoded, sizeof(encoded)));
+    TEST_ASSERT_EQUAL_UINT32(12345, decoded.sourceBytes);
+    TEST_ASSERT_EQUAL_UINT32(0x5F000000, decoded.sourceStamp);
+    TEST_ASSERT_EQUAL_UINT32(header.optionsKey, decoded.optionsKey);
+    TEST_ASSERT_EQUAL_UINT32(4808, decoded.payloadBytes);
+
+    encoded[4] = 99;  // Future version
+    TEST_ASSERT_FALSE(decoded.decode(encoded, sizeof(encoded)));
+    TEST_ASSERT_FALSE(decoded.decode(encoded, 8));
+
+    LogoRasterizer::Options ordered;
+    ordered.dither = LogoRasterizer::Dither::Ordered;
+    TEST_ASSERT_TRUE(ordered.key() != LogoRasterizer::Options().key());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_one_bit_bmp_matches_legacy_raster);
+    RUN_TEST(test_grayscale_threshold_and_centring);
+    RUN_TEST(test_ordered_dither_golden);
+    RUN_TEST(test_floyd_steinberg_golden_and_density);
+    RUN_TEST(test_wide_logo_is_scaled_to_printer_width);
+    RUN_TEST(test_colour_bmp_converts_to_gray_and_feeds_escpos_writer);
+    RUN_TEST(test_rejects_unsupported_or_truncated_bmps);
+    RUN_TEST(test_rejects_logo_taller_than_the_height_limit);
+    RUN_TEST(test_cache_header_round_trip);
+    return UNITY_END();
+}
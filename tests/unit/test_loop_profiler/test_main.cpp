@@ -0,0 +1,140 @@
+#include <unity.h>
+
+#include "loop_profiler.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+uint32_t g_ticks = 0;
+
+uint32_t fakeTicks() {
+    return g_ticks;
+}
+
+using Stage = LoopProfiler::Stage;
+
+}  // namespace
+
+void setUp(void) {
+    g_ticks = 0;
+}
+
+void tearDown(void) {}
+
+static void test_scope_records_elapsed_microseconds(void) {
+    LoopProfiler profiler;
+    profiler.setClock(fakeTicks, 240);  // 240 MHz cycle counter
+    {
+        LoopProfiler::Scope scope(profiler, Stage::Audio);
+        g_ticks += 240 * 150;
+    }
+    const auto stats = profiler.stats(Stage::Audio);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.samples);
+    TEST_ASSERT_EQUAL_UINT32(150, stats.minUs);
+    TEST_ASSERT_EQUAL_UINT32(150, stats.maxUs);
+    TEST_ASSERT_EQUAL_UINT32(150, stats.avgUs);
+}
+
+static void test_elapsed_handles_counter_wrap(void) {
+    LoopProfiler profiler;
+    profiler.setClock(fakeTicks, 1);
+    g_ticks = 0xFFFFFF00u;
+    {
+        LoopProfiler::Scope scope(profiler, Stage::Printer);
+        g_ticks += 0x200;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0x200, profiler.stats(Stage::Printer).maxUs);
+}
+
+static void test_min_avg_max_and_percentiles(void) {
+    LoopProfiler profiler;
+    for (int i = 0; i < 99; ++i) {
+        profiler.record(Stage::Finger, 100);
+    }
+    profiler.record(Stage::Finger, 9000);
+
+    const auto stats = profiler.stats(Stage::Finger);
+    TEST_ASSERT_EQUAL_UINT32(100, stats.samples);
+    TEST_ASSERT_EQUAL_UINT32(100, stats.minUs);
+    TEST_ASSERT_EQUAL_UINT32(9000, stats.maxUs);
+    TEST_ASSERT_EQUAL_UINT32(189, stats.avgUs);
+    // 100 µs sits in the [96, 111] bucket; p50/p99 report the bucket bound.
+    TEST_ASSERT_EQUAL_UINT32(111, stats.p50Us);
+    TEST_ASSERT_EQUAL_UINT32(111, stats.p99Us);
+
+    profiler.record(Stage::Finger, 9000);
+    TEST_ASSERT_EQUAL_UINT32(9000, profiler.stats(Stage::Finger).p99Us);
+}
+
+static void test_percentile_error_is_bounded(void) {
+    LoopProfiler profiler;
+    for (uint32_t value = 1; value <= 1000; ++value) {
+        profiler.record(Stage::Controller, value * 10);
+    }
+    const auto stats = profiler.stats(Stage::Controller);
+    // Exact p99 is 9900 µs; four sub-buckets per octave keep us within 25%.
+    TEST_ASSERT_TRUE(stats.p99Us >= 9900);
+    TEST_ASSERT_TRUE(stats.p99Us <= 9900 + 9900 / 4);
+    TEST_ASSERT_TRUE(stats.p50Us >= 5000);
+    TEST_ASSERT_TRUE(stats.p50Us <= 5000 + 5000 / 4);
+}
+
+static void test_budget_overruns_are_counted(void) {
+    LoopProfiler profiler;
+    profiler.setBudgetUs(Stage::Bluetooth, 1000);
+    profiler.record(Stage::Bluetooth, 999);
+    profiler.record(Stage::Bluetooth, 1000);
+    profiler.record(Stage::Bluetooth, 1001);
+    profiler.record(Stage::Bluetooth, 25000);
+    TEST_ASSERT_EQUAL_UINT32(2, profiler.stats(Stage::Bluetooth).overBudget);
+    TEST_ASSERT_EQUAL_UINT32(LoopProfiler::DEFAULT_LOOP_BUDGET_US,
+                             profiler.stats(Stage::Loop).budgetUs);
+}
+
+static void test_reset_clears_samples_but_keeps_budget(void) {
+    LoopProfiler profiler;
+    profiler.setBudgetUs(Stage::Cli, 200);
+    profiler.record(Stage::Cli, 500);
+    profiler.reset();
+    const auto stats = profiler.stats(Stage::Cli);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.overBudget);
+    TEST_ASSERT_EQUAL_UINT32(200, stats.budgetUs);
+}
+
+static void test_very_slow_samples_clamp_to_last_bucket(void) {
+    LoopProfiler profiler;
+    profiler.record(Stage::Lights, 30000000);
+    const auto stats = profiler.stats(Stage::Lights);
+    TEST_ASSERT_EQUAL_UINT32(30000000, stats.maxUs);
+    TEST_ASSERT_EQUAL_UINT32(30000000, stats.p99Us);
+}
+
+static void test_report_skips_idle_stages(void) {
+    LoopProfiler profiler;
+    profiler.record(Stage::Uart, 40);
+    profiler.record(Stage::Loop, 900);
+
+    std::vector<std::string> lines;
+    profiler.writeReport([&lines](const char *line) { lines.emplace_back(line); });
+
+    TEST_ASSERT_EQUAL(4, static_cast<int>(lines.size()));
+    TEST_ASSERT_EQUAL_STRING("=== LOOP PROFILE (us) ===", lines[0].c_str());
+    TEST_ASSERT_EQUAL(0, static_cast<int>(lines[2].rfind("uart", 0)));
+    TEST_ASSERT_EQUAL(0, static_cast<int>(lines[3].rfind("loop", 0)));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_scope_records_elapsed_microseconds);
+    RUN_TEST(test_elapsed_handles_counter_wrap);
+    RUN_TEST(test_min_avg_max_and_percentiles);
+    RUN_TEST(test_percentile_error_is_bounded);
+    RUN_TEST(test_budget_overruns_are_counted);
+    RUN_TEST(test_reset_clears_samples_but_keeps_budget);
+    RUN_TEST(test_very_slow_samples_clamp_to_last_bucket);
+    RUN_TEST(test_report_skips_idle_stages);
+    return UNITY_END();
+}
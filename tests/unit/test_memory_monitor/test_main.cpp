@@ -0,0 +1,307 @@
+#include <unity.h>
+
+#include "audio_directory_selector.h"
+#include "fake_filesystem.h"
+#include "fake_log_sink.h"
+#include "fixture_loader.h"
+#include "fortune_generator.h"
+#include "infra/alloc_tracker.h"
+#include "infra/heap_probe.h"
+#include "infra/log_sink.h"
+#include "infra/random_source.h"
+#include "memory_monitor.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+class ScriptedHeapProbe : public infra::IHeapProbe {
+public:
+    infra::HeapStats sample() const override {
+        return stats;
+    }
+
+    infra::HeapStats stats;
+};
+
+// Models a fixed-size heap whose usage follows the tracked allocations so the
+// simulated session reports plausible free/min-free numbers.
+class TrackedHeapProbe : public infra::IHeapProbe {
+public:
+    static constexpr uint32_t CAPACITY = 320 * 1024;
+
+    infra::HeapStats sample() const override {
+        const infra::AllocCounters totals = infra::allocTotals();
+        infra::HeapStats stats;
+        stats.totalBytes = CAPACITY;
+        stats.freeBytes = CAPACITY - totals.liveBytes;
+        stats.largestFreeBlock = stats.freeBytes;
+        stats.minimumFreeBytes = CAPACITY - totals.peakLiveBytes;
+        return stats;
+    }
+};
+
+class LcgRandom : public infra::IRandomSource {
+public:
+    int nextInt(int minInclusive, int maxExclusive) override {
+        if (maxExclusive <= minInclusive) {
+            return minInclusive;
+        }
+        state = state * 1103515245u + 12345u;
+        const uint32_t span = static_cast<uint32_t>(maxExclusive - minInclusive);
+        return minInclusive + static_cast<int>((state >> 16) % span);
+    }
+
+    uint32_t state = 1;
+};
+
+class StubEnumerator : public AudioDirectorySelector::IFileEnumerator {
+public:
+    bool listWavFiles(const String &directory, std::vector<String> &out) override {
+        out.clear();
+        for (int i = 0; i < 6; ++i) {
+            char name[24];
+            snprintf(name, sizeof(name), "/clip_%d.wav", i);
+            out.push_back(directory + name);
+        }
+        return true;
+    }
+};
+
+std::vector<std::string> collectReport(MemoryMonitor &monitor) {
+    std::vector<std::string> lines;
+    monitor.writeReport([&lines](const char *line) { lines.emplace_back(line); });
+    return lines;
+}
+
+}  // namespace
+
+void setUp(void) {
+    infra::setLogSink(nullptr);
+}
+
+void tearDown(void) {
+    infra::setLogSink(nullptr);
+}
+
+static void test_scoped_tag_attributes_allocations(void) {
+    const infra::AllocCounters before = infra::allocCounters(infra::AllocTag::Fortune);
+    {
+        infra::ScopedAllocTag tag(infra::AllocTag::Fortune);
+        std::vector<int> values(64);
+        const infra::AllocCounters during = infra::allocCounters(infra::AllocTag::Fortune);
+        TEST_ASSERT_EQUAL_UINT32(before.allocations + 1, during.allocations);
+        TEST_ASSERT_EQUAL_UINT32(before.liveBytes + 64 * sizeof(int), during.liveBytes);
+    }
+    const infra::AllocCounters after = infra::allocCounters(infra::AllocTag::Fortune);
+    TEST_ASSERT_EQUAL_UINT32(before.frees + 1, after.frees);
+    TEST_ASSERT_EQUAL_UINT32(before.liveBytes, after.liveBytes);
+    TEST_ASSERT_TRUE(after.peakLiveBytes >= 64 * sizeof(int));
+}
+
+static void test_free_is_credited_to_allocating_tag(void) {
+    std::vector<int> *values = nullptr;
+    const infra::AllocCounters before = infra::allocCounters(infra::AllocTag::Printer);
+    {
+        infra::ScopedAllocTag tag(infra::AllocTag::Printer);
+        values = new std::vector<int>(16);
+    }
+    {
+        infra::ScopedAllocTag tag(infra::AllocTag::Cli);
+        delete values;
+    }
+    const infra::AllocCounters after = infra::allocCounters(infra::AllocTag::Printer);
+    TEST_ASSERT_EQUAL_UINT32(before.allocations + 2, after.allocations);
+    TEST_ASSERT_EQUAL_UINT32(before.frees + 2, after.frees);
+    TEST_ASSERT_EQUAL_UINT32(before.liveBytes, after.liveBytes);
+}
+
+static void test_nested_scopes_restore_previous_tag(void) {
+    TEST_ASSERT_EQUAL(infra::AllocTag::Other, infra::currentAllocTag());
+    {
+        infra::ScopedAllocTag outer(infra::AllocTag::Controller);
+        {
+            infra::ScopedAllocTag inner(infra::AllocTag::Audio);
+            TEST_ASSERT_EQUAL(infra::AllocTag::Audio, infra::currentAllocTag());
+        }
+        TEST_ASSERT_EQUAL(infra::AllocTag::Controller, infra::currentAllocTag());
+    }
+    TEST_ASSERT_EQUAL(infra::AllocTag::Other, infra::currentAllocTag());
+}
+
+static void test_monitor_logs_once_per_interval(void) {
+    ScriptedHeapProbe probe;
+    probe.stats.freeBytes = 100000;
+    probe.stats.largestFreeBlock = 60000;
+    probe.stats.minimumFreeBytes = 90000;
+    probe.stats.totalBytes = 200000;
+    FakeLogSink sink;
+    infra::setLogSink(&sink);
+
+    MemoryMonitor monitor(probe);
+    monitor.setLogIntervalMs(1000);
+    monitor.update(0);
+    monitor.update(500);
+    monitor.update(999);
+    TEST_ASSERT_EQUAL(1, static_cast<int>(sink.entries.size()));
+    monitor.update(1000);
+    TEST_ASSERT_EQUAL(2, static_cast<int>(sink.entries.size()));
+
+    const CapturedLog &entry = sink.entries.front();
+    TEST_ASSERT_EQUAL_STRING("Memory", entry.tag.c_str());
+    TEST_ASSERT_TRUE(entry.message.find("free=100000") != std::string::npos);
+    TEST_ASSERT_TRUE(entry.message.find("largest=60000") != std::string::npos);
+    TEST_ASSERT_TRUE(entry.message.find("frag=40%") != std::string::npos);
+}
+
+static void test_monitor_tracks_largest_block_low_watermark(void) {
+    ScriptedHeapProbe probe;
+    probe.stats.freeBytes = 100000;
+    probe.stats.largestFreeBlock = 80000;
+    MemoryMonitor monitor(probe);
+
+    monitor.sample();
+    probe.stats.largestFreeBlock = 30000;
+    monitor.sample();
+    probe.stats.largestFreeBlock = 70000;
+    monitor.sample();
+
+    TEST_ASSERT_EQUAL_UINT32(30000, monitor.minLargestFreeBlock());
+    TEST_ASSERT_EQUAL_UINT32(70000, monitor.lastSample().largestFreeBlock);
+    TEST_ASSERT_EQUAL_UINT32(3, monitor.sampleCount());
+}
+
+static void test_fragmentation_percent_edge_cases(void) {
+    infra::HeapStats stats;
+    TEST_ASSERT_EQUAL_UINT32(0, MemoryMonitor::fragmentationPercent(stats));
+    stats.freeBytes = 1000;
+    stats.largestFreeBlock = 1000;
+    TEST_ASSERT_EQUAL_UINT32(0, MemoryMonitor::fragmentationPercent(stats));
+    stats.largestFreeBlock = 250;
+    TEST_ASSERT_EQUAL_UINT32(75, MemoryMonitor::fragmentationPercent(stats));
+}
+
+static void test_report_lists_active_subsystems(void) {
+    {
+        infra::ScopedAllocTag tag(infra::AllocTag::Network);
+        std::string payload(256, 'x');
+    }
+    ScriptedHeapProbe probe;
+    probe.stats.freeBytes = 5000;
+    probe.stats.largestFreeBlock = 5000;
+    MemoryMonitor monitor(probe);
+
+    const std::vector<std::string> lines = collectReport(monitor);
+    TEST_ASSERT_EQUAL_STRING("=== MEMORY ===", lines.front().c_str());
+    bool hasNetwork = false;
+    bool hasTotal = false;
+    for (const auto &line : lines) {
+        if (line.rfind("network", 0) == 0) {
+            hasNetwork = true;
+        }
+        if (line.rfind("total", 0) == 0) {
+            hasTotal = true;
+        }
+    }
+    TEST_ASSERT_TRUE(hasNetwork);
+    TEST_ASSERT_TRUE(hasTotal);
+}
+
+// Drives a day of visitor cycles through the host-testable subsystems and
+// reports how many allocations each one made. Live bytes must return to the
+// post-warm-up level so a slow leak shows up here rather than after days of
+// uptime on the skull.
+static void test_simulated_day_reports_allocations_per_subsystem(void) {
+    constexpr uint32_t DAY_MS = 24UL * 60UL * 60UL * 1000UL;
+    constexpr uint32_t TICK_MS = 1000;
+    constexpr uint32_t VISITOR_INTERVAL_MS = 90000;
+
+    FakeFileSystem fs;
+    fs.addFile("/printer/fortunes.json", loadFixture("fortune_session.json"));
+    LcgRandom random;
+    FakeLogSink sink;
+
+    FortuneGenerator generator;
+    generator.setFileSystem(&fs);
+    generator.setRandomSource(&random);
+    generator.setLogSink(&sink);
+    TEST_ASSERT_TRUE(generator.loadFortunes("/printer/fortunes.json"));
+
+    StubEnumerator enumerator;
+    uint32_t nowMs = 0;
+    AudioDirectorySelector::Dependencies selectorDeps;
+    selectorDeps.enumerator = &enumerator;
+    selectorDeps.randomSource = &random;
+    selectorDeps.nowFn = [&nowMs]() -> unsigned long { return nowMs; };
+    AudioDirectorySelector selector(selectorDeps);
+
+    TrackedHeapProbe probe;
+    MemoryMonitor monitor(probe);
+    sink.entries.reserve(2000);
+
+    const auto visitorCycle = [&]() {
+        String welcome = selector.selectClip("/audio/welcome", "welcome");
+        String fortune = generator.generateFortune();
+        String goodbye = selector.selectClip("/audio/goodbye", "goodbye");
+        TEST_ASSERT_TRUE(welcome.length() > 0);
+        TEST_ASSERT_TRUE(fortune.length() > 0);
+        TEST_ASSERT_TRUE(goodbye.length() > 0);
+    };
+
+    visitorCycle();
+    const uint32_t fortuneBaseline = infra::allocCounters(infra::AllocTag::Fortune).liveBytes;
+    const uint32_t audioBaseline = infra::allocCounters(infra::AllocTag::Audio).liveBytes;
+    const uint32_t fortuneAllocsBefore = infra::allocCounters(infra::AllocTag::Fortune).allocations;
+    const uint32_t audioAllocsBefore = infra::allocCounters(infra::AllocTag::Audio).allocations;
+
+    uint32_t visitors = 0;
+    for (nowMs = 0; nowMs < DAY_MS; nowMs += TICK_MS) {
+        if (nowMs % VISITOR_INTERVAL_MS == 0) {
+            visitorCycle();
+            ++visitors;
+        }
+        monitor.update(nowMs);
+    }
+
+    const infra::AllocCounters fortune = infra::allocCounters(infra::AllocTag::Fortune);
+    const infra::AllocCounters audio = infra::allocCounters(infra::AllocTag::Audio);
+
+    char summary[128];
+    snprintf(summary, sizeof(summary), "%u visitors: fortune %u allocs, audio %u allocs",
+             static_cast<unsigned>(visitors),
+             static_cast<unsigned>(fortune.allocations - fortuneAllocsBefore),
+             static_cast<unsigned>(audio.allocations - audioAllocsBefore));
+    TEST_MESSAGE(summary);
+    for (const auto &line : collectReport(monitor)) {
+        TEST_MESSAGE(line.c_str());
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(DAY_MS / VISITOR_INTERVAL_MS, visitors);
+    int memoryLogLines = 0;
+    for (const auto &entry : sink.entries) {
+        if (entry.tag == "Memory") {
+            ++memoryLogLines;
+        }
+    }
+    TEST_ASSERT_EQUAL(static_cast<int>(DAY_MS / MemoryMonitor::DEFAULT_LOG_INTERVAL_MS), memoryLogLines);
+    TEST_ASSERT_TRUE(fortune.allocations > fortuneAllocsBefore);
+    TEST_ASSERT_TRUE(audio.allocations > audioAllocsBefore);
+    TEST_ASSERT_EQUAL_UINT32(fortuneBaseline, fortune.liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(audioBaseline, audio.liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, infra::allocTotals().failures);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_scoped_tag_attributes_allocations);
+    RUN_TEST(test_free_is_credited_to_allocating_tag);
+    RUN_TEST(test_nested_scopes_restore_previous_tag);
+    RUN_TEST(test_monitor_logs_once_per_interval);
+    RUN_TEST(test_monitor_tracks_largest_block_low_watermark);
+    RUN_TEST(test_fragmentation_percent_edge_cases);
+    RUN_TEST(test_report_lists_active_subsystems);
+    RUN_TEST(test_simulated_day_reports_allocations_per_subsystem);
+    return UNITY_END();
+}
@@ -0,0 +1,190 @@
+#include <unity.h>
+
+#include "print_job_queue.h"
+
+#include <string>
+
+namespace {
+
+PrintJobQueue::Config smallQueue() {
+    PrintJobQueue::Config config;
+    config.capacity = 3;
+    config.maxAttempts = 2;
+    config.retryDelayMs = 1000;
+    config.historySize = 2;
+    return config;
+}
+
+PrintJobQueue::Status statusOf(const PrintJobQueue &queue, uint32_t id) {
+    PrintJobQueue::Status status = PrintJobQueue::Status::Pending;
+    TEST_ASSERT_TRUE(queue.status(id, status));
+    return status;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_jobs_print_in_order_one_at_a_time(void) {
+    PrintJobQueue queue(smallQueue());
+    const uint32_t first = queue.enqueue("first");
+    const uint32_t second = queue.enqueue("second");
+    TEST_ASSERT_NOT_EQUAL(0, first);
+    TEST_ASSERT_NOT_EQUAL(first, second);
+
+    const PrintJobQueue::Job *job = queue.next(0);
+    TEST_ASSERT_NOT_NULL(job);
+    TEST_ASSERT_EQUAL_UINT32(first, job->id);
+    TEST_ASSERT_TRUE(queue.start(first));
+    TEST_ASSERT_NULL(queue.next(0));
+    TEST_ASSERT_FALSE(queue.start(second));
+
+    TEST_ASSERT_TRUE(queue.complete(first));
+    TEST_ASSERT_EQUAL(PrintJobQueue::Status::Done, statusOf(queue, first));
+    job = queue.next(0);
+    TEST_ASSERT_NOT_NULL(job);
+    TEST_ASSERT_EQUAL_STRING("second", job->text.c_str());
+    TEST_ASSERT_EQUAL_UINT32(1, queue.size());
+}
+
+static void test_full_queue_rejects_new_jobs(void) {
+    PrintJobQueue queue(smallQueue());
+    queue.enqueue("a");
+    queue.enqueue("b");
+    queue.enqueue("c");
+    TEST_ASSERT_TRUE(queue.full());
+    TEST_ASSERT_EQUAL_UINT32(0, queue.enqueue("d"));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.stats().rejected);
+    TEST_ASSERT_EQUAL_UINT32(3, queue.size());
+}
+
+static void test_failed_job_waits_for_retry_then_gives_up(void) {
+    PrintJobQueue queue(smallQueue());
+    const uint32_t id = queue.enqueue("slip");
+    TEST_ASSERT_TRUE(queue.start(id));
+    TEST_ASSERT_TRUE(queue.fail(id, 5000));
+    TEST_ASSERT_EQUAL(PrintJobQueue::Status::Pending, statusOf(queue, id));
+
+    TEST_ASSERT_NULL(queue.next(5999));
+    TEST_ASSERT_NOT_NULL(queue.next(6000));
+    TEST_ASSERT_TRUE(queue.start(id));
+    TEST_ASSERT_FALSE(queue.fail(id, 7000));
+    TEST_ASSERT_EQUAL(PrintJobQueue::Status::Failed, statusOf(queue, id));
+    TEST_ASSERT_TRUE(queue.empty());
+    TEST_ASSERT_EQUAL_UINT32(1, queue.stats().retried);
+    TEST_ASSERT_EQUAL_UINT32(1, queue.stats().failed);
+}
+
+static void test_retry_delay_does_not_block_other_jobs(void) {
+    PrintJobQueue queue(smallQueue());
+    const uint32_t first = queue.enqueue("first");
+    const uint32_t second = queue.enqueue("second");
+    queue.start(first);
+    queue.fail(first, 100);
+
+    const PrintJobQueue::Job *job = queue.next(200);
+    TEST_ASSERT_NOT_NULL(job);
+    TEST_ASSERT_EQUAL_UINT32(second, job->id);
+}
+
+static void test_history_is_bounded(void) {
+    PrintJobQueue queue(smallQueue());
+    uint32_t ids[3];
+    for (auto &id : ids) {
+        id = queue.enqueue("x");
+        queue.start(id);
+        queue.complete(id);
+    }
+    PrintJobQueue::Status status;
+    TEST_ASSERT_FALSE(queue.status(ids[0], status));
+    TEST_ASSERT_TRUE(queue.status(ids[2], status));
+}
+
+static void test_encode_decode_round_trip_resumes_printing_job(void) {
+    PrintJobQueue queue(smallQueue());
+    const uint32_t first = queue.enqueue("line one\nline two \\ done");
+    const uint32_t second = queue.enqueue("");
+    queue.start(first);
+
+    const std::string saved = queue.encode();
+    PrintJobQueue restored(smallQueue());
+    TEST_ASSERT_TRUE(restored.decode(saved));
+    TEST_ASSERT_EQUAL_UINT32(2, restored.size());
+
+    const PrintJobQueue::Job *job = restored.next(0);
+    TEST_ASSERT_NOT_NULL(job);
+    TEST_ASSERT_EQUAL_UINT32(first, job->id);
+    TEST_ASSERT_EQUAL_UINT8(1, job->attempts);
+    TEST_ASSERT_EQUAL_STRING("line one\nline two \\ done", job->text.c_str());
+    TEST_ASSERT_EQUAL(PrintJobQueue::Status::Pending, statusOf(restored, second));
+
+    // Ids keep counting from where the saved queue left off
+    TEST_ASSERT_EQUAL_UINT32(second + 1, restored.enqueue("third"));
+}
+
+static void test_decode_rejects_damaged_files(void) {
+    PrintJobQueue source(smallQueue());
+    source.enqueue("alpha");
+    source.enqueue("beta");
+    const std::string saved = source.encode();
+
+    PrintJobQueue queue(smallQueue());
+    const uint32_t kept = queue.enqueue("kept");
+    TEST_ASSERT_FALSE(queue.decode(saved.substr(0, saved.size() - 3)));
+    TEST_ASSERT_FALSE(queue.decode("DFPQ 1 5 1\n"));
+    TEST_ASSERT_FALSE(queue.decode("DFPQ 9 5 0\n"));
+    TEST_ASSERT_FALSE(queue.decode("garbage\n"));
+    TEST_ASSERT_FALSE(queue.decode("DFPQ 1 5 1\n7 0 bad\\q\n"));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.size());
+    TEST_ASSERT_EQUAL(PrintJobQueue::Status::Pending, statusOf(queue, kept));
+}
+
+static void test_revision_tracks_persisted_changes(void) {
+    PrintJobQueue queue(smallQueue());
+    const uint32_t base = queue.revision();
+    const uint32_t id = queue.enqueue("x");
+    TEST_ASSERT_NOT_EQUAL(base, queue.revision());
+    const uint32_t afterEnqueue = queue.revision();
+    queue.next(0);
+    TEST_ASSERT_EQUAL_UINT32(afterEnqueue, queue.revision());
+    queue.start(id);
+    TEST_ASSERT_NOT_EQUAL(afterEnqueue, queue.revision());
+}
+
+static void test_requeue_keeps_the_attempt_budget(void) {
+    PrintJobQueue queue(smallQueue());
+    const uint32_t id = queue.enqueue("slip");
+    TEST_ASSERT_TRUE(queue.start(id));
+    const uint32_t revision = queue.revision();
+
+    // Paper ran out: back to pending, ready at once, no attempt spent
+    TEST_ASSERT_TRUE(queue.requeue(id));
+    TEST_ASSERT_NOT_EQUAL(revision, queue.revision());
+    TEST_ASSERT_EQUAL(PrintJobQueue::Status::Pending, statusOf(queue, id));
+    const PrintJobQueue::Job *job = queue.next(0);
+    TEST_ASSERT_NOT_NULL(job);
+    TEST_ASSERT_EQUAL_UINT8(0, job->attempts);
+    TEST_ASSERT_FALSE(queue.requeue(id));
+
+    // Both attempts are still available
+    TEST_ASSERT_TRUE(queue.start(id));
+    TEST_ASSERT_TRUE(queue.fail(id, 0));
+    TEST_ASSERT_TRUE(queue.start(id));
+    TEST_ASSERT_TRUE(queue.complete(id));
+    TEST_ASSERT_EQUAL_UINT32(0, queue.stats().failed);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_jobs_print_in_order_one_at_a_time);
+    RUN_TEST(test_full_queue_rejects_new_jobs);
+    RUN_TEST(test_failed_job_waits_for_retry_then_gives_up);
+    RUN_TEST(test_retry_delay_does_not_block_other_jobs);
+    RUN_TEST(test_history_is_bounded);
+    RUN_TEST(test_encode_decode_round_trip_resumes_printing_job);
+    RUN_TEST(test_decode_rejects_damaged_files);
+    RUN_TEST(test_revision_tracks_persisted_changes);
+    RUN_TEST(test_requeue_keeps_the_attempt_budget);
+    return UNITY_END();
+}
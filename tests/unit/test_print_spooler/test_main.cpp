@@ -0,0 +1,232 @@
+#include <unity.h>
+
+#include "escpos_stream.h"
+#include "print_spooler.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+class CaptureSink : public PrintSpooler::IByteSink {
+public:
+    size_t availableForWrite() override { return fifoSpace; }
+    size_t write(const uint8_t *data, size_t length) override {
+        bytes.insert(bytes.end(), data, data + length);
+        if (fifoFills) {
+            fifoSpace -= length;
+        }
+        return length;
+    }
+
+    size_t fifoSpace = 128;
+    bool fifoFills = false;  // When false the UART drains instantly
+    std::vector<uint8_t> bytes;
+};
+
+PrintSpooler::Timing serialOnly(uint32_t baud) {
+    PrintSpooler::Timing timing;
+    timing.baud = baud;
+    timing.headDotLinesPerSec = 0;  // Head model off
+    timing.burstBytes = 16;
+    return timing;
+}
+
+PrintStream plainBytes(size_t count) {
+    PrintStream stream;
+    stream.bytes.assign(count, 'x');
+    return stream;
+}
+
+PrintStream textLines(size_t lines, size_t columns) {
+    PrintStream stream;
+    EscPosWriter out(stream);
+    const std::string text(columns, 'a');
+    for (size_t i = 0; i < lines; ++i) {
+        out.textLine(text.c_str(), text.size());
+    }
+    return stream;
+}
+
+// Pumps every stepUs from startUs until the job drains; returns the end time.
+uint32_t drain(PrintSpooler &spooler, uint32_t stepUs, uint32_t limitUs, uint32_t startUs = 0) {
+    uint32_t now = startUs;
+    spooler.pump(now);
+    while (spooler.isBusy() && now < limitUs) {
+        now += stepUs;
+        spooler.pump(now);
+    }
+    return now;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_writer_charges_line_spacing_and_raster_rows(void) {
+    PrintStream stream;
+    EscPosWriter out(stream);
+    out.initialize();
+    out.textLine("hi", 2);
+    out.setLineSpacing(24);
+    out.newline();
+
+    const uint8_t raster[] = {0x1D, 'v', '0', 0, 2, 0, 3, 0,
+                              0xFF, 0x00, 0x0F, 0xF0, 0xAA, 0x55};
+    TEST_ASSERT_TRUE(out.raster(raster, sizeof(raster)));
+    TEST_ASSERT_EQUAL_UINT32(32 + 24 + 3, stream.totalDotLines());
+    TEST_ASSERT_EQUAL_UINT32(5, stream.marks.size());
+    TEST_ASSERT_EQUAL_UINT32(stream.bytes.size(), stream.marks.back().endOffset);
+
+    const uint8_t truncated[] = {0x1D, 'v', '0', 0, 2, 0, 3, 0, 0xFF};
+    const size_t before = stream.bytes.size();
+    TEST_ASSERT_FALSE(out.raster(truncated, sizeof(truncated)));
+    TEST_ASSERT_EQUAL_UINT32(before, stream.bytes.size());
+}
+
+static void test_serial_bucket_paces_to_baud_rate(void) {
+    CaptureSink sink;
+    PrintSpooler spooler(sink);
+    spooler.setTiming(serialOnly(9600));  // 960 bytes/s
+    TEST_ASSERT_TRUE(spooler.load(plainBytes(960)));
+
+    uint32_t now = 0;
+    spooler.pump(now);
+    TEST_ASSERT_EQUAL_UINT32(16, sink.bytes.size());  // Initial burst only
+    for (int i = 0; i < 100; ++i) {
+        now += 1000;
+        spooler.pump(now);
+        TEST_ASSERT_TRUE(sink.bytes.size() <= 16 + (now * 960ULL) / 1000000ULL);
+    }
+    TEST_ASSERT_UINT32_WITHIN(2, 16 + 96, sink.bytes.size());
+
+    const uint32_t elapsed = drain(spooler, 1000, 5000000, now + 1000);
+    TEST_ASSERT_FALSE(spooler.isBusy());
+    TEST_ASSERT_EQUAL_UINT32(960, sink.bytes.size());
+    TEST_ASSERT_UINT32_WITHIN(30000, 983000, elapsed);
+}
+
+static void test_sink_space_limits_each_write(void) {
+    CaptureSink sink;
+    sink.fifoSpace = 4;
+    sink.fifoFills = true;
+    PrintSpooler spooler(sink);
+    spooler.setTiming(serialOnly(115200));
+    spooler.load(plainBytes(64));
+
+    size_t written = spooler.pump(0);
+    TEST_ASSERT_EQUAL_UINT32(4, written);
+    written = spooler.pump(10000);  // FIFO still full
+    TEST_ASSERT_EQUAL_UINT32(0, written);
+
+    for (uint32_t now = 11000; spooler.isBusy() && now < 1000000; now += 1000) {
+        sink.fifoSpace = 4;  // UART drained a little
+        spooler.pump(now);
+    }
+    TEST_ASSERT_EQUAL_UINT32(64, sink.bytes.size());
+}
+
+static void test_head_model_holds_output_when_printer_falls_behind(void) {
+    CaptureSink sink;
+    PrintSpooler spooler(sink);
+    PrintSpooler::Timing timing;
+    timing.baud = 115200;
+    timing.headDotLinesPerSec = 400;
+    timing.headBufferDotLines = 96;
+    timing.burstBytes = 255;
+    spooler.setTiming(timing);
+
+    PrintStream stream = textLines(20, 16);  // 20 lines * 32 dots = 640 dot lines
+    const size_t lineBytes = 17;
+    const uint32_t estimate = PrintSpooler::estimateMicros(stream, timing);
+    spooler.load(std::move(stream));
+
+    spooler.pump(0);
+    // Three lines fill the 96-line head buffer; the fourth must wait.
+    TEST_ASSERT_EQUAL_UINT32(3 * lineBytes, sink.bytes.size());
+    TEST_ASSERT_EQUAL_UINT32(1, spooler.stats().headWaits);
+
+    spooler.pump(40000);  // 16 dot lines drained: below the limit again
+    TEST_ASSERT_EQUAL_UINT32(4 * lineBytes, sink.bytes.size());
+    spooler.pump(80000);  // Backlog back at the limit (112 - 16)
+    TEST_ASSERT_EQUAL_UINT32(4 * lineBytes, sink.bytes.size());
+    spooler.pump(120000);
+    TEST_ASSERT_EQUAL_UINT32(5 * lineBytes, sink.bytes.size());
+
+    const uint32_t elapsed = drain(spooler, 1000, 10000000, 121000);
+    TEST_ASSERT_EQUAL_UINT32(20 * lineBytes, sink.bytes.size());
+    // (640 - 96) dot lines at 400/s = 1.36 s
+    TEST_ASSERT_UINT32_WITHIN(10000, 1360000, estimate);
+    TEST_ASSERT_TRUE(elapsed >= estimate - 100000);
+    TEST_ASSERT_TRUE(elapsed <= estimate + 100000);
+}
+
+static void test_clear_to_send_pauses_output(void) {
+    CaptureSink sink;
+    PrintSpooler spooler(sink);
+    spooler.setTiming(serialOnly(115200));
+    bool ready = false;
+    spooler.setClearToSend([&ready]() { return ready; });
+    spooler.load(plainBytes(32));
+
+    spooler.pump(0);
+    spooler.pump(5000);
+    TEST_ASSERT_TRUE(sink.bytes.empty());
+    TEST_ASSERT_EQUAL_UINT32(2, spooler.stats().flowWaits);
+
+    ready = true;
+    drain(spooler, 1000, 1000000);
+    TEST_ASSERT_EQUAL_UINT32(32, sink.bytes.size());
+    TEST_ASSERT_EQUAL_UINT32(1, spooler.stats().jobs);
+}
+
+static void test_busy_spooler_rejects_second_job_until_done(void) {
+    CaptureSink sink;
+    PrintSpooler spooler(sink);
+    spooler.setTiming(serialOnly(9600));
+    TEST_ASSERT_TRUE(spooler.load(plainBytes(100)));
+    TEST_ASSERT_FALSE(spooler.load(plainBytes(10)));
+    TEST_ASSERT_EQUAL_UINT32(100, spooler.bytesRemaining());
+
+    spooler.abort();
+    TEST_ASSERT_FALSE(spooler.isBusy());
+    TEST_ASSERT_TRUE(spooler.load(plainBytes(10)));
+    drain(spooler, 1000, 1000000);
+    TEST_ASSERT_EQUAL_UINT32(10, spooler.stats().lastJobBytes);
+}
+
+static void test_stream_bytes_arrive_in_order(void) {
+    CaptureSink sink;
+    sink.fifoSpace = 7;
+    PrintSpooler spooler(sink);
+    PrintSpooler::Timing timing;
+    timing.baud = 19200;
+    timing.burstBytes = 5;
+    spooler.setTiming(timing);
+
+    PrintStream stream;
+    EscPosWriter out(stream);
+    out.initialize();
+    out.setJustification(1);
+    out.textLine("The end is nigh", 15);
+    out.feed(3);
+    const std::vector<uint8_t> expected = stream.bytes;
+    spooler.load(std::move(stream));
+
+    drain(spooler, 500, 10000000);
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), sink.bytes.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected.data(), sink.bytes.data(), expected.size());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_writer_charges_line_spacing_and_raster_rows);
+    RUN_TEST(test_serial_bucket_paces_to_baud_rate);
+    RUN_TEST(test_sink_space_limits_each_write);
+    RUN_TEST(test_head_model_holds_output_when_printer_falls_behind);
+    RUN_TEST(test_clear_to_send_pauses_output);
+    RUN_TEST(test_busy_spooler_rejects_second_job_until_done);
+    RUN_TEST(test_stream_bytes_arrive_in_order);
+    return UNITY_END();
+}
@@ -0,0 +1,214 @@
+#include <unity.h>
+
+#include "printer_status.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace {
+
+// Answers DLE EOT n with the scripted byte for n; queries without a script
+// entry go unanswered, like a printer with its TX line disconnected.
+class ScriptedPrinterPort : public PrinterStatusMonitor::IPort {
+public:
+    size_t write(const uint8_t *data, size_t length) override {
+        written.insert(written.end(), data, data + length);
+        for (size_t i = 0; i + 2 < length; ++i) {
+            if (data[i] == PrinterStatusMonitor::DLE && data[i + 1] == PrinterStatusMonitor::EOT) {
+                ++queries[data[i + 2]];
+                auto reply = replies.find(data[i + 2]);
+                if (reply != replies.end()) {
+                    rx.push_back(reply->second);
+                }
+            }
+        }
+        return length;
+    }
+
+    int read() override {
+        if (rx.empty()) {
+            return -1;
+        }
+        const uint8_t value = rx.front();
+        rx.pop_front();
+        return value;
+    }
+
+    void healthy() {
+        replies[2] = 0x12;
+        replies[3] = 0x12;
+        replies[4] = 0x12;
+    }
+
+    std::map<uint8_t, uint8_t> replies;
+    std::map<uint8_t, int> queries;
+    std::deque<uint8_t> rx;
+    std::vector<uint8_t> written;
+};
+
+PrinterStatusMonitor::Config fastPoll() {
+    PrinterStatusMonitor::Config config;
+    config.pollIntervalMs = 1000;
+    config.responseTimeoutMs = 100;
+    config.missedLimit = 2;
+    return config;
+}
+
+// Steps the monitor in 10 ms ticks; returns true if any update reported a change.
+bool run(PrinterStatusMonitor &monitor, uint32_t fromMs, uint32_t toMs, bool lineIdle = true) {
+    bool changed = false;
+    for (uint32_t now = fromMs; now <= toMs; now += 10) {
+        changed = monitor.update(now, lineIdle) || changed;
+    }
+    return changed;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_healthy_printer_reports_ready(void) {
+    ScriptedPrinterPort port;
+    port.healthy();
+    PrinterStatusMonitor monitor(port, fastPoll());
+
+    TEST_ASSERT_TRUE(run(monitor, 0, 50));
+    const auto &status = monitor.status();
+    TEST_ASSERT_TRUE(status.known);
+    TEST_ASSERT_TRUE(status.responding);
+    TEST_ASSERT_FALSE(status.fault());
+    TEST_ASSERT_FALSE(status.paperNearEnd);
+
+    const uint8_t expected[] = {0x10, 0x04, 2, 0x10, 0x04, 3, 0x10, 0x04, 4};
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected), port.written.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected, port.written.data(), sizeof(expected));
+}
+
+static void test_poll_waits_for_interval_and_idle_line(void) {
+    ScriptedPrinterPort port;
+    port.healthy();
+    PrinterStatusMonitor monitor(port, fastPoll());
+
+    run(monitor, 0, 50);
+    TEST_ASSERT_EQUAL(1, port.queries[2]);
+    run(monitor, 60, 990);
+    TEST_ASSERT_EQUAL(1, port.queries[2]);
+
+    run(monitor, 1000, 3000, false);
+    TEST_ASSERT_EQUAL(1, port.queries[2]);
+    run(monitor, 3010, 3050);
+    TEST_ASSERT_EQUAL(2, port.queries[2]);
+}
+
+static void test_paper_out_and_near_end(void) {
+    ScriptedPrinterPort port;
+    port.healthy();
+    port.replies[4] = 0x12 | 0x0C;
+    PrinterStatusMonitor monitor(port, fastPoll());
+    run(monitor, 0, 50);
+    TEST_ASSERT_TRUE(monitor.status().paperNearEnd);
+    TEST_ASSERT_FALSE(monitor.status().fault());
+
+    port.replies[4] = 0x12 | 0x0C | 0x60;
+    TEST_ASSERT_TRUE(run(monitor, 1000, 1100));
+    TEST_ASSERT_TRUE(monitor.status().paperOut);
+    TEST_ASSERT_TRUE(monitor.status().fault());
+
+    // Paper reloaded
+    port.healthy();
+    TEST_ASSERT_TRUE(run(monitor, 2000, 2100));
+    TEST_ASSERT_FALSE(monitor.status().paperOut);
+    TEST_ASSERT_FALSE(monitor.status().paperNearEnd);
+}
+
+static void test_cover_open_and_overheat(void) {
+    ScriptedPrinterPort port;
+    port.healthy();
+    port.replies[2] = 0x12 | 0x04;
+    PrinterStatusMonitor monitor(port, fastPoll());
+    run(monitor, 0, 50);
+    TEST_ASSERT_TRUE(monitor.status().coverOpen);
+    TEST_ASSERT_FALSE(monitor.status().overheat);
+    TEST_ASSERT_TRUE(monitor.status().fault());
+
+    port.healthy();
+    port.replies[3] = 0x12 | 0x20;
+    run(monitor, 1000, 1100);
+    TEST_ASSERT_FALSE(monitor.status().coverOpen);
+    TEST_ASSERT_TRUE(monitor.status().overheat);
+    TEST_ASSERT_TRUE(monitor.status().fault());
+}
+
+static void test_silent_printer_is_unknown_not_faulty(void) {
+    ScriptedPrinterPort port;
+    PrinterStatusMonitor monitor(port, fastPoll());
+    TEST_ASSERT_FALSE(run(monitor, 0, 5000));
+    TEST_ASSERT_FALSE(monitor.status().known);
+    TEST_ASSERT_FALSE(monitor.status().fault());
+    TEST_ASSERT_TRUE(monitor.stats().timeouts > 0);
+}
+
+static void test_printer_that_stops_answering_goes_offline(void) {
+    ScriptedPrinterPort port;
+    port.healthy();
+    PrinterStatusMonitor monitor(port, fastPoll());
+    run(monitor, 0, 50);
+    TEST_ASSERT_FALSE(monitor.status().fault());
+
+    port.replies.clear();
+    run(monitor, 1000, 1150);
+    TEST_ASSERT_FALSE(monitor.status().offline());  // One miss is tolerated
+    TEST_ASSERT_TRUE(run(monitor, 1160, 2400));
+    TEST_ASSERT_TRUE(monitor.status().offline());
+    TEST_ASSERT_TRUE(monitor.status().fault());
+
+    port.healthy();
+    TEST_ASSERT_TRUE(run(monitor, 2410, 4000));
+    TEST_ASSERT_FALSE(monitor.status().offline());
+}
+
+static void test_stray_bytes_are_ignored(void) {
+    ScriptedPrinterPort port;
+    port.healthy();
+    PrinterStatusMonitor monitor(port, fastPoll());
+    port.rx.push_back(0xFF);  // Line noise before any query
+    monitor.update(0, true);
+    port.rx.push_front(0x13);  // Not a status byte (bit 0 set); the real reply follows
+    run(monitor, 10, 50);
+
+    TEST_ASSERT_TRUE(monitor.status().known);
+    TEST_ASSERT_FALSE(monitor.status().fault());
+    TEST_ASSERT_EQUAL_UINT32(2, monitor.stats().strayBytes);
+    TEST_ASSERT_EQUAL_UINT32(3, monitor.stats().replies);
+}
+
+static void test_poll_now_starts_a_fresh_cycle(void) {
+    ScriptedPrinterPort port;
+    port.healthy();
+    PrinterStatusMonitor monitor(port, fastPoll());
+    run(monitor, 0, 50);
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.stats().cycles);
+
+    // Paper runs out mid-job; the scheduled poll would only come at 1000 ms
+    port.replies[4] = 0x72;
+    monitor.pollNow(200);
+    TEST_ASSERT_TRUE(run(monitor, 200, 250));
+    TEST_ASSERT_EQUAL_UINT32(2, monitor.stats().cycles);
+    TEST_ASSERT_EQUAL(2, port.queries[2]);
+    TEST_ASSERT_TRUE(monitor.status().paperOut);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_healthy_printer_reports_ready);
+    RUN_TEST(test_poll_waits_for_interval_and_idle_line);
+    RUN_TEST(test_paper_out_and_near_end);
+    RUN_TEST(test_cover_open_and_overheat);
+    RUN_TEST(test_silent_printer_is_unknown_not_faulty);
+    RUN_TEST(test_printer_that_stops_answering_goes_offline);
+    RUN_TEST(test_stray_bytes_are_ignored);
+    RUN_TEST(test_poll_now_starts_a_fresh_cycle);
+    return UNITY_END();
+}
@@ -0,0 +1,334 @@
+#include <unity.h>
+
+#include "bitmap_font.h"
+#include "print_spooler.h"
+#include "raster_text.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct GlyphSpec {
+    uint16_t codepoint;
+    uint8_t advance;
+    uint8_t width;
+    uint8_t height;
+    int8_t xOffset;
+    uint8_t yOffset;
+    std::vector<uint8_t> rows;  // One byte per row (width <= 8)
+};
+
+struct KernSpec {
+    uint16_t left;
+    uint16_t right;
+    int8_t adjust;
+};
+
+void put16(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value & 0xFF));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t> &out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value & 0xFFFF));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+std::vector<uint8_t> buildFont(uint8_t lineHeight,
+                               const std::vector<GlyphSpec> &glyphs,
+                               const std::vector<KernSpec> &kerns) {
+    std::vector<uint8_t> out = {'D', 'F', 'N', 'T', BitmapFont::VERSION, lineHeight, lineHeight, 0};
+    put16(out, static_cast<uint16_t>(glyphs.size()));
+    put16(out, static_cast<uint16_t>(kerns.size()));
+    put32(out, 0);
+
+    uint32_t bitmapOffset = 0;
+    for (const auto &g : glyphs) {
+        put16(out, g.codepoint);
+        out.push_back(g.advance);
+        out.push_back(g.width);
+        out.push_back(g.height);
+        out.push_back(static_cast<uint8_t>(g.xOffset));
+        out.push_back(g.yOffset);
+        out.push_back(0);
+        put32(out, bitmapOffset);
+        bitmapOffset += static_cast<uint32_t>(g.rows.size());
+    }
+    for (const auto &k : kerns) {
+        put16(out, k.left);
+        put16(out, k.right);
+        out.push_back(static_cast<uint8_t>(k.adjust));
+        out.push_back(0);
+    }
+    for (const auto &g : glyphs) {
+        out.insert(out.end(), g.rows.begin(), g.rows.end());
+    }
+    return out;
+}
+
+// 6-dot line; A is a solid 4x4 block, V a 4x4 vee, kerned together by -2.
+std::vector<uint8_t> testFont() {
+    return buildFont(6,
+                     {
+                         {' ', 3, 0, 0, 0, 0, {}},
+                         {'?', 4, 3, 4, 0, 1, {0xE0, 0x20, 0x40, 0x40}},
+                         {'A', 5, 4, 4, 0, 1, {0xF0, 0xF0, 0xF0, 0xF0}},
+                         {'V', 5, 4, 4, 0, 1, {0x90, 0x90, 0x60, 0x60}},
+                         {'i', 2, 1, 4, 0, 1, {0x80, 0x80, 0x80, 0x80}},
+                     },
+                     {{'A', 'V', -2}, {'V', 'A', -2}});
+}
+
+struct CountingReader {
+    explicit CountingReader(const std::vector<uint8_t> &data) : data(data) {}
+
+    BitmapFont::ReadAt fn() {
+        return [this](uint32_t offset, uint8_t *out, size_t length) -> size_t {
+            ++reads;
+            if (offset >= data.size()) {
+                return 0;
+            }
+            const size_t count = std::min(length, data.size() - offset);
+            std::memcpy(out, data.data() + offset, count);
+            return count;
+        };
+    }
+
+    const std::vector<uint8_t> &data;
+    int reads = 0;
+};
+
+std::vector<std::string> texts(const std::vector<TextLine> &lines) {
+    std::vector<std::string> out;
+    for (const auto &line : lines) {
+        out.push_back(line.text);
+    }
+    return out;
+}
+
+class NullSink : public PrintSpooler::IByteSink {
+public:
+    size_t availableForWrite() override { return 128; }
+    size_t write(const uint8_t *, size_t length) override {
+        total += length;
+        return length;
+    }
+    size_t total = 0;
+};
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_font_loads_metrics_and_kerning(void) {
+    const auto data = testFont();
+    CountingReader reader(data);
+    BitmapFont font;
+    TEST_ASSERT_TRUE(font.load(reader.fn()));
+
+    TEST_ASSERT_EQUAL_UINT8(6, font.lineHeight());
+    TEST_ASSERT_EQUAL_UINT32(5, font.glyphCount());
+    TEST_ASSERT_EQUAL_INT(-2, font.kerning('A', 'V'));
+    TEST_ASSERT_EQUAL_INT(0, font.kerning('A', 'A'));
+    TEST_ASSERT_EQUAL_INT(8, font.measure("AV", 2));
+    TEST_ASSERT_EQUAL_INT(10, font.measure("AA", 2));
+    TEST_ASSERT_EQUAL_INT(13, font.measure("A A", 3));
+    // Unknown glyphs render as '?'
+    TEST_ASSERT_EQUAL_UINT16('?', font.glyph('Z')->codepoint);
+}
+
+static void test_font_rejects_bad_files(void) {
+    auto data = testFont();
+    BitmapFont font;
+
+    auto badMagic = data;
+    badMagic[0] = 'X';
+    CountingReader magicReader(badMagic);
+    TEST_ASSERT_FALSE(font.load(magicReader.fn()));
+
+    auto badVersion = data;
+    badVersion[4] = 9;
+    CountingReader versionReader(badVersion);
+    TEST_ASSERT_FALSE(font.load(versionReader.fn()));
+
+    const std::vector<uint8_t> truncated(data.begin(), data.begin() + 30);
+    CountingReader truncatedReader(truncated);
+    TEST_ASSERT_FALSE(font.load(truncatedReader.fn()));
+    TEST_ASSERT_FALSE(font.isLoaded());
+}
+
+static void test_glyph_bitmaps_are_read_once_and_cached(void) {
+    const auto data = testFont();
+    CountingReader reader(data);
+    BitmapFont font;
+    TEST_ASSERT_TRUE(font.load(reader.fn(), 8));  // Room for two 4-byte glyphs
+    const int loadReads = reader.reads;
+
+    const BitmapFont::Glyph *a = font.glyph('A');
+    const uint8_t *bits = font.bitmap(*a);
+    TEST_ASSERT_NOT_NULL(bits);
+    TEST_ASSERT_EQUAL_HEX8(0xF0, bits[0]);
+    font.bitmap(*a);
+    font.bitmap(*a);
+    TEST_ASSERT_EQUAL_INT(loadReads + 1, reader.reads);
+    TEST_ASSERT_EQUAL_UINT32(2, font.cacheStats().hits);
+    TEST_ASSERT_EQUAL_UINT32(1, font.cacheStats().misses);
+
+    font.bitmap(*font.glyph('V'));
+    font.bitmap(*font.glyph('i'));  // Over budget: cache flushed
+    TEST_ASSERT_EQUAL_UINT32(2, font.cacheStats().evictions);
+    TEST_ASSERT_TRUE(font.cacheStats().bytes <= 8);
+}
+
+static void test_preloaded_glyphs_need_no_reads(void) {
+    const auto data = testFont();
+    CountingReader reader(data);
+    BitmapFont font;
+    TEST_ASSERT_TRUE(font.load(reader.fn(), 8));
+    TEST_ASSERT_FALSE(font.preload('A', 'V', 11));  // 'A', 'V' and fallback '?' need 12 bytes
+    TEST_ASSERT_EQUAL_UINT32(0, font.cacheStats().preloadedBytes);
+
+    TEST_ASSERT_TRUE(font.preload('A', 'V', 12));
+    TEST_ASSERT_EQUAL_UINT32(12, font.cacheStats().preloadedBytes);
+    const int preloadReads = reader.reads;
+    for (uint16_t cp : {'A', 'V', 'Z'}) {  // 'Z' falls back to '?'
+        TEST_ASSERT_NOT_NULL(font.bitmap(*font.glyph(cp)));
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x90, font.bitmap(*font.glyph('V'))[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xE0, font.bitmap(*font.glyph('Z'))[0]);
+    TEST_ASSERT_EQUAL_INT(preloadReads, reader.reads);
+    TEST_ASSERT_EQUAL_UINT32(0, font.cacheStats().misses);
+
+    // Glyphs outside the range still load on first use
+    TEST_ASSERT_EQUAL_HEX8(0x80, font.bitmap(*font.glyph('i'))[0]);
+    TEST_ASSERT_EQUAL_INT(preloadReads + 1, reader.reads);
+}
+
+static void test_wrap_by_pixel_width(void) {
+    const auto data = testFont();
+    CountingReader reader(data);
+    BitmapFont font;
+    TEST_ASSERT_TRUE(font.load(reader.fn()));
+
+    std::vector<TextLine> lines;
+    const char *text = "AA AA AA";
+    wrapText(font, text, strlen(text), 24, lines);
+    TEST_ASSERT_EQUAL_UINT32(2, lines.size());
+    TEST_ASSERT_EQUAL_STRING("AA AA", lines[0].text.c_str());
+    TEST_ASSERT_EQUAL_UINT16(23, lines[0].widthPx);
+    TEST_ASSERT_EQUAL_STRING("AA", lines[1].text.c_str());
+
+    // Kerning lets "AVAV" fit where four unkerned glyphs would not
+    lines.clear();
+    wrapText(font, "AVAV", 4, 14, lines);
+    TEST_ASSERT_EQUAL_UINT32(1, lines.size());
+    TEST_ASSERT_EQUAL_UINT16(14, lines[0].widthPx);
+
+    lines.clear();
+    const char *paragraphs = "Ai\n\nAAAAAA";
+    wrapText(font, paragraphs, strlen(paragraphs), 16, lines);
+    const auto wrapped = texts(lines);
+    TEST_ASSERT_EQUAL_UINT32(4, wrapped.size());
+    TEST_ASSERT_EQUAL_STRING("Ai", wrapped[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("", wrapped[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("AAA", wrapped[2].c_str());  // Long word broken
+    TEST_ASSERT_EQUAL_STRING("AAA", wrapped[3].c_str());
+}
+
+static void test_text_band_golden(void) {
+    const auto data = testFont();
+    CountingReader reader(data);
+    BitmapFont font;
+    TEST_ASSERT_TRUE(font.load(reader.fn()));
+
+    RasterComposer composer(font, 16);
+    TEST_ASSERT_EQUAL_UINT32(1, composer.addText("AV", 2, TextAlign::Centre));
+
+    PrintStream stream;
+    TEST_ASSERT_TRUE(composer.nextBand(stream));
+    // "AV" is 8 dots wide, centred at x=4; V starts at 4 + 5 - 2 = 7
+    const uint8_t golden[] = {0x1D, 'v', '0', 0, 2, 0, 6, 0,
+                              0x00, 0x00,
+                              0x0F, 0x20,
+                              0x0F, 0x20,
+                              0x0F, 0xC0,
+                              0x0F, 0xC0,
+                              0x00, 0x00};
+    TEST_ASSERT_EQUAL_UINT32(sizeof(golden), stream.bytes.size());
+    TEST_ASSERT_EQUAL_MEMORY(golden, stream.bytes.data(), sizeof(golden));
+    TEST_ASSERT_EQUAL_UINT32(6, stream.totalDotLines());
+
+    PrintStream end;
+    TEST_ASSERT_FALSE(composer.nextBand(end));
+    TEST_ASSERT_TRUE(end.empty());
+}
+
+static void test_spooler_streams_logo_and_text_band_by_band(void) {
+    const auto data = testFont();
+    CountingReader reader(data);
+    BitmapFont font;
+    TEST_ASSERT_TRUE(font.load(reader.fn()));
+
+    const std::vector<uint8_t> logo = {0x1D, 'v', '0', 0, 48, 0, 2, 0};
+    std::vector<uint8_t> logoBlock = logo;
+    logoBlock.resize(8 + 48 * 2, 0xFF);
+
+    auto composer = std::unique_ptr<RasterComposer>(new RasterComposer(font));
+    composer->addRaster(&logoBlock);
+    composer->addBlankLines(1);
+    std::string fortune;
+    for (int i = 0; i < 400; ++i) {
+        fortune += "AV ";
+    }
+    const size_t lines = composer->addText(fortune.c_str(), fortune.size(), TextAlign::Left);
+    TEST_ASSERT_TRUE(lines > 1);
+    composer->addBlankDots(300);  // Split into two ESC J commands
+
+    const size_t expectedBytes = composer->totalBytes();
+    const uint32_t expectedDots = composer->totalDotLines();
+    TEST_ASSERT_EQUAL_UINT32(2 + 6 + lines * 6 + 300, expectedDots);
+
+    NullSink sink;
+    PrintSpooler spooler(sink);
+    PrintSpooler::Timing timing;
+    timing.baud = 115200;
+    timing.headDotLinesPerSec = 0;
+    timing.burstBytes = 512;
+    spooler.setTiming(timing);
+
+    PrintStream prelude;
+    EscPosWriter(prelude).initialize();
+    const size_t preludeBytes = prelude.bytes.size();
+    TEST_ASSERT_TRUE(spooler.load(std::move(prelude), std::move(composer)));
+
+    size_t peakBuffered = 0;
+    uint32_t now = 0;
+    while (spooler.isBusy() && now < 10000000) {
+        spooler.pump(now);
+        peakBuffered = std::max(peakBuffered, spooler.bytesRemaining());
+        now += 1000;
+    }
+    TEST_ASSERT_FALSE(spooler.isBusy());
+    TEST_ASSERT_EQUAL_UINT32(preludeBytes + expectedBytes, sink.total);
+    TEST_ASSERT_EQUAL_UINT32(preludeBytes + expectedBytes, spooler.stats().lastJobBytes);
+    // Never more than one band buffered at once
+    const size_t textBand = 8 + 48 * 6;
+    TEST_ASSERT_TRUE(peakBuffered <= std::max(logoBlock.size(), textBand));
+    TEST_ASSERT_TRUE(peakBuffered < expectedBytes / 4);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_font_loads_metrics_and_kerning);
+    RUN_TEST(test_font_rejects_bad_files);
+    RUN_TEST(test_glyph_bitmaps_are_read_once_and_cached);
+    RUN_TEST(test_preloaded_glyphs_need_no_reads);
+    RUN_TEST(test_wrap_by_pixel_width);
+    RUN_TEST(test_text_band_golden);
+    RUN_TEST(test_spooler_streams_logo_and_text_band_by_band);
+    return UNITY_END();
+}
@@ -0,0 +1,263 @@
+#include <unity.h>
+
+#include "fake_filesystem.h"
+#include "sd_log_writer.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Counts writes so tests can see how the card was used
+class CountingFileSystem : public FakeFileSystem {
+public:
+    std::unique_ptr<infra::IFile> open(const char *path, const char *mode) override {
+        if (failOpens) {
+            return nullptr;
+        }
+        std::unique_ptr<infra::IFile> inner = FakeFileSystem::open(path, mode);
+        if (!inner) {
+            return nullptr;
+        }
+        return std::unique_ptr<infra::IFile>(new CountingFile(std::move(inner), *this));
+    }
+
+    std::vector<size_t> writes;
+    bool failOpens = false;
+    bool failWrites = false;
+
+private:
+    class CountingFile : public infra::IFile {
+    public:
+        CountingFile(std::unique_ptr<infra::IFile> inner, CountingFileSystem &owner)
+            : m_inner(std::move(inner)), m_owner(owner) {}
+
+        bool available() override { return m_inner->available(); }
+        String readString() override { return m_inner->readString(); }
+        String readStringUntil(char delimiter) override { return m_inner->readStringUntil(delimiter); }
+        size_t read(uint8_t *buffer, size_t length) override { return m_inner->read(buffer, length); }
+        size_t size() override { return m_inner->size(); }
+        size_t write(const uint8_t *buffer, size_t length) override {
+            if (m_owner.failWrites) {
+                return 0;
+            }
+            m_owner.writes.push_back(length);
+            return m_inner->write(buffer, length);
+        }
+        void close() override { m_inner->close(); }
+
+    private:
+        std::unique_ptr<infra::IFile> m_inner;
+        CountingFileSystem &m_owner;
+    };
+};
+
+SdLogWriter::Settings smallSettings() {
+    SdLogWriter::Settings settings;
+    settings.directory = "/logs";
+    settings.maxFileBytes = 2 * SdLogWriter::BLOCK_BYTES;
+    settings.maxFiles = 3;
+    settings.maxBlockAgeMs = 1000;
+    return settings;
+}
+
+// Appends numbered 63-character lines (64 bytes with the newline)
+void appendLines(SdLogWriter &writer, int count, uint32_t nowMs, int first = 0) {
+    char line[64];
+    for (int i = 0; i < count; ++i) {
+        snprintf(line, sizeof(line), "%06d ", first + i);
+        memset(line + 7, 'x', sizeof(line) - 8);
+        line[sizeof(line) - 1] = '\0';
+        TEST_ASSERT_TRUE(writer.append(line, strlen(line), nowMs));
+    }
+}
+
+size_t fileSize(const CountingFileSystem &fs, const char *path) {
+    const std::string *content = fs.contents(path);
+    return content ? content->size() : 0;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_lines_wait_for_a_full_block(void) {
+    CountingFileSystem fs;
+    SdLogWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(&fs, smallSettings()));
+
+    appendLines(writer, 10, 0);
+    TEST_ASSERT_FALSE(writer.blockDue(10));
+    TEST_ASSERT_FALSE(writer.service(10, true));
+    TEST_ASSERT_EQUAL(0, fs.writes.size());
+
+    appendLines(writer, 54, 10, 10);  // 64 lines x 64 bytes = one block
+    TEST_ASSERT_TRUE(writer.blockDue(20));
+    TEST_ASSERT_TRUE(writer.service(20, true));
+    TEST_ASSERT_EQUAL(1, fs.writes.size());
+    TEST_ASSERT_EQUAL(SdLogWriter::BLOCK_BYTES, fs.writes[0]);
+    TEST_ASSERT_EQUAL(0, writer.buffered());
+
+    const std::string *content = fs.contents("/logs/log0.txt");
+    TEST_ASSERT_NOT_NULL(content);
+    TEST_ASSERT_EQUAL(0, content->find("000000 xxx"));
+    TEST_ASSERT_EQUAL('\n', content->back());
+}
+
+static void test_due_block_waits_for_the_bus(void) {
+    CountingFileSystem fs;
+    SdLogWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(&fs, smallSettings()));
+    appendLines(writer, 64, 0);
+
+    TEST_ASSERT_FALSE(writer.service(5, false));
+    TEST_ASSERT_FALSE(writer.service(6, false));
+    TEST_ASSERT_EQUAL(0, fs.writes.size());
+    TEST_ASSERT_EQUAL(1, writer.stats().deferrals);
+
+    TEST_ASSERT_TRUE(writer.service(7, true));
+    TEST_ASSERT_EQUAL(1, fs.writes.size());
+}
+
+static void test_stale_partial_block_is_written_and_realigned(void) {
+    CountingFileSystem fs;
+    SdLogWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(&fs, smallSettings()));
+
+    appendLines(writer, 3, 100);
+    TEST_ASSERT_FALSE(writer.service(1099, true));
+    TEST_ASSERT_TRUE(writer.service(1100, true));
+    TEST_ASSERT_EQUAL(3 * 64, fs.writes[0]);
+
+    // The next write only tops the file up to the 4 KB boundary
+    appendLines(writer, 64, 2000, 3);
+    TEST_ASSERT_TRUE(writer.service(2000, true));
+    TEST_ASSERT_EQUAL(SdLogWriter::BLOCK_BYTES - 3 * 64, fs.writes[1]);
+    TEST_ASSERT_EQUAL(SdLogWriter::BLOCK_BYTES, writer.fileBytes());
+    TEST_ASSERT_EQUAL(3 * 64, writer.buffered());
+}
+
+static void test_full_buffer_drops_lines(void) {
+    CountingFileSystem fs;
+    SdLogWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(&fs, smallSettings()));
+    appendLines(writer, 64, 0);
+
+    TEST_ASSERT_FALSE(writer.hasRoom());
+    TEST_ASSERT_FALSE(writer.append("late", 4, 0));
+    TEST_ASSERT_EQUAL(1, writer.stats().droppedLines);
+}
+
+static void test_long_line_is_clipped(void) {
+    CountingFileSystem fs;
+    SdLogWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(&fs, smallSettings()));
+    std::string line(SdLogWriter::MAX_LINE_BYTES * 2, 'y');
+    TEST_ASSERT_TRUE(writer.append(line.c_str(), line.size(), 0));
+    TEST_ASSERT_EQUAL(SdLogWriter::MAX_LINE_BYTES, writer.buffered());
+}
+
+static void test_files_rotate_by_size_and_count(void) {
+    CountingFileSystem fs;
+    SdLogWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(&fs, smallSettings()));
+
+    // Two blocks fill a file; write four files' worth
+    for (int block = 0; block < 8; ++block) {
+        appendLines(writer, 64, 0, block * 64);
+        TEST_ASSERT_TRUE(writer.service(0, true));
+    }
+
+    TEST_ASSERT_EQUAL(4, writer.stats().rotations);
+    TEST_ASSERT_EQUAL(0, fileSize(fs, "/logs/log0.txt"));
+    TEST_ASSERT_EQUAL(2 * SdLogWriter::BLOCK_BYTES, fileSize(fs, "/logs/log1.txt"));
+    TEST_ASSERT_EQUAL(2 * SdLogWriter::BLOCK_BYTES, fileSize(fs, "/logs/log2.txt"));
+    TEST_ASSERT_FALSE(fs.exists("/logs/log3.txt"));
+    // log1 holds the newest lines (blocks 6 and 7)
+    TEST_ASSERT_EQUAL(0, fs.contents("/logs/log1.txt")->find("000384 "));
+    TEST_ASSERT_EQUAL(0, fs.contents("/logs/log2.txt")->find("000256 "));
+}
+
+static void test_appends_to_existing_file_on_begin(void) {
+    CountingFileSystem fs;
+    fs.addFile("/logs/log0.txt", std::string(100, 'o'));
+    SdLogWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(&fs, smallSettings()));
+    TEST_ASSERT_EQUAL(100, writer.fileBytes());
+
+    appendLines(writer, 64, 0);
+    TEST_ASSERT_TRUE(writer.service(0, true));
+    TEST_ASSERT_EQUAL(SdLogWriter::BLOCK_BYTES - 100, fs.writes[0]);
+    TEST_ASSERT_EQUAL(0, fs.contents("/logs/log0.txt")->find(std::string(100, 'o') + "000000"));
+}
+
+static void test_failed_write_drops_block_and_recovers(void) {
+    CountingFileSystem fs;
+    SdLogWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(&fs, smallSettings()));
+    appendLines(writer, 64, 0);
+
+    fs.failWrites = true;
+    TEST_ASSERT_FALSE(writer.service(0, true));
+    TEST_ASSERT_EQUAL(1, writer.stats().failedWrites);
+    TEST_ASSERT_EQUAL(SdLogWriter::BLOCK_BYTES, writer.stats().lostBytes);
+    TEST_ASSERT_TRUE(writer.hasRoom());
+
+    fs.failWrites = false;
+    appendLines(writer, 64, 0, 64);
+    TEST_ASSERT_TRUE(writer.service(0, true));
+    TEST_ASSERT_EQUAL(0, fs.contents("/logs/log0.txt")->find("000064 "));
+}
+
+static void test_flush_and_end_write_everything(void) {
+    CountingFileSystem fs;
+    SdLogWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(&fs, smallSettings()));
+    appendLines(writer, 60, 0);
+    TEST_ASSERT_TRUE(writer.flush());
+    TEST_ASSERT_EQUAL(60 * 64, fileSize(fs, "/logs/log0.txt"));
+
+    appendLines(writer, 10, 0, 60);
+    writer.end();
+    TEST_ASSERT_FALSE(writer.isActive());
+    TEST_ASSERT_EQUAL(70 * 64, fileSize(fs, "/logs/log0.txt"));
+    // The second flush tops up to the block boundary first
+    TEST_ASSERT_EQUAL(3, fs.writes.size());
+    TEST_ASSERT_EQUAL(4 * 64, fs.writes[1]);
+}
+
+static void test_begin_rejects_bad_setup(void) {
+    CountingFileSystem fs;
+    SdLogWriter writer;
+    SdLogWriter::Settings settings = smallSettings();
+    settings.directory = "logs";
+    TEST_ASSERT_FALSE(writer.begin(&fs, settings));
+    TEST_ASSERT_FALSE(writer.begin(nullptr, smallSettings()));
+
+    fs.failOpens = true;
+    TEST_ASSERT_FALSE(writer.begin(&fs, smallSettings()));
+    TEST_ASSERT_FALSE(writer.isActive());
+    TEST_ASSERT_FALSE(writer.append("x", 1, 0));
+
+    fs.failOpens = false;
+    settings.directory = "/";
+    TEST_ASSERT_TRUE(writer.begin(&fs, settings));
+    TEST_ASSERT_TRUE(fs.exists("/log0.txt"));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lines_wait_for_a_full_block);
+    RUN_TEST(test_due_block_waits_for_the_bus);
+    RUN_TEST(test_stale_partial_block_is_written_and_realigned);
+    RUN_TEST(test_full_buffer_drops_lines);
+    RUN_TEST(test_long_line_is_clipped);
+    RUN_TEST(test_files_rotate_by_size_and_count);
+    RUN_TEST(test_appends_to_existing_file_on_begin);
+    RUN_TEST(test_failed_write_drops_block_and_recovers);
+    RUN_TEST(test_flush_and_end_write_everything);
+    RUN_TEST(test_begin_rejects_bad_setup);
+    return UNITY_END();
+}
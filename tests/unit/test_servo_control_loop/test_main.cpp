@@ -0,0 +1,154 @@
+#include <unity.h>
+
+#include "servo_control_loop.h"
+#include "manual_periodic_timer.h"
+
+#include <vector>
+
+namespace {
+
+using Keyframe = ServoControlLoop::Keyframe;
+
+struct WriteLog {
+    std::vector<int> degrees;
+};
+
+void recordWrite(void *context, int degrees) {
+    static_cast<WriteLog *>(context)->degrees.push_back(degrees);
+}
+
+Keyframe linear(int target, uint32_t durationMs) {
+    Keyframe frame;
+    frame.targetDegrees = target;
+    frame.durationMs = durationMs;
+    frame.easing = ServoMotionPlanner::Easing::Linear;
+    return frame;
+}
+
+struct LoopFixture {
+    ManualPeriodicTimer timer;
+    ServoControlLoop loop{&timer};
+    WriteLog writes;
+
+    LoopFixture() {
+        loop.configure(0, 80, 0.0f, 0.0f);
+        loop.start(ServoControlLoop::DEFAULT_RATE_HZ, recordWrite, &writes, 0);
+    }
+};
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_start_runs_timer_at_requested_rate(void) {
+    LoopFixture fx;
+    TEST_ASSERT_TRUE(fx.loop.isRunning());
+    TEST_ASSERT_EQUAL_UINT32(10000, fx.timer.period);
+
+    fx.timer.advanceMillis(1000);
+    TEST_ASSERT_EQUAL_UINT32(100, fx.loop.stats().ticks);
+    TEST_ASSERT_TRUE(fx.writes.degrees.empty());  // Nothing changed, nothing written
+
+    fx.loop.stop();
+    fx.timer.advanceMillis(100);
+    TEST_ASSERT_FALSE(fx.loop.isRunning());
+    TEST_ASSERT_EQUAL_UINT32(100, fx.loop.stats().ticks);
+}
+
+static void test_mailbox_keeps_latest_target_per_tick(void) {
+    LoopFixture fx;
+    fx.loop.postTarget(10);
+    fx.loop.postTarget(20);
+    fx.loop.postTarget(30);
+    fx.timer.advanceMillis(10);
+
+    TEST_ASSERT_EQUAL_UINT32(1, fx.writes.degrees.size());
+    TEST_ASSERT_EQUAL_INT(30, fx.writes.degrees.back());
+    TEST_ASSERT_EQUAL_INT(30, fx.loop.lastWritten());
+    const auto stats = fx.loop.stats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.directTargets);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.coalescedTargets);
+}
+
+static void test_repeated_targets_skip_redundant_writes(void) {
+    LoopFixture fx;
+    for (int i = 0; i < 50; ++i) {
+        fx.loop.postTarget(25);
+        fx.timer.advanceMillis(10);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, fx.writes.degrees.size());
+    TEST_ASSERT_EQUAL_UINT32(50, fx.loop.stats().directTargets);
+    TEST_ASSERT_EQUAL_UINT32(1, fx.loop.stats().writes);
+}
+
+static void test_planned_move_advances_on_timer_ticks(void) {
+    LoopFixture fx;
+    TEST_ASSERT_TRUE(fx.loop.moveTo(linear(40, 400)));
+    TEST_ASSERT_TRUE(fx.loop.isMoving());  // Visible before the first tick
+
+    fx.timer.advanceMillis(10);   // Command applied at t=10ms
+    fx.timer.advanceMillis(200);
+    TEST_ASSERT_EQUAL_INT(20, fx.loop.lastWritten());
+    TEST_ASSERT_TRUE(fx.loop.isMoving());
+
+    fx.timer.advanceMillis(200);
+    TEST_ASSERT_EQUAL_INT(40, fx.loop.lastWritten());
+    TEST_ASSERT_FALSE(fx.loop.isMoving());
+    TEST_ASSERT_EQUAL_UINT32(40, fx.writes.degrees.size());  // One write per whole degree
+}
+
+static void test_direct_target_preempts_planned_motion(void) {
+    LoopFixture fx;
+    fx.loop.moveTo(linear(80, 1000));
+    fx.loop.enqueue(linear(0, 1000));
+    fx.timer.advanceMillis(300);
+    TEST_ASSERT_TRUE(fx.loop.isMoving());
+
+    fx.loop.postTarget(5);
+    fx.timer.advanceMillis(10);
+    TEST_ASSERT_EQUAL_INT(5, fx.loop.lastWritten());
+    TEST_ASSERT_FALSE(fx.loop.isMoving());
+
+    fx.timer.advanceMillis(500);
+    TEST_ASSERT_EQUAL_INT(5, fx.loop.lastWritten());
+}
+
+static void test_command_ring_is_bounded(void) {
+    ManualPeriodicTimer timer;
+    ServoControlLoop loop(&timer);
+    for (size_t i = 0; i < ServoControlLoop::COMMAND_CAPACITY; ++i) {
+        TEST_ASSERT_TRUE(loop.enqueue(linear(10, 100)));
+    }
+    TEST_ASSERT_FALSE(loop.enqueue(linear(10, 100)));
+    TEST_ASSERT_EQUAL_UINT32(1, loop.stats().droppedCommands);
+}
+
+static void test_step_fallback_when_timer_fails(void) {
+    ManualPeriodicTimer timer;
+    timer.failStart = true;
+    ServoControlLoop loop(&timer);
+    WriteLog writes;
+    loop.configure(0, 80, 0.0f, 0.0f);
+    TEST_ASSERT_FALSE(loop.start(ServoControlLoop::DEFAULT_RATE_HZ, recordWrite, &writes, 0));
+    TEST_ASSERT_FALSE(loop.isRunning());
+
+    loop.moveTo(linear(30, 300));
+    loop.step(1000);
+    loop.step(1150);
+    TEST_ASSERT_EQUAL_INT(15, loop.lastWritten());
+    loop.step(1300);
+    TEST_ASSERT_EQUAL_INT(30, loop.lastWritten());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_start_runs_timer_at_requested_rate);
+    RUN_TEST(test_mailbox_keeps_latest_target_per_tick);
+    RUN_TEST(test_repeated_targets_skip_redundant_writes);
+    RUN_TEST(test_planned_move_advances_on_timer_ticks);
+    RUN_TEST(test_direct_target_preempts_planned_motion);
+    RUN_TEST(test_command_ring_is_bounded);
+    RUN_TEST(test_step_fallback_when_timer_fails);
+    return UNITY_END();
+}
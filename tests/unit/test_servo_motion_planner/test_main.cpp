@@ -0,0 +1,197 @@
+#include <unity.h>
+
+#include "servo_motion_planner.h"
+
+#include <cmath>
+
+namespace {
+
+using Easing = ServoMotionPlanner::Easing;
+using Keyframe = ServoMotionPlanner::Keyframe;
+
+Keyframe keyframe(int target, uint32_t durationMs, Easing easing = Easing::Linear, uint32_t holdMs = 0) {
+    Keyframe frame;
+    frame.targetDegrees = target;
+    frame.durationMs = durationMs;
+    frame.easing = easing;
+    frame.holdMs = holdMs;
+    return frame;
+}
+
+// Steps the planner at a fixed tick and returns the time the queue drained.
+uint32_t runUntilIdle(ServoMotionPlanner &planner, uint32_t startMs, uint32_t stepMs, uint32_t limitMs) {
+    uint32_t now = startMs;
+    while (planner.isMoving() && now - startMs < limitMs) {
+        now += stepMs;
+        planner.update(now);
+    }
+    return now;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_easing_curves_hit_endpoints(void) {
+    const Easing curves[] = {Easing::Linear, Easing::EaseIn, Easing::EaseOut, Easing::EaseInOut};
+    for (Easing easing : curves) {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0f, ServoMotionPlanner::ease(easing, 0.0f));
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0f, ServoMotionPlanner::ease(easing, 1.0f));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.25f, ServoMotionPlanner::ease(Easing::EaseIn, 0.5f));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.75f, ServoMotionPlanner::ease(Easing::EaseOut, 0.5f));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.5f, ServoMotionPlanner::ease(Easing::EaseInOut, 0.5f));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0f, ServoMotionPlanner::ease(Easing::Linear, 2.0f));
+}
+
+static void test_linear_move_tracks_time_without_blocking(void) {
+    ServoMotionPlanner planner;
+    planner.setBounds(0, 80);
+    planner.reset(0);
+    planner.moveTo(keyframe(40, 1000), 0);
+
+    TEST_ASSERT_TRUE(planner.update(500));
+    TEST_ASSERT_EQUAL_INT(20, planner.position());
+    TEST_ASSERT_TRUE(planner.isMoving());
+
+    planner.update(1000);
+    TEST_ASSERT_EQUAL_INT(40, planner.position());
+    TEST_ASSERT_FALSE(planner.isMoving());
+    TEST_ASSERT_FALSE(planner.update(1020));
+}
+
+static void test_queued_keyframes_run_in_order_with_hold(void) {
+    ServoMotionPlanner planner;
+    planner.setBounds(0, 80);
+    planner.reset(0);
+    TEST_ASSERT_TRUE(planner.enqueue(keyframe(30, 200, Easing::EaseInOut, 100)));
+    TEST_ASSERT_TRUE(planner.enqueue(keyframe(0, 200, Easing::EaseInOut)));
+    TEST_ASSERT_EQUAL_UINT32(2, planner.queued());
+
+    planner.update(0);
+    planner.update(200);
+    TEST_ASSERT_EQUAL_INT(30, planner.position());
+    planner.update(250);
+    TEST_ASSERT_EQUAL_INT(30, planner.position());  // Holding
+
+    planner.update(300);  // Hold done, closing segment starts
+    TEST_ASSERT_EQUAL_UINT32(0, planner.queued());
+    planner.update(400);
+    TEST_ASSERT_EQUAL_INT(15, planner.position());
+    planner.update(500);
+    TEST_ASSERT_EQUAL_INT(0, planner.position());
+    TEST_ASSERT_FALSE(planner.isMoving());
+}
+
+static void test_queue_is_bounded(void) {
+    ServoMotionPlanner planner;
+    for (size_t i = 0; i < ServoMotionPlanner::MAX_KEYFRAMES; ++i) {
+        TEST_ASSERT_TRUE(planner.enqueue(keyframe(10, 100)));
+    }
+    TEST_ASSERT_FALSE(planner.enqueue(keyframe(10, 100)));
+}
+
+static void test_preemption_drops_queue_and_continues_from_current_position(void) {
+    ServoMotionPlanner planner;
+    planner.setBounds(0, 80);
+    planner.reset(0);
+    planner.moveTo(keyframe(80, 1000), 0);
+    planner.enqueue(keyframe(0, 1000));
+    planner.update(500);
+    TEST_ASSERT_EQUAL_INT(40, planner.position());
+
+    planner.moveTo(keyframe(20, 200), 500);
+    TEST_ASSERT_EQUAL_UINT32(0, planner.queued());
+    planner.update(510);
+    TEST_ASSERT_INT_WITHIN(2, 39, planner.position());  // No jump at the handover
+    planner.update(700);
+    TEST_ASSERT_EQUAL_INT(20, planner.position());
+    TEST_ASSERT_FALSE(planner.isMoving());
+}
+
+static void test_velocity_limit_caps_each_step(void) {
+    ServoMotionPlanner planner;
+    planner.setBounds(0, 80);
+    planner.setLimits(100.0f, 0.0f);
+    planner.reset(0);
+    planner.moveTo(keyframe(80, 0), 0);  // Asks for an instant jump
+
+    float previous = 0.0f;
+    for (uint32_t now = 10; now <= 200; now += 10) {
+        planner.update(now);
+        const float step = planner.positionExact() - previous;
+        TEST_ASSERT_TRUE(step <= 1.0f + 0.001f);
+        previous = planner.positionExact();
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, planner.positionExact());
+
+    const uint32_t done = runUntilIdle(planner, 200, 10, 5000);
+    TEST_ASSERT_EQUAL_INT(80, planner.position());
+    TEST_ASSERT_UINT32_WITHIN(20, 800, done);
+}
+
+static void test_acceleration_limit_ramps_and_stops_without_overshoot(void) {
+    ServoMotionPlanner planner;
+    planner.setBounds(0, 180);
+    planner.setLimits(400.0f, 2000.0f);
+    planner.reset(0);
+    planner.moveTo(keyframe(60, 0), 0);
+
+    float previousVelocity = 0.0f;
+    float peak = 0.0f;
+    uint32_t now = 0;
+    while (planner.isMoving() && now < 5000) {
+        now += 10;
+        planner.update(now);
+        if (planner.isMoving()) {  // The arrival step snaps velocity to zero
+            const float dv = std::fabs(planner.velocity() - previousVelocity);
+            TEST_ASSERT_TRUE(dv <= 2000.0f * 0.010f + 0.5f);
+        }
+        TEST_ASSERT_TRUE(planner.positionExact() <= 60.0f + 0.001f);
+        previousVelocity = planner.velocity();
+        if (planner.velocity() > peak) {
+            peak = planner.velocity();
+        }
+    }
+    TEST_ASSERT_FALSE(planner.isMoving());
+    TEST_ASSERT_EQUAL_INT(60, planner.position());
+    TEST_ASSERT_TRUE(peak <= 400.0f + 0.001f);
+}
+
+static void test_targets_are_clamped_to_bounds(void) {
+    ServoMotionPlanner planner;
+    planner.setBounds(10, 70);
+    planner.reset(0);
+    TEST_ASSERT_EQUAL_INT(10, planner.position());
+    planner.moveTo(keyframe(200, 100), 0);
+    planner.update(100);
+    TEST_ASSERT_EQUAL_INT(70, planner.position());
+}
+
+static void test_cancel_stops_in_place(void) {
+    ServoMotionPlanner planner;
+    planner.setBounds(0, 80);
+    planner.reset(0);
+    planner.moveTo(keyframe(80, 800), 0);
+    planner.enqueue(keyframe(0, 800));
+    planner.update(400);
+    planner.cancel();
+    TEST_ASSERT_FALSE(planner.isMoving());
+    TEST_ASSERT_FALSE(planner.update(800));
+    TEST_ASSERT_EQUAL_INT(40, planner.position());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_easing_curves_hit_endpoints);
+    RUN_TEST(test_linear_move_tracks_time_without_blocking);
+    RUN_TEST(test_queued_keyframes_run_in_order_with_hold);
+    RUN_TEST(test_queue_is_bounded);
+    RUN_TEST(test_preemption_drops_queue_and_continues_from_current_position);
+    RUN_TEST(test_velocity_limit_caps_each_step);
+    RUN_TEST(test_acceleration_limit_ramps_and_stops_without_overshoot);
+    RUN_TEST(test_targets_are_clamped_to_bounds);
+    RUN_TEST(test_cancel_stops_in_place);
+    return UNITY_END();
+}
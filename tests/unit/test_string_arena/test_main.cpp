@@ -0,0 +1,111 @@
+#include <unity.h>
+#include "infra/string_arena.h"
+
+#include <string>
+#include <vector>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_intern_deduplicates_identical_strings(void) {
+    infra::StringArena arena;
+    const char *first = arena.intern("raven", 5);
+    const char *second = arena.intern("ravenous", 5);
+    const char *other = arena.intern("raven", 4);
+    TEST_ASSERT_EQUAL_PTR(first, second);
+    TEST_ASSERT_TRUE(first != other);
+    TEST_ASSERT_EQUAL_STRING("raven", first);
+    TEST_ASSERT_EQUAL_STRING("rave", other);
+    TEST_ASSERT_EQUAL_UINT32(3, arena.stats().strings);
+    TEST_ASSERT_EQUAL_UINT32(2, arena.stats().uniqueStrings);
+    TEST_ASSERT_EQUAL_UINT32(11, arena.stats().bytesUsed);
+}
+
+static void test_pointers_stay_valid_across_blocks_and_index_growth(void) {
+    infra::StringArena arena(64);
+    std::vector<const char *> stored;
+    for (int i = 0; i < 500; ++i) {
+        const std::string text = "entry-" + std::to_string(i);
+        stored.push_back(arena.intern(text.c_str(), text.size()));
+    }
+    const std::string big(200, 'z');
+    const char *large = arena.intern(big.c_str(), big.size());
+
+    for (int i = 0; i < 500; ++i) {
+        const std::string text = "entry-" + std::to_string(i);
+        TEST_ASSERT_EQUAL_STRING(text.c_str(), stored[i]);
+        TEST_ASSERT_EQUAL_PTR(stored[i], arena.intern(text.c_str(), text.size()));
+    }
+    TEST_ASSERT_EQUAL_STRING(big.c_str(), large);
+    TEST_ASSERT_EQUAL_UINT32(501, arena.stats().uniqueStrings);
+    TEST_ASSERT_TRUE(arena.stats().bytesReserved >= arena.stats().bytesUsed);
+}
+
+static void test_release_index_stops_deduplication(void) {
+    infra::StringArena arena;
+    const char *first = arena.intern("bat", 3);
+    TEST_ASSERT_TRUE(arena.stats().indexBytes > 0);
+    arena.releaseIndex();
+    TEST_ASSERT_EQUAL_UINT32(0, arena.stats().indexBytes);
+
+    const char *second = arena.intern("bat", 3);
+    TEST_ASSERT_TRUE(first != second);
+    TEST_ASSERT_EQUAL_STRING("bat", first);
+    TEST_ASSERT_EQUAL_STRING("bat", second);
+
+    arena.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, arena.stats().bytesReserved);
+    const char *owl = arena.intern("owl", 3);
+    TEST_ASSERT_EQUAL_PTR(owl, arena.intern("owl", 3));
+}
+
+static void test_reserve_keeps_a_load_in_one_block(void) {
+    infra::StringArena arena(64);
+    arena.reserve(4096);
+    for (int i = 0; i < 200; ++i) {
+        const std::string text = "key-" + std::to_string(i);
+        arena.intern(text.c_str(), text.size());
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, arena.stats().blocks);
+    TEST_ASSERT_EQUAL_UINT32(4096, arena.stats().bytesReserved);
+}
+
+static void test_allocate_array_is_aligned_and_shares_blocks(void) {
+    infra::StringArena arena(256);
+    arena.intern("x", 1);
+    uint32_t *values = arena.allocateArray<uint32_t>(4);
+    TEST_ASSERT_EQUAL_UINT32(0, reinterpret_cast<uintptr_t>(values) % alignof(uint32_t));
+    for (uint32_t i = 0; i < 4; ++i) {
+        values[i] = i * 7;
+    }
+    const char *after = arena.intern("tail", 4);
+    TEST_ASSERT_EQUAL_UINT32(21, values[3]);
+    TEST_ASSERT_EQUAL_STRING("tail", after);
+    TEST_ASSERT_EQUAL_UINT32(1, arena.stats().blocks);
+    TEST_ASSERT_EQUAL_UINT32(2 + 16 + 5, arena.stats().bytesUsed);
+}
+
+static void test_failed_allocations_return_null_and_keep_the_arena_usable(void) {
+    infra::StringArena arena(64);
+    const char *first = arena.intern("moth", 4);
+    TEST_ASSERT_FALSE(arena.reserve(SIZE_MAX / 2));
+    TEST_ASSERT_NULL(arena.allocateArray<uint8_t>(SIZE_MAX / 2));
+    TEST_ASSERT_EQUAL_UINT32(2, arena.stats().failedBlocks);
+    TEST_ASSERT_EQUAL_UINT32(1, arena.stats().blocks);
+
+    const char *second = arena.intern("wasp", 4);
+    TEST_ASSERT_EQUAL_STRING("moth", first);
+    TEST_ASSERT_EQUAL_STRING("wasp", second);
+    TEST_ASSERT_EQUAL_UINT32(10, arena.stats().bytesUsed);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_intern_deduplicates_identical_strings);
+    RUN_TEST(test_pointers_stay_valid_across_blocks_and_index_growth);
+    RUN_TEST(test_release_index_stops_deduplication);
+    RUN_TEST(test_reserve_keeps_a_load_in_one_block);
+    RUN_TEST(test_allocate_array_is_aligned_and_shares_blocks);
+    RUN_TEST(test_failed_allocations_return_null_and_keep_the_arena_usable);
+    return UNITY_END();
+}
@@ -0,0 +1,332 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "touch_detector.h"
+#include "touch_trace_eval.h"
+
+namespace {
+
+constexpr float BASELINE = 1000.0f;
+
+TouchDetector::Config pipeline(TouchDetector::Algorithm algorithm, uint8_t median, uint8_t hampel) {
+    TouchDetector::Config config;
+    config.algorithm = algorithm;
+    config.medianWindow = median;
+    config.hampelWindow = hampel;
+    return config;
+}
+
+// Synthetic stand-ins for recorded traces: seeded, so every run scores the
+// same samples. Values fall when a finger is present, as on the ESP32 pads.
+struct Scenario {
+    const char *name;
+    float noiseSigma;        // Gaussian noise, raw counts
+    float touchDepth;        // Fractional drop while touched
+    float spikeProbability;  // Per-sample chance of a crowd/ESD spike
+    float spikeDepth;        // Fractional size of a spike, either sign
+    float driftTotal;        // Fractional baseline drift across the trace (humidity)
+};
+
+class TraceBuilder {
+public:
+    explicit TraceBuilder(uint32_t seed) : m_state(seed) {}
+
+    // 31 calibration samples (~1 s at 32 ms), then a 1-2 s touch every ~5 s
+    TouchTrace build(const Scenario &scenario, size_t touches) {
+        TouchTrace trace;
+        std::vector<float> depth;
+        size_t index = 0;
+        const auto idle = [&](size_t count) {
+            for (size_t i = 0; i < count; ++i, ++index) {
+                depth.push_back(0.0f);
+            }
+        };
+        idle(31 + 60);
+        for (size_t t = 0; t < touches; ++t) {
+            const size_t length = 31 + static_cast<size_t>(uniform() * 31.0f);
+            trace.touches.emplace_back(index, index + length);
+            for (size_t i = 0; i < length; ++i, ++index) {
+                // The finger arrives over ~3 samples
+                depth.push_back(scenario.touchDepth * std::min(1.0f, (i + 1) / 3.0f));
+            }
+            idle(125 + static_cast<size_t>(uniform() * 60.0f));
+        }
+
+        for (size_t i = 0; i < depth.size(); ++i) {
+            const float drift = i < 31 ? 0.0f : scenario.driftTotal * static_cast<float>(i) / depth.size();
+            float value = BASELINE * (1.0f - depth[i] - drift) + scenario.noiseSigma * gaussian();
+            if (uniform() < scenario.spikeProbability) {
+                value += BASELINE * scenario.spikeDepth * (uniform() < 0.5f ? -1.0f : 1.0f);
+            }
+            trace.samples.push_back(value);
+        }
+        return trace;
+    }
+
+private:
+    float uniform() {
+        m_state = m_state * 1664525u + 1013904223u;
+        return static_cast<float>(m_state >> 8) / 16777216.0f;
+    }
+
+    float gaussian() {
+        const float u1 = std::max(uniform(), 1e-6f);
+        const float u2 = uniform();
+        return std::sqrt(-2.0f * std::log(u1)) * std::cos(6.2831853f * u2);
+    }
+
+    uint32_t m_state;
+};
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_threshold_pipeline_matches_original_filter(void) {
+    TouchDetector detector;
+    detector.configure(TouchDetector::Config());
+    detector.reset(BASELINE);
+    detector.setThresholdRatio(0.01f);
+
+    float filtered = BASELINE;
+    float baseline = BASELINE;
+    bool touched = false;
+    const float samples[] = {1000.0f, 995.0f, 960.0f, 960.0f, 960.0f, 1000.0f, 1000.0f};
+    for (float sample : samples) {
+        // FingerSensor::update before the pipeline was extracted
+        filtered = 0.3f * sample + 0.7f * filtered;
+        if (!touched) {
+            baseline = 0.0001f * filtered + 0.9999f * baseline;
+        }
+        touched = (baseline - filtered) / baseline >= 0.01f;
+
+        TEST_ASSERT_EQUAL(touched, detector.update(sample));
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, filtered, detector.filtered());
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, baseline, detector.baseline());
+    }
+}
+
+static void test_median_window_suppresses_single_spike(void) {
+    TouchDetector detector;
+    TouchDetector::Config config = pipeline(TouchDetector::Algorithm::Threshold, 3, 0);
+    config.filterAlpha = 1.0f;
+    detector.configure(config);
+    detector.reset(BASELINE);
+    detector.setThresholdRatio(0.01f);
+
+    detector.update(BASELINE);
+    detector.update(BASELINE);
+    TEST_ASSERT_FALSE(detector.update(900.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, BASELINE, detector.filtered());
+    TEST_ASSERT_FALSE(detector.update(BASELINE));
+    TEST_ASSERT_FALSE(detector.update(BASELINE));
+
+    // A sustained drop passes once it holds the majority of the window
+    TEST_ASSERT_FALSE(detector.update(950.0f));
+    TEST_ASSERT_TRUE(detector.update(950.0f));
+}
+
+static void test_hampel_replaces_outliers_but_passes_steps(void) {
+    TouchDetector detector;
+    TouchDetector::Config config = pipeline(TouchDetector::Algorithm::Threshold, 1, 5);
+    config.filterAlpha = 1.0f;
+    detector.configure(config);
+    detector.reset(BASELINE);
+    detector.setThresholdRatio(0.01f);
+
+    const float quiet[] = {1000.0f, 1001.0f, 999.0f, 1000.0f, 1001.0f};
+    for (float sample : quiet) {
+        detector.update(sample);
+    }
+    TEST_ASSERT_FALSE(detector.update(930.0f));
+    TEST_ASSERT_EQUAL_UINT32(1, detector.outliersRejected());
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, BASELINE, detector.filtered());
+
+    // A step is an outlier only until half the window has moved with it
+    for (float sample : quiet) {
+        detector.update(sample);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, detector.outliersRejected());
+    TEST_ASSERT_FALSE(detector.update(950.0f));
+    TEST_ASSERT_FALSE(detector.update(950.0f));
+    TEST_ASSERT_TRUE(detector.update(950.0f));
+}
+
+static void test_cusum_accumulates_shifts_below_threshold(void) {
+    TouchDetector threshold;
+    TouchDetector cusum;
+    threshold.configure(pipeline(TouchDetector::Algorithm::Threshold, 1, 0));
+    cusum.configure(pipeline(TouchDetector::Algorithm::Cusum, 1, 0));
+    for (TouchDetector *detector : {&threshold, &cusum}) {
+        detector->reset(BASELINE);
+        detector->setThresholdRatio(0.01f);
+    }
+
+    // A light touch: 0.8 % against a 1 % threshold
+    int onset = -1;
+    for (int i = 0; i < 40; ++i) {
+        TEST_ASSERT_FALSE(threshold.update(992.0f));
+        if (cusum.update(992.0f) && onset < 0) {
+            onset = i;
+        }
+    }
+    // (0.008 - 0.005) per sample against a 0.03 limit, after the EMA settles
+    TEST_ASSERT_TRUE(onset >= 10 && onset <= 16);
+    TEST_ASSERT_TRUE(cusum.isTouched());
+
+    // Release takes limit / slack samples of a clear signal
+    int released = -1;
+    for (int i = 0; i < 20 && released < 0; ++i) {
+        if (!cusum.update(BASELINE)) {
+            released = i;
+        }
+    }
+    TEST_ASSERT_TRUE(released >= 5 && released <= 9);
+}
+
+static void test_page_hinkley_absorbs_a_standing_offset(void) {
+    TouchDetector cusum;
+    TouchDetector pageHinkley;
+    TouchDetector::Config config = pipeline(TouchDetector::Algorithm::Cusum, 1, 0);
+    config.baselineDrift = 0.0f;
+    cusum.configure(config);
+    config.algorithm = TouchDetector::Algorithm::PageHinkley;
+    pageHinkley.configure(config);
+    for (TouchDetector *detector : {&cusum, &pageHinkley}) {
+        detector->reset(BASELINE);
+        detector->setThresholdRatio(0.01f);
+    }
+
+    // Someone leaning on the pedestal: a 0.6 % offset that never goes away
+    bool cusumTriggered = false;
+    for (int i = 0; i < 200; ++i) {
+        cusumTriggered = cusum.update(994.0f) || cusumTriggered;
+        TEST_ASSERT_FALSE(pageHinkley.update(994.0f));
+    }
+    TEST_ASSERT_TRUE(cusumTriggered);
+
+    // A finger on top of the offset is still a step
+    bool touched = false;
+    for (int i = 0; i < 10; ++i) {
+        touched = pageHinkley.update(960.0f) || touched;
+    }
+    TEST_ASSERT_TRUE(touched);
+}
+
+static void test_unarmed_updates_track_without_reporting(void) {
+    TouchDetector detector;
+    detector.configure(pipeline(TouchDetector::Algorithm::Cusum, 1, 0));
+    detector.reset(BASELINE);
+    detector.setThresholdRatio(0.01f);
+
+    for (int i = 0; i < 20; ++i) {
+        TEST_ASSERT_FALSE(detector.update(950.0f, false));
+    }
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, detector.score());
+    TEST_ASSERT_TRUE(detector.normalizedDelta() > 0.04f);
+    TEST_ASSERT_TRUE(detector.update(950.0f));
+}
+
+static void test_configure_clamps_windows_and_parses_names(void) {
+    TouchDetector detector;
+    TouchDetector::Config config;
+    config.medianWindow = 40;
+    config.hampelWindow = 4;
+    detector.configure(config);
+    TEST_ASSERT_EQUAL_UINT8(TouchDetector::MAX_WINDOW, detector.config().medianWindow);
+    TEST_ASSERT_EQUAL_UINT8(3, detector.config().hampelWindow);
+
+    TouchDetector::Algorithm algorithm = TouchDetector::Algorithm::Threshold;
+    TEST_ASSERT_TRUE(TouchDetector::parseAlgorithm("ph", algorithm));
+    TEST_ASSERT_TRUE(algorithm == TouchDetector::Algorithm::PageHinkley);
+    TEST_ASSERT_TRUE(TouchDetector::parseAlgorithm("cusum", algorithm));
+    TEST_ASSERT_EQUAL_STRING("cusum", TouchDetector::algorithmName(algorithm));
+    TEST_ASSERT_FALSE(TouchDetector::parseAlgorithm("magic", algorithm));
+    TEST_ASSERT_FALSE(TouchDetector::parseAlgorithm(nullptr, algorithm));
+}
+
+static void test_pipelines_on_synthetic_traces(void) {
+    const Scenario scenarios[] = {
+        {"clean", 0.6f, 0.025f, 0.0f, 0.0f, 0.0f},
+        {"crowd", 0.6f, 0.025f, 0.02f, 0.04f, 0.0f},
+        {"humid", 0.6f, 0.025f, 0.0f, 0.0f, 0.01f},
+        {"light", 0.6f, 0.0012f, 0.0f, 0.0f, 0.0f},
+    };
+    struct Candidate {
+        const char *name;
+        TouchDetector::Config config;
+    };
+    const Candidate candidates[] = {
+        {"threshold", pipeline(TouchDetector::Algorithm::Threshold, 1, 0)},
+        {"threshold+hampel", pipeline(TouchDetector::Algorithm::Threshold, 1, 7)},
+        {"cusum", pipeline(TouchDetector::Algorithm::Cusum, 1, 0)},
+        {"cusum+median", pipeline(TouchDetector::Algorithm::Cusum, 3, 0)},
+        {"cusum+hampel", pipeline(TouchDetector::Algorithm::Cusum, 1, 7)},
+        {"ph+hampel", pipeline(TouchDetector::Algorithm::PageHinkley, 1, 7)},
+    };
+    constexpr size_t CANDIDATES = sizeof(candidates) / sizeof(candidates[0]);
+
+    std::printf("%-8s %-18s %9s %6s %9s %9s\n", "trace", "pipeline", "precision", "recall", "mean ms", "max ms");
+    for (const Scenario &scenario : scenarios) {
+        TraceBuilder builder(0xC0FFEEu);
+        const TouchTrace trace = builder.build(scenario, 40);
+        DetectionMetrics results[CANDIDATES];
+        for (size_t c = 0; c < CANDIDATES; ++c) {
+            TouchDetector detector;
+            detector.configure(candidates[c].config);
+            results[c] = evaluateDetector(detector, trace, 31);
+            std::printf("%-8s %-18s %9.3f %6.3f %9.1f %9u\n",
+                        scenario.name,
+                        candidates[c].name,
+                        results[c].precision(),
+                        results[c].recall(),
+                        results[c].meanDetectMs,
+                        results[c].maxDetectMs);
+        }
+
+        const std::string name = scenario.name;
+        if (name == "clean") {
+            for (const DetectionMetrics &metrics : results) {
+                TEST_ASSERT_EQUAL_FLOAT(1.0f, metrics.recall());
+            }
+        }
+        if (name == "crowd") {
+            // Spikes trip the bare detectors; outlier rejection removes them
+            TEST_ASSERT_TRUE(results[0].falsePositives > 0);
+            TEST_ASSERT_TRUE(results[4].falsePositives < results[0].falsePositives);
+            TEST_ASSERT_TRUE(results[4].precision() >= 0.95f);
+            TEST_ASSERT_TRUE(results[4].recall() >= 0.95f);
+        }
+        if (name == "humid") {
+            // The lagging baseline reads as a touch that never ends; only the
+            // tracked Page-Hinkley reference keeps up
+            TEST_ASSERT_TRUE(results[0].recall() < 0.5f);
+            TEST_ASSERT_TRUE(results[5].precision() >= 0.95f);
+            TEST_ASSERT_TRUE(results[5].recall() >= 0.95f);
+        }
+        if (name == "light") {
+            // Near the threshold the bare comparison flickers on and off
+            TEST_ASSERT_TRUE(results[2].precision() > results[0].precision());
+            TEST_ASSERT_TRUE(results[2].recall() >= results[0].recall());
+        }
+    }
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_threshold_pipeline_matches_original_filter);
+    RUN_TEST(test_median_window_suppresses_single_spike);
+    RUN_TEST(test_hampel_replaces_outliers_but_passes_steps);
+    RUN_TEST(test_cusum_accumulates_shifts_below_threshold);
+    RUN_TEST(test_page_hinkley_absorbs_a_standing_offset);
+    RUN_TEST(test_unarmed_updates_track_without_reporting);
+    RUN_TEST(test_configure_clamps_windows_and_parses_names);
+    RUN_TEST(test_pipelines_on_synthetic_traces);
+    return UNITY_END();
+}
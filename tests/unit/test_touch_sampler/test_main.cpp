@@ -0,0 +1,149 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "manual_periodic_timer.h"
+#include "touch_sampler.h"
+
+namespace {
+
+class FakeTimeProvider : public infra::ITimeProvider {
+public:
+    uint32_t nowMillis() const override { return static_cast<uint32_t>(currentMicros / 1000); }
+    uint64_t nowMicros() const override { return currentMicros; }
+
+    uint64_t currentMicros = 0;
+};
+
+// Each reading takes readMicros of simulated time and returns the next value
+struct FakeTouchPad {
+    FakeTimeProvider *clock = nullptr;
+    std::vector<uint32_t> values;
+    size_t next = 0;
+    uint32_t readMicros = 0;
+
+    static uint32_t read(void *context) {
+        auto *pad = static_cast<FakeTouchPad *>(context);
+        pad->clock->currentMicros += pad->readMicros;
+        return pad->values.empty() ? 0 : pad->values[pad->next++ % pad->values.size()];
+    }
+};
+
+struct Fixture {
+    ManualPeriodicTimer timer;
+    FakeTimeProvider clock;
+    FakeTouchPad pad;
+    TouchSampler sampler{&timer, &clock};
+
+    Fixture() { pad.clock = &clock; }
+
+    // Advances the clock and the timer together, one period at a time
+    void run(uint32_t periods) {
+        for (uint32_t i = 0; i < periods; ++i) {
+            clock.currentMicros += timer.period;
+            timer.advanceMicros(timer.period);
+        }
+    }
+};
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_blocks_are_averaged_and_timestamped(void) {
+    Fixture fx;
+    fx.pad.values = {100, 200, 300, 400};
+    TEST_ASSERT_TRUE(fx.sampler.start(1000, &FakeTouchPad::read, &fx.pad, 4));
+    TEST_ASSERT_EQUAL_UINT32(1000, fx.timer.period);
+
+    fx.run(3);
+    TouchSampler::Sample sample;
+    TEST_ASSERT_FALSE(fx.sampler.pop(sample));
+
+    fx.run(5);
+    TEST_ASSERT_EQUAL_UINT32(2, fx.sampler.pending());
+    TEST_ASSERT_TRUE(fx.sampler.pop(sample));
+    TEST_ASSERT_EQUAL_FLOAT(250.0f, sample.value);
+    TEST_ASSERT_EQUAL_UINT32(4, sample.readings);
+    TEST_ASSERT_EQUAL_UINT32(4, sample.timestampMs);
+    TEST_ASSERT_TRUE(fx.sampler.pop(sample));
+    TEST_ASSERT_EQUAL_UINT32(8, sample.timestampMs);
+    TEST_ASSERT_FALSE(fx.sampler.pop(sample));
+}
+
+static void test_full_ring_drops_newest_and_counts(void) {
+    Fixture fx;
+    fx.pad.values = {7};
+    TEST_ASSERT_TRUE(fx.sampler.start(1000, &FakeTouchPad::read, &fx.pad, 1));
+
+    fx.run(TouchSampler::RING_CAPACITY + 5);
+    TEST_ASSERT_EQUAL_UINT32(TouchSampler::RING_CAPACITY, fx.sampler.pending());
+    const TouchSampler::Stats stats = fx.sampler.stats();
+    TEST_ASSERT_EQUAL_UINT32(TouchSampler::RING_CAPACITY + 5, stats.ticks);
+    TEST_ASSERT_EQUAL_UINT32(TouchSampler::RING_CAPACITY, stats.published);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.dropped);
+
+    // The oldest samples survive, so timestamps stay in order
+    TouchSampler::Sample sample;
+    TEST_ASSERT_TRUE(fx.sampler.pop(sample));
+    TEST_ASSERT_EQUAL_UINT32(1, sample.timestampMs);
+    fx.run(1);
+    TEST_ASSERT_EQUAL_UINT32(TouchSampler::RING_CAPACITY, fx.sampler.pending());
+}
+
+static void test_block_size_changes_at_block_boundary(void) {
+    Fixture fx;
+    fx.pad.values = {10};
+    TEST_ASSERT_TRUE(fx.sampler.start(1000, &FakeTouchPad::read, &fx.pad, 4));
+
+    fx.run(2);
+    fx.sampler.setSamplesPerBlock(2);
+    fx.run(2);  // Finishes the 4-reading block already under way
+    fx.run(2);
+
+    TouchSampler::Sample sample;
+    TEST_ASSERT_TRUE(fx.sampler.pop(sample));
+    TEST_ASSERT_EQUAL_UINT32(4, sample.readings);
+    TEST_ASSERT_TRUE(fx.sampler.pop(sample));
+    TEST_ASSERT_EQUAL_UINT32(2, sample.readings);
+    TEST_ASSERT_EQUAL_UINT32(6, sample.timestampMs);
+}
+
+static void test_tracks_slowest_reading(void) {
+    Fixture fx;
+    fx.pad.values = {1};
+    fx.pad.readMicros = 480;
+    TEST_ASSERT_TRUE(fx.sampler.start(1000, &FakeTouchPad::read, &fx.pad, 1));
+    fx.run(3);
+    TEST_ASSERT_EQUAL_UINT32(480, fx.sampler.stats().maxReadMicros);
+}
+
+static void test_start_fails_without_timer_and_restart_discards_stale_samples(void) {
+    FakeTimeProvider clock;
+    FakeTouchPad pad;
+    pad.clock = &clock;
+    TouchSampler untimed(nullptr, &clock);
+    TEST_ASSERT_FALSE(untimed.start(1000, &FakeTouchPad::read, &pad, 1));
+    TEST_ASSERT_FALSE(untimed.isRunning());
+
+    Fixture fx;
+    fx.pad.values = {5};
+    TEST_ASSERT_TRUE(fx.sampler.start(1000, &FakeTouchPad::read, &fx.pad, 1));
+    fx.run(3);
+    TEST_ASSERT_EQUAL_UINT32(3, fx.sampler.pending());
+    TEST_ASSERT_TRUE(fx.sampler.start(1000, &FakeTouchPad::read, &fx.pad, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, fx.sampler.pending());
+    fx.sampler.stop();
+    TEST_ASSERT_FALSE(fx.sampler.isRunning());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_blocks_are_averaged_and_timestamped);
+    RUN_TEST(test_full_ring_drops_newest_and_counts);
+    RUN_TEST(test_block_size_changes_at_block_boundary);
+    RUN_TEST(test_tracks_slowest_reading);
+    RUN_TEST(test_start_fails_without_timer_and_restart_discards_stale_samples);
+    return UNITY_END();
+}
@@ -0,0 +1,360 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "fake_filesystem.h"
+#include "touch_trace.h"
+#include "touch_trace_replay.h"
+
+namespace {
+
+constexpr const char *TRACE_PATH = "/touch_trace.bin";
+
+// Raw 1 kHz touchRead capture as `fmultisample 1` + `ftrace start` records it:
+// baseline 1000 counts, sigma 3 counts, a 1 % drop while touched. The first
+// 3.5 s are unlabelled so calibration and settling are never scored.
+class RawTraceBuilder {
+public:
+    explicit RawTraceBuilder(uint32_t seed) : m_state(seed) {}
+
+    std::vector<TouchTraceRecord> build(size_t touches, float driftTotal, float spikeProbability) {
+        std::vector<TouchTraceRecord> records;
+        std::vector<float> depth;
+        std::vector<TouchLabel> labels;
+        const auto span = [&](size_t count, float amount, TouchLabel label) {
+            for (size_t i = 0; i < count; ++i) {
+                // The finger arrives over ~30 ms
+                depth.push_back(amount * std::min(1.0f, (i + 1) / 30.0f));
+                labels.push_back(label);
+            }
+        };
+        span(3500, 0.0f, TouchLabel::None);
+        span(1500, 0.0f, TouchLabel::Idle);
+        for (size_t t = 0; t < touches; ++t) {
+            span(600 + static_cast<size_t>(uniform() * 600.0f), 0.01f, TouchLabel::Touch);
+            span(2000 + static_cast<size_t>(uniform() * 2000.0f), 0.0f, TouchLabel::Idle);
+        }
+
+        for (size_t i = 0; i < depth.size(); ++i) {
+            const float drift = driftTotal * static_cast<float>(i) / static_cast<float>(depth.size());
+            float value = 1000.0f * (1.0f - depth[i] - drift) + 3.0f * gaussian();
+            if (uniform() < spikeProbability) {
+                value += 40.0f * (uniform() < 0.5f ? -1.0f : 1.0f);
+            }
+            TouchTraceRecord record;
+            record.timestampMs = static_cast<uint32_t>(i + 1);
+            record.value = std::round(value);
+            record.label = labels[i];
+            records.push_back(record);
+        }
+        return records;
+    }
+
+private:
+    float uniform() {
+        m_state = m_state * 1664525u + 1013904223u;
+        return static_cast<float>(m_state >> 8) / 16777216.0f;
+    }
+
+    float gaussian() {
+        const float u1 = std::max(uniform(), 1e-6f);
+        const float u2 = uniform();
+        return std::sqrt(-2.0f * std::log(u1)) * std::cos(6.2831853f * u2);
+    }
+
+    uint32_t m_state;
+};
+
+TouchTraceHeader rawHeader() {
+    TouchTraceHeader header;
+    header.version = TouchTraceWriter::VERSION;
+    header.readingsPerSample = 1;
+    header.readingPeriodMicros = 1000;
+    return header;
+}
+
+bool writeTrace(FakeFileSystem &fs, const TouchTraceHeader &header, const std::vector<TouchTraceRecord> &records) {
+    TouchTraceWriter writer;
+    if (!writer.begin(fs.open(TRACE_PATH, "w"), header)) {
+        return false;
+    }
+    for (const TouchTraceRecord &record : records) {
+        writer.setLabel(record.label);
+        if (!writer.append(record.timestampMs, record.value) || !writer.service(true)) {
+            return false;
+        }
+    }
+    return writer.end();
+}
+
+// Accepts the first `budget` bytes, then reports a full card
+class FillingFile : public infra::IFile {
+public:
+    explicit FillingFile(size_t budget) : m_budget(budget) {}
+
+    bool available() override { return false; }
+    String readString() override { return String(); }
+    String readStringUntil(char) override { return String(); }
+    size_t read(uint8_t *, size_t) override { return 0; }
+    size_t size() override { return 0; }
+    size_t write(const uint8_t *, size_t length) override {
+        const size_t accepted = std::min(length, m_budget);
+        m_budget -= accepted;
+        return accepted;
+    }
+    void close() override {}
+
+private:
+    size_t m_budget;
+};
+
+void printResult(const char *prefix, const SweepResult &result) {
+    printf("%s alpha=%.2f drift=%.4f threshold=%.3f%%: F1=%.3f precision=%.2f recall=%.2f mean=%.0fms max=%ums\n",
+           prefix,
+           result.settings.filterAlpha,
+           result.settings.baselineDrift,
+           result.settings.thresholdRatio * 100.0f,
+           result.metrics.f1(),
+           result.metrics.precision(),
+           result.metrics.recall(),
+           result.metrics.meanDetectMs,
+           static_cast<unsigned>(result.metrics.maxDetectMs));
+}
+
+const std::vector<float> SWEEP_ALPHAS = {0.1f, 0.3f, 0.6f};
+const std::vector<float> SWEEP_DRIFTS = {0.0f, 0.0001f, 0.001f};
+const std::vector<float> SWEEP_THRESHOLDS = {0.0f, 0.002f, 0.004f};  // 0 = adaptive only
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_writer_round_trips_records_across_flushes(void) {
+    FakeFileSystem fs;
+    TouchTraceHeader header;
+    header.readingsPerSample = 32;
+    header.readingPeriodMicros = 1000;
+    header.startMs = 4321;
+
+    TouchTraceWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(fs.open(TRACE_PATH, "w"), header));
+    TEST_ASSERT_TRUE(writer.isActive());
+    const size_t count = 200;  // several buffer flushes
+    for (size_t i = 0; i < count; ++i) {
+        writer.setLabel(i < 50 ? TouchLabel::None : (i < 120 ? TouchLabel::Idle : TouchLabel::Touch));
+        TEST_ASSERT_TRUE(writer.append(static_cast<uint32_t>(4321 + i * 32), 1000.25f - static_cast<float>(i)));
+        TEST_ASSERT_TRUE(writer.service(true));
+    }
+    TEST_ASSERT_TRUE(writer.end());
+    TEST_ASSERT_FALSE(writer.isActive());
+
+    const TouchTraceWriter::Stats stats = writer.stats();
+    TEST_ASSERT_EQUAL_UINT32(count, stats.records);
+    TEST_ASSERT_GREATER_THAN_UINT32(2, stats.flushes);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.failedWrites);
+
+    const std::string *data = fs.contents(TRACE_PATH);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_EQUAL_UINT32(TouchTraceWriter::HEADER_BYTES + count * TouchTraceWriter::RECORD_BYTES, data->size());
+    TEST_ASSERT_EQUAL_UINT32(data->size(), stats.bytesWritten);
+
+    TouchTraceHeader parsed;
+    std::vector<TouchTraceRecord> records;
+    TEST_ASSERT_TRUE(TouchTraceWriter::parse(reinterpret_cast<const uint8_t *>(data->data()), data->size(), parsed, records));
+    TEST_ASSERT_EQUAL_UINT16(TouchTraceWriter::VERSION, parsed.version);
+    TEST_ASSERT_EQUAL_UINT16(32, parsed.readingsPerSample);
+    TEST_ASSERT_EQUAL_UINT32(1000, parsed.readingPeriodMicros);
+    TEST_ASSERT_EQUAL_UINT32(4321, parsed.startMs);
+    TEST_ASSERT_EQUAL_UINT32(count, records.size());
+    TEST_ASSERT_EQUAL_UINT32(4321 + 199 * 32, records[199].timestampMs);
+    TEST_ASSERT_EQUAL_FLOAT(1000.25f - 120.0f, records[120].value);
+    TEST_ASSERT_EQUAL(TouchLabel::None, records[0].label);
+    TEST_ASSERT_EQUAL(TouchLabel::Idle, records[50].label);
+    TEST_ASSERT_EQUAL(TouchLabel::Touch, records[120].label);
+}
+
+static void test_parse_rejects_foreign_data_and_drops_partial_record(void) {
+    FakeFileSystem fs;
+    TouchTraceHeader header = rawHeader();
+    std::vector<TouchTraceRecord> written(3);
+    for (size_t i = 0; i < written.size(); ++i) {
+        written[i].timestampMs = static_cast<uint32_t>(i);
+        written[i].value = 1000.0f;
+    }
+    TEST_ASSERT_TRUE(writeTrace(fs, header, written));
+    std::string data = *fs.contents(TRACE_PATH);
+
+    TouchTraceHeader parsed;
+    std::vector<TouchTraceRecord> records;
+    const std::string truncated = data.substr(0, data.size() - 4);
+    TEST_ASSERT_TRUE(TouchTraceWriter::parse(reinterpret_cast<const uint8_t *>(truncated.data()), truncated.size(), parsed, records));
+    TEST_ASSERT_EQUAL_UINT32(2, records.size());
+
+    std::string badMagic = data;
+    badMagic[0] = 'X';
+    TEST_ASSERT_FALSE(TouchTraceWriter::parse(reinterpret_cast<const uint8_t *>(badMagic.data()), badMagic.size(), parsed, records));
+    TEST_ASSERT_EQUAL_UINT32(0, records.size());
+
+    std::string newer = data;
+    newer[4] = static_cast<char>(TouchTraceWriter::VERSION + 1);
+    TEST_ASSERT_FALSE(TouchTraceWriter::parse(reinterpret_cast<const uint8_t *>(newer.data()), newer.size(), parsed, records));
+
+    TEST_ASSERT_FALSE(TouchTraceWriter::parse(reinterpret_cast<const uint8_t *>(data.data()), 10, parsed, records));
+}
+
+static void test_failed_write_closes_the_trace(void) {
+    TouchTraceWriter writer;
+    TEST_ASSERT_FALSE(writer.begin(nullptr, rawHeader()));
+    TEST_ASSERT_FALSE(writer.append(1, 1000.0f));
+
+    TEST_ASSERT_TRUE(writer.begin(std::unique_ptr<infra::IFile>(new FillingFile(100)), rawHeader()));
+    bool failed = false;
+    for (uint32_t i = 0; i < 200 && !failed; ++i) {
+        failed = !writer.append(i, 1000.0f) || !writer.service(true);
+    }
+    TEST_ASSERT_TRUE(failed);
+    TEST_ASSERT_FALSE(writer.isActive());
+    TEST_ASSERT_EQUAL_UINT32(1, writer.stats().failedWrites);
+    TEST_ASSERT_EQUAL_UINT32(100, writer.stats().bytesWritten);
+    TEST_ASSERT_FALSE(writer.append(500, 1000.0f));
+    TEST_ASSERT_FALSE(writer.end());
+}
+
+static void test_writes_wait_for_the_bus_and_drop_when_full(void) {
+    FakeFileSystem fs;
+    TouchTraceWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(fs.open(TRACE_PATH, "w"), rawHeader()));
+
+    // Audio holds the bus: nothing is written and the buffer fills up
+    const uint32_t capacity = (TouchTraceWriter::BUFFER_BYTES - TouchTraceWriter::HEADER_BYTES) /
+                              TouchTraceWriter::RECORD_BYTES;
+    for (uint32_t i = 0; i < capacity + 10; ++i) {
+        TEST_ASSERT_TRUE(writer.append(i, 1000.0f));
+        TEST_ASSERT_TRUE(writer.service(false));
+    }
+    TouchTraceWriter::Stats stats = writer.stats();
+    TEST_ASSERT_EQUAL_UINT32(0, stats.flushes);
+    TEST_ASSERT_EQUAL_UINT32(capacity, stats.records);
+    TEST_ASSERT_EQUAL_UINT32(10, stats.droppedRecords);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.deferrals);
+    TEST_ASSERT_EQUAL_UINT32(0, fs.contents(TRACE_PATH)->size());
+
+    // Headroom again: one write empties the buffer and recording resumes
+    TEST_ASSERT_TRUE(writer.service(true));
+    TEST_ASSERT_TRUE(writer.append(capacity + 10, 1000.0f));
+    TEST_ASSERT_TRUE(writer.end());
+    stats = writer.stats();
+    TEST_ASSERT_EQUAL_UINT32(capacity + 1, stats.records);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.flushes);
+
+    TouchTraceHeader parsed;
+    std::vector<TouchTraceRecord> records;
+    const std::string *data = fs.contents(TRACE_PATH);
+    TEST_ASSERT_TRUE(TouchTraceWriter::parse(reinterpret_cast<const uint8_t *>(data->data()), data->size(), parsed, records));
+    TEST_ASSERT_EQUAL_UINT32(capacity + 1, records.size());
+    TEST_ASSERT_EQUAL_UINT32(capacity - 1, records[capacity - 1].timestampMs);
+    TEST_ASSERT_EQUAL_UINT32(capacity + 10, records[capacity].timestampMs);
+}
+
+static void test_replay_detects_every_touch_in_a_clean_raw_trace(void) {
+    RawTraceBuilder builder(7);
+    const std::vector<TouchTraceRecord> records = builder.build(12, 0.0f, 0.0f);
+
+    const DetectionMetrics metrics = replayTrace(rawHeader(), records, ReplaySettings());
+    TEST_ASSERT_EQUAL_UINT32(12, metrics.truePositives + metrics.misses);
+    TEST_ASSERT_EQUAL_UINT32(12, metrics.truePositives);
+    TEST_ASSERT_EQUAL_UINT32(0, metrics.falsePositives);
+    TEST_ASSERT_LESS_THAN_FLOAT(200.0f, metrics.meanDetectMs);
+
+    // Averaging fewer readings is noisier but still reaches every touch
+    ReplaySettings fewer;
+    fewer.readingsPerSample = 8;
+    TEST_ASSERT_EQUAL_UINT32(12, replayTrace(rawHeader(), records, fewer).truePositives);
+}
+
+static void test_replay_of_captured_file_matches_in_memory_trace(void) {
+    RawTraceBuilder builder(11);
+    const std::vector<TouchTraceRecord> records = builder.build(6, 0.002f, 0.001f);
+    FakeFileSystem fs;
+    TEST_ASSERT_TRUE(writeTrace(fs, rawHeader(), records));
+
+    const std::string *data = fs.contents(TRACE_PATH);
+    TouchTraceHeader header;
+    std::vector<TouchTraceRecord> parsed;
+    TEST_ASSERT_TRUE(TouchTraceWriter::parse(reinterpret_cast<const uint8_t *>(data->data()), data->size(), header, parsed));
+
+    const DetectionMetrics direct = replayTrace(rawHeader(), records, ReplaySettings());
+    const DetectionMetrics captured = replayTrace(header, parsed, ReplaySettings());
+    TEST_ASSERT_EQUAL_UINT32(direct.truePositives, captured.truePositives);
+    TEST_ASSERT_EQUAL_UINT32(direct.falsePositives, captured.falsePositives);
+    TEST_ASSERT_EQUAL_UINT32(direct.misses, captured.misses);
+    TEST_ASSERT_EQUAL_FLOAT(direct.meanDetectMs, captured.meanDetectMs);
+}
+
+static void test_sweep_ranks_settings_by_f1(void) {
+    // Humidity drift plus crowd spikes: the defaults are not the best choice
+    RawTraceBuilder builder(23);
+    const std::vector<TouchTraceRecord> records = builder.build(12, 0.006f, 0.002f);
+
+    const std::vector<SweepResult> results =
+        sweepTrace(rawHeader(), records, ReplaySettings(), SWEEP_ALPHAS, SWEEP_DRIFTS, SWEEP_THRESHOLDS);
+    TEST_ASSERT_EQUAL_UINT32(SWEEP_ALPHAS.size() * SWEEP_DRIFTS.size() * SWEEP_THRESHOLDS.size(), results.size());
+    for (size_t i = 1; i < results.size(); ++i) {
+        TEST_ASSERT_TRUE(results[i - 1].metrics.f1() >= results[i].metrics.f1());
+    }
+
+    SweepResult defaults;
+    defaults.metrics = replayTrace(rawHeader(), records, defaults.settings);
+    printResult("[sweep] defaults", defaults);
+    for (size_t i = 0; i < std::min<size_t>(3, results.size()); ++i) {
+        printResult("[sweep] best", results[i]);
+    }
+    TEST_ASSERT_TRUE(results.front().metrics.f1() > defaults.metrics.f1());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, results.front().metrics.recall());
+}
+
+// Point TOUCH_TRACE at a file copied off the SD card to tune against it
+static void test_sweep_recorded_trace_from_environment(void) {
+    const char *path = std::getenv("TOUCH_TRACE");
+    if (!path || !*path) {
+        TEST_IGNORE_MESSAGE("set TOUCH_TRACE=<trace.bin> to sweep a recorded trace");
+    }
+    std::ifstream in(path, std::ios::binary);
+    TEST_ASSERT_TRUE_MESSAGE(in.good(), path);
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    TouchTraceHeader header;
+    std::vector<TouchTraceRecord> records;
+    TEST_ASSERT_TRUE(TouchTraceWriter::parse(reinterpret_cast<const uint8_t *>(data.data()), data.size(), header, records));
+    printf("[trace] %s: %u records, %u reading(s) per sample\n",
+           path,
+           static_cast<unsigned>(records.size()),
+           static_cast<unsigned>(header.readingsPerSample));
+
+    const std::vector<SweepResult> results =
+        sweepTrace(header, records, ReplaySettings(), SWEEP_ALPHAS, SWEEP_DRIFTS, SWEEP_THRESHOLDS);
+    for (const SweepResult &result : results) {
+        printResult("[trace]", result);
+    }
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_writer_round_trips_records_across_flushes);
+    RUN_TEST(test_parse_rejects_foreign_data_and_drops_partial_record);
+    RUN_TEST(test_failed_write_closes_the_trace);
+    RUN_TEST(test_writes_wait_for_the_bus_and_drop_when_full);
+    RUN_TEST(test_replay_detects_every_touch_in_a_clean_raw_trace);
+    RUN_TEST(test_replay_of_captured_file_matches_in_memory_trace);
+    RUN_TEST(test_sweep_ranks_settings_by_f1);
+    RUN_TEST(test_sweep_recorded_trace_from_environment);
+    return UNITY_END();
+}